@@ -139,6 +139,8 @@
     #define AwsIotShadow_FreeString              vPortFree
     #define AwsIotShadow_MallocSubscription      pvPortMalloc
     #define AwsIotShadow_FreeSubscription        vPortFree
+    #define AwsIotShadow_MallocCoalescedUpdate   pvPortMalloc
+    #define AwsIotShadow_FreeCoalescedUpdate     vPortFree
 
     #define AwsIotDefender_MallocReport          pvPortMalloc
     #define AwsIotDefender_FreeReport            vPortFree
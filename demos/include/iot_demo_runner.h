@@ -78,6 +78,8 @@
         #undef democonfigDEMO_PRIORITY
         #define democonfigDEMO_PRIORITY     democonfigTCP_ECHO_TASKS_SINGLE_TASK_PRIORITY
     #endif
+#elif defined( CONFIG_IPERF_DEMO_ENABLED )
+    #define DEMO_entryFUNCTION              vStartIperfDemo
 #elif defined( CONFIG_DEFENDER_DEMO_ENABLED )
     #define DEMO_entryFUNCTION              RunDefenderDemo
 #elif defined( CONFIG_POSIX_DEMO_ENABLED )
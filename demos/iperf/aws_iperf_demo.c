@@ -0,0 +1,561 @@
+/*
+ * Amazon FreeRTOS V201910.00
+ * Copyright (C) 2019 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Measures the TCP and UDP throughput of FreeRTOS+TCP against a peer that runs
+ * iperf version 2, normally the TCP/IP stack of the host that runs the Linux
+ * or Windows simulator.
+ *
+ * Two server tasks listen on democonfigIPERF_PORT, one for TCP and one for UDP.
+ * They count everything the peer sends with "iperf -c <address>" or
+ * "iperf -c <address> -u -b <rate>", and print the throughput when the peer
+ * stops.
+ *
+ * When democonfigIPERF_PEER_ADDRESS is not empty, a client task first sends to
+ * the peer for democonfigIPERF_TX_DURATION_MS, over TCP and then over UDP.  Run
+ * "iperf -s" and "iperf -s -u" on the peer to see its side of the measurement.
+ * By default the peer is the gateway, which is the host when the simulator uses
+ * a TAP interface.
+ */
+
+/* Standard includes. */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* Demo includes. */
+#include "aws_demo.h"
+#include "aws_demo_config.h"
+
+/* The port of iperf version 2. */
+#ifndef democonfigIPERF_PORT
+    #define democonfigIPERF_PORT    ( 5001 )
+#endif
+
+/* The address that the client task sends to.  An empty string disables the
+ * client task, NULL selects the gateway.  Other strings need
+ * ipconfigINCLUDE_FULL_INET_ADDR. */
+#ifndef democonfigIPERF_PEER_ADDRESS
+    #define democonfigIPERF_PEER_ADDRESS    NULL
+#endif
+
+/* The duration of each of the transmit tests. */
+#ifndef democonfigIPERF_TX_DURATION_MS
+    #define democonfigIPERF_TX_DURATION_MS    ( 10000 )
+#endif
+
+/* The buffer and window sizes of the TCP sockets, in bytes and in multiples of
+ * the MSS.  Throughput is limited to window / round trip time. */
+#ifndef democonfigIPERF_TCP_BUFFER_SIZE
+    #define democonfigIPERF_TCP_BUFFER_SIZE    ( 16 * ipconfigTCP_MSS )
+#endif
+#ifndef democonfigIPERF_TCP_WINDOW_SIZE
+    #define democonfigIPERF_TCP_WINDOW_SIZE    ( 8 )
+#endif
+
+/* The UDP payload size used by the client task, the same as that of iperf. */
+#define iperfUDP_PAYLOAD_SIZE        ( 1470 )
+
+/* The number of times the final UDP datagram is sent, as it may be lost. */
+#define iperfUDP_FINAL_COUNT         ( 10 )
+
+/* The size of the header that iperf version 2 puts in front of every UDP
+ * datagram: a sequence number and a time stamp, all 32-bit and big endian.  The
+ * last datagram of a test carries a negative sequence number. */
+#define iperfUDP_HEADER_SIZE         ( 12 )
+
+/* Time out after which an idle UDP test is considered finished. */
+#define iperfUDP_IDLE_TIMEOUT_MS     ( 2000 )
+
+/* The size of the buffer that the TCP client sends from. */
+#define iperfTCP_TX_CHUNK_SIZE       ( 4 * ipconfigTCP_MSS )
+
+/*-----------------------------------------------------------*/
+
+/* The result of one direction of one test. */
+typedef struct IperfResult
+{
+    uint64_t ullBytes;
+    uint32_t ulPackets;
+    uint32_t ulLost;
+    TickType_t xStartTime;
+    TickType_t xEndTime;
+} IperfResult_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Accept TCP connections one at a time and count the received bytes.
+ */
+static void prvTCPServerTask( void * pvParameters );
+
+/*
+ * Count the UDP datagrams that arrive, using the iperf sequence numbers to
+ * count the lost ones.
+ */
+static void prvUDPServerTask( void * pvParameters );
+
+/*
+ * Send to the peer, first over TCP and then over UDP.
+ */
+static void prvClientTask( void * pvParameters );
+
+/*
+ * Run a single transmit test.
+ */
+static void prvTCPSend( uint32_t ulPeerAddress );
+static void prvUDPSend( uint32_t ulPeerAddress );
+
+/*
+ * Create a socket of the given type, with the buffer and window sizes for this
+ * demo.
+ */
+static Socket_t prvCreateSocket( BaseType_t xType );
+
+/*
+ * Print the throughput of a test.
+ */
+static void prvPrintResult( const char * pcName,
+                            const IperfResult_t * pxResult );
+
+/*-----------------------------------------------------------*/
+
+/* The TCP client sends the contents of this buffer over and over. */
+static uint8_t ucTxBuffer[ iperfTCP_TX_CHUNK_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+int vStartIperfDemo( bool awsIotMqttMode,
+                     const char * pIdentifier,
+                     void * pNetworkServerInfo,
+                     void * pNetworkCredentialInfo,
+                     const IotNetworkInterface_t * pNetworkInterface )
+{
+    const char * pcPeer = democonfigIPERF_PEER_ADDRESS;
+
+    /* Unused parameters */
+    ( void ) awsIotMqttMode;
+    ( void ) pIdentifier;
+    ( void ) pNetworkServerInfo;
+    ( void ) pNetworkCredentialInfo;
+    ( void ) pNetworkInterface;
+
+    xTaskCreate( prvTCPServerTask, "IperfTCP", democonfigDEMO_STACKSIZE, NULL, democonfigDEMO_PRIORITY, NULL );
+    xTaskCreate( prvUDPServerTask, "IperfUDP", democonfigDEMO_STACKSIZE, NULL, democonfigDEMO_PRIORITY, NULL );
+
+    if( ( pcPeer == NULL ) || ( pcPeer[ 0 ] != '\0' ) )
+    {
+        xTaskCreate( prvClientTask, "IperfTx", democonfigDEMO_STACKSIZE, NULL, democonfigDEMO_PRIORITY, NULL );
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static Socket_t prvCreateSocket( BaseType_t xType )
+{
+    Socket_t xSocket;
+    BaseType_t xProtocol = ( xType == FREERTOS_SOCK_STREAM ) ? FREERTOS_IPPROTO_TCP : FREERTOS_IPPROTO_UDP;
+    TickType_t xTimeOut = pdMS_TO_TICKS( iperfUDP_IDLE_TIMEOUT_MS );
+
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+        WinProperties_t xWinProps;
+    #endif
+
+    xSocket = FreeRTOS_socket( FREERTOS_AF_INET, xType, xProtocol );
+    configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+        {
+            if( xType == FREERTOS_SOCK_STREAM )
+            {
+                /* Listening sockets pass these on to the sockets they create. */
+                xWinProps.lTxBufSize = democonfigIPERF_TCP_BUFFER_SIZE;
+                xWinProps.lTxWinSize = democonfigIPERF_TCP_WINDOW_SIZE;
+                xWinProps.lRxBufSize = democonfigIPERF_TCP_BUFFER_SIZE;
+                xWinProps.lRxWinSize = democonfigIPERF_TCP_WINDOW_SIZE;
+                FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, ( void * ) &xWinProps, sizeof( xWinProps ) );
+            }
+        }
+    #endif /* ipconfigUSE_TCP_WIN */
+
+    return xSocket;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintResult( const char * pcName,
+                            const IperfResult_t * pxResult )
+{
+    uint32_t ulMilliSeconds = ( uint32_t ) ( ( pxResult->xEndTime - pxResult->xStartTime ) * portTICK_PERIOD_MS );
+    uint32_t ulKbitPerSecond = 0UL;
+
+    if( ulMilliSeconds > 0UL )
+    {
+        /* Bits per millisecond are kilobits per second. */
+        ulKbitPerSecond = ( uint32_t ) ( ( pxResult->ullBytes * 8ULL ) / ulMilliSeconds );
+    }
+
+    configPRINTF( ( "[%s] %lu KB in %lu ms = %lu kbit/s, %lu packets, %lu lost\r\n",
+                    pcName,
+                    ( unsigned long ) ( pxResult->ullBytes / 1024ULL ),
+                    ( unsigned long ) ulMilliSeconds,
+                    ( unsigned long ) ulKbitPerSecond,
+                    ( unsigned long ) pxResult->ulPackets,
+                    ( unsigned long ) pxResult->ulLost ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTCPServerTask( void * pvParameters )
+{
+    Socket_t xListeningSocket, xConnectedSocket;
+    struct freertos_sockaddr xBindAddress, xClient;
+    socklen_t xSize = sizeof( xClient );
+    const TickType_t xWaitForever = portMAX_DELAY;
+    IperfResult_t xResult;
+    uint8_t * pucData;
+    BaseType_t xReceived;
+
+    ( void ) pvParameters;
+
+    xListeningSocket = prvCreateSocket( FREERTOS_SOCK_STREAM );
+    FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_RCVTIMEO, &xWaitForever, sizeof( xWaitForever ) );
+
+    xBindAddress.sin_port = FreeRTOS_htons( democonfigIPERF_PORT );
+    FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+    FreeRTOS_listen( xListeningSocket, 1 );
+
+    configPRINTF( ( "iperf TCP server listening on port %d\r\n", democonfigIPERF_PORT ) );
+
+    for( ; ; )
+    {
+        xConnectedSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+        if( xConnectedSocket == FREERTOS_INVALID_SOCKET )
+        {
+            continue;
+        }
+
+        memset( &xResult, 0, sizeof( xResult ) );
+        xResult.xStartTime = xTaskGetTickCount();
+        xResult.xEndTime = xResult.xStartTime;
+
+        for( ; ; )
+        {
+            /* Zero copy: the data is counted where it is, in the stream
+             * buffer of the socket, and then dropped. */
+            xReceived = FreeRTOS_recv( xConnectedSocket, &pucData, democonfigIPERF_TCP_BUFFER_SIZE, FREERTOS_ZERO_COPY );
+
+            if( xReceived > 0 )
+            {
+                FreeRTOS_recv( xConnectedSocket, NULL, ( size_t ) xReceived, 0 );
+                xResult.ullBytes += ( uint64_t ) xReceived;
+                xResult.ulPackets++;
+                xResult.xEndTime = xTaskGetTickCount();
+            }
+            else if( xReceived < 0 )
+            {
+                /* The peer closed the connection. */
+                break;
+            }
+            else
+            {
+                /* Time out, the peer is gone. */
+                break;
+            }
+        }
+
+        prvPrintResult( "TCP RX", &xResult );
+
+        FreeRTOS_shutdown( xConnectedSocket, FREERTOS_SHUT_RDWR );
+        FreeRTOS_closesocket( xConnectedSocket );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvUDPServerTask( void * pvParameters )
+{
+    Socket_t xSocket;
+    struct freertos_sockaddr xBindAddress, xClient;
+    socklen_t xSize = sizeof( xClient );
+    IperfResult_t xResult;
+    uint8_t * pucData;
+    int32_t lReceived, lSequence, lExpected = 0;
+    BaseType_t xRunning = pdFALSE;
+
+    ( void ) pvParameters;
+
+    xSocket = prvCreateSocket( FREERTOS_SOCK_DGRAM );
+
+    xBindAddress.sin_port = FreeRTOS_htons( democonfigIPERF_PORT );
+    FreeRTOS_bind( xSocket, &xBindAddress, sizeof( xBindAddress ) );
+
+    configPRINTF( ( "iperf UDP server listening on port %d\r\n", democonfigIPERF_PORT ) );
+
+    memset( &xResult, 0, sizeof( xResult ) );
+
+    for( ; ; )
+    {
+        lReceived = FreeRTOS_recvfrom( xSocket, &pucData, 0, FREERTOS_ZERO_COPY, &xClient, &xSize );
+
+        if( lReceived <= 0 )
+        {
+            if( xRunning != pdFALSE )
+            {
+                /* The peer stopped without sending its final datagram. */
+                prvPrintResult( "UDP RX", &xResult );
+                xRunning = pdFALSE;
+            }
+
+            continue;
+        }
+
+        if( lReceived >= iperfUDP_HEADER_SIZE )
+        {
+            lSequence = ( int32_t ) ( ( ( uint32_t ) pucData[ 0 ] << 24 ) | ( ( uint32_t ) pucData[ 1 ] << 16 ) |
+                                      ( ( uint32_t ) pucData[ 2 ] << 8 ) | ( uint32_t ) pucData[ 3 ] );
+        }
+        else
+        {
+            lSequence = lExpected;
+        }
+
+        if( xRunning == pdFALSE )
+        {
+            if( lSequence < 0 )
+            {
+                /* A repeated final datagram of a test that has been reported
+                 * already. */
+                FreeRTOS_ReleaseUDPPayloadBuffer( ( void * ) pucData );
+                continue;
+            }
+
+            memset( &xResult, 0, sizeof( xResult ) );
+            xResult.xStartTime = xTaskGetTickCount();
+            lExpected = lSequence;
+            xRunning = pdTRUE;
+        }
+
+        xResult.ullBytes += ( uint64_t ) lReceived;
+        xResult.ulPackets++;
+        xResult.xEndTime = xTaskGetTickCount();
+
+        if( lSequence < 0 )
+        {
+            /* The final datagram carries the negated sequence number. */
+            lSequence = -lSequence;
+        }
+
+        if( lSequence > lExpected )
+        {
+            xResult.ulLost += ( uint32_t ) ( lSequence - lExpected );
+        }
+
+        if( lSequence >= lExpected )
+        {
+            lExpected = lSequence + 1;
+        }
+
+        if( ( lReceived >= iperfUDP_HEADER_SIZE ) && ( ( pucData[ 0 ] & 0x80U ) != 0U ) )
+        {
+            prvPrintResult( "UDP RX", &xResult );
+            xRunning = pdFALSE;
+        }
+
+        FreeRTOS_ReleaseUDPPayloadBuffer( ( void * ) pucData );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTCPSend( uint32_t ulPeerAddress )
+{
+    Socket_t xSocket;
+    struct freertos_sockaddr xPeer;
+    IperfResult_t xResult;
+    TickType_t xDuration = pdMS_TO_TICKS( democonfigIPERF_TX_DURATION_MS );
+    BaseType_t xSent;
+
+    memset( &xResult, 0, sizeof( xResult ) );
+
+    xSocket = prvCreateSocket( FREERTOS_SOCK_STREAM );
+    xPeer.sin_addr = ulPeerAddress;
+    xPeer.sin_port = FreeRTOS_htons( democonfigIPERF_PORT );
+
+    if( FreeRTOS_connect( xSocket, &xPeer, sizeof( xPeer ) ) == 0 )
+    {
+        xResult.xStartTime = xTaskGetTickCount();
+        xResult.xEndTime = xResult.xStartTime;
+
+        /* The buffer is all zeroes, which iperf reads as a header without any
+         * options, and then as plain data. */
+        while( ( xResult.xEndTime - xResult.xStartTime ) < xDuration )
+        {
+            xSent = FreeRTOS_send( xSocket, ucTxBuffer, sizeof( ucTxBuffer ), 0 );
+
+            if( xSent < 0 )
+            {
+                break;
+            }
+
+            xResult.ullBytes += ( uint64_t ) xSent;
+            xResult.ulPackets++;
+            xResult.xEndTime = xTaskGetTickCount();
+        }
+
+        prvPrintResult( "TCP TX", &xResult );
+        FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+    }
+    else
+    {
+        configPRINTF( ( "iperf: could not connect to the TCP server of the peer\r\n" ) );
+    }
+
+    FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static void prvUDPSend( uint32_t ulPeerAddress )
+{
+    Socket_t xSocket;
+    struct freertos_sockaddr xPeer;
+    IperfResult_t xResult;
+    TickType_t xDuration = pdMS_TO_TICKS( democonfigIPERF_TX_DURATION_MS );
+    TickType_t xNow;
+    uint8_t * pucPayload;
+    uint32_t ulMilliSeconds, ulHeader[ iperfUDP_HEADER_SIZE / sizeof( uint32_t ) ];
+    int32_t lSequence = 0;
+    BaseType_t xFinal = 0;
+
+    memset( &xResult, 0, sizeof( xResult ) );
+
+    xSocket = prvCreateSocket( FREERTOS_SOCK_DGRAM );
+    xPeer.sin_addr = ulPeerAddress;
+    xPeer.sin_port = FreeRTOS_htons( democonfigIPERF_PORT );
+
+    xResult.xStartTime = xTaskGetTickCount();
+    xNow = xResult.xStartTime;
+
+    while( xFinal < iperfUDP_FINAL_COUNT )
+    {
+        /* The datagrams are sent without copying: the payload is written into
+         * a network buffer, which is then passed to the stack. */
+        pucPayload = ( uint8_t * ) FreeRTOS_GetUDPPayloadBuffer( iperfUDP_PAYLOAD_SIZE, portMAX_DELAY );
+
+        if( pucPayload == NULL )
+        {
+            continue;
+        }
+
+        xNow = xTaskGetTickCount();
+
+        if( ( xNow - xResult.xStartTime ) >= xDuration )
+        {
+            /* Tell the server that the test has ended. */
+            xFinal++;
+            ulHeader[ 0 ] = FreeRTOS_htonl( ( uint32_t ) -lSequence );
+        }
+        else
+        {
+            ulHeader[ 0 ] = FreeRTOS_htonl( ( uint32_t ) lSequence );
+        }
+
+        ulMilliSeconds = ( uint32_t ) ( xNow * portTICK_PERIOD_MS );
+        ulHeader[ 1 ] = FreeRTOS_htonl( ulMilliSeconds / 1000UL );
+        ulHeader[ 2 ] = FreeRTOS_htonl( ( ulMilliSeconds % 1000UL ) * 1000UL );
+
+        memcpy( pucPayload, ulHeader, sizeof( ulHeader ) );
+        memset( pucPayload + sizeof( ulHeader ), 0, iperfUDP_PAYLOAD_SIZE - sizeof( ulHeader ) );
+
+        if( FreeRTOS_sendto( xSocket, pucPayload, iperfUDP_PAYLOAD_SIZE, FREERTOS_ZERO_COPY, &xPeer, sizeof( xPeer ) ) > 0 )
+        {
+            if( xFinal == 0 )
+            {
+                xResult.ullBytes += iperfUDP_PAYLOAD_SIZE;
+                xResult.ulPackets++;
+                xResult.xEndTime = xNow;
+                lSequence++;
+            }
+        }
+        else
+        {
+            /* The buffer is still owned by this task. */
+            FreeRTOS_ReleaseUDPPayloadBuffer( ( void * ) pucPayload );
+            xResult.ulLost++;
+        }
+
+        if( xFinal != 0 )
+        {
+            /* Give the server time to reply to the final datagram. */
+            vTaskDelay( pdMS_TO_TICKS( 10 ) );
+        }
+    }
+
+    prvPrintResult( "UDP TX", &xResult );
+
+    FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static void prvClientTask( void * pvParameters )
+{
+    const char * pcPeer = democonfigIPERF_PEER_ADDRESS;
+    uint32_t ulPeerAddress;
+
+    ( void ) pvParameters;
+
+    if( pcPeer == NULL )
+    {
+        ulPeerAddress = FreeRTOS_GetGatewayAddress();
+    }
+    else
+    {
+        #if ( ipconfigINCLUDE_FULL_INET_ADDR == 1 )
+            ulPeerAddress = FreeRTOS_inet_addr( pcPeer );
+        #else
+            /* An address string can not be converted. */
+            configASSERT( pcPeer == NULL );
+            ulPeerAddress = FreeRTOS_GetGatewayAddress();
+        #endif
+    }
+
+    /* Give the peer some time to start its servers. */
+    vTaskDelay( pdMS_TO_TICKS( 1000 ) );
+
+    prvTCPSend( ulPeerAddress );
+    prvUDPSend( ulPeerAddress );
+
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
@@ -1402,6 +1402,23 @@
  */
 #define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
 
+/**
+ * \def MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+ *
+ * Shrink the record buffers of an SSL context to the maximum fragment
+ * length in use once a handshake completes, and grow them back to their full
+ * size when a new handshake starts.
+ *
+ * The input buffer only shrinks if the peer accepted the max_fragment_length
+ * extension; the output buffer shrinks to the maximum fragment length set
+ * with mbedtls_ssl_conf_max_frag_len().
+ *
+ * Requires: MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+ *
+ * Uncomment this macro to resize the record buffers
+ */
+//#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+
 /**
  * \def MBEDTLS_SSL_PROTO_SSL3
  *
@@ -708,6 +708,29 @@ static inline size_t mbedtls_ssl_hdr_len( const mbedtls_ssl_context *ssl )
     return( 5 );
 }
 
+/*
+ * Current length of the record buffers.
+ */
+static inline size_t mbedtls_ssl_in_buf_len( const mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    return( ssl->in_buf_len );
+#else
+    ((void) ssl);
+    return( MBEDTLS_SSL_IN_BUFFER_LEN );
+#endif
+}
+
+static inline size_t mbedtls_ssl_out_buf_len( const mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    return( ssl->out_buf_len );
+#else
+    ((void) ssl);
+    return( MBEDTLS_SSL_OUT_BUFFER_LEN );
+#endif
+}
+
 static inline size_t mbedtls_ssl_hs_hdr_len( const mbedtls_ssl_context *ssl )
 {
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
@@ -1165,6 +1165,9 @@ static int ssl_parse_max_fragment_length_ext( mbedtls_ssl_context *ssl,
         return( MBEDTLS_ERR_SSL_BAD_HS_SERVER_HELLO );
     }
 
+    /* The server will not send records larger than the agreed length */
+    ssl->session_negotiate->mfl_code = ssl->conf->mfl_code;
+
     return( 0 );
 }
 #endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
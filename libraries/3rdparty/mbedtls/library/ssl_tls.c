@@ -125,10 +125,10 @@ static size_t ssl_get_maximum_datagram_size( mbedtls_ssl_context const *ssl )
 {
     size_t mtu = ssl_get_current_mtu( ssl );
 
-    if( mtu != 0 && mtu < MBEDTLS_SSL_OUT_BUFFER_LEN )
+    if( mtu != 0 && mtu < mbedtls_ssl_out_buf_len( ssl ) )
         return( mtu );
 
-    return( MBEDTLS_SSL_OUT_BUFFER_LEN );
+    return( mbedtls_ssl_out_buf_len( ssl ) );
 }
 
 static int ssl_get_remaining_space_in_datagram( mbedtls_ssl_context const *ssl )
@@ -270,6 +270,162 @@ static unsigned int ssl_mfl_code_to_length( int mfl )
 }
 #endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/*
+ * Length of the input buffer once a handshake is over: one record of the
+ * negotiated maximum fragment length, plus the record expansion.
+ */
+static size_t ssl_get_input_buflen( const mbedtls_ssl_context *ssl )
+{
+    size_t len = MBEDTLS_SSL_IN_CONTENT_LEN;
+
+    if( ssl->session != NULL &&
+        ssl_mfl_code_to_length( ssl->session->mfl_code ) < len )
+    {
+        len = ssl_mfl_code_to_length( ssl->session->mfl_code );
+    }
+
+    return( MBEDTLS_SSL_IN_BUFFER_LEN - MBEDTLS_SSL_IN_CONTENT_LEN + len );
+}
+
+/*
+ * Length of the output buffer once a handshake is over: one record of the
+ * maximum fragment length we send, plus the record expansion.
+ */
+static size_t ssl_get_output_buflen( const mbedtls_ssl_context *ssl )
+{
+    size_t len = mbedtls_ssl_get_max_frag_len( ssl );
+
+    if( len > MBEDTLS_SSL_OUT_CONTENT_LEN )
+        len = MBEDTLS_SSL_OUT_CONTENT_LEN;
+
+    return( MBEDTLS_SSL_OUT_BUFFER_LEN - MBEDTLS_SSL_OUT_CONTENT_LEN + len );
+}
+
+/*
+ * Move the input buffer to a new allocation of len bytes, keeping its
+ * content up to the smaller of both lengths.
+ */
+static int ssl_resize_in_buf( mbedtls_ssl_context *ssl, size_t len )
+{
+    unsigned char *buf;
+    size_t hdr_offset = ssl->in_hdr - ssl->in_buf;
+    size_t ctr_offset = ssl->in_ctr - ssl->in_buf;
+    size_t len_offset = ssl->in_len - ssl->in_buf;
+    size_t iv_offset  = ssl->in_iv  - ssl->in_buf;
+    size_t msg_offset = ssl->in_msg - ssl->in_buf;
+    size_t offt_offset = 0;
+
+    if( ssl->in_offt != NULL )
+        offt_offset = ssl->in_offt - ssl->in_buf;
+
+    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", (int) len ) );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+
+    memcpy( buf, ssl->in_buf, len < ssl->in_buf_len ? len : ssl->in_buf_len );
+    mbedtls_platform_zeroize( ssl->in_buf, ssl->in_buf_len );
+    mbedtls_free( ssl->in_buf );
+
+    ssl->in_buf = buf;
+    ssl->in_buf_len = len;
+
+    ssl->in_hdr = buf + hdr_offset;
+    ssl->in_ctr = buf + ctr_offset;
+    ssl->in_len = buf + len_offset;
+    ssl->in_iv  = buf + iv_offset;
+    ssl->in_msg = buf + msg_offset;
+
+    if( ssl->in_offt != NULL )
+        ssl->in_offt = buf + offt_offset;
+
+    return( 0 );
+}
+
+/*
+ * Move the output buffer to a new allocation of len bytes, keeping its
+ * content up to the smaller of both lengths.
+ */
+static int ssl_resize_out_buf( mbedtls_ssl_context *ssl, size_t len )
+{
+    unsigned char *buf;
+    size_t hdr_offset = ssl->out_hdr - ssl->out_buf;
+    size_t ctr_offset = ssl->out_ctr - ssl->out_buf;
+    size_t len_offset = ssl->out_len - ssl->out_buf;
+    size_t iv_offset  = ssl->out_iv  - ssl->out_buf;
+    size_t msg_offset = ssl->out_msg - ssl->out_buf;
+
+    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", (int) len ) );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+
+    memcpy( buf, ssl->out_buf, len < ssl->out_buf_len ? len : ssl->out_buf_len );
+    mbedtls_platform_zeroize( ssl->out_buf, ssl->out_buf_len );
+    mbedtls_free( ssl->out_buf );
+
+    ssl->out_buf = buf;
+    ssl->out_buf_len = len;
+
+    ssl->out_hdr = buf + hdr_offset;
+    ssl->out_ctr = buf + ctr_offset;
+    ssl->out_len = buf + len_offset;
+    ssl->out_iv  = buf + iv_offset;
+    ssl->out_msg = buf + msg_offset;
+
+    return( 0 );
+}
+
+/*
+ * Shrink the record buffers to the length needed once the handshake is
+ * over. Buffers still holding data beyond that length are left alone, and a
+ * failed allocation keeps the larger buffer.
+ */
+static void ssl_shrink_buffers( mbedtls_ssl_context *ssl )
+{
+    size_t in_len = ssl_get_input_buflen( ssl );
+    size_t out_len = ssl_get_output_buflen( ssl );
+
+    if( ssl->in_buf_len > in_len &&
+        (size_t)( ssl->in_hdr - ssl->in_buf ) + ssl->in_left <= in_len )
+    {
+        if( ssl_resize_in_buf( ssl, in_len ) == 0 )
+            MBEDTLS_SSL_DEBUG_MSG( 3, ( "input buffer shrunk to %d bytes", (int) in_len ) );
+    }
+
+    if( ssl->out_buf_len > out_len && ssl->out_left == 0 )
+    {
+        if( ssl_resize_out_buf( ssl, out_len ) == 0 )
+            MBEDTLS_SSL_DEBUG_MSG( 3, ( "output buffer shrunk to %d bytes", (int) out_len ) );
+    }
+}
+
+/*
+ * Grow the record buffers back to their full length before a handshake.
+ */
+static int ssl_grow_buffers( mbedtls_ssl_context *ssl )
+{
+    int ret;
+
+    if( ssl->in_buf_len < MBEDTLS_SSL_IN_BUFFER_LEN &&
+        ( ret = ssl_resize_in_buf( ssl, MBEDTLS_SSL_IN_BUFFER_LEN ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    if( ssl->out_buf_len < MBEDTLS_SSL_OUT_BUFFER_LEN &&
+        ( ret = ssl_resize_out_buf( ssl, MBEDTLS_SSL_OUT_BUFFER_LEN ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    return( 0 );
+}
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 #if defined(MBEDTLS_SSL_CLI_C)
 static int ssl_session_copy( mbedtls_ssl_session *dst, const mbedtls_ssl_session *src )
 {
@@ -2410,7 +2566,7 @@ static int ssl_compress_buf( mbedtls_ssl_context *ssl )
     ssl->transform_out->ctx_deflate.next_in = msg_pre;
     ssl->transform_out->ctx_deflate.avail_in = len_pre;
     ssl->transform_out->ctx_deflate.next_out = msg_post;
-    ssl->transform_out->ctx_deflate.avail_out = MBEDTLS_SSL_OUT_BUFFER_LEN - bytes_written;
+    ssl->transform_out->ctx_deflate.avail_out = mbedtls_ssl_out_buf_len( ssl ) - bytes_written;
 
     ret = deflate( &ssl->transform_out->ctx_deflate, Z_SYNC_FLUSH );
     if( ret != Z_OK )
@@ -2419,7 +2575,7 @@ static int ssl_compress_buf( mbedtls_ssl_context *ssl )
         return( MBEDTLS_ERR_SSL_COMPRESSION_FAILED );
     }
 
-    ssl->out_msglen = MBEDTLS_SSL_OUT_BUFFER_LEN -
+    ssl->out_msglen = mbedtls_ssl_out_buf_len( ssl ) -
                       ssl->transform_out->ctx_deflate.avail_out - bytes_written;
 
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "after compression: msglen = %d, ",
@@ -2457,7 +2613,7 @@ static int ssl_decompress_buf( mbedtls_ssl_context *ssl )
     ssl->transform_in->ctx_inflate.next_in = msg_pre;
     ssl->transform_in->ctx_inflate.avail_in = len_pre;
     ssl->transform_in->ctx_inflate.next_out = msg_post;
-    ssl->transform_in->ctx_inflate.avail_out = MBEDTLS_SSL_IN_BUFFER_LEN -
+    ssl->transform_in->ctx_inflate.avail_out = mbedtls_ssl_in_buf_len( ssl ) -
                                                header_bytes;
 
     ret = inflate( &ssl->transform_in->ctx_inflate, Z_SYNC_FLUSH );
@@ -2467,7 +2623,7 @@ static int ssl_decompress_buf( mbedtls_ssl_context *ssl )
         return( MBEDTLS_ERR_SSL_COMPRESSION_FAILED );
     }
 
-    ssl->in_msglen = MBEDTLS_SSL_IN_BUFFER_LEN -
+    ssl->in_msglen = mbedtls_ssl_in_buf_len( ssl ) -
                      ssl->transform_in->ctx_inflate.avail_out - header_bytes;
 
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "after decompression: msglen = %d, ",
@@ -2542,7 +2698,7 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
     }
 
-    if( nb_want > MBEDTLS_SSL_IN_BUFFER_LEN - (size_t)( ssl->in_hdr - ssl->in_buf ) )
+    if( nb_want > mbedtls_ssl_in_buf_len( ssl ) - (size_t)( ssl->in_hdr - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "requesting more data than fits" ) );
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
@@ -2628,7 +2784,7 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
         }
         else
         {
-            len = MBEDTLS_SSL_IN_BUFFER_LEN - ( ssl->in_hdr - ssl->in_buf );
+            len = mbedtls_ssl_in_buf_len( ssl ) - ( ssl->in_hdr - ssl->in_buf );
 
             if( ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER )
                 timeout = ssl->handshake->retransmit_timeout;
@@ -4088,7 +4244,7 @@ static int ssl_parse_record_header( mbedtls_ssl_context *ssl )
     }
 
     /* Check length against the size of our buffer */
-    if( ssl->in_msglen > MBEDTLS_SSL_IN_BUFFER_LEN
+    if( ssl->in_msglen > mbedtls_ssl_in_buf_len( ssl )
                          - (size_t)( ssl->in_msg - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "bad message length" ) );
@@ -4877,7 +5033,7 @@ static int ssl_load_buffered_record( mbedtls_ssl_context *ssl )
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "Found buffered record from current epoch - load" ) );
 
     /* Double-check that the record is not too large */
-    if( rec_len > MBEDTLS_SSL_IN_BUFFER_LEN -
+    if( rec_len > mbedtls_ssl_in_buf_len( ssl ) -
         (size_t)( ssl->in_hdr - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "should never happen" ) );
@@ -6326,6 +6482,10 @@ static void ssl_handshake_wrapup_free_hs_transform( mbedtls_ssl_context *ssl )
     ssl->transform = ssl->transform_negotiate;
     ssl->transform_negotiate = NULL;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl_shrink_buffers( ssl );
+#endif
+
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "<= handshake wrapup: final free" ) );
 }
 
@@ -6664,6 +6824,14 @@ void mbedtls_ssl_session_init( mbedtls_ssl_session *session )
 
 static int ssl_handshake_init( mbedtls_ssl_context *ssl )
 {
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    int ret;
+
+    /* Handshake messages may need the full record length */
+    if( ( ret = ssl_grow_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
     /* Clear old handshake information if present */
     if( ssl->transform_negotiate )
         mbedtls_ssl_transform_free( ssl->transform_negotiate );
@@ -6886,6 +7054,9 @@ int mbedtls_ssl_setup( mbedtls_ssl_context *ssl,
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
         goto error;
     }
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl->in_buf_len = MBEDTLS_SSL_IN_BUFFER_LEN;
+#endif
 
     ssl->out_buf = mbedtls_calloc( 1, MBEDTLS_SSL_OUT_BUFFER_LEN );
     if( ssl->out_buf == NULL )
@@ -6894,6 +7065,9 @@ int mbedtls_ssl_setup( mbedtls_ssl_context *ssl,
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
         goto error;
     }
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl->out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
 
     ssl_reset_in_out_pointers( ssl );
 
@@ -6991,14 +7165,14 @@ static int ssl_session_reset_int( mbedtls_ssl_context *ssl, int partial )
     ssl->session_in = NULL;
     ssl->session_out = NULL;
 
-    memset( ssl->out_buf, 0, MBEDTLS_SSL_OUT_BUFFER_LEN );
+    memset( ssl->out_buf, 0, mbedtls_ssl_out_buf_len( ssl ) );
 
 #if defined(MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE) && defined(MBEDTLS_SSL_SRV_C)
     if( partial == 0 )
 #endif /* MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE && MBEDTLS_SSL_SRV_C */
     {
         ssl->in_left = 0;
-        memset( ssl->in_buf, 0, MBEDTLS_SSL_IN_BUFFER_LEN );
+        memset( ssl->in_buf, 0, mbedtls_ssl_in_buf_len( ssl ) );
     }
 
 #if defined(MBEDTLS_SSL_HW_RECORD_ACCEL)
@@ -7983,6 +8157,12 @@ int mbedtls_ssl_get_max_out_record_payload( const mbedtls_ssl_context *ssl )
 {
     size_t max_len = MBEDTLS_SSL_OUT_CONTENT_LEN;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* The output buffer may have been shrunk after the handshake */
+    max_len = ssl->out_buf_len - ( MBEDTLS_SSL_OUT_BUFFER_LEN -
+                                   MBEDTLS_SSL_OUT_CONTENT_LEN );
+#endif
+
 #if !defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH) && \
     !defined(MBEDTLS_SSL_PROTO_DTLS)
     (void) ssl;
@@ -8935,13 +9115,13 @@ void mbedtls_ssl_free( mbedtls_ssl_context *ssl )
 
     if( ssl->out_buf != NULL )
     {
-        mbedtls_platform_zeroize( ssl->out_buf, MBEDTLS_SSL_OUT_BUFFER_LEN );
+        mbedtls_platform_zeroize( ssl->out_buf, mbedtls_ssl_out_buf_len( ssl ) );
         mbedtls_free( ssl->out_buf );
     }
 
     if( ssl->in_buf != NULL )
     {
-        mbedtls_platform_zeroize( ssl->in_buf, MBEDTLS_SSL_IN_BUFFER_LEN );
+        mbedtls_platform_zeroize( ssl->in_buf, mbedtls_ssl_in_buf_len( ssl ) );
         mbedtls_free( ssl->in_buf );
     }
 
@@ -230,6 +230,9 @@ AwsIotDefenderError_t AwsIotDefender_Start( AwsIotDefenderStartInfo_t * pStartIn
             /* Silence warnigns when asserts are disabled. */
             ( void ) taskPoolError;
             AwsIotDefender_Assert( taskPoolError == IOT_TASKPOOL_SUCCESS );
+            /* Metrics reports are periodic and not latency sensitive. */
+            taskPoolError = IotTaskPool_SetJobPriority( IOT_SYSTEM_TASKPOOL, _metricsPublishJob, IOT_TASKPOOL_JOB_PRIORITY_BULK );
+            AwsIotDefender_Assert( taskPoolError == IOT_TASKPOOL_SUCCESS );
             /* Schedule Publish Job */
             taskPoolError = IotTaskPool_Schedule( IOT_SYSTEM_TASKPOOL, _metricsPublishJob, 0 );
             AwsIotDefender_Assert( taskPoolError == IOT_TASKPOOL_SUCCESS );
@@ -66,6 +66,8 @@
  * @function_brief{shadow_function_setupdatedcallback}
  * - @function_name{shadow_function_removepersistentsubscriptions}
  * @function_brief{shadow_function_removepersistentsubscriptions}
+ * - @function_name{shadow_function_flushcoalescedupdates}
+ * @function_brief{shadow_function_flushcoalescedupdates}
  * - @function_name{shadow_function_strerror}
  * @function_brief{shadow_function_strerror}
  */
@@ -107,6 +109,9 @@
  * @function_page{AwsIotShadow_RemovePersistentSubscriptions,shadow,removepersistentsubscriptions}
  * @function_snippet{shadow,removepersistentsubscriptions,this}
  * @copydoc AwsIotShadow_RemovePersistentSubscriptions
+ * @function_page{AwsIotShadow_FlushCoalescedUpdates,shadow,flushcoalescedupdates}
+ * @function_snippet{shadow,flushcoalescedupdates,this}
+ * @copydoc AwsIotShadow_FlushCoalescedUpdates
  * @function_page{AwsIotShadow_strerror,shadow,strerror}
  * @function_snippet{shadow,strerror,this}
  * @copydoc AwsIotShadow_strerror
@@ -412,6 +417,10 @@ AwsIotShadowError_t AwsIotShadow_TimedGet( IotMqttConnection_t mqttConnection,
  * they may be reused <i>as long as no two Shadow updates are using the same
  * client token at the same time</i>.
  *
+ * Frequent updates of a Thing's `reported` state may be passed with
+ * #AWS_IOT_SHADOW_FLAG_COALESCE. Such updates are merged and sent as a single
+ * Shadow update once per @ref AWS_IOT_SHADOW_COALESCE_WINDOW_MS.
+ *
  * @param[in] mqttConnection The MQTT connection to use for Shadow update.
  * @param[in] pUpdateInfo Shadow document parameters.
  * @param[in] flags Flags which modify the behavior of this function. See @ref shadow_constants_flags.
@@ -900,6 +909,27 @@ AwsIotShadowError_t AwsIotShadow_RemovePersistentSubscriptions( IotMqttConnectio
                                                                 uint32_t flags );
 /* @[declare_shadow_removepersistentsubscriptions] */
 
+/**
+ * @brief Send the coalesced Shadow updates of an MQTT connection now.
+ *
+ * Shadow updates passed with #AWS_IOT_SHADOW_FLAG_COALESCE are sent from a
+ * task pool job up to @ref AWS_IOT_SHADOW_COALESCE_WINDOW_MS after this
+ * library receives them, using the MQTT connection of the most recent update.
+ * This function sends the coalesced updates waiting on `mqttConnection`
+ * immediately, and waits for a coalesced update that is already being sent on
+ * it. Once it returns, the Shadow library no longer uses `mqttConnection` for
+ * coalesced updates received before the call.
+ *
+ * @param[in] mqttConnection The MQTT connection whose coalesced updates are sent.
+ *
+ * @warning This function <b>MUST</b> be called before @ref mqtt_function_disconnect
+ * if updates were passed with #AWS_IOT_SHADOW_FLAG_COALESCE on `mqttConnection`.
+ * Otherwise, a coalesced update may be sent on a destroyed MQTT connection.
+ */
+/* @[declare_shadow_flushcoalescedupdates] */
+void AwsIotShadow_FlushCoalescedUpdates( IotMqttConnection_t mqttConnection );
+/* @[declare_shadow_flushcoalescedupdates] */
+
 /*------------------------- Shadow helper functions -------------------------*/
 
 /**
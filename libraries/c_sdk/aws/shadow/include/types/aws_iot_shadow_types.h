@@ -395,6 +395,7 @@ typedef struct AwsIotShadowCallbackParam
 
             AwsIotShadowError_t result;        /**< @brief Result of Shadow operation, e.g. succeeded or failed. */
             AwsIotShadowOperation_t reference; /**< @brief Reference to the Shadow operation that completed. */
+            uint32_t mergedCount;              /**< @brief Number of updates merged by #AWS_IOT_SHADOW_FLAG_COALESCE; 1 for other updates, 0 for other operations. */
         } operation;                           /**< @brief Information on a completed Shadow operation. */
 
         /* Valid for a message on a Shadow delta or updated topic. */
@@ -523,6 +524,10 @@ typedef struct AwsIotShadowDocumentInfo
  * - #AWS_IOT_SHADOW_FLAG_KEEP_SUBSCRIPTIONS <br>
  *   @copybrief AWS_IOT_SHADOW_FLAG_KEEP_SUBSCRIPTIONS
  *
+ * The following flag is only valid for @ref shadow_function_update.
+ * - #AWS_IOT_SHADOW_FLAG_COALESCE <br>
+ *   @copybrief AWS_IOT_SHADOW_FLAG_COALESCE
+ *
  * The following flags are valid for @ref shadow_function_removepersistentsubscriptions.
  * These flags are not valid for the Shadow operation functions.
  * - #AWS_IOT_SHADOW_FLAG_REMOVE_DELETE_SUBSCRIPTIONS <br>
@@ -585,6 +590,38 @@ typedef struct AwsIotShadowDocumentInfo
  */
 #define AWS_IOT_SHADOW_FLAG_KEEP_SUBSCRIPTIONS             ( 0x00000002 )
 
+/**
+ * @brief Merge this Shadow update with other updates of the same Thing and send
+ * them as a single Shadow UPDATE.
+ *
+ * This flag is only valid if passed to the function @ref shadow_function_update.
+ *
+ * Devices that report frequently changing state (such as sensor readings)
+ * often send many small Shadow updates in a short time. Each of these costs a
+ * PUBLISH, an accepted/rejected response, and a Shadow service request. With
+ * this flag, @ref shadow_function_update only merges the `state.reported`
+ * object of the update document into a pending update for the Thing. The
+ * pending update is sent at most @ref AWS_IOT_SHADOW_COALESCE_WINDOW_MS after
+ * the first update merged into it. Members of a newer `reported` object replace
+ * members with the same key from older updates.
+ *
+ * The update document <b>MUST</b> contain a `state.reported` object and a
+ * `clientToken`. Only the `reported` state and the `clientToken` of the update
+ * document are used; the `clientToken` of the most recent update is sent. When
+ * the merged update completes, only the #AwsIotShadowCallbackInfo_t of the most
+ * recent update is invoked; #AwsIotShadowCallbackParam_t.u.operation.mergedCount
+ * is set to the number of updates merged.
+ *
+ * This flag may not be used with #AWS_IOT_SHADOW_FLAG_WAITABLE, and an
+ * #AwsIotShadowOperation_t <b>MUST NOT</b> be provided. The subscriptions for the
+ * Shadow update topics are always maintained as if by #AWS_IOT_SHADOW_FLAG_KEEP_SUBSCRIPTIONS.
+ *
+ * Coalesced updates are sent after @ref shadow_function_update returns, so
+ * @ref shadow_function_flushcoalescedupdates <b>MUST</b> be called before the
+ * MQTT connection is disconnected.
+ */
+#define AWS_IOT_SHADOW_FLAG_COALESCE                       ( 0x00000004 )
+
 /**
  * @brief Remove the persistent subscriptions from a Shadow delete operation.
  *
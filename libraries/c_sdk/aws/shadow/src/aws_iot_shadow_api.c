@@ -38,6 +38,7 @@
 #include "private/aws_iot_shadow_internal.h"
 
 /* Platform layer includes. */
+#include "platform/iot_clock.h"
 #include "platform/iot_threads.h"
 
 /* JSON utilities include. */
@@ -46,6 +47,9 @@
 /* MQTT include. */
 #include "iot_mqtt.h"
 
+/* Task pool include. */
+#include "iot_taskpool.h"
+
 /* Validate Shadow configuration settings. */
 #if AWS_IOT_SHADOW_ENABLE_ASSERTS != 0 && AWS_IOT_SHADOW_ENABLE_ASSERTS != 1
     #error "AWS_IOT_SHADOW_ENABLE_ASSERTS must be 0 or 1."
@@ -53,6 +57,42 @@
 #if AWS_IOT_SHADOW_DEFAULT_MQTT_TIMEOUT_MS <= 0
     #error "AWS_IOT_SHADOW_DEFAULT_MQTT_TIMEOUT_MS cannot be 0 or negative."
 #endif
+#if AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS <= 0
+    #error "AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS cannot be 0 or negative."
+#endif
+#if AWS_IOT_SHADOW_COALESCE_WINDOW_MS <= 0
+    #error "AWS_IOT_SHADOW_COALESCE_WINDOW_MS cannot be 0 or negative."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The start of a coalesced Shadow update document, up to the merged
+ * `reported` state.
+ */
+#define COALESCED_UPDATE_DOCUMENT_PREFIX           "{\"" STATE_KEY "\":{\"" REPORTED_KEY "\":"
+
+/**
+ * @brief The length of #COALESCED_UPDATE_DOCUMENT_PREFIX.
+ */
+#define COALESCED_UPDATE_DOCUMENT_PREFIX_LENGTH    ( sizeof( COALESCED_UPDATE_DOCUMENT_PREFIX ) - 1 )
+
+/**
+ * @brief The part of a coalesced Shadow update document between the merged
+ * `reported` state and the client token.
+ */
+#define COALESCED_UPDATE_DOCUMENT_INFIX            "},\"" CLIENT_TOKEN_KEY "\":"
+
+/**
+ * @brief The length of #COALESCED_UPDATE_DOCUMENT_INFIX.
+ */
+#define COALESCED_UPDATE_DOCUMENT_INFIX_LENGTH     ( sizeof( COALESCED_UPDATE_DOCUMENT_INFIX ) - 1 )
+
+/**
+ * @brief How long to sleep between checks for a coalesced update that is
+ * being sent by its job.
+ */
+#define COALESCED_UPDATE_POLL_MS                   ( 10 )
 
 /*-----------------------------------------------------------*/
 
@@ -88,6 +128,127 @@ static AwsIotShadowError_t _validateDocumentInfo( _shadowOperationType_t type,
                                                   uint32_t flags,
                                                   const AwsIotShadowDocumentInfo_t * pDocumentInfo );
 
+/**
+ * @brief Create a Shadow UPDATE operation and send its document.
+ *
+ * @param[in] mqttConnection The MQTT connection to use.
+ * @param[in] pUpdateInfo Shadow document parameters.
+ * @param[in] flags Flags passed to Shadow API function.
+ * @param[in] pCallbackInfo Callback info passed to Shadow API function.
+ * @param[out] pUpdateOperation Operation reference pointer passed to Shadow API function.
+ * @param[in] pClientToken The client token in the update document, with quotes.
+ * @param[in] clientTokenLength Length of `pClientToken`.
+ * @param[in] mergedCount The number of updates in the update document.
+ * @param[in] pTopicBuffer The Thing's UPDATE topic; `NULL` to generate one.
+ * @param[in] operationTopicLength Length of the UPDATE topic in `pTopicBuffer`.
+ *
+ * @return #AWS_IOT_SHADOW_STATUS_PENDING on success. On error, one of
+ * #AWS_IOT_SHADOW_NO_MEMORY or #AWS_IOT_SHADOW_MQTT_ERROR.
+ */
+static AwsIotShadowError_t _processUpdate( IotMqttConnection_t mqttConnection,
+                                           const AwsIotShadowDocumentInfo_t * pUpdateInfo,
+                                           uint32_t flags,
+                                           const AwsIotShadowCallbackInfo_t * pCallbackInfo,
+                                           AwsIotShadowOperation_t * pUpdateOperation,
+                                           const char * pClientToken,
+                                           size_t clientTokenLength,
+                                           uint32_t mergedCount,
+                                           char * pTopicBuffer,
+                                           uint16_t operationTopicLength );
+
+/**
+ * @brief Match a coalesced update by Thing Name.
+ *
+ * @param[in] pCoalescedUpdateLink Pointer to the link member of a #_shadowCoalescedUpdate_t.
+ * @param[in] pMatch Pointer to an #AwsIotShadowDocumentInfo_t with the Thing Name to match.
+ *
+ * @return `true` if the Thing Names match; `false` otherwise.
+ */
+static bool _coalescedUpdateMatch( const IotLink_t * pCoalescedUpdateLink,
+                                   void * pMatch );
+
+/**
+ * @brief Match a coalesced update that is waiting to be sent or being sent on
+ * an MQTT connection.
+ *
+ * @param[in] pCoalescedUpdateLink Pointer to the link member of a #_shadowCoalescedUpdate_t.
+ * @param[in] pMatch The #IotMqttConnection_t to match.
+ *
+ * @return `true` if the coalesced update uses the MQTT connection; `false` otherwise.
+ */
+static bool _coalescedUpdateConnectionMatch( const IotLink_t * pCoalescedUpdateLink,
+                                             void * pMatch );
+
+/**
+ * @brief Merge a Shadow update into the coalesced update of its Thing.
+ *
+ * @param[in] mqttConnection The MQTT connection to use.
+ * @param[in] pUpdateInfo Shadow document parameters.
+ * @param[in] pCallbackInfo Callback info passed to Shadow API function.
+ * @param[in] pClientToken The client token in the update document, with quotes.
+ * @param[in] clientTokenLength Length of `pClientToken`.
+ *
+ * @return #AWS_IOT_SHADOW_STATUS_PENDING on success. On error, one of
+ * #AWS_IOT_SHADOW_BAD_PARAMETER or #AWS_IOT_SHADOW_NO_MEMORY.
+ */
+static AwsIotShadowError_t _coalesceUpdate( IotMqttConnection_t mqttConnection,
+                                            const AwsIotShadowDocumentInfo_t * pUpdateInfo,
+                                            const AwsIotShadowCallbackInfo_t * pCallbackInfo,
+                                            const char * pClientToken,
+                                            size_t clientTokenLength );
+
+/**
+ * @brief Task pool routine that sends a coalesced update.
+ *
+ * @param[in] pTaskPool Pointer to the system task pool.
+ * @param[in] pSendJob The job that sends the coalesced update.
+ * @param[in] pContext Pointer to a #_shadowCoalescedUpdate_t.
+ */
+static void _sendCoalescedUpdate( IotTaskPool_t pTaskPool,
+                                  IotTaskPoolJob_t pSendJob,
+                                  void * pContext );
+
+/**
+ * @brief Schedule the job that sends a coalesced update at the end of the
+ * coalesce window.
+ *
+ * Must be called with #_AwsIotShadowCoalescedUpdatesMutex locked.
+ *
+ * @param[in] pCoalescedUpdate The coalesced update to send.
+ *
+ * @return The status returned by the task pool.
+ */
+static IotTaskPoolError_t _scheduleCoalescedUpdate( _shadowCoalescedUpdate_t * pCoalescedUpdate );
+
+/**
+ * @brief Invoke the callback of coalesced updates that could not be sent.
+ *
+ * @param[in] pCallbackInfo Callback of the most recent coalesced update.
+ * @param[in] pThingName Thing Name of the coalesced updates.
+ * @param[in] thingNameLength Length of `pThingName`.
+ * @param[in] mqttConnection MQTT connection of the most recent coalesced update.
+ * @param[in] status Why the coalesced updates could not be sent.
+ * @param[in] mergedCount Number of coalesced updates.
+ */
+static void _reportCoalescedUpdateFailure( const AwsIotShadowCallbackInfo_t * pCallbackInfo,
+                                           const char * pThingName,
+                                           size_t thingNameLength,
+                                           IotMqttConnection_t mqttConnection,
+                                           AwsIotShadowError_t status,
+                                           uint32_t mergedCount );
+
+/**
+ * @brief Discard the updates of a coalesced update and free it.
+ *
+ * Its send job is canceled. If the job already runs, this function waits for
+ * it to finish. Must be called with #_AwsIotShadowCoalescedUpdatesMutex locked
+ * and the coalesced update removed from #_AwsIotShadowCoalescedUpdates. The
+ * mutex is released while waiting.
+ *
+ * @param[in] pCoalescedUpdate The coalesced update to free.
+ */
+static void _destroyCoalescedUpdate( _shadowCoalescedUpdate_t * pCoalescedUpdate );
+
 /**
  * @brief Common function for setting Shadow callbacks.
  *
@@ -158,6 +319,21 @@ static void _updatedCallbackWrapper( void * pArgument,
  */
 uint32_t _AwsIotShadowMqttTimeoutMs = AWS_IOT_SHADOW_DEFAULT_MQTT_TIMEOUT_MS;
 
+/**
+ * @brief How long Shadow updates are coalesced before being sent.
+ */
+uint32_t _AwsIotShadowCoalesceWindowMs = AWS_IOT_SHADOW_COALESCE_WINDOW_MS;
+
+/**
+ * @brief List of coalesced Shadow updates, one per Thing.
+ */
+IotListDouble_t _AwsIotShadowCoalescedUpdates = { 0 };
+
+/**
+ * @brief Protects #_AwsIotShadowCoalescedUpdates and its updates.
+ */
+IotMutex_t _AwsIotShadowCoalescedUpdatesMutex;
+
 #if LIBRARY_LOG_LEVEL > IOT_LOG_NONE
 
 /**
@@ -223,6 +399,28 @@ static AwsIotShadowError_t _validateThingNameFlags( _shadowOperationType_t type,
         }
     }
 
+    /* Check the coalesce flag. */
+    if( ( flags & AWS_IOT_SHADOW_FLAG_COALESCE ) == AWS_IOT_SHADOW_FLAG_COALESCE )
+    {
+        if( type != _SHADOW_UPDATE )
+        {
+            IotLogError( "Shadow %s cannot be coalesced.",
+                         _pAwsIotShadowOperationNames[ type ] );
+
+            return AWS_IOT_SHADOW_BAD_PARAMETER;
+        }
+
+        /* A coalesced update completes after this function returns, possibly
+         * together with later updates, so it cannot be waited on. */
+        if( ( ( flags & AWS_IOT_SHADOW_FLAG_WAITABLE ) == AWS_IOT_SHADOW_FLAG_WAITABLE ) ||
+            ( pOperation != NULL ) )
+        {
+            IotLogError( "Coalesced Shadow UPDATE cannot be waitable or have a reference." );
+
+            return AWS_IOT_SHADOW_BAD_PARAMETER;
+        }
+    }
+
     /* A callback info must be passed to a non-waitable GET. */
     if( ( type == _SHADOW_GET ) &&
         ( ( flags & AWS_IOT_SHADOW_FLAG_WAITABLE ) == 0 ) &&
@@ -310,6 +508,565 @@ static AwsIotShadowError_t _validateDocumentInfo( _shadowOperationType_t type,
 
 /*-----------------------------------------------------------*/
 
+static AwsIotShadowError_t _processUpdate( IotMqttConnection_t mqttConnection,
+                                           const AwsIotShadowDocumentInfo_t * pUpdateInfo,
+                                           uint32_t flags,
+                                           const AwsIotShadowCallbackInfo_t * pCallbackInfo,
+                                           AwsIotShadowOperation_t * pUpdateOperation,
+                                           const char * pClientToken,
+                                           size_t clientTokenLength,
+                                           uint32_t mergedCount,
+                                           char * pTopicBuffer,
+                                           uint16_t operationTopicLength )
+{
+    _shadowOperation_t * pOperation = NULL;
+    AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
+
+    /* Allocate a new Shadow operation for UPDATE. */
+    if( _AwsIotShadow_CreateOperation( &pOperation,
+                                       _SHADOW_UPDATE,
+                                       flags,
+                                       pCallbackInfo ) != AWS_IOT_SHADOW_SUCCESS )
+    {
+        /* No memory for a new Shadow operation. */
+        return AWS_IOT_SHADOW_NO_MEMORY;
+    }
+
+    /* Check the members set by Shadow operation creation. */
+    AwsIotShadow_Assert( pOperation != NULL );
+    AwsIotShadow_Assert( pOperation->type == _SHADOW_UPDATE );
+    AwsIotShadow_Assert( pOperation->flags == flags );
+    AwsIotShadow_Assert( pOperation->status == AWS_IOT_SHADOW_STATUS_PENDING );
+
+    /* Allocate memory for the client token. */
+    pOperation->u.update.pClientToken = AwsIotShadow_MallocString( clientTokenLength );
+
+    if( pOperation->u.update.pClientToken == NULL )
+    {
+        IotLogError( "Failed to allocate memory for Shadow update client token." );
+        _AwsIotShadow_DestroyOperation( pOperation );
+
+        return AWS_IOT_SHADOW_NO_MEMORY;
+    }
+
+    /* Copy the client token. The client token must be copied in case the application
+     * frees the buffer containing it. */
+    ( void ) memcpy( ( void * ) pOperation->u.update.pClientToken,
+                     pClientToken,
+                     clientTokenLength );
+    pOperation->u.update.clientTokenLength = clientTokenLength;
+    pOperation->u.update.mergedCount = mergedCount;
+
+    /* Set the reference if provided. This must be done before the Shadow operation
+     * is processed. */
+    if( pUpdateOperation != NULL )
+    {
+        *pUpdateOperation = pOperation;
+    }
+
+    /* Process the Shadow operation. This subscribes to any required topics and
+     * sends the MQTT message for the Shadow operation. */
+    status = _AwsIotShadow_ProcessOperation( mqttConnection,
+                                             pUpdateInfo->pThingName,
+                                             pUpdateInfo->thingNameLength,
+                                             pOperation,
+                                             pUpdateInfo,
+                                             pTopicBuffer,
+                                             operationTopicLength );
+
+    /* If the Shadow operation failed, clear the now invalid reference. */
+    if( ( status != AWS_IOT_SHADOW_STATUS_PENDING ) && ( pUpdateOperation != NULL ) )
+    {
+        *pUpdateOperation = AWS_IOT_SHADOW_OPERATION_INITIALIZER;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _coalescedUpdateMatch( const IotLink_t * pCoalescedUpdateLink,
+                                   void * pMatch )
+{
+    bool match = false;
+    const _shadowCoalescedUpdate_t * pCoalescedUpdate = IotLink_Container( _shadowCoalescedUpdate_t,
+                                                                           pCoalescedUpdateLink,
+                                                                           link );
+    const AwsIotShadowDocumentInfo_t * pUpdateInfo = ( const AwsIotShadowDocumentInfo_t * ) pMatch;
+
+    /* Because this function is called from a container function, the given link
+     * must never be NULL. */
+    AwsIotShadow_Assert( pCoalescedUpdateLink != NULL );
+
+    if( pCoalescedUpdate->thingNameLength == pUpdateInfo->thingNameLength )
+    {
+        match = ( strncmp( pCoalescedUpdate->pThingName,
+                           pUpdateInfo->pThingName,
+                           pUpdateInfo->thingNameLength ) == 0 );
+    }
+
+    return match;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _coalescedUpdateConnectionMatch( const IotLink_t * pCoalescedUpdateLink,
+                                             void * pMatch )
+{
+    IotMqttConnection_t mqttConnection = ( IotMqttConnection_t ) pMatch;
+    const _shadowCoalescedUpdate_t * pCoalescedUpdate = IotLink_Container( _shadowCoalescedUpdate_t,
+                                                                           pCoalescedUpdateLink,
+                                                                           link );
+
+    return ( mqttConnection != IOT_MQTT_CONNECTION_INITIALIZER ) &&
+           ( ( ( pCoalescedUpdate->mergedCount > 0 ) &&
+               ( pCoalescedUpdate->mqttConnection == mqttConnection ) ) ||
+             ( pCoalescedUpdate->sendingConnection == mqttConnection ) );
+}
+
+/*-----------------------------------------------------------*/
+
+static AwsIotShadowError_t _coalesceUpdate( IotMqttConnection_t mqttConnection,
+                                            const AwsIotShadowDocumentInfo_t * pUpdateInfo,
+                                            const AwsIotShadowCallbackInfo_t * pCallbackInfo,
+                                            const char * pClientToken,
+                                            size_t clientTokenLength )
+{
+    AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
+    IotTaskPoolError_t taskPoolStatus = IOT_TASKPOOL_SUCCESS;
+    _shadowCoalescedUpdate_t * pCoalescedUpdate = NULL;
+    IotLink_t * pCoalescedUpdateLink = NULL;
+    const char * pState = NULL, * pReported = NULL;
+    size_t stateLength = 0, reportedLength = 0, mergedLength = 0;
+    char * pMerged = NULL;
+
+    /* Find the reported state in the update document. */
+    if( ( IotJsonUtils_FindJsonValue( pUpdateInfo->u.update.pUpdateDocument,
+                                      pUpdateInfo->u.update.updateDocumentLength,
+                                      STATE_KEY,
+                                      STATE_KEY_LENGTH,
+                                      &pState,
+                                      &stateLength ) == false ) ||
+        ( IotJsonUtils_FindJsonValue( pState,
+                                      stateLength,
+                                      REPORTED_KEY,
+                                      REPORTED_KEY_LENGTH,
+                                      &pReported,
+                                      &reportedLength ) == false ) ||
+        ( pReported[ 0 ] != '{' ) )
+    {
+        IotLogError( "Shadow document for coalesced Shadow UPDATE must have a "
+                     "%s.%s object.", STATE_KEY, REPORTED_KEY );
+
+        return AWS_IOT_SHADOW_BAD_PARAMETER;
+    }
+
+    IotMutex_Lock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    /* Find the coalesced update of this Thing. */
+    pCoalescedUpdateLink = IotListDouble_FindFirstMatch( &( _AwsIotShadowCoalescedUpdates ),
+                                                         NULL,
+                                                         _coalescedUpdateMatch,
+                                                         ( void * ) pUpdateInfo );
+
+    if( pCoalescedUpdateLink != NULL )
+    {
+        pCoalescedUpdate = IotLink_Container( _shadowCoalescedUpdate_t, pCoalescedUpdateLink, link );
+    }
+    else
+    {
+        /* Create a coalesced update for this Thing. */
+        pCoalescedUpdate = AwsIotShadow_MallocCoalescedUpdate( sizeof( _shadowCoalescedUpdate_t ) +
+                                                               pUpdateInfo->thingNameLength );
+
+        if( pCoalescedUpdate == NULL )
+        {
+            IotLogError( "Failed to allocate memory for Shadow coalesced update." );
+
+            status = AWS_IOT_SHADOW_NO_MEMORY;
+        }
+        else
+        {
+            ( void ) memset( pCoalescedUpdate, 0x00, sizeof( _shadowCoalescedUpdate_t ) );
+            ( void ) memcpy( pCoalescedUpdate->pThingName,
+                             pUpdateInfo->pThingName,
+                             pUpdateInfo->thingNameLength );
+            pCoalescedUpdate->thingNameLength = pUpdateInfo->thingNameLength;
+
+            /* Generate the UPDATE topic once; it is reused for every coalesced
+             * update of this Thing. */
+            if( _AwsIotShadow_GenerateShadowTopic( _SHADOW_UPDATE,
+                                                   pCoalescedUpdate->pThingName,
+                                                   pCoalescedUpdate->thingNameLength,
+                                                   &( pCoalescedUpdate->pTopicBuffer ),
+                                                   &( pCoalescedUpdate->topicLength ) ) != AWS_IOT_SHADOW_SUCCESS )
+            {
+                IotLogError( "No memory for Shadow coalesced update topic buffer." );
+                AwsIotShadow_FreeCoalescedUpdate( pCoalescedUpdate );
+
+                status = AWS_IOT_SHADOW_NO_MEMORY;
+            }
+            else
+            {
+                IotListDouble_InsertHead( &( _AwsIotShadowCoalescedUpdates ),
+                                          &( pCoalescedUpdate->link ) );
+            }
+        }
+    }
+
+    if( status == AWS_IOT_SHADOW_STATUS_PENDING )
+    {
+        /* Merge the reported state with the states waiting to be sent. */
+        if( pCoalescedUpdate->mergedCount == 0 )
+        {
+            mergedLength = reportedLength;
+        }
+        else if( _AwsIotShadow_MergeReportedState( pCoalescedUpdate->pReported,
+                                                   pCoalescedUpdate->reportedLength,
+                                                   pReported,
+                                                   reportedLength,
+                                                   NULL,
+                                                   &mergedLength ) != AWS_IOT_SHADOW_SUCCESS )
+        {
+            IotLogError( "Failed to parse reported state of coalesced Shadow UPDATE." );
+
+            status = AWS_IOT_SHADOW_BAD_PARAMETER;
+        }
+    }
+
+    if( status == AWS_IOT_SHADOW_STATUS_PENDING )
+    {
+        pMerged = AwsIotShadow_MallocString( mergedLength );
+
+        if( pMerged == NULL )
+        {
+            IotLogError( "Failed to allocate memory for coalesced Shadow UPDATE." );
+
+            status = AWS_IOT_SHADOW_NO_MEMORY;
+        }
+        else
+        {
+            if( pCoalescedUpdate->mergedCount == 0 )
+            {
+                ( void ) memcpy( pMerged, pReported, reportedLength );
+            }
+            else
+            {
+                ( void ) _AwsIotShadow_MergeReportedState( pCoalescedUpdate->pReported,
+                                                           pCoalescedUpdate->reportedLength,
+                                                           pReported,
+                                                           reportedLength,
+                                                           pMerged,
+                                                           &mergedLength );
+
+                AwsIotShadow_FreeString( pCoalescedUpdate->pReported );
+            }
+
+            pCoalescedUpdate->pReported = pMerged;
+            pCoalescedUpdate->reportedLength = mergedLength;
+
+            /* The most recent update's parameters are used to send the
+             * coalesced update. */
+            ( void ) memcpy( pCoalescedUpdate->pClientToken, pClientToken, clientTokenLength );
+            pCoalescedUpdate->clientTokenLength = clientTokenLength;
+            pCoalescedUpdate->mqttConnection = mqttConnection;
+            pCoalescedUpdate->updateInfo = *pUpdateInfo;
+
+            if( pCallbackInfo != NULL )
+            {
+                pCoalescedUpdate->callback = *pCallbackInfo;
+            }
+            else
+            {
+                pCoalescedUpdate->callback.function = NULL;
+                pCoalescedUpdate->callback.pCallbackContext = NULL;
+            }
+
+            pCoalescedUpdate->mergedCount++;
+
+            /* The first update merged opens the coalesce window. While the
+             * previous window is being sent, its job schedules the next one
+             * when it finishes. */
+            if( ( pCoalescedUpdate->mergedCount == 1 ) &&
+                ( pCoalescedUpdate->sendingConnection == IOT_MQTT_CONNECTION_INITIALIZER ) )
+            {
+                taskPoolStatus = _scheduleCoalescedUpdate( pCoalescedUpdate );
+
+                if( taskPoolStatus != IOT_TASKPOOL_SUCCESS )
+                {
+                    AwsIotShadow_FreeString( pCoalescedUpdate->pReported );
+                    pCoalescedUpdate->pReported = NULL;
+                    pCoalescedUpdate->mergedCount = 0;
+
+                    status = AWS_IOT_SHADOW_NO_MEMORY;
+                }
+            }
+
+            if( status == AWS_IOT_SHADOW_STATUS_PENDING )
+            {
+                IotLogDebug( "Coalesced %lu Shadow UPDATEs for Thing %.*s.",
+                             ( unsigned long ) pCoalescedUpdate->mergedCount,
+                             pCoalescedUpdate->thingNameLength,
+                             pCoalescedUpdate->pThingName );
+            }
+        }
+    }
+
+    IotMutex_Unlock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _sendCoalescedUpdate( IotTaskPool_t pTaskPool,
+                                  IotTaskPoolJob_t pSendJob,
+                                  void * pContext )
+{
+    _shadowCoalescedUpdate_t * pCoalescedUpdate = ( _shadowCoalescedUpdate_t * ) pContext;
+    AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
+    IotTaskPoolError_t taskPoolStatus = IOT_TASKPOOL_SUCCESS;
+    AwsIotShadowDocumentInfo_t updateInfo = AWS_IOT_SHADOW_DOCUMENT_INFO_INITIALIZER;
+    AwsIotShadowCallbackInfo_t callbackInfo = AWS_IOT_SHADOW_CALLBACK_INFO_INITIALIZER;
+    AwsIotShadowCallbackInfo_t nextCallbackInfo = AWS_IOT_SHADOW_CALLBACK_INFO_INITIALIZER;
+    IotMqttConnection_t mqttConnection = IOT_MQTT_CONNECTION_INITIALIZER;
+    IotMqttConnection_t nextMqttConnection = IOT_MQTT_CONNECTION_INITIALIZER;
+    char * pReported = NULL, * pDocument = NULL;
+    size_t reportedLength = 0, documentLength = 0;
+    char pClientToken[ MAX_CLIENT_TOKEN_LENGTH ] = { 0 };
+    size_t clientTokenLength = 0;
+    char pThingName[ MAX_THING_NAME_LENGTH ] = { 0 };
+    size_t thingNameLength = 0;
+    uint32_t mergedCount = 0, nextMergedCount = 0;
+
+    /* Unused parameters. */
+    ( void ) pTaskPool;
+    ( void ) pSendJob;
+
+    /* Take the merged updates. Updates merged after this point open a new
+     * coalesce window. */
+    IotMutex_Lock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    pReported = pCoalescedUpdate->pReported;
+    reportedLength = pCoalescedUpdate->reportedLength;
+    ( void ) memcpy( pClientToken, pCoalescedUpdate->pClientToken, pCoalescedUpdate->clientTokenLength );
+    clientTokenLength = pCoalescedUpdate->clientTokenLength;
+    mergedCount = pCoalescedUpdate->mergedCount;
+    mqttConnection = pCoalescedUpdate->mqttConnection;
+    updateInfo = pCoalescedUpdate->updateInfo;
+    callbackInfo = pCoalescedUpdate->callback;
+    ( void ) memcpy( pThingName, pCoalescedUpdate->pThingName, pCoalescedUpdate->thingNameLength );
+    thingNameLength = pCoalescedUpdate->thingNameLength;
+
+    pCoalescedUpdate->pReported = NULL;
+    pCoalescedUpdate->reportedLength = 0;
+    pCoalescedUpdate->mergedCount = 0;
+
+    /* The coalesced update may not be freed, and its MQTT connection should
+     * not be disconnected, until this function is done with them. */
+    pCoalescedUpdate->sendingConnection = mqttConnection;
+
+    IotMutex_Unlock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    AwsIotShadow_Assert( pReported != NULL );
+    AwsIotShadow_Assert( mergedCount > 0 );
+
+    /* Build the update document:
+     * {"state":{"reported":<merged>},"clientToken":<token>} */
+    documentLength = COALESCED_UPDATE_DOCUMENT_PREFIX_LENGTH +
+                     reportedLength +
+                     COALESCED_UPDATE_DOCUMENT_INFIX_LENGTH +
+                     clientTokenLength + 1;
+    pDocument = AwsIotShadow_MallocString( documentLength );
+
+    if( pDocument == NULL )
+    {
+        IotLogError( "Failed to allocate memory for coalesced Shadow UPDATE document." );
+
+        status = AWS_IOT_SHADOW_NO_MEMORY;
+    }
+    else
+    {
+        ( void ) memcpy( pDocument,
+                         COALESCED_UPDATE_DOCUMENT_PREFIX,
+                         COALESCED_UPDATE_DOCUMENT_PREFIX_LENGTH );
+        ( void ) memcpy( pDocument + COALESCED_UPDATE_DOCUMENT_PREFIX_LENGTH,
+                         pReported,
+                         reportedLength );
+        ( void ) memcpy( pDocument + COALESCED_UPDATE_DOCUMENT_PREFIX_LENGTH + reportedLength,
+                         COALESCED_UPDATE_DOCUMENT_INFIX,
+                         COALESCED_UPDATE_DOCUMENT_INFIX_LENGTH );
+        ( void ) memcpy( pDocument + documentLength - clientTokenLength - 1,
+                         pClientToken,
+                         clientTokenLength );
+        pDocument[ documentLength - 1 ] = '}';
+
+        updateInfo.pThingName = pCoalescedUpdate->pThingName;
+        updateInfo.thingNameLength = pCoalescedUpdate->thingNameLength;
+        updateInfo.u.update.pUpdateDocument = pDocument;
+        updateInfo.u.update.updateDocumentLength = documentLength;
+
+        IotLogInfo( "Sending %lu coalesced Shadow UPDATEs for Thing %.*s.",
+                    ( unsigned long ) mergedCount,
+                    pCoalescedUpdate->thingNameLength,
+                    pCoalescedUpdate->pThingName );
+
+        /* Coalesced updates are frequent by nature, so their subscriptions are
+         * kept. */
+        status = _processUpdate( mqttConnection,
+                                 &updateInfo,
+                                 AWS_IOT_SHADOW_FLAG_KEEP_SUBSCRIPTIONS,
+                                 ( callbackInfo.function != NULL ) ? &callbackInfo : NULL,
+                                 NULL,
+                                 pDocument + documentLength - clientTokenLength - 1,
+                                 clientTokenLength,
+                                 mergedCount,
+                                 pCoalescedUpdate->pTopicBuffer,
+                                 pCoalescedUpdate->topicLength );
+
+        /* The update document was sent in an MQTT PUBLISH, so it is no longer needed. */
+        AwsIotShadow_FreeString( pDocument );
+    }
+
+    AwsIotShadow_FreeString( pReported );
+
+    IotMutex_Lock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    /* Updates merged while this one was sent open the next coalesce window. */
+    if( pCoalescedUpdate->mergedCount > 0 )
+    {
+        taskPoolStatus = _scheduleCoalescedUpdate( pCoalescedUpdate );
+
+        if( taskPoolStatus != IOT_TASKPOOL_SUCCESS )
+        {
+            nextCallbackInfo = pCoalescedUpdate->callback;
+            nextMqttConnection = pCoalescedUpdate->mqttConnection;
+            nextMergedCount = pCoalescedUpdate->mergedCount;
+
+            AwsIotShadow_FreeString( pCoalescedUpdate->pReported );
+            pCoalescedUpdate->pReported = NULL;
+            pCoalescedUpdate->reportedLength = 0;
+            pCoalescedUpdate->mergedCount = 0;
+        }
+    }
+
+    /* The coalesced update must not be used past this point. */
+    pCoalescedUpdate->sendingConnection = IOT_MQTT_CONNECTION_INITIALIZER;
+
+    IotMutex_Unlock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    /* The application has no other way to learn that a coalesced update
+     * could not be sent, so report the failure through its callback. */
+    if( status != AWS_IOT_SHADOW_STATUS_PENDING )
+    {
+        _reportCoalescedUpdateFailure( &callbackInfo,
+                                       pThingName,
+                                       thingNameLength,
+                                       mqttConnection,
+                                       status,
+                                       mergedCount );
+    }
+
+    if( nextMergedCount > 0 )
+    {
+        _reportCoalescedUpdateFailure( &nextCallbackInfo,
+                                       pThingName,
+                                       thingNameLength,
+                                       nextMqttConnection,
+                                       AWS_IOT_SHADOW_NO_MEMORY,
+                                       nextMergedCount );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static IotTaskPoolError_t _scheduleCoalescedUpdate( _shadowCoalescedUpdate_t * pCoalescedUpdate )
+{
+    IotTaskPoolError_t taskPoolStatus = IOT_TASKPOOL_SUCCESS;
+
+    /* Creating a job with valid parameters should never fail. */
+    taskPoolStatus = IotTaskPool_CreateJob( _sendCoalescedUpdate,
+                                            pCoalescedUpdate,
+                                            &( pCoalescedUpdate->jobStorage ),
+                                            &( pCoalescedUpdate->job ) );
+    AwsIotShadow_Assert( taskPoolStatus == IOT_TASKPOOL_SUCCESS );
+
+    taskPoolStatus = IotTaskPool_ScheduleDeferred( IOT_SYSTEM_TASKPOOL,
+                                                   pCoalescedUpdate->job,
+                                                   _AwsIotShadowCoalesceWindowMs );
+
+    if( taskPoolStatus != IOT_TASKPOOL_SUCCESS )
+    {
+        IotLogError( "Failed to schedule coalesced Shadow UPDATE, error %s.",
+                     IotTaskPool_strerror( taskPoolStatus ) );
+    }
+
+    return taskPoolStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _reportCoalescedUpdateFailure( const AwsIotShadowCallbackInfo_t * pCallbackInfo,
+                                           const char * pThingName,
+                                           size_t thingNameLength,
+                                           IotMqttConnection_t mqttConnection,
+                                           AwsIotShadowError_t status,
+                                           uint32_t mergedCount )
+{
+    AwsIotShadowCallbackParam_t callbackParam = { .callbackType = ( AwsIotShadowCallbackType_t ) 0 };
+
+    if( pCallbackInfo->function != NULL )
+    {
+        callbackParam.callbackType = AWS_IOT_SHADOW_UPDATE_COMPLETE;
+        callbackParam.pThingName = pThingName;
+        callbackParam.thingNameLength = thingNameLength;
+        callbackParam.mqttConnection = mqttConnection;
+        callbackParam.u.operation.result = status;
+        callbackParam.u.operation.reference = AWS_IOT_SHADOW_OPERATION_INITIALIZER;
+        callbackParam.u.operation.mergedCount = mergedCount;
+
+        pCallbackInfo->function( pCallbackInfo->pCallbackContext, &callbackParam );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _destroyCoalescedUpdate( _shadowCoalescedUpdate_t * pCoalescedUpdate )
+{
+    /* The send job may still run even after it was removed from the list, so
+     * it must be canceled or have finished before the coalesced update is freed. */
+    while( ( pCoalescedUpdate->mergedCount > 0 ) ||
+           ( pCoalescedUpdate->sendingConnection != IOT_MQTT_CONNECTION_INITIALIZER ) )
+    {
+        if( ( pCoalescedUpdate->mergedCount > 0 ) &&
+            ( IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL,
+                                     pCoalescedUpdate->job,
+                                     NULL ) == IOT_TASKPOOL_SUCCESS ) )
+        {
+            /* Discard the updates that were waiting to be sent. */
+            AwsIotShadow_FreeString( pCoalescedUpdate->pReported );
+            pCoalescedUpdate->pReported = NULL;
+            pCoalescedUpdate->mergedCount = 0;
+        }
+        else
+        {
+            /* The send job is already running. Wait for it to finish. */
+            IotMutex_Unlock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+            IotClock_SleepMs( COALESCED_UPDATE_POLL_MS );
+            IotMutex_Lock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+        }
+    }
+
+    if( pCoalescedUpdate->pTopicBuffer != NULL )
+    {
+        AwsIotShadow_FreeString( pCoalescedUpdate->pTopicBuffer );
+    }
+
+    AwsIotShadow_FreeCoalescedUpdate( pCoalescedUpdate );
+}
+
+/*-----------------------------------------------------------*/
+
 static AwsIotShadowError_t _setCallbackCommon( IotMqttConnection_t mqttConnection,
                                                _shadowCallbackType_t type,
                                                const char * pThingName,
@@ -590,6 +1347,8 @@ static void _updatedCallbackWrapper( void * pArgument,
 
 AwsIotShadowError_t AwsIotShadow_Init( uint32_t mqttTimeoutMs )
 {
+    size_t i = 0;
+
     /* Create the Shadow pending operation list mutex. */
     if( IotMutex_Create( &( _AwsIotShadowPendingOperationsMutex ), false ) == false )
     {
@@ -607,9 +1366,25 @@ AwsIotShadowError_t AwsIotShadow_Init( uint32_t mqttTimeoutMs )
         return AWS_IOT_SHADOW_INIT_FAILED;
     }
 
+    /* Create the Shadow coalesced update list mutex. */
+    if( IotMutex_Create( &( _AwsIotShadowCoalescedUpdatesMutex ), false ) == false )
+    {
+        IotLogError( "Failed to create Shadow coalesced update list." );
+        IotMutex_Destroy( &_AwsIotShadowPendingOperationsMutex );
+        IotMutex_Destroy( &_AwsIotShadowSubscriptionsMutex );
+
+        return AWS_IOT_SHADOW_INIT_FAILED;
+    }
+
     /* Create Shadow linear containers. */
     IotListDouble_Create( &( _AwsIotShadowPendingOperations ) );
     IotListDouble_Create( &( _AwsIotShadowSubscriptions ) );
+    IotListDouble_Create( &( _AwsIotShadowCoalescedUpdates ) );
+
+    for( i = 0; i < AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS; i++ )
+    {
+        IotListDouble_Create( &( _AwsIotShadowPendingUpdates[ i ] ) );
+    }
 
     /* Save the MQTT timeout option. */
     if( mqttTimeoutMs != 0 )
@@ -626,11 +1401,33 @@ AwsIotShadowError_t AwsIotShadow_Init( uint32_t mqttTimeoutMs )
 
 void AwsIotShadow_Cleanup( void )
 {
-    /* Remove and free all items in the Shadow pending operation list. */
+    size_t i = 0;
+    IotLink_t * pCoalescedUpdateLink = NULL;
+
+    /* Remove and free all coalesced updates. Updates that were not sent yet
+     * are discarded. */
+    IotMutex_Lock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    while( ( pCoalescedUpdateLink = IotListDouble_RemoveHead( &( _AwsIotShadowCoalescedUpdates ) ) ) != NULL )
+    {
+        _destroyCoalescedUpdate( IotLink_Container( _shadowCoalescedUpdate_t, pCoalescedUpdateLink, link ) );
+    }
+
+    IotMutex_Unlock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    /* Remove and free all items in the Shadow pending operation lists. */
     IotMutex_Lock( &( _AwsIotShadowPendingOperationsMutex ) );
     IotListDouble_RemoveAll( &( _AwsIotShadowPendingOperations ),
                              _AwsIotShadow_DestroyOperation,
                              offsetof( _shadowOperation_t, link ) );
+
+    for( i = 0; i < AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS; i++ )
+    {
+        IotListDouble_RemoveAll( &( _AwsIotShadowPendingUpdates[ i ] ),
+                                 _AwsIotShadow_DestroyOperation,
+                                 offsetof( _shadowOperation_t, link ) );
+    }
+
     IotMutex_Unlock( &( _AwsIotShadowPendingOperationsMutex ) );
 
     /* Remove and free all items in the Shadow subscription list. */
@@ -643,9 +1440,11 @@ void AwsIotShadow_Cleanup( void )
     /* Destroy Shadow library mutexes. */
     IotMutex_Destroy( &( _AwsIotShadowPendingOperationsMutex ) );
     IotMutex_Destroy( &( _AwsIotShadowSubscriptionsMutex ) );
+    IotMutex_Destroy( &( _AwsIotShadowCoalescedUpdatesMutex ) );
 
-    /* Restore the default MQTT timeout. */
+    /* Restore the default MQTT timeout and coalesce window. */
     _AwsIotShadowMqttTimeoutMs = AWS_IOT_SHADOW_DEFAULT_MQTT_TIMEOUT_MS;
+    _AwsIotShadowCoalesceWindowMs = AWS_IOT_SHADOW_COALESCE_WINDOW_MS;
 
     IotLogInfo( "Shadow library cleanup done." );
 }
@@ -703,7 +1502,9 @@ AwsIotShadowError_t AwsIotShadow_Delete( IotMqttConnection_t mqttConnection,
                                              pThingName,
                                              thingNameLength,
                                              pOperation,
-                                             NULL );
+                                             NULL,
+                                             NULL,
+                                             0 );
 
     /* If the Shadow operation failed, clear the now invalid reference. */
     if( ( status != AWS_IOT_SHADOW_STATUS_PENDING ) && ( pDeleteOperation != NULL ) )
@@ -812,7 +1613,9 @@ AwsIotShadowError_t AwsIotShadow_Get( IotMqttConnection_t mqttConnection,
                                              pGetInfo->pThingName,
                                              pGetInfo->thingNameLength,
                                              pOperation,
-                                             pGetInfo );
+                                             pGetInfo,
+                                             NULL,
+                                             0 );
 
     /* If the Shadow operation failed, clear the now invalid reference. */
     if( ( status != AWS_IOT_SHADOW_STATUS_PENDING ) && ( pGetOperation != NULL ) )
@@ -868,8 +1671,6 @@ AwsIotShadowError_t AwsIotShadow_Update( IotMqttConnection_t mqttConnection,
                                          const AwsIotShadowCallbackInfo_t * pCallbackInfo,
                                          AwsIotShadowOperation_t * pUpdateOperation )
 {
-    _shadowOperation_t * pOperation = NULL;
-    AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
     const char * pClientToken = NULL;
     size_t clientTokenLength = 0;
 
@@ -919,62 +1720,26 @@ AwsIotShadowError_t AwsIotShadow_Update( IotMqttConnection_t mqttConnection,
         return AWS_IOT_SHADOW_BAD_PARAMETER;
     }
 
-    /* Allocate a new Shadow operation for UPDATE. */
-    if( _AwsIotShadow_CreateOperation( &pOperation,
-                                       _SHADOW_UPDATE,
-                                       flags,
-                                       pCallbackInfo ) != AWS_IOT_SHADOW_SUCCESS )
-    {
-        /* No memory for a new Shadow operation. */
-        return AWS_IOT_SHADOW_NO_MEMORY;
-    }
-
-    /* Check the members set by Shadow operation creation. */
-    AwsIotShadow_Assert( pOperation != NULL );
-    AwsIotShadow_Assert( pOperation->type == _SHADOW_UPDATE );
-    AwsIotShadow_Assert( pOperation->flags == flags );
-    AwsIotShadow_Assert( pOperation->status == AWS_IOT_SHADOW_STATUS_PENDING );
-
-    /* Allocate memory for the client token. */
-    pOperation->u.update.pClientToken = AwsIotShadow_MallocString( clientTokenLength );
-
-    if( pOperation->u.update.pClientToken == NULL )
-    {
-        IotLogError( "Failed to allocate memory for Shadow update client token." );
-        _AwsIotShadow_DestroyOperation( pOperation );
-
-        return AWS_IOT_SHADOW_NO_MEMORY;
-    }
-
-    /* Copy the client token. The client token must be copied in case the application
-     * frees the buffer containing it. */
-    ( void ) memcpy( ( void * ) pOperation->u.update.pClientToken,
-                     pClientToken,
-                     clientTokenLength );
-    pOperation->u.update.clientTokenLength = clientTokenLength;
-
-    /* Set the reference if provided. This must be done before the Shadow operation
-     * is processed. */
-    if( pUpdateOperation != NULL )
-    {
-        *pUpdateOperation = pOperation;
-    }
-
-    /* Process the Shadow operation. This subscribes to any required topics and
-     * sends the MQTT message for the Shadow operation. */
-    status = _AwsIotShadow_ProcessOperation( mqttConnection,
-                                             pUpdateInfo->pThingName,
-                                             pUpdateInfo->thingNameLength,
-                                             pOperation,
-                                             pUpdateInfo );
-
-    /* If the Shadow operation failed, clear the now invalid reference. */
-    if( ( status != AWS_IOT_SHADOW_STATUS_PENDING ) && ( pUpdateOperation != NULL ) )
+    /* Coalesced updates are merged and sent later. */
+    if( ( flags & AWS_IOT_SHADOW_FLAG_COALESCE ) == AWS_IOT_SHADOW_FLAG_COALESCE )
     {
-        *pUpdateOperation = AWS_IOT_SHADOW_OPERATION_INITIALIZER;
+        return _coalesceUpdate( mqttConnection,
+                                pUpdateInfo,
+                                pCallbackInfo,
+                                pClientToken,
+                                clientTokenLength );
     }
 
-    return status;
+    return _processUpdate( mqttConnection,
+                           pUpdateInfo,
+                           flags,
+                           pCallbackInfo,
+                           pUpdateOperation,
+                           pClientToken,
+                           clientTokenLength,
+                           1,
+                           NULL,
+                           0 );
 }
 
 /*-----------------------------------------------------------*/
@@ -1121,6 +1886,49 @@ AwsIotShadowError_t AwsIotShadow_SetUpdatedCallback( IotMqttConnection_t mqttCon
 
 /*-----------------------------------------------------------*/
 
+void AwsIotShadow_FlushCoalescedUpdates( IotMqttConnection_t mqttConnection )
+{
+    IotLink_t * pCoalescedUpdateLink = NULL;
+    _shadowCoalescedUpdate_t * pCoalescedUpdate = NULL;
+    bool sendNow = false;
+
+    IotMutex_Lock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+    /* Coalesced updates are never removed from the list before cleanup, so
+     * the list may be searched again after the mutex was released. */
+    while( ( pCoalescedUpdateLink = IotListDouble_FindFirstMatch( &( _AwsIotShadowCoalescedUpdates ),
+                                                                  NULL,
+                                                                  _coalescedUpdateConnectionMatch,
+                                                                  ( void * ) mqttConnection ) ) != NULL )
+    {
+        pCoalescedUpdate = IotLink_Container( _shadowCoalescedUpdate_t, pCoalescedUpdateLink, link );
+
+        /* Send the updates now if their job is still waiting for the coalesce
+         * window to end. Otherwise, wait for the job to send them. */
+        sendNow = ( pCoalescedUpdate->sendingConnection == IOT_MQTT_CONNECTION_INITIALIZER ) &&
+                  ( IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL,
+                                           pCoalescedUpdate->job,
+                                           NULL ) == IOT_TASKPOOL_SUCCESS );
+
+        IotMutex_Unlock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+
+        if( sendNow == true )
+        {
+            _sendCoalescedUpdate( IOT_SYSTEM_TASKPOOL, pCoalescedUpdate->job, pCoalescedUpdate );
+        }
+        else
+        {
+            IotClock_SleepMs( COALESCED_UPDATE_POLL_MS );
+        }
+
+        IotMutex_Lock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+    }
+
+    IotMutex_Unlock( &( _AwsIotShadowCoalescedUpdatesMutex ) );
+}
+
+/*-----------------------------------------------------------*/
+
 const char * AwsIotShadow_strerror( AwsIotShadowError_t status )
 {
     switch( status )
@@ -56,8 +56,8 @@ typedef struct _operationMatchParams
     _shadowOperationType_t type; /**< @brief DELETE, GET, or UPDATE. */
     const char * pThingName;     /**< @brief Thing Name of Shadow operation. */
     size_t thingNameLength;      /**< @brief Length of #_operationMatchParams_t.pThingName. */
-    const char * pDocument;      /**< @brief Shadow UPDATE response document. */
-    size_t documentLength;       /**< @brief Length of #_operationMatchParams_t.pDocument. */
+    const char * pClientToken;   /**< @brief Client token of Shadow UPDATE response. */
+    size_t clientTokenLength;    /**< @brief Length of #_operationMatchParams_t.pClientToken. */
 } _operationMatchParams_t;
 
 /*-----------------------------------------------------------*/
@@ -75,6 +75,22 @@ typedef struct _operationMatchParams
 static bool _shadowOperation_match( const IotLink_t * pOperationLink,
                                     void * pMatch );
 
+/**
+ * @brief Calculate the bucket of #_AwsIotShadowPendingUpdates for a Shadow
+ * UPDATE.
+ *
+ * @param[in] pThingName Thing Name of the Shadow UPDATE.
+ * @param[in] thingNameLength Length of `pThingName`.
+ * @param[in] pClientToken Client token of the Shadow UPDATE.
+ * @param[in] clientTokenLength Length of `pClientToken`.
+ *
+ * @return An index into #_AwsIotShadowPendingUpdates.
+ */
+static size_t _pendingUpdateBucket( const char * pThingName,
+                                    size_t thingNameLength,
+                                    const char * pClientToken,
+                                    size_t clientTokenLength );
+
 /**
  * @brief Common function for processing received Shadow responses.
  *
@@ -150,7 +166,18 @@ static void _updateCallback( void * pArgument,
 IotListDouble_t _AwsIotShadowPendingOperations = { 0 };
 
 /**
- * @brief Protects #_AwsIotShadowPendingOperations from concurrent access.
+ * @brief Shadow UPDATE operations awaiting a response from the Shadow service,
+ * hashed by Thing Name and client token.
+ *
+ * Shadow UPDATE responses are matched by client token, so keeping UPDATEs out
+ * of #_AwsIotShadowPendingOperations means an incoming response only needs to
+ * be compared against the few UPDATEs that share its bucket.
+ */
+IotListDouble_t _AwsIotShadowPendingUpdates[ AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS ] = { { 0 } };
+
+/**
+ * @brief Protects #_AwsIotShadowPendingOperations and #_AwsIotShadowPendingUpdates
+ * from concurrent access.
  */
 IotMutex_t _AwsIotShadowPendingOperationsMutex;
 
@@ -168,8 +195,6 @@ static bool _shadowOperation_match( const IotLink_t * pOperationLink,
                                                          link );
     _operationMatchParams_t * pParam = ( _operationMatchParams_t * ) pMatch;
     _shadowSubscription_t * pSubscription = pOperation->pSubscription;
-    const char * pClientToken = NULL;
-    size_t clientTokenLength = 0;
 
     /* Check for matching Thing Name and operation type. */
     bool match = ( pOperation->type == pParam->type ) &&
@@ -178,44 +203,49 @@ static bool _shadowOperation_match( const IotLink_t * pOperationLink,
                             pSubscription->pThingName,
                             pParam->thingNameLength ) == 0 );
 
-    /* For a Shadow UPDATE operation, compare the client tokens. */
+    /* For a Shadow UPDATE operation, compare the client tokens. The client
+     * token of the response was parsed once by the caller. */
     if( ( match == true ) && ( pOperation->type == _SHADOW_UPDATE ) )
     {
-        /* Check document pointers. */
-        AwsIotShadow_Assert( pParam->pDocument != NULL );
-        AwsIotShadow_Assert( pParam->documentLength > 0 );
+        /* Check client token pointers. */
+        AwsIotShadow_Assert( pParam->pClientToken != NULL );
         AwsIotShadow_Assert( pOperation->u.update.pClientToken != NULL );
         AwsIotShadow_Assert( pOperation->u.update.clientTokenLength > 0 );
 
-        IotLogDebug( "Verifying client tokens for Shadow UPDATE." );
+        match = ( pParam->clientTokenLength == pOperation->u.update.clientTokenLength ) &&
+                ( strncmp( pParam->pClientToken,
+                           pOperation->u.update.pClientToken,
+                           pParam->clientTokenLength ) == 0 );
+    }
 
-        /* Check for the client token in the UPDATE response document. */
-        match = IotJsonUtils_FindJsonValue( pParam->pDocument,
-                                            pParam->documentLength,
-                                            CLIENT_TOKEN_KEY,
-                                            CLIENT_TOKEN_KEY_LENGTH,
-                                            &pClientToken,
-                                            &clientTokenLength );
+    return match;
+}
 
-        /* If the UPDATE response document has a client token, check that it
-         * matches. */
-        if( match == true )
-        {
-            match = ( clientTokenLength == pOperation->u.update.clientTokenLength ) &&
-                    ( strncmp( pClientToken,
-                               pOperation->u.update.pClientToken,
-                               clientTokenLength ) == 0 );
-        }
-        else
-        {
-            IotLogWarn( "Received a Shadow UPDATE response with no client token. "
-                        "This is possibly a response to a bad JSON document:\n%.*s",
-                        pParam->documentLength,
-                        pParam->pDocument );
-        }
+/*-----------------------------------------------------------*/
+
+static size_t _pendingUpdateBucket( const char * pThingName,
+                                    size_t thingNameLength,
+                                    const char * pClientToken,
+                                    size_t clientTokenLength )
+{
+    size_t i = 0;
+
+    /* 32-bit FNV-1a hash of the Thing Name followed by the client token. */
+    uint32_t hash = 2166136261UL;
+
+    for( i = 0; i < thingNameLength; i++ )
+    {
+        hash ^= ( uint32_t ) ( uint8_t ) pThingName[ i ];
+        hash *= 16777619UL;
     }
 
-    return match;
+    for( i = 0; i < clientTokenLength; i++ )
+    {
+        hash ^= ( uint32_t ) ( uint8_t ) pClientToken[ i ];
+        hash *= 16777619UL;
+    }
+
+    return ( size_t ) ( hash % AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS );
 }
 
 /*-----------------------------------------------------------*/
@@ -224,41 +254,52 @@ static void _commonOperationCallback( _shadowOperationType_t type,
                                       IotMqttCallbackParam_t * pMessage )
 {
     _shadowOperation_t * pOperation = NULL;
-    IotLink_t * pOperationLink = NULL;
     _shadowOperationStatus_t status = _UNKNOWN_STATUS;
-    _operationMatchParams_t param = { .type = ( _shadowOperationType_t ) 0 };
+    const char * pThingName = NULL, * pClientToken = NULL;
+    size_t thingNameLength = 0, clientTokenLength = 0;
     uint32_t flags = 0;
 
-    /* Set operation type to search. */
-    param.type = type;
-
-    /* Set the response document for a Shadow UPDATE. */
-    if( type == _SHADOW_UPDATE )
-    {
-        param.pDocument = pMessage->u.message.info.pPayload;
-        param.documentLength = pMessage->u.message.info.payloadLength;
-    }
-
     /* Parse the Thing Name from the MQTT topic name. */
     if( _AwsIotShadow_ParseThingName( pMessage->u.message.info.pTopicName,
                                       pMessage->u.message.info.topicNameLength,
-                                      &( param.pThingName ),
-                                      &( param.thingNameLength ) ) != AWS_IOT_SHADOW_SUCCESS )
+                                      &pThingName,
+                                      &thingNameLength ) != AWS_IOT_SHADOW_SUCCESS )
     {
         return;
     }
 
+    /* Parse the client token of a Shadow UPDATE response. This is done once
+     * per response, outside of the pending operations lock. */
+    if( type == _SHADOW_UPDATE )
+    {
+        if( IotJsonUtils_FindJsonValue( pMessage->u.message.info.pPayload,
+                                        pMessage->u.message.info.payloadLength,
+                                        CLIENT_TOKEN_KEY,
+                                        CLIENT_TOKEN_KEY_LENGTH,
+                                        &pClientToken,
+                                        &clientTokenLength ) == false )
+        {
+            IotLogWarn( "Received a Shadow UPDATE response with no client token. "
+                        "This is possibly a response to a bad JSON document:\n%.*s",
+                        pMessage->u.message.info.payloadLength,
+                        pMessage->u.message.info.pPayload );
+
+            return;
+        }
+    }
+
     /* Lock the pending operations list for exclusive access. */
     IotMutex_Lock( &( _AwsIotShadowPendingOperationsMutex ) );
 
     /* Search for a matching pending operation. */
-    pOperationLink = IotListDouble_FindFirstMatch( &( _AwsIotShadowPendingOperations ),
-                                                   NULL,
-                                                   _shadowOperation_match,
-                                                   &param );
+    pOperation = _AwsIotShadow_FindPendingOperation( type,
+                                                     pThingName,
+                                                     thingNameLength,
+                                                     pClientToken,
+                                                     clientTokenLength );
 
     /* Find and remove the first Shadow operation of the given type. */
-    if( pOperationLink == NULL )
+    if( pOperation == NULL )
     {
         /* Operation is not pending. It may have already been processed. Return
          * without doing anything */
@@ -271,8 +312,6 @@ static void _commonOperationCallback( _shadowOperationType_t type,
     }
     else
     {
-        pOperation = IotLink_Container( _shadowOperation_t, pOperationLink, link );
-
         /* Remove a non-waitable operation from the pending operation list. */
         if( ( pOperation->flags & AWS_IOT_SHADOW_FLAG_WAITABLE ) == 0 )
         {
@@ -611,14 +650,15 @@ AwsIotShadowError_t _AwsIotShadow_ProcessOperation( IotMqttConnection_t mqttConn
                                                     const char * pThingName,
                                                     size_t thingNameLength,
                                                     _shadowOperation_t * pOperation,
-                                                    const AwsIotShadowDocumentInfo_t * pDocumentInfo )
+                                                    const AwsIotShadowDocumentInfo_t * pDocumentInfo,
+                                                    char * pTopicBuffer,
+                                                    uint16_t operationTopicLength )
 {
     _shadowSubscription_t * pSubscription = NULL;
     AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
     IotMqttError_t publishStatus = IOT_MQTT_STATUS_PENDING;
-    char * pTopicBuffer = NULL;
-    uint16_t operationTopicLength = 0;
-    bool freeTopicBuffer = true;
+    uint16_t subscriptionTopicLength = 0;
+    bool freeTopicBuffer = ( pTopicBuffer == NULL );
     IotMqttPublishInfo_t publishInfo = IOT_MQTT_PUBLISH_INFO_INITIALIZER;
 
     /* Lookup table for Shadow operation callbacks. */
@@ -637,12 +677,13 @@ AwsIotShadowError_t _AwsIotShadow_ProcessOperation( IotMqttConnection_t mqttConn
     /* Set the operation's MQTT connection. */
     pOperation->mqttConnection = mqttConnection;
 
-    /* Generate the operation topic buffer. */
-    if( _AwsIotShadow_GenerateShadowTopic( pOperation->type,
-                                           pThingName,
-                                           thingNameLength,
-                                           &pTopicBuffer,
-                                           &operationTopicLength ) != AWS_IOT_SHADOW_SUCCESS )
+    /* Generate the operation topic buffer if the caller did not provide one. */
+    if( ( freeTopicBuffer == true ) &&
+        ( _AwsIotShadow_GenerateShadowTopic( pOperation->type,
+                                             pThingName,
+                                             thingNameLength,
+                                             &pTopicBuffer,
+                                             &operationTopicLength ) != AWS_IOT_SHADOW_SUCCESS ) )
     {
         IotLogError( "No memory for Shadow operation topic buffer." );
 
@@ -682,26 +723,42 @@ AwsIotShadowError_t _AwsIotShadow_ProcessOperation( IotMqttConnection_t mqttConn
          * the subscription has no topic buffer. */
         if( pSubscription->pTopicBuffer == NULL )
         {
-            pSubscription->pTopicBuffer = pTopicBuffer;
+            if( freeTopicBuffer == true )
+            {
+                pSubscription->pTopicBuffer = pTopicBuffer;
 
-            /* This function should not free the topic buffer. */
-            freeTopicBuffer = false;
+                /* This function should not free the topic buffer. */
+                freeTopicBuffer = false;
+            }
+            /* A topic buffer provided by the caller remains owned by the caller,
+             * so the subscription needs its own. */
+            else if( _AwsIotShadow_GenerateShadowTopic( pOperation->type,
+                                                        pThingName,
+                                                        thingNameLength,
+                                                        &( pSubscription->pTopicBuffer ),
+                                                        &subscriptionTopicLength ) != AWS_IOT_SHADOW_SUCCESS )
+            {
+                status = AWS_IOT_SHADOW_NO_MEMORY;
+            }
         }
+    }
 
+    if( status == AWS_IOT_SHADOW_STATUS_PENDING )
+    {
         /* Increment the reference count for this Shadow operation's
          * subscriptions. */
         status = _AwsIotShadow_IncrementReferences( pOperation,
                                                     pTopicBuffer,
                                                     operationTopicLength,
                                                     shadowCallbacks[ pOperation->type ] );
+    }
 
-        if( status != AWS_IOT_SHADOW_STATUS_PENDING )
-        {
-            /* Failed to add subscriptions for a Shadow operation. The reference
-             * count was not incremented. Check if this subscription should be
-             * deleted. */
-            _AwsIotShadow_RemoveSubscription( pSubscription, NULL );
-        }
+    if( ( status != AWS_IOT_SHADOW_STATUS_PENDING ) && ( pSubscription != NULL ) )
+    {
+        /* Failed to add subscriptions for a Shadow operation. The reference
+         * count was not incremented. Check if this subscription should be
+         * deleted. */
+        _AwsIotShadow_RemoveSubscription( pSubscription, NULL );
     }
 
     /* Unlock the Shadow subscription list mutex. */
@@ -749,10 +806,9 @@ AwsIotShadowError_t _AwsIotShadow_ProcessOperation( IotMqttConnection_t mqttConn
             publishInfo.payloadLength = 0;
         }
 
-        /* Add Shadow operation to the pending operations list. */
+        /* Add Shadow operation to the pending operations. */
         IotMutex_Lock( &( _AwsIotShadowPendingOperationsMutex ) );
-        IotListDouble_InsertHead( &( _AwsIotShadowPendingOperations ),
-                                  &( pOperation->link ) );
+        _AwsIotShadow_AddPendingOperation( pOperation );
         IotMutex_Unlock( &( _AwsIotShadowPendingOperationsMutex ) );
 
         /* Publish to the Shadow topic name. */
@@ -821,6 +877,74 @@ AwsIotShadowError_t _AwsIotShadow_ProcessOperation( IotMqttConnection_t mqttConn
 
 /*-----------------------------------------------------------*/
 
+void _AwsIotShadow_AddPendingOperation( _shadowOperation_t * pOperation )
+{
+    size_t bucket = 0;
+
+    AwsIotShadow_Assert( pOperation->pSubscription != NULL );
+
+    if( pOperation->type == _SHADOW_UPDATE )
+    {
+        bucket = _pendingUpdateBucket( pOperation->pSubscription->pThingName,
+                                       pOperation->pSubscription->thingNameLength,
+                                       pOperation->u.update.pClientToken,
+                                       pOperation->u.update.clientTokenLength );
+
+        IotListDouble_InsertHead( &( _AwsIotShadowPendingUpdates[ bucket ] ),
+                                  &( pOperation->link ) );
+    }
+    else
+    {
+        IotListDouble_InsertHead( &( _AwsIotShadowPendingOperations ),
+                                  &( pOperation->link ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+_shadowOperation_t * _AwsIotShadow_FindPendingOperation( _shadowOperationType_t type,
+                                                         const char * pThingName,
+                                                         size_t thingNameLength,
+                                                         const char * pClientToken,
+                                                         size_t clientTokenLength )
+{
+    _shadowOperation_t * pOperation = NULL;
+    IotListDouble_t * pList = &( _AwsIotShadowPendingOperations );
+    IotLink_t * pOperationLink = NULL;
+    _operationMatchParams_t param = { .type = ( _shadowOperationType_t ) 0 };
+
+    param.type = type;
+    param.pThingName = pThingName;
+    param.thingNameLength = thingNameLength;
+
+    /* Shadow UPDATEs are only searched for in the bucket selected by their
+     * Thing Name and client token. */
+    if( type == _SHADOW_UPDATE )
+    {
+        param.pClientToken = pClientToken;
+        param.clientTokenLength = clientTokenLength;
+
+        pList = &( _AwsIotShadowPendingUpdates[ _pendingUpdateBucket( pThingName,
+                                                                      thingNameLength,
+                                                                      pClientToken,
+                                                                      clientTokenLength ) ] );
+    }
+
+    pOperationLink = IotListDouble_FindFirstMatch( pList,
+                                                   NULL,
+                                                   _shadowOperation_match,
+                                                   &param );
+
+    if( pOperationLink != NULL )
+    {
+        pOperation = IotLink_Container( _shadowOperation_t, pOperationLink, link );
+    }
+
+    return pOperation;
+}
+
+/*-----------------------------------------------------------*/
+
 void _AwsIotShadow_Notify( _shadowOperation_t * pOperation )
 {
     AwsIotShadowCallbackParam_t callbackParam = { .callbackType = ( AwsIotShadowCallbackType_t ) 0 };
@@ -860,6 +984,7 @@ void _AwsIotShadow_Notify( _shadowOperation_t * pOperation )
         callbackParam.mqttConnection = pOperation->mqttConnection;
         callbackParam.u.operation.result = pOperation->status;
         callbackParam.u.operation.reference = pOperation;
+        callbackParam.u.operation.mergedCount = 0;
         callbackParam.pThingName = pSubscription->pThingName;
         callbackParam.thingNameLength = pSubscription->thingNameLength;
 
@@ -869,6 +994,10 @@ void _AwsIotShadow_Notify( _shadowOperation_t * pOperation )
             callbackParam.u.operation.get.pDocument = pOperation->u.get.pDocument;
             callbackParam.u.operation.get.documentLength = pOperation->u.get.documentLength;
         }
+        else if( pOperation->type == _SHADOW_UPDATE )
+        {
+            callbackParam.u.operation.mergedCount = pOperation->u.update.mergedCount;
+        }
 
         pOperation->notify.callback.function( pOperation->notify.callback.pCallbackContext,
                                               &callbackParam );
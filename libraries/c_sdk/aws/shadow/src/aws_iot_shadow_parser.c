@@ -32,6 +32,7 @@
 #include "iot_config.h"
 
 /* Standard includes. */
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -74,6 +75,17 @@
         SHADOW_ACCEPTED_SUFFIX_LENGTH :                                 \
         SHADOW_REJECTED_SUFFIX_LENGTH ) )
 
+/**
+ * @brief A member of a JSON object.
+ */
+typedef struct _jsonMember
+{
+    const char * pKey;    /**< @brief The member's key, without quotes. */
+    size_t keyLength;     /**< @brief Length of #_jsonMember_t.pKey. */
+    const char * pMember; /**< @brief The member's key and value, starting at the opening quote of the key. */
+    size_t memberLength;  /**< @brief Length of #_jsonMember_t.pMember. */
+} _jsonMember_t;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -86,6 +98,179 @@
  */
 static AwsIotShadowError_t _codeToShadowStatus( uint32_t code );
 
+/**
+ * @brief Check if a character is JSON whitespace.
+ *
+ * @param[in] character The character to check.
+ *
+ * @return `true` if `character` is whitespace; `false` otherwise.
+ */
+static bool _isWhitespace( char character );
+
+/**
+ * @brief Read the next member of a JSON object.
+ *
+ * @param[in] pObject A JSON object that starts with `{` and ends with `}`.
+ * @param[in] objectLength The length of `pObject`.
+ * @param[in,out] pOffset Where to start reading; `1` for the first member. Set
+ * to the end of the member that was read.
+ * @param[out] pMember Set to the member that was read.
+ *
+ * @return `true` if a member was read; `false` otherwise. When `false` is
+ * returned, `pOffset` is the offset of the closing brace if `pObject` is a
+ * valid JSON object.
+ */
+static bool _nextMember( const char * pObject,
+                         size_t objectLength,
+                         size_t * pOffset,
+                         _jsonMember_t * pMember );
+
+/**
+ * @brief Append a member to a merged JSON object.
+ *
+ * @param[out] pMerged The merged JSON object; may be `NULL` to only calculate
+ * its length.
+ * @param[in] mergedLength The current length of `pMerged`.
+ * @param[in] memberCount The number of members already in `pMerged`.
+ * @param[in] pMember The member to append.
+ *
+ * @return The length of `pMerged` after appending the member.
+ */
+static size_t _appendMember( char * pMerged,
+                             size_t mergedLength,
+                             size_t memberCount,
+                             const _jsonMember_t * pMember );
+
+/*-----------------------------------------------------------*/
+
+static bool _isWhitespace( char character )
+{
+    return ( character == ' ' ) || ( character == '\n' ) ||
+           ( character == '\r' ) || ( character == '\t' );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _nextMember( const char * pObject,
+                         size_t objectLength,
+                         size_t * pOffset,
+                         _jsonMember_t * pMember )
+{
+    size_t i = *pOffset, keyEnd = 0, keyLength = 0;
+    const char * pValue = NULL;
+    size_t valueLength = 0;
+    bool firstMember = ( *pOffset == 1 );
+
+    /* Skip the separator between this member and the previous one. */
+    while( ( i < objectLength - 1 ) && ( _isWhitespace( pObject[ i ] ) == true ) )
+    {
+        i++;
+    }
+
+    /* Members after the first must follow a comma. The offset is left at the
+     * comma if no member follows it, so that the object is invalid. */
+    if( ( firstMember == false ) && ( pObject[ i ] == ',' ) )
+    {
+        *pOffset = i;
+        i++;
+
+        while( ( i < objectLength - 1 ) && ( _isWhitespace( pObject[ i ] ) == true ) )
+        {
+            i++;
+        }
+    }
+    else
+    {
+        *pOffset = i;
+    }
+
+    /* A member starts with the opening quote of its key. */
+    if( ( i >= objectLength - 1 ) || ( pObject[ i ] != '\"' ) )
+    {
+        return false;
+    }
+
+    /* A member after the first must follow a comma. */
+    if( ( firstMember == false ) && ( pObject[ *pOffset ] != ',' ) )
+    {
+        return false;
+    }
+
+    /* Find the closing quote of the key. */
+    for( keyEnd = i + 1; keyEnd < objectLength - 1; keyEnd++ )
+    {
+        if( ( pObject[ keyEnd ] == '\"' ) && ( pObject[ keyEnd - 1 ] != '\\' ) )
+        {
+            break;
+        }
+    }
+
+    if( ( keyEnd >= objectLength - 1 ) || ( keyEnd == i + 1 ) )
+    {
+        return false;
+    }
+
+    keyLength = keyEnd - i - 1;
+
+    /* Calculate the length of the value. The search starts at the separator
+     * before the key so that the remaining document is long enough to hold
+     * the key and a value. */
+    if( IotJsonUtils_FindJsonValue( pObject + i - 1,
+                                    objectLength - i + 1,
+                                    pObject + i + 1,
+                                    keyLength,
+                                    &pValue,
+                                    &valueLength ) == false )
+    {
+        return false;
+    }
+
+    /* The value found must belong to this key, i.e. only whitespace and a
+     * colon may separate them. */
+    for( keyEnd = keyEnd + 1; pObject + keyEnd < pValue; keyEnd++ )
+    {
+        if( ( pObject[ keyEnd ] != ':' ) && ( _isWhitespace( pObject[ keyEnd ] ) == false ) )
+        {
+            return false;
+        }
+    }
+
+    pMember->pKey = pObject + i + 1;
+    pMember->keyLength = keyLength;
+    pMember->pMember = pObject + i;
+    pMember->memberLength = ( size_t ) ( pValue - pObject ) + valueLength - i;
+
+    *pOffset = ( size_t ) ( pValue - pObject ) + valueLength;
+
+    return true;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t _appendMember( char * pMerged,
+                             size_t mergedLength,
+                             size_t memberCount,
+                             const _jsonMember_t * pMember )
+{
+    /* Members after the first are separated by a comma. */
+    if( memberCount > 0 )
+    {
+        if( pMerged != NULL )
+        {
+            pMerged[ mergedLength ] = ',';
+        }
+
+        mergedLength++;
+    }
+
+    if( pMerged != NULL )
+    {
+        ( void ) memcpy( pMerged + mergedLength, pMember->pMember, pMember->memberLength );
+    }
+
+    return mergedLength + pMember->memberLength;
+}
+
 /*-----------------------------------------------------------*/
 
 static AwsIotShadowError_t _codeToShadowStatus( uint32_t code )
@@ -295,3 +480,76 @@ AwsIotShadowError_t _AwsIotShadow_ParseThingName( const char * pTopicName,
 }
 
 /*-----------------------------------------------------------*/
+
+AwsIotShadowError_t _AwsIotShadow_MergeReportedState( const char * pReported,
+                                                      size_t reportedLength,
+                                                      const char * pPatch,
+                                                      size_t patchLength,
+                                                      char * pMerged,
+                                                      size_t * pMergedLength )
+{
+    size_t reportedOffset = 1, patchOffset = 1, searchOffset = 1;
+    size_t mergedLength = 1, memberCount = 0;
+    _jsonMember_t member = { 0 }, patchMember = { 0 };
+    bool replaced = false;
+
+    /* Both states must be JSON objects. */
+    if( ( reportedLength < 2 ) || ( pReported[ 0 ] != '{' ) || ( pReported[ reportedLength - 1 ] != '}' ) ||
+        ( patchLength < 2 ) || ( pPatch[ 0 ] != '{' ) || ( pPatch[ patchLength - 1 ] != '}' ) )
+    {
+        return AWS_IOT_SHADOW_BAD_PARAMETER;
+    }
+
+    if( pMerged != NULL )
+    {
+        pMerged[ 0 ] = '{';
+    }
+
+    /* Copy the members of the current reported state that are not replaced
+     * by the patch. */
+    while( _nextMember( pReported, reportedLength, &reportedOffset, &member ) == true )
+    {
+        replaced = false;
+        searchOffset = 1;
+
+        while( _nextMember( pPatch, patchLength, &searchOffset, &patchMember ) == true )
+        {
+            if( ( patchMember.keyLength == member.keyLength ) &&
+                ( strncmp( patchMember.pKey, member.pKey, member.keyLength ) == 0 ) )
+            {
+                replaced = true;
+                break;
+            }
+        }
+
+        if( replaced == false )
+        {
+            mergedLength = _appendMember( pMerged, mergedLength, memberCount, &member );
+            memberCount++;
+        }
+    }
+
+    /* Copy all members of the patch. */
+    while( _nextMember( pPatch, patchLength, &patchOffset, &member ) == true )
+    {
+        mergedLength = _appendMember( pMerged, mergedLength, memberCount, &member );
+        memberCount++;
+    }
+
+    /* Members are read until the closing brace of a valid object. */
+    if( ( reportedOffset != reportedLength - 1 ) || ( patchOffset != patchLength - 1 ) )
+    {
+        return AWS_IOT_SHADOW_BAD_PARAMETER;
+    }
+
+    if( pMerged != NULL )
+    {
+        pMerged[ mergedLength ] = '}';
+    }
+
+    *pMergedLength = mergedLength + 1;
+
+    return AWS_IOT_SHADOW_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
@@ -76,7 +76,16 @@
  * the constant #MAX_THING_NAME_LENGTH is used for the length of
  * #_shadowSubscription_t.pThingName.
  */
-    #define SHADOW_SUBSCRIPTION_SIZE    ( sizeof( _shadowSubscription_t ) + MAX_THING_NAME_LENGTH )
+    #define SHADOW_SUBSCRIPTION_SIZE       ( sizeof( _shadowSubscription_t ) + MAX_THING_NAME_LENGTH )
+
+/**
+ * @brief The size of a static memory Shadow coalesced update.
+ *
+ * Since the pThingName member of #_shadowCoalescedUpdate_t is variable-length,
+ * the constant #MAX_THING_NAME_LENGTH is used for the length of
+ * #_shadowCoalescedUpdate_t.pThingName.
+ */
+    #define SHADOW_COALESCED_UPDATE_SIZE    ( sizeof( _shadowCoalescedUpdate_t ) + MAX_THING_NAME_LENGTH )
 
 /*-----------------------------------------------------------*/
 
@@ -89,6 +98,9 @@
     static bool _pInUseShadowSubscriptions[ AWS_IOT_SHADOW_SUBSCRIPTIONS ] = { 0 };                                    /**< @brief Shadow subscription in-use flags. */
     static char _pShadowSubscriptions[ AWS_IOT_SHADOW_SUBSCRIPTIONS ][ SHADOW_SUBSCRIPTION_SIZE ] = { { 0 } };         /**< @brief Shadow subscriptions. */
 
+    static bool _pInUseShadowCoalescedUpdates[ AWS_IOT_SHADOW_SUBSCRIPTIONS ] = { 0 };                                         /**< @brief Shadow coalesced update in-use flags. */
+    static char _pShadowCoalescedUpdates[ AWS_IOT_SHADOW_SUBSCRIPTIONS ][ SHADOW_COALESCED_UPDATE_SIZE ] = { { 0 } };           /**< @brief Shadow coalesced updates. */
+
 /*-----------------------------------------------------------*/
 
     void * AwsIotShadow_MallocOperation( size_t size )
@@ -158,6 +170,41 @@
                                      SHADOW_SUBSCRIPTION_SIZE );
     }
 
+/*-----------------------------------------------------------*/
+
+    void * AwsIotShadow_MallocCoalescedUpdate( size_t size )
+    {
+        int32_t freeIndex = -1;
+        void * pNewCoalescedUpdate = NULL;
+
+        if( size <= SHADOW_COALESCED_UPDATE_SIZE )
+        {
+            /* Get the index of a free Shadow coalesced update. Coalesced
+             * updates are kept per Thing, like subscriptions. */
+            freeIndex = IotStaticMemory_FindFree( _pInUseShadowCoalescedUpdates,
+                                                  AWS_IOT_SHADOW_SUBSCRIPTIONS );
+
+            if( freeIndex != -1 )
+            {
+                pNewCoalescedUpdate = &( _pShadowCoalescedUpdates[ freeIndex ][ 0 ] );
+            }
+        }
+
+        return pNewCoalescedUpdate;
+    }
+
+/*-----------------------------------------------------------*/
+
+    void AwsIotShadow_FreeCoalescedUpdate( void * ptr )
+    {
+        /* Return the in-use Shadow coalesced update. */
+        IotStaticMemory_ReturnInUse( ptr,
+                                     _pShadowCoalescedUpdates,
+                                     _pInUseShadowCoalescedUpdates,
+                                     AWS_IOT_SHADOW_SUBSCRIPTIONS,
+                                     SHADOW_COALESCED_UPDATE_SIZE );
+    }
+
 /*-----------------------------------------------------------*/
 
 #endif /* if IOT_STATIC_MEMORY_ONLY == 1 */
@@ -124,6 +124,20 @@
  * (http://pubs.opengroup.org/onlinepubs/9699919799/functions/free.html).
  */
     void AwsIotShadow_FreeSubscription( void * ptr );
+
+/**
+ * @brief Allocate a #_shadowCoalescedUpdate_t. This function should have the
+ * same signature as [malloc]
+ * (http://pubs.opengroup.org/onlinepubs/9699919799/functions/malloc.html).
+ */
+    void * AwsIotShadow_MallocCoalescedUpdate( size_t size );
+
+/**
+ * @brief Free a #_shadowCoalescedUpdate_t. This function should have the same
+ * signature as [free]
+ * (http://pubs.opengroup.org/onlinepubs/9699919799/functions/free.html).
+ */
+    void AwsIotShadow_FreeCoalescedUpdate( void * ptr );
 #else /* if IOT_STATIC_MEMORY_ONLY == 1 */
     #include <stdlib.h>
 
@@ -150,6 +164,14 @@
     #ifndef AwsIotShadow_FreeSubscription
         #define AwsIotShadow_FreeSubscription    free
     #endif
+
+    #ifndef AwsIotShadow_MallocCoalescedUpdate
+        #define AwsIotShadow_MallocCoalescedUpdate    malloc
+    #endif
+
+    #ifndef AwsIotShadow_FreeCoalescedUpdate
+        #define AwsIotShadow_FreeCoalescedUpdate    free
+    #endif
 #endif /* if IOT_STATIC_MEMORY_ONLY == 1 */
 
 /**
@@ -161,6 +183,12 @@
 #ifndef AWS_IOT_SHADOW_DEFAULT_MQTT_TIMEOUT_MS
     #define AWS_IOT_SHADOW_DEFAULT_MQTT_TIMEOUT_MS    ( 5000 )
 #endif
+#ifndef AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS
+    #define AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS     ( 16 )
+#endif
+#ifndef AWS_IOT_SHADOW_COALESCE_WINDOW_MS
+    #define AWS_IOT_SHADOW_COALESCE_WINDOW_MS         ( 1000 )
+#endif
 /** @endcond */
 
 /**
@@ -280,6 +308,26 @@
  */
 #define CLIENT_TOKEN_KEY_LENGTH                  ( sizeof( CLIENT_TOKEN_KEY ) - 1 )
 
+/**
+ * @brief The JSON key of the state object in a Shadow update document.
+ */
+#define STATE_KEY                                "state"
+
+/**
+ * @brief The length of #STATE_KEY.
+ */
+#define STATE_KEY_LENGTH                         ( sizeof( STATE_KEY ) - 1 )
+
+/**
+ * @brief The JSON key of the reported state in a Shadow update document.
+ */
+#define REPORTED_KEY                             "reported"
+
+/**
+ * @brief The length of #REPORTED_KEY.
+ */
+#define REPORTED_KEY_LENGTH                      ( sizeof( REPORTED_KEY ) - 1 )
+
 /**
  * @brief The longest client token accepted by the Shadow service, per AWS IoT
  * service limits.
@@ -399,6 +447,7 @@ typedef struct _shadowOperation
         {
             const char * pClientToken; /**< @brief Client token in update document. */
             size_t clientTokenLength;  /**< @brief Length of client token. */
+            uint32_t mergedCount;      /**< @brief Number of Shadow updates merged into this update. */
         } update;
     } u;                               /**< @brief Valid member depends on _shadowOperation_t.type. */
 
@@ -434,6 +483,39 @@ typedef struct _shadowSubscription
     char pThingName[];      /**< @brief Thing Name associated with this subscriptions object. */
 } _shadowSubscription_t;
 
+/**
+ * @brief Holds the Shadow updates of a Thing passed with
+ * #AWS_IOT_SHADOW_FLAG_COALESCE until they are sent as one Shadow UPDATE.
+ *
+ * These structures are stored in a list. One is created for each Thing the
+ * first time its updates are coalesced and kept until the Shadow library is
+ * cleaned up, so that the Thing's UPDATE topic is only generated once.
+ */
+typedef struct _shadowCoalescedUpdate
+{
+    IotLink_t link;                        /**< @brief List link member. */
+
+    IotMqttConnection_t mqttConnection;    /**< @brief MQTT connection of the most recent update. */
+    AwsIotShadowDocumentInfo_t updateInfo; /**< @brief QoS and retry settings of the most recent update. */
+    AwsIotShadowCallbackInfo_t callback;   /**< @brief Callback of the most recent update. */
+
+    char * pReported;                      /**< @brief Merged `reported` state, as a JSON object. */
+    size_t reportedLength;                 /**< @brief Length of #_shadowCoalescedUpdate_t.pReported. */
+    char pClientToken[ MAX_CLIENT_TOKEN_LENGTH ]; /**< @brief Client token of the most recent update, with quotes. */
+    size_t clientTokenLength;              /**< @brief Length of #_shadowCoalescedUpdate_t.pClientToken. */
+    uint32_t mergedCount;                  /**< @brief Number of updates merged; 0 when none are waiting to be sent. */
+    IotMqttConnection_t sendingConnection; /**< @brief MQTT connection of the updates being sent; #IOT_MQTT_CONNECTION_INITIALIZER when none are. */
+
+    char * pTopicBuffer;                   /**< @brief The Thing's Shadow UPDATE topic. */
+    uint16_t topicLength;                  /**< @brief Length of the UPDATE topic in #_shadowCoalescedUpdate_t.pTopicBuffer. */
+
+    IotTaskPoolJobStorage_t jobStorage;    /**< @brief Storage for the job that sends the merged update. */
+    IotTaskPoolJob_t job;                  /**< @brief Job that sends the merged update. */
+
+    size_t thingNameLength;                /**< @brief Length of Thing Name. */
+    char pThingName[];                     /**< @brief Thing Name of the coalesced updates. */
+} _shadowCoalescedUpdate_t;
+
 /* Declarations of names printed in logs. */
 #if LIBRARY_LOG_LEVEL > IOT_LOG_NONE
     extern const char * const _pAwsIotShadowOperationNames[];
@@ -443,9 +525,13 @@ typedef struct _shadowSubscription
 /* Declarations of variables for internal Shadow files. */
 extern uint32_t _AwsIotShadowMqttTimeoutMs;
 extern IotListDouble_t _AwsIotShadowPendingOperations;
+extern IotListDouble_t _AwsIotShadowPendingUpdates[ AWS_IOT_SHADOW_PENDING_UPDATE_BUCKETS ];
 extern IotListDouble_t _AwsIotShadowSubscriptions;
 extern IotMutex_t _AwsIotShadowPendingOperationsMutex;
 extern IotMutex_t _AwsIotShadowSubscriptionsMutex;
+extern uint32_t _AwsIotShadowCoalesceWindowMs;
+extern IotListDouble_t _AwsIotShadowCoalescedUpdates;
+extern IotMutex_t _AwsIotShadowCoalescedUpdatesMutex;
 
 /*----------------------- Shadow operation functions ------------------------*/
 
@@ -508,6 +594,11 @@ AwsIotShadowError_t _AwsIotShadow_GenerateShadowTopic( _shadowOperationType_t ty
  * @param[in] pOperation Operation data to process.
  * @param[in] pDocumentInfo Information on the Shadow document for GET or UPDATE
  * operations.
+ * @param[in] pTopicBuffer A buffer generated by #_AwsIotShadow_GenerateShadowTopic
+ * for this operation. Optional; pass `NULL` to generate a new topic. A provided
+ * buffer remains owned by the caller.
+ * @param[in] operationTopicLength Length of the operation topic in `pTopicBuffer`.
+ * Ignored if `pTopicBuffer` is `NULL`.
  *
  * @return #AWS_IOT_SHADOW_STATUS_PENDING on success. On error, one of
  * #AWS_IOT_SHADOW_NO_MEMORY or #AWS_IOT_SHADOW_MQTT_ERROR.
@@ -516,7 +607,44 @@ AwsIotShadowError_t _AwsIotShadow_ProcessOperation( IotMqttConnection_t mqttConn
                                                     const char * pThingName,
                                                     size_t thingNameLength,
                                                     _shadowOperation_t * pOperation,
-                                                    const AwsIotShadowDocumentInfo_t * pDocumentInfo );
+                                                    const AwsIotShadowDocumentInfo_t * pDocumentInfo,
+                                                    char * pTopicBuffer,
+                                                    uint16_t operationTopicLength );
+
+/**
+ * @brief Add a Shadow operation to the pending operations.
+ *
+ * Shadow UPDATE operations are placed in the bucket of
+ * #_AwsIotShadowPendingUpdates selected by their Thing Name and client token;
+ * all other operations are placed in #_AwsIotShadowPendingOperations.
+ *
+ * @param[in] pOperation The operation to add. Its subscription object must be
+ * set.
+ *
+ * @note This function should be called with the pending operations mutex locked.
+ */
+void _AwsIotShadow_AddPendingOperation( _shadowOperation_t * pOperation );
+
+/**
+ * @brief Find a pending Shadow operation that matches a received response.
+ *
+ * @param[in] type DELETE, GET, or UPDATE.
+ * @param[in] pThingName Thing Name parsed from the response topic.
+ * @param[in] thingNameLength Length of `pThingName`.
+ * @param[in] pClientToken Client token parsed from the response document. Only
+ * used for Shadow UPDATE; ignored otherwise.
+ * @param[in] clientTokenLength Length of `pClientToken`.
+ *
+ * @return The matching operation, or `NULL` if none is pending. The operation
+ * is not removed from its list.
+ *
+ * @note This function should be called with the pending operations mutex locked.
+ */
+_shadowOperation_t * _AwsIotShadow_FindPendingOperation( _shadowOperationType_t type,
+                                                         const char * pThingName,
+                                                         size_t thingNameLength,
+                                                         const char * pClientToken,
+                                                         size_t clientTokenLength );
 
 /**
  * @brief Notify of a completed Shadow operation.
@@ -660,4 +788,32 @@ AwsIotShadowError_t _AwsIotShadow_ParseThingName( const char * pTopicName,
 AwsIotShadowError_t _AwsIotShadow_ParseErrorDocument( const char * pErrorDocument,
                                                       size_t errorDocumentLength );
 
+/**
+ * @brief Merge the members of two `reported` state objects.
+ *
+ * Members of `pPatch` replace members of `pReported` with the same key; all
+ * other members of both objects are kept.
+ *
+ * @param[in] pReported The current reported state, as a JSON object.
+ * @param[in] reportedLength The length of `pReported`.
+ * @param[in] pPatch The reported state to merge, as a JSON object.
+ * @param[in] patchLength The length of `pPatch`.
+ * @param[out] pMerged Buffer for the merged JSON object. Optional; pass `NULL`
+ * to only calculate the merged length.
+ * @param[out] pMergedLength Set to the length of the merged JSON object.
+ *
+ * @warning This function does not check the length of `pMerged`! Any provided
+ * buffer must be at least as large as the length calculated with `pMerged` set
+ * to `NULL`.
+ *
+ * @return #AWS_IOT_SHADOW_SUCCESS or #AWS_IOT_SHADOW_BAD_PARAMETER if either
+ * object is not a valid JSON object.
+ */
+AwsIotShadowError_t _AwsIotShadow_MergeReportedState( const char * pReported,
+                                                      size_t reportedLength,
+                                                      const char * pPatch,
+                                                      size_t patchLength,
+                                                      char * pMerged,
+                                                      size_t * pMergedLength );
+
 #endif /* ifndef AWS_IOT_SHADOW_INTERNAL_H_ */
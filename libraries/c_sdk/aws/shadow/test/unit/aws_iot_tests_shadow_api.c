@@ -33,6 +33,7 @@
 
 /* Standard includes. */
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 
 /* SDK initialization include. */
@@ -56,6 +57,9 @@
 #include "platform/iot_clock.h"
 #include "platform/iot_threads.h"
 
+/* JSON utilities include. */
+#include "iot_json_utils.h"
+
 /* Test framework includes. */
 #include "unity_fixture.h"
 
@@ -110,6 +114,67 @@
  */
 #define ACKNOWLEDGEMENT_PACKET_SIZE    ( 5 )
 
+/**
+ * @brief The largest number of pending Shadow UPDATEs used in the pending
+ * UPDATE lookup benchmark.
+ */
+#define PENDING_UPDATE_MAX_COUNT       ( 256 )
+
+/**
+ * @brief The number of times each pending Shadow UPDATE is looked up in the
+ * pending UPDATE lookup benchmark.
+ */
+#define PENDING_UPDATE_ITERATIONS      ( 50 )
+
+/**
+ * @brief Size of the buffer holding each client token in the pending UPDATE
+ * lookup benchmark.
+ */
+#define PENDING_UPDATE_TOKEN_SIZE      ( 16 )
+
+/**
+ * @brief The Shadow UPDATE response document used in the pending UPDATE lookup
+ * benchmark. The client token is appended to this prefix.
+ */
+#define PENDING_UPDATE_RESPONSE                                                  \
+    "{\"state\":{\"reported\":{\"temperature\":22,\"humidity\":41}},"            \
+    "\"metadata\":{\"reported\":{\"temperature\":{\"timestamp\":1571000000},"    \
+    "\"humidity\":{\"timestamp\":1571000000}}},\"version\":12,"                 \
+    "\"timestamp\":1571000000,\"clientToken\":"
+
+/**
+ * @brief The length of #PENDING_UPDATE_RESPONSE.
+ */
+#define PENDING_UPDATE_RESPONSE_LENGTH    ( sizeof( PENDING_UPDATE_RESPONSE ) - 1 )
+
+/**
+ * @brief The coalesce window used in the coalesced UPDATE test.
+ */
+#define COALESCE_WINDOW_MS                ( 100 )
+
+/**
+ * @brief The number of Shadow UPDATEs sent in the coalesced UPDATE test.
+ */
+#define COALESCED_UPDATE_COUNT            ( 4 )
+
+/**
+ * @brief The document expected to be published for the coalesced UPDATE test.
+ */
+#define COALESCED_UPDATE_DOCUMENT                                                   \
+    "{\"state\":{\"reported\":{\"humidity\":40,\"pressure\":1013,\"temperature\":23}}," \
+    "\"clientToken\":\"token-4\"}"
+
+/**
+ * @brief The coalesce window used by the tests that end it early. It is long
+ * enough to never end during those tests by itself.
+ */
+#define LONG_COALESCE_WINDOW_MS           ( 10 * COALESCE_WINDOW_MS )
+
+/**
+ * @brief Size of the buffer that holds the payload of the last PUBLISH sent.
+ */
+#define LAST_PUBLISH_PAYLOAD_SIZE         ( 256 )
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -156,6 +221,21 @@ static uint8_t _lastPacketType = 0;
  */
 static uint16_t _lastPacketIdentifier = 0;
 
+/**
+ * @brief The number of QoS 1 PUBLISH packets sent by the send thread.
+ */
+static uint32_t _publishCount = 0;
+
+/**
+ * @brief The payload of the last QoS 1 PUBLISH sent by the send thread.
+ */
+static char _pLastPublishPayload[ LAST_PUBLISH_PAYLOAD_SIZE ] = { 0 };
+
+/**
+ * @brief The length of #_pLastPublishPayload.
+ */
+static size_t _lastPublishPayloadLength = 0;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -305,6 +385,14 @@ static size_t _sendSuccess( void * pSendContext,
 
             status = _IotMqtt_DeserializePublish( &mqttPacket );
             _lastPacketIdentifier = mqttPacket.packetIdentifier;
+
+            /* Save the payload of the PUBLISH. */
+            _publishCount++;
+            _lastPublishPayloadLength = deserializedPublish.u.publish.publishInfo.payloadLength;
+            AwsIotShadow_Assert( _lastPublishPayloadLength <= LAST_PUBLISH_PAYLOAD_SIZE );
+            ( void ) memcpy( _pLastPublishPayload,
+                             deserializedPublish.u.publish.publishInfo.pPayload,
+                             _lastPublishPayloadLength );
         }
 
         AwsIotShadow_Assert( status == IOT_MQTT_SUCCESS );
@@ -364,6 +452,20 @@ static size_t _receive( void * pConnection,
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Completion callback for the coalesced UPDATE test. Saves the number
+ * of merged updates.
+ */
+static void _coalescedUpdateCallback( void * pCallbackContext,
+                                      AwsIotShadowCallbackParam_t * pCallbackParam )
+{
+    uint32_t * pMergedCount = ( uint32_t * ) pCallbackContext;
+
+    *pMergedCount = pCallbackParam->u.operation.mergedCount;
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Test group for Shadow API tests.
  */
@@ -390,6 +492,8 @@ TEST_SETUP( Shadow_Unit_API )
     /* Clear the last packet type and identifier. */
     _lastPacketType = 0;
     _lastPacketIdentifier = 0;
+    _publishCount = 0;
+    _lastPublishPayloadLength = 0;
 
     /* Create the mutex that synchronizes the receive callback and send thread. */
     TEST_ASSERT_EQUAL_INT( true, IotMutex_Create( &_lastPacketMutex, false ) );
@@ -456,6 +560,10 @@ TEST_GROUP_RUNNER( Shadow_Unit_API )
     RUN_TEST_CASE( Shadow_Unit_API, DeleteMallocFail );
     RUN_TEST_CASE( Shadow_Unit_API, GetMallocFail );
     RUN_TEST_CASE( Shadow_Unit_API, UpdateMallocFail );
+    RUN_TEST_CASE( Shadow_Unit_API, PendingUpdateLookup );
+    RUN_TEST_CASE( Shadow_Unit_API, CoalescedUpdate );
+    RUN_TEST_CASE( Shadow_Unit_API, CoalescedUpdateDisconnect );
+    RUN_TEST_CASE( Shadow_Unit_API, CoalescedUpdateCleanup );
 }
 
 /*-----------------------------------------------------------*/
@@ -854,3 +962,372 @@ TEST( Shadow_Unit_API, UpdateMallocFail )
 }
 
 /*-----------------------------------------------------------*/
+
+/**
+ * @brief Checks that Shadow UPDATE responses are matched to the correct
+ * pending UPDATE and measures the matching time for 1 to
+ * #PENDING_UPDATE_MAX_COUNT pending UPDATEs.
+ */
+TEST( Shadow_Unit_API, PendingUpdateLookup )
+{
+    size_t i = 0, j = 0, k = 0, tokenLength = 0;
+    const size_t pPendingCounts[] = { 1, 8, 64, PENDING_UPDATE_MAX_COUNT };
+    _shadowOperation_t * pOperations = NULL, * pFoundOperation = NULL;
+    _shadowSubscription_t * pSubscription = NULL;
+    char * pTokens = NULL;
+    char pDocument[ PENDING_UPDATE_RESPONSE_LENGTH + PENDING_UPDATE_TOKEN_SIZE + 1 ] = { 0 };
+    const char * pClientToken = NULL;
+    size_t clientTokenLength = 0;
+    uint64_t startTime = 0, elapsedTime = 0;
+
+    /* Allocate the pending operations, their client tokens, and a subscription
+     * object that holds the Thing Name. */
+    pOperations = IotTest_Malloc( sizeof( _shadowOperation_t ) * PENDING_UPDATE_MAX_COUNT );
+    TEST_ASSERT_NOT_NULL( pOperations );
+    pTokens = IotTest_Malloc( PENDING_UPDATE_TOKEN_SIZE * PENDING_UPDATE_MAX_COUNT );
+    TEST_ASSERT_NOT_NULL( pTokens );
+    pSubscription = IotTest_Malloc( sizeof( _shadowSubscription_t ) + TEST_THING_NAME_LENGTH );
+    TEST_ASSERT_NOT_NULL( pSubscription );
+
+    ( void ) memset( pSubscription, 0x00, sizeof( _shadowSubscription_t ) );
+    ( void ) memcpy( pSubscription->pThingName, TEST_THING_NAME, TEST_THING_NAME_LENGTH );
+    pSubscription->thingNameLength = TEST_THING_NAME_LENGTH;
+
+    /* All response documents share the same prefix. */
+    ( void ) memcpy( pDocument, PENDING_UPDATE_RESPONSE, PENDING_UPDATE_RESPONSE_LENGTH );
+
+    if( TEST_PROTECT() )
+    {
+        for( i = 0; i < ( sizeof( pPendingCounts ) / sizeof( pPendingCounts[ 0 ] ) ); i++ )
+        {
+            ( void ) memset( pOperations, 0x00, sizeof( _shadowOperation_t ) * pPendingCounts[ i ] );
+
+            /* Add the pending UPDATEs, each with a unique client token. */
+            for( j = 0; j < pPendingCounts[ i ]; j++ )
+            {
+                tokenLength = ( size_t ) snprintf( pTokens + ( j * PENDING_UPDATE_TOKEN_SIZE ),
+                                                   PENDING_UPDATE_TOKEN_SIZE,
+                                                   "\"token%04lu\"",
+                                                   ( unsigned long ) j );
+
+                pOperations[ j ].type = _SHADOW_UPDATE;
+                pOperations[ j ].status = AWS_IOT_SHADOW_STATUS_PENDING;
+                pOperations[ j ].pSubscription = pSubscription;
+                pOperations[ j ].u.update.pClientToken = pTokens + ( j * PENDING_UPDATE_TOKEN_SIZE );
+                pOperations[ j ].u.update.clientTokenLength = tokenLength;
+
+                IotMutex_Lock( &( _AwsIotShadowPendingOperationsMutex ) );
+                _AwsIotShadow_AddPendingOperation( &( pOperations[ j ] ) );
+                IotMutex_Unlock( &( _AwsIotShadowPendingOperationsMutex ) );
+            }
+
+            startTime = IotClock_GetTimeMs();
+
+            /* Match a response to every pending UPDATE, the same way the UPDATE
+             * callback does. */
+            for( k = 0; k < PENDING_UPDATE_ITERATIONS; k++ )
+            {
+                for( j = 0; j < pPendingCounts[ i ]; j++ )
+                {
+                    tokenLength = pOperations[ j ].u.update.clientTokenLength;
+                    ( void ) memcpy( pDocument + PENDING_UPDATE_RESPONSE_LENGTH,
+                                     pOperations[ j ].u.update.pClientToken,
+                                     tokenLength );
+                    pDocument[ PENDING_UPDATE_RESPONSE_LENGTH + tokenLength ] = '}';
+
+                    TEST_ASSERT_EQUAL_INT( true,
+                                           IotJsonUtils_FindJsonValue( pDocument,
+                                                                       PENDING_UPDATE_RESPONSE_LENGTH + tokenLength + 1,
+                                                                       CLIENT_TOKEN_KEY,
+                                                                       CLIENT_TOKEN_KEY_LENGTH,
+                                                                       &pClientToken,
+                                                                       &clientTokenLength ) );
+
+                    IotMutex_Lock( &( _AwsIotShadowPendingOperationsMutex ) );
+                    pFoundOperation = _AwsIotShadow_FindPendingOperation( _SHADOW_UPDATE,
+                                                                          TEST_THING_NAME,
+                                                                          TEST_THING_NAME_LENGTH,
+                                                                          pClientToken,
+                                                                          clientTokenLength );
+                    IotMutex_Unlock( &( _AwsIotShadowPendingOperationsMutex ) );
+
+                    TEST_ASSERT_EQUAL_PTR( &( pOperations[ j ] ), pFoundOperation );
+                }
+            }
+
+            elapsedTime = IotClock_GetTimeMs() - startTime;
+
+            /* A client token that was never sent must not match. */
+            IotMutex_Lock( &( _AwsIotShadowPendingOperationsMutex ) );
+            pFoundOperation = _AwsIotShadow_FindPendingOperation( _SHADOW_UPDATE,
+                                                                  TEST_THING_NAME,
+                                                                  TEST_THING_NAME_LENGTH,
+                                                                  "\"unknown\"",
+                                                                  9 );
+            IotMutex_Unlock( &( _AwsIotShadowPendingOperationsMutex ) );
+            TEST_ASSERT_NULL( pFoundOperation );
+
+            /* Report the result of this benchmark. */
+            UnityPrint( "PendingUpdateLookup " );
+            UnityPrintNumber( ( UNITY_INT ) pPendingCounts[ i ] );
+            UnityPrint( " pending: " );
+            UnityPrintNumber( ( UNITY_INT ) ( pPendingCounts[ i ] * PENDING_UPDATE_ITERATIONS ) );
+            UnityPrint( " responses matched in " );
+            UnityPrintNumber( ( UNITY_INT ) elapsedTime );
+            UnityPrint( " ms." );
+            UNITY_PRINT_EOL();
+
+            /* Remove the pending UPDATEs. */
+            IotMutex_Lock( &( _AwsIotShadowPendingOperationsMutex ) );
+
+            for( j = 0; j < pPendingCounts[ i ]; j++ )
+            {
+                IotListDouble_Remove( &( pOperations[ j ].link ) );
+            }
+
+            IotMutex_Unlock( &( _AwsIotShadowPendingOperationsMutex ) );
+        }
+    }
+
+    IotTest_Free( pSubscription );
+    IotTest_Free( pTokens );
+    IotTest_Free( pOperations );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Checks that Shadow UPDATEs passed with #AWS_IOT_SHADOW_FLAG_COALESCE
+ * are merged and sent as a single Shadow UPDATE.
+ */
+TEST( Shadow_Unit_API, CoalescedUpdate )
+{
+    size_t i = 0;
+    AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
+    AwsIotShadowDocumentInfo_t documentInfo = AWS_IOT_SHADOW_DOCUMENT_INFO_INITIALIZER;
+    AwsIotShadowCallbackInfo_t callbackInfo = AWS_IOT_SHADOW_CALLBACK_INFO_INITIALIZER;
+    AwsIotShadowOperation_t updateOperation = AWS_IOT_SHADOW_OPERATION_INITIALIZER;
+    _shadowOperation_t * pOperation = NULL;
+    uint32_t publishCount = 0, callbackMergedCount = 0;
+    size_t payloadLength = 0;
+    char pPayload[ LAST_PUBLISH_PAYLOAD_SIZE ] = { 0 };
+
+    const char * const pDocuments[ COALESCED_UPDATE_COUNT ] =
+    {
+        "{\"state\":{\"reported\":{\"temperature\":21,\"humidity\":40}},\"clientToken\":\"token-1\"}",
+        "{\"state\":{\"reported\":{\"temperature\":22}},\"clientToken\":\"token-2\"}",
+        "{\"state\":{\"reported\":{\"pressure\":1013}},\"clientToken\":\"token-3\"}",
+        "{\"state\":{\"reported\":{\"temperature\":23}},\"clientToken\":\"token-4\"}"
+    };
+
+    /* Shorten the coalesce window. It is restored by AwsIotShadow_Cleanup. */
+    _AwsIotShadowCoalesceWindowMs = COALESCE_WINDOW_MS;
+
+    documentInfo.pThingName = TEST_THING_NAME;
+    documentInfo.thingNameLength = TEST_THING_NAME_LENGTH;
+    documentInfo.qos = IOT_MQTT_QOS_1;
+    documentInfo.u.update.pUpdateDocument = pDocuments[ 0 ];
+    documentInfo.u.update.updateDocumentLength = strlen( pDocuments[ 0 ] );
+
+    /* Coalesced updates cannot be waited on. */
+    status = AwsIotShadow_Update( _pMqttConnection,
+                                  &documentInfo,
+                                  AWS_IOT_SHADOW_FLAG_COALESCE | AWS_IOT_SHADOW_FLAG_WAITABLE,
+                                  NULL,
+                                  &updateOperation );
+    TEST_ASSERT_EQUAL( AWS_IOT_SHADOW_BAD_PARAMETER, status );
+
+    status = AwsIotShadow_Update( _pMqttConnection,
+                                  &documentInfo,
+                                  AWS_IOT_SHADOW_FLAG_COALESCE,
+                                  NULL,
+                                  &updateOperation );
+    TEST_ASSERT_EQUAL( AWS_IOT_SHADOW_BAD_PARAMETER, status );
+
+    /* Coalesced updates must have a reported state. */
+    documentInfo.u.update.pUpdateDocument = "{\"state\":{\"desired\":{\"on\":true}},\"clientToken\":\"token\"}";
+    documentInfo.u.update.updateDocumentLength = strlen( documentInfo.u.update.pUpdateDocument );
+    status = AwsIotShadow_Update( _pMqttConnection,
+                                  &documentInfo,
+                                  AWS_IOT_SHADOW_FLAG_COALESCE,
+                                  NULL,
+                                  NULL );
+    TEST_ASSERT_EQUAL( AWS_IOT_SHADOW_BAD_PARAMETER, status );
+
+    /* The callback is only invoked if the merged update cannot be sent; the
+     * Shadow service never responds in this test. */
+    callbackInfo.function = _coalescedUpdateCallback;
+    callbackInfo.pCallbackContext = &callbackMergedCount;
+
+    for( i = 0; i < COALESCED_UPDATE_COUNT; i++ )
+    {
+        documentInfo.u.update.pUpdateDocument = pDocuments[ i ];
+        documentInfo.u.update.updateDocumentLength = strlen( pDocuments[ i ] );
+
+        status = AwsIotShadow_Update( _pMqttConnection,
+                                      &documentInfo,
+                                      AWS_IOT_SHADOW_FLAG_COALESCE,
+                                      &callbackInfo,
+                                      NULL );
+        TEST_ASSERT_EQUAL( AWS_IOT_SHADOW_STATUS_PENDING, status );
+    }
+
+    /* Nothing is sent before the coalesce window ends. */
+    IotMutex_Lock( &_lastPacketMutex );
+    publishCount = _publishCount;
+    IotMutex_Unlock( &_lastPacketMutex );
+    TEST_ASSERT_EQUAL_UINT32( 0, publishCount );
+
+    /* Wait for the coalesce window and the subscriptions and PUBLISH of the
+     * merged update. */
+    IotClock_SleepMs( COALESCE_WINDOW_MS + 10 * NETWORK_ROUND_TRIP_TIME_MS );
+
+    IotMutex_Lock( &_lastPacketMutex );
+    publishCount = _publishCount;
+    payloadLength = _lastPublishPayloadLength;
+    ( void ) memcpy( pPayload, _pLastPublishPayload, payloadLength );
+    IotMutex_Unlock( &_lastPacketMutex );
+
+    TEST_ASSERT_EQUAL_UINT32( 0, callbackMergedCount );
+    TEST_ASSERT_EQUAL_UINT32( 1, publishCount );
+    TEST_ASSERT_EQUAL( sizeof( COALESCED_UPDATE_DOCUMENT ) - 1, payloadLength );
+    TEST_ASSERT_EQUAL_STRING_LEN( COALESCED_UPDATE_DOCUMENT, pPayload, payloadLength );
+
+    /* The merged update is pending with the most recent client token. */
+    IotMutex_Lock( &( _AwsIotShadowPendingOperationsMutex ) );
+    pOperation = _AwsIotShadow_FindPendingOperation( _SHADOW_UPDATE,
+                                                     TEST_THING_NAME,
+                                                     TEST_THING_NAME_LENGTH,
+                                                     "\"token-4\"",
+                                                     9 );
+    IotMutex_Unlock( &( _AwsIotShadowPendingOperationsMutex ) );
+
+    TEST_ASSERT_NOT_NULL( pOperation );
+    TEST_ASSERT_EQUAL_UINT32( COALESCED_UPDATE_COUNT, pOperation->u.update.mergedCount );
+    TEST_ASSERT_EQUAL_PTR( _coalescedUpdateCallback, pOperation->notify.callback.function );
+}
+
+/*-----------------------------------------------------------*/
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Checks that coalesced Shadow UPDATEs are sent by
+ * @ref shadow_function_flushcoalescedupdates, and that nothing is sent on their
+ * MQTT connection once it is disconnected before the coalesce window ends.
+ */
+TEST( Shadow_Unit_API, CoalescedUpdateDisconnect )
+{
+    size_t i = 0;
+    AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
+    AwsIotShadowDocumentInfo_t documentInfo = AWS_IOT_SHADOW_DOCUMENT_INFO_INITIALIZER;
+    IotMqttNetworkInfo_t networkInfo = IOT_MQTT_NETWORK_INFO_INITIALIZER;
+    uint32_t publishCount = 0;
+    size_t payloadLength = 0;
+    char pPayload[ LAST_PUBLISH_PAYLOAD_SIZE ] = { 0 };
+
+    const char * const pDocuments[ COALESCED_UPDATE_COUNT ] =
+    {
+        "{\"state\":{\"reported\":{\"temperature\":21,\"humidity\":40}},\"clientToken\":\"token-1\"}",
+        "{\"state\":{\"reported\":{\"temperature\":22}},\"clientToken\":\"token-2\"}",
+        "{\"state\":{\"reported\":{\"pressure\":1013}},\"clientToken\":\"token-3\"}",
+        "{\"state\":{\"reported\":{\"temperature\":23}},\"clientToken\":\"token-4\"}"
+    };
+
+    /* Set a coalesce window that does not end during this test. It is restored
+     * by AwsIotShadow_Cleanup. */
+    _AwsIotShadowCoalesceWindowMs = LONG_COALESCE_WINDOW_MS;
+
+    documentInfo.pThingName = TEST_THING_NAME;
+    documentInfo.thingNameLength = TEST_THING_NAME_LENGTH;
+    documentInfo.qos = IOT_MQTT_QOS_1;
+
+    for( i = 0; i < COALESCED_UPDATE_COUNT; i++ )
+    {
+        documentInfo.u.update.pUpdateDocument = pDocuments[ i ];
+        documentInfo.u.update.updateDocumentLength = strlen( pDocuments[ i ] );
+
+        status = AwsIotShadow_Update( _pMqttConnection,
+                                      &documentInfo,
+                                      AWS_IOT_SHADOW_FLAG_COALESCE,
+                                      NULL,
+                                      NULL );
+        TEST_ASSERT_EQUAL( AWS_IOT_SHADOW_STATUS_PENDING, status );
+    }
+
+    /* Send the merged update before disconnecting. */
+    AwsIotShadow_FlushCoalescedUpdates( _pMqttConnection );
+
+    IotMutex_Lock( &_lastPacketMutex );
+    publishCount = _publishCount;
+    payloadLength = _lastPublishPayloadLength;
+    ( void ) memcpy( pPayload, _pLastPublishPayload, payloadLength );
+    IotMutex_Unlock( &_lastPacketMutex );
+
+    TEST_ASSERT_EQUAL_UINT32( 1, publishCount );
+    TEST_ASSERT_EQUAL( sizeof( COALESCED_UPDATE_DOCUMENT ) - 1, payloadLength );
+    TEST_ASSERT_EQUAL_STRING_LEN( COALESCED_UPDATE_DOCUMENT, pPayload, payloadLength );
+
+    /* Disconnect and destroy the MQTT connection. A new one is created for the
+     * test tear down. */
+    IotMqtt_Disconnect( _pMqttConnection, IOT_MQTT_FLAG_CLEANUP_ONLY );
+
+    networkInfo.pNetworkInterface = &_networkInterface;
+    _pMqttConnection = IotTestMqtt_createMqttConnection( false,
+                                                         &networkInfo,
+                                                         0 );
+    TEST_ASSERT_NOT_NULL( _pMqttConnection );
+
+    /* Nothing else is sent when the coalesce window ends. */
+    IotClock_SleepMs( LONG_COALESCE_WINDOW_MS + 10 * NETWORK_ROUND_TRIP_TIME_MS );
+
+    IotMutex_Lock( &_lastPacketMutex );
+    publishCount = _publishCount;
+    IotMutex_Unlock( &_lastPacketMutex );
+
+    TEST_ASSERT_EQUAL_UINT32( 1, publishCount );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Checks that coalesced Shadow UPDATEs waiting to be sent are discarded
+ * by @ref shadow_function_cleanup.
+ */
+TEST( Shadow_Unit_API, CoalescedUpdateCleanup )
+{
+    AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
+    AwsIotShadowDocumentInfo_t documentInfo = AWS_IOT_SHADOW_DOCUMENT_INFO_INITIALIZER;
+    uint32_t publishCount = 0;
+
+    _AwsIotShadowCoalesceWindowMs = COALESCE_WINDOW_MS;
+
+    documentInfo.pThingName = TEST_THING_NAME;
+    documentInfo.thingNameLength = TEST_THING_NAME_LENGTH;
+    documentInfo.qos = IOT_MQTT_QOS_1;
+    documentInfo.u.update.pUpdateDocument = "{\"state\":{\"reported\":{\"on\":true}},\"clientToken\":\"token\"}";
+    documentInfo.u.update.updateDocumentLength = strlen( documentInfo.u.update.pUpdateDocument );
+
+    status = AwsIotShadow_Update( _pMqttConnection,
+                                  &documentInfo,
+                                  AWS_IOT_SHADOW_FLAG_COALESCE,
+                                  NULL,
+                                  NULL );
+    TEST_ASSERT_EQUAL( AWS_IOT_SHADOW_STATUS_PENDING, status );
+
+    /* Clean up the Shadow library before the coalesce window ends. It is
+     * initialized again for the test tear down. */
+    AwsIotShadow_Cleanup();
+    TEST_ASSERT_EQUAL( AWS_IOT_SHADOW_SUCCESS, AwsIotShadow_Init( 0 ) );
+
+    /* The discarded update is never sent. */
+    IotClock_SleepMs( COALESCE_WINDOW_MS + 10 * NETWORK_ROUND_TRIP_TIME_MS );
+
+    IotMutex_Lock( &_lastPacketMutex );
+    publishCount = _publishCount;
+    IotMutex_Unlock( &_lastPacketMutex );
+
+    TEST_ASSERT_EQUAL_UINT32( 0, publishCount );
+}
+
+/*-----------------------------------------------------------*/
@@ -52,6 +52,11 @@
  */
 #define ERROR_DOCUMENT_BUFFER_SIZE    ( 128 )
 
+/**
+ * @brief The size of the buffers allocated for holding merged reported states.
+ */
+#define MERGED_STATE_BUFFER_SIZE      ( 256 )
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -142,6 +147,47 @@ static void _parseThingName( const char * pTopicName,
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Wrapper for merging reported states and checking the result.
+ */
+static void _mergeReportedState( const char * pReported,
+                                 const char * pPatch,
+                                 AwsIotShadowError_t expectedResult,
+                                 const char * pExpectedMerged )
+{
+    AwsIotShadowError_t status = AWS_IOT_SHADOW_STATUS_PENDING;
+    char pMerged[ MERGED_STATE_BUFFER_SIZE ] = { 0 };
+    size_t mergedLength = 0, expectedLength = 0;
+
+    /* Calculate the merged length. */
+    status = _AwsIotShadow_MergeReportedState( pReported,
+                                               strlen( pReported ),
+                                               pPatch,
+                                               strlen( pPatch ),
+                                               NULL,
+                                               &expectedLength );
+    TEST_ASSERT_EQUAL( expectedResult, status );
+
+    if( expectedResult == AWS_IOT_SHADOW_SUCCESS )
+    {
+        TEST_ASSERT_LESS_THAN( MERGED_STATE_BUFFER_SIZE, expectedLength );
+
+        /* Merge the states and check the result. */
+        status = _AwsIotShadow_MergeReportedState( pReported,
+                                                   strlen( pReported ),
+                                                   pPatch,
+                                                   strlen( pPatch ),
+                                                   pMerged,
+                                                   &mergedLength );
+        TEST_ASSERT_EQUAL( AWS_IOT_SHADOW_SUCCESS, status );
+        TEST_ASSERT_EQUAL( expectedLength, mergedLength );
+        TEST_ASSERT_EQUAL( strlen( pExpectedMerged ), mergedLength );
+        TEST_ASSERT_EQUAL_STRING_LEN( pExpectedMerged, pMerged, mergedLength );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Test group for Shadow parser tests.
  */
@@ -183,6 +229,7 @@ TEST_GROUP_RUNNER( Shadow_Unit_Parser )
     RUN_TEST_CASE( Shadow_Unit_Parser, ErrorDocument );
     RUN_TEST_CASE( Shadow_Unit_Parser, ErrorDocumentInvalid );
     RUN_TEST_CASE( Shadow_Unit_Parser, ThingName );
+    RUN_TEST_CASE( Shadow_Unit_Parser, MergeReportedState );
 }
 
 /*-----------------------------------------------------------*/
@@ -461,3 +508,61 @@ TEST( Shadow_Unit_Parser, ThingName )
 }
 
 /*-----------------------------------------------------------*/
+
+/**
+ * @brief Tests merging valid and invalid reported states.
+ */
+TEST( Shadow_Unit_Parser, MergeReportedState )
+{
+    /* Keys of the patch replace existing keys; other keys are kept. */
+    _mergeReportedState( "{\"temperature\":21,\"humidity\":40}",
+                         "{\"temperature\":22}",
+                         AWS_IOT_SHADOW_SUCCESS,
+                         "{\"humidity\":40,\"temperature\":22}" );
+
+    /* New keys are appended. */
+    _mergeReportedState( "{\"temperature\":21}",
+                         "{\"pressure\":1013}",
+                         AWS_IOT_SHADOW_SUCCESS,
+                         "{\"temperature\":21,\"pressure\":1013}" );
+
+    /* Objects, arrays, strings, and whitespace in values are copied. Only the
+     * top-level members are merged. */
+    _mergeReportedState( "{ \"a\" : { \"b\": 1, \"c\": 2 }, \"list\": [1, 2], \"name\": \"x\\\"y\" }",
+                         "{\"a\":{\"b\":3},\"name\":\"z\"}",
+                         AWS_IOT_SHADOW_SUCCESS,
+                         "{\"list\": [1, 2],\"a\":{\"b\":3},\"name\":\"z\"}" );
+
+    /* A key nested in another member is not a top-level member. */
+    _mergeReportedState( "{\"outer\":{\"inner\":1},\"inner\":2}",
+                         "{\"inner\":3}",
+                         AWS_IOT_SHADOW_SUCCESS,
+                         "{\"outer\":{\"inner\":1},\"inner\":3}" );
+
+    /* Empty objects. */
+    _mergeReportedState( "{}",
+                         "{\"on\":true}",
+                         AWS_IOT_SHADOW_SUCCESS,
+                         "{\"on\":true}" );
+    _mergeReportedState( "{\"on\":true}",
+                         "{ }",
+                         AWS_IOT_SHADOW_SUCCESS,
+                         "{\"on\":true}" );
+
+    /* Null values are kept so that the Shadow service deletes the key. */
+    _mergeReportedState( "{\"on\":true}",
+                         "{\"on\":null}",
+                         AWS_IOT_SHADOW_SUCCESS,
+                         "{\"on\":null}" );
+
+    /* Not JSON objects. */
+    _mergeReportedState( "[1,2]", "{\"on\":true}", AWS_IOT_SHADOW_BAD_PARAMETER, NULL );
+    _mergeReportedState( "{\"on\":true}", "true", AWS_IOT_SHADOW_BAD_PARAMETER, NULL );
+
+    /* Malformed members. */
+    _mergeReportedState( "{\"on\":true}", "{\"on\"}", AWS_IOT_SHADOW_BAD_PARAMETER, NULL );
+    _mergeReportedState( "{\"on\":true}", "{on:true}", AWS_IOT_SHADOW_BAD_PARAMETER, NULL );
+    _mergeReportedState( "{\"on\":true,}", "{\"off\":true}", AWS_IOT_SHADOW_BAD_PARAMETER, NULL );
+}
+
+/*-----------------------------------------------------------*/
@@ -343,15 +343,16 @@
 #define IOT_BLE_DATA_TRANSFER_SERVICE_TYPE_WIFI_PROVISIONING    0x01
 
 /**
- *@brief Size of the buffer to store pending bytes to be sent out through data transfer service.
+ *@brief Size of the ring buffer to store pending bytes to be sent out through data transfer service.
+ * Must be at least one transmit length of IOT_BLE_PREFERRED_MTU_SIZE.
  */
 #ifndef IOT_BLE_DATA_TRANSFER_TX_BUFFER_SIZE
     #define IOT_BLE_DATA_TRANSFER_TX_BUFFER_SIZE    ( 1024 )
 #endif
 
 /**
- * @brief Initial size of the buffer used to store the data received through  data transfer service.
- * The buffer size grows exponentially ( powers of 2 ).
+ * @brief Size of the chunks used to store a large message received through data transfer service.
+ * A message larger than one chunk is stored in a list of chunks.
  */
 #ifndef IOT_BLE_DATA_TRANSFER_RX_BUFFER_SIZE
     #define IOT_BLE_DATA_TRANSFER_RX_BUFFER_SIZE    ( 1024 )
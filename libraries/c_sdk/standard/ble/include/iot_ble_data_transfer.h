@@ -97,6 +97,10 @@ bool IotBleDataTransfer_SetCallback( IotBleDataTransferChannel_t * pChannel,
  * @param[in] pMessage Pointer to the message to be sent.
  * @param[in] messageLength Length in bytes of the message to be sent.
  *
+ * A message larger than the MTU is queued in a send buffer of IOT_BLE_DATA_TRANSFER_TX_BUFFER_SIZE bytes
+ * which is drained by the reads of the peer. The function blocks until the last part of the message
+ * fits in the send buffer, or until the peer stops reading for IOT_BLE_DATA_TRANSFER_TIMEOUT_MS.
+ *
  * @return Number of bytes of message actually sent.
  */
 size_t IotBleDataTransfer_Send( IotBleDataTransferChannel_t * pChannel,
@@ -111,6 +115,8 @@ size_t IotBleDataTransfer_Send( IotBleDataTransferChannel_t * pChannel,
  * @param[in] pBuffer Pointer to the buffer where the data will be copied. Pass NULL to do an empty read to flush the data.
  * @param[in] bytesRequested Number of bytes of data requested.
  *
+ * Data not read when the callback returns is discarded.
+ *
  * @return Number of bytes of data returned. Should be less than or equal to the number of bytes requested.
  */
 size_t IotBleDataTransfer_Receive( IotBleDataTransferChannel_t * pChannel,
@@ -120,6 +126,7 @@ size_t IotBleDataTransfer_Receive( IotBleDataTransferChannel_t * pChannel,
 /**
  * @brief Returns a pointer to the received buffer and length of the received data.
  * Function should always be called in the context of a IotBleDataTransferChannelCallback_t IOT_BLE_DATA_TRANSFER_CHANNEL_DATA_RECEIVED event.
+ * A large message received in several chunks is copied into a single buffer on the first call.
  *
  * @param[in] pChannel Channel on which the callback is fired.
  * @param[out] pBuffer Pointer to the received buffer.
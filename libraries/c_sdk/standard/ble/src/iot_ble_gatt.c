@@ -53,6 +53,11 @@ static BTStatus_t _createAttributes( BTService_t * pService );
 static size_t _computeNumberOfHandles( BTService_t * pService );
 static void _serviceClean( BLEServiceListElement_t * pServiceElem );
 static BLEServiceListElement_t * _getServiceListElemFromHandle( uint16_t handle );
+static BLEServiceListElement_t * _searchServiceList( uint16_t handle,
+                                                     uint16_t * pAttributeIndex );
+static BLEServiceListElement_t * _lookupHandle( uint16_t handle,
+                                                uint16_t * pAttributeIndex );
+static void _rebuildHandleTable( void );
 static bool _getCallbackFromHandle( uint16_t attrHandle,
                                     IotBleAttributeEventCallback_t * pEventsCallbacks );
 static BLEServiceListElement_t * _getLastAddedServiceElem( void );
@@ -163,14 +168,13 @@ void _serviceClean( BLEServiceListElement_t * pServiceElem )
 
 /*-----------------------------------------------------------*/
 
-BLEServiceListElement_t * _getServiceListElemFromHandle( uint16_t handle )
+BLEServiceListElement_t * _searchServiceList( uint16_t handle,
+                                              uint16_t * pAttributeIndex )
 {
     IotLink_t * pTmpElem;
     BLEServiceListElement_t * pServiceElem = NULL, * pTmpServiceElem;
+    uint16_t attributeIndex;
 
-    IotMutex_Lock( &_BTInterface.threadSafetyMutex );
-
-    /* Remove service from service list */
     /* IotContainers_ForEach( &_BTInterface.xServiceListHead, pxTmpElem ) */
     for( ( pTmpElem ) = _BTInterface.serviceListHead.pNext; ( pTmpElem ) != ( &_BTInterface.serviceListHead ); ( pTmpElem ) = ( pTmpElem )->pNext )
     {
@@ -179,11 +183,137 @@ BLEServiceListElement_t * _getServiceListElemFromHandle( uint16_t handle )
         if( ( pTmpServiceElem->pService->pusHandlesBuffer[ 0 ] <= handle ) &&
             ( handle <= pTmpServiceElem->endHandle ) )
         {
-            pServiceElem = pTmpServiceElem;
+            for( attributeIndex = 0; attributeIndex < pTmpServiceElem->pService->xNumberOfAttributes; attributeIndex++ )
+            {
+                if( pTmpServiceElem->pService->pusHandlesBuffer[ attributeIndex ] == handle )
+                {
+                    pServiceElem = pTmpServiceElem;
+                    *pAttributeIndex = attributeIndex;
+                    break;
+                }
+            }
+
             break;
         }
     }
 
+    return pServiceElem;
+}
+
+/*-----------------------------------------------------------*/
+
+BLEServiceListElement_t * _lookupHandle( uint16_t handle,
+                                         uint16_t * pAttributeIndex )
+{
+    BLEServiceListElement_t * pServiceElem = NULL;
+    size_t low = 0, high = _BTInterface.handleTableLength, middle;
+
+    if( _BTInterface.handleTableStale == true )
+    {
+        pServiceElem = _searchServiceList( handle, pAttributeIndex );
+    }
+    else
+    {
+        /* Binary search in the table sorted by handle. */
+        while( low < high )
+        {
+            middle = low + ( ( high - low ) / 2 );
+
+            if( _BTInterface.pHandleTable[ middle ].handle < handle )
+            {
+                low = middle + 1;
+            }
+            else if( _BTInterface.pHandleTable[ middle ].handle > handle )
+            {
+                high = middle;
+            }
+            else
+            {
+                pServiceElem = _BTInterface.pHandleTable[ middle ].pServiceElem;
+                *pAttributeIndex = _BTInterface.pHandleTable[ middle ].attributeIndex;
+                break;
+            }
+        }
+    }
+
+    return pServiceElem;
+}
+
+/*-----------------------------------------------------------*/
+
+void _rebuildHandleTable( void )
+{
+    IotLink_t * pTmpElem;
+    BLEServiceListElement_t * pServiceElem;
+    _bleHandleTableEntry_t * pTable = NULL;
+    _bleHandleTableEntry_t entry;
+    size_t tableLength = 0, maxLength = 0, index;
+    uint16_t attributeIndex;
+
+    /* IotContainers_ForEach( &_BTInterface.xServiceListHead, pxTmpElem ) */
+    for( ( pTmpElem ) = _BTInterface.serviceListHead.pNext; ( pTmpElem ) != ( &_BTInterface.serviceListHead ); ( pTmpElem ) = ( pTmpElem )->pNext )
+    {
+        pServiceElem = IotLink_Container( BLEServiceListElement_t, pTmpElem, serviceList );
+        maxLength += pServiceElem->pService->xNumberOfAttributes;
+    }
+
+    if( maxLength > 0 )
+    {
+        pTable = IotBle_Malloc( maxLength * sizeof( _bleHandleTableEntry_t ) );
+    }
+
+    if( ( pTable != NULL ) || ( maxLength == 0 ) )
+    {
+        for( ( pTmpElem ) = _BTInterface.serviceListHead.pNext; ( pTmpElem ) != ( &_BTInterface.serviceListHead ); ( pTmpElem ) = ( pTmpElem )->pNext )
+        {
+            pServiceElem = IotLink_Container( BLEServiceListElement_t, pTmpElem, serviceList );
+
+            for( attributeIndex = 0; attributeIndex < pServiceElem->pService->xNumberOfAttributes; attributeIndex++ )
+            {
+                entry.handle = pServiceElem->pService->pusHandlesBuffer[ attributeIndex ];
+                entry.attributeIndex = attributeIndex;
+                entry.pServiceElem = pServiceElem;
+
+                /* Attributes which did not get a handle are not added. Insert sorted, the table is small. */
+                if( entry.handle != 0 )
+                {
+                    for( index = tableLength; ( index > 0 ) && ( pTable[ index - 1 ].handle > entry.handle ); index-- )
+                    {
+                        pTable[ index ] = pTable[ index - 1 ];
+                    }
+
+                    pTable[ index ] = entry;
+                    tableLength++;
+                }
+            }
+        }
+
+        _BTInterface.handleTableStale = false;
+    }
+    else
+    {
+        IotLogError( "Could not allocate the attribute handle table, searching the service list instead." );
+        _BTInterface.handleTableStale = true;
+    }
+
+    if( _BTInterface.pHandleTable != NULL )
+    {
+        IotBle_Free( _BTInterface.pHandleTable );
+    }
+
+    _BTInterface.pHandleTable = pTable;
+    _BTInterface.handleTableLength = tableLength;
+}
+
+/*-----------------------------------------------------------*/
+
+BLEServiceListElement_t * _getServiceListElemFromHandle( uint16_t handle )
+{
+    BLEServiceListElement_t * pServiceElem;
+    uint16_t attributeIndex;
+
+    IotMutex_Lock( &_BTInterface.threadSafetyMutex );
+    pServiceElem = _lookupHandle( handle, &attributeIndex );
     IotMutex_Unlock( &_BTInterface.threadSafetyMutex );
 
     return pServiceElem;
@@ -196,24 +326,22 @@ bool _getCallbackFromHandle( uint16_t attrHandle,
 {
     BLEServiceListElement_t * pServiceElem;
     bool foundService = false;
-    size_t attributeIndex;
+    uint16_t attributeIndex;
 
-    /* The service that was just added is the last in the list */
-    pServiceElem = _getServiceListElemFromHandle( attrHandle );
+    IotMutex_Lock( &_BTInterface.threadSafetyMutex );
+
+    pServiceElem = _lookupHandle( attrHandle, &attributeIndex );
 
     if( pServiceElem != NULL )
     {
-        for( attributeIndex = 0; attributeIndex < pServiceElem->pService->xNumberOfAttributes; attributeIndex++ )
-        {
-            if( pServiceElem->pService->pusHandlesBuffer[ attributeIndex ] == attrHandle )
-            {
-                *pEventsCallbacks = pServiceElem->pEventsCallbacks[ attributeIndex ];
-                foundService = true;
-                break;
-            }
-        }
+        *pEventsCallbacks = pServiceElem->pEventsCallbacks[ attributeIndex ];
+
+        /* Attributes without a callback, like the service declaration, do not get events. */
+        foundService = ( *pEventsCallbacks != NULL );
     }
 
+    IotMutex_Unlock( &_BTInterface.threadSafetyMutex );
+
     return foundService;
 }
 
@@ -445,6 +573,7 @@ void _serviceDeletedCb( BTStatus_t status,
     {
         IotMutex_Lock( &_BTInterface.threadSafetyMutex );
         _serviceClean( pServiceElem );
+        _rebuildHandleTable();
         IotMutex_Unlock( &_BTInterface.threadSafetyMutex );
     }
     else
@@ -751,7 +880,7 @@ BTStatus_t IotBle_CreateService( BTService_t * pService,
     /* Create all attributes. */
     if( pService != NULL )
     {
-        memset( pService->pusHandlesBuffer, 0, pService->xNumberOfAttributes );
+        memset( pService->pusHandlesBuffer, 0, pService->xNumberOfAttributes * sizeof( uint16_t ) );
         status = _addServiceToList( pService, pEventsCallbacks );
     }
 
@@ -794,6 +923,14 @@ BTStatus_t IotBle_CreateService( BTService_t * pService,
         }
     }
 
+    /* All the handles of the service are known, make them visible to the event dispatch. */
+    if( pService != NULL )
+    {
+        IotMutex_Lock( &_BTInterface.threadSafetyMutex );
+        _rebuildHandleTable();
+        IotMutex_Unlock( &_BTInterface.threadSafetyMutex );
+    }
+
     IotMutex_Unlock( &_BTInterface.waitCbMutex );
 
     return status;
@@ -65,6 +65,14 @@ typedef struct
     uint16_t endHandle;
 } BLEServiceListElement_t;
 
+/* Entry of the table used to dispatch GATT events by attribute handle. */
+typedef struct
+{
+    uint16_t handle;
+    uint16_t attributeIndex;
+    BLEServiceListElement_t * pServiceElem;
+} _bleHandleTableEntry_t;
+
 typedef struct
 {
     IotLink_t eventList;
@@ -80,6 +88,9 @@ typedef struct
     uint16_t handlePendingIndicationResponse;
     uint8_t serverIf;
     IotListDouble_t serviceListHead;
+    _bleHandleTableEntry_t * pHandleTable; /**< Attribute handles of all the services, sorted by handle. */
+    size_t handleTableLength;
+    bool handleTableStale;                 /**< Set when the table could not be rebuilt, the service list is searched instead. */
     IotListDouble_t connectionListHead;
     IotListDouble_t subscrEventListHead[ eNbEvents ]; /**< Any task can subscribe to events in that array, several callback can subscribe to the same event */
     uint16_t handlePendingPrepareWrite;
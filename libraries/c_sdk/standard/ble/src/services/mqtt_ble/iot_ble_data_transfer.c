@@ -155,6 +155,19 @@
  */
 #define _NUM_DATA_TRANSFER_SERVICES    ( sizeof( _attributeTable ) / sizeof( _attributeTable[ 0 ] ) )
 
+/**
+ * @brief Number of bytes kept after the end of the send ring buffer.
+ *
+ * A chunk which wraps around the end of the ring is copied into this area, so that every
+ * read response can point to contiguous memory. The negotiated MTU never exceeds
+ * #IOT_BLE_PREFERRED_MTU_SIZE, so one transmit length is always enough.
+ */
+#define _SEND_BUFFER_MIRROR_LENGTH    _TRANSMIT_LENGTH( IOT_BLE_PREFERRED_MTU_SIZE )
+
+#if ( IOT_BLE_DATA_TRANSFER_TX_BUFFER_SIZE < _TRANSMIT_LENGTH( IOT_BLE_PREFERRED_MTU_SIZE ) )
+    #error "IOT_BLE_DATA_TRANSFER_TX_BUFFER_SIZE must hold at least one transmit length of IOT_BLE_PREFERRED_MTU_SIZE."
+#endif
+
 /*-------------------------------------------------------------------------------------------------------------------------*/
 
 /**
@@ -184,16 +197,37 @@ typedef struct IotBleDataChannelBuffer
     size_t bufferLength;
 } IotBleDataChannelBuffer_t;
 
+/**
+ * @brief Fixed size chunk of a large object being received.
+ *
+ * Large objects are received into a list of chunks instead of a single buffer, so a
+ * growing message never has to be reallocated and copied.
+ */
+typedef struct IotBleDataChannelChunk
+{
+    struct IotBleDataChannelChunk * pNext;              /**< Next chunk of the message. */
+    size_t length;                                      /**< Number of bytes used in the chunk. */
+    uint8_t data[ IOT_BLE_DATA_TRANSFER_RX_BUFFER_SIZE ]; /**< Chunk data. */
+} IotBleDataChannelChunk_t;
+
 /**
  * @brief Structure used to represent a data transfer channel.
  */
 struct IotBleDataTransferChannel
 {
-    IotBleDataChannelBuffer_t lotBuffer;          /**< Points to a large object buffer. */
+    IotBleDataChannelChunk_t * pFirstChunk;       /**< First chunk of the large object being received. */
+    IotBleDataChannelChunk_t * pLastChunk;        /**< Last chunk of the large object being received. */
+    IotBleDataChannelChunk_t * pSpareChunk;       /**< Chunk kept across messages to avoid an allocation per message. */
+    size_t chunkOffset;                           /**< Read offset in the first chunk. */
+    IotBleDataChannelBuffer_t lotBuffer;          /**< Contiguous copy of a large object spanning several chunks, only made on peek. */
     IotBleDataChannelBuffer_t * pReceiveBuffer;   /**< Points to the buffer where data is received. */
 
-    IotBleDataChannelBuffer_t sendBuffer;         /**< Buffer used to send data. */
-    IotSemaphore_t sendComplete;                  /**< Lock to protect access to the send buffer. */
+    IotBleDataChannelBuffer_t sendBuffer;         /**< Ring buffer holding the part of a large object not read yet. */
+    const uint8_t * pSendPending;                 /**< Part of the large object which does not fit in the send buffer yet. */
+    size_t sendPendingLength;                     /**< Length of the pending part. */
+    IotMutex_t sendLock;                          /**< Lock to protect access to the send buffer and the pending part. */
+    IotSemaphore_t sendProgress;                  /**< Posted each time the pending part is moved into the send buffer. */
+    IotSemaphore_t sendComplete;                  /**< Posted when the large object transfer is complete. */
 
     IotBleDataTransferChannelCallback_t callback; /**< Callback invoked on various events on the channel. */
     void * pContext;                              /**< Callback context. */
@@ -204,7 +238,6 @@ struct IotBleDataTransferChannel
     bool isOpen;                                  /**< Flag to indicate if the channel is ready to send/receive data. */
 };
 
-
 /**
  * @ingroup ble_datatypes_structs
  * @brief MQTT BLE Service structure.
@@ -228,26 +261,46 @@ typedef struct IotBleDataTransferService
 static IotBleDataTransferService_t * _getServiceFromHandle( uint16_t handle );
 
 
-/**
- * @brief Reallocate a buffer; data is also copied from the old
- * buffer into the new buffer.
- *
- * @param[in] oldBuffer The current network receive buffer.
- * @param[in] oldBufferSize The size (in bytes) of oldBuffer.
- * @param[in] newBufferSize Requested size of the reallocated buffer.
- * copied into the new buffer.
- *
- * @return Pointer to a new, reallocated buffer; NULL if buffer reallocation failed.
+/*
+ * @brief Takes a chunk from the channel, allocating one if the spare chunk is in use.
  */
-static uint8_t * _reallocBuffer( uint8_t * oldBuffer,
-                                 size_t oldBufferSize,
-                                 size_t newBufferSize );
+static IotBleDataChannelChunk_t * _allocateChunk( IotBleDataTransferChannel_t * pChannel );
 
+/*
+ * @brief Gives a chunk back to the channel, freeing it if a spare chunk is already kept.
+ */
+static void _releaseChunk( IotBleDataTransferChannel_t * pChannel,
+                           IotBleDataChannelChunk_t * pChunk );
+
+/*
+ * @brief Appends data received for a large object to the channel chunk list.
+ */
+static bool _appendReceivedData( IotBleDataTransferChannel_t * pChannel,
+                                 const uint8_t * pData,
+                                 size_t length );
 
-static bool _resizeChannelBuffer( IotBleDataChannelBuffer_t * pChannelBuffer,
-                                  size_t initialLength,
-                                  size_t requiredLength );
+/*
+ * @brief Copies data out of the chunk list, releasing the chunks which are fully read.
+ */
+static size_t _receiveFromChunks( IotBleDataTransferChannel_t * pChannel,
+                                  uint8_t * pBuffer,
+                                  size_t bytesRequested );
 
+/*
+ * @brief Copies a large object spanning several chunks into one contiguous buffer.
+ */
+static bool _coalesceChunks( IotBleDataTransferChannel_t * pChannel );
+
+/*
+ * @brief Drops any received data still held by the channel.
+ */
+static void _flushReceivedData( IotBleDataTransferChannel_t * pChannel );
+
+/*
+ * @brief Moves as much of the pending message as fits into the send ring buffer.
+ * Must be called with the send lock held.
+ */
+static void _fillSendBuffer( IotBleDataTransferChannel_t * pChannel );
 
 static void _deleteChannelBuffer( IotBleDataChannelBuffer_t * pChannelBuffer );
 
@@ -276,14 +329,14 @@ static void _RXMesgCharCallback( IotBleAttributeEvent_t * pEventParam );
 
 /*
  * @brief Callback to register for events (read) on TX large message characteristic.
- * Buffers a large message and sends the message in chunks of size MTU at a time as response
- * to the read request. Keeps the buffer until last message is read.
+ * Sends the large message in chunks of size MTU at a time as response to the read request,
+ * refilling the send ring buffer from the sender as it drains.
  */
 static void _TXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam );
 
 /*
  * @brief Callback to register for events (write) on RX large message characteristic.
- * Copies the individual write packets into a buffer until a packet less than BLE MTU size
+ * Copies the individual write packets into a list of chunks until a packet less than BLE MTU size
  * is received. Sends the buffered message to the upper layer.
  */
 static void _RXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam );
@@ -422,85 +475,236 @@ static bool _send( IotBleDataTransferChannel_t * pChannel,
     return status;
 }
 
-static uint8_t * _reallocBuffer( uint8_t * oldBuffer,
-                                 size_t oldBufferSize,
-                                 size_t newBufferSize )
-{
-    uint8_t * newBuffer = NULL;
+/*-----------------------------------------------------------*/
 
-    /* This function should not be called with a smaller new buffer size or a
-     * copy offset greater than the old buffer size. */
-    IotBle_Assert( newBufferSize >= oldBufferSize );
+static IotBleDataChannelChunk_t * _allocateChunk( IotBleDataTransferChannel_t * pChannel )
+{
+    IotBleDataChannelChunk_t * pChunk = pChannel->pSpareChunk;
 
-    /* Allocate a larger receive buffer. */
-    newBuffer = IotBle_Malloc( newBufferSize );
+    if( pChunk != NULL )
+    {
+        pChannel->pSpareChunk = NULL;
+    }
+    else
+    {
+        pChunk = IotBle_Malloc( sizeof( IotBleDataChannelChunk_t ) );
+    }
 
-    /* Copy data into the new buffer. */
-    if( newBuffer != NULL )
+    if( pChunk != NULL )
     {
-        ( void ) memcpy( newBuffer,
-                         oldBuffer,
-                         oldBufferSize );
+        pChunk->pNext = NULL;
+        pChunk->length = 0;
+    }
+    else
+    {
+        IotLogError( "Failed to allocate a receive chunk of size %d", sizeof( IotBleDataChannelChunk_t ) );
     }
 
-    /* Free the old buffer. */
-    IotBle_Free( oldBuffer );
+    return pChunk;
+}
 
-    return newBuffer;
+/*-----------------------------------------------------------*/
+
+static void _releaseChunk( IotBleDataTransferChannel_t * pChannel,
+                           IotBleDataChannelChunk_t * pChunk )
+{
+    if( pChannel->pSpareChunk == NULL )
+    {
+        pChannel->pSpareChunk = pChunk;
+    }
+    else
+    {
+        IotBle_Free( pChunk );
+    }
 }
 
 /*-----------------------------------------------------------*/
 
-static bool _resizeChannelBuffer( IotBleDataChannelBuffer_t * pChannelBuffer,
-                                  size_t initialLength,
-                                  size_t requiredLength )
+static bool _appendReceivedData( IotBleDataTransferChannel_t * pChannel,
+                                 const uint8_t * pData,
+                                 size_t length )
 {
+    IotBleDataChannelChunk_t * pChunk;
+    size_t copyLength;
     bool result = true;
 
-    /**
-     * Create a new buffer if the buffer is empty.
-     */
-    if( pChannelBuffer->pBuffer == NULL )
+    while( ( length > 0 ) && ( result == true ) )
     {
-        pChannelBuffer->pBuffer = IotBle_Malloc( initialLength );
+        pChunk = pChannel->pLastChunk;
 
-        if( pChannelBuffer->pBuffer != NULL )
+        /* Link a new chunk once the last one is full. */
+        if( ( pChunk == NULL ) || ( pChunk->length == sizeof( pChunk->data ) ) )
         {
-            pChannelBuffer->bufferLength = initialLength;
-            pChannelBuffer->head = pChannelBuffer->tail = 0;
+            pChunk = _allocateChunk( pChannel );
+
+            if( pChunk == NULL )
+            {
+                result = false;
+            }
+            else if( pChannel->pLastChunk == NULL )
+            {
+                pChannel->pFirstChunk = pChunk;
+                pChannel->pLastChunk = pChunk;
+            }
+            else
+            {
+                pChannel->pLastChunk->pNext = pChunk;
+                pChannel->pLastChunk = pChunk;
+            }
         }
-        else
+
+        if( result == true )
         {
-            IotLogError( "Failed to allocate a buffer of size %d", initialLength );
-            result = false;
+            copyLength = sizeof( pChunk->data ) - pChunk->length;
+
+            if( copyLength > length )
+            {
+                copyLength = length;
+            }
+
+            memcpy( &pChunk->data[ pChunk->length ], pData, copyLength );
+            pChunk->length += copyLength;
+            pData += copyLength;
+            length -= copyLength;
         }
     }
-    else
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t _receiveFromChunks( IotBleDataTransferChannel_t * pChannel,
+                                  uint8_t * pBuffer,
+                                  size_t bytesRequested )
+{
+    IotBleDataChannelChunk_t * pChunk;
+    size_t bytesReturned = 0;
+    size_t copyLength;
+
+    while( ( bytesReturned < bytesRequested ) && ( pChannel->pFirstChunk != NULL ) )
     {
-        /**
-         *  If current buffer can't hold the received data, resize the buffer by twice the current size.
-         */
-        if( ( pChannelBuffer->head + requiredLength ) > pChannelBuffer->bufferLength )
+        pChunk = pChannel->pFirstChunk;
+        copyLength = pChunk->length - pChannel->chunkOffset;
+
+        if( copyLength > ( bytesRequested - bytesReturned ) )
         {
-            pChannelBuffer->pBuffer = _reallocBuffer( pChannelBuffer->pBuffer,
-                                                      pChannelBuffer->bufferLength,
-                                                      ( 2 * pChannelBuffer->bufferLength ) );
+            copyLength = bytesRequested - bytesReturned;
+        }
 
-            if( pChannelBuffer->pBuffer != NULL )
-            {
-                pChannelBuffer->bufferLength = ( pChannelBuffer->bufferLength * 2 );
-            }
-            else
+        if( pBuffer != NULL )
+        {
+            memcpy( ( pBuffer + bytesReturned ), &pChunk->data[ pChannel->chunkOffset ], copyLength );
+        }
+
+        bytesReturned += copyLength;
+        pChannel->chunkOffset += copyLength;
+
+        /* Release the chunk as soon as it is consumed. */
+        if( pChannel->chunkOffset == pChunk->length )
+        {
+            pChannel->pFirstChunk = pChunk->pNext;
+
+            if( pChannel->pFirstChunk == NULL )
             {
-                IotLogError( "Failed to re-allocate a buffer of size %d.\r\n", ( 2 * pChannelBuffer->bufferLength ) );
-                result = false;
+                pChannel->pLastChunk = NULL;
             }
+
+            pChannel->chunkOffset = 0;
+            _releaseChunk( pChannel, pChunk );
         }
     }
 
+    return bytesReturned;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _coalesceChunks( IotBleDataTransferChannel_t * pChannel )
+{
+    IotBleDataChannelChunk_t * pChunk;
+    size_t length = 0;
+    bool result = true;
+
+    for( pChunk = pChannel->pFirstChunk; pChunk != NULL; pChunk = pChunk->pNext )
+    {
+        length += pChunk->length;
+    }
+
+    length -= pChannel->chunkOffset;
+
+    pChannel->lotBuffer.pBuffer = IotBle_Malloc( length );
+
+    if( pChannel->lotBuffer.pBuffer != NULL )
+    {
+        pChannel->lotBuffer.bufferLength = length;
+        pChannel->lotBuffer.tail = 0;
+        pChannel->lotBuffer.head = _receiveFromChunks( pChannel, pChannel->lotBuffer.pBuffer, length );
+    }
+    else
+    {
+        IotLogError( "Failed to allocate a buffer of size %d", length );
+        result = false;
+    }
+
     return result;
 }
 
+/*-----------------------------------------------------------*/
+
+static void _flushReceivedData( IotBleDataTransferChannel_t * pChannel )
+{
+    IotBleDataChannelChunk_t * pChunk;
+
+    while( pChannel->pFirstChunk != NULL )
+    {
+        pChunk = pChannel->pFirstChunk;
+        pChannel->pFirstChunk = pChunk->pNext;
+        _releaseChunk( pChannel, pChunk );
+    }
+
+    pChannel->pLastChunk = NULL;
+    pChannel->chunkOffset = 0;
+    _deleteChannelBuffer( &pChannel->lotBuffer );
+    pChannel->pReceiveBuffer = NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _fillSendBuffer( IotBleDataTransferChannel_t * pChannel )
+{
+    IotBleDataChannelBuffer_t * pSendBuffer = &pChannel->sendBuffer;
+    size_t length = pSendBuffer->bufferLength - ( pSendBuffer->head - pSendBuffer->tail );
+    size_t offset, firstLength;
+
+    if( length > pChannel->sendPendingLength )
+    {
+        length = pChannel->sendPendingLength;
+    }
+
+    if( length > 0 )
+    {
+        /* head and tail run freely, the position in the ring is taken modulo its length. */
+        offset = pSendBuffer->head % pSendBuffer->bufferLength;
+        firstLength = pSendBuffer->bufferLength - offset;
+
+        if( firstLength > length )
+        {
+            firstLength = length;
+        }
+
+        memcpy( ( pSendBuffer->pBuffer + offset ), pChannel->pSendPending, firstLength );
+        memcpy( pSendBuffer->pBuffer, ( pChannel->pSendPending + firstLength ), ( length - firstLength ) );
+
+        pSendBuffer->head += length;
+        pChannel->pSendPending += length;
+        pChannel->sendPendingLength -= length;
+
+        IotSemaphore_Post( &pChannel->sendProgress );
+    }
+}
+
+/*-----------------------------------------------------------*/
 
 static void _deleteChannelBuffer( IotBleDataChannelBuffer_t * pChannelBuffer )
 {
@@ -607,8 +811,10 @@ static void _TXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam )
     };
 
     IotBleDataTransferService_t * pService;
-    size_t length;
+    IotBleDataChannelBuffer_t * pSendBuffer;
+    size_t length, offset, wrapLength;
     BTStatus_t status;
+    bool sendComplete = false;
 
     if( pEventParam->xEventType == eBLERead )
     {
@@ -618,39 +824,70 @@ static void _TXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam )
 
         if( pService->channel.isOpen == true )
         {
-            length = ( pService->channel.sendBuffer.head - pService->channel.sendBuffer.tail );
+            pSendBuffer = &pService->channel.sendBuffer;
+
+            IotMutex_Lock( &pService->channel.sendLock );
+
+            /* Top up the ring with the part of the message still held by the sender. */
+            _fillSendBuffer( &pService->channel );
+
+            length = ( pSendBuffer->head - pSendBuffer->tail );
 
             if( length > transmitLength )
             {
                 length = transmitLength;
             }
 
-            attrData.pData = ( pService->channel.sendBuffer.pBuffer + pService->channel.sendBuffer.tail );
+            if( length > 0 )
+            {
+                offset = pSendBuffer->tail % pSendBuffer->bufferLength;
+
+                /* Copy the wrapped part of the chunk after the end of the ring, so the response is contiguous. */
+                if( ( offset + length ) > pSendBuffer->bufferLength )
+                {
+                    wrapLength = ( offset + length ) - pSendBuffer->bufferLength;
+                    memcpy( ( pSendBuffer->pBuffer + pSendBuffer->bufferLength ), pSendBuffer->pBuffer, wrapLength );
+                }
+
+                attrData.pData = ( pSendBuffer->pBuffer + offset );
+            }
+
             attrData.size = length;
 
             status = IotBle_SendResponse( &resp, pEventParam->pParamRead->connId, pEventParam->pParamRead->transId );
 
             if( status == eBTStatusSuccess )
             {
-                pService->channel.sendBuffer.tail += length;
+                pSendBuffer->tail += length;
 
                 if( length < transmitLength )
                 {
-                    pService->channel.sendBuffer.head = pService->channel.sendBuffer.tail = 0;
-                    IotSemaphore_Post( &pService->channel.sendComplete );
-
-                    if( pService->channel.callback != NULL )
-                    {
-                        pService->channel.callback( IOT_BLE_DATA_TRANSFER_CHANNEL_DATA_SENT,
-                                                    &pService->channel,
-                                                    pService->channel.pContext );
-                    }
+                    pSendBuffer->head = pSendBuffer->tail = 0;
+                    sendComplete = true;
+                }
+                else
+                {
+                    _fillSendBuffer( &pService->channel );
                 }
             }
             else
             {
                 IotLogError( "Failed to send large object chunk through ble connection" );
             }
+
+            IotMutex_Unlock( &pService->channel.sendLock );
+
+            if( sendComplete == true )
+            {
+                IotSemaphore_Post( &pService->channel.sendComplete );
+
+                if( pService->channel.callback != NULL )
+                {
+                    pService->channel.callback( IOT_BLE_DATA_TRANSFER_CHANNEL_DATA_SENT,
+                                                &pService->channel,
+                                                pService->channel.pContext );
+                }
+            }
         }
         else
         {
@@ -683,20 +920,15 @@ static void _RXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam )
         if( ( pService != NULL ) &&
             ( pService->channel.isOpen ) )
         {
-            status = _resizeChannelBuffer( &pService->channel.lotBuffer, IOT_BLE_DATA_TRANSFER_RX_BUFFER_SIZE, pEventParam->pParamWrite->length );
+            status = _appendReceivedData( &pService->channel,
+                                          pEventParam->pParamWrite->pValue,
+                                          pEventParam->pParamWrite->length );
 
             if( status == true )
             {
-                /* Copy the received data into the buffer. */
-                memcpy( ( pService->channel.lotBuffer.pBuffer + pService->channel.lotBuffer.head ),
-                        pEventParam->pParamWrite->pValue,
-                        pEventParam->pParamWrite->length );
-
-                pService->channel.lotBuffer.head += pEventParam->pParamWrite->length;
-
                 if( pEventParam->pParamWrite->length < transmitLength )
                 {
-                    /* All chunks for large object transfer received. */
+                    /* All chunks for large object transfer received. The message is read out of the chunk list. */
                     pService->channel.pReceiveBuffer = &pService->channel.lotBuffer;
 
                     if( pService->channel.callback != NULL )
@@ -705,6 +937,9 @@ static void _RXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam )
                                                     &pService->channel,
                                                     pService->channel.pContext );
                     }
+
+                    /* Data is only readable from the callback, drop what was not read. */
+                    _flushReceivedData( &pService->channel );
                 }
 
                 resp.eventStatus = eBTStatusSuccess;
@@ -712,6 +947,9 @@ static void _RXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam )
             else
             {
                 IotLogError( "RX failed, unable to allocate buffer to read data" );
+
+                /* Drop the partial large object, so that the next one starts from an empty list. */
+                _flushReceivedData( &pService->channel );
             }
         }
 
@@ -760,6 +998,9 @@ static void _RXMesgCharCallback( IotBleAttributeEvent_t * pEventParam )
                                             pService->channel.pContext );
             }
 
+            /* The received value is only valid during the callback. */
+            pService->channel.pReceiveBuffer = NULL;
+
             resp.eventStatus = eBTStatusSuccess;
         }
 
@@ -940,6 +1181,29 @@ static bool _initializeChannel( IotBleDataTransferChannel_t * pChannel )
         IotLogError( "Failed to create semaphore for send buffer." );
     }
 
+    if( ret == true )
+    {
+        ret = IotSemaphore_Create( &pChannel->sendProgress, 0, 1 );
+
+        if( ret == false )
+        {
+            IotLogError( "Failed to create semaphore for send progress." );
+            IotSemaphore_Destroy( &pChannel->sendComplete );
+        }
+    }
+
+    if( ret == true )
+    {
+        ret = IotMutex_Create( &pChannel->sendLock, false );
+
+        if( ret == false )
+        {
+            IotLogError( "Failed to create lock for send buffer." );
+            IotSemaphore_Destroy( &pChannel->sendProgress );
+            IotSemaphore_Destroy( &pChannel->sendComplete );
+        }
+    }
+
     return ret;
 }
 
@@ -1044,10 +1308,17 @@ void IotBleDataTransfer_Close( IotBleDataTransferChannel_t * pChannel )
 
     /* Nobody writes/reads from send buffer after timeout value. */
     ( void ) IotSemaphore_TimedWait( &pChannel->sendComplete, pChannel->timeout );
+    IotMutex_Lock( &pChannel->sendLock );
     _deleteChannelBuffer( &pChannel->sendBuffer );
+    IotMutex_Unlock( &pChannel->sendLock );
     IotSemaphore_Post( &pChannel->sendComplete );
-    _deleteChannelBuffer( &pChannel->lotBuffer );
-    pChannel->pReceiveBuffer = NULL;
+    _flushReceivedData( pChannel );
+
+    if( pChannel->pSpareChunk != NULL )
+    {
+        IotBle_Free( pChannel->pSpareChunk );
+        pChannel->pSpareChunk = NULL;
+    }
 
     if( pChannel->callback != NULL )
     {
@@ -1067,23 +1338,38 @@ size_t IotBleDataTransfer_Receive( IotBleDataTransferChannel_t * pChannel,
                                    uint8_t * pBuffer,
                                    size_t bytesRequested )
 {
-    size_t bytesReturned = pChannel->pReceiveBuffer->head - pChannel->pReceiveBuffer->tail;
+    size_t bytesReturned = 0;
 
-    if( bytesReturned > bytesRequested )
+    if( pChannel->pReceiveBuffer == NULL )
     {
-        bytesReturned = bytesRequested;
+        IotLogDebug( "No data received on the channel." );
     }
-
-    if( pBuffer != NULL )
+    else if( ( pChannel->pReceiveBuffer == &pChannel->lotBuffer ) &&
+             ( pChannel->lotBuffer.pBuffer == NULL ) )
     {
-        memcpy( pBuffer, ( pChannel->pReceiveBuffer->pBuffer + pChannel->pReceiveBuffer->tail ), bytesReturned );
+        /* Large object not peeked, stream it out of the chunk list. */
+        bytesReturned = _receiveFromChunks( pChannel, pBuffer, bytesRequested );
     }
+    else
+    {
+        bytesReturned = pChannel->pReceiveBuffer->head - pChannel->pReceiveBuffer->tail;
 
-    pChannel->pReceiveBuffer->tail += bytesReturned;
+        if( bytesReturned > bytesRequested )
+        {
+            bytesReturned = bytesRequested;
+        }
 
-    if( pChannel->pReceiveBuffer->tail == pChannel->pReceiveBuffer->head )
-    {
-        pChannel->pReceiveBuffer->head = pChannel->pReceiveBuffer->tail = 0;
+        if( pBuffer != NULL )
+        {
+            memcpy( pBuffer, ( pChannel->pReceiveBuffer->pBuffer + pChannel->pReceiveBuffer->tail ), bytesReturned );
+        }
+
+        pChannel->pReceiveBuffer->tail += bytesReturned;
+
+        if( pChannel->pReceiveBuffer->tail == pChannel->pReceiveBuffer->head )
+        {
+            pChannel->pReceiveBuffer->head = pChannel->pReceiveBuffer->tail = 0;
+        }
     }
 
     return bytesReturned;
@@ -1095,15 +1381,36 @@ void IotBleDataTransfer_PeekReceiveBuffer( IotBleDataTransferChannel_t * pChanne
                                            const uint8_t ** pBuffer,
                                            size_t * pBufferLength )
 {
-    if( pChannel->pReceiveBuffer != NULL )
+    *pBuffer = NULL;
+    *pBufferLength = 0;
+
+    if( ( pChannel->pReceiveBuffer == &pChannel->lotBuffer ) &&
+        ( pChannel->lotBuffer.pBuffer == NULL ) )
     {
-        *pBuffer = ( pChannel->pReceiveBuffer->pBuffer + pChannel->pReceiveBuffer->tail );
-        *pBufferLength = ( pChannel->pReceiveBuffer->head - pChannel->pReceiveBuffer->tail );
+        if( pChannel->pFirstChunk == NULL )
+        {
+            IotLogDebug( "Large object received is empty." );
+        }
+        else if( pChannel->pFirstChunk->pNext == NULL )
+        {
+            /* Message fits in a single chunk, return it in place. */
+            *pBuffer = &pChannel->pFirstChunk->data[ pChannel->chunkOffset ];
+            *pBufferLength = pChannel->pFirstChunk->length - pChannel->chunkOffset;
+        }
+        else if( _coalesceChunks( pChannel ) == true )
+        {
+            *pBuffer = pChannel->lotBuffer.pBuffer;
+            *pBufferLength = pChannel->lotBuffer.head;
+        }
+        else
+        {
+            IotLogError( "Failed to peek the large object received." );
+        }
     }
-    else
+    else if( pChannel->pReceiveBuffer != NULL )
     {
-        *pBuffer = NULL;
-        *pBufferLength = 0;
+        *pBuffer = ( pChannel->pReceiveBuffer->pBuffer + pChannel->pReceiveBuffer->tail );
+        *pBufferLength = ( pChannel->pReceiveBuffer->head - pChannel->pReceiveBuffer->tail );
     }
 }
 
@@ -1113,8 +1420,9 @@ size_t IotBleDataTransfer_Send( IotBleDataTransferChannel_t * pChannel,
                                 const uint8_t * const pMessage,
                                 size_t messageLength )
 {
-    uint8_t * pData;
     size_t remainingLength = messageLength;
+    bool sendStarted = false;
+    bool progress;
 
     if( pChannel->isOpen )
     {
@@ -1142,29 +1450,80 @@ size_t IotBleDataTransfer_Send( IotBleDataTransferChannel_t * pChannel,
              */
             if( IotSemaphore_TimedWait( &pChannel->sendComplete, pChannel->timeout ) == true )
             {
-                if( _send( pChannel, true, ( uint8_t * ) pMessage, transmitLength ) == true )
+                IotMutex_Lock( &pChannel->sendLock );
+
+                if( ( messageLength > transmitLength ) && ( pChannel->sendBuffer.pBuffer == NULL ) )
                 {
-                    remainingLength -= transmitLength;
+                    pChannel->sendBuffer.pBuffer = IotBle_Malloc( IOT_BLE_DATA_TRANSFER_TX_BUFFER_SIZE + _SEND_BUFFER_MIRROR_LENGTH );
 
-                    if( remainingLength > 0 )
+                    if( pChannel->sendBuffer.pBuffer != NULL )
                     {
-                        if( _resizeChannelBuffer( &pChannel->sendBuffer, IOT_BLE_DATA_TRANSFER_TX_BUFFER_SIZE, remainingLength ) == true )
-                        {
-                            memcpy( pChannel->sendBuffer.pBuffer, ( pMessage + transmitLength ), remainingLength );
-                            pChannel->sendBuffer.head += remainingLength;
-                            remainingLength = 0;
-                        }
-                        else
-                        {
-                            IotLogError( "TX Failed, Failed to allocate send buffer." );
-                            IotSemaphore_Post( &pChannel->sendComplete );
-                        }
+                        pChannel->sendBuffer.bufferLength = IOT_BLE_DATA_TRANSFER_TX_BUFFER_SIZE;
                     }
                 }
-                else
+
+                if( ( messageLength == transmitLength ) || ( pChannel->sendBuffer.pBuffer != NULL ) )
+                {
+                    /* Queue the rest of the message before the first chunk is notified, the peer reads it from the ring. */
+                    pChannel->sendBuffer.head = pChannel->sendBuffer.tail = 0;
+                    pChannel->pSendPending = ( pMessage + transmitLength );
+                    pChannel->sendPendingLength = ( messageLength - transmitLength );
+                    _fillSendBuffer( pChannel );
+                    sendStarted = true;
+                }
+
+                IotMutex_Unlock( &pChannel->sendLock );
+
+                if( sendStarted == false )
+                {
+                    IotLogError( "TX Failed, Failed to allocate send buffer." );
+                    IotSemaphore_Post( &pChannel->sendComplete );
+                }
+                else if( _send( pChannel, true, ( uint8_t * ) pMessage, transmitLength ) == false )
                 {
                     IotLogError( "TX Failed, GATT notification failed." );
+
+                    IotMutex_Lock( &pChannel->sendLock );
+                    pChannel->sendBuffer.head = pChannel->sendBuffer.tail = 0;
+                    pChannel->pSendPending = NULL;
+                    pChannel->sendPendingLength = 0;
+                    IotMutex_Unlock( &pChannel->sendLock );
+
                     IotSemaphore_Post( &pChannel->sendComplete );
+                    sendStarted = false;
+                }
+                else
+                {
+                    IotMutex_Lock( &pChannel->sendLock );
+                    remainingLength = pChannel->sendPendingLength;
+                    IotMutex_Unlock( &pChannel->sendLock );
+                }
+
+                /* Wait until the part which does not fit in the ring has been moved into it. */
+                while( ( sendStarted == true ) && ( remainingLength > 0 ) )
+                {
+                    progress = IotSemaphore_TimedWait( &pChannel->sendProgress, pChannel->timeout );
+
+                    IotMutex_Lock( &pChannel->sendLock );
+
+                    if( ( progress == false ) && ( pChannel->sendPendingLength == remainingLength ) )
+                    {
+                        /* No read from the peer within the timeout, stop sending the message. */
+                        pChannel->pSendPending = NULL;
+                        pChannel->sendPendingLength = 0;
+                        sendStarted = false;
+                    }
+                    else
+                    {
+                        remainingLength = pChannel->sendPendingLength;
+                    }
+
+                    IotMutex_Unlock( &pChannel->sendLock );
+
+                    if( sendStarted == false )
+                    {
+                        IotLogError( "TX Failed, channel timed out with %d bytes pending.", remainingLength );
+                    }
                 }
             }
             else
@@ -1180,3 +1539,8 @@ size_t IotBleDataTransfer_Send( IotBleDataTransferChannel_t * pChannel,
 
     return( messageLength - remainingLength );
 }
+
+/* Provide access to private members for testing. */
+#ifdef AMAZON_FREERTOS_ENABLE_UNIT_TESTS
+    #include "iot_ble_data_transfer_test_access_define.h"
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Amazon FreeRTOS BLE V2.0.0
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file iot_ble_data_transfer_test_access_declare.h
+ * @brief Declarations for functions that access private methods in iot_ble_data_transfer.c
+ *
+ * Required to test the private methods in iot_ble_data_transfer.c
+ */
+
+#ifndef IOT_BLE_DATA_TRANSFER_TEST_ACCESS_DECLARE_H_
+#define IOT_BLE_DATA_TRANSFER_TEST_ACCESS_DECLARE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "iot_ble.h"
+
+
+void test_ControlCharCallback( IotBleAttributeEvent_t * pEventParam );
+
+void test_TXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam );
+
+void test_RXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam );
+
+uint16_t test_GetServiceHandle( uint8_t serviceIdentifier );
+
+size_t test_SetTransmitLength( size_t length );
+
+BTGattServerInterface_t * test_SetGattServerInterface( BTGattServerInterface_t * pInterface );
+
+#endif /* IOT_BLE_DATA_TRANSFER_TEST_ACCESS_DECLARE_H_ */
@@ -0,0 +1,87 @@
+/*
+ * Amazon FreeRTOS BLE V2.0.0
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file iot_ble_data_transfer_test_access_define.h
+ * @brief Definitions for functions that access private methods in iot_ble_data_transfer.c
+ *
+ * Required to test the private methods in iot_ble_data_transfer.c
+ */
+#ifndef IOT_BLE_DATA_TRANSFER_TEST_ACCESS_DEFINE_H_
+#define IOT_BLE_DATA_TRANSFER_TEST_ACCESS_DEFINE_H_
+
+#include "iot_ble_internal.h"
+
+void test_ControlCharCallback( IotBleAttributeEvent_t * pEventParam )
+{
+    _ControlCharCallback( pEventParam );
+}
+
+void test_TXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam )
+{
+    _TXLargeMesgCharCallback( pEventParam );
+}
+
+void test_RXLargeMesgCharCallback( IotBleAttributeEvent_t * pEventParam )
+{
+    _RXLargeMesgCharCallback( pEventParam );
+}
+
+uint16_t test_GetServiceHandle( uint8_t serviceIdentifier )
+{
+    uint16_t handle = 0;
+    uint8_t id;
+
+    for( id = 0; id < _numDataTransferServices; id++ )
+    {
+        if( _services[ id ].identifier == serviceIdentifier )
+        {
+            handle = _services[ id ].handles[ IOT_BLE_DATA_TRANSFER_CONTROL_CHAR ];
+            break;
+        }
+    }
+
+    return handle;
+}
+
+size_t test_SetTransmitLength( size_t length )
+{
+    size_t previousLength = transmitLength;
+
+    transmitLength = length;
+
+    return previousLength;
+}
+
+BTGattServerInterface_t * test_SetGattServerInterface( BTGattServerInterface_t * pInterface )
+{
+    BTGattServerInterface_t * pPreviousInterface = _BTInterface.pGattServerInterface;
+
+    _BTInterface.pGattServerInterface = pInterface;
+
+    return pPreviousInterface;
+}
+
+#endif /* IOT_BLE_DATA_TRANSFER_TEST_ACCESS_DEFINE_H_ */
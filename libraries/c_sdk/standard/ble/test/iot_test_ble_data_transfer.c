@@ -0,0 +1,373 @@
+/*
+ * Amazon FreeRTOS BLE V2.0.0
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file iot_test_ble_data_transfer.c
+ * @brief Throughput tests for the BLE data transfer channel, run against a mock GATT server.
+ */
+
+#include "iot_config.h"
+
+/* C standard library includes. */
+#include <stddef.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "iot_ble.h"
+#include "iot_ble_data_transfer.h"
+#include "iot_ble_data_transfer_test_access_declare.h"
+#include "platform/iot_clock.h"
+#include "platform/iot_threads.h"
+
+/* Test framework includes. */
+#include "unity_fixture.h"
+#include "unity.h"
+
+/**
+ * @brief Length of the large objects sent and received by the tests.
+ */
+#define testDATA_TRANSFER_MESSAGE_LENGTH     ( 4096 )
+
+/**
+ * @brief Number of large objects transferred in each test.
+ */
+#define testDATA_TRANSFER_ITERATIONS         ( 64 )
+
+/**
+ * @brief Transmit length used by the tests, the payload of a 185 bytes MTU.
+ */
+#define testDATA_TRANSFER_TRANSMIT_LENGTH    ( 182 )
+
+/**
+ * @brief Time to wait for a send to complete.
+ */
+#define testDATA_TRANSFER_TIMEOUT_MS         ( 5000 )
+
+/*-----------------------------------------------------------*/
+
+static BTStatus_t prvSendIndication( uint8_t ucServerIf,
+                                     uint16_t usAttributeHandle,
+                                     uint16_t usConnId,
+                                     size_t xLen,
+                                     uint8_t * pucValue,
+                                     bool bConfirm );
+
+static BTStatus_t prvSendResponse( uint16_t usConnId,
+                                   uint32_t ulTransId,
+                                   BTStatus_t xStatus,
+                                   BTGattResponse_t * pxResponse );
+
+static void prvChannelCallback( IotBleDataTransferChannelEvent_t event,
+                                IotBleDataTransferChannel_t * pChannel,
+                                void * pContext );
+
+static void prvSendThread( void * pArgument );
+
+static void prvWriteControl( uint8_t value );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Mock GATT server, captures the data sent through notifications and read responses.
+ */
+static BTGattServerInterface_t xMockGattServerInterface =
+{
+    .pxSendIndication = prvSendIndication,
+    .pxSendResponse   = prvSendResponse
+};
+
+static BTGattServerInterface_t * pxSavedGattServerInterface = NULL;
+static size_t xSavedTransmitLength;
+static IotBleDataTransferChannel_t * pxChannel = NULL;
+static IotSemaphore_t xIndicationSent;
+static IotSemaphore_t xSendDone;
+
+static uint8_t ucMessage[ testDATA_TRANSFER_MESSAGE_LENGTH ];
+static uint8_t ucReceivedMessage[ testDATA_TRANSFER_MESSAGE_LENGTH ];
+static size_t xReceivedLength = 0;
+static size_t xLastResponseLength = 0;
+static size_t xBytesSent = 0;
+static bool bCaptureResponses = false;
+static bool bBLEInitialized = false;
+
+extern bool IotTestNetwork_SelectNetworkType( uint16_t networkType );
+
+/*-----------------------------------------------------------*/
+
+static BTStatus_t prvSendIndication( uint8_t ucServerIf,
+                                     uint16_t usAttributeHandle,
+                                     uint16_t usConnId,
+                                     size_t xLen,
+                                     uint8_t * pucValue,
+                                     bool bConfirm )
+{
+    ( void ) ucServerIf;
+    ( void ) usAttributeHandle;
+    ( void ) usConnId;
+    ( void ) bConfirm;
+
+    if( ( xReceivedLength + xLen ) <= sizeof( ucReceivedMessage ) )
+    {
+        memcpy( &ucReceivedMessage[ xReceivedLength ], pucValue, xLen );
+        xReceivedLength += xLen;
+    }
+
+    IotSemaphore_Post( &xIndicationSent );
+
+    return eBTStatusSuccess;
+}
+
+/*-----------------------------------------------------------*/
+
+static BTStatus_t prvSendResponse( uint16_t usConnId,
+                                   uint32_t ulTransId,
+                                   BTStatus_t xStatus,
+                                   BTGattResponse_t * pxResponse )
+{
+    ( void ) usConnId;
+    ( void ) ulTransId;
+    ( void ) xStatus;
+
+    if( bCaptureResponses == true )
+    {
+        xLastResponseLength = pxResponse->xAttrValue.xLen;
+
+        if( ( xLastResponseLength > 0 ) &&
+            ( ( xReceivedLength + xLastResponseLength ) <= sizeof( ucReceivedMessage ) ) )
+        {
+            memcpy( &ucReceivedMessage[ xReceivedLength ], pxResponse->xAttrValue.pucValue, xLastResponseLength );
+            xReceivedLength += xLastResponseLength;
+        }
+    }
+
+    return eBTStatusSuccess;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvChannelCallback( IotBleDataTransferChannelEvent_t event,
+                                IotBleDataTransferChannel_t * pChannel,
+                                void * pContext )
+{
+    size_t xBytesRead;
+
+    ( void ) pContext;
+
+    if( event == IOT_BLE_DATA_TRANSFER_CHANNEL_DATA_RECEIVED )
+    {
+        /* Read in small steps, the way the MQTT deserializer does. */
+        do
+        {
+            xBytesRead = IotBleDataTransfer_Receive( pChannel,
+                                                     &ucReceivedMessage[ xReceivedLength ],
+                                                     sizeof( ucReceivedMessage ) - xReceivedLength );
+            xReceivedLength += xBytesRead;
+        } while( xBytesRead > 0 );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvSendThread( void * pArgument )
+{
+    ( void ) pArgument;
+
+    xBytesSent = IotBleDataTransfer_Send( pxChannel, ucMessage, sizeof( ucMessage ) );
+    IotSemaphore_Post( &xSendDone );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvWriteControl( uint8_t value )
+{
+    IotBleWriteEventParams_t xWriteParam = { 0 };
+    IotBleAttributeEvent_t xEvent;
+
+    xWriteParam.attrHandle = test_GetServiceHandle( IOT_BLE_DATA_TRANSFER_SERVICE_TYPE_MQTT );
+    xWriteParam.pValue = &value;
+    xWriteParam.length = 1;
+    xEvent.pParamWrite = &xWriteParam;
+    xEvent.xEventType = eBLEWriteNoResponse;
+
+    test_ControlCharCallback( &xEvent );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_BLE_DATA_TRANSFER );
+
+/*-----------------------------------------------------------*/
+
+TEST_SETUP( Full_BLE_DATA_TRANSFER )
+{
+    size_t xIndex;
+
+    TEST_ASSERT_MESSAGE( bBLEInitialized, "BLE Not initialized" );
+
+    for( xIndex = 0; xIndex < sizeof( ucMessage ); xIndex++ )
+    {
+        ucMessage[ xIndex ] = ( uint8_t ) ( xIndex * 31 );
+    }
+
+    TEST_ASSERT_TRUE( IotSemaphore_Create( &xIndicationSent, 0, 1 ) );
+    TEST_ASSERT_TRUE( IotSemaphore_Create( &xSendDone, 0, 1 ) );
+
+    pxSavedGattServerInterface = test_SetGattServerInterface( &xMockGattServerInterface );
+    xSavedTransmitLength = test_SetTransmitLength( testDATA_TRANSFER_TRANSMIT_LENGTH );
+
+    pxChannel = IotBleDataTransfer_Open( IOT_BLE_DATA_TRANSFER_SERVICE_TYPE_MQTT );
+    TEST_ASSERT_NOT_NULL( pxChannel );
+    TEST_ASSERT_TRUE( IotBleDataTransfer_SetCallback( pxChannel, prvChannelCallback, NULL ) );
+
+    /* Open the channel the way the peer does, through the control characteristic. */
+    prvWriteControl( 1 );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST_TEAR_DOWN( Full_BLE_DATA_TRANSFER )
+{
+    if( pxChannel != NULL )
+    {
+        prvWriteControl( 0 );
+        IotBleDataTransfer_Close( pxChannel );
+        IotBleDataTransfer_Reset( pxChannel );
+        pxChannel = NULL;
+    }
+
+    ( void ) test_SetTransmitLength( xSavedTransmitLength );
+    ( void ) test_SetGattServerInterface( pxSavedGattServerInterface );
+
+    IotSemaphore_Destroy( &xSendDone );
+    IotSemaphore_Destroy( &xIndicationSent );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST_GROUP_RUNNER( Full_BLE_DATA_TRANSFER )
+{
+    /* The data transfer services are created when the BLE stack is initialized. */
+    bBLEInitialized = IotTestNetwork_SelectNetworkType( AWSIOT_NETWORK_TYPE_BLE );
+
+    RUN_TEST_CASE( Full_BLE_DATA_TRANSFER, ReceiveLargeObjectThroughput );
+    RUN_TEST_CASE( Full_BLE_DATA_TRANSFER, SendLargeObjectThroughput );
+
+    /* Revert to sockets network interface after this test is finished. */
+    IotTestNetwork_SelectNetworkType( DEFAULT_NETWORK );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_BLE_DATA_TRANSFER, ReceiveLargeObjectThroughput )
+{
+    IotBleWriteEventParams_t xWriteParam = { 0 };
+    IotBleAttributeEvent_t xEvent;
+    uint64_t ullStartTime, ullElapsedTime;
+    size_t xOffset;
+    uint32_t ulIteration;
+
+    xWriteParam.attrHandle = test_GetServiceHandle( IOT_BLE_DATA_TRANSFER_SERVICE_TYPE_MQTT );
+    xEvent.pParamWrite = &xWriteParam;
+    xEvent.xEventType = eBLEWriteNoResponse;
+
+    ullStartTime = IotClock_GetTimeMs();
+
+    for( ulIteration = 0; ulIteration < testDATA_TRANSFER_ITERATIONS; ulIteration++ )
+    {
+        xReceivedLength = 0;
+
+        /* The peer ends a large object with a write shorter than the transmit length, possibly empty. */
+        for( xOffset = 0; xOffset <= sizeof( ucMessage ); xOffset += testDATA_TRANSFER_TRANSMIT_LENGTH )
+        {
+            xWriteParam.pValue = &ucMessage[ xOffset ];
+            xWriteParam.length = sizeof( ucMessage ) - xOffset;
+
+            if( xWriteParam.length > testDATA_TRANSFER_TRANSMIT_LENGTH )
+            {
+                xWriteParam.length = testDATA_TRANSFER_TRANSMIT_LENGTH;
+            }
+
+            test_RXLargeMesgCharCallback( &xEvent );
+        }
+
+        TEST_ASSERT_EQUAL( sizeof( ucMessage ), xReceivedLength );
+        TEST_ASSERT_EQUAL_MEMORY( ucMessage, ucReceivedMessage, sizeof( ucMessage ) );
+    }
+
+    ullElapsedTime = IotClock_GetTimeMs() - ullStartTime;
+
+    configPRINTF( ( "BLE data transfer receive of %u bytes: %u bytes/s\r\n",
+                    ( unsigned ) ( testDATA_TRANSFER_ITERATIONS * sizeof( ucMessage ) ),
+                    ( unsigned ) ( ( testDATA_TRANSFER_ITERATIONS * sizeof( ucMessage ) * 1000ULL ) /
+                                   ( ullElapsedTime + 1 ) ) ) );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_BLE_DATA_TRANSFER, SendLargeObjectThroughput )
+{
+    IotBleReadEventParams_t xReadParam = { 0 };
+    IotBleAttributeEvent_t xEvent;
+    uint64_t ullStartTime, ullElapsedTime;
+    uint32_t ulIteration;
+
+    xReadParam.attrHandle = test_GetServiceHandle( IOT_BLE_DATA_TRANSFER_SERVICE_TYPE_MQTT );
+    xEvent.pParamRead = &xReadParam;
+    xEvent.xEventType = eBLERead;
+
+    ullStartTime = IotClock_GetTimeMs();
+
+    for( ulIteration = 0; ulIteration < testDATA_TRANSFER_ITERATIONS; ulIteration++ )
+    {
+        xReceivedLength = 0;
+        bCaptureResponses = true;
+
+        TEST_ASSERT_TRUE( Iot_CreateDetachedThread( prvSendThread,
+                                                    NULL,
+                                                    IOT_THREAD_DEFAULT_PRIORITY,
+                                                    IOT_THREAD_DEFAULT_STACK_SIZE ) );
+
+        /* The first chunk is notified, the peer then reads until a short response. */
+        TEST_ASSERT_TRUE( IotSemaphore_TimedWait( &xIndicationSent, testDATA_TRANSFER_TIMEOUT_MS ) );
+
+        do
+        {
+            test_TXLargeMesgCharCallback( &xEvent );
+        } while( xLastResponseLength == testDATA_TRANSFER_TRANSMIT_LENGTH );
+
+        TEST_ASSERT_TRUE( IotSemaphore_TimedWait( &xSendDone, testDATA_TRANSFER_TIMEOUT_MS ) );
+        bCaptureResponses = false;
+
+        TEST_ASSERT_EQUAL( sizeof( ucMessage ), xBytesSent );
+        TEST_ASSERT_EQUAL( sizeof( ucMessage ), xReceivedLength );
+        TEST_ASSERT_EQUAL_MEMORY( ucMessage, ucReceivedMessage, sizeof( ucMessage ) );
+    }
+
+    ullElapsedTime = IotClock_GetTimeMs() - ullStartTime;
+
+    configPRINTF( ( "BLE data transfer send of %u bytes: %u bytes/s\r\n",
+                    ( unsigned ) ( testDATA_TRANSFER_ITERATIONS * sizeof( ucMessage ) ),
+                    ( unsigned ) ( ( testDATA_TRANSFER_ITERATIONS * sizeof( ucMessage ) * 1000ULL ) /
+                                   ( ullElapsedTime + 1 ) ) ) );
+}
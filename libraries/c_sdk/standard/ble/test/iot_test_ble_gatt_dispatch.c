@@ -0,0 +1,295 @@
+/*
+ * Amazon FreeRTOS BLE V2.0.0
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file iot_test_ble_gatt_dispatch.c
+ * @brief Benchmark of the GATT event dispatch by attribute handle, run against a mock GATT server.
+ */
+
+#include "iot_config.h"
+
+/* C standard library includes. */
+#include <stddef.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "platform/iot_clock.h"
+#include "platform/iot_threads.h"
+#include "iot_ble.h"
+#include "iot_ble_internal.h"
+
+/* Test framework includes. */
+#include "unity_fixture.h"
+#include "unity.h"
+
+/**
+ * @brief Number of services registered by the test, on top of the ones of the application.
+ */
+#define testGATT_DISPATCH_SERVICES          ( 6 )
+
+/**
+ * @brief Number of attributes of each service, including the service declaration.
+ */
+#define testGATT_DISPATCH_ATTRIBUTES        ( 12 )
+
+/**
+ * @brief Number of times every attribute is read.
+ */
+#define testGATT_DISPATCH_ITERATIONS        ( 2000 )
+
+/**
+ * @brief First handle given by the mock GATT server, away from the handles of the real services.
+ */
+#define testGATT_DISPATCH_FIRST_HANDLE      ( 0xF000 )
+
+/*-----------------------------------------------------------*/
+
+static BTStatus_t prvAddServiceBlob( uint8_t ucServerIf,
+                                     BTService_t * pxService );
+
+static BTStatus_t prvStopService( uint8_t ucServerIf,
+                                  uint16_t usServiceHandle );
+
+static BTStatus_t prvDeleteService( uint8_t ucServerIf,
+                                    uint16_t usServiceHandle );
+
+static void prvAttributeCallback( IotBleAttributeEvent_t * pEventParam );
+
+/*-----------------------------------------------------------*/
+
+extern bool IotTestNetwork_SelectNetworkType( uint16_t networkType );
+
+/**
+ * @brief Mock GATT server, gives consecutive handles to the attributes of the services.
+ */
+static BTGattServerInterface_t xMockGattServerInterface =
+{
+    .pxAddServiceBlob = prvAddServiceBlob,
+    .pxStopService    = prvStopService,
+    .pxDeleteService  = prvDeleteService
+};
+
+static BTGattServerInterface_t * pxSavedGattServerInterface = NULL;
+static bool bBLEInitialized = false;
+static uint16_t usNextHandle;
+
+static BTAttribute_t xAttributes[ testGATT_DISPATCH_ATTRIBUTES ];
+static IotBleAttributeEventCallback_t xCallbacks[ testGATT_DISPATCH_ATTRIBUTES ];
+static uint16_t usHandles[ testGATT_DISPATCH_SERVICES ][ testGATT_DISPATCH_ATTRIBUTES ];
+static BTService_t xServices[ testGATT_DISPATCH_SERVICES ];
+static bool bServiceCreated[ testGATT_DISPATCH_SERVICES ];
+
+static uint16_t usLastHandle;
+static uint32_t ulDispatchCount;
+
+/*-----------------------------------------------------------*/
+
+static BTStatus_t prvAddServiceBlob( uint8_t ucServerIf,
+                                     BTService_t * pxService )
+{
+    size_t xIndex;
+
+    ( void ) ucServerIf;
+
+    for( xIndex = 0; xIndex < pxService->xNumberOfAttributes; xIndex++ )
+    {
+        pxService->pusHandlesBuffer[ xIndex ] = usNextHandle++;
+    }
+
+    return eBTStatusSuccess;
+}
+
+/*-----------------------------------------------------------*/
+
+static BTStatus_t prvStopService( uint8_t ucServerIf,
+                                  uint16_t usServiceHandle )
+{
+    _BTGattServerCb.pxServiceStoppedCb( eBTStatusSuccess, ucServerIf, usServiceHandle );
+
+    return eBTStatusSuccess;
+}
+
+/*-----------------------------------------------------------*/
+
+static BTStatus_t prvDeleteService( uint8_t ucServerIf,
+                                    uint16_t usServiceHandle )
+{
+    _BTGattServerCb.pxServiceDeletedCb( eBTStatusSuccess, ucServerIf, usServiceHandle );
+
+    return eBTStatusSuccess;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvAttributeCallback( IotBleAttributeEvent_t * pEventParam )
+{
+    usLastHandle = pEventParam->pParamRead->attrHandle;
+    ulDispatchCount++;
+}
+
+/*-----------------------------------------------------------*/
+
+TEST_GROUP( Full_BLE_GATT_DISPATCH );
+
+/*-----------------------------------------------------------*/
+
+TEST_SETUP( Full_BLE_GATT_DISPATCH )
+{
+    size_t xIndex;
+
+    TEST_ASSERT_MESSAGE( bBLEInitialized, "BLE Not initialized" );
+
+    pxSavedGattServerInterface = _BTInterface.pGattServerInterface;
+    _BTInterface.pGattServerInterface = &xMockGattServerInterface;
+    usNextHandle = testGATT_DISPATCH_FIRST_HANDLE;
+
+    xAttributes[ 0 ].xAttributeType = eBTDbPrimaryService;
+    xCallbacks[ 0 ] = NULL;
+
+    for( xIndex = 1; xIndex < testGATT_DISPATCH_ATTRIBUTES; xIndex++ )
+    {
+        xAttributes[ xIndex ].xAttributeType = eBTDbCharacteristic;
+        xCallbacks[ xIndex ] = prvAttributeCallback;
+    }
+
+    for( xIndex = 0; xIndex < testGATT_DISPATCH_SERVICES; xIndex++ )
+    {
+        xServices[ xIndex ].xNumberOfAttributes = testGATT_DISPATCH_ATTRIBUTES;
+        xServices[ xIndex ].pusHandlesBuffer = usHandles[ xIndex ];
+        xServices[ xIndex ].pxBLEAttributes = xAttributes;
+
+        TEST_ASSERT_EQUAL( eBTStatusSuccess, IotBle_CreateService( &xServices[ xIndex ], xCallbacks ) );
+        bServiceCreated[ xIndex ] = true;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+TEST_TEAR_DOWN( Full_BLE_GATT_DISPATCH )
+{
+    size_t xIndex;
+
+    for( xIndex = 0; xIndex < testGATT_DISPATCH_SERVICES; xIndex++ )
+    {
+        if( bServiceCreated[ xIndex ] == true )
+        {
+            ( void ) IotBle_DeleteService( &xServices[ xIndex ] );
+            bServiceCreated[ xIndex ] = false;
+        }
+    }
+
+    if( pxSavedGattServerInterface != NULL )
+    {
+        _BTInterface.pGattServerInterface = pxSavedGattServerInterface;
+        pxSavedGattServerInterface = NULL;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+TEST_GROUP_RUNNER( Full_BLE_GATT_DISPATCH )
+{
+    /* The GATT server is registered when the BLE stack is initialized. */
+    bBLEInitialized = IotTestNetwork_SelectNetworkType( AWSIOT_NETWORK_TYPE_BLE );
+
+    RUN_TEST_CASE( Full_BLE_GATT_DISPATCH, DispatchByHandle );
+    RUN_TEST_CASE( Full_BLE_GATT_DISPATCH, DispatchAfterDelete );
+    RUN_TEST_CASE( Full_BLE_GATT_DISPATCH, ReadDispatchThroughput );
+
+    /* Revert to sockets network interface after this test is finished. */
+    IotTestNetwork_SelectNetworkType( DEFAULT_NETWORK );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_BLE_GATT_DISPATCH, DispatchByHandle )
+{
+    size_t xService, xAttribute;
+
+    for( xService = 0; xService < testGATT_DISPATCH_SERVICES; xService++ )
+    {
+        for( xAttribute = 1; xAttribute < testGATT_DISPATCH_ATTRIBUTES; xAttribute++ )
+        {
+            usLastHandle = 0;
+            _BTGattServerCb.pxRequestReadCb( 0, 0, NULL, usHandles[ xService ][ xAttribute ], 0 );
+            TEST_ASSERT_EQUAL( usHandles[ xService ][ xAttribute ], usLastHandle );
+        }
+    }
+
+    /* The service declaration has no callback and unknown handles are ignored. */
+    ulDispatchCount = 0;
+    _BTGattServerCb.pxRequestReadCb( 0, 0, NULL, usHandles[ 0 ][ 0 ], 0 );
+    _BTGattServerCb.pxRequestReadCb( 0, 0, NULL, usNextHandle, 0 );
+    TEST_ASSERT_EQUAL( 0, ulDispatchCount );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_BLE_GATT_DISPATCH, DispatchAfterDelete )
+{
+    uint16_t usDeletedHandle = usHandles[ 0 ][ 1 ];
+
+    TEST_ASSERT_EQUAL( eBTStatusSuccess, IotBle_DeleteService( &xServices[ 0 ] ) );
+    bServiceCreated[ 0 ] = false;
+
+    ulDispatchCount = 0;
+    _BTGattServerCb.pxRequestReadCb( 0, 0, NULL, usDeletedHandle, 0 );
+    TEST_ASSERT_EQUAL( 0, ulDispatchCount );
+
+    usLastHandle = 0;
+    _BTGattServerCb.pxRequestReadCb( 0, 0, NULL, usHandles[ 1 ][ 1 ], 0 );
+    TEST_ASSERT_EQUAL( usHandles[ 1 ][ 1 ], usLastHandle );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_BLE_GATT_DISPATCH, ReadDispatchThroughput )
+{
+    uint64_t ullStartTime, ullElapsedTime;
+    uint32_t ulIteration;
+    size_t xService, xAttribute;
+
+    ulDispatchCount = 0;
+    ullStartTime = IotClock_GetTimeMs();
+
+    for( ulIteration = 0; ulIteration < testGATT_DISPATCH_ITERATIONS; ulIteration++ )
+    {
+        for( xService = 0; xService < testGATT_DISPATCH_SERVICES; xService++ )
+        {
+            for( xAttribute = 1; xAttribute < testGATT_DISPATCH_ATTRIBUTES; xAttribute++ )
+            {
+                _BTGattServerCb.pxRequestReadCb( 0, ulIteration, NULL, usHandles[ xService ][ xAttribute ], 0 );
+            }
+        }
+    }
+
+    ullElapsedTime = IotClock_GetTimeMs() - ullStartTime;
+
+    TEST_ASSERT_EQUAL( testGATT_DISPATCH_ITERATIONS * testGATT_DISPATCH_SERVICES * ( testGATT_DISPATCH_ATTRIBUTES - 1 ),
+                       ulDispatchCount );
+
+    configPRINTF( ( "GATT read dispatch over %u services: %u events/s\r\n",
+                    ( unsigned ) testGATT_DISPATCH_SERVICES,
+                    ( unsigned ) ( ( ulDispatchCount * 1000ULL ) / ( ullElapsedTime + 1 ) ) ) );
+}
@@ -61,18 +61,26 @@
  * @function_brief{taskpool_function_createjob}
  * - @function_name{taskpool_function_createrecyclablejob}
  * @function_brief{taskpool_function_createrecyclablejob}
+ * - @function_name{taskpool_function_createrecyclablejobs}
+ * @function_brief{taskpool_function_createrecyclablejobs}
  * - @function_name{taskpool_function_destroyrecyclablejob}
  * @function_brief{taskpool_function_destroyrecyclablejob}
  * - @function_name{taskpool_function_recyclejob}
  * @function_brief{taskpool_function_recyclejob}
  * - @function_name{taskpool_function_schedule}
  * @function_brief{taskpool_function_schedule}
+ * - @function_name{taskpool_function_schedulebatch}
+ * @function_brief{taskpool_function_schedulebatch}
  * - @function_name{taskpool_function_scheduledeferred}
  * @function_brief{taskpool_function_scheduledeferred}
  * - @function_name{taskpool_function_getstatus}
  * @function_brief{taskpool_function_getstatus}
  * - @function_name{taskpool_function_trycancel}
  * @function_brief{taskpool_function_trycancel}
+ * - @function_name{taskpool_function_setjobpriority}
+ * @function_brief{taskpool_function_setjobpriority}
+ * - @function_name{taskpool_function_getstatistics}
+ * @function_brief{taskpool_function_getstatistics}
  * - @function_name{taskpool_function_getjobstoragefromhandle}
  * @function_brief{taskpool_function_getjobstoragefromhandle}
  * - @function_name{taskpool_function_strerror}
@@ -101,6 +109,9 @@
  * @function_page{IotTaskPool_CreateRecyclableJob,taskpool,createrecyclablejob}
  * @function_snippet{taskpool,createrecyclablejob,this}
  * @copydoc IotTaskPool_CreateRecyclableJob
+ * @function_page{IotTaskPool_CreateRecyclableJobs,taskpool,createrecyclablejobs}
+ * @function_snippet{taskpool,createrecyclablejobs,this}
+ * @copydoc IotTaskPool_CreateRecyclableJobs
  * @function_page{IotTaskPool_DestroyRecyclableJob,taskpool,destroyrecyclablejob}
  * @function_snippet{taskpool,destroyrecyclablejob,this}
  * @copydoc IotTaskPool_DestroyRecyclableJob
@@ -110,6 +121,9 @@
  * @function_page{IotTaskPool_Schedule,taskpool,schedule}
  * @function_snippet{taskpool,schedule,this}
  * @copydoc IotTaskPool_Schedule
+ * @function_page{IotTaskPool_ScheduleBatch,taskpool,schedulebatch}
+ * @function_snippet{taskpool,schedulebatch,this}
+ * @copydoc IotTaskPool_ScheduleBatch
  * @function_page{IotTaskPool_ScheduleDeferred,taskpool,scheduledeferred}
  * @function_snippet{taskpool,scheduledeferred,this}
  * @copydoc IotTaskPool_ScheduleDeferred
@@ -119,6 +133,12 @@
  * @function_page{IotTaskPool_TryCancel,taskpool,trycancel}
  * @function_snippet{taskpool,trycancel,this}
  * @copydoc IotTaskPool_TryCancel
+ * @function_page{IotTaskPool_SetJobPriority,taskpool,setjobpriority}
+ * @function_snippet{taskpool,setjobpriority,this}
+ * @copydoc IotTaskPool_SetJobPriority
+ * @function_page{IotTaskPool_GetStatistics,taskpool,getstatistics}
+ * @function_snippet{taskpool,getstatistics,this}
+ * @copydoc IotTaskPool_GetStatistics
  * @function_page{IotTaskPool_GetJobStorageFromHandle,taskpool,getjobstoragefromhandle}
  * @function_snippet{taskpool,getjobstoragefromhandle,this}
  * @copydoc IotTaskPool_GetJobStorageFromHandle
@@ -301,6 +321,41 @@ IotTaskPoolError_t IotTaskPool_CreateRecyclableJob( IotTaskPool_t taskPool,
                                                     IotTaskPoolJob_t * const pJob );
 /* @[declare_taskpool_createrecyclablejob] */
 
+/**
+ * @brief Creates several recyclable jobs for the task pool at once.
+ *
+ * This function is equivalent to calling @ref IotTaskPool_CreateRecyclableJob `jobCount` times, but it
+ * acquires the task pool lock only once. Jobs are drawn from the task pool cache first, and only the
+ * jobs missing from the cache are allocated.
+ *
+ * @param[in] taskPool A handle to the task pool for which to create the recyclable jobs.
+ * @param[in] userCallback A user-specified callback for all jobs.
+ * @param[in] ppUserContexts An array of `jobCount` user-specified contexts, one for the callback of each
+ * job. If `NULL`, the callbacks receive a `NULL` context.
+ * @param[out] pJobs An array of `jobCount` instances of @ref IotTaskPoolJob_t that will be initialized when this
+ * function returns successfully.
+ * @param[in] jobCount The number of jobs to create.
+ *
+ * @return One of the following:
+ * - #IOT_TASKPOOL_SUCCESS
+ * - #IOT_TASKPOOL_BAD_PARAMETER
+ * - #IOT_TASKPOOL_NO_MEMORY
+ * - #IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS
+ *
+ * @note Creating the jobs is all or nothing: if any job cannot be allocated, the jobs created so far
+ * are returned to the cache and #IOT_TASKPOOL_NO_MEMORY is returned.
+ *
+ * @warning Recyclable jobs should be recycled with a call to @ref IotTaskPool_RecycleJob rather than destroyed.
+ *
+ */
+/* @[declare_taskpool_createrecyclablejobs] */
+IotTaskPoolError_t IotTaskPool_CreateRecyclableJobs( IotTaskPool_t taskPool,
+                                                     IotTaskPoolRoutine_t userCallback,
+                                                     void * const * ppUserContexts,
+                                                     IotTaskPoolJob_t * const pJobs,
+                                                     uint32_t jobCount );
+/* @[declare_taskpool_createrecyclablejobs] */
+
 /**
  * @brief This function un-initializes a job.
  *
@@ -459,6 +514,41 @@ IotTaskPoolError_t IotTaskPool_Schedule( IotTaskPool_t taskPool,
                                          uint32_t flags );
 /* @[declare_taskpool_schedule] */
 
+/**
+ * @brief This function schedules several jobs for immediate execution.
+ *
+ * This function is equivalent to calling @ref IotTaskPool_Schedule with no flags for each job in
+ * `pJobs`, in order, but it acquires the task pool lock only once and wakes at most as many worker
+ * threads as there are idle workers, instead of signaling the task pool once per job.
+ *
+ * @param[in] taskPool A handle to the task pool that must have been previously initialized with
+ * a call to @ref IotTaskPool_Create or @ref IotTaskPool_CreateSystemTaskPool.
+ * @param[in] pJobs An array of `jobCount` jobs to schedule for execution. Each job must be first initialized
+ * with a call to @ref IotTaskPool_CreateJob, @ref IotTaskPool_CreateRecyclableJob or
+ * @ref IotTaskPool_CreateRecyclableJobs.
+ * @param[in] jobCount The number of jobs in `pJobs`.
+ *
+ * @return One of the following:
+ * - #IOT_TASKPOOL_SUCCESS
+ * - #IOT_TASKPOOL_BAD_PARAMETER
+ * - #IOT_TASKPOOL_ILLEGAL_OPERATION
+ * - #IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS
+ *
+ * @note Scheduling the jobs is all or nothing: if any job is executing, no job is scheduled and
+ * #IOT_TASKPOOL_ILLEGAL_OPERATION is returned.
+ *
+ * @note This function will not allocate memory, but it may create worker threads up to the
+ * maximum number of threads of the task pool.
+ *
+ * @warning The `taskPool` used in this function should be the same
+ * used to create the jobs in `pJobs`, or the results will be undefined.
+ */
+/* @[declare_taskpool_schedulebatch] */
+IotTaskPoolError_t IotTaskPool_ScheduleBatch( IotTaskPool_t taskPool,
+                                              IotTaskPoolJob_t * const pJobs,
+                                              uint32_t jobCount );
+/* @[declare_taskpool_schedulebatch] */
+
 /**
  * @brief This function schedules a job created with @ref IotTaskPool_CreateJob against the task pool
  * pointed to by `taskPool` to be executed after a user-defined time interval.
@@ -541,6 +631,59 @@ IotTaskPoolError_t IotTaskPool_TryCancel( IotTaskPool_t taskPool,
                                           IotTaskPoolJobStatus_t * const pStatus );
 /* @[declare_taskpool_trycancel] */
 
+/**
+ * @brief This function sets the priority class of a job.
+ *
+ * Jobs of a more urgent class are executed before jobs of a less urgent class that were
+ * scheduled earlier. Jobs of the same class are executed in the order they were scheduled.
+ * The priority class is kept when the job is rescheduled, so a periodic job only needs to
+ * set it once after it is created. Recycled jobs return to #IOT_TASKPOOL_JOB_PRIORITY_NORMAL.
+ *
+ * @param[in] taskPool A handle to the task pool that must have been previously initialized with
+ * a call to @ref IotTaskPool_Create or @ref IotTaskPool_CreateSystemTaskPool.
+ * @param[in] job The job to change. This must be first initialized with a call to @ref IotTaskPool_CreateJob
+ * or @ref IotTaskPool_CreateRecyclableJob.
+ * @param[in] priority The new priority class of the job.
+ *
+ * @return One of the following:
+ * - #IOT_TASKPOOL_SUCCESS
+ * - #IOT_TASKPOOL_BAD_PARAMETER
+ * - #IOT_TASKPOOL_ILLEGAL_OPERATION
+ * - #IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS
+ *
+ * @note A job that is waiting in a dispatch queue, i.e. whose status is #IOT_TASKPOOL_STATUS_SCHEDULED,
+ * cannot change class and this function returns #IOT_TASKPOOL_ILLEGAL_OPERATION.
+ *
+ * @warning The `taskPool` used in this function should be the same
+ * used to create the job pointed to by `job`, or the results will be undefined.
+ */
+/* @[declare_taskpool_setjobpriority] */
+IotTaskPoolError_t IotTaskPool_SetJobPriority( IotTaskPool_t taskPool,
+                                               IotTaskPoolJob_t job,
+                                               IotTaskPoolJobPriority_t priority );
+/* @[declare_taskpool_setjobpriority] */
+
+/**
+ * @brief This function retrieves the latency statistics of a task pool.
+ *
+ * The statistics count every job executed since the task pool was created, per priority class.
+ *
+ * @param[in] taskPool A handle to the task pool that must have been previously initialized with
+ * a call to @ref IotTaskPool_Create or @ref IotTaskPool_CreateSystemTaskPool.
+ * @param[out] pStatistics Receives a copy of the statistics of the task pool.
+ *
+ * @return One of the following:
+ * - #IOT_TASKPOOL_SUCCESS
+ * - #IOT_TASKPOOL_BAD_PARAMETER
+ * - #IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS
+ *
+ * @note When @ref IOT_TASKPOOL_ENABLE_STATISTICS is `0`, all statistics are reported as `0`.
+ */
+/* @[declare_taskpool_getstatistics] */
+IotTaskPoolError_t IotTaskPool_GetStatistics( IotTaskPool_t taskPool,
+                                              IotTaskPoolStatistics_t * const pStatistics );
+/* @[declare_taskpool_getstatistics] */
+
 /**
  * @brief Returns a pointer to the job storage from an instance of a job handle
  * of type @ref IotTaskPoolJob_t. This function is guaranteed to succeed for a
@@ -601,4 +744,19 @@ const char * IotTaskPool_strerror( IotTaskPoolError_t status );
     #define IOT_TASKPOOL_JOB_WAIT_TIMEOUT_MS    ( 60 * 1000UL )
 #endif
 
+/**
+ * @brief The maximum number of times in a row a priority class with jobs waiting
+ * may be passed over in favor of a more urgent class.
+ */
+#ifndef IOT_TASKPOOL_STARVATION_LIMIT
+    #define IOT_TASKPOOL_STARVATION_LIMIT    ( 8UL )
+#endif
+
+/**
+ * @brief Set to 1 to record the latency statistics returned by @ref IotTaskPool_GetStatistics.
+ */
+#ifndef IOT_TASKPOOL_ENABLE_STATISTICS
+    #define IOT_TASKPOOL_ENABLE_STATISTICS    ( 1 )
+#endif
+
 #endif /* ifndef IOT_TASKPOOL_H_ */
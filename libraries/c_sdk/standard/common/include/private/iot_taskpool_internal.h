@@ -243,19 +243,23 @@ typedef struct _taskPoolCache
  */
 typedef struct _taskPool
 {
-    IotDeQueue_t dispatchQueue;      /**< @brief The queue for the jobs waiting to be executed. */
-    IotListDouble_t timerEventsList; /**< @brief The timeouts queue for all deferred jobs waiting to be executed. */
-    _taskPoolCache_t jobsCache;      /**< @brief A cache to re-use jobs in order to limit memory allocations. */
-    uint32_t minThreads;             /**< @brief The minimum number of threads for the task pool. */
-    uint32_t maxThreads;             /**< @brief The maximum number of threads for the task pool. */
-    uint32_t activeThreads;          /**< @brief The number of threads in the task pool at any given time. */
-    uint32_t activeJobs;             /**< @brief The number of active jobs in the task pool at any given time. */
-    uint32_t stackSize;              /**< @brief The stack size for all task pool threads. */
-    int32_t priority;                /**< @brief The priority for all task pool threads. */
-    IotSemaphore_t dispatchSignal;   /**< @brief The synchronization object on which threads are waiting for incoming jobs. */
-    IotSemaphore_t startStopSignal;  /**< @brief The synchronization object for threads to signal start and stop condition. */
-    IotTimer_t timer;                /**< @brief The timer for deferred jobs. */
-    IotMutex_t lock;                 /**< @brief The lock to protect the task pool data structure access. */
+    IotDeQueue_t dispatchQueues[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ]; /**< @brief The queues for the jobs waiting to be executed, one per priority class. */
+    uint32_t skipCount[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ];          /**< @brief The number of times in a row each priority class was passed over while it had jobs waiting. */
+    IotListDouble_t timerEventsList;                                 /**< @brief The timeouts queue for all deferred jobs waiting to be executed. */
+    _taskPoolCache_t jobsCache;                                      /**< @brief A cache to re-use jobs in order to limit memory allocations. */
+    uint32_t minThreads;                                             /**< @brief The minimum number of threads for the task pool. */
+    uint32_t maxThreads;                                             /**< @brief The maximum number of threads for the task pool. */
+    uint32_t activeThreads;                                          /**< @brief The number of threads in the task pool at any given time. */
+    uint32_t activeJobs;                                             /**< @brief The number of active jobs in the task pool at any given time. */
+    uint32_t stackSize;                                              /**< @brief The stack size for all task pool threads. */
+    int32_t priority;                                                /**< @brief The priority for all task pool threads. */
+    IotSemaphore_t dispatchSignal;                                   /**< @brief The synchronization object on which threads are waiting for incoming jobs. */
+    IotSemaphore_t startStopSignal;                                  /**< @brief The synchronization object for threads to signal start and stop condition. */
+    IotTimer_t timer;                                                /**< @brief The timer for deferred jobs. */
+    IotMutex_t lock;                                                 /**< @brief The lock to protect the task pool data structure access. */
+    #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+        IotTaskPoolStatistics_t statistics; /**< @brief The latency statistics of the task pool. */
+    #endif
 } _taskPool_t;
 
 /**
@@ -272,6 +276,8 @@ typedef struct _taskPoolJob
     void * pUserContext;               /**< @brief The user provided context. */
     uint32_t flags;                    /**< @brief Internal flags. */
     IotTaskPoolJobStatus_t status;     /**< @brief The status for the job. */
+    IotTaskPoolJobPriority_t priority; /**< @brief The priority class of the job. */
+    uint64_t enqueueTime;              /**< @brief When the job was added to a dispatch queue. */
 } _taskPoolJob_t;
 
 /**
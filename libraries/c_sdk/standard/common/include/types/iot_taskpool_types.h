@@ -62,12 +62,16 @@ typedef enum IotTaskPoolError
      * - @ref taskpool_function_setmaxthreads
      * - @ref taskpool_function_createjob
      * - @ref taskpool_function_createrecyclablejob
+     * - @ref taskpool_function_createrecyclablejobs
      * - @ref taskpool_function_destroyrecyclablejob
      * - @ref taskpool_function_recyclejob
      * - @ref taskpool_function_schedule
+     * - @ref taskpool_function_schedulebatch
      * - @ref taskpool_function_scheduledeferred
      * - @ref taskpool_function_getstatus
      * - @ref taskpool_function_trycancel
+     * - @ref taskpool_function_setjobpriority
+     * - @ref taskpool_function_getstatistics
      *
      */
     IOT_TASKPOOL_SUCCESS = 0,
@@ -82,12 +86,16 @@ typedef enum IotTaskPoolError
      * - @ref taskpool_function_setmaxthreads
      * - @ref taskpool_function_createjob
      * - @ref taskpool_function_createrecyclablejob
+     * - @ref taskpool_function_createrecyclablejobs
      * - @ref taskpool_function_destroyrecyclablejob
      * - @ref taskpool_function_recyclejob
      * - @ref taskpool_function_schedule
+     * - @ref taskpool_function_schedulebatch
      * - @ref taskpool_function_scheduledeferred
      * - @ref taskpool_function_getstatus
      * - @ref taskpool_function_trycancel
+     * - @ref taskpool_function_setjobpriority
+     * - @ref taskpool_function_getstatistics
      *
      */
     IOT_TASKPOOL_BAD_PARAMETER,
@@ -101,8 +109,10 @@ typedef enum IotTaskPoolError
      * - @ref taskpool_function_destroyrecyclablejob
      * - @ref taskpool_function_recyclejob
      * - @ref taskpool_function_schedule
+     * - @ref taskpool_function_schedulebatch
      * - @ref taskpool_function_scheduledeferred
      * - @ref taskpool_function_trycancel
+     * - @ref taskpool_function_setjobpriority
      *
      */
     IOT_TASKPOOL_ILLEGAL_OPERATION,
@@ -115,6 +125,7 @@ typedef enum IotTaskPoolError
      * - @ref taskpool_function_create
      * - @ref taskpool_function_setmaxthreads
      * - @ref taskpool_function_createrecyclablejob
+     * - @ref taskpool_function_createrecyclablejobs
      * - @ref taskpool_function_scheduledeferred
      * - @ref taskpool_function_getstatus
      *
@@ -127,12 +138,16 @@ typedef enum IotTaskPoolError
      * Functions that may return this value:
      * - @ref taskpool_function_setmaxthreads
      * - @ref taskpool_function_createrecyclablejob
+     * - @ref taskpool_function_createrecyclablejobs
      * - @ref taskpool_function_destroyrecyclablejob
      * - @ref taskpool_function_recyclejob
      * - @ref taskpool_function_schedule
+     * - @ref taskpool_function_schedulebatch
      * - @ref taskpool_function_scheduledeferred
      * - @ref taskpool_function_getstatus
      * - @ref taskpool_function_trycancel
+     * - @ref taskpool_function_setjobpriority
+     * - @ref taskpool_function_getstatistics
      *
      */
     IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS,
@@ -196,6 +211,48 @@ typedef enum IotTaskPoolJobStatus
     IOT_TASKPOOL_STATUS_UNDEFINED,
 } IotTaskPoolJobStatus_t;
 
+/**
+ * @ingroup taskpool_datatypes_enums
+ * @brief Priority classes of [task pool Job](@ref IotTaskPoolJob_t).
+ *
+ * Worker threads always pick the oldest job of the most urgent class with jobs waiting,
+ * except that a class passed over @ref IOT_TASKPOOL_STARVATION_LIMIT times in a row is
+ * served next. A job is created with #IOT_TASKPOOL_JOB_PRIORITY_NORMAL; use
+ * @ref taskpool_function_setjobpriority to change it.
+ */
+typedef enum IotTaskPoolJobPriority
+{
+    /**
+     * @brief Latency sensitive jobs, such as protocol keep-alives.
+     *
+     */
+    IOT_TASKPOOL_JOB_PRIORITY_CRITICAL = 0,
+
+    /**
+     * @brief Default priority class of a job.
+     *
+     */
+    IOT_TASKPOOL_JOB_PRIORITY_NORMAL,
+
+    /**
+     * @brief Throughput oriented jobs, such as large transfers or periodic reports.
+     *
+     */
+    IOT_TASKPOOL_JOB_PRIORITY_BULK,
+} IotTaskPoolJobPriority_t;
+
+/**
+ * @brief Number of job priority classes, see #IotTaskPoolJobPriority_t.
+ */
+#define IOT_TASKPOOL_JOB_PRIORITY_LEVELS    ( 3 )
+
+/**
+ * @brief Number of buckets in each histogram of #IotTaskPoolStatistics_t.
+ *
+ * With 12 buckets, the last one counts durations of 1024 ms and longer.
+ */
+#define IOT_TASKPOOL_HISTOGRAM_BUCKETS      ( 12 )
+
 /*------------------------- Task pool types and handles --------------------------*/
 
 /**
@@ -231,6 +288,8 @@ typedef struct IotTaskPoolJobStorage
     void * dummy3;                 /**< @brief Placeholder. */
     uint32_t dummy4;               /**< @brief Placeholder. */
     IotTaskPoolJobStatus_t status; /**< @brief Placeholder. */
+    uint32_t dummy5;               /**< @brief Placeholder. */
+    uint64_t dummy6;               /**< @brief Placeholder. */
 } IotTaskPoolJobStorage_t;
 
 /**
@@ -291,6 +350,27 @@ typedef struct IotTaskPoolInfo
     int32_t priority;    /**< @brief priority for every task pool thread. The priority for each thread is fixed after the task pool is created and cannot be changed. */
 } IotTaskPoolInfo_t;
 
+/**
+ * @ingroup taskpool_datatypes_paramstructs
+ * @brief Latency statistics of a task pool.
+ *
+ * @paramfor @ref taskpool_function_getstatistics
+ *
+ * All arrays are indexed by #IotTaskPoolJobPriority_t. The histograms count jobs by
+ * duration in milliseconds: bucket `0` counts jobs that took less than 1 ms, and bucket
+ * `n` counts jobs that took between 2^(n-1) and 2^n - 1 ms. The last bucket also counts
+ * all longer jobs.
+ */
+typedef struct IotTaskPoolStatistics
+{
+    uint32_t jobsScheduled[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ];                                 /**< @brief Jobs queued for execution, including deferred jobs whose timer expired. */
+    uint32_t jobsCompleted[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ];                                 /**< @brief Jobs whose callback returned. */
+    uint32_t maxQueueWaitMs[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ];                                /**< @brief Longest time a job waited in the dispatch queue. */
+    uint32_t maxRunTimeMs[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ];                                  /**< @brief Longest time a job callback ran. */
+    uint32_t queueWait[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ][ IOT_TASKPOOL_HISTOGRAM_BUCKETS ]; /**< @brief Histogram of the time jobs waited in the dispatch queue. */
+    uint32_t runTime[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ][ IOT_TASKPOOL_HISTOGRAM_BUCKETS ];   /**< @brief Histogram of the time job callbacks ran. */
+} IotTaskPoolStatistics_t;
+
 /*------------------------- TASKPOOL defined constants --------------------------*/
 
 /**
@@ -339,7 +419,7 @@ typedef struct IotTaskPoolInfo
 /** @brief Initializer for a #IotTaskPool_t. */
 #define IOT_TASKPOOL_INITIALIZER                NULL
 /** @brief Initializer for a #IotTaskPoolJobStorage_t. */
-#define IOT_TASKPOOL_JOB_STORAGE_INITIALIZER    { { NULL, NULL }, NULL, NULL, 0, IOT_TASKPOOL_STATUS_UNDEFINED }
+#define IOT_TASKPOOL_JOB_STORAGE_INITIALIZER    { { NULL, NULL }, NULL, NULL, 0, IOT_TASKPOOL_STATUS_UNDEFINED, 0, 0 }
 /** @brief Initializer for a #IotTaskPoolJob_t. */
 #define IOT_TASKPOOL_JOB_INITIALIZER            NULL
 /* @[define_taskpool_initializers] */
@@ -76,7 +76,7 @@
  * the system libraries as well. The system task pool needs to be initialized before any library is used or
  * before any code that posts jobs to the task pool runs.
  */
-_taskPool_t _IotSystemTaskPool = { .dispatchQueue = IOT_DEQUEUE_INITIALIZER };
+_taskPool_t _IotSystemTaskPool = { .dispatchQueues = { IOT_DEQUEUE_INITIALIZER } };
 
 /* -------------- Convenience functions to create/recycle/destroy jobs -------------- */
 
@@ -135,6 +135,31 @@ static void _destroyJob( _taskPoolJob_t * const pJob );
  */
 static void _taskPoolWorker( void * pUserContext );
 
+/**
+ * Removes the next job to execute from the dispatch queues.
+ *
+ * Must be called with the task pool lock held.
+ *
+ * @param[in] pTaskPool The task pool to dequeue a job from.
+ *
+ * @return The job to execute, or `NULL` if all dispatch queues are empty.
+ */
+static _taskPoolJob_t * _dequeueJob( _taskPool_t * const pTaskPool );
+
+#if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+
+/**
+ * Adds one duration to a histogram of the task pool statistics.
+ *
+ * @param[in] pHistogram The histogram to update.
+ * @param[in] pMaxMs The longest duration recorded so far, updated if `durationMs` is longer.
+ * @param[in] durationMs The duration to record.
+ */
+    static void _recordDuration( uint32_t * const pHistogram,
+                                 uint32_t * const pMaxMs,
+                                 uint64_t durationMs );
+#endif
+
 /* -------------- Convenience functions to handle timer events  -------------- */
 
 /**
@@ -219,7 +244,7 @@ static void _signalShutdown( _taskPool_t * const pTaskPool,
                              uint32_t threads );
 
 /**
- * Places a job in the dispatch queue.
+ * Places a job in the dispatch queue and signals a worker to pick it up.
  *
  * @param[in] pTaskPool The task pool to schedule the job with.
  * @param[in] pJob The job to schedule.
@@ -230,6 +255,18 @@ static IotTaskPoolError_t _scheduleInternal( _taskPool_t * const pTaskPool,
                                              _taskPoolJob_t * const pJob,
                                              uint32_t flags );
 
+/**
+ * Places a job in the dispatch queue, growing the task pool if needed, without signaling a worker.
+ *
+ * @param[in] pTaskPool The task pool to schedule the job with.
+ * @param[in] pJob The job to schedule.
+ * @param[in] flags The job flags.
+ *
+ */
+static IotTaskPoolError_t _enqueueInternal( _taskPool_t * const pTaskPool,
+                                            _taskPoolJob_t * const pJob,
+                                            uint32_t flags );
+
 /**
  * Matches a deferred job in the timer queue with its timer event wrapper.
  *
@@ -364,20 +401,23 @@ IotTaskPoolError_t IotTaskPool_Destroy( IotTaskPool_t taskPoolHandle )
          * all task pool data structures and release the associated memory.
          */
 
-        /* (1) Clear the job queue. */
-        do
+        /* (1) Clear the job queues. */
+        for( count = 0; count < IOT_TASKPOOL_JOB_PRIORITY_LEVELS; ++count )
         {
-            pItemLink = NULL;
+            do
+            {
+                pItemLink = NULL;
 
-            pItemLink = IotDeQueue_DequeueHead( &pTaskPool->dispatchQueue );
+                pItemLink = IotDeQueue_DequeueHead( &pTaskPool->dispatchQueues[ count ] );
 
-            if( pItemLink != NULL )
-            {
-                _taskPoolJob_t * pJob = IotLink_Container( _taskPoolJob_t, pItemLink, link );
+                if( pItemLink != NULL )
+                {
+                    _taskPoolJob_t * pJob = IotLink_Container( _taskPoolJob_t, pItemLink, link );
 
-                _destroyJob( pJob );
-            }
-        } while( pItemLink );
+                    _destroyJob( pJob );
+                }
+            } while( pItemLink );
+        }
 
         /* (2) Clear the timer queue. */
         {
@@ -596,6 +636,73 @@ IotTaskPoolError_t IotTaskPool_CreateRecyclableJob( IotTaskPool_t taskPoolHandle
 
 /*-----------------------------------------------------------*/
 
+IotTaskPoolError_t IotTaskPool_CreateRecyclableJobs( IotTaskPool_t taskPoolHandle,
+                                                     IotTaskPoolRoutine_t userCallback,
+                                                     void * const * ppUserContexts,
+                                                     IotTaskPoolJob_t * const pJobs,
+                                                     uint32_t jobCount )
+{
+    _taskPool_t * pTaskPool = NULL;
+    uint32_t count = 0;
+
+    TASKPOOL_FUNCTION_ENTRY( IOT_TASKPOOL_SUCCESS );
+
+    /* Parameter checking. */
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( taskPoolHandle );
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( userCallback );
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( pJobs );
+    TASKPOOL_ON_ARG_ERROR_GOTO_CLEANUP( jobCount == 0UL );
+
+    pTaskPool = ( _taskPool_t * ) taskPoolHandle;
+
+    TASKPOOL_ENTER_CRITICAL();
+    {
+        /* Bail out early if this task pool is shutting down. */
+        if( _IsShutdownStarted( pTaskPool ) )
+        {
+            TASKPOOL_EXIT_CRITICAL();
+
+            TASKPOOL_SET_AND_GOTO_CLEANUP( IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS );
+        }
+
+        /* Draw all jobs from the cache first, and allocate only the missing ones. */
+        for( count = 0; count < jobCount; ++count )
+        {
+            _taskPoolJob_t * pTempJob = _fetchOrAllocateJob( &pTaskPool->jobsCache );
+
+            if( pTempJob == NULL )
+            {
+                IotLogInfo( "Failed to allocate job %lu of %lu.", ( unsigned long ) count, ( unsigned long ) jobCount );
+
+                break;
+            }
+
+            _initializeJob( pTempJob, userCallback, ( ppUserContexts == NULL ) ? NULL : ppUserContexts[ count ], false );
+
+            pJobs[ count ] = pTempJob;
+        }
+
+        /* Creating the jobs is all or nothing: return the jobs created so far to the cache. */
+        if( count < jobCount )
+        {
+            while( count > 0UL )
+            {
+                --count;
+
+                _recycleJob( &pTaskPool->jobsCache, pJobs[ count ] );
+                pJobs[ count ] = IOT_TASKPOOL_JOB_INITIALIZER;
+            }
+
+            status = IOT_TASKPOOL_NO_MEMORY;
+        }
+    }
+    TASKPOOL_EXIT_CRITICAL();
+
+    TASKPOOL_NO_FUNCTION_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
 IotTaskPoolError_t IotTaskPool_DestroyRecyclableJob( IotTaskPool_t taskPoolHandle,
                                                      IotTaskPoolJob_t pJobHandle )
 {
@@ -730,6 +837,90 @@ IotTaskPoolError_t IotTaskPool_Schedule( IotTaskPool_t taskPoolHandle,
 
 /*-----------------------------------------------------------*/
 
+IotTaskPoolError_t IotTaskPool_ScheduleBatch( IotTaskPool_t taskPoolHandle,
+                                              IotTaskPoolJob_t * const pJobs,
+                                              uint32_t jobCount )
+{
+    TASKPOOL_FUNCTION_ENTRY( IOT_TASKPOOL_SUCCESS );
+    _taskPool_t * pTaskPool = NULL;
+    uint32_t count = 0;
+
+    /* Parameter checking. */
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( taskPoolHandle );
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( pJobs );
+    TASKPOOL_ON_ARG_ERROR_GOTO_CLEANUP( jobCount == 0UL );
+
+    for( count = 0; count < jobCount; ++count )
+    {
+        TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( pJobs[ count ] );
+    }
+
+    pTaskPool = ( _taskPool_t * ) taskPoolHandle;
+
+    TASKPOOL_ENTER_CRITICAL();
+    {
+        /* Bail out early if this task pool is shutting down. */
+        if( _IsShutdownStarted( pTaskPool ) )
+        {
+            TASKPOOL_EXIT_CRITICAL();
+
+            TASKPOOL_SET_AND_GOTO_CLEANUP( IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS );
+        }
+
+        /* Scheduling the batch is all or nothing: an executing job is the only one
+         * that cannot be extracted and rescheduled, so check for it up front. */
+        for( count = 0; count < jobCount; ++count )
+        {
+            if( pJobs[ count ]->status == IOT_TASKPOOL_STATUS_COMPLETED )
+            {
+                TASKPOOL_EXIT_CRITICAL();
+
+                TASKPOOL_SET_AND_GOTO_CLEANUP( IOT_TASKPOOL_ILLEGAL_OPERATION );
+            }
+        }
+
+        for( count = 0; count < jobCount; ++count )
+        {
+            status = _trySafeExtraction( pTaskPool, pJobs[ count ], false );
+            IotTaskPool_Assert( TASKPOOL_SUCCEEDED( status ) );
+
+            /* Without the high priority flag, enqueuing cannot fail. */
+            status = _enqueueInternal( pTaskPool, pJobs[ count ], 0 );
+            IotTaskPool_Assert( TASKPOOL_SUCCEEDED( status ) );
+        }
+
+        /* Wake as many workers as there are jobs, but no more than the workers not already
+         * accounted for by other jobs: a worker drains the dispatch queues before waiting again.
+         * Always wake at least one, so that the batch cannot sit in the queues unattended. */
+        {
+            uint32_t otherJobs = pTaskPool->activeJobs - jobCount;
+            uint32_t wake = 1;
+
+            if( pTaskPool->activeThreads > otherJobs )
+            {
+                wake = pTaskPool->activeThreads - otherJobs;
+            }
+
+            if( wake > jobCount )
+            {
+                wake = jobCount;
+            }
+
+            while( wake > 0UL )
+            {
+                IotSemaphore_Post( &pTaskPool->dispatchSignal );
+
+                --wake;
+            }
+        }
+    }
+    TASKPOOL_EXIT_CRITICAL();
+
+    TASKPOOL_NO_FUNCTION_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
 IotTaskPoolError_t IotTaskPool_ScheduleDeferred( IotTaskPool_t taskPoolHandle,
                                                  IotTaskPoolJob_t pJob,
                                                  uint32_t timeMs )
@@ -886,6 +1077,81 @@ IotTaskPoolError_t IotTaskPool_TryCancel( IotTaskPool_t taskPoolHandle,
     TASKPOOL_NO_FUNCTION_CLEANUP();
 }
 
+/*-----------------------------------------------------------*/
+
+IotTaskPoolError_t IotTaskPool_SetJobPriority( IotTaskPool_t taskPoolHandle,
+                                               IotTaskPoolJob_t pJob,
+                                               IotTaskPoolJobPriority_t priority )
+{
+    TASKPOOL_FUNCTION_ENTRY( IOT_TASKPOOL_SUCCESS );
+    _taskPool_t * pTaskPool = NULL;
+
+    /* Parameter checking. */
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( taskPoolHandle );
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( pJob );
+    TASKPOOL_ON_ARG_ERROR_GOTO_CLEANUP( ( uint32_t ) priority >= IOT_TASKPOOL_JOB_PRIORITY_LEVELS );
+
+    pTaskPool = ( _taskPool_t * ) taskPoolHandle;
+
+    TASKPOOL_ENTER_CRITICAL();
+    {
+        /* Bail out early if this task pool is shutting down. */
+        if( _IsShutdownStarted( pTaskPool ) )
+        {
+            status = IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS;
+        }
+        /* A scheduled job is linked in the dispatch queue of its current class. */
+        else if( pJob->status == IOT_TASKPOOL_STATUS_SCHEDULED )
+        {
+            IotLogWarn( "Attempt to change the priority of a scheduled job." );
+
+            status = IOT_TASKPOOL_ILLEGAL_OPERATION;
+        }
+        else
+        {
+            pJob->priority = priority;
+        }
+    }
+    TASKPOOL_EXIT_CRITICAL();
+
+    TASKPOOL_NO_FUNCTION_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
+IotTaskPoolError_t IotTaskPool_GetStatistics( IotTaskPool_t taskPoolHandle,
+                                              IotTaskPoolStatistics_t * const pStatistics )
+{
+    TASKPOOL_FUNCTION_ENTRY( IOT_TASKPOOL_SUCCESS );
+    _taskPool_t * pTaskPool = NULL;
+
+    /* Parameter checking. */
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( taskPoolHandle );
+    TASKPOOL_ON_NULL_ARG_GOTO_CLEANUP( pStatistics );
+
+    pTaskPool = ( _taskPool_t * ) taskPoolHandle;
+
+    memset( pStatistics, 0x00, sizeof( IotTaskPoolStatistics_t ) );
+
+    TASKPOOL_ENTER_CRITICAL();
+    {
+        /* Bail out early if this task pool is shutting down. */
+        if( _IsShutdownStarted( pTaskPool ) )
+        {
+            TASKPOOL_EXIT_CRITICAL();
+
+            TASKPOOL_SET_AND_GOTO_CLEANUP( IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS );
+        }
+
+        #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+            *pStatistics = pTaskPool->statistics;
+        #endif
+    }
+    TASKPOOL_EXIT_CRITICAL();
+
+    TASKPOOL_NO_FUNCTION_CLEANUP();
+}
+
 IotTaskPoolJobStorage_t * IotTaskPool_GetJobStorageFromHandle( IotTaskPoolJob_t pJob )
 {
     return ( IotTaskPoolJobStorage_t * ) pJob;
@@ -951,6 +1217,7 @@ static IotTaskPoolError_t _initTaskPoolControlStructures( const IotTaskPoolInfo_
 {
     TASKPOOL_FUNCTION_ENTRY( IOT_TASKPOOL_SUCCESS );
 
+    uint32_t count;
     bool semStartStopInit = false;
     bool lockInit = false;
     bool semDispatchInit = false;
@@ -962,7 +1229,11 @@ static IotTaskPoolError_t _initTaskPoolControlStructures( const IotTaskPoolInfo_
     /* Initialize a job data structures that require no de-initialization.
      * All other data structures carry a value of 'NULL' before initialization.
      */
-    IotDeQueue_Create( &pTaskPool->dispatchQueue );
+    for( count = 0; count < IOT_TASKPOOL_JOB_PRIORITY_LEVELS; ++count )
+    {
+        IotDeQueue_Create( &pTaskPool->dispatchQueues[ count ] );
+    }
+
     IotListDouble_Create( &pTaskPool->timerEventsList );
 
     pTaskPool->minThreads = pInfo->minThreads;
@@ -1143,7 +1414,6 @@ static void _taskPoolWorker( void * pUserContext )
     do
     {
         bool jobAvailable;
-        IotLink_t * pFirst;
         _taskPoolJob_t * pJob = NULL;
 
         /* Wait on incoming notifications. If waiting on the semaphore return with timeout, then
@@ -1209,15 +1479,12 @@ static void _taskPoolWorker( void * pUserContext )
             /* Only look for a job if waiting did not timed out. */
             if( jobAvailable == true )
             {
-                /* Dequeue the first job in FIFO order. */
-                pFirst = IotDeQueue_DequeueHead( &pTaskPool->dispatchQueue );
+                /* Dequeue the next job in priority order. */
+                pJob = _dequeueJob( pTaskPool );
 
                 /* If there is indeed a job, then update status under lock, and release the lock before processing the job. */
-                if( pFirst != NULL )
+                if( pJob != NULL )
                 {
-                    /* Extract the job from its link. */
-                    pJob = IotLink_Container( _taskPoolJob_t, pFirst, link );
-
                     /* Update status to 'executing'. */
                     pJob->status = IOT_TASKPOOL_STATUS_COMPLETED;
                     userCallback = pJob->userCallback;
@@ -1229,6 +1496,11 @@ static void _taskPoolWorker( void * pUserContext )
         /* INNER LOOP: it controls the execution of jobs: the exit condition is the lack of a job to execute. */
         while( pJob != NULL )
         {
+            #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+                IotTaskPoolJobPriority_t priority;
+                uint64_t runTime;
+            #endif
+
             /* Process the job by invoking the associated callback with the user context.
              * This task pool thread will not be available until the user callback returns.
              */
@@ -1236,13 +1508,25 @@ static void _taskPoolWorker( void * pUserContext )
                 IotTaskPool_Assert( IotLink_IsLinked( &pJob->link ) == false );
                 IotTaskPool_Assert( userCallback != NULL );
 
+                #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+                    /* The callback may recycle or destroy the job, so record its class beforehand. */
+                    priority = pJob->priority;
+                    runTime = IotClock_GetTimeMs();
+                #endif
+
                 userCallback( pTaskPool, pJob, pJob->pUserContext );
 
+                #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+                    runTime = IotClock_GetTimeMs() - runTime;
+                #endif
+
                 /* This job is finished, clear its pointer. */
                 pJob = NULL;
                 userCallback = NULL;
 
-                /* If this thread exceeded the quota, then let it terminate. */
+                /* If this thread exceeded the quota, then let it terminate. This thread no longer
+                 * counts as active, so the task pool may be destroyed already: do not record
+                 * statistics for this job. */
                 if( running == false )
                 {
                     /* Abandon the INNER LOOP. Execution will tranfer back to the OUTER LOOP condition. */
@@ -1256,14 +1540,18 @@ static void _taskPoolWorker( void * pUserContext )
                 /* Update the number of busy threads, so new requests can be served by creating new threads, up to maxThreads. */
                 pTaskPool->activeJobs--;
 
-                /* Try and dequeue the next job in the dispatch queue. */
-                IotLink_t * pItem = NULL;
+                #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+                    pTaskPool->statistics.jobsCompleted[ priority ]++;
+                    _recordDuration( pTaskPool->statistics.runTime[ priority ],
+                                     &pTaskPool->statistics.maxRunTimeMs[ priority ],
+                                     runTime );
+                #endif
 
-                /* Dequeue the next job from the dispatch queue. */
-                pItem = IotDeQueue_DequeueHead( &pTaskPool->dispatchQueue );
+                /* Dequeue the next job in priority order. */
+                pJob = _dequeueJob( pTaskPool );
 
-                /* If there is no job left in the dispatch queue, update the worker status and leave. */
-                if( pItem == NULL )
+                /* If there is no job left in the dispatch queues, update the worker status and leave. */
+                if( pJob == NULL )
                 {
                     TASKPOOL_EXIT_CRITICAL();
 
@@ -1272,8 +1560,6 @@ static void _taskPoolWorker( void * pUserContext )
                 }
                 else
                 {
-                    pJob = IotLink_Container( _taskPoolJob_t, pItem, link );
-
                     userCallback = pJob->userCallback;
                 }
 
@@ -1284,6 +1570,95 @@ static void _taskPoolWorker( void * pUserContext )
     } while( running == true );
 }
 
+/*-----------------------------------------------------------*/
+
+static _taskPoolJob_t * _dequeueJob( _taskPool_t * const pTaskPool )
+{
+    uint32_t level;
+    uint32_t selected = IOT_TASKPOOL_JOB_PRIORITY_LEVELS;
+    _taskPoolJob_t * pJob = NULL;
+
+    /* Serve the most urgent class with jobs waiting, unless a less urgent class was
+     * passed over too many times in a row. */
+    for( level = 0; level < IOT_TASKPOOL_JOB_PRIORITY_LEVELS; ++level )
+    {
+        if( IotDeQueue_IsEmpty( &pTaskPool->dispatchQueues[ level ] ) == false )
+        {
+            if( selected == IOT_TASKPOOL_JOB_PRIORITY_LEVELS )
+            {
+                selected = level;
+            }
+            else if( pTaskPool->skipCount[ level ] >= IOT_TASKPOOL_STARVATION_LIMIT )
+            {
+                selected = level;
+                break;
+            }
+            else
+            {
+                /* Nothing to do. */
+            }
+        }
+    }
+
+    if( selected < IOT_TASKPOOL_JOB_PRIORITY_LEVELS )
+    {
+        /* Every other class with jobs waiting is passed over once more. */
+        for( level = 0; level < IOT_TASKPOOL_JOB_PRIORITY_LEVELS; ++level )
+        {
+            if( level == selected )
+            {
+                pTaskPool->skipCount[ level ] = 0;
+            }
+            else if( IotDeQueue_IsEmpty( &pTaskPool->dispatchQueues[ level ] ) == false )
+            {
+                pTaskPool->skipCount[ level ]++;
+            }
+            else
+            {
+                pTaskPool->skipCount[ level ] = 0;
+            }
+        }
+
+        pJob = IotLink_Container( _taskPoolJob_t,
+                                  IotDeQueue_DequeueHead( &pTaskPool->dispatchQueues[ selected ] ),
+                                  link );
+
+        #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+            _recordDuration( pTaskPool->statistics.queueWait[ selected ],
+                             &pTaskPool->statistics.maxQueueWaitMs[ selected ],
+                             IotClock_GetTimeMs() - pJob->enqueueTime );
+        #endif
+    }
+
+    return pJob;
+}
+
+/*-----------------------------------------------------------*/
+
+#if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+    static void _recordDuration( uint32_t * const pHistogram,
+                                 uint32_t * const pMaxMs,
+                                 uint64_t durationMs )
+    {
+        uint32_t bucket = 0;
+        uint64_t remaining = durationMs;
+
+        /* Bucket n counts durations of 2^(n-1) to 2^n - 1 ms, the last bucket all longer ones. */
+        while( ( remaining > 0ULL ) && ( bucket < ( IOT_TASKPOOL_HISTOGRAM_BUCKETS - 1 ) ) )
+        {
+            remaining >>= 1;
+            bucket++;
+        }
+
+        pHistogram[ bucket ]++;
+
+        if( durationMs > ( uint64_t ) *pMaxMs )
+        {
+            *pMaxMs = ( durationMs > ( uint64_t ) UINT32_MAX ) ? UINT32_MAX : ( uint32_t ) durationMs;
+        }
+    }
+#endif /* if IOT_TASKPOOL_ENABLE_STATISTICS == 1 */
+
 /* ---------------------------------------------------------------------------------------------- */
 
 static void _initJobsCache( _taskPoolCache_t * const pCache )
@@ -1304,6 +1679,7 @@ static void _initializeJob( _taskPoolJob_t * const pJob,
     pJob->link.pPrevious = NULL;
     pJob->userCallback = userCallback;
     pJob->pUserContext = pUserContext;
+    pJob->priority = IOT_TASKPOOL_JOB_PRIORITY_NORMAL;
 
     if( isStatic )
     {
@@ -1429,6 +1805,23 @@ static void _signalShutdown( _taskPool_t * const pTaskPool,
 static IotTaskPoolError_t _scheduleInternal( _taskPool_t * const pTaskPool,
                                              _taskPoolJob_t * const pJob,
                                              uint32_t flags )
+{
+    IotTaskPoolError_t status = _enqueueInternal( pTaskPool, pJob, flags );
+
+    if( TASKPOOL_SUCCEEDED( status ) )
+    {
+        /* Signal a worker to pick up the job. */
+        IotSemaphore_Post( &pTaskPool->dispatchSignal );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static IotTaskPoolError_t _enqueueInternal( _taskPool_t * const pTaskPool,
+                                            _taskPoolJob_t * const pJob,
+                                            uint32_t flags )
 {
     TASKPOOL_FUNCTION_ENTRY( IOT_TASKPOOL_SUCCESS );
 
@@ -1498,21 +1891,25 @@ static IotTaskPoolError_t _scheduleInternal( _taskPool_t * const pTaskPool,
 
     if( TASKPOOL_SUCCEEDED( status ) )
     {
-        /* Append the job to the dispatch queue.
+        IotDeQueue_t * pDispatchQueue = &pTaskPool->dispatchQueues[ pJob->priority ];
+
+        #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+            pJob->enqueueTime = IotClock_GetTimeMs();
+            pTaskPool->statistics.jobsScheduled[ pJob->priority ]++;
+        #endif
+
+        /* Append the job to the dispatch queue of its priority class.
          * Put the job at the front, if it is a high priority job. */
         if( mustGrow == true )
         {
             IotLogDebug( "High priority job: placing job at the head of the queue." );
 
-            IotDeQueue_EnqueueHead( &pTaskPool->dispatchQueue, &pJob->link );
+            IotDeQueue_EnqueueHead( pDispatchQueue, &pJob->link );
         }
         else
         {
-            IotDeQueue_EnqueueTail( &pTaskPool->dispatchQueue, &pJob->link );
+            IotDeQueue_EnqueueTail( pDispatchQueue, &pJob->link );
         }
-
-        /* Signal a worker to pick up the job. */
-        IotSemaphore_Post( &pTaskPool->dispatchSignal );
     }
     else
     {
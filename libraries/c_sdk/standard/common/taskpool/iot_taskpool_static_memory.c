@@ -58,7 +58,7 @@
  * Static memory buffers and flags, allocated and zeroed at compile-time.
  */
     static bool _pInUseTaskPools[ IOT_TASKPOOLS ] = { 0 };                                                          /**< @brief Task pools in-use flags. */
-    static _taskPool_t _pTaskPools[ IOT_TASKPOOLS ] = { { .dispatchQueue = IOT_DEQUEUE_INITIALIZER } };             /**< @brief Task pools. */
+    static _taskPool_t _pTaskPools[ IOT_TASKPOOLS ] = { { .dispatchQueues = { IOT_DEQUEUE_INITIALIZER } } };       /**< @brief Task pools. */
 
     static bool _pInUseTaskPoolJobs[ IOT_TASKPOOL_JOBS_RECYCLE_LIMIT ] = { 0 };                                     /**< @brief Task pool jobs in-use flags. */
     static _taskPoolJob_t _pTaskPoolJobs[ IOT_TASKPOOL_JOBS_RECYCLE_LIMIT ] = { { .link = IOT_LINK_INITIALIZER } }; /**< @brief Task pool jobs. */
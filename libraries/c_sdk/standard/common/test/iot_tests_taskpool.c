@@ -73,6 +73,23 @@ typedef struct JobBlockingUserContext
     IotSemaphore_t block;  /**< @brief A synch object to wait on. */
 } JobBlockingUserContext_t;
 
+/**
+ * @brief Number of jobs queued behind a blocked worker in the priority tests.
+ */
+#ifndef TEST_TASKPOOL_PRIORITY_JOBS
+    #define TEST_TASKPOOL_PRIORITY_JOBS    ( IOT_TASKPOOL_STARVATION_LIMIT + 4 )
+#endif
+
+/**
+ * @brief A simple user context to prove jobs execute in priority order.
+ */
+typedef struct JobOrderUserContext
+{
+    IotMutex_t lock;                                        /**< @brief Protection from concurrent updates. */
+    uint32_t counter;                                       /**< @brief A counter to keep track of callback invocations. */
+    IotTaskPoolJob_t order[ TEST_TASKPOOL_PRIORITY_JOBS ]; /**< @brief The jobs, in the order they executed. */
+} JobOrderUserContext_t;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -124,6 +141,11 @@ TEST_GROUP_RUNNER( Common_Unit_Task_Pool )
     RUN_TEST_CASE( Common_Unit_Task_Pool, ScheduleTasks_ReSchedule );
     RUN_TEST_CASE( Common_Unit_Task_Pool, ScheduleTasks_ReScheduleDeferred );
     RUN_TEST_CASE( Common_Unit_Task_Pool, ScheduleTasks_CancelTasks );
+    RUN_TEST_CASE( Common_Unit_Task_Pool, ScheduleTasks_PriorityOrder );
+    RUN_TEST_CASE( Common_Unit_Task_Pool, ScheduleTasks_PriorityStarvation );
+    RUN_TEST_CASE( Common_Unit_Task_Pool, GetStatistics );
+    RUN_TEST_CASE( Common_Unit_Task_Pool, ScheduleBatch );
+    RUN_TEST_CASE( Common_Unit_Task_Pool, ScheduleBatchThroughput );
 }
 
 /*-----------------------------------------------------------*/
@@ -198,6 +220,18 @@ TEST_GROUP_RUNNER( Common_Unit_Task_Pool )
     #define TEST_TASKPOOL_MAX_THREADS    7
 #endif
 
+/**
+ * @brief Number of jobs scheduled by each round of the batch scheduling benchmark.
+ */
+#ifndef TEST_TASKPOOL_BATCH_BENCHMARK_JOBS
+    #define TEST_TASKPOOL_BATCH_BENCHMARK_JOBS    ( 1024 )
+#endif
+
+/**
+ * @brief Largest batch of the batch scheduling benchmark.
+ */
+#define TEST_TASKPOOL_MAX_BATCH    ( 64 )
+
 /**
  * @brief One hour in milliseconds.
  */
@@ -349,6 +383,90 @@ static void BlankExecution( IotTaskPool_t pTaskPool,
     TEST_ASSERT( ( error == IOT_TASKPOOL_SUCCESS ) || ( error == IOT_TASKPOOL_SHUTDOWN_IN_PROGRESS ) );
 }
 
+/**
+ * @brief A callback that records the order in which jobs execute.
+ */
+static void ExecutionRecordOrderCb( IotTaskPool_t pTaskPool,
+                                    IotTaskPoolJob_t pJob,
+                                    void * pContext )
+{
+    JobOrderUserContext_t * pUserContext = ( JobOrderUserContext_t * ) pContext;
+
+    ( void ) pTaskPool;
+
+    IotMutex_Lock( &pUserContext->lock );
+
+    if( pUserContext->counter < TEST_TASKPOOL_PRIORITY_JOBS )
+    {
+        pUserContext->order[ pUserContext->counter ] = pJob;
+    }
+
+    pUserContext->counter++;
+    IotMutex_Unlock( &pUserContext->lock );
+}
+
+/**
+ * @brief A callback that only counts its invocations and recycles its job.
+ */
+static void ExecutionCountAndRecycleCb( IotTaskPool_t pTaskPool,
+                                        IotTaskPoolJob_t pJob,
+                                        void * pContext )
+{
+    JobUserContext_t * pUserContext = ( JobUserContext_t * ) pContext;
+
+    IotMutex_Lock( &pUserContext->lock );
+    pUserContext->counter++;
+    IotMutex_Unlock( &pUserContext->lock );
+
+    IotTaskPool_RecycleJob( pTaskPool, pJob );
+}
+
+/**
+ * @brief Waits until a job counter context has recorded a number of callbacks.
+ */
+static void WaitForCounter( JobUserContext_t * pUserContext,
+                            uint32_t expected )
+{
+    while( true )
+    {
+        IotMutex_Lock( &pUserContext->lock );
+
+        if( pUserContext->counter >= expected )
+        {
+            IotMutex_Unlock( &pUserContext->lock );
+
+            break;
+        }
+
+        IotMutex_Unlock( &pUserContext->lock );
+
+        IotClock_SleepMs( 1 );
+    }
+}
+
+/**
+ * @brief Waits until a job order context has recorded a number of callbacks.
+ */
+static void WaitForOrderCounter( JobOrderUserContext_t * pUserContext,
+                                 uint32_t expected )
+{
+    while( true )
+    {
+        IotMutex_Lock( &pUserContext->lock );
+
+        if( pUserContext->counter >= expected )
+        {
+            IotMutex_Unlock( &pUserContext->lock );
+
+            break;
+        }
+
+        IotMutex_Unlock( &pUserContext->lock );
+
+        IotClock_SleepMs( 50 );
+    }
+}
+
 /* ---------------------------------------------------------------------------------------------- */
 /* ---------------------------------------------------------------------------------------------- */
 /* ---------------------------------------------------------------------------------------------- */
@@ -1853,3 +1971,422 @@ TEST( Common_Unit_Task_Pool, ScheduleTasks_CancelTasks )
 }
 
 /*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that queued jobs execute in priority order, and that a scheduled job cannot change class.
+ */
+TEST( Common_Unit_Task_Pool, ScheduleTasks_PriorityOrder )
+{
+    IotTaskPool_t taskPool = IOT_TASKPOOL_INITIALIZER;
+
+    /* Use a single thread, so that jobs queue up behind the blocking job. */
+    const IotTaskPoolInfo_t tpInfo = { .minThreads = 1, .maxThreads = 1, .stackSize = IOT_THREAD_DEFAULT_STACK_SIZE, .priority = IOT_THREAD_DEFAULT_PRIORITY };
+
+    JobBlockingUserContext_t blockingContext;
+    JobOrderUserContext_t orderContext;
+
+    memset( &orderContext, 0, sizeof( JobOrderUserContext_t ) );
+
+    /* Initialize user contexts. */
+    TEST_ASSERT( IotSemaphore_Create( &blockingContext.signal, 0, 1 ) );
+    TEST_ASSERT( IotSemaphore_Create( &blockingContext.block, 0, 1 ) );
+    TEST_ASSERT_TRUE( IotMutex_Create( &orderContext.lock, false ) );
+
+    TEST_ASSERT( IotTaskPool_Create( &tpInfo, &taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    if( TEST_PROTECT() )
+    {
+        IotTaskPoolJobStorage_t blockingJobStorage;
+        IotTaskPoolJob_t blockingJob = IOT_TASKPOOL_JOB_INITIALIZER;
+        IotTaskPoolJobStorage_t jobsStorage[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ];
+        IotTaskPoolJob_t jobs[ IOT_TASKPOOL_JOB_PRIORITY_LEVELS ];
+
+        /* Occupy the only worker. */
+        TEST_ASSERT( IotTaskPool_CreateJob( &ExecutionBlockingWithoutDestroyCb, &blockingContext, &blockingJobStorage, &blockingJob ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_Schedule( taskPool, blockingJob, 0 ) == IOT_TASKPOOL_SUCCESS );
+        IotSemaphore_Wait( &blockingContext.signal );
+
+        /* Create jobs in every class, and schedule them from the least to the most urgent. */
+        TEST_ASSERT( IotTaskPool_CreateJob( &ExecutionRecordOrderCb, &orderContext, &jobsStorage[ 0 ], &jobs[ IOT_TASKPOOL_JOB_PRIORITY_BULK ] ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_CreateJob( &ExecutionRecordOrderCb, &orderContext, &jobsStorage[ 1 ], &jobs[ IOT_TASKPOOL_JOB_PRIORITY_NORMAL ] ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_CreateJob( &ExecutionRecordOrderCb, &orderContext, &jobsStorage[ 2 ], &jobs[ IOT_TASKPOOL_JOB_PRIORITY_CRITICAL ] ) == IOT_TASKPOOL_SUCCESS );
+
+        TEST_ASSERT( IotTaskPool_SetJobPriority( NULL, jobs[ IOT_TASKPOOL_JOB_PRIORITY_BULK ], IOT_TASKPOOL_JOB_PRIORITY_BULK ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_SetJobPriority( taskPool, NULL, IOT_TASKPOOL_JOB_PRIORITY_BULK ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_SetJobPriority( taskPool, jobs[ IOT_TASKPOOL_JOB_PRIORITY_BULK ], ( IotTaskPoolJobPriority_t ) IOT_TASKPOOL_JOB_PRIORITY_LEVELS ) == IOT_TASKPOOL_BAD_PARAMETER );
+
+        TEST_ASSERT( IotTaskPool_SetJobPriority( taskPool, jobs[ IOT_TASKPOOL_JOB_PRIORITY_BULK ], IOT_TASKPOOL_JOB_PRIORITY_BULK ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_SetJobPriority( taskPool, jobs[ IOT_TASKPOOL_JOB_PRIORITY_CRITICAL ], IOT_TASKPOOL_JOB_PRIORITY_CRITICAL ) == IOT_TASKPOOL_SUCCESS );
+
+        TEST_ASSERT( IotTaskPool_Schedule( taskPool, jobs[ IOT_TASKPOOL_JOB_PRIORITY_BULK ], 0 ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_Schedule( taskPool, jobs[ IOT_TASKPOOL_JOB_PRIORITY_NORMAL ], 0 ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_Schedule( taskPool, jobs[ IOT_TASKPOOL_JOB_PRIORITY_CRITICAL ], 0 ) == IOT_TASKPOOL_SUCCESS );
+
+        /* A job waiting in a dispatch queue cannot change class. */
+        TEST_ASSERT( IotTaskPool_SetJobPriority( taskPool, jobs[ IOT_TASKPOOL_JOB_PRIORITY_BULK ], IOT_TASKPOOL_JOB_PRIORITY_CRITICAL ) == IOT_TASKPOOL_ILLEGAL_OPERATION );
+
+        /* Release the worker and wait for all jobs to execute. */
+        IotSemaphore_Post( &blockingContext.block );
+
+        WaitForOrderCounter( &orderContext, IOT_TASKPOOL_JOB_PRIORITY_LEVELS );
+
+        TEST_ASSERT_EQUAL( IOT_TASKPOOL_JOB_PRIORITY_LEVELS, orderContext.counter );
+        TEST_ASSERT( orderContext.order[ 0 ] == jobs[ IOT_TASKPOOL_JOB_PRIORITY_CRITICAL ] );
+        TEST_ASSERT( orderContext.order[ 1 ] == jobs[ IOT_TASKPOOL_JOB_PRIORITY_NORMAL ] );
+        TEST_ASSERT( orderContext.order[ 2 ] == jobs[ IOT_TASKPOOL_JOB_PRIORITY_BULK ] );
+    }
+
+    TEST_ASSERT( IotTaskPool_Destroy( taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    /* Destroy user contexts. */
+    IotSemaphore_Destroy( &blockingContext.signal );
+    IotSemaphore_Destroy( &blockingContext.block );
+    IotMutex_Destroy( &orderContext.lock );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a stream of critical jobs cannot hold off a bulk job longer than the starvation limit.
+ */
+TEST( Common_Unit_Task_Pool, ScheduleTasks_PriorityStarvation )
+{
+    IotTaskPool_t taskPool = IOT_TASKPOOL_INITIALIZER;
+
+    /* Use a single thread, so that jobs queue up behind the blocking job. */
+    const IotTaskPoolInfo_t tpInfo = { .minThreads = 1, .maxThreads = 1, .stackSize = IOT_THREAD_DEFAULT_STACK_SIZE, .priority = IOT_THREAD_DEFAULT_PRIORITY };
+
+    JobBlockingUserContext_t blockingContext;
+    JobOrderUserContext_t orderContext;
+
+    memset( &orderContext, 0, sizeof( JobOrderUserContext_t ) );
+
+    /* Initialize user contexts. */
+    TEST_ASSERT( IotSemaphore_Create( &blockingContext.signal, 0, 1 ) );
+    TEST_ASSERT( IotSemaphore_Create( &blockingContext.block, 0, 1 ) );
+    TEST_ASSERT_TRUE( IotMutex_Create( &orderContext.lock, false ) );
+
+    TEST_ASSERT( IotTaskPool_Create( &tpInfo, &taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    if( TEST_PROTECT() )
+    {
+        uint32_t count;
+        IotTaskPoolJobStorage_t blockingJobStorage;
+        IotTaskPoolJob_t blockingJob = IOT_TASKPOOL_JOB_INITIALIZER;
+        IotTaskPoolJobStorage_t jobsStorage[ TEST_TASKPOOL_PRIORITY_JOBS ];
+        IotTaskPoolJob_t jobs[ TEST_TASKPOOL_PRIORITY_JOBS ];
+
+        /* Occupy the only worker. */
+        TEST_ASSERT( IotTaskPool_CreateJob( &ExecutionBlockingWithoutDestroyCb, &blockingContext, &blockingJobStorage, &blockingJob ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_Schedule( taskPool, blockingJob, 0 ) == IOT_TASKPOOL_SUCCESS );
+        IotSemaphore_Wait( &blockingContext.signal );
+
+        /* Schedule one bulk job first, then enough critical jobs to starve it. */
+        for( count = 0; count < TEST_TASKPOOL_PRIORITY_JOBS; ++count )
+        {
+            TEST_ASSERT( IotTaskPool_CreateJob( &ExecutionRecordOrderCb, &orderContext, &jobsStorage[ count ], &jobs[ count ] ) == IOT_TASKPOOL_SUCCESS );
+            TEST_ASSERT( IotTaskPool_SetJobPriority( taskPool,
+                                                     jobs[ count ],
+                                                     ( count == 0 ) ? IOT_TASKPOOL_JOB_PRIORITY_BULK : IOT_TASKPOOL_JOB_PRIORITY_CRITICAL ) == IOT_TASKPOOL_SUCCESS );
+            TEST_ASSERT( IotTaskPool_Schedule( taskPool, jobs[ count ], 0 ) == IOT_TASKPOOL_SUCCESS );
+        }
+
+        /* Release the worker and wait for all jobs to execute. */
+        IotSemaphore_Post( &blockingContext.block );
+
+        WaitForOrderCounter( &orderContext, TEST_TASKPOOL_PRIORITY_JOBS );
+
+        /* The bulk job runs right after it was passed over IOT_TASKPOOL_STARVATION_LIMIT times. */
+        for( count = 0; count < IOT_TASKPOOL_STARVATION_LIMIT; ++count )
+        {
+            TEST_ASSERT( orderContext.order[ count ] == jobs[ count + 1 ] );
+        }
+
+        TEST_ASSERT( orderContext.order[ IOT_TASKPOOL_STARVATION_LIMIT ] == jobs[ 0 ] );
+    }
+
+    TEST_ASSERT( IotTaskPool_Destroy( taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    /* Destroy user contexts. */
+    IotSemaphore_Destroy( &blockingContext.signal );
+    IotSemaphore_Destroy( &blockingContext.block );
+    IotMutex_Destroy( &orderContext.lock );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that task pool statistics count every executed job in its priority class.
+ */
+TEST( Common_Unit_Task_Pool, GetStatistics )
+{
+    IotTaskPool_t taskPool = IOT_TASKPOOL_INITIALIZER;
+    const IotTaskPoolInfo_t tpInfo = { .minThreads = 2, .maxThreads = 3, .stackSize = IOT_THREAD_DEFAULT_STACK_SIZE, .priority = IOT_THREAD_DEFAULT_PRIORITY };
+
+    JobOrderUserContext_t orderContext;
+    IotTaskPoolStatistics_t statistics;
+
+    memset( &orderContext, 0, sizeof( JobOrderUserContext_t ) );
+
+    /* Initialize user context. */
+    TEST_ASSERT_TRUE( IotMutex_Create( &orderContext.lock, false ) );
+
+    TEST_ASSERT( IotTaskPool_Create( &tpInfo, &taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    if( TEST_PROTECT() )
+    {
+        uint32_t count, level, bucket, total;
+        IotTaskPoolJobStorage_t jobsStorage[ TEST_TASKPOOL_PRIORITY_JOBS ];
+        IotTaskPoolJob_t jobs[ TEST_TASKPOOL_PRIORITY_JOBS ];
+
+        TEST_ASSERT( IotTaskPool_GetStatistics( NULL, &statistics ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_GetStatistics( taskPool, NULL ) == IOT_TASKPOOL_BAD_PARAMETER );
+
+        /* A new task pool has not executed anything. */
+        TEST_ASSERT( IotTaskPool_GetStatistics( taskPool, &statistics ) == IOT_TASKPOOL_SUCCESS );
+
+        for( level = 0; level < IOT_TASKPOOL_JOB_PRIORITY_LEVELS; ++level )
+        {
+            TEST_ASSERT_EQUAL( 0, statistics.jobsScheduled[ level ] );
+            TEST_ASSERT_EQUAL( 0, statistics.jobsCompleted[ level ] );
+        }
+
+        /* Spread the jobs over all classes. */
+        for( count = 0; count < TEST_TASKPOOL_PRIORITY_JOBS; ++count )
+        {
+            TEST_ASSERT( IotTaskPool_CreateJob( &ExecutionRecordOrderCb, &orderContext, &jobsStorage[ count ], &jobs[ count ] ) == IOT_TASKPOOL_SUCCESS );
+            TEST_ASSERT( IotTaskPool_SetJobPriority( taskPool,
+                                                     jobs[ count ],
+                                                     ( IotTaskPoolJobPriority_t ) ( count % IOT_TASKPOOL_JOB_PRIORITY_LEVELS ) ) == IOT_TASKPOOL_SUCCESS );
+            TEST_ASSERT( IotTaskPool_Schedule( taskPool, jobs[ count ], 0 ) == IOT_TASKPOOL_SUCCESS );
+        }
+
+        WaitForOrderCounter( &orderContext, TEST_TASKPOOL_PRIORITY_JOBS );
+
+        #if IOT_TASKPOOL_ENABLE_STATISTICS == 1
+            /* Run times are recorded after the callbacks return. */
+            while( true )
+            {
+                TEST_ASSERT( IotTaskPool_GetStatistics( taskPool, &statistics ) == IOT_TASKPOOL_SUCCESS );
+
+                total = 0;
+
+                for( level = 0; level < IOT_TASKPOOL_JOB_PRIORITY_LEVELS; ++level )
+                {
+                    total += statistics.jobsCompleted[ level ];
+                }
+
+                if( total == TEST_TASKPOOL_PRIORITY_JOBS )
+                {
+                    break;
+                }
+
+                IotClock_SleepMs( 50 );
+            }
+
+            for( level = 0; level < IOT_TASKPOOL_JOB_PRIORITY_LEVELS; ++level )
+            {
+                uint32_t expected = ( TEST_TASKPOOL_PRIORITY_JOBS + IOT_TASKPOOL_JOB_PRIORITY_LEVELS - 1 - level ) / IOT_TASKPOOL_JOB_PRIORITY_LEVELS;
+                uint32_t queueWaitTotal = 0, runTimeTotal = 0;
+
+                for( bucket = 0; bucket < IOT_TASKPOOL_HISTOGRAM_BUCKETS; ++bucket )
+                {
+                    queueWaitTotal += statistics.queueWait[ level ][ bucket ];
+                    runTimeTotal += statistics.runTime[ level ][ bucket ];
+                }
+
+                TEST_ASSERT_EQUAL( expected, statistics.jobsScheduled[ level ] );
+                TEST_ASSERT_EQUAL( expected, statistics.jobsCompleted[ level ] );
+                TEST_ASSERT_EQUAL( expected, queueWaitTotal );
+                TEST_ASSERT_EQUAL( expected, runTimeTotal );
+            }
+        #else /* if IOT_TASKPOOL_ENABLE_STATISTICS == 1 */
+            ( void ) bucket;
+            ( void ) total;
+
+            TEST_ASSERT( IotTaskPool_GetStatistics( taskPool, &statistics ) == IOT_TASKPOOL_SUCCESS );
+
+            for( level = 0; level < IOT_TASKPOOL_JOB_PRIORITY_LEVELS; ++level )
+            {
+                TEST_ASSERT_EQUAL( 0, statistics.jobsCompleted[ level ] );
+            }
+        #endif /* if IOT_TASKPOOL_ENABLE_STATISTICS == 1 */
+    }
+
+    TEST_ASSERT( IotTaskPool_Destroy( taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    /* Destroy user context. */
+    IotMutex_Destroy( &orderContext.lock );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test scheduling and creating jobs in batches, with both legal and illegal parameters.
+ */
+TEST( Common_Unit_Task_Pool, ScheduleBatch )
+{
+    IotTaskPool_t taskPool = IOT_TASKPOOL_INITIALIZER;
+    const IotTaskPoolInfo_t tpInfo = { .minThreads = 2, .maxThreads = 3, .stackSize = IOT_THREAD_DEFAULT_STACK_SIZE, .priority = IOT_THREAD_DEFAULT_PRIORITY };
+
+    JobUserContext_t userContext;
+    JobBlockingUserContext_t blockingContext;
+
+    memset( &userContext, 0, sizeof( JobUserContext_t ) );
+
+    /* Initialize user contexts. */
+    TEST_ASSERT_TRUE( IotMutex_Create( &userContext.lock, false ) );
+    TEST_ASSERT( IotSemaphore_Create( &blockingContext.signal, 0, 1 ) );
+    TEST_ASSERT( IotSemaphore_Create( &blockingContext.block, 0, 1 ) );
+
+    TEST_ASSERT( IotTaskPool_Create( &tpInfo, &taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    if( TEST_PROTECT() )
+    {
+        uint32_t count;
+        void * pContexts[ TEST_TASKPOOL_NUMBER_OF_JOBS ];
+        IotTaskPoolJob_t jobs[ TEST_TASKPOOL_NUMBER_OF_JOBS ];
+        IotTaskPoolJobStorage_t blockingJobStorage;
+        IotTaskPoolJob_t batch[ 2 ];
+        IotTaskPoolJobStatus_t jobStatus;
+
+        for( count = 0; count < TEST_TASKPOOL_NUMBER_OF_JOBS; ++count )
+        {
+            pContexts[ count ] = &userContext;
+            jobs[ count ] = IOT_TASKPOOL_JOB_INITIALIZER;
+        }
+
+        /* Illegal parameters. */
+        TEST_ASSERT( IotTaskPool_CreateRecyclableJobs( NULL, &ExecutionCountAndRecycleCb, pContexts, jobs, TEST_TASKPOOL_NUMBER_OF_JOBS ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_CreateRecyclableJobs( taskPool, NULL, pContexts, jobs, TEST_TASKPOOL_NUMBER_OF_JOBS ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_CreateRecyclableJobs( taskPool, &ExecutionCountAndRecycleCb, pContexts, NULL, TEST_TASKPOOL_NUMBER_OF_JOBS ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_CreateRecyclableJobs( taskPool, &ExecutionCountAndRecycleCb, pContexts, jobs, 0 ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_ScheduleBatch( NULL, jobs, TEST_TASKPOOL_NUMBER_OF_JOBS ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_ScheduleBatch( taskPool, NULL, TEST_TASKPOOL_NUMBER_OF_JOBS ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_ScheduleBatch( taskPool, jobs, 0 ) == IOT_TASKPOOL_BAD_PARAMETER );
+        TEST_ASSERT( IotTaskPool_ScheduleBatch( taskPool, jobs, TEST_TASKPOOL_NUMBER_OF_JOBS ) == IOT_TASKPOOL_BAD_PARAMETER );
+
+        /* Create and schedule a batch, then wait for all callbacks. */
+        TEST_ASSERT( IotTaskPool_CreateRecyclableJobs( taskPool, &ExecutionCountAndRecycleCb, pContexts, jobs, TEST_TASKPOOL_NUMBER_OF_JOBS ) == IOT_TASKPOOL_SUCCESS );
+
+        for( count = 0; count < TEST_TASKPOOL_NUMBER_OF_JOBS; ++count )
+        {
+            TEST_ASSERT( jobs[ count ] != IOT_TASKPOOL_JOB_INITIALIZER );
+            TEST_ASSERT( IotTaskPool_GetStatus( taskPool, jobs[ count ], &jobStatus ) == IOT_TASKPOOL_SUCCESS );
+            TEST_ASSERT( jobStatus == IOT_TASKPOOL_STATUS_READY );
+        }
+
+        TEST_ASSERT( IotTaskPool_ScheduleBatch( taskPool, jobs, TEST_TASKPOOL_NUMBER_OF_JOBS ) == IOT_TASKPOOL_SUCCESS );
+
+        WaitForCounter( &userContext, TEST_TASKPOOL_NUMBER_OF_JOBS );
+        TEST_ASSERT_EQUAL( TEST_TASKPOOL_NUMBER_OF_JOBS, userContext.counter );
+
+        /* A batch holding an executing job is rejected as a whole. */
+        TEST_ASSERT( IotTaskPool_CreateJob( &ExecutionBlockingWithoutDestroyCb, &blockingContext, &blockingJobStorage, &batch[ 1 ] ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_Schedule( taskPool, batch[ 1 ], 0 ) == IOT_TASKPOOL_SUCCESS );
+        IotSemaphore_Wait( &blockingContext.signal );
+
+        TEST_ASSERT( IotTaskPool_CreateRecyclableJobs( taskPool, &ExecutionCountAndRecycleCb, pContexts, &batch[ 0 ], 1 ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( IotTaskPool_ScheduleBatch( taskPool, batch, 2 ) == IOT_TASKPOOL_ILLEGAL_OPERATION );
+        TEST_ASSERT( IotTaskPool_GetStatus( taskPool, batch[ 0 ], &jobStatus ) == IOT_TASKPOOL_SUCCESS );
+        TEST_ASSERT( jobStatus == IOT_TASKPOOL_STATUS_READY );
+
+        IotSemaphore_Post( &blockingContext.block );
+
+        TEST_ASSERT( IotTaskPool_ScheduleBatch( taskPool, batch, 1 ) == IOT_TASKPOOL_SUCCESS );
+
+        WaitForCounter( &userContext, TEST_TASKPOOL_NUMBER_OF_JOBS + 1 );
+    }
+
+    TEST_ASSERT( IotTaskPool_Destroy( taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    /* Destroy user contexts. */
+    IotMutex_Destroy( &userContext.lock );
+    IotSemaphore_Destroy( &blockingContext.signal );
+    IotSemaphore_Destroy( &blockingContext.block );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measure the time to create and execute recyclable jobs one by one and in batches of 1, 8 and 64.
+ */
+TEST( Common_Unit_Task_Pool, ScheduleBatchThroughput )
+{
+    IotTaskPool_t taskPool = IOT_TASKPOOL_INITIALIZER;
+    const IotTaskPoolInfo_t tpInfo = { .minThreads = 2, .maxThreads = 3, .stackSize = IOT_THREAD_DEFAULT_STACK_SIZE, .priority = IOT_THREAD_DEFAULT_PRIORITY };
+    const uint32_t batchSizes[] = { 1, 8, TEST_TASKPOOL_MAX_BATCH };
+
+    JobUserContext_t userContext;
+
+    memset( &userContext, 0, sizeof( JobUserContext_t ) );
+
+    /* Initialize user context. */
+    TEST_ASSERT_TRUE( IotMutex_Create( &userContext.lock, false ) );
+
+    TEST_ASSERT( IotTaskPool_Create( &tpInfo, &taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    if( TEST_PROTECT() )
+    {
+        uint32_t count, size, scheduled;
+        uint64_t startTime = 0, elapsedTime = 0;
+        void * pContexts[ TEST_TASKPOOL_MAX_BATCH ];
+        IotTaskPoolJob_t jobs[ TEST_TASKPOOL_MAX_BATCH ];
+
+        for( count = 0; count < TEST_TASKPOOL_MAX_BATCH; ++count )
+        {
+            pContexts[ count ] = &userContext;
+        }
+
+        /* Reference: one job per call. */
+        userContext.counter = 0;
+        startTime = IotClock_GetTimeMs();
+
+        for( count = 0; count < TEST_TASKPOOL_BATCH_BENCHMARK_JOBS; ++count )
+        {
+            TEST_ASSERT( IotTaskPool_CreateRecyclableJob( taskPool, &ExecutionCountAndRecycleCb, &userContext, &jobs[ 0 ] ) == IOT_TASKPOOL_SUCCESS );
+            TEST_ASSERT( IotTaskPool_Schedule( taskPool, jobs[ 0 ], 0 ) == IOT_TASKPOOL_SUCCESS );
+        }
+
+        WaitForCounter( &userContext, TEST_TASKPOOL_BATCH_BENCHMARK_JOBS );
+        elapsedTime = IotClock_GetTimeMs() - startTime;
+
+        UnityPrint( "Schedule, " );
+        UnityPrintNumber( TEST_TASKPOOL_BATCH_BENCHMARK_JOBS );
+        UnityPrint( " jobs: " );
+        UnityPrintNumber( ( UNITY_INT ) elapsedTime );
+        UnityPrint( " ms." );
+        UNITY_PRINT_EOL();
+
+        for( size = 0; size < ( sizeof( batchSizes ) / sizeof( batchSizes[ 0 ] ) ); ++size )
+        {
+            userContext.counter = 0;
+            startTime = IotClock_GetTimeMs();
+
+            for( scheduled = 0; scheduled < TEST_TASKPOOL_BATCH_BENCHMARK_JOBS; scheduled += batchSizes[ size ] )
+            {
+                TEST_ASSERT( IotTaskPool_CreateRecyclableJobs( taskPool, &ExecutionCountAndRecycleCb, pContexts, jobs, batchSizes[ size ] ) == IOT_TASKPOOL_SUCCESS );
+                TEST_ASSERT( IotTaskPool_ScheduleBatch( taskPool, jobs, batchSizes[ size ] ) == IOT_TASKPOOL_SUCCESS );
+            }
+
+            WaitForCounter( &userContext, scheduled );
+            elapsedTime = IotClock_GetTimeMs() - startTime;
+
+            UnityPrint( "ScheduleBatch of " );
+            UnityPrintNumber( ( UNITY_INT ) batchSizes[ size ] );
+            UnityPrint( ", " );
+            UnityPrintNumber( ( UNITY_INT ) scheduled );
+            UnityPrint( " jobs: " );
+            UnityPrintNumber( ( UNITY_INT ) elapsedTime );
+            UnityPrint( " ms." );
+            UNITY_PRINT_EOL();
+        }
+    }
+
+    TEST_ASSERT( IotTaskPool_Destroy( taskPool ) == IOT_TASKPOOL_SUCCESS );
+
+    /* Destroy user context. */
+    IotMutex_Destroy( &userContext.lock );
+}
+
+/*-----------------------------------------------------------*/
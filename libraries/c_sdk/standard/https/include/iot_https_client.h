@@ -70,6 +70,8 @@
  * @function_brief{https_client_function_readheader}
  * - @function_name{https_client_function_readresponsebody}
  * @function_brief{https_client_function_readresponsebody}
+ * - @function_name{https_client_function_download}
+ * @function_brief{https_client_function_download}
  */
 
 /**
@@ -118,6 +120,9 @@
  * @page https_client_function_readresponsebody IotHttpsClient_ReadResponseBody
  * @snippet this declare_https_client_readresponsebody
  * @copydoc IotHttpsClient_ReadResponseBody
+ * @page https_client_function_download IotHttpsClient_Download
+ * @snippet this declare_https_client_download
+ * @copydoc IotHttpsClient_Download
  */
 
 
@@ -202,6 +207,9 @@ void IotHttpsClient_Cleanup( void );
  * See @ref connectionUserBufferMinimumSize for information about the user buffer configured in
  * #IotHttpsConnectionInfo_t.userBuffer needed to create a valid connection handle.
  *
+ * If @ref IOT_HTTPS_POOLED_CONNECTION_FLAG is set in #IotHttpsConnectionInfo_t.flags, then this function returns an
+ * idle connection to the same server from the connection pool, if there is one, without a new TLS handshake.
+ *
  * @param[out] pConnHandle - Handle returned representing the open connection. NULL if the function failed.
  * @param[in] pConnInfo - Configurations for the HTTPS connection.
  *
@@ -284,6 +292,10 @@ IotHttpsReturnCode_t IotHttpsClient_Connect( IotHttpsConnectionHandle_t * pConnH
  * @ref https_client_function_sendsync has returned or when #IotHttpsClientCallbacks_t.responseCompleteCallback
  * has been invoked for requests scheduled with @ref https_client_function_sendasync.
  *
+ * A connection created with @ref IOT_HTTPS_POOLED_CONNECTION_FLAG is given back to the connection pool instead, and is
+ * kept open for reuse if it is healthy and the pool has fewer than @ref IOT_HTTPS_CONNECTION_POOL_MAX_IDLE idle
+ * connections. The connection handle must not be used after this function returns #IOT_HTTPS_OK.
+ *
  * @param[in] connHandle - Valid handle representing an open connection.
  *
  * @return One of the following:
@@ -536,7 +548,12 @@ IotHttpsReturnCode_t IotHttpsClient_WriteRequestBody( IotHttpsRequestHandle_t re
  * function for a different #IotHttpsRequestHandle_t, even on the same #IotHttpsConnectionHandle_t. An application must
  * wait util a request is fully sent, before scheduling it again. A request is fully sent when this function has returned.
  *
- * @param[in] connHandle - Handle from an HTTPS connection created with @ref https_client_function_connect.
+ * If connHandle is NULL and the request was initialized with #IotHttpsRequestInfo_t.pConnInfo, then the request is
+ * sent on a persistent connection borrowed from the connection pool. A connection is created if there is no idle
+ * connection to the same server. The connection is given back to the pool once the response is received.
+ *
+ * @param[in] connHandle - Handle from an HTTPS connection created with @ref https_client_function_connect, or NULL to
+ * use a pooled connection.
  * @param[in] reqHandle - Handle from a request created with @ref https_client_function_initializerequest.
  * @param[out] pRespHandle - HTTPS response handle resulting from a successful send and receive.
  * @param[in] pRespInfo - HTTP response configuration information.
@@ -583,7 +600,11 @@ IotHttpsReturnCode_t IotHttpsClient_SendSync( IotHttpsConnectionHandle_t connHan
  * #IotHttpsClientCallbacks_t.readReadyCallback is invoked the #IotHttpsRequestInfo_t.userBuffer can freed,
  * modified, or reused.
  *
- * @param[in] connHandle - Handle from an HTTPS connection.
+ * If connHandle is NULL and the request was initialized with #IotHttpsRequestInfo_t.pConnInfo, then the request is
+ * sent on a persistent connection borrowed from the connection pool, which is given back to the pool once the response
+ * is received.
+ *
+ * @param[in] connHandle - Handle from an HTTPS connection, or NULL to use a pooled connection.
  * @param[in] reqHandle - Handle from a request created with IotHttpsClient_initialize_request.
  * @param[out] pRespHandle - HTTPS response handle.
  * @param[in] pRespInfo - HTTP response configuration information.
@@ -895,4 +916,62 @@ IotHttpsReturnCode_t IotHttpsClient_ReadResponseBody( IotHttpsResponseHandle_t r
                                                       uint32_t * pLen );
 /* @[declare_https_client_readresponsebody] */
 
+/**
+ * @brief Download a resource with parallel HTTP Range requests into a positional sink.
+ *
+ * The resource is split into ranges of #IotHttpsDownloadInfo_t.rangeSize bytes. Each of the
+ * #IotHttpsDownloadInfo_t.numConnections connections, taken from the connection pool, downloads one range at a time
+ * with an asynchronous "Range: bytes=N-M" GET request and takes the next range not yet requested when it is done. The
+ * body of each response is read from the network into the body buffer of its connection and passed from there to
+ * #IotHttpsDownloadInfo_t.sink with its offset in the resource, without being buffered anywhere else.
+ *
+ * If a request fails, its connection is closed and the rest of its range is requested again on a new connection, up
+ * to #IotHttpsDownloadInfo_t.maxRetries times. Failures of the sink and servers that do not support Range requests are
+ * not retried.
+ *
+ * If #IotHttpsDownloadInfo_t.fileSize is zero, the first range is requested alone and the size of the resource is read
+ * from the Content-Range header of its response. A server that answers this request with the whole resource, with
+ * status 200 OK, is accepted and the resource is downloaded on this single connection.
+ *
+ * This function blocks until the download is complete or failed. When it returns, the connections are idle in the
+ * connection pool, to be reused by the next requests to the same server.
+ *
+ * <b> Example </b>
+ * @code{c}
+ * bool applicationDefined_sink( void * pContext, uint32_t offset, const uint8_t * pData, uint32_t dataLen )
+ * {
+ *      return prvPAL_WriteBlock( pContext, offset, pData, dataLen ) == dataLen;
+ * }
+ *
+ * IotHttpsDownloadInfo_t downloadInfo = IOT_HTTPS_DOWNLOAD_INFO_INITIALIZER;
+ * downloadInfo.pConnInfo = &connInfo;
+ * downloadInfo.pPath = "/path/to/image.bin";
+ * downloadInfo.pathLen = strlen( downloadInfo.pPath );
+ * downloadInfo.rangeSize = 16384;
+ * downloadInfo.numConnections = 4;
+ * downloadInfo.maxRetries = 3;
+ * downloadInfo.sink = applicationDefined_sink;
+ * downloadInfo.pSinkContext = pFileContext;
+ * downloadInfo.userBuffer.pBuffer = downloadUserBuffer;
+ * downloadInfo.userBuffer.bufferLen = sizeof( downloadUserBuffer );
+ * status = IotHttpsClient_Download( &downloadInfo, &fileSize );
+ * @endcode
+ *
+ * @param[in] pDownloadInfo - Configuration of the download.
+ * @param[out] pFileSize - The size of the resource. This may be NULL.
+ *
+ * @return One of the following:
+ * - #IOT_HTTPS_OK if the whole resource was written to the sink.
+ * - #IOT_HTTPS_INVALID_PARAMETER if there are NULL parameters or if a size in the configuration is zero.
+ * - #IOT_HTTPS_INSUFFICIENT_MEMORY if #IotHttpsDownloadInfo_t.userBuffer is too small for the number of connections.
+ * - #IOT_HTTPS_NOT_SUPPORTED if the server did not answer a Range request with 206 Partial Content.
+ * - #IOT_HTTPS_USER_CALLBACK_ERROR if the sink failed.
+ * - #IOT_HTTPS_PROTOCOL_ERROR if a response did not match its range.
+ * - The error of the last retry of a range if it could not be downloaded.
+ */
+/* @[declare_https_client_download] */
+IotHttpsReturnCode_t IotHttpsClient_Download( const IotHttpsDownloadInfo_t * pDownloadInfo,
+                                              uint32_t * pFileSize );
+/* @[declare_https_client_download] */
+
 #endif /* IOT_HTTPS_CLIENT_ */
@@ -57,6 +57,8 @@
  *   @copybrief responseUserBufferMinimumSize
  * - @ref connectionUserBufferMinimumSize <br>
  *   @copybrief connectionUserBufferMinimumSize
+ * - @ref downloadUserBufferMinimumSize <br>
+ *   @copybrief downloadUserBufferMinimumSize
  *
  * @section https_connection_flags HTTPS Client Connection Flags
  * @brief Flags that modify the behavior of the HTTPS Connection.
@@ -88,6 +90,7 @@
  * IotHttpsConnectionInfo_t connInfo = IOT_HTTPS_CONNECTION_INFO_INITIALIZER;
  * IotHttpsRequestInfo_t reqInfo = IOT_HTTPS_REQUEST_INFO_INITIALIZER
  * IotHttpsResponseInfo_t respInfo = IOT_HTTPS_RESPONSE_INFO_INITIALIZER
+ * IotHttpsDownloadInfo_t downloadInfo = IOT_HTTPS_DOWNLOAD_INFO_INITIALIZER
  * @endcode
  *
  * @section http_constants_connection_flags HTTPS Client Connection Flags
@@ -96,6 +99,8 @@
  *   @copybrief IOT_HTTPS_IS_NON_TLS_FLAG
  * - #IOT_HTTPS_DISABLE_SNI <br>
  *   @copybrief IOT_HTTPS_DISABLE_SNI
+ * - #IOT_HTTPS_POOLED_CONNECTION_FLAG <br>
+ *   @copybrief IOT_HTTPS_POOLED_CONNECTION_FLAG
  */
 
 /**
@@ -169,6 +174,29 @@ extern const uint32_t responseUserBufferMinimumSize;
  */
 extern const uint32_t connectionUserBufferMinimumSize;
 
+/**
+ * @brief The minimum user buffer size for each connection of a ranged download.
+ *
+ * This helps to calculate the size of the buffer needed for #IotHttpsDownloadInfo_t.userBuffer.
+ *
+ * @ref https_client_function_download splits #IotHttpsDownloadInfo_t.userBuffer into an equal share for each of the
+ * #IotHttpsDownloadInfo_t.numConnections connections. Each share holds the download context of the connection, the
+ * connection, request, and response contexts, the request and response headers, and the buffer that the response body
+ * is received into. This minimum does not account for the length of #IotHttpsDownloadInfo_t.pPath nor for the length
+ * of the host name, which must be added to each share. Any space left in a share makes its body buffer larger, so
+ * that the sink is called with larger blocks.
+ *
+ * A typical value for sizing the download user buffer is 2048 bytes for each connection. See the example below.
+ * @code{c}
+ * uint8_t downloadUserBuffer[ 4 * 2048 ] = { 0 };
+ * IotHttpsDownloadInfo_t downloadInfo = IOT_HTTPS_DOWNLOAD_INFO_INITIALIZER;
+ * downloadInfo.numConnections = 4;
+ * downloadInfo.userBuffer.pBuffer = downloadUserBuffer;
+ * downloadInfo.userBuffer.bufferLen = sizeof( downloadUserBuffer );
+ * @endcode
+ */
+extern const uint32_t downloadUserBufferMinimumSize;
+
 /**
  * @brief Flag for #IotHttpsConnectionInfo_t that disables TLS.
  *
@@ -185,6 +213,21 @@ extern const uint32_t connectionUserBufferMinimumSize;
  */
 #define IOT_HTTPS_DISABLE_SNI        ( 0x00000008 )
 
+/**
+ * @brief Flag for #IotHttpsConnectionInfo_t that keeps the connection in the connection pool.
+ *
+ * Set this bit in #IotHttpsConnectionInfo_t.flags to have @ref https_client_function_connect reuse an idle persistent
+ * connection to the same server, instead of connecting and performing a new TLS handshake. An idle connection is
+ * reused only if the server address, port, flags, network interface, ALPN protocols, and credentials are the same.
+ * @ref https_client_function_disconnect gives a pooled connection back to the pool, where it is kept open for at
+ * most @ref IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS. After a call to @ref https_client_function_disconnect, the
+ * connection handle must not be used again.
+ *
+ * The connection context of a pooled connection is stored in the pool, so #IotHttpsConnectionInfo_t.userBuffer is
+ * used only if all @ref IOT_HTTPS_CONNECTION_POOL_SIZE entries of the pool are in use.
+ */
+#define IOT_HTTPS_POOLED_CONNECTION_FLAG    ( 0x00000010 )
+
 /* @[define_https_initializers] */
 /** @brief Initializer for #IotHttpsConnectionHandle_t. */
 #define IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER    NULL
@@ -204,6 +247,8 @@ extern const uint32_t connectionUserBufferMinimumSize;
 #define IOT_HTTPS_REQUEST_INFO_INITIALIZER         { 0 }
 /** @brief Initializer for #IotHttpsResponseInfo_t. */
 #define IOT_HTTPS_RESPONSE_INFO_INITIALIZER        { 0 }
+/** @brief Initializer for #IotHttpsDownloadInfo_t. */
+#define IOT_HTTPS_DOWNLOAD_INFO_INITIALIZER        { 0 }
 /* @[define_https_initializers] */
 
 /* Network include for the network types below. */
@@ -841,6 +886,18 @@ typedef struct IotHttpsRequestInfo
      */
     bool isNonPersistent;
 
+    /**
+     * @brief Connection configuration for sending this request without an explicit connection.
+     *
+     * If this is not NULL and a NULL connection handle is passed to @ref https_client_function_sendsync or
+     * @ref https_client_function_sendasync, then the request is sent on a connection borrowed from the connection
+     * pool, as if #IOT_HTTPS_POOLED_CONNECTION_FLAG were set in the configuration. The connection is given back to the
+     * pool as soon as the response is received.
+     *
+     * This may be NULL if the request is always sent on an explicit connection.
+     */
+    IotHttpsConnectionInfo_t * pConnInfo;
+
     /**
      * @brief Application owned buffer for storing the request headers and internal request context.
      *
@@ -902,4 +959,83 @@ typedef struct IotHttpsResponseInfo
     IotHttpsSyncInfo_t * pSyncInfo;
 } IotHttpsResponseInfo_t;
 
+/**
+ * @ingroup https_client_datatypes_paramstructs
+ * @brief Positional sink that receives the data of a ranged download.
+ *
+ * @paramfor @ref https_client_function_download
+ *
+ * The sink is called with each block of the resource as soon as it is received on a connection, straight from the
+ * buffer it was received into. Blocks of different connections arrive out of order, but calls to the sink are
+ * serialized. This signature matches writing a block of an OTA image at an offset, e.g. with the OTA PAL
+ * `prvPAL_WriteBlock()`.
+ *
+ * @param[in] pSinkContext - User context configured in #IotHttpsDownloadInfo_t.pSinkContext.
+ * @param[in] offset - Offset of pData in the resource.
+ * @param[in] pData - The data received. It is valid only during this call.
+ * @param[in] dataLen - The length of pData.
+ *
+ * @return `true` if the data was written; `false` to abort the download.
+ */
+typedef bool ( * IotHttpsDownloadSink_t )( void * pSinkContext,
+                                           uint32_t offset,
+                                           const uint8_t * pData,
+                                           uint32_t dataLen );
+
+/**
+ * @ingroup https_client_datatypes_paramstructs
+ * @brief HTTP ranged download configuration.
+ *
+ * @paramfor @ref https_client_function_download
+ *
+ * The resource is downloaded with HTTP Range requests of #IotHttpsDownloadInfo_t.rangeSize bytes, sent in parallel on
+ * #IotHttpsDownloadInfo_t.numConnections connections of the connection pool.
+ *
+ * @note The lengths of the strings in this struct should not include the NULL
+ * terminator. Strings in this struct do not need to be NULL-terminated.
+ */
+typedef struct IotHttpsDownloadInfo
+{
+    /**
+     * @brief Configuration of the connections to the server.
+     *
+     * The connections are taken from the connection pool, as if #IOT_HTTPS_POOLED_CONNECTION_FLAG were set in the
+     * configuration, and are given back to the pool when the download is done. #IotHttpsConnectionInfo_t.pAddress is
+     * also used as the Host header of the requests. #IotHttpsConnectionInfo_t.userBuffer is ignored.
+     */
+    const IotHttpsConnectionInfo_t * pConnInfo;
+
+    const char * pPath; /**< @brief The absolute path to the resource, as in #IotHttpsRequestInfo_t.pPath. */
+    uint32_t pathLen;   /**< @brief URI path length. */
+
+    /**
+     * @brief Size of the resource in bytes.
+     *
+     * If this is zero, the size is learned from the response to the first range request, which is sent before any
+     * other request.
+     */
+    uint32_t fileSize;
+
+    uint32_t rangeSize;      /**< @brief Number of bytes requested in each Range request. Must not be zero. */
+    uint32_t numConnections; /**< @brief Number of connections used in parallel. Must not be zero. */
+
+    /**
+     * @brief Number of times the rest of a range is requested again after its request failed.
+     *
+     * Each retry is sent on a new connection and resumes at the first byte not yet written to the sink. The count is
+     * reset each time a range is completed.
+     */
+    uint32_t maxRetries;
+
+    IotHttpsDownloadSink_t sink; /**< @brief The sink the resource is written to. */
+    void * pSinkContext;         /**< @brief User context passed to #IotHttpsDownloadInfo_t.sink. */
+
+    /**
+     * @brief Application owned buffer for the contexts, headers, and body buffers of the connections.
+     *
+     * See @ref downloadUserBufferMinimumSize for the size of this buffer.
+     */
+    IotHttpsUserBuffer_t userBuffer;
+} IotHttpsDownloadInfo_t;
+
 #endif /* ifndef IOT_HTTPS_TYPES_H_ */
@@ -125,6 +125,24 @@ const uint32_t responseUserBufferMinimumSize = sizeof( _httpsResponse_t );
  */
 const uint32_t connectionUserBufferMinimumSize = sizeof( _httpsConnection_t );
 
+/**
+ * @brief Minimum size of each connection's share of the download user buffer.
+ *
+ * The download user buffer is configured in IotHttpsDownloadInfo_t.userBuffer. Each connection's share stores the
+ * download context of the connection, the connection context, the response context with space for the response
+ * headers, the request context with the request headers and the Range header, and the buffer the response body is
+ * received into. The length of the path and of the host name must be added to this minimum.
+ */
+const uint32_t downloadUserBufferMinimumSize = HTTPS_DOWNLOAD_ALIGN( sizeof( _httpsDownloadConnection_t ) ) +
+                                               HTTPS_DOWNLOAD_ALIGN( sizeof( _httpsConnection_t ) ) +
+                                               HTTPS_DOWNLOAD_ALIGN( sizeof( _httpsResponse_t ) + IOT_HTTPS_DOWNLOAD_RESPONSE_HEADERS_SIZE ) +
+                                               sizeof( _httpsRequest_t ) +
+                                               sizeof( HTTPS_PARTIAL_REQUEST_LINE ) +
+                                               sizeof( HTTPS_USER_AGENT_HEADER_LINE ) +
+                                               sizeof( HTTPS_PARTIAL_HOST_HEADER_LINE ) +
+                                               HTTPS_MAX_RANGE_LINE_LENGTH +
+                                               HTTPS_DOWNLOAD_MINIMUM_BODY_BUFFER_SIZE;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -324,6 +342,101 @@ static void _networkDisconnect( _httpsConnection_t * pHttpsConnection );
  */
 static void _networkDestroy( _httpsConnection_t * pHttpsConnection );
 
+/**
+ * @brief Disconnects from the server and destroys the network connection.
+ *
+ * Unlike @ref https_client_function_disconnect, this always closes the connection, even if it is pooled. The
+ * connection pool entry of a pooled connection remains in use until the connection is given back to the pool.
+ *
+ * @param[in] pHttpsConnection - HTTPS connection handle.
+ *
+ * @return #IOT_HTTPS_OK if the connection was disconnected and destroyed.
+ *         #IOT_HTTPS_BUSY if a request is still sending on the connection.
+ */
+static IotHttpsReturnCode_t _disconnectHttpsConnection( _httpsConnection_t * pHttpsConnection );
+
+/**
+ * @brief Connects to HTTPS server, reusing an idle connection from the connection pool if possible.
+ *
+ * If every entry of the pool is in use, a connection that is not pooled is created in
+ * #IotHttpsConnectionInfo_t.userBuffer.
+ *
+ * @param[out] pConnHandle - The out parameter to return handle representing the open connection.
+ * @param[in] pConnInfo - The connection configuration.
+ *
+ * @return #IOT_HTTPS_OK if a connection was reused or created.
+ *         Otherwise, the error codes of _createHttpsConnection().
+ */
+static IotHttpsReturnCode_t _connectPooledConnection( IotHttpsConnectionHandle_t * pConnHandle,
+                                                     IotHttpsConnectionInfo_t * pConnInfo );
+
+/**
+ * @brief Gives a connection borrowed for a request configured with #IotHttpsRequestInfo_t.pConnInfo back to the
+ * connection pool, once it has no more requests or responses in progress.
+ *
+ * This is called at the end of both the request sending and the response receiving, because either may finish last.
+ *
+ * @param[in] pHttpsConnection - HTTPS connection handle.
+ */
+static void _releaseImplicitConnection( _httpsConnection_t * pHttpsConnection );
+
+#if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+
+/**
+ * @brief Gives a pooled connection back to the connection pool.
+ *
+ * The connection is kept open as an idle connection if it is connected and healthy, and there are fewer than
+ * @ref IOT_HTTPS_CONNECTION_POOL_MAX_IDLE idle connections. Otherwise it is disconnected.
+ *
+ * @param[in] pHttpsConnection - HTTPS connection handle.
+ *
+ * @return #IOT_HTTPS_OK if the connection was kept idle or disconnected.
+ *         #IOT_HTTPS_BUSY if a request is still sending on the connection.
+ */
+    static IotHttpsReturnCode_t _releasePooledConnection( _httpsConnection_t * pHttpsConnection );
+
+/**
+ * @brief Check if a pooled idle connection can be reused for a connection configuration.
+ *
+ * @param[in] pEntry - The connection pool entry.
+ * @param[in] pConnInfo - The connection configuration.
+ *
+ * @return true if the key of the entry matches the configuration; false otherwise.
+ */
+    static bool _poolEntryMatches( const _httpsPooledConnection_t * pEntry,
+                                   const IotHttpsConnectionInfo_t * pConnInfo );
+
+/**
+ * @brief Check that an idle pooled connection is still connected and not in use.
+ *
+ * The server closing an idle connection is detected by the network receive callback, which disconnects it.
+ *
+ * @param[in] pEntry - The connection pool entry.
+ *
+ * @return true if the connection can be reused; false otherwise.
+ */
+    static bool _poolEntryIsHealthy( _httpsPooledConnection_t * pEntry );
+
+/**
+ * @brief Close the idle connections that exceeded @ref IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS, and schedule
+ * the eviction job for the connections that remain idle.
+ *
+ * @param[in] closeAll - Close all idle connections regardless of their idle time.
+ */
+    static void _evictIdleConnections( bool closeAll );
+
+/**
+ * @brief Task pool job that evicts timed out idle connections from the connection pool.
+ *
+ * @param[in] pTaskPool - Pointer to the system task pool.
+ * @param[in] pJob - Pointer the to the eviction job.
+ * @param[in] pUserContext - Not used.
+ */
+    static void _evictIdleConnectionsJob( IotTaskPool_t pTaskPool,
+                                          IotTaskPoolJob_t pJob,
+                                          void * pUserContext );
+#endif /* if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 ) */
+
 /**
  * @brief Add a header to the current HTTP request.
  *
@@ -629,6 +742,123 @@ static void _incrementNextLocationToWriteBeyondParsed( uint8_t ** pBufCur,
 static IotHttpsReturnCode_t _sendHttpsHeadersAndBody( _httpsConnection_t * pHttpsConnection,
                                                       _httpsRequest_t * pHttpsRequest );
 
+/**
+ * @brief Get the context of a connection of a ranged download from its share of the user buffer.
+ *
+ * @param[in] pDownload - The download in progress.
+ * @param[in] index - The index of the connection.
+ *
+ * @return The download context of the connection.
+ */
+static _httpsDownloadConnection_t * _getDownloadConnection( _httpsDownload_t * pDownload,
+                                                            uint32_t index );
+
+/**
+ * @brief Split the share of the user buffer of a connection of a ranged download and configure its requests.
+ *
+ * @param[in] pDownload - The download in progress.
+ * @param[in] index - The index of the connection.
+ */
+static void _initializeDownloadConnection( _httpsDownload_t * pDownload,
+                                           uint32_t index );
+
+/**
+ * @brief Give the next range to a connection of a ranged download that is not busy.
+ *
+ * A connection whose last request failed takes the rest of its own range again. Otherwise the connection takes the next
+ * range not yet requested. While the size of the resource is unknown, only the first range is given out.
+ *
+ * @param[in] pDownload - The download in progress.
+ * @param[in] pDownloadConnection - The connection to give a range to.
+ *
+ * @return `true` if the connection was given a range to request; `false` if there is none left.
+ */
+static bool _getNextDownloadRange( _httpsDownload_t * pDownload,
+                                   _httpsDownloadConnection_t * pDownloadConnection );
+
+/**
+ * @brief Connect if needed and send the asynchronous Range request of a connection of a ranged download.
+ *
+ * @param[in] pDownloadConnection - The connection of the download to send the request on.
+ *
+ * @return #IOT_HTTPS_OK if the request was scheduled, or the error of the connect or of the request.
+ */
+static IotHttpsReturnCode_t _startDownloadRequest( _httpsDownloadConnection_t * pDownloadConnection );
+
+/**
+ * @brief Record the result of the request of a connection of a ranged download and wake up the download.
+ *
+ * @param[in] pDownloadConnection - The connection of the download whose request is finished.
+ * @param[in] requestStatus - An error of the request, which is kept only if it is the first one.
+ */
+static void _finishDownloadRequest( _httpsDownloadConnection_t * pDownloadConnection,
+                                    IotHttpsReturnCode_t requestStatus );
+
+/**
+ * @brief Update the range of a connection of a ranged download after its request finished and decide on a retry.
+ *
+ * @param[in] pDownload - The download in progress.
+ * @param[in] pDownloadConnection - The connection of the download whose request is finished.
+ *
+ * @return #IOT_HTTPS_OK if the range was completed or will be retried, or the error that failed the download.
+ */
+static IotHttpsReturnCode_t _processDownloadResult( _httpsDownload_t * pDownload,
+                                                    _httpsDownloadConnection_t * pDownloadConnection );
+
+/**
+ * @brief Give the connection of a connection of a ranged download back to the pool or close it.
+ *
+ * @param[in] pDownloadConnection - The connection of the download.
+ * @param[in] keepAlive - Set to true to keep a healthy connection idle in the connection pool.
+ */
+static void _closeDownloadConnection( _httpsDownloadConnection_t * pDownloadConnection,
+                                      bool keepAlive );
+
+/**
+ * @brief Check the status and the Content-Range of a response to a Range request.
+ *
+ * If the size of the resource is not known yet, it is read from the Content-Range header, or from the Content-Length
+ * header if the server answered the first range request with the whole resource.
+ *
+ * @param[in] pDownloadConnection - The connection of the download that received the response.
+ * @param[in] respHandle - The response to the Range request.
+ * @param[in] responseStatus - The HTTP status of the response.
+ *
+ * @return #IOT_HTTPS_OK if the body of the response is the requested range; #IOT_HTTPS_TRY_AGAIN if the server
+ * is temporarily unable to answer; #IOT_HTTPS_NOT_SUPPORTED or #IOT_HTTPS_PROTOCOL_ERROR otherwise.
+ */
+static IotHttpsReturnCode_t _checkDownloadResponse( _httpsDownloadConnection_t * pDownloadConnection,
+                                                    IotHttpsResponseHandle_t respHandle,
+                                                    uint16_t responseStatus );
+
+/**
+ * @brief The #IotHttpsClientCallbacks_t.readReadyCallback of the requests of a ranged download.
+ *
+ * Reads the next block of the body into the body buffer of the connection and writes it to the sink at its offset.
+ *
+ * @param[in] pPrivData - The connection of the download the response was received on.
+ * @param[in] respHandle - The response in progress.
+ * @param[in] rc - The status of receiving the response so far.
+ * @param[in] status - The HTTP status of the response.
+ */
+static void _downloadReadReadyCallback( void * pPrivData,
+                                        IotHttpsResponseHandle_t respHandle,
+                                        IotHttpsReturnCode_t rc,
+                                        uint16_t status );
+
+/**
+ * @brief The #IotHttpsClientCallbacks_t.responseCompleteCallback of the requests of a ranged download.
+ *
+ * @param[in] pPrivData - The connection of the download the response was received on.
+ * @param[in] respHandle - The response that completed, or NULL if the request failed to send.
+ * @param[in] rc - The status of the request and response.
+ * @param[in] status - The HTTP status of the response.
+ */
+static void _downloadResponseCompleteCallback( void * pPrivData,
+                                               IotHttpsResponseHandle_t respHandle,
+                                               IotHttpsReturnCode_t rc,
+                                               uint16_t status );
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -638,6 +868,14 @@ static IotHttpsReturnCode_t _sendHttpsHeadersAndBody( _httpsConnection_t * pHttp
  */
 static http_parser_settings _httpParserSettings = { 0 };
 
+#if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+
+/**
+ * @brief The process-wide pool of persistent connections.
+ */
+    static _httpsConnectionPool_t _connectionPool = { 0 };
+#endif
+
 /*-----------------------------------------------------------*/
 
 static int _httpParserOnMessageBeginCallback( http_parser * pHttpParser )
@@ -1190,7 +1428,7 @@ static void _networkReceiveCallback( void * pNetworkConnection,
     if( fatalDisconnect && !pCurrentHttpsResponse )
     {
         IotLogError( "An out-of-order response was received. The connection will be disconnected." );
-        disconnectStatus = IotHttpsClient_Disconnect( pHttpsConnection );
+        disconnectStatus = _disconnectHttpsConnection( pHttpsConnection );
 
         if( HTTPS_FAILED( disconnectStatus ) )
         {
@@ -1218,7 +1456,7 @@ static void _networkReceiveCallback( void * pNetworkConnection,
     if( fatalDisconnect || pCurrentHttpsResponse->isNonPersistent )
     {
         IotLogDebug( "Disconnecting response %d.", pCurrentHttpsResponse );
-        disconnectStatus = IotHttpsClient_Disconnect( pHttpsConnection );
+        disconnectStatus = _disconnectHttpsConnection( pHttpsConnection );
 
         if( ( pCurrentHttpsResponse != NULL ) && pCurrentHttpsResponse->isAsync && pCurrentHttpsResponse->pCallbacks->connectionClosedCallback )
         {
@@ -1310,6 +1548,10 @@ static void _networkReceiveCallback( void * pNetworkConnection,
 
     IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
 
+    /* Give a borrowed connection back to the pool before signaling the application, so that its next request can
+     * reuse the connection. */
+    _releaseImplicitConnection( pHttpsConnection );
+
     /* The first if-case below notifies IotHttpsClient_SendSync() that the response is finished receiving. When
      * IotHttpsClient_SendSync() returns the user is allowed to modify the user buffer used for the response context.
      * In the asynchronous case, the responseCompleteCallback notifies the application that the user buffer used for the
@@ -1383,6 +1625,10 @@ static IotHttpsReturnCode_t _createHttpsConnection( IotHttpsConnectionHandle_t *
     /* Initialize disconnection state keeper. */
     pHttpsConnection->isDestroyed = false;
 
+    /* The connection pool sets the entry of a pooled connection after it is created. */
+    pHttpsConnection->pPoolEntry = NULL;
+    pHttpsConnection->isImplicit = false;
+
     /* Initialize the queue of responses and requests. */
     IotDeQueue_Create( &( pHttpsConnection->reqQ ) );
     IotDeQueue_Create( &( pHttpsConnection->respQ ) );
@@ -1555,124 +1801,674 @@ static void _networkDestroy( _httpsConnection_t * pHttpsConnection )
 
 /*-----------------------------------------------------------*/
 
-static IotHttpsReturnCode_t _addHeader( _httpsRequest_t * pHttpsRequest,
-                                        const char * pName,
-                                        uint32_t nameLen,
-                                        const char * pValue,
-                                        uint32_t valueLen )
+static IotHttpsReturnCode_t _disconnectHttpsConnection( _httpsConnection_t * pHttpsConnection )
 {
     HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
 
-    int headerFieldSeparatorLen = HTTPS_HEADER_FIELD_SEPARATOR_LENGTH;
-    uint32_t additionalLength = nameLen + headerFieldSeparatorLen + valueLen + HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH;
-    uint32_t possibleLastHeaderAdditionalLength = HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH;
+    _httpsRequest_t * pHttpsRequest = NULL;
+    _httpsResponse_t * pHttpsResponse = NULL;
+    IotLink_t * pRespItem = NULL;
+    IotLink_t * pReqItem = NULL;
+    bool connectionLocked = false;
 
-    /* Check if there is enough space to add the header field and value
-     * (name:value\r\n). We need to add a "\r\n" at the end of headers. The use of
-     * possibleLastHeaderAdditionalLength is to make sure that there is always
-     * space for the last "\r\n". */
-    if( ( additionalLength + possibleLastHeaderAdditionalLength ) > ( pHttpsRequest->pHeadersEnd - pHttpsRequest->pHeadersCur ) )
+    /* If this routine is currently is progress by another thread, for instance the taskpool worker that received a
+     * network error after sending, then return right away because connection resources are being used. */
+    if( IotMutex_TryLock( &( pHttpsConnection->connectionMutex ) ) == false )
     {
-        IotLogError( "There is %d space left in the header buffer, but we want to add %d more of header.",
-                     pHttpsRequest->pHeadersEnd - pHttpsRequest->pHeadersCur,
-                     additionalLength + possibleLastHeaderAdditionalLength );
-        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_INSUFFICIENT_MEMORY );
+        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_BUSY );
     }
 
-    memcpy( pHttpsRequest->pHeadersCur, pName, nameLen );
-    pHttpsRequest->pHeadersCur += nameLen;
-    memcpy( pHttpsRequest->pHeadersCur, HTTPS_HEADER_FIELD_SEPARATOR, headerFieldSeparatorLen );
-    pHttpsRequest->pHeadersCur += headerFieldSeparatorLen;
-    memcpy( pHttpsRequest->pHeadersCur, pValue, valueLen );
-    pHttpsRequest->pHeadersCur += valueLen;
-    memcpy( pHttpsRequest->pHeadersCur, HTTPS_END_OF_HEADER_LINES_INDICATOR, HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH );
-    pHttpsRequest->pHeadersCur += HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH;
-    IotLogDebug( "Wrote header: \"%s: %.*s\r\n\". Space left in request user buffer: %d",
-                 pName,
-                 valueLen,
-                 pValue,
-                 pHttpsRequest->pHeadersEnd - pHttpsRequest->pHeadersCur );
+    connectionLocked = true;
 
-    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
-}
+    /* Do not attempt to disconnect an already disconnected connection.
+     * It can happen when a user calls this functions and we return IOT_HTTPS_BUSY. */
+    if( pHttpsConnection->isConnected )
+    {
+        /* Mark the network as disconnected whether the disconnect passes or not. */
+        pHttpsConnection->isConnected = false;
+        _networkDisconnect( pHttpsConnection );
+    }
 
-/*-----------------------------------------------------------*/
+    /* If there is a response in the connection's response queue and the associated request has not finished sending,
+     * then we cannot destroy the connection until it finishes. */
+    pRespItem = IotDeQueue_DequeueHead( &( pHttpsConnection->respQ ) );
 
-static IotHttpsReturnCode_t _networkSend( _httpsConnection_t * pHttpsConnection,
-                                          uint8_t * pBuf,
-                                          size_t len )
-{
-    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+    if( pRespItem != NULL )
+    {
+        pHttpsResponse = IotLink_Container( _httpsResponse_t, pRespItem, link );
 
-    size_t numBytesSent = 0;
-    size_t numBytesSentTotal = 0;
-    size_t sendLength = len;
+        if( pHttpsResponse->reqFinishedSending == false )
+        {
+            IotLogError( "Connection is in use. Disconnected, but cannot destroy the connection." );
+            status = IOT_HTTPS_BUSY;
 
-    while( numBytesSentTotal < sendLength )
-    {
-        numBytesSent = pHttpsConnection->pNetworkInterface->send( pHttpsConnection->pNetworkConnection,
-                                                                  &( pBuf[ numBytesSentTotal ] ),
-                                                                  sendLength - numBytesSentTotal );
+            /* The request is busy, to as quickly as possible allow a successful retry call of this function we must
+             * cancel the busy request which is the first in the queue. */
+            pReqItem = IotDeQueue_PeekHead( &( pHttpsConnection->reqQ ) );
 
-        /* pNetworkInterface->send returns 0 on error. */
-        if( numBytesSent == 0 )
+            if( pReqItem != NULL )
+            {
+                pHttpsRequest = IotLink_Container( _httpsRequest_t, pReqItem, link );
+                _cancelRequest( pHttpsRequest );
+            }
+
+            /* We set the status as busy, but we do not goto the cleanup right away because we still want to remove
+             * all pending requests. */
+        }
+
+        /* Delete all possible pending responses. (This is defensive.) */
+        IotDeQueue_RemoveAll( &( pHttpsConnection->respQ ), NULL, 0 );
+
+        /* Put the response that was dequeued back so that the application can call this function again to check later
+         * that is exited and marked itself as finished sending.
+         * If during the last check and this check reqFinishedSending gets set to true, that is OK because on the next
+         * call to this routine, the disconnect will succeed. */
+        if( pHttpsResponse->reqFinishedSending == false )
         {
-            IotLogError( "Error in sending the HTTPS headers. Error code: %d", numBytesSent );
-            break;
+            IotDeQueue_EnqueueHead( &( pHttpsConnection->respQ ), pRespItem );
         }
+    }
 
-        numBytesSentTotal += numBytesSent;
+    /* Remove all pending requests. If this routine is called from the application context and there is a
+     * network receive callback in process, this routine will wait in _networkDestroy until that routine returns.
+     * If this is routine is called from the network receive callback context, then the destroy happens after the
+     * network receive callback context returns. */
+    IotDeQueue_RemoveAll( &( pHttpsConnection->reqQ ), NULL, 0 );
+
+    /* Do not attempt to destroy an already destroyed connection. This can happen when the user calls this function and
+     * IOT_HTTPS_BUSY is returned. */
+    if( HTTPS_SUCCEEDED( status ) )
+    {
+        if( pHttpsConnection->isDestroyed == false )
+        {
+            pHttpsConnection->isDestroyed = true;
+            _networkDestroy( pHttpsConnection );
+        }
     }
 
-    if( numBytesSentTotal != sendLength )
+    HTTPS_FUNCTION_CLEANUP_BEGIN();
+
+    /* This function is no longer in process, so disconnecting is no longer in process. This signals to the retry
+     * on this function that it can proceed with the disconnecting activities. */
+    if( connectionLocked )
     {
-        IotLogError( "Error sending data on the network. We sent %d but there were total %d.", numBytesSentTotal, sendLength );
-        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_NETWORK_ERROR );
+        IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
     }
 
-    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+    HTTPS_FUNCTION_CLEANUP_END();
 }
 
 /*-----------------------------------------------------------*/
 
-static IotHttpsReturnCode_t _networkRecv( _httpsConnection_t * pHttpsConnection,
-                                          uint8_t * pBuf,
-                                          size_t bufLen,
-                                          size_t * numBytesRecv )
+static void _releaseImplicitConnection( _httpsConnection_t * pHttpsConnection )
 {
-    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
-
-    /* The HTTP server could send the header and the body in two separate TCP packets. If that is the case, then
-     * receiveUpTo will return return the full headers first. Then on a second call, the body will be returned.
-     * If the http parser receives just the headers despite the content length being greater than  */
-    *numBytesRecv = pHttpsConnection->pNetworkInterface->receiveUpto( pHttpsConnection->pNetworkConnection,
-                                                                      pBuf,
-                                                                      bufLen );
+    IotHttpsReturnCode_t releaseStatus = IOT_HTTPS_OK;
+    bool release = false;
 
-    IotLogDebug( "The network interface receive returned %d.", numBytesRecv );
+    /* Only the last of the request sending and the response receiving gives the connection back. */
+    IotMutex_Lock( &( pHttpsConnection->connectionMutex ) );
 
-    /* We return IOT_HTTPS_NETWORK_ERROR only if we receive nothing. Receiving less
-     * data than requested is okay because it is not known in advance how much data
-     * we are going to receive and therefore we request for the available buffer
-     * size. */
-    if( *numBytesRecv == 0 )
+    if( ( pHttpsConnection->isImplicit ) &&
+        ( IotDeQueue_IsEmpty( &( pHttpsConnection->reqQ ) ) ) &&
+        ( IotDeQueue_IsEmpty( &( pHttpsConnection->respQ ) ) ) )
     {
-        IotLogError( "Error in receiving the HTTPS response message. Socket Error code %d", *numBytesRecv );
-        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_NETWORK_ERROR );
-
-        /* A network error is returned when zero is received because that would indicate that either there
-        * was a network error or there was a timeout reading data. If there was timeout reading data, then
-        * the server was too slow to respond. If the server is too slow to respond, then a network error must
-        * be returned to trigger a connection close. The connection must close after the network error so
-        * that the response from this request does not piggyback on the response from the next request. */
+        pHttpsConnection->isImplicit = false;
+        release = true;
     }
 
-    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
-}
+    IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
 
-/*-----------------------------------------------------------*/
+    if( release )
+    {
+        IotLogDebug( "Releasing the implicit connection %d.", pHttpsConnection );
 
-static IotHttpsReturnCode_t _sendHttpsHeaders( _httpsConnection_t * pHttpsConnection,
+        #if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+            if( pHttpsConnection->pPoolEntry != NULL )
+            {
+                releaseStatus = _releasePooledConnection( pHttpsConnection );
+            }
+            else
+        #endif
+        {
+            /* The pool was full when the request was sent, so the connection was created in the user buffer. */
+            releaseStatus = _disconnectHttpsConnection( pHttpsConnection );
+        }
+
+        if( HTTPS_FAILED( releaseStatus ) )
+        {
+            IotLogWarn( "Failed to release the implicit connection %d. Error code: %d.", pHttpsConnection, releaseStatus );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+
+    static bool _poolEntryMatches( const _httpsPooledConnection_t * pEntry,
+                                   const IotHttpsConnectionInfo_t * pConnInfo )
+    {
+        bool match = false;
+
+        if( ( pEntry->addressLen == pConnInfo->addressLen ) &&
+            ( pEntry->port == pConnInfo->port ) &&
+            ( pEntry->flags == ( pConnInfo->flags & ( IOT_HTTPS_IS_NON_TLS_FLAG | IOT_HTTPS_DISABLE_SNI ) ) ) &&
+            ( pEntry->pNetworkInterface == pConnInfo->pNetworkInterface ) &&
+            ( pEntry->pCaCert == pConnInfo->pCaCert ) &&
+            ( pEntry->caCertLen == pConnInfo->caCertLen ) &&
+            ( pEntry->pClientCert == pConnInfo->pClientCert ) &&
+            ( pEntry->clientCertLen == pConnInfo->clientCertLen ) &&
+            ( pEntry->pPrivateKey == pConnInfo->pPrivateKey ) &&
+            ( pEntry->privateKeyLen == pConnInfo->privateKeyLen ) &&
+            ( memcmp( pEntry->pAddress, pConnInfo->pAddress, pConnInfo->addressLen ) == 0 ) )
+        {
+            if( pConnInfo->pAlpnProtocols == NULL )
+            {
+                match = ( pEntry->alpnProtocolsLen == 0 );
+            }
+            else
+            {
+                match = ( pEntry->alpnProtocolsLen == pConnInfo->alpnProtocolsLen ) &&
+                        ( memcmp( pEntry->pAlpnProtocols, pConnInfo->pAlpnProtocols, pConnInfo->alpnProtocolsLen ) == 0 );
+            }
+        }
+
+        return match;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static bool _poolEntryIsHealthy( _httpsPooledConnection_t * pEntry )
+    {
+        _httpsConnection_t * pHttpsConnection = &( pEntry->connection );
+        bool healthy = false;
+
+        /* If the connection mutex is taken, then the connection is being disconnected by the network receive
+         * callback. */
+        if( IotMutex_TryLock( &( pHttpsConnection->connectionMutex ) ) == true )
+        {
+            healthy = ( pHttpsConnection->isConnected ) &&
+                      ( pHttpsConnection->isDestroyed == false ) &&
+                      ( IotDeQueue_IsEmpty( &( pHttpsConnection->reqQ ) ) ) &&
+                      ( IotDeQueue_IsEmpty( &( pHttpsConnection->respQ ) ) );
+            IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
+        }
+
+        return healthy;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static IotHttpsReturnCode_t _releasePooledConnection( _httpsConnection_t * pHttpsConnection )
+    {
+        HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+        _httpsPooledConnection_t * pEntry = pHttpsConnection->pPoolEntry;
+        IotTaskPoolError_t taskPoolStatus = IOT_TASKPOOL_SUCCESS;
+        bool keepIdle = false;
+
+        IotMutex_Lock( &( _connectionPool.mutex ) );
+
+        /* Giving back a connection twice must not make it idle twice. */
+        if( pEntry->state != POOL_ENTRY_IN_USE )
+        {
+            IotLogWarn( "Connection %d was already given back to the connection pool.", pHttpsConnection );
+            IotMutex_Unlock( &( _connectionPool.mutex ) );
+            HTTPS_GOTO_CLEANUP();
+        }
+
+        if( ( _connectionPool.idleCount < IOT_HTTPS_CONNECTION_POOL_MAX_IDLE ) &&
+            ( _poolEntryIsHealthy( pEntry ) ) )
+        {
+            keepIdle = true;
+            pEntry->state = POOL_ENTRY_IDLE;
+            pEntry->idleSinceMs = IotClock_GetTimeMs();
+            _connectionPool.idleCount++;
+
+            /* Close the connection when it exceeds the idle timeout, unless it is reused before. */
+            if( _connectionPool.evictionJobScheduled == false )
+            {
+                taskPoolStatus = IotTaskPool_CreateJob( _evictIdleConnectionsJob,
+                                                        NULL,
+                                                        &( _connectionPool.evictionJobStorage ),
+                                                        &( _connectionPool.evictionJob ) );
+
+                if( taskPoolStatus == IOT_TASKPOOL_SUCCESS )
+                {
+                    taskPoolStatus = IotTaskPool_ScheduleDeferred( IOT_SYSTEM_TASKPOOL,
+                                                                   _connectionPool.evictionJob,
+                                                                   IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS );
+                }
+
+                if( taskPoolStatus == IOT_TASKPOOL_SUCCESS )
+                {
+                    _connectionPool.evictionJobScheduled = true;
+                }
+                else
+                {
+                    /* The connection is still evicted when the pool is used next. */
+                    IotLogWarn( "Failed to schedule the idle connection eviction. Error code: %d.", taskPoolStatus );
+                }
+            }
+        }
+
+        IotMutex_Unlock( &( _connectionPool.mutex ) );
+
+        if( keepIdle )
+        {
+            IotLogDebug( "Connection %d is now idle in the connection pool.", pHttpsConnection );
+        }
+        else
+        {
+            status = _disconnectHttpsConnection( pHttpsConnection );
+
+            /* The entry stays in use until the connection is destroyed, so a retry of
+             * IotHttpsClient_Disconnect() can finish the disconnect. */
+            if( HTTPS_SUCCEEDED( status ) )
+            {
+                IotMutex_Lock( &( _connectionPool.mutex ) );
+                pEntry->state = POOL_ENTRY_FREE;
+                IotMutex_Unlock( &( _connectionPool.mutex ) );
+            }
+        }
+
+        HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+    }
+
+/*-----------------------------------------------------------*/
+
+    static void _evictIdleConnections( bool closeAll )
+    {
+        IotHttpsReturnCode_t disconnectStatus = IOT_HTTPS_OK;
+        _httpsPooledConnection_t * pEntry = NULL;
+        uint64_t currentTimeMs = 0;
+        uint32_t i = 0;
+
+        do
+        {
+            pEntry = NULL;
+            currentTimeMs = IotClock_GetTimeMs();
+
+            /* Find the next connection to close. The pool mutex is released while the connection is closed, so the
+             * search starts over after each one. */
+            IotMutex_Lock( &( _connectionPool.mutex ) );
+
+            for( i = 0; i < IOT_HTTPS_CONNECTION_POOL_SIZE; i++ )
+            {
+                if( ( _connectionPool.entries[ i ].state == POOL_ENTRY_IDLE ) &&
+                    ( ( closeAll ) ||
+                      ( currentTimeMs - _connectionPool.entries[ i ].idleSinceMs >= IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS ) ) )
+                {
+                    pEntry = &( _connectionPool.entries[ i ] );
+                    pEntry->state = POOL_ENTRY_IN_USE;
+                    _connectionPool.idleCount--;
+                    break;
+                }
+            }
+
+            IotMutex_Unlock( &( _connectionPool.mutex ) );
+
+            if( pEntry != NULL )
+            {
+                IotLogDebug( "Closing idle connection %d.", &( pEntry->connection ) );
+                disconnectStatus = _disconnectHttpsConnection( &( pEntry->connection ) );
+
+                IotMutex_Lock( &( _connectionPool.mutex ) );
+
+                if( HTTPS_SUCCEEDED( disconnectStatus ) )
+                {
+                    pEntry->state = POOL_ENTRY_FREE;
+                }
+                else
+                {
+                    /* The network receive callback is disconnecting this connection because the server closed it.
+                     * The entry is freed when the pool is used next. */
+                    pEntry->state = POOL_ENTRY_IDLE;
+                    _connectionPool.idleCount++;
+                }
+
+                IotMutex_Unlock( &( _connectionPool.mutex ) );
+            }
+        } while( ( pEntry != NULL ) && HTTPS_SUCCEEDED( disconnectStatus ) );
+    }
+
+/*-----------------------------------------------------------*/
+
+    static void _evictIdleConnectionsJob( IotTaskPool_t pTaskPool,
+                                          IotTaskPoolJob_t pJob,
+                                          void * pUserContext )
+    {
+        IotTaskPoolError_t taskPoolStatus = IOT_TASKPOOL_SUCCESS;
+        uint64_t currentTimeMs = 0;
+        uint64_t idleTimeMs = 0;
+        uint64_t nextEvictionMs = 0;
+        uint32_t i = 0;
+
+        ( void ) pUserContext;
+
+        _evictIdleConnections( false );
+
+        /* Run again when the connection idle the longest times out. */
+        IotMutex_Lock( &( _connectionPool.mutex ) );
+        currentTimeMs = IotClock_GetTimeMs();
+
+        for( i = 0; i < IOT_HTTPS_CONNECTION_POOL_SIZE; i++ )
+        {
+            if( _connectionPool.entries[ i ].state == POOL_ENTRY_IDLE )
+            {
+                idleTimeMs = currentTimeMs - _connectionPool.entries[ i ].idleSinceMs;
+
+                if( idleTimeMs >= IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS )
+                {
+                    /* Became idle and timed out while the other connections were closed. */
+                    nextEvictionMs = 1;
+                    break;
+                }
+                else if( ( nextEvictionMs == 0 ) ||
+                         ( IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS - idleTimeMs < nextEvictionMs ) )
+                {
+                    nextEvictionMs = IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS - idleTimeMs;
+                }
+            }
+        }
+
+        if( nextEvictionMs != 0 )
+        {
+            taskPoolStatus = IotTaskPool_ScheduleDeferred( pTaskPool, pJob, ( uint32_t ) nextEvictionMs );
+
+            if( taskPoolStatus != IOT_TASKPOOL_SUCCESS )
+            {
+                IotLogWarn( "Failed to reschedule the idle connection eviction. Error code: %d.", taskPoolStatus );
+            }
+        }
+
+        _connectionPool.evictionJobScheduled = ( nextEvictionMs != 0 ) && ( taskPoolStatus == IOT_TASKPOOL_SUCCESS );
+        IotMutex_Unlock( &( _connectionPool.mutex ) );
+    }
+
+#endif /* if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 ) */
+
+/*-----------------------------------------------------------*/
+
+static IotHttpsReturnCode_t _connectPooledConnection( IotHttpsConnectionHandle_t * pConnHandle,
+                                                     IotHttpsConnectionInfo_t * pConnInfo )
+{
+    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+    #if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+        _httpsPooledConnection_t * pEntry = NULL;
+        _httpsPooledConnection_t * pIdleEntry = NULL;
+        IotHttpsConnectionInfo_t pooledConnInfo = *pConnInfo;
+        bool reused = false;
+        bool evicted = false;
+        uint32_t i = 0;
+
+        IotMutex_Lock( &( _connectionPool.mutex ) );
+
+        for( i = 0; i < IOT_HTTPS_CONNECTION_POOL_SIZE; i++ )
+        {
+            pIdleEntry = &( _connectionPool.entries[ i ] );
+
+            if( pIdleEntry->state != POOL_ENTRY_IDLE )
+            {
+                continue;
+            }
+
+            if( ( pIdleEntry->connection.isConnected == false ) && ( pIdleEntry->connection.isDestroyed ) )
+            {
+                /* The server closed this idle connection. */
+                pIdleEntry->state = POOL_ENTRY_FREE;
+                _connectionPool.idleCount--;
+            }
+            else if( ( _poolEntryMatches( pIdleEntry, pConnInfo ) ) &&
+                     ( IotClock_GetTimeMs() - pIdleEntry->idleSinceMs < IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS ) &&
+                     ( _poolEntryIsHealthy( pIdleEntry ) ) )
+            {
+                /* Prefer the most recently used connection, the one least likely to be closed by the server. */
+                if( ( pEntry == NULL ) || ( pIdleEntry->idleSinceMs > pEntry->idleSinceMs ) )
+                {
+                    pEntry = pIdleEntry;
+                }
+            }
+        }
+
+        if( pEntry != NULL )
+        {
+            reused = true;
+        }
+        else
+        {
+            /* Use a free entry, or else close the connection idle the longest. */
+            for( i = 0; i < IOT_HTTPS_CONNECTION_POOL_SIZE; i++ )
+            {
+                pIdleEntry = &( _connectionPool.entries[ i ] );
+
+                if( pIdleEntry->state == POOL_ENTRY_FREE )
+                {
+                    pEntry = pIdleEntry;
+                    evicted = false;
+                    break;
+                }
+                else if( ( pIdleEntry->state == POOL_ENTRY_IDLE ) &&
+                         ( ( pEntry == NULL ) || ( pIdleEntry->idleSinceMs < pEntry->idleSinceMs ) ) )
+                {
+                    pEntry = pIdleEntry;
+                    evicted = true;
+                }
+            }
+        }
+
+        if( pEntry != NULL )
+        {
+            if( pEntry->state == POOL_ENTRY_IDLE )
+            {
+                _connectionPool.idleCount--;
+            }
+
+            pEntry->state = POOL_ENTRY_IN_USE;
+        }
+
+        IotMutex_Unlock( &( _connectionPool.mutex ) );
+
+        if( reused )
+        {
+            IotLogDebug( "Reusing idle connection %d to %.*s.", &( pEntry->connection ), pConnInfo->addressLen, pConnInfo->pAddress );
+
+            /* The response timeout is not part of the key. */
+            pEntry->connection.timeout = ( pConnInfo->timeout == 0 ) ? IOT_HTTPS_RESPONSE_WAIT_MS : pConnInfo->timeout;
+            *pConnHandle = &( pEntry->connection );
+            HTTPS_GOTO_CLEANUP();
+        }
+
+        if( pEntry == NULL )
+        {
+            IotLogDebug( "All %d connection pool entries are in use. The connection will not be pooled.",
+                         IOT_HTTPS_CONNECTION_POOL_SIZE );
+            status = _createHttpsConnection( pConnHandle, pConnInfo );
+            HTTPS_GOTO_CLEANUP();
+        }
+
+        if( evicted )
+        {
+            IotLogDebug( "Closing idle connection %d to make room in the connection pool.", &( pEntry->connection ) );
+
+            if( HTTPS_FAILED( _disconnectHttpsConnection( &( pEntry->connection ) ) ) )
+            {
+                /* The network receive callback is disconnecting this connection because the server closed it, so its
+                 * context cannot be reused yet. */
+                IotMutex_Lock( &( _connectionPool.mutex ) );
+                pEntry->state = POOL_ENTRY_IDLE;
+                _connectionPool.idleCount++;
+                IotMutex_Unlock( &( _connectionPool.mutex ) );
+
+                status = _createHttpsConnection( pConnHandle, pConnInfo );
+                HTTPS_GOTO_CLEANUP();
+            }
+        }
+
+        /* The connection context is stored in the pool entry instead of the user buffer. */
+        pooledConnInfo.userBuffer.pBuffer = ( uint8_t * ) &( pEntry->connection );
+        pooledConnInfo.userBuffer.bufferLen = sizeof( _httpsConnection_t );
+
+        status = _createHttpsConnection( pConnHandle, &pooledConnInfo );
+
+        if( HTTPS_FAILED( status ) )
+        {
+            IotMutex_Lock( &( _connectionPool.mutex ) );
+            pEntry->state = POOL_ENTRY_FREE;
+            IotMutex_Unlock( &( _connectionPool.mutex ) );
+            HTTPS_GOTO_CLEANUP();
+        }
+
+        /* Save the key of the new connection. The lengths were checked by _createHttpsConnection(). */
+        memcpy( pEntry->pAddress, pConnInfo->pAddress, pConnInfo->addressLen );
+        pEntry->addressLen = pConnInfo->addressLen;
+        pEntry->port = pConnInfo->port;
+        pEntry->flags = pConnInfo->flags & ( IOT_HTTPS_IS_NON_TLS_FLAG | IOT_HTTPS_DISABLE_SNI );
+        pEntry->pNetworkInterface = pConnInfo->pNetworkInterface;
+        pEntry->alpnProtocolsLen = 0;
+
+        if( pConnInfo->pAlpnProtocols != NULL )
+        {
+            memcpy( pEntry->pAlpnProtocols, pConnInfo->pAlpnProtocols, pConnInfo->alpnProtocolsLen );
+            pEntry->alpnProtocolsLen = pConnInfo->alpnProtocolsLen;
+        }
+
+        pEntry->pCaCert = pConnInfo->pCaCert;
+        pEntry->caCertLen = pConnInfo->caCertLen;
+        pEntry->pClientCert = pConnInfo->pClientCert;
+        pEntry->clientCertLen = pConnInfo->clientCertLen;
+        pEntry->pPrivateKey = pConnInfo->pPrivateKey;
+        pEntry->privateKeyLen = pConnInfo->privateKeyLen;
+        pEntry->connection.pPoolEntry = pEntry;
+    #else /* if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 ) */
+        /* Without a connection pool, every connection is created in the user buffer. */
+        status = _createHttpsConnection( pConnHandle, pConnInfo );
+    #endif /* if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 ) */
+
+    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
+static IotHttpsReturnCode_t _addHeader( _httpsRequest_t * pHttpsRequest,
+                                        const char * pName,
+                                        uint32_t nameLen,
+                                        const char * pValue,
+                                        uint32_t valueLen )
+{
+    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+    int headerFieldSeparatorLen = HTTPS_HEADER_FIELD_SEPARATOR_LENGTH;
+    uint32_t additionalLength = nameLen + headerFieldSeparatorLen + valueLen + HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH;
+    uint32_t possibleLastHeaderAdditionalLength = HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH;
+
+    /* Check if there is enough space to add the header field and value
+     * (name:value\r\n). We need to add a "\r\n" at the end of headers. The use of
+     * possibleLastHeaderAdditionalLength is to make sure that there is always
+     * space for the last "\r\n". */
+    if( ( additionalLength + possibleLastHeaderAdditionalLength ) > ( pHttpsRequest->pHeadersEnd - pHttpsRequest->pHeadersCur ) )
+    {
+        IotLogError( "There is %d space left in the header buffer, but we want to add %d more of header.",
+                     pHttpsRequest->pHeadersEnd - pHttpsRequest->pHeadersCur,
+                     additionalLength + possibleLastHeaderAdditionalLength );
+        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_INSUFFICIENT_MEMORY );
+    }
+
+    memcpy( pHttpsRequest->pHeadersCur, pName, nameLen );
+    pHttpsRequest->pHeadersCur += nameLen;
+    memcpy( pHttpsRequest->pHeadersCur, HTTPS_HEADER_FIELD_SEPARATOR, headerFieldSeparatorLen );
+    pHttpsRequest->pHeadersCur += headerFieldSeparatorLen;
+    memcpy( pHttpsRequest->pHeadersCur, pValue, valueLen );
+    pHttpsRequest->pHeadersCur += valueLen;
+    memcpy( pHttpsRequest->pHeadersCur, HTTPS_END_OF_HEADER_LINES_INDICATOR, HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH );
+    pHttpsRequest->pHeadersCur += HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH;
+    IotLogDebug( "Wrote header: \"%s: %.*s\r\n\". Space left in request user buffer: %d",
+                 pName,
+                 valueLen,
+                 pValue,
+                 pHttpsRequest->pHeadersEnd - pHttpsRequest->pHeadersCur );
+
+    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
+static IotHttpsReturnCode_t _networkSend( _httpsConnection_t * pHttpsConnection,
+                                          uint8_t * pBuf,
+                                          size_t len )
+{
+    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+    size_t numBytesSent = 0;
+    size_t numBytesSentTotal = 0;
+    size_t sendLength = len;
+
+    while( numBytesSentTotal < sendLength )
+    {
+        numBytesSent = pHttpsConnection->pNetworkInterface->send( pHttpsConnection->pNetworkConnection,
+                                                                  &( pBuf[ numBytesSentTotal ] ),
+                                                                  sendLength - numBytesSentTotal );
+
+        /* pNetworkInterface->send returns 0 on error. */
+        if( numBytesSent == 0 )
+        {
+            IotLogError( "Error in sending the HTTPS headers. Error code: %d", numBytesSent );
+            break;
+        }
+
+        numBytesSentTotal += numBytesSent;
+    }
+
+    if( numBytesSentTotal != sendLength )
+    {
+        IotLogError( "Error sending data on the network. We sent %d but there were total %d.", numBytesSentTotal, sendLength );
+        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_NETWORK_ERROR );
+    }
+
+    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
+static IotHttpsReturnCode_t _networkRecv( _httpsConnection_t * pHttpsConnection,
+                                          uint8_t * pBuf,
+                                          size_t bufLen,
+                                          size_t * numBytesRecv )
+{
+    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+    /* The HTTP server could send the header and the body in two separate TCP packets. If that is the case, then
+     * receiveUpTo will return return the full headers first. Then on a second call, the body will be returned.
+     * If the http parser receives just the headers despite the content length being greater than  */
+    *numBytesRecv = pHttpsConnection->pNetworkInterface->receiveUpto( pHttpsConnection->pNetworkConnection,
+                                                                      pBuf,
+                                                                      bufLen );
+
+    IotLogDebug( "The network interface receive returned %d.", numBytesRecv );
+
+    /* We return IOT_HTTPS_NETWORK_ERROR only if we receive nothing. Receiving less
+     * data than requested is okay because it is not known in advance how much data
+     * we are going to receive and therefore we request for the available buffer
+     * size. */
+    if( *numBytesRecv == 0 )
+    {
+        IotLogError( "Error in receiving the HTTPS response message. Socket Error code %d", *numBytesRecv );
+        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_NETWORK_ERROR );
+
+        /* A network error is returned when zero is received because that would indicate that either there
+        * was a network error or there was a timeout reading data. If there was timeout reading data, then
+        * the server was too slow to respond. If the server is too slow to respond, then a network error must
+        * be returned to trigger a connection close. The connection must close after the network error so
+        * that the response from this request does not piggyback on the response from the next request. */
+    }
+
+    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
+static IotHttpsReturnCode_t _sendHttpsHeaders( _httpsConnection_t * pHttpsConnection,
                                                uint8_t * pHeadersBuf,
                                                uint32_t headersLength,
                                                bool isNonPersistent,
@@ -2218,7 +3014,7 @@ static void _sendHttpsRequest( IotTaskPool_t pTaskPool,
         if( status == IOT_HTTPS_NETWORK_ERROR )
         {
             IotLogDebug( "Disconnecting request %d.", pHttpsRequest );
-            disconnectStatus = IotHttpsClient_Disconnect( pHttpsConnection );
+            disconnectStatus = _disconnectHttpsConnection( pHttpsConnection );
 
             if( pHttpsRequest->isAsync && pHttpsRequest->pCallbacks->connectionClosedCallback )
             {
@@ -2293,6 +3089,9 @@ static void _sendHttpsRequest( IotTaskPool_t pTaskPool,
     IotDeQueue_DequeueHead( &( pHttpsConnection->reqQ ) );
     IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
 
+    /* Give a borrowed connection back to the pool if the response was already received. */
+    _releaseImplicitConnection( pHttpsConnection );
+
     /* This routine returns a void so there is no HTTPS_FUNCTION_CLEANUP_END();. */
 }
 
@@ -2320,6 +3119,12 @@ IotHttpsReturnCode_t _scheduleHttpsRequestSend( _httpsRequest_t * pHttpsRequest
         HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_INTERNAL_ERROR );
     }
 
+    /* Sending a request and receiving its response may keep a worker busy for a long
+     * time; let latency sensitive jobs, such as MQTT keep-alive, go first. */
+    ( void ) IotTaskPool_SetJobPriority( IOT_SYSTEM_TASKPOOL,
+                                         pHttpsConnection->taskPoolJob,
+                                         IOT_TASKPOOL_JOB_PRIORITY_BULK );
+
     taskPoolStatus = IotTaskPool_Schedule( IOT_SYSTEM_TASKPOOL, pHttpsConnection->taskPoolJob, 0 );
 
     if( taskPoolStatus != IOT_TASKPOOL_SUCCESS )
@@ -2379,44 +3184,549 @@ IotHttpsReturnCode_t _addRequestToConnectionReqQ( _httpsRequest_t * pHttpsReques
         scheduleRequest = true;
     }
 
-    /* Place into the connection's request to have a taskpool worker schedule to serve it later. */
-    IotDeQueue_EnqueueTail( &( pHttpsConnection->reqQ ), &( pHttpsRequest->link ) );
-    IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
-
-    if( scheduleRequest )
+    /* Place into the connection's request to have a taskpool worker schedule to serve it later. */
+    IotDeQueue_EnqueueTail( &( pHttpsConnection->reqQ ), &( pHttpsRequest->link ) );
+    IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
+
+    if( scheduleRequest )
+    {
+        /* This routine schedules a task pool worker to send the request. If a worker is available immediately, then
+         * the request is sent right away. */
+        status = _scheduleHttpsRequestSend( pHttpsRequest );
+
+        if( HTTPS_FAILED( status ) )
+        {
+            IotLogError( "Failed to schedule the request in the queue for request %d. Error code: %d", pHttpsRequest, status );
+
+            /* If we fail to schedule the only request in the queue we should remove it. */
+            IotMutex_Lock( &( pHttpsConnection->connectionMutex ) );
+            IotDeQueue_Remove( &( pHttpsRequest->link ) );
+            IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
+
+            HTTPS_GOTO_CLEANUP();
+        }
+    }
+
+    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cancelRequest( _httpsRequest_t * pHttpsRequest )
+{
+    pHttpsRequest->cancelled = true;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cancelResponse( _httpsResponse_t * pHttpsResponse )
+{
+    pHttpsResponse->cancelled = true;
+}
+
+/*-----------------------------------------------------------*/
+
+static _httpsDownloadConnection_t * _getDownloadConnection( _httpsDownload_t * pDownload,
+                                                            uint32_t index )
+{
+    return ( _httpsDownloadConnection_t * ) ( pDownload->pDownloadInfo->userBuffer.pBuffer +
+                                              ( index * pDownload->connectionBufferLen ) );
+}
+
+/*-----------------------------------------------------------*/
+
+static void _initializeDownloadConnection( _httpsDownload_t * pDownload,
+                                           uint32_t index )
+{
+    const IotHttpsDownloadInfo_t * pDownloadInfo = pDownload->pDownloadInfo;
+    _httpsDownloadConnection_t * pDownloadConnection = _getDownloadConnection( pDownload, index );
+    uint8_t * pBufferCur = ( uint8_t * ) pDownloadConnection;
+    uint8_t * pBufferEnd = pBufferCur + pDownload->connectionBufferLen;
+
+    memset( pDownloadConnection, 0, sizeof( _httpsDownloadConnection_t ) );
+    pDownloadConnection->pDownload = pDownload;
+    pBufferCur += HTTPS_DOWNLOAD_ALIGN( sizeof( _httpsDownloadConnection_t ) );
+
+    /* The connection context is stored in the user buffer only if the connection pool is full. */
+    pDownloadConnection->connInfo = *( pDownloadInfo->pConnInfo );
+    pDownloadConnection->connInfo.flags |= IOT_HTTPS_POOLED_CONNECTION_FLAG;
+    pDownloadConnection->connInfo.userBuffer.pBuffer = pBufferCur;
+    pDownloadConnection->connInfo.userBuffer.bufferLen = connectionUserBufferMinimumSize;
+    pBufferCur += HTTPS_DOWNLOAD_ALIGN( connectionUserBufferMinimumSize );
+
+    pDownloadConnection->respInfo.userBuffer.pBuffer = pBufferCur;
+    pDownloadConnection->respInfo.userBuffer.bufferLen = responseUserBufferMinimumSize + IOT_HTTPS_DOWNLOAD_RESPONSE_HEADERS_SIZE;
+    pDownloadConnection->respInfo.pSyncInfo = NULL;
+    pBufferCur += HTTPS_DOWNLOAD_ALIGN( pDownloadConnection->respInfo.userBuffer.bufferLen );
+
+    pDownloadConnection->reqInfo.pPath = pDownloadInfo->pPath;
+    pDownloadConnection->reqInfo.pathLen = pDownloadInfo->pathLen;
+    pDownloadConnection->reqInfo.method = IOT_HTTPS_METHOD_GET;
+    pDownloadConnection->reqInfo.pHost = pDownloadInfo->pConnInfo->pAddress;
+    pDownloadConnection->reqInfo.hostLen = pDownloadInfo->pConnInfo->addressLen;
+    pDownloadConnection->reqInfo.isNonPersistent = false;
+    pDownloadConnection->reqInfo.userBuffer.pBuffer = pBufferCur;
+    pDownloadConnection->reqInfo.userBuffer.bufferLen = requestUserBufferMinimumSize +
+                                                        HTTPS_MAX_RANGE_LINE_LENGTH +
+                                                        pDownloadInfo->pathLen +
+                                                        pDownloadInfo->pConnInfo->addressLen;
+    pDownloadConnection->reqInfo.isAsync = true;
+    pDownloadConnection->reqInfo.u.pAsyncInfo = &( pDownloadConnection->asyncInfo );
+    pBufferCur += pDownloadConnection->reqInfo.userBuffer.bufferLen;
+
+    pDownloadConnection->asyncInfo.callbacks.readReadyCallback = _downloadReadReadyCallback;
+    pDownloadConnection->asyncInfo.callbacks.responseCompleteCallback = _downloadResponseCompleteCallback;
+    pDownloadConnection->asyncInfo.pPrivData = pDownloadConnection;
+
+    /* The rest of the share receives the response body, which is passed to the sink from here. */
+    pDownloadConnection->pBody = pBufferCur;
+    pDownloadConnection->bodyLen = ( uint32_t ) ( pBufferEnd - pBufferCur );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _getNextDownloadRange( _httpsDownload_t * pDownload,
+                                   _httpsDownloadConnection_t * pDownloadConnection )
+{
+    uint32_t rangeSize = pDownload->pDownloadInfo->rangeSize;
+    uint32_t fileSize = 0;
+    bool hasRange = false;
+
+    /* The rest of a range whose request failed is requested again on the same connection context. */
+    if( pDownloadConnection->rangeStart < pDownloadConnection->rangeEnd )
+    {
+        hasRange = true;
+    }
+    else
+    {
+        IotMutex_Lock( &( pDownload->resultMutex ) );
+        fileSize = pDownload->fileSize;
+        IotMutex_Unlock( &( pDownload->resultMutex ) );
+
+        if( fileSize == 0 )
+        {
+            /* The size of the resource is learned from the response to the first range, so it is requested alone. */
+            if( pDownload->nextOffset == 0 )
+            {
+                pDownloadConnection->rangeStart = 0;
+                pDownloadConnection->rangeEnd = rangeSize;
+                hasRange = true;
+            }
+        }
+        else if( pDownload->nextOffset < fileSize )
+        {
+            pDownloadConnection->rangeStart = pDownload->nextOffset;
+            pDownloadConnection->rangeEnd = ( ( fileSize - pDownload->nextOffset ) > rangeSize ) ?
+                                            ( pDownload->nextOffset + rangeSize ) : fileSize;
+            hasRange = true;
+        }
+
+        if( hasRange )
+        {
+            pDownload->nextOffset = pDownloadConnection->rangeEnd;
+        }
+    }
+
+    return hasRange;
+}
+
+/*-----------------------------------------------------------*/
+
+static IotHttpsReturnCode_t _startDownloadRequest( _httpsDownloadConnection_t * pDownloadConnection )
+{
+    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+    int numWritten = 0;
+
+    pDownloadConnection->received = 0;
+    pDownloadConnection->status = IOT_HTTPS_OK;
+    pDownloadConnection->statusChecked = false;
+    pDownloadConnection->finished = false;
+    pDownloadConnection->reqHandle = NULL;
+    pDownloadConnection->respHandle = NULL;
+
+    /* A connection closed after a failed request is replaced, preferably with an idle connection from the pool. */
+    if( pDownloadConnection->connHandle == NULL )
+    {
+        status = IotHttpsClient_Connect( &( pDownloadConnection->connHandle ), &( pDownloadConnection->connInfo ) );
+
+        if( HTTPS_FAILED( status ) )
+        {
+            IotLogError( "Failed to connect for the download of range %d-%d. Error code: %d.",
+                         pDownloadConnection->rangeStart,
+                         pDownloadConnection->rangeEnd,
+                         status );
+            pDownloadConnection->connHandle = NULL;
+            HTTPS_GOTO_CLEANUP();
+        }
+    }
+
+    status = IotHttpsClient_InitializeRequest( &( pDownloadConnection->reqHandle ), &( pDownloadConnection->reqInfo ) );
+
+    if( HTTPS_FAILED( status ) )
+    {
+        IotLogError( "Failed to initialize the request for the download of range %d-%d. Error code: %d.",
+                     pDownloadConnection->rangeStart,
+                     pDownloadConnection->rangeEnd,
+                     status );
+        HTTPS_GOTO_CLEANUP();
+    }
+
+    /* The Range header holds the offsets of the first and of the last byte of the range. */
+    numWritten = snprintf( pDownloadConnection->pRangeValue,
+                           sizeof( pDownloadConnection->pRangeValue ),
+                           "%s%lu-%lu",
+                           HTTPS_RANGE_VALUE_PREFIX,
+                           ( unsigned long ) pDownloadConnection->rangeStart,
+                           ( unsigned long ) ( pDownloadConnection->rangeEnd - 1 ) );
+
+    if( ( numWritten < 0 ) || ( numWritten >= sizeof( pDownloadConnection->pRangeValue ) ) )
+    {
+        IotLogError( "Internal error in snprintf() in _startDownloadRequest(). Error code %d.", numWritten );
+        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_INTERNAL_ERROR );
+    }
+
+    status = _addHeader( pDownloadConnection->reqHandle,
+                         HTTPS_RANGE_HEADER,
+                         FAST_MACRO_STRLEN( HTTPS_RANGE_HEADER ),
+                         pDownloadConnection->pRangeValue,
+                         ( uint32_t ) numWritten );
+
+    if( HTTPS_FAILED( status ) )
+    {
+        IotLogError( "Failed to add the Range header to the request. Error code: %d.", status );
+        HTTPS_GOTO_CLEANUP();
+    }
+
+    status = IotHttpsClient_SendAsync( pDownloadConnection->connHandle,
+                                       pDownloadConnection->reqHandle,
+                                       &( pDownloadConnection->respHandle ),
+                                       &( pDownloadConnection->respInfo ) );
+
+    if( HTTPS_FAILED( status ) )
+    {
+        IotLogError( "Failed to send the request for the download of range %d-%d. Error code: %d.",
+                     pDownloadConnection->rangeStart,
+                     pDownloadConnection->rangeEnd,
+                     status );
+    }
+
+    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
+static void _finishDownloadRequest( _httpsDownloadConnection_t * pDownloadConnection,
+                                    IotHttpsReturnCode_t requestStatus )
+{
+    _httpsDownload_t * pDownload = pDownloadConnection->pDownload;
+
+    IotMutex_Lock( &( pDownload->resultMutex ) );
+
+    if( HTTPS_SUCCEEDED( pDownloadConnection->status ) )
+    {
+        pDownloadConnection->status = requestStatus;
+    }
+
+    /* The semaphore is posted with the mutex held. Otherwise an earlier wake up could process this request and end the
+     * download, whose semaphore lives on the stack of IotHttpsClient_Download(), before this post. */
+    pDownloadConnection->finished = true;
+    IotSemaphore_Post( &( pDownload->finishedSem ) );
+
+    IotMutex_Unlock( &( pDownload->resultMutex ) );
+}
+
+/*-----------------------------------------------------------*/
+
+static IotHttpsReturnCode_t _processDownloadResult( _httpsDownload_t * pDownload,
+                                                    _httpsDownloadConnection_t * pDownloadConnection )
+{
+    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+    IotHttpsReturnCode_t requestStatus = pDownloadConnection->status;
+
+    /* A response that ended before the whole range was received, e.g. because the server closed the connection, is
+     * retried. */
+    if( HTTPS_SUCCEEDED( requestStatus ) &&
+        ( pDownloadConnection->received < ( pDownloadConnection->rangeEnd - pDownloadConnection->rangeStart ) ) )
+    {
+        requestStatus = IOT_HTTPS_TRY_AGAIN;
+    }
+
+    pDownloadConnection->rangeStart += pDownloadConnection->received;
+
+    /* The first response may have shown the resource to be smaller than the first range, or may have carried the
+     * whole resource. */
+    if( pDownloadConnection->rangeEnd > pDownload->nextOffset )
+    {
+        pDownload->nextOffset = pDownloadConnection->rangeEnd;
+    }
+
+    if( HTTPS_SUCCEEDED( requestStatus ) )
+    {
+        pDownloadConnection->retries = 0;
+        HTTPS_GOTO_CLEANUP();
+    }
+
+    /* The connection may be in the middle of a response, so it is closed instead of being kept in the pool. */
+    _closeDownloadConnection( pDownloadConnection, false );
+
+    if( pDownloadConnection->rangeStart == pDownloadConnection->rangeEnd )
+    {
+        IotLogDebug( "The whole range was written to the sink before the error %d.", requestStatus );
+        pDownloadConnection->retries = 0;
+        HTTPS_GOTO_CLEANUP();
+    }
+
+    /* Retrying does not help if the sink failed or if the server does not serve the range as requested. */
+    if( ( requestStatus == IOT_HTTPS_USER_CALLBACK_ERROR ) ||
+        ( requestStatus == IOT_HTTPS_NOT_SUPPORTED ) ||
+        ( requestStatus == IOT_HTTPS_PROTOCOL_ERROR ) ||
+        ( pDownloadConnection->retries >= pDownload->pDownloadInfo->maxRetries ) )
+    {
+        IotLogError( "Failed to download range %d-%d after %d retries. Error code: %d.",
+                     pDownloadConnection->rangeStart,
+                     pDownloadConnection->rangeEnd,
+                     pDownloadConnection->retries,
+                     requestStatus );
+        HTTPS_SET_AND_GOTO_CLEANUP( requestStatus );
+    }
+
+    pDownloadConnection->retries++;
+    IotLogWarn( "Retrying the download of range %d-%d after error %d.",
+                pDownloadConnection->rangeStart,
+                pDownloadConnection->rangeEnd,
+                requestStatus );
+
+    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
+
+static void _closeDownloadConnection( _httpsDownloadConnection_t * pDownloadConnection,
+                                      bool keepAlive )
+{
+    IotHttpsReturnCode_t disconnectStatus = IOT_HTTPS_OK;
+
+    if( pDownloadConnection->connHandle != NULL )
+    {
+        /* Disconnecting the network first makes the connection unhealthy, so the pool does not keep it. */
+        if( keepAlive == false )
+        {
+            while( _disconnectHttpsConnection( pDownloadConnection->connHandle ) == IOT_HTTPS_BUSY )
+            {
+                IotClock_SleepMs( HTTPS_DOWNLOAD_DISCONNECT_RETRY_MS );
+            }
+        }
+
+        /* The connection is busy until the task sending its last request is done with it. */
+        while( ( disconnectStatus = IotHttpsClient_Disconnect( pDownloadConnection->connHandle ) ) == IOT_HTTPS_BUSY )
+        {
+            IotClock_SleepMs( HTTPS_DOWNLOAD_DISCONNECT_RETRY_MS );
+        }
+
+        if( HTTPS_FAILED( disconnectStatus ) )
+        {
+            IotLogWarn( "Failed to disconnect a connection of the download. Error code: %d.", disconnectStatus );
+        }
+
+        pDownloadConnection->connHandle = NULL;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static IotHttpsReturnCode_t _checkDownloadResponse( _httpsDownloadConnection_t * pDownloadConnection,
+                                                    IotHttpsResponseHandle_t respHandle,
+                                                    uint16_t responseStatus )
+{
+    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+    const int CONTENT_RANGE_NUMERIC_BASE = 10;
+    _httpsDownload_t * pDownload = pDownloadConnection->pDownload;
+    char pContentRangeStr[ HTTPS_MAX_CONTENT_RANGE_VALUE_LENGTH ] = { 0 };
+    char * pTotalStr = NULL;
+    uint32_t fileSize = 0;
+    uint32_t contentLength = 0;
+
+    IotMutex_Lock( &( pDownload->resultMutex ) );
+    fileSize = pDownload->fileSize;
+    IotMutex_Unlock( &( pDownload->resultMutex ) );
+
+    if( responseStatus == IOT_HTTPS_STATUS_PARTIAL_CONTENT )
+    {
+        /* The Content-Range header value is of the form "bytes first-last/total". It may not be stored if the response
+         * headers do not fit into the response user buffer, in which case the requested range is trusted. */
+        if( IotHttpsClient_ReadHeader( respHandle,
+                                       HTTPS_CONTENT_RANGE_HEADER,
+                                       FAST_MACRO_STRLEN( HTTPS_CONTENT_RANGE_HEADER ),
+                                       pContentRangeStr,
+                                       sizeof( pContentRangeStr ) ) == IOT_HTTPS_OK )
+        {
+            HTTPS_ON_ARG_ERROR_MSG_GOTO_CLEANUP( ( strncmp( pContentRangeStr,
+                                                            HTTPS_CONTENT_RANGE_VALUE_PREFIX,
+                                                            FAST_MACRO_STRLEN( HTTPS_CONTENT_RANGE_VALUE_PREFIX ) ) == 0 ) &&
+                                                 ( strtoul( pContentRangeStr + FAST_MACRO_STRLEN( HTTPS_CONTENT_RANGE_VALUE_PREFIX ),
+                                                            NULL,
+                                                            CONTENT_RANGE_NUMERIC_BASE ) == pDownloadConnection->rangeStart ),
+                                                 IOT_HTTPS_PROTOCOL_ERROR,
+                                                 "The server sent Content-Range %s for a request of range %d-%d.",
+                                                 pContentRangeStr,
+                                                 pDownloadConnection->rangeStart,
+                                                 pDownloadConnection->rangeEnd );
+
+            pTotalStr = strchr( pContentRangeStr, '/' );
+
+            if( ( fileSize == 0 ) && ( pTotalStr != NULL ) )
+            {
+                fileSize = strtoul( pTotalStr + 1, NULL, CONTENT_RANGE_NUMERIC_BASE );
+            }
+        }
+
+        HTTPS_ON_ARG_ERROR_MSG_GOTO_CLEANUP( fileSize > 0,
+                                             IOT_HTTPS_PROTOCOL_ERROR,
+                                             "The size of the resource could not be read from the Content-Range header." );
+    }
+    else if( ( responseStatus == IOT_HTTPS_STATUS_OK ) &&
+             ( pDownloadConnection->rangeStart == 0 ) &&
+             ( ( fileSize == 0 ) || ( pDownloadConnection->rangeEnd == fileSize ) ) )
+    {
+        /* The server sent the whole resource instead of the first range, which is fine as long as its size is known. */
+        if( ( IotHttpsClient_ReadContentLength( respHandle, &contentLength ) != IOT_HTTPS_OK ) ||
+            ( contentLength == 0 ) ||
+            ( ( fileSize != 0 ) && ( contentLength != fileSize ) ) )
+        {
+            IotLogError( "The server does not support Range requests and sent a resource of unknown size." );
+            HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_NOT_SUPPORTED );
+        }
+
+        fileSize = contentLength;
+        pDownloadConnection->rangeEnd = contentLength;
+    }
+    else if( ( responseStatus >= IOT_HTTPS_STATUS_INTERNAL_SERVER_ERROR ) ||
+             ( responseStatus == IOT_HTTPS_STATUS_REQUEST_TIMEOUT ) )
+    {
+        IotLogWarn( "The server answered the request of range %d-%d with status %d.",
+                    pDownloadConnection->rangeStart,
+                    pDownloadConnection->rangeEnd,
+                    responseStatus );
+        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_TRY_AGAIN );
+    }
+    else
+    {
+        IotLogError( "The server answered the request of range %d-%d with status %d.",
+                     pDownloadConnection->rangeStart,
+                     pDownloadConnection->rangeEnd,
+                     responseStatus );
+        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_NOT_SUPPORTED );
+    }
+
+    /* The first range may be longer than the resource. */
+    if( pDownloadConnection->rangeEnd > fileSize )
     {
-        /* This routine schedules a task pool worker to send the request. If a worker is available immediately, then
-         * the request is sent right away. */
-        status = _scheduleHttpsRequestSend( pHttpsRequest );
-
-        if( HTTPS_FAILED( status ) )
-        {
-            IotLogError( "Failed to schedule the request in the queue for request %d. Error code: %d", pHttpsRequest, status );
+        pDownloadConnection->rangeEnd = fileSize;
+    }
 
-            /* If we fail to schedule the only request in the queue we should remove it. */
-            IotMutex_Lock( &( pHttpsConnection->connectionMutex ) );
-            IotDeQueue_Remove( &( pHttpsRequest->link ) );
-            IotMutex_Unlock( &( pHttpsConnection->connectionMutex ) );
+    IotMutex_Lock( &( pDownload->resultMutex ) );
 
-            HTTPS_GOTO_CLEANUP();
-        }
+    if( pDownload->fileSize == 0 )
+    {
+        pDownload->fileSize = fileSize;
     }
 
+    IotMutex_Unlock( &( pDownload->resultMutex ) );
+
     HTTPS_FUNCTION_EXIT_NO_CLEANUP();
 }
 
 /*-----------------------------------------------------------*/
 
-static void _cancelRequest( _httpsRequest_t * pHttpsRequest )
+static void _downloadReadReadyCallback( void * pPrivData,
+                                        IotHttpsResponseHandle_t respHandle,
+                                        IotHttpsReturnCode_t rc,
+                                        uint16_t status )
 {
-    pHttpsRequest->cancelled = true;
+    _httpsDownloadConnection_t * pDownloadConnection = ( _httpsDownloadConnection_t * ) pPrivData;
+    const IotHttpsDownloadInfo_t * pDownloadInfo = pDownloadConnection->pDownload->pDownloadInfo;
+    IotHttpsReturnCode_t downloadStatus = rc;
+    uint32_t bodyLen = pDownloadConnection->bodyLen;
+    bool sinkStatus = false;
+
+    /* The status and the range of the connection are only changed in the callbacks of the response, which all run in
+     * the network receive callback, until the response complete callback wakes up the download. */
+    if( HTTPS_SUCCEEDED( downloadStatus ) && ( pDownloadConnection->statusChecked == false ) )
+    {
+        pDownloadConnection->statusChecked = true;
+        downloadStatus = _checkDownloadResponse( pDownloadConnection, respHandle, status );
+    }
+
+    if( HTTPS_SUCCEEDED( downloadStatus ) )
+    {
+        downloadStatus = IotHttpsClient_ReadResponseBody( respHandle, pDownloadConnection->pBody, &bodyLen );
+    }
+
+    if( HTTPS_SUCCEEDED( downloadStatus ) && ( bodyLen > 0 ) )
+    {
+        if( bodyLen > ( pDownloadConnection->rangeEnd - pDownloadConnection->rangeStart - pDownloadConnection->received ) )
+        {
+            IotLogError( "The server sent more than the requested range %d-%d.",
+                         pDownloadConnection->rangeStart,
+                         pDownloadConnection->rangeEnd );
+            downloadStatus = IOT_HTTPS_PROTOCOL_ERROR;
+        }
+        else
+        {
+            /* The block is written straight from the buffer the network received it into. */
+            IotMutex_Lock( &( pDownloadConnection->pDownload->sinkMutex ) );
+            sinkStatus = pDownloadInfo->sink( pDownloadInfo->pSinkContext,
+                                              pDownloadConnection->rangeStart + pDownloadConnection->received,
+                                              pDownloadConnection->pBody,
+                                              bodyLen );
+            IotMutex_Unlock( &( pDownloadConnection->pDownload->sinkMutex ) );
+
+            if( sinkStatus )
+            {
+                pDownloadConnection->received += bodyLen;
+            }
+            else
+            {
+                IotLogError( "The sink of the download failed to write %d bytes at offset %d.",
+                             bodyLen,
+                             pDownloadConnection->rangeStart + pDownloadConnection->received );
+                downloadStatus = IOT_HTTPS_USER_CALLBACK_ERROR;
+            }
+        }
+    }
+
+    if( HTTPS_FAILED( downloadStatus ) )
+    {
+        if( HTTPS_SUCCEEDED( pDownloadConnection->status ) )
+        {
+            pDownloadConnection->status = downloadStatus;
+        }
+
+        IotHttpsClient_CancelResponseAsync( respHandle );
+    }
 }
 
 /*-----------------------------------------------------------*/
 
-static void _cancelResponse( _httpsResponse_t * pHttpsResponse )
+static void _downloadResponseCompleteCallback( void * pPrivData,
+                                               IotHttpsResponseHandle_t respHandle,
+                                               IotHttpsReturnCode_t rc,
+                                               uint16_t status )
 {
-    pHttpsResponse->cancelled = true;
+    _httpsDownloadConnection_t * pDownloadConnection = ( _httpsDownloadConnection_t * ) pPrivData;
+    IotHttpsReturnCode_t requestStatus = rc;
+
+    /* The readReadyCallback is not invoked for a response without a body, so its status is checked here. */
+    if( HTTPS_SUCCEEDED( requestStatus ) && ( respHandle != NULL ) && ( pDownloadConnection->statusChecked == false ) )
+    {
+        pDownloadConnection->statusChecked = true;
+        requestStatus = _checkDownloadResponse( pDownloadConnection, respHandle, status );
+    }
+
+    _finishDownloadRequest( pDownloadConnection, requestStatus );
 }
 
 /*-----------------------------------------------------------*/
@@ -2443,6 +3753,18 @@ IotHttpsReturnCode_t IotHttpsClient_Init( void )
         _httpParserSettings.on_chunk_header = _httpParserOnChunkHeaderCallback;
         _httpParserSettings.on_chunk_complete = _httpParserOnChunkCompleteCallback;
     #endif
+
+    #if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+        /* Start with an empty connection pool. */
+        ( void ) memset( &_connectionPool, 0x00, sizeof( _connectionPool ) );
+
+        if( IotMutex_Create( &( _connectionPool.mutex ), false ) == false )
+        {
+            IotLogError( "Failed to create the connection pool mutex." );
+            HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_INTERNAL_ERROR );
+        }
+    #endif
+
     HTTPS_GOTO_CLEANUP();
     HTTPS_FUNCTION_EXIT_NO_CLEANUP();
 }
@@ -2557,7 +3879,32 @@ static IotHttpsReturnCode_t _initializeResponse( IotHttpsResponseHandle_t * pRes
 
 void IotHttpsClient_Cleanup( void )
 {
-    /* There is nothing to clean up here as of now. */
+    #if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+        /* Stop the eviction job. If it is executing, wait for it to finish. */
+        IotMutex_Lock( &( _connectionPool.mutex ) );
+
+        while( _connectionPool.evictionJobScheduled )
+        {
+            if( IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL, _connectionPool.evictionJob, NULL ) == IOT_TASKPOOL_SUCCESS )
+            {
+                _connectionPool.evictionJobScheduled = false;
+            }
+            else
+            {
+                IotMutex_Unlock( &( _connectionPool.mutex ) );
+                IotClock_SleepMs( 1 );
+                IotMutex_Lock( &( _connectionPool.mutex ) );
+            }
+        }
+
+        IotMutex_Unlock( &( _connectionPool.mutex ) );
+
+        /* Close all idle connections. Connections still borrowed by the application must be disconnected before
+         * calling this function. */
+        _evictIdleConnections( true );
+
+        IotMutex_Destroy( &( _connectionPool.mutex ) );
+    #endif
 }
 
 /* --------------------------------------------------------- */
@@ -2571,7 +3918,7 @@ IotHttpsReturnCode_t IotHttpsClient_Connect( IotHttpsConnectionHandle_t * pConnH
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pConnHandle );
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pConnInfo );
 
-    /* If a valid connection handle is passed in. */
+    /* If a valid connection handle is passed in. A pooled connection handle is given back to the pool. */
     if( *pConnHandle != NULL )
     {
         /* If the handle in a connected state, then we want to disconnect before reconnecting. The ONLY way to put the
@@ -2589,8 +3936,16 @@ IotHttpsReturnCode_t IotHttpsClient_Connect( IotHttpsConnectionHandle_t * pConnH
         }
     }
 
-    /* Connect to the server now. Initialize all resources needed for the connection context as well here. */
-    status = _createHttpsConnection( pConnHandle, pConnInfo );
+    /* Connect to the server now. Initialize all resources needed for the connection context as well here. A pooled
+     * connection may instead reuse an idle connection to the same server. */
+    if( pConnInfo->flags & IOT_HTTPS_POOLED_CONNECTION_FLAG )
+    {
+        status = _connectPooledConnection( pConnHandle, pConnInfo );
+    }
+    else
+    {
+        status = _createHttpsConnection( pConnHandle, pConnInfo );
+    }
 
     if( HTTPS_FAILED( status ) )
     {
@@ -2606,96 +3961,20 @@ IotHttpsReturnCode_t IotHttpsClient_Disconnect( IotHttpsConnectionHandle_t connH
 {
     HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
 
-    _httpsRequest_t * pHttpsRequest = NULL;
-    _httpsResponse_t * pHttpsResponse = NULL;
-    IotLink_t * pRespItem = NULL;
-    IotLink_t * pReqItem = NULL;
-
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( connHandle );
 
-    /* If this routine is currently is progress by another thread, for instance the taskpool worker that received a
-     * network error after sending, then return right away because connection resources are being used. */
-    if( IotMutex_TryLock( &( connHandle->connectionMutex ) ) == false )
-    {
-        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_BUSY );
-    }
-
-    /* Do not attempt to disconnect an already disconnected connection.
-     * It can happen when a user calls this functions and we return IOT_HTTPS_BUSY. */
-    if( connHandle->isConnected )
-    {
-        /* Mark the network as disconnected whether the disconnect passes or not. */
-        connHandle->isConnected = false;
-        _networkDisconnect( connHandle );
-    }
-
-    /* If there is a response in the connection's response queue and the associated request has not finished sending,
-     * then we cannot destroy the connection until it finishes. */
-    pRespItem = IotDeQueue_DequeueHead( &( connHandle->respQ ) );
-
-    if( pRespItem != NULL )
-    {
-        pHttpsResponse = IotLink_Container( _httpsResponse_t, pRespItem, link );
-
-        if( pHttpsResponse->reqFinishedSending == false )
-        {
-            IotLogError( "Connection is in use. Disconnected, but cannot destroy the connection." );
-            status = IOT_HTTPS_BUSY;
-
-            /* The request is busy, to as quickly as possible allow a successful retry call of this function we must
-             * cancel the busy request which is the first in the queue. */
-            pReqItem = IotDeQueue_PeekHead( &( connHandle->reqQ ) );
-
-            if( pReqItem != NULL )
-            {
-                pHttpsRequest = IotLink_Container( _httpsRequest_t, pReqItem, link );
-                _cancelRequest( pHttpsRequest );
-            }
-
-            /* We set the status as busy, but we do not goto the cleanup right away because we still want to remove
-             * all pending requests. */
-        }
-
-        /* Delete all possible pending responses. (This is defensive.) */
-        IotDeQueue_RemoveAll( &( connHandle->respQ ), NULL, 0 );
-
-        /* Put the response that was dequeued back so that the application can call this function again to check later
-         * that is exited and marked itself as finished sending.
-         * If during the last check and this check reqFinishedSending gets set to true, that is OK because on the next
-         * call to this routine, the disconnect will succeed. */
-        if( pHttpsResponse->reqFinishedSending == false )
-        {
-            IotDeQueue_EnqueueHead( &( connHandle->respQ ), pRespItem );
-        }
-    }
-
-    /* Remove all pending requests. If this routine is called from the application context and there is a
-     * network receive callback in process, this routine will wait in _networkDestroy until that routine returns.
-     * If this is routine is called from the network receive callback context, then the destroy happens after the
-     * network receive callback context returns. */
-    IotDeQueue_RemoveAll( &( connHandle->reqQ ), NULL, 0 );
-
-    /* Do not attempt to destroy an already destroyed connection. This can happen when the user calls this function and
-     * IOT_HTTPS_BUSY is returned. */
-    if( HTTPS_SUCCEEDED( status ) )
-    {
-        if( connHandle->isDestroyed == false )
+    #if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+        /* A pooled connection is kept open for reuse if it is still healthy. */
+        if( connHandle->pPoolEntry != NULL )
         {
-            connHandle->isDestroyed = true;
-            _networkDestroy( connHandle );
+            status = _releasePooledConnection( connHandle );
+            HTTPS_GOTO_CLEANUP();
         }
-    }
-
-    HTTPS_FUNCTION_CLEANUP_BEGIN();
+    #endif
 
-    /* This function is no longer in process, so disconnecting is no longer in process. This signals to the retry
-     * on this function that it can proceed with the disconnecting activities. */
-    if( connHandle != NULL )
-    {
-        IotMutex_Unlock( &( connHandle->connectionMutex ) );
-    }
+    status = _disconnectHttpsConnection( connHandle );
 
-    HTTPS_FUNCTION_CLEANUP_END();
+    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
 }
 
 /*-----------------------------------------------------------*/
@@ -2830,6 +4109,8 @@ IotHttpsReturnCode_t IotHttpsClient_InitializeRequest( IotHttpsRequestHandle_t *
     pHttpsRequest->method = pReqInfo->method;
     /* Set the connection persistence flag for keeping the connection open after receiving a response. */
     pHttpsRequest->isNonPersistent = pReqInfo->isNonPersistent;
+    /* Save the configuration of the connection to borrow if the request is sent without a connection. */
+    pHttpsRequest->pConnInfo = pReqInfo->pConnInfo;
     /* Initialize the request cancellation. */
     pHttpsRequest->cancelled = false;
     /* Initialize the status of sending the body over the network in a possible asynchronous request. */
@@ -2929,15 +4210,14 @@ IotHttpsReturnCode_t IotHttpsClient_SendSync( IotHttpsConnectionHandle_t connHan
     HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
 
     bool respFinishedSemCreated = false;
+    bool implicitConnection = false;
+    bool requestQueued = false;
     _httpsResponse_t * pHttpsResponse = NULL;
 
     /* Parameter checks. */
-    HTTPS_ON_NULL_ARG_GOTO_CLEANUP( connHandle );
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( reqHandle );
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pRespHandle );
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pRespInfo );
-    /* Stop the application from scheduling requests on a closed connection. */
-    HTTPS_ON_ARG_ERROR_GOTO_CLEANUP( connHandle->isConnected );
 
     /* If an asynchronous request/response is configured, that is invalid for this API. */
     if( reqHandle->isAsync )
@@ -2946,6 +4226,25 @@ IotHttpsReturnCode_t IotHttpsClient_SendSync( IotHttpsConnectionHandle_t connHan
         HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_INVALID_PARAMETER );
     }
 
+    /* Borrow a connection from the connection pool if the request carries its connection configuration. */
+    if( ( connHandle == NULL ) && ( reqHandle->pConnInfo != NULL ) )
+    {
+        status = _connectPooledConnection( &connHandle, reqHandle->pConnInfo );
+
+        if( HTTPS_FAILED( status ) )
+        {
+            IotLogError( "Failed to connect for the synchronous request %d. Error code: %d.", reqHandle, status );
+            HTTPS_GOTO_CLEANUP();
+        }
+
+        connHandle->isImplicit = true;
+        implicitConnection = true;
+    }
+
+    HTTPS_ON_NULL_ARG_GOTO_CLEANUP( connHandle );
+    /* Stop the application from scheduling requests on a closed connection. */
+    HTTPS_ON_ARG_ERROR_GOTO_CLEANUP( connHandle->isConnected );
+
     /* Initialize the response handle to return. */
     status = _initializeResponse( pRespHandle, pRespInfo, reqHandle );
 
@@ -2983,6 +4282,9 @@ IotHttpsReturnCode_t IotHttpsClient_SendSync( IotHttpsConnectionHandle_t connHan
         HTTPS_GOTO_CLEANUP();
     }
 
+    /* From now on, the borrowed connection is given back when the request and response are finished. */
+    requestQueued = true;
+
     /* Wait for the request to finish. */
     if( timeoutMs == 0 )
     {
@@ -3005,6 +4307,12 @@ IotHttpsReturnCode_t IotHttpsClient_SendSync( IotHttpsConnectionHandle_t connHan
         IotSemaphore_Destroy( &( pHttpsResponse->respFinishedSem ) );
     }
 
+    /* Give back a borrowed connection that was never used. */
+    if( implicitConnection && ( requestQueued == false ) )
+    {
+        _releaseImplicitConnection( connHandle );
+    }
+
     /* If the syncStatus is anything other than IOT_HTTPS_OK, then the request was scheduled. */
     if( ( pHttpsResponse != NULL ) && HTTPS_FAILED( pHttpsResponse->syncStatus ) )
     {
@@ -3174,11 +4482,30 @@ IotHttpsReturnCode_t IotHttpsClient_SendAsync( IotHttpsConnectionHandle_t connHa
 {
     HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
 
-    HTTPS_ON_NULL_ARG_GOTO_CLEANUP( connHandle );
+    bool implicitConnection = false;
+    bool requestQueued = false;
+
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( reqHandle );
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pRespHandle );
     HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pRespInfo );
     HTTPS_ON_ARG_ERROR_GOTO_CLEANUP( reqHandle->isAsync );
+
+    /* Borrow a connection from the connection pool if the request carries its connection configuration. */
+    if( ( connHandle == NULL ) && ( reqHandle->pConnInfo != NULL ) )
+    {
+        status = _connectPooledConnection( &connHandle, reqHandle->pConnInfo );
+
+        if( HTTPS_FAILED( status ) )
+        {
+            IotLogError( "Failed to connect for the asynchronous request %d. Error code: %d.", reqHandle, status );
+            HTTPS_GOTO_CLEANUP();
+        }
+
+        connHandle->isImplicit = true;
+        implicitConnection = true;
+    }
+
+    HTTPS_ON_NULL_ARG_GOTO_CLEANUP( connHandle );
     /* Stop the application from scheduling requests on a closed connection. */
     HTTPS_ON_ARG_ERROR_GOTO_CLEANUP( connHandle->isConnected );
 
@@ -3209,7 +4536,18 @@ IotHttpsReturnCode_t IotHttpsClient_SendAsync( IotHttpsConnectionHandle_t connHa
         HTTPS_GOTO_CLEANUP();
     }
 
-    HTTPS_FUNCTION_EXIT_NO_CLEANUP();
+    /* From now on, the borrowed connection is given back when the request and response are finished. */
+    requestQueued = true;
+
+    HTTPS_FUNCTION_CLEANUP_BEGIN();
+
+    /* Give back a borrowed connection that was never used. */
+    if( implicitConnection && ( requestQueued == false ) )
+    {
+        _releaseImplicitConnection( connHandle );
+    }
+
+    HTTPS_FUNCTION_CLEANUP_END();
 }
 
 /*-----------------------------------------------------------*/
@@ -3359,6 +4697,160 @@ IotHttpsReturnCode_t IotHttpsClient_ReadContentLength( IotHttpsResponseHandle_t
 
 /*-----------------------------------------------------------*/
 
+IotHttpsReturnCode_t IotHttpsClient_Download( const IotHttpsDownloadInfo_t * pDownloadInfo,
+                                              uint32_t * pFileSize )
+{
+    HTTPS_FUNCTION_ENTRY( IOT_HTTPS_OK );
+
+    _httpsDownload_t download = { 0 };
+    _httpsDownloadConnection_t * pDownloadConnection = NULL;
+    IotHttpsReturnCode_t requestStatus = IOT_HTTPS_OK;
+    uint64_t requiredBufferLen = 0;
+    uint32_t index = 0;
+    uint32_t activeCount = 0;
+    bool finished = false;
+    bool resultMutexCreated = false;
+    bool sinkMutexCreated = false;
+    bool finishedSemCreated = false;
+
+    HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pDownloadInfo );
+    HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pDownloadInfo->pConnInfo );
+    HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pDownloadInfo->sink );
+    HTTPS_ON_NULL_ARG_GOTO_CLEANUP( pDownloadInfo->userBuffer.pBuffer );
+    HTTPS_ON_ARG_ERROR_MSG_GOTO_CLEANUP( pDownloadInfo->rangeSize > 0,
+                                         IOT_HTTPS_INVALID_PARAMETER,
+                                         "The range size of the download must not be zero." );
+    HTTPS_ON_ARG_ERROR_MSG_GOTO_CLEANUP( pDownloadInfo->numConnections > 0,
+                                         IOT_HTTPS_INVALID_PARAMETER,
+                                         "The download must use at least one connection." );
+
+    download.pDownloadInfo = pDownloadInfo;
+    download.fileSize = pDownloadInfo->fileSize;
+
+    /* Each connection takes an equal share of the user buffer, rounded down so that the next share is aligned. */
+    download.connectionBufferLen = ( pDownloadInfo->userBuffer.bufferLen / pDownloadInfo->numConnections ) &
+                                   ~( ( uint32_t ) sizeof( uint64_t ) - 1 );
+    requiredBufferLen = ( uint64_t ) downloadUserBufferMinimumSize +
+                        pDownloadInfo->pathLen +
+                        pDownloadInfo->pConnInfo->addressLen;
+    HTTPS_ON_ARG_ERROR_MSG_GOTO_CLEANUP( download.connectionBufferLen >= requiredBufferLen,
+                                         IOT_HTTPS_INSUFFICIENT_MEMORY,
+                                         "The download user buffer of length %d is too small for %d connections. Each connection needs at least %d bytes.",
+                                         pDownloadInfo->userBuffer.bufferLen,
+                                         pDownloadInfo->numConnections,
+                                         ( uint32_t ) requiredBufferLen );
+
+    resultMutexCreated = IotMutex_Create( &( download.resultMutex ), false );
+    sinkMutexCreated = IotMutex_Create( &( download.sinkMutex ), false );
+    finishedSemCreated = IotSemaphore_Create( &( download.finishedSem ), 0, pDownloadInfo->numConnections );
+
+    if( !resultMutexCreated || !sinkMutexCreated || !finishedSemCreated )
+    {
+        IotLogError( "Failed to create the internal mutexes and semaphore of the download." );
+        HTTPS_SET_AND_GOTO_CLEANUP( IOT_HTTPS_INTERNAL_ERROR );
+    }
+
+    for( index = 0; index < pDownloadInfo->numConnections; index++ )
+    {
+        _initializeDownloadConnection( &download, index );
+    }
+
+    while( true )
+    {
+        /* Give a range to every connection that is not busy. A connection with nothing left to download, and every
+         * connection once the download failed, goes back to the pool. */
+        for( index = 0; index < pDownloadInfo->numConnections; index++ )
+        {
+            pDownloadConnection = _getDownloadConnection( &download, index );
+
+            if( pDownloadConnection->active )
+            {
+                continue;
+            }
+
+            if( HTTPS_SUCCEEDED( status ) && _getNextDownloadRange( &download, pDownloadConnection ) )
+            {
+                pDownloadConnection->active = true;
+                activeCount++;
+                requestStatus = _startDownloadRequest( pDownloadConnection );
+
+                /* A request that could not be sent is handled like one that failed on the network. */
+                if( HTTPS_FAILED( requestStatus ) )
+                {
+                    _finishDownloadRequest( pDownloadConnection, requestStatus );
+                }
+            }
+            else
+            {
+                _closeDownloadConnection( pDownloadConnection, true );
+            }
+        }
+
+        if( activeCount == 0 )
+        {
+            break;
+        }
+
+        /* Each finished request posts once. A wake up can find no finished request when an earlier wake up already
+         * processed it, which is harmless. */
+        IotSemaphore_Wait( &( download.finishedSem ) );
+
+        for( index = 0; index < pDownloadInfo->numConnections; index++ )
+        {
+            pDownloadConnection = _getDownloadConnection( &download, index );
+
+            if( pDownloadConnection->active == false )
+            {
+                continue;
+            }
+
+            IotMutex_Lock( &( download.resultMutex ) );
+            finished = pDownloadConnection->finished;
+            IotMutex_Unlock( &( download.resultMutex ) );
+
+            if( finished )
+            {
+                pDownloadConnection->active = false;
+                activeCount--;
+                requestStatus = _processDownloadResult( &download, pDownloadConnection );
+
+                /* The download stops giving out ranges after the first failure and waits for the requests in
+                 * progress. */
+                if( HTTPS_FAILED( requestStatus ) && HTTPS_SUCCEEDED( status ) )
+                {
+                    status = requestStatus;
+                }
+            }
+        }
+    }
+
+    HTTPS_FUNCTION_CLEANUP_BEGIN();
+
+    if( finishedSemCreated )
+    {
+        IotSemaphore_Destroy( &( download.finishedSem ) );
+    }
+
+    if( sinkMutexCreated )
+    {
+        IotMutex_Destroy( &( download.sinkMutex ) );
+    }
+
+    if( resultMutexCreated )
+    {
+        IotMutex_Destroy( &( download.resultMutex ) );
+    }
+
+    if( pFileSize != NULL )
+    {
+        *pFileSize = download.fileSize;
+    }
+
+    HTTPS_FUNCTION_CLEANUP_END();
+}
+
+/*-----------------------------------------------------------*/
+
 /* Provide access to internal functions and variables if testing. */
 #if IOT_BUILD_TESTS == 1
     #include "iot_test_access_https_client.c"
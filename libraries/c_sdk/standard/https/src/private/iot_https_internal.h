@@ -51,6 +51,7 @@
 #include "types/iot_taskpool_types.h"
 
 /* Platform layer includes. */
+#include "platform/iot_clock.h"
 #include "platform/iot_threads.h"
 #include "platform/iot_network.h"
 
@@ -177,6 +178,18 @@
 #ifndef IOT_HTTPS_MAX_ALPN_PROTOCOLS_LENGTH
     #define IOT_HTTPS_MAX_ALPN_PROTOCOLS_LENGTH    ( 255 ) /* The maximum alpn protocols length is chosen arbitrarily. */
 #endif
+#ifndef IOT_HTTPS_CONNECTION_POOL_SIZE
+    #define IOT_HTTPS_CONNECTION_POOL_SIZE               ( 2 )
+#endif
+#ifndef IOT_HTTPS_CONNECTION_POOL_MAX_IDLE
+    #define IOT_HTTPS_CONNECTION_POOL_MAX_IDLE           IOT_HTTPS_CONNECTION_POOL_SIZE
+#endif
+#ifndef IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS
+    #define IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS    ( 4000 ) /* Below the 5 second keep-alive timeout of common servers. */
+#endif
+#ifndef IOT_HTTPS_DOWNLOAD_RESPONSE_HEADERS_SIZE
+    #define IOT_HTTPS_DOWNLOAD_RESPONSE_HEADERS_SIZE     ( 512 )
+#endif
 
 /** @endcond */
 
@@ -237,6 +250,50 @@
 #define HTTPS_CONTENT_LENGTH_HEADER                   "Content-Length"
 #define HTTPS_CONNECTION_HEADER                       "Connection"
 
+/*
+ * Constants for the header fields of ranged downloads.
+ */
+#define HTTPS_RANGE_HEADER                            "Range"
+#define HTTPS_CONTENT_RANGE_HEADER                    "Content-Range"
+#define HTTPS_RANGE_VALUE_PREFIX                      "bytes="
+#define HTTPS_CONTENT_RANGE_VALUE_PREFIX              "bytes "
+
+/**
+ * @brief The maximum Range header value size.
+ *
+ * This is the length of the header value string "bytes=4294967295-4294967295" with a NULL terminator for snprintf.
+ */
+#define HTTPS_MAX_RANGE_VALUE_LENGTH                  ( 28 )
+
+/**
+ * @brief The maximum Range header line size.
+ *
+ * This is the space needed in the request user buffer of a ranged download for "Range: bytes=N-M\r\n".
+ */
+#define HTTPS_MAX_RANGE_LINE_LENGTH                   ( sizeof( HTTPS_RANGE_HEADER ) - 1 + HTTPS_HEADER_FIELD_SEPARATOR_LENGTH + HTTPS_MAX_RANGE_VALUE_LENGTH + HTTPS_END_OF_HEADER_LINES_INDICATOR_LENGTH )
+
+/**
+ * @brief The maximum Content-Range header value size.
+ *
+ * This is the length of the header value string "bytes 4294967295-4294967295/4294967295" with a NULL terminator.
+ */
+#define HTTPS_MAX_CONTENT_RANGE_VALUE_LENGTH          ( 39 )
+
+/**
+ * @brief The minimum size of the buffer that a ranged download reads the response body of each connection into.
+ */
+#define HTTPS_DOWNLOAD_MINIMUM_BODY_BUFFER_SIZE       ( 256 )
+
+/**
+ * @brief Round up a size in the user buffer of a ranged download so that the context following it is aligned.
+ */
+#define HTTPS_DOWNLOAD_ALIGN( size )                  ( ( ( size ) + sizeof( uint64_t ) - 1 ) & ~( sizeof( uint64_t ) - 1 ) )
+
+/**
+ * @brief The time to wait before trying again to disconnect a connection of a ranged download that is busy.
+ */
+#define HTTPS_DOWNLOAD_DISCONNECT_RETRY_MS            ( 10 )
+
 /**
  * @brief The maximum Content-Length header line size.
  *
@@ -390,8 +447,76 @@ typedef struct _httpsConnection
     IotDeQueue_t respQ;                         /**< @brief The queue for the responses that are waiting to be processed. */
     IotTaskPoolJobStorage_t taskPoolJobStorage; /**< @brief An asynchronous operation requires storage for the task pool job. */
     IotTaskPoolJob_t taskPoolJob;               /**< @brief The task pool job identifier for an asynchronous request. */
+    struct _httpsPooledConnection * pPoolEntry; /**< @brief The connection pool entry holding this connection, NULL if this connection is not pooled. */
+
+    /**
+     * @brief true if this connection was borrowed by @ref https_client_function_sendsync or
+     * @ref https_client_function_sendasync for a request configured with #IotHttpsRequestInfo_t.pConnInfo.
+     *
+     * Such a connection is given back to the connection pool as soon as its request and response queues are empty.
+     */
+    bool isImplicit;
 } _httpsConnection_t;
 
+/**
+ * @brief The state of an entry in the connection pool.
+ */
+typedef enum _httpsPoolEntryState
+{
+    POOL_ENTRY_FREE = 0, /**< @brief The entry does not hold a connection. */
+    POOL_ENTRY_IN_USE,   /**< @brief The entry holds a connection borrowed by the application. */
+    POOL_ENTRY_IDLE      /**< @brief The entry holds an idle connection waiting to be reused. */
+} _httpsPoolEntryState_t;
+
+/**
+ * @brief An entry of the connection pool.
+ *
+ * The pool owns the memory of the connection context of a pooled connection, so that the connection can outlive the
+ * application buffers of the request that created it. A pooled connection is reused only for a connection
+ * configuration with the same key: server address, port, TLS flags, network interface, ALPN protocols, and
+ * credentials. Credentials are compared by address and length; the application must not modify credentials that
+ * are used by pooled connections.
+ */
+typedef struct _httpsPooledConnection
+{
+    _httpsConnection_t connection;                              /**< @brief The pooled connection context. */
+    _httpsPoolEntryState_t state;                               /**< @brief The state of this entry. */
+    uint64_t idleSinceMs;                                       /**< @brief The time at which the connection became idle. */
+    char pAddress[ IOT_HTTPS_MAX_HOST_NAME_LENGTH ];            /**< @brief Server address of the connection. */
+    uint32_t addressLen;                                        /**< @brief Length of pAddress. */
+    uint16_t port;                                              /**< @brief Server port of the connection. */
+    uint32_t flags;                                             /**< @brief The #IotHttpsConnectionInfo_t.flags that affect the connection. */
+    const IotNetworkInterface_t * pNetworkInterface;            /**< @brief Network interface of the connection. */
+    char pAlpnProtocols[ IOT_HTTPS_MAX_ALPN_PROTOCOLS_LENGTH ]; /**< @brief ALPN protocols of the connection. */
+    uint32_t alpnProtocolsLen;                                  /**< @brief Length of pAlpnProtocols. */
+    const char * pCaCert;                                       /**< @brief Server trusted certificate store of the connection. */
+    uint32_t caCertLen;                                         /**< @brief Length of pCaCert. */
+    const char * pClientCert;                                   /**< @brief Client certificate of the connection. */
+    uint32_t clientCertLen;                                     /**< @brief Length of pClientCert. */
+    const char * pPrivateKey;                                   /**< @brief Client private key of the connection. */
+    uint32_t privateKeyLen;                                     /**< @brief Length of pPrivateKey. */
+} _httpsPooledConnection_t;
+
+#if ( IOT_HTTPS_CONNECTION_POOL_SIZE > 0 )
+
+/**
+ * @brief The process-wide pool of persistent connections.
+ *
+ * The entries, the idle count, and the eviction job state are protected by the mutex. A connection mutex may be taken
+ * while holding the pool mutex, but not the other way around. Network calls are never made while holding the pool
+ * mutex: an entry is marked in use before its connection is closed.
+ */
+    typedef struct _httpsConnectionPool
+    {
+        IotMutex_t mutex;                                                   /**< @brief Protects the connection pool. */
+        _httpsPooledConnection_t entries[ IOT_HTTPS_CONNECTION_POOL_SIZE ]; /**< @brief The connection pool entries. */
+        uint32_t idleCount;                                                 /**< @brief The number of entries in the #POOL_ENTRY_IDLE state. */
+        IotTaskPoolJobStorage_t evictionJobStorage;                         /**< @brief Storage of the eviction job. */
+        IotTaskPoolJob_t evictionJob;                                       /**< @brief Job closing connections that exceeded the idle timeout. */
+        bool evictionJobScheduled;                                          /**< @brief true while the eviction job is scheduled or executing. */
+    } _httpsConnectionPool_t;
+#endif
+
 /**
  * @brief Third party library http-parser information.
  *
@@ -480,6 +605,50 @@ typedef struct _httpsRequest
     bool scheduled;                             /**< @brief Set to true when this request has already been scheduled to the task pool. */
 } _httpsRequest_t;
 
+/**
+ * @brief Represents one connection of a ranged download and the range it is currently downloading.
+ *
+ * Each connection of @ref IotHttpsClient_Download() takes an equal share of #IotHttpsDownloadInfo_t.userBuffer. The
+ * share starts with this context and is followed by the connection, response and request user buffers, and the buffer
+ * that the response body is read into.
+ */
+typedef struct _httpsDownloadConnection
+{
+    struct _httpsDownload * pDownload;                /**< @brief The download this connection belongs to. */
+    IotHttpsConnectionHandle_t connHandle;            /**< @brief The connection, or NULL if it is not connected. */
+    IotHttpsRequestHandle_t reqHandle;                /**< @brief The request for the current range. */
+    IotHttpsResponseHandle_t respHandle;              /**< @brief The response for the current range. */
+    IotHttpsConnectionInfo_t connInfo;                /**< @brief The connection configuration with pooling enabled. */
+    IotHttpsRequestInfo_t reqInfo;                    /**< @brief The configuration of the range requests. */
+    IotHttpsResponseInfo_t respInfo;                  /**< @brief The configuration of the range responses. */
+    IotHttpsAsyncInfo_t asyncInfo;                    /**< @brief The callbacks of the range requests. */
+    uint8_t * pBody;                                  /**< @brief The buffer the response body is read into before it is written to the sink. */
+    uint32_t bodyLen;                                 /**< @brief The length of the body buffer. */
+    uint32_t rangeStart;                              /**< @brief Offset of the first byte of the current request. */
+    uint32_t rangeEnd;                                /**< @brief Offset after the last byte of the current range. */
+    uint32_t received;                                /**< @brief Number of bytes of the current request written to the sink. */
+    uint32_t retries;                                 /**< @brief Number of times the current range was retried. */
+    IotHttpsReturnCode_t status;                      /**< @brief The first error of the current request. */
+    bool statusChecked;                               /**< @brief Set once the response status of the current request was checked. */
+    bool active;                                      /**< @brief Set while a request of this connection is in progress. */
+    bool finished;                                    /**< @brief Set by the response complete callback when the request is done. */
+    char pRangeValue[ HTTPS_MAX_RANGE_VALUE_LENGTH ]; /**< @brief The Range header value of the current request. */
+} _httpsDownloadConnection_t;
+
+/**
+ * @brief Represents a ranged download in progress.
+ */
+typedef struct _httpsDownload
+{
+    const IotHttpsDownloadInfo_t * pDownloadInfo; /**< @brief The download configuration. */
+    uint32_t connectionBufferLen;                 /**< @brief The share of the user buffer of each connection. */
+    IotMutex_t resultMutex;                       /**< @brief Protects the results of the requests and the resource size. */
+    IotMutex_t sinkMutex;                         /**< @brief Serializes the calls to the sink. */
+    IotSemaphore_t finishedSem;                   /**< @brief Posted each time a connection finishes a request. */
+    uint32_t fileSize;                            /**< @brief Size of the resource, 0 until it is known. */
+    uint32_t nextOffset;                          /**< @brief Offset of the first byte not yet given to a connection. */
+} _httpsDownload_t;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -265,6 +265,29 @@ static IotNetworkError_t _setReceiveCallbackFail( void * pConnection,
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief The number of network connections created by _networkCreateCounted().
+ *
+ * HTTP tests run sequentially, so there is no race condition here.
+ */
+static uint32_t _networkCreateCount = 0;
+
+/**
+ * @brief Network Abstraction create function that succeeds and counts the connections created.
+ */
+static IotNetworkError_t _networkCreateCounted( void * pConnectionInfo,
+                                                void * pCredentialInfo,
+                                                void ** pConnection )
+{
+    ( void ) pConnectionInfo;
+    ( void ) pCredentialInfo;
+    ( void ) pConnection;
+    _networkCreateCount++;
+    return IOT_NETWORK_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Mock the http parser execution failing.
  */
@@ -295,6 +318,9 @@ TEST_GROUP( HTTPS_Client_Unit_API );
  */
 TEST_SETUP( HTTPS_Client_Unit_API )
 {
+    /* Initialize the SDK for the task pool used to close idle pooled connections. */
+    TEST_ASSERT_EQUAL_INT( true, IotSdk_Init() );
+
     /* Initialize the library. */
     TEST_ASSERT_EQUAL( IOT_HTTPS_OK, IotHttpsClient_Init() );
 
@@ -315,6 +341,7 @@ TEST_TEAR_DOWN( HTTPS_Client_Unit_API )
 {
     /* Clean up the library after the tests. */
     IotHttpsClient_Cleanup();
+    IotSdk_Cleanup();
 }
 
 /*-----------------------------------------------------------*/
@@ -330,6 +357,11 @@ TEST_GROUP_RUNNER( HTTPS_Client_Unit_API )
     RUN_TEST_CASE( HTTPS_Client_Unit_API, DisconnectInvalidParameters );
     RUN_TEST_CASE( HTTPS_Client_Unit_API, DisconnectFailure );
     RUN_TEST_CASE( HTTPS_Client_Unit_API, DisconnectSuccess );
+    RUN_TEST_CASE( HTTPS_Client_Unit_API, ConnectPooledReusesIdleConnection );
+    RUN_TEST_CASE( HTTPS_Client_Unit_API, ConnectPooledDifferentServer );
+    RUN_TEST_CASE( HTTPS_Client_Unit_API, ConnectPooledClosedIdleConnection );
+    RUN_TEST_CASE( HTTPS_Client_Unit_API, ConnectPooledExpiredIdleConnection );
+    RUN_TEST_CASE( HTTPS_Client_Unit_API, ConnectPooledPoolFull );
     RUN_TEST_CASE( HTTPS_Client_Unit_API, InitializeRequestInvalidParameters );
     RUN_TEST_CASE( HTTPS_Client_Unit_API, InitializeRequestFormatCheck );
     RUN_TEST_CASE( HTTPS_Client_Unit_API, AddHeaderInvalidParameters );
@@ -626,6 +658,221 @@ TEST( HTTPS_Client_Unit_API, DisconnectSuccess )
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Test that a pooled connection given back with @ref https_client_function_disconnect is reused by the next
+ * connect to the same server.
+ */
+TEST( HTTPS_Client_Unit_API, ConnectPooledReusesIdleConnection )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    IotHttpsConnectionInfo_t connInfo = _connInfo;
+    IotHttpsConnectionHandle_t connHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+    IotHttpsConnectionHandle_t reusedConnHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+
+    _networkInterface.create = _networkCreateCounted;
+    _networkInterface.setReceiveCallback = _setReceiveCallbackSuccess;
+    _networkInterface.close = _networkCloseSuccess;
+    _networkInterface.destroy = _networkDestroySuccess;
+    _networkCreateCount = 0;
+    connInfo.flags |= IOT_HTTPS_POOLED_CONNECTION_FLAG;
+
+    returnCode = IotHttpsClient_Connect( &connHandle, &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_NOT_NULL( connHandle );
+    /* The connection context is not stored in the user buffer. */
+    TEST_ASSERT_NOT_NULL( connHandle->pPoolEntry );
+    TEST_ASSERT_TRUE( ( uint8_t * ) connHandle != connInfo.userBuffer.pBuffer );
+
+    /* Disconnecting keeps the connection open and idle. */
+    returnCode = IotHttpsClient_Disconnect( connHandle );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_TRUE( connHandle->isConnected );
+    TEST_ASSERT_EQUAL( POOL_ENTRY_IDLE, connHandle->pPoolEntry->state );
+
+    /* Disconnecting twice does not give the connection back twice. */
+    returnCode = IotHttpsClient_Disconnect( connHandle );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL( POOL_ENTRY_IDLE, connHandle->pPoolEntry->state );
+
+    /* The same server gets the idle connection without connecting again. */
+    returnCode = IotHttpsClient_Connect( &reusedConnHandle, &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL_PTR( connHandle, reusedConnHandle );
+    TEST_ASSERT_EQUAL( POOL_ENTRY_IN_USE, reusedConnHandle->pPoolEntry->state );
+    TEST_ASSERT_EQUAL( 1, _networkCreateCount );
+
+    /* Connections still idle are closed by IotHttpsClient_Cleanup(). */
+    returnCode = IotHttpsClient_Disconnect( reusedConnHandle );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    IotHttpsClient_Cleanup();
+    TEST_ASSERT_FALSE( connHandle->isConnected );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, IotHttpsClient_Init() );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that an idle pooled connection is not reused for a different server.
+ */
+TEST( HTTPS_Client_Unit_API, ConnectPooledDifferentServer )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    IotHttpsConnectionInfo_t connInfo = _connInfo;
+    IotHttpsConnectionHandle_t connHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+    IotHttpsConnectionHandle_t otherConnHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+
+    _networkInterface.create = _networkCreateCounted;
+    _networkInterface.setReceiveCallback = _setReceiveCallbackSuccess;
+    _networkInterface.close = _networkCloseSuccess;
+    _networkInterface.destroy = _networkDestroySuccess;
+    _networkCreateCount = 0;
+    connInfo.flags |= IOT_HTTPS_POOLED_CONNECTION_FLAG;
+
+    returnCode = IotHttpsClient_Connect( &connHandle, &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    returnCode = IotHttpsClient_Disconnect( connHandle );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+
+    /* A different port is a different server. */
+    connInfo.port = HTTPS_TEST_PORT + 1;
+    returnCode = IotHttpsClient_Connect( &otherConnHandle, &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_TRUE( connHandle != otherConnHandle );
+    TEST_ASSERT_EQUAL( 2, _networkCreateCount );
+
+    /* The first connection stays idle for its own server. */
+    TEST_ASSERT_EQUAL( POOL_ENTRY_IDLE, connHandle->pPoolEntry->state );
+    TEST_ASSERT_TRUE( connHandle->isConnected );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that an idle pooled connection closed by the server is not reused.
+ */
+TEST( HTTPS_Client_Unit_API, ConnectPooledClosedIdleConnection )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    IotHttpsConnectionInfo_t connInfo = _connInfo;
+    IotHttpsConnectionHandle_t connHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+    IotHttpsConnectionHandle_t newConnHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+
+    _networkInterface.create = _networkCreateCounted;
+    _networkInterface.setReceiveCallback = _setReceiveCallbackSuccess;
+    _networkInterface.receiveUpto = _networkReceiveSuccess;
+    _networkInterface.close = _networkCloseSuccess;
+    _networkInterface.destroy = _networkDestroySuccess;
+    _networkCreateCount = 0;
+    connInfo.flags |= IOT_HTTPS_POOLED_CONNECTION_FLAG;
+
+    returnCode = IotHttpsClient_Connect( &connHandle, &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    returnCode = IotHttpsClient_Disconnect( connHandle );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+
+    /* Data received without a request waiting for it, such as a close from the server, disconnects the idle
+     * connection. */
+    IotTestHttps_networkReceiveCallback( NULL, connHandle );
+    TEST_ASSERT_FALSE( connHandle->isConnected );
+
+    /* A new connection is made in the freed entry. */
+    returnCode = IotHttpsClient_Connect( &newConnHandle, &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_TRUE( newConnHandle->isConnected );
+    TEST_ASSERT_EQUAL( POOL_ENTRY_IN_USE, newConnHandle->pPoolEntry->state );
+    TEST_ASSERT_EQUAL( 2, _networkCreateCount );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that an idle pooled connection is not reused after the idle timeout.
+ */
+TEST( HTTPS_Client_Unit_API, ConnectPooledExpiredIdleConnection )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    IotHttpsConnectionInfo_t connInfo = _connInfo;
+    IotHttpsConnectionHandle_t connHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+    IotHttpsConnectionHandle_t newConnHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+
+    _networkInterface.create = _networkCreateCounted;
+    _networkInterface.setReceiveCallback = _setReceiveCallbackSuccess;
+    _networkInterface.close = _networkCloseSuccess;
+    _networkInterface.destroy = _networkDestroySuccess;
+    _networkCreateCount = 0;
+    connInfo.flags |= IOT_HTTPS_POOLED_CONNECTION_FLAG;
+
+    returnCode = IotHttpsClient_Connect( &connHandle, &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    returnCode = IotHttpsClient_Disconnect( connHandle );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+
+    /* Age the idle connection instead of waiting for the timeout. */
+    connHandle->pPoolEntry->idleSinceMs -= IOT_HTTPS_CONNECTION_POOL_IDLE_TIMEOUT_MS;
+
+    returnCode = IotHttpsClient_Connect( &newConnHandle, &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_TRUE( connHandle != newConnHandle );
+    TEST_ASSERT_EQUAL( 2, _networkCreateCount );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test pooled connections when every pool entry is in use.
+ */
+TEST( HTTPS_Client_Unit_API, ConnectPooledPoolFull )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    IotHttpsConnectionInfo_t connInfo = _connInfo;
+    IotHttpsConnectionHandle_t connHandles[ IOT_HTTPS_CONNECTION_POOL_SIZE + 1 ] = { 0 };
+    uint32_t i = 0;
+
+    _networkInterface.create = _networkCreateCounted;
+    _networkInterface.setReceiveCallback = _setReceiveCallbackSuccess;
+    _networkInterface.close = _networkCloseSuccess;
+    _networkInterface.destroy = _networkDestroySuccess;
+    _networkCreateCount = 0;
+    connInfo.flags |= IOT_HTTPS_POOLED_CONNECTION_FLAG;
+
+    for( i = 0; i < IOT_HTTPS_CONNECTION_POOL_SIZE; i++ )
+    {
+        returnCode = IotHttpsClient_Connect( &connHandles[ i ], &connInfo );
+        TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+        TEST_ASSERT_NOT_NULL( connHandles[ i ]->pPoolEntry );
+    }
+
+    /* The connection that does not fit in the pool is stored in the user buffer. */
+    returnCode = IotHttpsClient_Connect( &connHandles[ IOT_HTTPS_CONNECTION_POOL_SIZE ], &connInfo );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL_PTR( connInfo.userBuffer.pBuffer, connHandles[ IOT_HTTPS_CONNECTION_POOL_SIZE ] );
+    TEST_ASSERT_NULL( connHandles[ IOT_HTTPS_CONNECTION_POOL_SIZE ]->pPoolEntry );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_CONNECTION_POOL_SIZE + 1, _networkCreateCount );
+
+    /* It is closed when disconnected. */
+    returnCode = IotHttpsClient_Disconnect( connHandles[ IOT_HTTPS_CONNECTION_POOL_SIZE ] );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_FALSE( connHandles[ IOT_HTTPS_CONNECTION_POOL_SIZE ]->isConnected );
+
+    /* At most IOT_HTTPS_CONNECTION_POOL_MAX_IDLE connections are kept idle. */
+    for( i = 0; i < IOT_HTTPS_CONNECTION_POOL_SIZE; i++ )
+    {
+        returnCode = IotHttpsClient_Disconnect( connHandles[ i ] );
+        TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+
+        if( i < IOT_HTTPS_CONNECTION_POOL_MAX_IDLE )
+        {
+            TEST_ASSERT_EQUAL( POOL_ENTRY_IDLE, connHandles[ i ]->pPoolEntry->state );
+        }
+        else
+        {
+            TEST_ASSERT_FALSE( connHandles[ i ]->isConnected );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Test intitializing an HTTP request with various invalid parameters.
  */
@@ -0,0 +1,875 @@
+/*
+ * Amazon FreeRTOS HTTPS Client V1.1.0
+ * Copyright (C) 2019 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file iot_tests_https_download.c
+ * @brief Tests for IotHttpsClient_Download() in iot_https_client.h.
+ *
+ * The network abstraction in this file stands in for a local HTTP server that serves Range requests for a test
+ * resource. Each response is delivered by a separate thread after a fixed latency, like a server on another host.
+ */
+
+#include "iot_tests_https_common.h"
+#include "platform/iot_clock.h"
+
+/**
+ * @brief The size of the test resource served by the test server.
+ */
+#define HTTPS_TEST_DOWNLOAD_FILE_SIZE                 ( 32768 )
+
+/**
+ * @brief The size of the Range requests of the tests.
+ */
+#define HTTPS_TEST_DOWNLOAD_RANGE_SIZE                ( 2048 )
+
+/**
+ * @brief The maximum number of connections used by a download in the tests.
+ */
+#define HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS           ( 4 )
+
+/**
+ * @brief The share of the download user buffer of each connection.
+ */
+#define HTTPS_TEST_DOWNLOAD_CONNECTION_BUFFER_SIZE    ( 2048 )
+
+/**
+ * @brief The time the test server takes to answer a request.
+ */
+#define HTTPS_TEST_DOWNLOAD_LATENCY_MS                ( ( uint32_t ) 20 )
+
+/**
+ * @brief The maximum number of network connections open on the test server at the same time.
+ */
+#define HTTPS_TEST_DOWNLOAD_MAX_SERVER_CONNECTIONS    ( 16 )
+
+/**
+ * @brief The maximum length of a request received by the test server.
+ */
+#define HTTPS_TEST_DOWNLOAD_MAX_REQUEST_LENGTH        ( 512 )
+
+/**
+ * @brief The maximum length of the headers of a response of the test server.
+ */
+#define HTTPS_TEST_DOWNLOAD_MAX_HEADERS_LENGTH        ( 256 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A network connection of the test server.
+ *
+ * The response is the headers in pHeaders followed by bodyLen bytes of the test resource from bodyOffset.
+ */
+typedef struct _testServerConnection
+{
+    bool inUse;                                                /**< @brief If this connection is open. */
+    IotNetworkReceiveCallback_t receiveCallback;               /**< @brief The network receive callback of the HTTPS Client. */
+    void * pReceiveContext;                                    /**< @brief The context of receiveCallback. */
+    char pRequest[ HTTPS_TEST_DOWNLOAD_MAX_REQUEST_LENGTH ];   /**< @brief The request received so far. */
+    size_t requestLen;                                         /**< @brief The length of pRequest. */
+    char pHeaders[ HTTPS_TEST_DOWNLOAD_MAX_HEADERS_LENGTH ];   /**< @brief The headers of the response. */
+    size_t headersLen;                                         /**< @brief The length of pHeaders. */
+    uint32_t bodyOffset;                                       /**< @brief The offset in the resource of the response body. */
+    uint32_t bodyLen;                                          /**< @brief The length of the response body sent before closing. */
+    size_t responseSent;                                       /**< @brief The number of response bytes received by the HTTPS Client. */
+} _testServerConnection_t;
+
+/**
+ * @brief The state and the behavior of the test server.
+ */
+typedef struct _testServer
+{
+    IotMutex_t mutex;                                                                  /**< @brief Protects this structure. */
+    _testServerConnection_t connections[ HTTPS_TEST_DOWNLOAD_MAX_SERVER_CONNECTIONS ]; /**< @brief The network connections. */
+    uint32_t fileSize;                                                                 /**< @brief The size of the served resource. */
+    bool ignoreRange;                                                                  /**< @brief Answer all requests with 200 OK and the whole resource. */
+    uint16_t failureStatus;                                                            /**< @brief If not zero, the status of the responses to fail. */
+    uint32_t failuresLeft;                                                             /**< @brief The number of responses still to fail. */
+    uint32_t truncationsLeft;                                                          /**< @brief The number of responses still to cut in the middle of the body. */
+    uint32_t connectionsCreated;                                                       /**< @brief The number of connections created. */
+    uint32_t requestsServed;                                                           /**< @brief The number of requests answered. */
+    uint32_t requestsInFlight;                                                         /**< @brief The number of requests being answered. */
+    uint32_t maxRequestsInFlight;                                                      /**< @brief The maximum of requestsInFlight. */
+} _testServer_t;
+
+/**
+ * @brief The state of the test sink.
+ */
+typedef struct _testSink
+{
+    uint8_t pData[ HTTPS_TEST_DOWNLOAD_FILE_SIZE ]; /**< @brief The resource written by the download. */
+    uint32_t bytesWritten;                          /**< @brief The number of bytes written to the sink. */
+    uint32_t callCount;                             /**< @brief The number of calls to the sink. */
+    uint32_t failAtCall;                            /**< @brief If not zero, the call to the sink that fails. */
+    bool concurrentCall;                            /**< @brief If the sink was called while it was already running. */
+    bool running;                                   /**< @brief If the sink is running. */
+} _testSink_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The resource served by the test server.
+ */
+static uint8_t _pTestFile[ HTTPS_TEST_DOWNLOAD_FILE_SIZE ] = { 0 };
+
+/**
+ * @brief The test server.
+ */
+static _testServer_t _testServer = { 0 };
+
+/**
+ * @brief The test sink.
+ */
+static _testSink_t _testSink = { 0 };
+
+/**
+ * @brief The user buffer of the downloads.
+ */
+static uint8_t _pDownloadUserBuffer[ HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS * HTTPS_TEST_DOWNLOAD_CONNECTION_BUFFER_SIZE ] = { 0 };
+
+/**
+ * @brief The download configuration of the tests, reset before each test.
+ */
+static IotHttpsDownloadInfo_t _downloadInfo = IOT_HTTPS_DOWNLOAD_INFO_INITIALIZER;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Deliver the response prepared on a test server connection after the latency of the server.
+ */
+static void _testServerRespond( void * pArgument )
+{
+    _testServerConnection_t * pServerConnection = ( _testServerConnection_t * ) pArgument;
+
+    IotClock_SleepMs( HTTPS_TEST_DOWNLOAD_LATENCY_MS );
+
+    pServerConnection->receiveCallback( pServerConnection, pServerConnection->pReceiveContext );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Prepare the response of the test server to a complete request.
+ */
+static void _testServerPrepareResponse( _testServerConnection_t * pServerConnection )
+{
+    char * pRange = strstr( pServerConnection->pRequest, "Range: bytes=" );
+    char * pRangeEnd = NULL;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    int headersLen = 0;
+
+    if( pRange != NULL )
+    {
+        first = strtoul( pRange + strlen( "Range: bytes=" ), &pRangeEnd, 10 );
+        last = strtoul( pRangeEnd + 1, NULL, 10 );
+    }
+
+    if( last >= _testServer.fileSize )
+    {
+        last = _testServer.fileSize - 1;
+    }
+
+    pServerConnection->responseSent = 0;
+
+    if( _testServer.failuresLeft > 0 )
+    {
+        _testServer.failuresLeft--;
+        pServerConnection->bodyOffset = 0;
+        pServerConnection->bodyLen = 0;
+        headersLen = snprintf( pServerConnection->pHeaders,
+                               sizeof( pServerConnection->pHeaders ),
+                               "HTTP/1.1 %d Failure\r\nContent-Length: 0\r\n\r\n",
+                               _testServer.failureStatus );
+    }
+    else if( ( pRange == NULL ) || _testServer.ignoreRange )
+    {
+        pServerConnection->bodyOffset = 0;
+        pServerConnection->bodyLen = _testServer.fileSize;
+        headersLen = snprintf( pServerConnection->pHeaders,
+                               sizeof( pServerConnection->pHeaders ),
+                               "HTTP/1.1 200 OK\r\nContent-Length: %lu\r\n\r\n",
+                               ( unsigned long ) _testServer.fileSize );
+    }
+    else
+    {
+        pServerConnection->bodyOffset = first;
+        pServerConnection->bodyLen = last - first + 1;
+        headersLen = snprintf( pServerConnection->pHeaders,
+                               sizeof( pServerConnection->pHeaders ),
+                               "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %lu-%lu/%lu\r\nContent-Length: %lu\r\n\r\n",
+                               ( unsigned long ) first,
+                               ( unsigned long ) last,
+                               ( unsigned long ) _testServer.fileSize,
+                               ( unsigned long ) pServerConnection->bodyLen );
+    }
+
+    pServerConnection->headersLen = ( size_t ) headersLen;
+
+    /* A truncated response closes the connection in the middle of the body. */
+    if( _testServer.truncationsLeft > 0 )
+    {
+        _testServer.truncationsLeft--;
+        pServerConnection->bodyLen /= 2;
+    }
+
+    _testServer.requestsServed++;
+    _testServer.requestsInFlight++;
+
+    if( _testServer.requestsInFlight > _testServer.maxRequestsInFlight )
+    {
+        _testServer.maxRequestsInFlight = _testServer.requestsInFlight;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Network Abstraction create function of the test server.
+ */
+static IotNetworkError_t _testServerCreate( void * pConnectionInfo,
+                                           void * pCredentialInfo,
+                                           void ** pConnection )
+{
+    IotNetworkError_t status = IOT_NETWORK_FAILURE;
+    int index = 0;
+
+    ( void ) pConnectionInfo;
+    ( void ) pCredentialInfo;
+
+    IotMutex_Lock( &( _testServer.mutex ) );
+
+    for( index = 0; index < HTTPS_TEST_DOWNLOAD_MAX_SERVER_CONNECTIONS; index++ )
+    {
+        if( _testServer.connections[ index ].inUse == false )
+        {
+            memset( &( _testServer.connections[ index ] ), 0, sizeof( _testServerConnection_t ) );
+            _testServer.connections[ index ].inUse = true;
+            _testServer.connectionsCreated++;
+            *pConnection = &( _testServer.connections[ index ] );
+            status = IOT_NETWORK_SUCCESS;
+            break;
+        }
+    }
+
+    IotMutex_Unlock( &( _testServer.mutex ) );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Network Abstraction setReceiveCallback function of the test server.
+ */
+static IotNetworkError_t _testServerSetReceiveCallback( void * pConnection,
+                                                        IotNetworkReceiveCallback_t receiveCallback,
+                                                        void * pContext )
+{
+    _testServerConnection_t * pServerConnection = ( _testServerConnection_t * ) pConnection;
+
+    pServerConnection->receiveCallback = receiveCallback;
+    pServerConnection->pReceiveContext = pContext;
+
+    return IOT_NETWORK_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Network Abstraction send function of the test server.
+ *
+ * The response is delivered once the end of the request headers is received. The requests of the download do not
+ * have a body.
+ */
+static size_t _testServerSend( void * pConnection,
+                               const uint8_t * pMessage,
+                               size_t messageLength )
+{
+    _testServerConnection_t * pServerConnection = ( _testServerConnection_t * ) pConnection;
+    bool requestComplete = false;
+
+    if( pServerConnection->requestLen + messageLength >= sizeof( pServerConnection->pRequest ) )
+    {
+        return 0;
+    }
+
+    memcpy( pServerConnection->pRequest + pServerConnection->requestLen, pMessage, messageLength );
+    pServerConnection->requestLen += messageLength;
+    pServerConnection->pRequest[ pServerConnection->requestLen ] = '\0';
+
+    if( strstr( pServerConnection->pRequest, "\r\n\r\n" ) != NULL )
+    {
+        IotMutex_Lock( &( _testServer.mutex ) );
+        _testServerPrepareResponse( pServerConnection );
+        IotMutex_Unlock( &( _testServer.mutex ) );
+
+        pServerConnection->requestLen = 0;
+        requestComplete = true;
+    }
+
+    if( requestComplete )
+    {
+        TEST_ASSERT_TRUE( Iot_CreateDetachedThread( _testServerRespond,
+                                                    pServerConnection,
+                                                    IOT_THREAD_DEFAULT_PRIORITY,
+                                                    IOT_THREAD_DEFAULT_STACK_SIZE ) );
+    }
+
+    return messageLength;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Network Abstraction receive function of the test server.
+ *
+ * This returns zero, like a closed connection, once the response is sent.
+ */
+static size_t _testServerReceive( void * pConnection,
+                                  uint8_t * pBuffer,
+                                  size_t bytesRequested )
+{
+    _testServerConnection_t * pServerConnection = ( _testServerConnection_t * ) pConnection;
+    size_t copyLen = 0;
+    size_t bodySent = 0;
+
+    if( pServerConnection->responseSent < pServerConnection->headersLen )
+    {
+        copyLen = pServerConnection->headersLen - pServerConnection->responseSent;
+
+        if( copyLen > bytesRequested )
+        {
+            copyLen = bytesRequested;
+        }
+
+        memcpy( pBuffer, pServerConnection->pHeaders + pServerConnection->responseSent, copyLen );
+    }
+    else
+    {
+        bodySent = pServerConnection->responseSent - pServerConnection->headersLen;
+        copyLen = pServerConnection->bodyLen - bodySent;
+
+        if( copyLen > bytesRequested )
+        {
+            copyLen = bytesRequested;
+        }
+
+        memcpy( pBuffer, _pTestFile + pServerConnection->bodyOffset + bodySent, copyLen );
+    }
+
+    pServerConnection->responseSent += copyLen;
+
+    /* The request is answered once the HTTPS Client has received the whole response. */
+    if( ( copyLen > 0 ) &&
+        ( pServerConnection->responseSent == pServerConnection->headersLen + pServerConnection->bodyLen ) )
+    {
+        IotMutex_Lock( &( _testServer.mutex ) );
+        _testServer.requestsInFlight--;
+        IotMutex_Unlock( &( _testServer.mutex ) );
+    }
+
+    return copyLen;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Network Abstraction close function of the test server.
+ */
+static IotNetworkError_t _testServerClose( void * pConnection )
+{
+    ( void ) pConnection;
+    return IOT_NETWORK_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Network Abstraction destroy function of the test server.
+ */
+static IotNetworkError_t _testServerDestroy( void * pConnection )
+{
+    _testServerConnection_t * pServerConnection = ( _testServerConnection_t * ) pConnection;
+
+    IotMutex_Lock( &( _testServer.mutex ) );
+    pServerConnection->inUse = false;
+    IotMutex_Unlock( &( _testServer.mutex ) );
+
+    return IOT_NETWORK_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The sink of the downloads of the tests, which writes into _testSink.pData.
+ */
+static bool _testSinkWrite( void * pSinkContext,
+                            uint32_t offset,
+                            const uint8_t * pData,
+                            uint32_t dataLen )
+{
+    _testSink_t * pSink = ( _testSink_t * ) pSinkContext;
+    bool status = true;
+
+    if( pSink->running )
+    {
+        pSink->concurrentCall = true;
+    }
+
+    pSink->running = true;
+    pSink->callCount++;
+
+    if( ( pSink->failAtCall == pSink->callCount ) || ( offset + dataLen > sizeof( pSink->pData ) ) )
+    {
+        status = false;
+    }
+    else
+    {
+        memcpy( pSink->pData + offset, pData, dataLen );
+        pSink->bytesWritten += dataLen;
+    }
+
+    pSink->running = false;
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Download the test resource and return the time it took in milliseconds.
+ */
+static uint64_t _timedDownload( uint32_t numConnections,
+                                IotHttpsReturnCode_t * pStatus,
+                                uint32_t * pFileSize )
+{
+    uint64_t startTime = 0;
+
+    _downloadInfo.numConnections = numConnections;
+    _downloadInfo.userBuffer.bufferLen = numConnections * HTTPS_TEST_DOWNLOAD_CONNECTION_BUFFER_SIZE;
+
+    startTime = IotClock_GetTimeMs();
+    *pStatus = IotHttpsClient_Download( &_downloadInfo, pFileSize );
+
+    return IotClock_GetTimeMs() - startTime;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test group for HTTPS Client Download Unit tests.
+ */
+TEST_GROUP( HTTPS_Client_Unit_Download );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test setup for the HTTP Client Download unit tests.
+ */
+TEST_SETUP( HTTPS_Client_Unit_Download )
+{
+    uint32_t index = 0;
+
+    /* This will initialize the library before every test case, which is OK. */
+    TEST_ASSERT_EQUAL_INT( true, IotSdk_Init() );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, IotHttpsClient_Init() );
+
+    for( index = 0; index < HTTPS_TEST_DOWNLOAD_FILE_SIZE; index++ )
+    {
+        _pTestFile[ index ] = ( uint8_t ) ( ( index * 31 ) + ( index >> 8 ) );
+    }
+
+    /* Reset the test server and the network abstraction that connects to it. */
+    memset( &_testServer, 0, sizeof( _testServer_t ) );
+    TEST_ASSERT_TRUE( IotMutex_Create( &( _testServer.mutex ), false ) );
+    _testServer.fileSize = HTTPS_TEST_DOWNLOAD_FILE_SIZE;
+
+    ( void ) memset( &_networkInterface, 0x00, sizeof( IotNetworkInterface_t ) );
+    _networkInterface.create = _testServerCreate;
+    _networkInterface.setReceiveCallback = _testServerSetReceiveCallback;
+    _networkInterface.send = _testServerSend;
+    _networkInterface.receiveUpto = _testServerReceive;
+    _networkInterface.close = _testServerClose;
+    _networkInterface.destroy = _testServerDestroy;
+
+    memset( &_testSink, 0, sizeof( _testSink_t ) );
+
+    memset( &_downloadInfo, 0, sizeof( IotHttpsDownloadInfo_t ) );
+    _downloadInfo.pConnInfo = &_connInfo;
+    _downloadInfo.pPath = HTTPS_TEST_PATH;
+    _downloadInfo.pathLen = sizeof( HTTPS_TEST_PATH ) - 1;
+    _downloadInfo.fileSize = HTTPS_TEST_DOWNLOAD_FILE_SIZE;
+    _downloadInfo.rangeSize = HTTPS_TEST_DOWNLOAD_RANGE_SIZE;
+    _downloadInfo.numConnections = HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS;
+    _downloadInfo.maxRetries = 2;
+    _downloadInfo.sink = _testSinkWrite;
+    _downloadInfo.pSinkContext = &_testSink;
+    _downloadInfo.userBuffer.pBuffer = _pDownloadUserBuffer;
+    _downloadInfo.userBuffer.bufferLen = sizeof( _pDownloadUserBuffer );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test teardown for the HTTP Client Download unit tests.
+ */
+TEST_TEAR_DOWN( HTTPS_Client_Unit_Download )
+{
+    IotHttpsClient_Cleanup();
+    IotSdk_Cleanup();
+    IotMutex_Destroy( &( _testServer.mutex ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test group runner for HTTPS Client function @ref https_client_function_download
+ */
+TEST_GROUP_RUNNER( HTTPS_Client_Unit_Download )
+{
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadInvalidParameters );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadUserBufferTooSmall );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadSuccess );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadThroughputScalesWithConnections );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadUnknownFileSize );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadFileSmallerThanRange );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadServerIgnoresRange );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadRetryTruncatedResponses );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadRetryServerErrors );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadRetriesExhausted );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadNotFound );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Download, DownloadSinkFailure );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test IotHttpsClient_Download() with various invalid parameters.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadInvalidParameters )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    IotHttpsDownloadInfo_t downloadInfo = IOT_HTTPS_DOWNLOAD_INFO_INITIALIZER;
+
+    /* NULL pDownloadInfo. */
+    returnCode = IotHttpsClient_Download( NULL, NULL );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INVALID_PARAMETER, returnCode );
+
+    /* NULL pConnInfo. */
+    downloadInfo = _downloadInfo;
+    downloadInfo.pConnInfo = NULL;
+    returnCode = IotHttpsClient_Download( &downloadInfo, NULL );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INVALID_PARAMETER, returnCode );
+
+    /* NULL sink. */
+    downloadInfo = _downloadInfo;
+    downloadInfo.sink = NULL;
+    returnCode = IotHttpsClient_Download( &downloadInfo, NULL );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INVALID_PARAMETER, returnCode );
+
+    /* NULL userBuffer.pBuffer. */
+    downloadInfo = _downloadInfo;
+    downloadInfo.userBuffer.pBuffer = NULL;
+    returnCode = IotHttpsClient_Download( &downloadInfo, NULL );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INVALID_PARAMETER, returnCode );
+
+    /* Zero rangeSize. */
+    downloadInfo = _downloadInfo;
+    downloadInfo.rangeSize = 0;
+    returnCode = IotHttpsClient_Download( &downloadInfo, NULL );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INVALID_PARAMETER, returnCode );
+
+    /* Zero numConnections. */
+    downloadInfo = _downloadInfo;
+    downloadInfo.numConnections = 0;
+    returnCode = IotHttpsClient_Download( &downloadInfo, NULL );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INVALID_PARAMETER, returnCode );
+
+    /* Nothing was sent to the server. */
+    TEST_ASSERT_EQUAL( 0, _testServer.connectionsCreated );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test IotHttpsClient_Download() with a user buffer too small for the number of connections.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadUserBufferTooSmall )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+
+    /* The test share of each connection is large enough. */
+    TEST_ASSERT_GREATER_OR_EQUAL( downloadUserBufferMinimumSize + _downloadInfo.pathLen + _connInfo.addressLen,
+                                  HTTPS_TEST_DOWNLOAD_CONNECTION_BUFFER_SIZE );
+
+    _downloadInfo.userBuffer.bufferLen = _downloadInfo.numConnections * ( downloadUserBufferMinimumSize - 1 );
+    returnCode = IotHttpsClient_Download( &_downloadInfo, NULL );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INSUFFICIENT_MEMORY, returnCode );
+
+    /* The path and the host name also need space in each share. */
+    _downloadInfo.userBuffer.bufferLen = _downloadInfo.numConnections * downloadUserBufferMinimumSize;
+    returnCode = IotHttpsClient_Download( &_downloadInfo, NULL );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INSUFFICIENT_MEMORY, returnCode );
+
+    TEST_ASSERT_EQUAL( 0, _testServer.connectionsCreated );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test a successful download of a resource of known size on multiple connections.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadSuccess )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE, fileSize );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE, _testSink.bytesWritten );
+    TEST_ASSERT_EQUAL_MEMORY( _pTestFile, _testSink.pData, HTTPS_TEST_DOWNLOAD_FILE_SIZE );
+    TEST_ASSERT_FALSE( _testSink.concurrentCall );
+
+    /* Each range was requested once, and no connection was replaced. */
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE / HTTPS_TEST_DOWNLOAD_RANGE_SIZE, _testServer.requestsServed );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS, _testServer.connectionsCreated );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS, _testServer.maxRequestsInFlight );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that downloading on more connections hides the latency of the server.
+ *
+ * With a server latency much larger than the time to transfer a range, the download time is dominated by the number
+ * of round trips, which is divided by the number of connections.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadThroughputScalesWithConnections )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+    uint64_t singleConnectionTime = 0;
+    uint64_t multipleConnectionsTime = 0;
+
+    singleConnectionTime = _timedDownload( 1, &returnCode, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL_MEMORY( _pTestFile, _testSink.pData, HTTPS_TEST_DOWNLOAD_FILE_SIZE );
+    TEST_ASSERT_EQUAL( 1, _testServer.maxRequestsInFlight );
+
+    memset( &_testSink, 0, sizeof( _testSink_t ) );
+    _testServer.maxRequestsInFlight = 0;
+
+    multipleConnectionsTime = _timedDownload( HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS, &returnCode, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL_MEMORY( _pTestFile, _testSink.pData, HTTPS_TEST_DOWNLOAD_FILE_SIZE );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS, _testServer.maxRequestsInFlight );
+
+    /* The single connection makes one round trip per range. */
+    TEST_ASSERT_GREATER_OR_EQUAL( ( HTTPS_TEST_DOWNLOAD_FILE_SIZE / HTTPS_TEST_DOWNLOAD_RANGE_SIZE ) * HTTPS_TEST_DOWNLOAD_LATENCY_MS,
+                                  singleConnectionTime );
+
+    /* Allow for scheduling overhead, but the parallel download must be at least twice as fast. */
+    TEST_ASSERT_LESS_THAN( singleConnectionTime, multipleConnectionsTime * 2 );
+
+    IotLogInfo( "Downloaded %d bytes in %d ms on 1 connection and in %d ms on %d connections.",
+                HTTPS_TEST_DOWNLOAD_FILE_SIZE,
+                ( int ) singleConnectionTime,
+                ( int ) multipleConnectionsTime,
+                HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test a download that learns the size of the resource from the first response.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadUnknownFileSize )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    /* The resource does not end on a range boundary. */
+    _testServer.fileSize = HTTPS_TEST_DOWNLOAD_FILE_SIZE - 100;
+    _downloadInfo.fileSize = 0;
+
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE - 100, fileSize );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE - 100, _testSink.bytesWritten );
+    TEST_ASSERT_EQUAL_MEMORY( _pTestFile, _testSink.pData, HTTPS_TEST_DOWNLOAD_FILE_SIZE - 100 );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE / HTTPS_TEST_DOWNLOAD_RANGE_SIZE, _testServer.requestsServed );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_MAX_CONNECTIONS, _testServer.maxRequestsInFlight );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test a download of unknown size of a resource smaller than a range.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadFileSmallerThanRange )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    _testServer.fileSize = 100;
+    _downloadInfo.fileSize = 0;
+
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL( 100, fileSize );
+    TEST_ASSERT_EQUAL( 100, _testSink.bytesWritten );
+    TEST_ASSERT_EQUAL_MEMORY( _pTestFile, _testSink.pData, 100 );
+    TEST_ASSERT_EQUAL( 1, _testServer.requestsServed );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test a download from a server that answers Range requests with the whole resource.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadServerIgnoresRange )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    _testServer.ignoreRange = true;
+    _downloadInfo.fileSize = 0;
+
+    /* The whole resource is received on the first connection. */
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE, fileSize );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE, _testSink.bytesWritten );
+    TEST_ASSERT_EQUAL_MEMORY( _pTestFile, _testSink.pData, HTTPS_TEST_DOWNLOAD_FILE_SIZE );
+    TEST_ASSERT_EQUAL( 1, _testServer.requestsServed );
+
+    /* A later range answered with the whole resource cannot be used. */
+    memset( &_testSink, 0, sizeof( _testSink_t ) );
+    _downloadInfo.fileSize = HTTPS_TEST_DOWNLOAD_FILE_SIZE;
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_NOT_SUPPORTED, returnCode );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that ranges cut short by the server are resumed on new connections.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadRetryTruncatedResponses )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    _testServer.truncationsLeft = 3;
+
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE, _testSink.bytesWritten );
+    TEST_ASSERT_EQUAL_MEMORY( _pTestFile, _testSink.pData, HTTPS_TEST_DOWNLOAD_FILE_SIZE );
+
+    /* Each truncated range was resumed with one more request for the bytes not yet written. */
+    TEST_ASSERT_EQUAL( ( HTTPS_TEST_DOWNLOAD_FILE_SIZE / HTTPS_TEST_DOWNLOAD_RANGE_SIZE ) + 3, _testServer.requestsServed );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that ranges answered with a server error are requested again.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadRetryServerErrors )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    _testServer.failureStatus = IOT_HTTPS_STATUS_SERVICE_UNAVAILABLE;
+    _testServer.failuresLeft = 2;
+
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    TEST_ASSERT_EQUAL( HTTPS_TEST_DOWNLOAD_FILE_SIZE, _testSink.bytesWritten );
+    TEST_ASSERT_EQUAL_MEMORY( _pTestFile, _testSink.pData, HTTPS_TEST_DOWNLOAD_FILE_SIZE );
+    TEST_ASSERT_EQUAL( ( HTTPS_TEST_DOWNLOAD_FILE_SIZE / HTTPS_TEST_DOWNLOAD_RANGE_SIZE ) + 2, _testServer.requestsServed );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a download fails when a range fails more than the maximum number of retries.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadRetriesExhausted )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    _testServer.failureStatus = IOT_HTTPS_STATUS_SERVICE_UNAVAILABLE;
+    _testServer.failuresLeft = UINT32_MAX;
+    _downloadInfo.numConnections = 1;
+
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_TRY_AGAIN, returnCode );
+    TEST_ASSERT_EQUAL( 0, _testSink.bytesWritten );
+    TEST_ASSERT_EQUAL( _downloadInfo.maxRetries + 1, _testServer.requestsServed );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a download of a resource that does not exist fails without retries.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadNotFound )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    _testServer.failureStatus = IOT_HTTPS_STATUS_NOT_FOUND;
+    _testServer.failuresLeft = UINT32_MAX;
+    _downloadInfo.fileSize = 0;
+
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_NOT_SUPPORTED, returnCode );
+    TEST_ASSERT_EQUAL( 0, fileSize );
+    TEST_ASSERT_EQUAL( 1, _testServer.requestsServed );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a failure of the sink aborts the download without retries.
+ */
+TEST( HTTPS_Client_Unit_Download, DownloadSinkFailure )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    uint32_t fileSize = 0;
+
+    _testSink.failAtCall = 5;
+
+    returnCode = IotHttpsClient_Download( &_downloadInfo, &fileSize );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_USER_CALLBACK_ERROR, returnCode );
+    TEST_ASSERT_LESS_THAN( HTTPS_TEST_DOWNLOAD_FILE_SIZE, _testSink.bytesWritten );
+
+    /* The download stopped requesting ranges after the failure. */
+    TEST_ASSERT_LESS_THAN( HTTPS_TEST_DOWNLOAD_FILE_SIZE / HTTPS_TEST_DOWNLOAD_RANGE_SIZE, _testServer.requestsServed );
+}
@@ -103,6 +103,13 @@ static bool _alreadyCreatedReceiveCallbackThread = false;
  */
 static IotHttpsRequestHandle_t _currentlySendingRequestHandle = IOT_HTTPS_REQUEST_HANDLE_INITIALIZER;
 
+/**
+ * @brief The number of connections that the library set the network receive callback for.
+ *
+ * HTTP tests run sequentially, so there is no race condition here.
+ */
+static uint32_t _setReceiveCallbackCount = 0;
+
 /**
  * #IotHttpsSyncInfo_t for requests and response to share among the tests.
  *
@@ -296,6 +303,25 @@ static size_t _networkSendSuccess( void * pConnection,
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Network Abstraction setReceiveCallback that saves the connection handle of connections created by the
+ * library for requests sent without one.
+ */
+static IotNetworkError_t _setReceiveCallbackSaveConnHandle( void * pConnection,
+                                                            IotNetworkReceiveCallback_t receiveCallback,
+                                                            void * pContext )
+{
+    ( void ) pConnection;
+    ( void ) receiveCallback;
+
+    _receiveCallbackConnHandle = ( IotHttpsConnectionHandle_t ) pContext;
+    _setReceiveCallbackCount++;
+
+    return IOT_NETWORK_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Network abstraction receive function that fails when sending the HTTP headers.
  */
@@ -477,6 +503,7 @@ TEST_GROUP_RUNNER( HTTPS_Client_Unit_Sync )
     RUN_TEST_CASE( HTTPS_Client_Unit_Sync, SendSyncHeadersEndsWithSpaceSeparator );
     RUN_TEST_CASE( HTTPS_Client_Unit_Sync, SendSyncHeadersEndsWithSpaceAfterHeaderValue );
     RUN_TEST_CASE( HTTPS_Client_Unit_Sync, SendSyncChunkedResponse );
+    RUN_TEST_CASE( HTTPS_Client_Unit_Sync, SendSyncPooledConnection );
 }
 
 /*-----------------------------------------------------------*/
@@ -1081,6 +1108,71 @@ TEST( HTTPS_Client_Unit_Sync, SendSyncNonPersistentRequest )
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Test sending requests without a connection handle, on a connection from the connection pool.
+ */
+TEST( HTTPS_Client_Unit_Sync, SendSyncPooledConnection )
+{
+    IotHttpsReturnCode_t returnCode = IOT_HTTPS_OK;
+    IotHttpsConnectionInfo_t connInfo = _connInfo;
+    IotHttpsRequestInfo_t reqInfo = IOT_HTTPS_REQUEST_INFO_INITIALIZER;
+    IotHttpsConnectionHandle_t connHandle = IOT_HTTPS_CONNECTION_HANDLE_INITIALIZER;
+    IotHttpsRequestHandle_t reqHandle = IOT_HTTPS_REQUEST_HANDLE_INITIALIZER;
+    IotHttpsResponseHandle_t respHandle = IOT_HTTPS_RESPONSE_HANDLE_INITIALIZER;
+    uint32_t timeout = HTTPS_TEST_SYNC_TIMEOUT_MS;
+    int headerLength = HTTPS_TEST_RESP_HEADER_BUFFER_LENGTH;
+    int bodyLength = HTTPS_TEST_RESP_BODY_BUFFER_SIZE;
+
+    _networkInterface.create = _networkCreateSuccess;
+    _networkInterface.setReceiveCallback = _setReceiveCallbackSaveConnHandle;
+    _networkInterface.send = _networkSendSuccess;
+    _networkInterface.receiveUpto = _networkReceiveSuccess;
+    _networkInterface.close = _networkCloseSuccess;
+    _networkInterface.destroy = _networkDestroySuccess;
+    _setReceiveCallbackCount = 0;
+
+    /* The request carries the connection information instead of being sent on a connection handle. */
+    connInfo.flags |= IOT_HTTPS_POOLED_CONNECTION_FLAG;
+    memcpy( &reqInfo, &_reqInfo, sizeof( IotHttpsRequestInfo_t ) );
+    reqInfo.pConnInfo = &connInfo;
+
+    reqHandle = _getReqHandle( &reqInfo );
+    TEST_ASSERT_NOT_NULL( reqHandle );
+    _generateHttpResponseMessage( headerLength, bodyLength );
+
+    returnCode = IotHttpsClient_SendSync( NULL, reqHandle, &respHandle, &_respInfo, timeout );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    _verifyHttpResponseBody( bodyLength, _respInfo.pSyncInfo->pBody, 0 );
+
+    /* The connection went back to the pool when the response was received. */
+    connHandle = _receiveCallbackConnHandle;
+    TEST_ASSERT_NOT_NULL( connHandle );
+    TEST_ASSERT_NOT_NULL( connHandle->pPoolEntry );
+    TEST_ASSERT_EQUAL( POOL_ENTRY_IDLE, connHandle->pPoolEntry->state );
+    TEST_ASSERT_TRUE( connHandle->isConnected );
+
+    /* The next request to the same server is sent on the idle connection. */
+    _alreadyCreatedReceiveCallbackThread = false;
+    _nextRespMessageBufferByteToReceive = 0;
+    ( void ) memset( _pRespBodyBuffer, 0x00, sizeof( _pRespBodyBuffer ) );
+    reqHandle = _getReqHandle( &reqInfo );
+    TEST_ASSERT_NOT_NULL( reqHandle );
+
+    returnCode = IotHttpsClient_SendSync( NULL, reqHandle, &respHandle, &_respInfo, timeout );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_OK, returnCode );
+    _verifyHttpResponseBody( bodyLength, _respInfo.pSyncInfo->pBody, 0 );
+    TEST_ASSERT_EQUAL( 1, _setReceiveCallbackCount );
+    TEST_ASSERT_EQUAL( POOL_ENTRY_IDLE, connHandle->pPoolEntry->state );
+
+    /* A request without a connection handle or connection information is invalid. */
+    reqHandle = _getReqHandle( &_reqInfo );
+    TEST_ASSERT_NOT_NULL( reqHandle );
+    returnCode = IotHttpsClient_SendSync( NULL, reqHandle, &respHandle, &_respInfo, timeout );
+    TEST_ASSERT_EQUAL( IOT_HTTPS_INVALID_PARAMETER, returnCode );
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Test that we have the correct header data when it ends on the carriage return of the end of the header lines
  * separator.
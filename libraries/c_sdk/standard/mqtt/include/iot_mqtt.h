@@ -635,6 +635,15 @@ IotMqttError_t IotMqtt_TimedUnsubscribe( IotMqttConnection_t mqttConnection,
  * of QoS), it will return one of:
  * - #IOT_MQTT_BAD_PARAMETER
  * - #IOT_MQTT_NO_MEMORY
+ * - #IOT_MQTT_QUEUE_FULL (QoS 1 only)
+ *
+ * @note QoS 1 publishes are limited by an in-flight window of
+ * [maxInFlightPublishes](@ref IotMqttNetworkInfo_t.maxInFlightPublishes)
+ * messages. Publishes beyond this window are queued and sent as PUBACKs
+ * arrive; once @ref IOT_MQTT_MAX_QUEUED_PUBLISHES messages are queued, this
+ * function returns #IOT_MQTT_QUEUE_FULL until the connection's
+ * [publish ready callback](@ref IotMqttNetworkInfo_t.publishReadyCallback)
+ * is invoked.
  *
  * @note The parameters `pCallbackInfo` and `pPublishOperation` should only be used for QoS
  * 1 publishes. For QoS 0, they should both be `NULL`.
@@ -720,6 +729,7 @@ IotMqttError_t IotMqtt_Publish( IotMqttConnection_t mqttConnection,
  * - #IOT_MQTT_BAD_RESPONSE
  * - #IOT_MQTT_RETRY_NO_RESPONSE (if [pPublishInfo->retryMs](@ref IotMqttPublishInfo_t.retryMs)
  * and [pPublishInfo->retryLimit](@ref IotMqttPublishInfo_t.retryLimit) were set).
+ * - #IOT_MQTT_QUEUE_FULL
  */
 /* @[declare_mqtt_timedpublish] */
 IotMqttError_t IotMqtt_TimedPublish( IotMqttConnection_t mqttConnection,
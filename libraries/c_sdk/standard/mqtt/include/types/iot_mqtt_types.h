@@ -255,7 +255,21 @@ typedef enum IotMqttError
      * May also be the value of an operation completion callback's
      * #IotMqttCallbackParam_t.result for a QoS 1 PUBLISH.
      */
-    IOT_MQTT_RETRY_NO_RESPONSE
+    IOT_MQTT_RETRY_NO_RESPONSE,
+
+    /**
+     * @brief A QoS 1 PUBLISH was not queued because the in-flight window and
+     * the send queue of its MQTT connection are full.
+     *
+     * The PUBLISH may be sent again once the connection's
+     * [publish ready callback](@ref IotMqttNetworkInfo_t.publishReadyCallback)
+     * is invoked.
+     *
+     * Functions that may return this value:
+     * - @ref mqtt_function_publish
+     * - @ref mqtt_function_timedpublish
+     */
+    IOT_MQTT_QUEUE_FULL
 } IotMqttError_t;
 
 /**
@@ -416,6 +430,8 @@ typedef struct IotMqttPublishInfo
  * member is valid. Otherwise, if the callback was triggered because of a
  * server-to-client PUBLISH, the `message` member is valid. Finally, if the callback
  * was triggered because of a disconnect, the `disconnectReason` member is valid.
+ * A [publish ready callback](@ref IotMqttNetworkInfo_t.publishReadyCallback)
+ * also uses the `operation` member, but with no operation reference.
  *
  * For an incoming PUBLISH, the `message.pTopicFilter` parameter provides the
  * subscription topic filter that matched the topic name in the PUBLISH. Because
@@ -985,6 +1001,30 @@ typedef struct IotMqttNetworkInfo
      */
     IotMqttCallbackInfo_t disconnectCallback;
 
+    /**
+     * @brief The maximum number of QoS 1 PUBLISH messages that may be in flight
+     * on this MQTT connection.
+     *
+     * A QoS 1 PUBLISH is in flight from the time it is sent until its PUBACK
+     * is received or it fails. Additional QoS 1 PUBLISH messages are queued
+     * and sent in order as in-flight messages complete; at most
+     * @ref IOT_MQTT_MAX_QUEUED_PUBLISHES messages are queued. Set this to `0`
+     * to use @ref IOT_MQTT_MAX_IN_FLIGHT_PUBLISHES.
+     */
+    uint16_t maxInFlightPublishes;
+
+    /**
+     * @brief A callback function to invoke when a QoS 1 PUBLISH may be queued
+     * again after @ref mqtt_function_publish returned #IOT_MQTT_QUEUE_FULL.
+     *
+     * This callback is invoked once for every time the send queue fills up.
+     * The `operation` member of its #IotMqttCallbackParam_t is valid, with type
+     * #IOT_MQTT_PUBLISH_TO_SERVER, a `NULL` reference, and result
+     * #IOT_MQTT_SUCCESS. Unlike a disconnect callback, @ref mqtt_function_publish
+     * may be called from this callback.
+     */
+    IotMqttCallbackInfo_t publishReadyCallback;
+
     #if IOT_MQTT_ENABLE_SERIALIZER_OVERRIDES == 1
 
         /**
@@ -336,11 +336,22 @@ static _mqttConnection_t * _createMqttConnection( bool awsIotMqttMode,
     else
     {
         /* Clear the MQTT connection, then copy the MQTT server mode, network
-         * interface, and disconnect callback. */
+         * interface, disconnect callback, and PUBLISH flow control settings. */
         ( void ) memset( pMqttConnection, 0x00, sizeof( _mqttConnection_t ) );
         pMqttConnection->awsIotMqttMode = awsIotMqttMode;
         pMqttConnection->pNetworkInterface = pNetworkInfo->pNetworkInterface;
         pMqttConnection->disconnectCallback = pNetworkInfo->disconnectCallback;
+        pMqttConnection->publishReadyCallback = pNetworkInfo->publishReadyCallback;
+        pMqttConnection->maxInFlightPublishes = pNetworkInfo->maxInFlightPublishes;
+
+        if( pMqttConnection->maxInFlightPublishes == 0 )
+        {
+            pMqttConnection->maxInFlightPublishes = IOT_MQTT_MAX_IN_FLIGHT_PUBLISHES;
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
 
         /* Start a new MQTT connection with a reference count of 1. */
         pMqttConnection->references = 1;
@@ -378,6 +389,7 @@ static _mqttConnection_t * _createMqttConnection( bool awsIotMqttMode,
     IotListDouble_Create( &( pMqttConnection->subscriptionList ) );
     IotListDouble_Create( &( pMqttConnection->pendingProcessing ) );
     IotListDouble_Create( &( pMqttConnection->pendingResponse ) );
+    IotListDouble_Create( &( pMqttConnection->publishQueue ) );
 
     /* AWS IoT service limits set minimum and maximum values for keep-alive interval.
      * Adjust the user-provided keep-alive interval based on these requirements. */
@@ -1154,6 +1166,12 @@ IotMqttError_t IotMqtt_Connect( const IotMqttNetworkInfo_t * pNetworkInfo,
         {
             IotLogDebug( "Scheduling first MQTT keep-alive job." );
 
+            /* Keep-alive must not wait behind bulk jobs, or the server may close
+             * the connection. Scheduling fails for the same reasons this may fail. */
+            ( void ) IotTaskPool_SetJobPriority( IOT_SYSTEM_TASKPOOL,
+                                                 pNewMqttConnection->keepAliveJob,
+                                                 IOT_TASKPOOL_JOB_PRIORITY_CRITICAL );
+
             taskPoolStatus = IotTaskPool_ScheduleDeferred( IOT_SYSTEM_TASKPOOL,
                                                            pNewMqttConnection->keepAliveJob,
                                                            pNewMqttConnection->nextKeepAliveMs );
@@ -1237,7 +1255,7 @@ IotMqttError_t IotMqtt_Connect( const IotMqttNetworkInfo_t * pNetworkInfo,
 void IotMqtt_Disconnect( IotMqttConnection_t mqttConnection,
                          uint32_t flags )
 {
-    bool disconnected = false;
+    bool disconnected = false, retryJobCanceled = false;
     IotMqttError_t status = IOT_MQTT_STATUS_PENDING;
     _mqttOperation_t * pOperation = NULL;
 
@@ -1367,6 +1385,27 @@ void IotMqtt_Disconnect( IotMqttConnection_t mqttConnection,
     /* At this point, the connection should be marked disconnected. */
     IotMqtt_Assert( mqttConnection->disconnected == true );
 
+    /* Cancel the retry job. If the retry job is executing, it releases its own
+     * connection reference. */
+    if( mqttConnection->retryJobScheduled == true )
+    {
+        if( IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL,
+                                   mqttConnection->retryJob,
+                                   NULL ) == IOT_TASKPOOL_SUCCESS )
+        {
+            mqttConnection->retryJobScheduled = false;
+            retryJobCanceled = true;
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
     /* Attempt cancel and destroy each operation in the connection's lists. */
     IotListDouble_RemoveAll( &( mqttConnection->pendingProcessing ),
                              _mqttOperation_tryDestroy,
@@ -1376,8 +1415,22 @@ void IotMqtt_Disconnect( IotMqttConnection_t mqttConnection,
                              _mqttOperation_tryDestroy,
                              offsetof( _mqttOperation_t, link ) );
 
+    IotListDouble_RemoveAll( &( mqttConnection->publishQueue ),
+                             _mqttOperation_tryDestroy,
+                             offsetof( _mqttOperation_t, link ) );
+
     IotMutex_Unlock( &( mqttConnection->referencesMutex ) );
 
+    /* Release the reference held by a canceled retry job. */
+    if( retryJobCanceled == true )
+    {
+        _IotMqtt_DecrementConnectionReferences( mqttConnection );
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
     /* Decrement the connection reference count and destroy it if possible. */
     _IotMqtt_DecrementConnectionReferences( mqttConnection );
 }
@@ -1681,15 +1734,24 @@ IotMqttError_t IotMqtt_Publish( IotMqttConnection_t mqttConnection,
         EMPTY_ELSE_MARKER;
     }
 
-    /* Add the PUBLISH operation to the send queue for network transmission. */
-    status = _IotMqtt_ScheduleOperation( pOperation,
-                                         _IotMqtt_ProcessSend,
-                                         0 );
+    /* Add the PUBLISH operation to the send queue for network transmission.
+     * QoS 1 PUBLISH messages are subject to the connection's in-flight window. */
+    if( pPublishInfo->qos == IOT_MQTT_QOS_0 )
+    {
+        status = _IotMqtt_ScheduleOperation( pOperation,
+                                             _IotMqtt_ProcessSend,
+                                             0 );
+    }
+    else
+    {
+        status = _IotMqtt_SchedulePublish( pOperation );
+    }
 
     if( status != IOT_MQTT_SUCCESS )
     {
-        IotLogError( "(MQTT connection %p) Failed to enqueue PUBLISH for sending.",
-                     mqttConnection );
+        IotLogError( "(MQTT connection %p) Failed to enqueue PUBLISH for sending, error %s.",
+                     mqttConnection,
+                     IotMqtt_strerror( status ) );
 
         /* Clear the previously set (and now invalid) reference. */
         if( pPublishInfo->qos != IOT_MQTT_QOS_0 )
@@ -1958,6 +2020,10 @@ const char * IotMqtt_strerror( IotMqttError_t status )
             pMessage = "NO RESPONSE";
             break;
 
+        case IOT_MQTT_QUEUE_FULL:
+            pMessage = "QUEUE FULL";
+            break;
+
         default:
             pMessage = "INVALID STATUS";
             break;
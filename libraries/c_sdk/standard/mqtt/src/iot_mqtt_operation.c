@@ -85,12 +85,75 @@ static bool _checkRetryLimit( _mqttOperation_t * pOperation );
 /**
  * @brief Schedule the next send of an operation with retry.
  *
+ * The operation is held by the retry job of its MQTT connection until its
+ * retry period elapses.
+ *
  * @param[in] pOperation The operation to schedule.
  *
  * @return `true` if the reschedule succeeded; `false` otherwise.
  */
 static bool _scheduleNextRetry( _mqttOperation_t * pOperation );
 
+/**
+ * @brief Ensure that the retry job of an MQTT connection runs no later than a
+ * given time.
+ *
+ * The references mutex of the MQTT connection must be locked by the caller.
+ *
+ * @param[in] pMqttConnection The MQTT connection that owns the retry job.
+ * @param[in] retryTime When the retry job must run.
+ *
+ * @return `true` if the retry job is scheduled; `false` otherwise.
+ */
+static bool _scheduleRetryJob( _mqttConnection_t * pMqttConnection,
+                               uint64_t retryTime );
+
+/**
+ * @brief Task pool routine that schedules a send of every PUBLISH of an MQTT
+ * connection whose retry period has elapsed.
+ *
+ * @param[in] pTaskPool Pointer to the system task pool.
+ * @param[in] pRetryJob Pointer to the retry job of the MQTT connection.
+ * @param[in] pContext Pointer to the MQTT connection.
+ */
+static void _processRetry( IotTaskPool_t pTaskPool,
+                           IotTaskPoolJob_t pRetryJob,
+                           void * pContext );
+
+/**
+ * @brief Release a PUBLISH that is held by its MQTT connection.
+ *
+ * PUBLISH operations waiting in the publish queue or for their next retry
+ * have no job in the task pool. Releasing such a PUBLISH is equivalent to
+ * canceling its job. The references mutex of the MQTT connection must be
+ * locked by the caller.
+ *
+ * @param[in] pOperation The operation to release.
+ *
+ * @return `true` if the operation was held by its MQTT connection; `false` otherwise.
+ */
+static bool _releaseHeldOperation( _mqttOperation_t * pOperation );
+
+/**
+ * @brief Add a QoS 1 PUBLISH to the in-flight window of its MQTT connection
+ * and schedule it for sending.
+ *
+ * The references mutex of the MQTT connection must be locked by the caller.
+ *
+ * @param[in] pOperation The PUBLISH to send.
+ *
+ * @return #IOT_MQTT_SUCCESS or #IOT_MQTT_SCHEDULING_ERROR.
+ */
+static IotMqttError_t _scheduleInFlightPublish( _mqttOperation_t * pOperation );
+
+/**
+ * @brief Remove a QoS 1 PUBLISH from the in-flight window of its MQTT
+ * connection, then send queued PUBLISH operations that fit in the window.
+ *
+ * @param[in] pOperation The PUBLISH leaving the in-flight window.
+ */
+static void _completeInFlightPublish( _mqttOperation_t * pOperation );
+
 /*-----------------------------------------------------------*/
 
 static bool _mqttOperation_match( const IotLink_t * pOperationLink,
@@ -206,9 +269,8 @@ static bool _checkRetryLimit( _mqttOperation_t * pOperation )
 
 static bool _scheduleNextRetry( _mqttOperation_t * pOperation )
 {
-    bool firstRetry = false;
+    bool status = false;
     uint32_t scheduleDelay = 0;
-    IotMqttError_t status = IOT_MQTT_STATUS_PENDING;
     _mqttConnection_t * pMqttConnection = pOperation->pMqttConnection;
 
     /* This function should never be called with retry count greater than
@@ -252,65 +314,438 @@ static bool _scheduleNextRetry( _mqttOperation_t * pOperation )
                      ( unsigned long ) pOperation->u.operation.retry.count,
                      ( unsigned long ) pOperation->u.operation.retry.limit,
                      ( unsigned long ) scheduleDelay );
+    }
 
-        /* Check if this is the first retry. */
-        firstRetry = ( pOperation->u.operation.retry.count == 1 );
+    IotMutex_Lock( &( pMqttConnection->referencesMutex ) );
+
+    /* Hand the PUBLISH to the connection's retry job. A single retry job serves
+     * every PUBLISH in the in-flight window, so it is only rescheduled if this
+     * PUBLISH is due before the retry job runs. */
+    pOperation->u.operation.retry.nextRetryMs = IotClock_GetTimeMs() + scheduleDelay;
+    status = _scheduleRetryJob( pMqttConnection,
+                                pOperation->u.operation.retry.nextRetryMs );
 
-        /* On the first retry, the PUBLISH will be moved from the pending processing
-         * list to the pending responses list. Lock the connection references mutex
-         * to manipulate the lists. */
-        if( firstRetry == true )
+    if( status == true )
+    {
+        /* Move the PUBLISH from the pending processing list to the pending
+         * responses list on the first retry. */
+        if( pOperation->u.operation.retry.count == 1 )
         {
-            IotMutex_Lock( &( pMqttConnection->referencesMutex ) );
+            /* Operation must be linked. */
+            IotMqtt_Assert( IotLink_IsLinked( &( pOperation->link ) ) == true );
+
+            /* Transfer to pending response list. */
+            IotListDouble_Remove( &( pOperation->link ) );
+            IotListDouble_InsertHead( &( pMqttConnection->pendingResponse ),
+                                      &( pOperation->link ) );
         }
         else
         {
             EMPTY_ELSE_MARKER;
         }
     }
+    else
+    {
+        pOperation->u.operation.retry.nextRetryMs = 0;
+    }
 
-    /* Reschedule the PUBLISH for another send. */
-    status = _IotMqtt_ScheduleOperation( pOperation,
-                                         _IotMqtt_ProcessSend,
-                                         scheduleDelay );
+    IotMutex_Unlock( &( pMqttConnection->referencesMutex ) );
+
+    return status;
+}
 
-    /* Check for successful reschedule. */
-    if( status == IOT_MQTT_SUCCESS )
+/*-----------------------------------------------------------*/
+
+static bool _scheduleRetryJob( _mqttConnection_t * pMqttConnection,
+                               uint64_t retryTime )
+{
+    bool status = true, reuseReference = false;
+    uint32_t scheduleDelay = 0;
+    uint64_t currentTime = IotClock_GetTimeMs();
+    IotTaskPoolError_t taskPoolStatus = IOT_TASKPOOL_SUCCESS;
+
+    /* Bring a scheduled retry job forward if it would run too late. */
+    if( pMqttConnection->retryJobScheduled == true )
     {
-        /* Move a successfully rescheduled PUBLISH from the pending processing
-         * list to the pending responses list on the first retry. */
-        if( firstRetry == true )
+        if( retryTime < pMqttConnection->nextRetryMs )
         {
-            /* Operation must be linked. */
-            IotMqtt_Assert( IotLink_IsLinked( &( pOperation->link ) ) == true );
+            taskPoolStatus = IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL,
+                                                    pMqttConnection->retryJob,
+                                                    NULL );
 
-            /* Transfer to pending response list. */
+            /* If the retry job could not be canceled, it is already executing
+             * and waiting for the references mutex. It will check every PUBLISH
+             * of this connection, so it does not need to be rescheduled. */
+            if( taskPoolStatus == IOT_TASKPOOL_SUCCESS )
+            {
+                /* The reference held by the canceled retry job is kept for
+                 * the rescheduled retry job. */
+                pMqttConnection->retryJobScheduled = false;
+                reuseReference = true;
+            }
+            else
+            {
+                EMPTY_ELSE_MARKER;
+            }
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    if( pMqttConnection->retryJobScheduled == false )
+    {
+        if( pMqttConnection->disconnected == true )
+        {
+            IotLogWarn( "(MQTT connection %p) Retry job not scheduled for a closed connection.",
+                        pMqttConnection );
+
+            status = false;
+        }
+        else
+        {
+            if( retryTime > currentTime )
+            {
+                scheduleDelay = ( uint32_t ) ( retryTime - currentTime );
+            }
+            else
+            {
+                EMPTY_ELSE_MARKER;
+            }
+
+            /* Creating a new job should never fail when parameters are valid. */
+            taskPoolStatus = IotTaskPool_CreateJob( _processRetry,
+                                                    pMqttConnection,
+                                                    &( pMqttConnection->retryJobStorage ),
+                                                    &( pMqttConnection->retryJob ) );
+            IotMqtt_Assert( taskPoolStatus == IOT_TASKPOOL_SUCCESS );
+
+            taskPoolStatus = IotTaskPool_ScheduleDeferred( IOT_SYSTEM_TASKPOOL,
+                                                           pMqttConnection->retryJob,
+                                                           scheduleDelay );
+
+            if( taskPoolStatus == IOT_TASKPOOL_SUCCESS )
+            {
+                pMqttConnection->retryJobScheduled = true;
+                pMqttConnection->nextRetryMs = retryTime;
+
+                /* A scheduled retry job holds a reference to its connection. */
+                if( reuseReference == false )
+                {
+                    ( pMqttConnection->references )++;
+                }
+                else
+                {
+                    EMPTY_ELSE_MARKER;
+                }
+            }
+            else
+            {
+                IotLogWarn( "(MQTT connection %p) Failed to schedule retry job, error %s.",
+                            pMqttConnection,
+                            IotTaskPool_strerror( taskPoolStatus ) );
+
+                status = false;
+            }
+        }
+
+        /* Release the reference of a canceled retry job that was not
+         * rescheduled. The PUBLISH operations of this connection also hold
+         * references, so this never destroys the connection. */
+        if( ( status == false ) && ( reuseReference == true ) )
+        {
+            ( pMqttConnection->references )--;
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _processRetry( IotTaskPool_t pTaskPool,
+                           IotTaskPoolJob_t pRetryJob,
+                           void * pContext )
+{
+    uint64_t currentTime = 0, nextRetryTime = UINT64_MAX;
+    IotLink_t * pLink = NULL, * pNextLink = NULL;
+    _mqttOperation_t * pOperation = NULL;
+    IotListDouble_t failedOperations = IOT_LIST_DOUBLE_INITIALIZER;
+    _mqttConnection_t * pMqttConnection = ( _mqttConnection_t * ) pContext;
+
+    /* Check parameters. The task pool and job parameter is not used when asserts
+     * are disabled. */
+    ( void ) pTaskPool;
+    ( void ) pRetryJob;
+    IotMqtt_Assert( pTaskPool == IOT_SYSTEM_TASKPOOL );
+    IotMqtt_Assert( pRetryJob == pMqttConnection->retryJob );
+
+    IotListDouble_Create( &failedOperations );
+
+    IotMutex_Lock( &( pMqttConnection->referencesMutex ) );
+
+    /* This retry job's connection reference is released when it finishes. */
+    pMqttConnection->retryJobScheduled = false;
+    currentTime = IotClock_GetTimeMs();
+
+    /* Schedule a send of every PUBLISH whose retry period has elapsed, and find
+     * the earliest retry among the others. */
+    pLink = pMqttConnection->pendingResponse.pNext;
+
+    while( pLink != &( pMqttConnection->pendingResponse ) )
+    {
+        pNextLink = pLink->pNext;
+        pOperation = IotLink_Container( _mqttOperation_t, pLink, link );
+
+        if( pOperation->u.operation.retry.nextRetryMs != 0 )
+        {
+            if( pOperation->u.operation.retry.nextRetryMs <= currentTime )
+            {
+                pOperation->u.operation.retry.nextRetryMs = 0;
+
+                if( _IotMqtt_ScheduleOperation( pOperation,
+                                                _IotMqtt_ProcessSend,
+                                                0 ) != IOT_MQTT_SUCCESS )
+                {
+                    pOperation->u.operation.status = IOT_MQTT_SCHEDULING_ERROR;
+
+                    IotListDouble_Remove( pLink );
+                    IotListDouble_InsertTail( &failedOperations, pLink );
+                }
+                else
+                {
+                    EMPTY_ELSE_MARKER;
+                }
+            }
+            else if( pOperation->u.operation.retry.nextRetryMs < nextRetryTime )
+            {
+                nextRetryTime = pOperation->u.operation.retry.nextRetryMs;
+            }
+            else
+            {
+                EMPTY_ELSE_MARKER;
+            }
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+
+        pLink = pNextLink;
+    }
+
+    /* Reschedule this retry job for the earliest remaining retry. If that fails,
+     * the remaining PUBLISH operations cannot be retried. */
+    if( nextRetryTime != UINT64_MAX )
+    {
+        if( _scheduleRetryJob( pMqttConnection, nextRetryTime ) == false )
+        {
+            pLink = pMqttConnection->pendingResponse.pNext;
+
+            while( pLink != &( pMqttConnection->pendingResponse ) )
+            {
+                pNextLink = pLink->pNext;
+                pOperation = IotLink_Container( _mqttOperation_t, pLink, link );
+
+                if( pOperation->u.operation.retry.nextRetryMs != 0 )
+                {
+                    pOperation->u.operation.retry.nextRetryMs = 0;
+                    pOperation->u.operation.status = IOT_MQTT_SCHEDULING_ERROR;
+
+                    IotListDouble_Remove( pLink );
+                    IotListDouble_InsertTail( &failedOperations, pLink );
+                }
+                else
+                {
+                    EMPTY_ELSE_MARKER;
+                }
+
+                pLink = pNextLink;
+            }
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    IotMutex_Unlock( &( pMqttConnection->referencesMutex ) );
+
+    /* Notify of PUBLISH operations that could not be retried. */
+    while( IotListDouble_IsEmpty( &failedOperations ) == false )
+    {
+        pLink = IotListDouble_RemoveHead( &failedOperations );
+        _IotMqtt_Notify( IotLink_Container( _mqttOperation_t, pLink, link ) );
+    }
+
+    /* Release this retry job's connection reference. */
+    _IotMqtt_DecrementConnectionReferences( pMqttConnection );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _releaseHeldOperation( _mqttOperation_t * pOperation )
+{
+    bool released = true;
+    _mqttConnection_t * pMqttConnection = pOperation->pMqttConnection;
+
+    if( pOperation->u.operation.queued == true )
+    {
+        pOperation->u.operation.queued = false;
+        ( pMqttConnection->queuedPublishes )--;
+
+        /* A disconnect may have already removed this PUBLISH from the publish queue. */
+        if( IotLink_IsLinked( &( pOperation->link ) ) == true )
+        {
             IotListDouble_Remove( &( pOperation->link ) );
-            IotListDouble_InsertHead( &( pMqttConnection->pendingResponse ),
-                                      &( pOperation->link ) );
         }
         else
         {
             EMPTY_ELSE_MARKER;
         }
     }
+    else if( pOperation->u.operation.retry.nextRetryMs != 0 )
+    {
+        pOperation->u.operation.retry.nextRetryMs = 0;
+    }
+    else
+    {
+        released = false;
+    }
+
+    return released;
+}
+
+/*-----------------------------------------------------------*/
+
+static IotMqttError_t _scheduleInFlightPublish( _mqttOperation_t * pOperation )
+{
+    IotMqttError_t status = IOT_MQTT_SUCCESS;
+    _mqttConnection_t * pMqttConnection = pOperation->pMqttConnection;
+
+    /* Occupy a slot in the in-flight window before scheduling, as the PUBLISH
+     * may complete before this function returns. */
+    pOperation->u.operation.inFlight = true;
+    ( pMqttConnection->inFlightPublishes )++;
+
+    status = _IotMqtt_ScheduleOperation( pOperation,
+                                         _IotMqtt_ProcessSend,
+                                         0 );
+
+    if( status != IOT_MQTT_SUCCESS )
+    {
+        pOperation->u.operation.inFlight = false;
+        ( pMqttConnection->inFlightPublishes )--;
+    }
     else
     {
         EMPTY_ELSE_MARKER;
     }
 
-    /* The references mutex only needs to be unlocked on the first retry, since
-     * only the first retry manipulates the connection lists. */
-    if( firstRetry == true )
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _completeInFlightPublish( _mqttOperation_t * pOperation )
+{
+    bool invokeReadyCallback = false;
+    IotLink_t * pLink = NULL;
+    _mqttOperation_t * pQueuedOperation = NULL;
+    IotListDouble_t failedOperations = IOT_LIST_DOUBLE_INITIALIZER;
+    IotMqttCallbackParam_t callbackParam = { 0 };
+    _mqttConnection_t * pMqttConnection = pOperation->pMqttConnection;
+
+    IotListDouble_Create( &failedOperations );
+
+    IotMutex_Lock( &( pMqttConnection->referencesMutex ) );
+
+    if( pOperation->u.operation.inFlight == true )
     {
-        IotMutex_Unlock( &( pMqttConnection->referencesMutex ) );
+        pOperation->u.operation.inFlight = false;
+        ( pMqttConnection->inFlightPublishes )--;
+
+        /* Send queued PUBLISH operations in order while the in-flight window has room. */
+        while( ( pMqttConnection->disconnected == false ) &&
+               ( pMqttConnection->inFlightPublishes < pMqttConnection->maxInFlightPublishes ) &&
+               ( IotListDouble_IsEmpty( &( pMqttConnection->publishQueue ) ) == false ) )
+        {
+            pLink = IotListDouble_RemoveHead( &( pMqttConnection->publishQueue ) );
+            pQueuedOperation = IotLink_Container( _mqttOperation_t, pLink, link );
+
+            pQueuedOperation->u.operation.queued = false;
+            ( pMqttConnection->queuedPublishes )--;
+
+            if( _scheduleInFlightPublish( pQueuedOperation ) == IOT_MQTT_SUCCESS )
+            {
+                IotListDouble_InsertHead( &( pMqttConnection->pendingProcessing ),
+                                          pLink );
+            }
+            else
+            {
+                pQueuedOperation->u.operation.status = IOT_MQTT_SCHEDULING_ERROR;
+                IotListDouble_InsertTail( &failedOperations, pLink );
+            }
+        }
+
+        /* Signal a producer that was refused by a full publish queue. */
+        if( ( pMqttConnection->publishReadyPending == true ) &&
+            ( pMqttConnection->disconnected == false ) &&
+            ( pMqttConnection->queuedPublishes < IOT_MQTT_MAX_QUEUED_PUBLISHES ) )
+        {
+            pMqttConnection->publishReadyPending = false;
+            invokeReadyCallback = ( pMqttConnection->publishReadyCallback.function != NULL );
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
     }
     else
     {
         EMPTY_ELSE_MARKER;
     }
 
-    return( status == IOT_MQTT_SUCCESS );
+    IotMutex_Unlock( &( pMqttConnection->referencesMutex ) );
+
+    /* Notify of queued PUBLISH operations that could not be scheduled. */
+    while( IotListDouble_IsEmpty( &failedOperations ) == false )
+    {
+        pLink = IotListDouble_RemoveHead( &failedOperations );
+        _IotMqtt_Notify( IotLink_Container( _mqttOperation_t, pLink, link ) );
+    }
+
+    if( invokeReadyCallback == true )
+    {
+        callbackParam.mqttConnection = pMqttConnection;
+        callbackParam.u.operation.type = IOT_MQTT_PUBLISH_TO_SERVER;
+        callbackParam.u.operation.reference = IOT_MQTT_OPERATION_INITIALIZER;
+        callbackParam.u.operation.result = IOT_MQTT_SUCCESS;
+
+        pMqttConnection->publishReadyCallback.function( pMqttConnection->publishReadyCallback.pCallbackContext,
+                                                        &callbackParam );
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
 }
 
 /*-----------------------------------------------------------*/
@@ -472,9 +907,21 @@ bool _IotMqtt_DecrementOperationReferences( _mqttOperation_t * pOperation,
     /* Attempt to cancel the operation's job. */
     if( cancelJob == true )
     {
-        taskPoolStatus = IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL,
-                                                pOperation->job,
-                                                NULL );
+        IotMutex_Lock( &( pMqttConnection->referencesMutex ) );
+
+        /* An operation held by its connection has no job to cancel. */
+        if( _releaseHeldOperation( pOperation ) == false )
+        {
+            taskPoolStatus = IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL,
+                                                    pOperation->job,
+                                                    NULL );
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+
+        IotMutex_Unlock( &( pMqttConnection->referencesMutex ) );
 
         /* If the operation's job was not canceled, it must be already executing.
          * Any other return value is invalid. */
@@ -554,6 +1001,16 @@ void _IotMqtt_DestroyOperation( _mqttOperation_t * pOperation )
     IotMqtt_Assert( ( pOperation->u.operation.jobReference >= 0 ) &&
                     ( pOperation->u.operation.jobReference <= 2 ) );
 
+    /* Free the in-flight window slot of a QoS 1 PUBLISH that did not complete. */
+    if( pOperation->u.operation.type == IOT_MQTT_PUBLISH_TO_SERVER )
+    {
+        _completeInFlightPublish( pOperation );
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
     /* Jobs to be destroyed should be removed from the MQTT connection's
      * lists. */
     IotMutex_Lock( &( pMqttConnection->referencesMutex ) );
@@ -676,6 +1133,12 @@ void _IotMqtt_ProcessKeepAlive( IotTaskPool_t pTaskPool,
                                             &pKeepAliveJob );
     IotMqtt_Assert( taskPoolStatus == IOT_TASKPOOL_SUCCESS );
 
+    /* Re-creating the job reset its priority class. Failure here means the task
+     * pool is shutting down, which rescheduling below will report. */
+    ( void ) IotTaskPool_SetJobPriority( pTaskPool,
+                                         pKeepAliveJob,
+                                         IOT_TASKPOOL_JOB_PRIORITY_CRITICAL );
+
     IotMutex_Lock( &( pMqttConnection->referencesMutex ) );
 
     /* Determine whether to send a PINGREQ or check for PINGRESP. */
@@ -1097,6 +1560,53 @@ IotMqttError_t _IotMqtt_ScheduleOperation( _mqttOperation_t * pOperation,
 
 /*-----------------------------------------------------------*/
 
+IotMqttError_t _IotMqtt_SchedulePublish( _mqttOperation_t * pOperation )
+{
+    IotMqttError_t status = IOT_MQTT_SUCCESS;
+    _mqttConnection_t * pMqttConnection = pOperation->pMqttConnection;
+
+    /* Only QoS 1 PUBLISH operations are subject to the in-flight window. */
+    IotMqtt_Assert( pOperation->u.operation.type == IOT_MQTT_PUBLISH_TO_SERVER );
+
+    IotMutex_Lock( &( pMqttConnection->referencesMutex ) );
+
+    /* Send the PUBLISH if the in-flight window has room and no earlier PUBLISH
+     * is waiting for it. */
+    if( ( pMqttConnection->inFlightPublishes < pMqttConnection->maxInFlightPublishes ) &&
+        ( IotListDouble_IsEmpty( &( pMqttConnection->publishQueue ) ) == true ) )
+    {
+        status = _scheduleInFlightPublish( pOperation );
+    }
+    else if( pMqttConnection->queuedPublishes < IOT_MQTT_MAX_QUEUED_PUBLISHES )
+    {
+        IotLogDebug( "(MQTT connection %p, PUBLISH operation %p) In-flight window full, "
+                     "PUBLISH queued.",
+                     pMqttConnection,
+                     pOperation );
+
+        /* Hold the PUBLISH until an in-flight PUBLISH completes. */
+        IotListDouble_Remove( &( pOperation->link ) );
+        IotListDouble_InsertTail( &( pMqttConnection->publishQueue ),
+                                  &( pOperation->link ) );
+
+        pOperation->u.operation.queued = true;
+        ( pMqttConnection->queuedPublishes )++;
+    }
+    else
+    {
+        /* Invoke the publish ready callback once the publish queue has room. */
+        pMqttConnection->publishReadyPending = true;
+
+        status = IOT_MQTT_QUEUE_FULL;
+    }
+
+    IotMutex_Unlock( &( pMqttConnection->referencesMutex ) );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
 _mqttOperation_t * _IotMqtt_FindOperation( _mqttConnection_t * pMqttConnection,
                                            IotMqttOperationType_t type,
                                            const uint16_t * pPacketIdentifier )
@@ -1136,13 +1646,20 @@ _mqttOperation_t * _IotMqtt_FindOperation( _mqttConnection_t * pMqttConnection,
         pResult = IotLink_Container( _mqttOperation_t, pResultLink, link );
         waitable = ( pResult->u.operation.flags & IOT_MQTT_FLAG_WAITABLE ) == IOT_MQTT_FLAG_WAITABLE;
 
-        /* Check if the matched operation is a PUBLISH with retry. If it is, cancel
-         * the retry job. */
+        /* Check if the matched operation is a PUBLISH with retry. If it is, release
+         * it from the connection's retry job or cancel its send job. */
         if( pResult->u.operation.retry.limit > 0 )
         {
-            taskPoolStatus = IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL,
-                                                    pResult->job,
-                                                    NULL );
+            if( _releaseHeldOperation( pResult ) == false )
+            {
+                taskPoolStatus = IotTaskPool_TryCancel( IOT_SYSTEM_TASKPOOL,
+                                                        pResult->job,
+                                                        NULL );
+            }
+            else
+            {
+                EMPTY_ELSE_MARKER;
+            }
 
             /* If the retry job could not be canceled, then it is currently
              * executing. Ignore the operation. */
@@ -1214,6 +1731,17 @@ void _IotMqtt_Notify( _mqttOperation_t * pOperation )
     /* Check if operation is waitable. */
     bool waitable = ( pOperation->u.operation.flags & IOT_MQTT_FLAG_WAITABLE ) == IOT_MQTT_FLAG_WAITABLE;
 
+    /* A completed QoS 1 PUBLISH leaves the in-flight window, which allows a
+     * queued PUBLISH to be sent. */
+    if( pOperation->u.operation.type == IOT_MQTT_PUBLISH_TO_SERVER )
+    {
+        _completeInFlightPublish( pOperation );
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
     /* Remove any lingering subscriptions if a SUBSCRIBE failed. Rejected
      * subscriptions are removed by the deserializer, so not removed here. */
     if( pOperation->u.operation.type == IOT_MQTT_SUBSCRIBE )
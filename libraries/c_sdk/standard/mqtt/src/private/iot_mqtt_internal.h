@@ -192,6 +192,12 @@
 #ifndef IOT_MQTT_RETRY_MS_CEILING
     #define IOT_MQTT_RETRY_MS_CEILING               ( 60000 )
 #endif
+#ifndef IOT_MQTT_MAX_IN_FLIGHT_PUBLISHES
+    #define IOT_MQTT_MAX_IN_FLIGHT_PUBLISHES        ( 10 )
+#endif
+#ifndef IOT_MQTT_MAX_QUEUED_PUBLISHES
+    #define IOT_MQTT_MAX_QUEUED_PUBLISHES           ( 10 )
+#endif
 /** @endcond */
 
 /**
@@ -278,6 +284,18 @@ typedef struct _mqttConnection
     IotTaskPoolJob_t keepAliveJob;               /**< @brief Task pool job for processing this connection's keep-alive. */
     uint8_t * pPingreqPacket;                    /**< @brief An MQTT PINGREQ packet, allocated if keep-alive is active. */
     size_t pingreqPacketSize;                    /**< @brief The size of an allocated PINGREQ packet. */
+
+    uint16_t maxInFlightPublishes;               /**< @brief Size of the in-flight window for QoS 1 PUBLISH messages. */
+    uint16_t inFlightPublishes;                  /**< @brief Number of QoS 1 PUBLISH messages in the in-flight window. */
+    uint16_t queuedPublishes;                    /**< @brief Number of QoS 1 PUBLISH messages in `publishQueue`. */
+    bool publishReadyPending;                    /**< @brief Whether the publish ready callback should be invoked once the queue has room. */
+    IotListDouble_t publishQueue;                /**< @brief QoS 1 PUBLISH operations waiting for room in the in-flight window. */
+    IotMqttCallbackInfo_t publishReadyCallback;  /**< @brief A function to invoke when a full publish queue has room. */
+
+    bool retryJobScheduled;                      /**< @brief Whether the retry job is scheduled. */
+    uint64_t nextRetryMs;                        /**< @brief When the retry job is scheduled to run. */
+    IotTaskPoolJobStorage_t retryJobStorage;     /**< @brief Task pool job for retransmitting this connection's in-flight PUBLISH messages. */
+    IotTaskPoolJob_t retryJob;                   /**< @brief Task pool job for retransmitting this connection's in-flight PUBLISH messages. */
 } _mqttConnection_t;
 
 /**
@@ -352,12 +370,15 @@ typedef struct _mqttOperation
                 IotMqttCallbackInfo_t callback; /**< @brief User-provided callback function and parameter. */
             } notify;                           /**< @brief How to notify of this operation's completion. */
             IotMqttError_t status;              /**< @brief Result of this operation. This is reported once a response is received. */
+            bool inFlight;                      /**< @brief Whether this QoS 1 PUBLISH occupies a slot in the connection's in-flight window. */
+            bool queued;                        /**< @brief Whether this QoS 1 PUBLISH is waiting in the connection's publish queue. */
 
             struct
             {
                 uint32_t count;
                 uint32_t limit;
                 uint32_t nextPeriod;
+                uint64_t nextRetryMs;
             } retry;
         } operation;
 
@@ -782,6 +803,19 @@ IotMqttError_t _IotMqtt_ScheduleOperation( _mqttOperation_t * pOperation,
                                            IotTaskPoolRoutine_t jobRoutine,
                                            uint32_t delay );
 
+/**
+ * @brief Schedule a QoS 1 PUBLISH for sending, subject to the in-flight window
+ * of its MQTT connection.
+ *
+ * If the in-flight window is full, the PUBLISH is queued and sent once an
+ * in-flight PUBLISH completes.
+ *
+ * @param[in] pOperation The PUBLISH operation to schedule.
+ *
+ * @return #IOT_MQTT_SUCCESS, #IOT_MQTT_SCHEDULING_ERROR, or #IOT_MQTT_QUEUE_FULL.
+ */
+IotMqttError_t _IotMqtt_SchedulePublish( _mqttOperation_t * pOperation );
+
 /**
  * @brief Search a list of MQTT operations pending responses using an operation
  * name and packet identifier. Removes a matching operation from the list if found.
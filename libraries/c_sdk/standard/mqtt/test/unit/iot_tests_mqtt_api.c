@@ -122,6 +122,38 @@
       4 * DUP_CHECK_RETRY_MS + \
       IOT_MQTT_RESPONSE_WAIT_MS )
 
+/*
+ * Constants that affect the behavior of #TEST_MQTT_Unit_API_PublishWindow and
+ * #TEST_MQTT_Unit_API_PublishThroughput.
+ */
+#define WINDOW_TEST_IN_FLIGHT        ( 2 )     /**< @brief Size of the in-flight window in the window test. */
+#define THROUGHPUT_PUBLISH_COUNT     ( 1000 )  /**< @brief How many PUBLISH messages the throughput test sends. */
+#define THROUGHPUT_RETRY_MS          ( 50 )    /**< @brief Retry period of PUBLISH messages in the throughput test. */
+#define THROUGHPUT_RETRY_LIMIT       ( 8 )     /**< @brief Retry limit of PUBLISH messages in the throughput test. */
+#define THROUGHPUT_TIMEOUT_MS        ( 60000 ) /**< @brief Total time allowed for the throughput test. */
+#define BROKER_ACK_DELAY_MS          ( 1 )     /**< @brief Simulated network round-trip time of the broker stand-in. */
+#define BROKER_QUEUE_SIZE            ( 64 )    /**< @brief How many unacknowledged PUBLISH messages the broker stand-in holds. */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A local stand-in for an MQTT broker that acknowledges every QoS 1
+ * PUBLISH it receives.
+ */
+typedef struct _brokerStandIn
+{
+    IotMutex_t mutex;                            /**< @brief Protects the queue of packet identifiers. */
+    IotSemaphore_t publishSem;                   /**< @brief Counts PUBLISH messages waiting for a PUBACK. */
+    IotSemaphore_t exitSem;                      /**< @brief Posted when the broker thread exits. */
+    volatile bool exit;                          /**< @brief Signals the broker thread to exit. */
+    uint16_t pPacketIds[ BROKER_QUEUE_SIZE ];    /**< @brief Packet identifiers of PUBLISH messages waiting for a PUBACK. */
+    size_t head;                                 /**< @brief Index of the oldest packet identifier. */
+    size_t count;                                /**< @brief Number of packet identifiers in the queue. */
+    uint8_t pPuback[ 4 ];                        /**< @brief The PUBACK being received. */
+    size_t pubackIndex;                          /**< @brief Next byte of the PUBACK to receive. */
+    uint16_t maxInFlightPublishes;               /**< @brief Largest in-flight window observed by the send function. */
+} _brokerStandIn_t;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -159,6 +191,16 @@ static IotMqttNetworkInfo_t _networkInfo = IOT_MQTT_NETWORK_INFO_INITIALIZER;
  */
 static IotNetworkInterface_t _networkInterface = { 0 };
 
+/**
+ * @brief Counts the completed PUBLISH operations in the flow control tests.
+ */
+static uint32_t _publishCompleteCount = 0;
+
+/**
+ * @brief Counts how many times #_publishReadyCallback has been called.
+ */
+static uint32_t _publishReadyCount = 0;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -506,6 +548,201 @@ static void _decrementReferencesJob( IotTaskPool_t pTaskPool,
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief A send function for the broker stand-in. Records the packet identifier
+ * of each QoS 1 PUBLISH so that the broker stand-in may acknowledge it.
+ */
+static size_t _brokerSend( void * pSendContext,
+                           const uint8_t * pMessage,
+                           size_t messageLength )
+{
+    _brokerStandIn_t * pBroker = ( _brokerStandIn_t * ) pSendContext;
+    size_t packetIdIndex = 4 + TEST_TOPIC_NAME_LENGTH;
+
+    /* Only QoS 1 PUBLISH messages are acknowledged. The PUBLISH messages of these
+     * tests have a single byte "Remaining length". */
+    if( ( ( pMessage[ 0 ] & 0xf0 ) == MQTT_PACKET_TYPE_PUBLISH ) &&
+        ( ( pMessage[ 0 ] & 0x06 ) == 0x02 ) &&
+        ( messageLength > packetIdIndex + 1 ) )
+    {
+        IotMutex_Lock( &( pBroker->mutex ) );
+
+        if( pBroker->count < BROKER_QUEUE_SIZE )
+        {
+            pBroker->pPacketIds[ ( pBroker->head + pBroker->count ) % BROKER_QUEUE_SIZE ] =
+                ( uint16_t ) ( ( pMessage[ packetIdIndex ] << 8 ) | pMessage[ packetIdIndex + 1 ] );
+            pBroker->count++;
+
+            IotSemaphore_Post( &( pBroker->publishSem ) );
+        }
+
+        IotMutex_Unlock( &( pBroker->mutex ) );
+
+        /* Record the largest in-flight window seen while sending. */
+        IotMutex_Lock( &( _pMqttConnection->referencesMutex ) );
+
+        if( _pMqttConnection->inFlightPublishes > pBroker->maxInFlightPublishes )
+        {
+            pBroker->maxInFlightPublishes = _pMqttConnection->inFlightPublishes;
+        }
+
+        IotMutex_Unlock( &( _pMqttConnection->referencesMutex ) );
+    }
+
+    /* This function returns the message length to simulate a successful send. */
+    return messageLength;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A network receive function that reads the broker stand-in's PUBACK.
+ */
+static size_t _brokerReceive( void * pReceiveContext,
+                              uint8_t * pBuffer,
+                              size_t bytesRequested )
+{
+    _brokerStandIn_t * pBroker = ( _brokerStandIn_t * ) pReceiveContext;
+    size_t bytesReceived = sizeof( pBroker->pPuback ) - pBroker->pubackIndex;
+
+    if( bytesReceived > bytesRequested )
+    {
+        bytesReceived = bytesRequested;
+    }
+
+    ( void ) memcpy( pBuffer, pBroker->pPuback + pBroker->pubackIndex, bytesReceived );
+    pBroker->pubackIndex += bytesReceived;
+
+    return bytesReceived;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Deliver a PUBACK from the broker stand-in to the MQTT connection.
+ */
+static void _brokerAcknowledge( _brokerStandIn_t * pBroker,
+                                uint16_t packetIdentifier )
+{
+    pBroker->pPuback[ 0 ] = MQTT_PACKET_TYPE_PUBACK;
+    pBroker->pPuback[ 1 ] = 0x02;
+    pBroker->pPuback[ 2 ] = ( uint8_t ) ( packetIdentifier >> 8 );
+    pBroker->pPuback[ 3 ] = ( uint8_t ) ( packetIdentifier & 0x00ff );
+    pBroker->pubackIndex = 0;
+
+    IotMqtt_ReceiveCallback( pBroker, _pMqttConnection );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The broker stand-in thread. Acknowledges PUBLISH messages after a short
+ * delay that simulates the network round-trip time.
+ */
+static void _brokerThread( void * pArgument )
+{
+    _brokerStandIn_t * pBroker = ( _brokerStandIn_t * ) pArgument;
+    uint16_t packetIdentifier = 0;
+    bool acknowledge = false;
+
+    while( pBroker->exit == false )
+    {
+        acknowledge = IotSemaphore_TimedWait( &( pBroker->publishSem ), TIMEOUT_MS );
+
+        if( acknowledge == true )
+        {
+            IotClock_SleepMs( BROKER_ACK_DELAY_MS );
+        }
+
+        /* Acknowledge every PUBLISH received during the round trip. */
+        while( acknowledge == true )
+        {
+            IotMutex_Lock( &( pBroker->mutex ) );
+            packetIdentifier = pBroker->pPacketIds[ pBroker->head ];
+            pBroker->head = ( pBroker->head + 1 ) % BROKER_QUEUE_SIZE;
+            pBroker->count--;
+            IotMutex_Unlock( &( pBroker->mutex ) );
+
+            _brokerAcknowledge( pBroker, packetIdentifier );
+
+            acknowledge = IotSemaphore_TryWait( &( pBroker->publishSem ) );
+        }
+    }
+
+    IotSemaphore_Post( &( pBroker->exitSem ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize a broker stand-in and use it as the network connection of
+ * the shared MQTT connection.
+ */
+static void _brokerCreate( _brokerStandIn_t * pBroker )
+{
+    ( void ) memset( pBroker, 0x00, sizeof( _brokerStandIn_t ) );
+
+    TEST_ASSERT_EQUAL_INT( true, IotMutex_Create( &( pBroker->mutex ), false ) );
+    TEST_ASSERT_EQUAL_INT( true, IotSemaphore_Create( &( pBroker->publishSem ), 0, BROKER_QUEUE_SIZE ) );
+    TEST_ASSERT_EQUAL_INT( true, IotSemaphore_Create( &( pBroker->exitSem ), 0, 1 ) );
+
+    _pMqttConnection->pNetworkConnection = pBroker;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Clean up a broker stand-in.
+ */
+static void _brokerDestroy( _brokerStandIn_t * pBroker )
+{
+    IotSemaphore_Destroy( &( pBroker->exitSem ) );
+    IotSemaphore_Destroy( &( pBroker->publishSem ) );
+    IotMutex_Destroy( &( pBroker->mutex ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A PUBLISH completion callback that counts successful PUBLISH messages.
+ */
+static void _publishCompleteCallback( void * pCallbackContext,
+                                      IotMqttCallbackParam_t * pCallbackParam )
+{
+    IotSemaphore_t * pCompleteSem = ( IotSemaphore_t * ) pCallbackContext;
+
+    if( pCallbackParam->u.operation.result == IOT_MQTT_SUCCESS )
+    {
+        IotMutex_Lock( &( _pMqttConnection->referencesMutex ) );
+        _publishCompleteCount++;
+        IotMutex_Unlock( &( _pMqttConnection->referencesMutex ) );
+    }
+
+    IotSemaphore_Post( pCompleteSem );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A publish ready callback that counts how many times it was invoked.
+ */
+static void _publishReadyCallback( void * pCallbackContext,
+                                   IotMqttCallbackParam_t * pCallbackParam )
+{
+    IotSemaphore_t * pReadySem = ( IotSemaphore_t * ) pCallbackContext;
+
+    /* The publish ready callback does not have an operation. */
+    if( ( pCallbackParam->u.operation.type == IOT_MQTT_PUBLISH_TO_SERVER ) &&
+        ( pCallbackParam->u.operation.reference == IOT_MQTT_OPERATION_INITIALIZER ) )
+    {
+        _publishReadyCount++;
+    }
+
+    IotSemaphore_Post( pReadySem );
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Test group for MQTT API tests.
  */
@@ -531,6 +768,8 @@ TEST_SETUP( MQTT_Unit_API )
     _pingreqSendCount = 0;
     _closeCount = 0;
     _disconnectCallbackCount = 0;
+    _publishCompleteCount = 0;
+    _publishReadyCount = 0;
 
     /* Initialize libraries. */
     TEST_ASSERT_EQUAL_INT( true, IotSdk_Init() );
@@ -565,6 +804,8 @@ TEST_GROUP_RUNNER( MQTT_Unit_API )
     RUN_TEST_CASE( MQTT_Unit_API, PublishQoS0MallocFail );
     RUN_TEST_CASE( MQTT_Unit_API, PublishQoS1 );
     RUN_TEST_CASE( MQTT_Unit_API, PublishDuplicates );
+    RUN_TEST_CASE( MQTT_Unit_API, PublishWindow );
+    RUN_TEST_CASE( MQTT_Unit_API, PublishThroughput );
     RUN_TEST_CASE( MQTT_Unit_API, SubscribeUnsubscribeParameters );
     RUN_TEST_CASE( MQTT_Unit_API, SubscribeMallocFail );
     RUN_TEST_CASE( MQTT_Unit_API, UnsubscribeMallocFail );
@@ -1172,6 +1413,231 @@ TEST( MQTT_Unit_API, PublishDuplicates )
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Tests that QoS 1 PUBLISH messages beyond the in-flight window are
+ * queued, that a full queue is reported, and that the publish ready callback
+ * is invoked once the queue has room.
+ */
+TEST( MQTT_Unit_API, PublishWindow )
+{
+    int32_t i = 0, retries = 0;
+    const int32_t publishCount = WINDOW_TEST_IN_FLIGHT + IOT_MQTT_MAX_QUEUED_PUBLISHES;
+    uint16_t pPacketIds[ WINDOW_TEST_IN_FLIGHT + IOT_MQTT_MAX_QUEUED_PUBLISHES ] = { 0 };
+    _brokerStandIn_t broker;
+    IotSemaphore_t completeSem, readySem;
+    IotMqttPublishInfo_t publishInfo = IOT_MQTT_PUBLISH_INFO_INITIALIZER;
+    IotMqttOperation_t publishOperation = IOT_MQTT_OPERATION_INITIALIZER;
+    IotMqttCallbackInfo_t callbackInfo = IOT_MQTT_CALLBACK_INFO_INITIALIZER;
+
+    TEST_ASSERT_EQUAL_INT( true, IotSemaphore_Create( &completeSem, 0, publishCount ) );
+    TEST_ASSERT_EQUAL_INT( true, IotSemaphore_Create( &readySem, 0, 1 ) );
+
+    /* Initialize parameters. */
+    _networkInterface.send = _brokerSend;
+    _networkInterface.receive = _brokerReceive;
+    _networkInfo.maxInFlightPublishes = WINDOW_TEST_IN_FLIGHT;
+    _networkInfo.publishReadyCallback.function = _publishReadyCallback;
+    _networkInfo.publishReadyCallback.pCallbackContext = &readySem;
+    callbackInfo.function = _publishCompleteCallback;
+    callbackInfo.pCallbackContext = &completeSem;
+
+    /* Create a new MQTT connection. */
+    _pMqttConnection = IotTestMqtt_createMqttConnection( AWS_IOT_MQTT_SERVER,
+                                                         &_networkInfo,
+                                                         0 );
+    TEST_ASSERT_NOT_NULL( _pMqttConnection );
+    _brokerCreate( &broker );
+
+    /* Set the publish info. */
+    publishInfo.qos = IOT_MQTT_QOS_1;
+    publishInfo.pTopicName = TEST_TOPIC_NAME;
+    publishInfo.topicNameLength = TEST_TOPIC_NAME_LENGTH;
+    publishInfo.pPayload = "test";
+    publishInfo.payloadLength = 4;
+
+    if( TEST_PROTECT() )
+    {
+        /* Fill the in-flight window and the publish queue. */
+        for( i = 0; i < publishCount; i++ )
+        {
+            TEST_ASSERT_EQUAL( IOT_MQTT_STATUS_PENDING,
+                               IotMqtt_Publish( _pMqttConnection,
+                                                &publishInfo,
+                                                0,
+                                                &callbackInfo,
+                                                &publishOperation ) );
+
+            pPacketIds[ i ] = publishOperation->u.operation.packetIdentifier;
+        }
+
+        /* Check that excess PUBLISH messages were queued. */
+        IotMutex_Lock( &( _pMqttConnection->referencesMutex ) );
+        TEST_ASSERT_EQUAL_UINT16( WINDOW_TEST_IN_FLIGHT, _pMqttConnection->inFlightPublishes );
+        TEST_ASSERT_EQUAL_UINT16( IOT_MQTT_MAX_QUEUED_PUBLISHES, _pMqttConnection->queuedPublishes );
+        IotMutex_Unlock( &( _pMqttConnection->referencesMutex ) );
+
+        /* A full publish queue refuses new PUBLISH messages. */
+        TEST_ASSERT_EQUAL( IOT_MQTT_QUEUE_FULL,
+                           IotMqtt_Publish( _pMqttConnection,
+                                            &publishInfo,
+                                            0,
+                                            &callbackInfo,
+                                            &publishOperation ) );
+        TEST_ASSERT_EQUAL_UINT32( 0, _publishReadyCount );
+
+        /* Acknowledge each PUBLISH in order. A PUBLISH is only acknowledged once it
+         * is awaiting a response, so the PUBACK is repeated until it completes. */
+        for( i = 0; i < publishCount; i++ )
+        {
+            for( retries = 0; retries < 100; retries++ )
+            {
+                _brokerAcknowledge( &broker, pPacketIds[ i ] );
+
+                if( IotSemaphore_TimedWait( &completeSem, 10 ) == true )
+                {
+                    break;
+                }
+            }
+
+            /* The publish queue has room after the first PUBLISH completes. */
+            TEST_ASSERT_EQUAL_UINT32( 1, _publishReadyCount );
+        }
+
+        TEST_ASSERT_EQUAL_UINT32( publishCount, _publishCompleteCount );
+        TEST_ASSERT_EQUAL_UINT16( WINDOW_TEST_IN_FLIGHT, broker.maxInFlightPublishes );
+
+        /* Check that the in-flight window and publish queue are empty. */
+        IotMutex_Lock( &( _pMqttConnection->referencesMutex ) );
+        TEST_ASSERT_EQUAL_UINT16( 0, _pMqttConnection->inFlightPublishes );
+        TEST_ASSERT_EQUAL_UINT16( 0, _pMqttConnection->queuedPublishes );
+        IotMutex_Unlock( &( _pMqttConnection->referencesMutex ) );
+    }
+
+    /* Clean up MQTT connection. */
+    IotMqtt_Disconnect( _pMqttConnection, IOT_MQTT_FLAG_CLEANUP_ONLY );
+
+    _brokerDestroy( &broker );
+    IotSemaphore_Destroy( &readySem );
+    IotSemaphore_Destroy( &completeSem );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the rate of QoS 1 PUBLISH messages acknowledged by a local
+ * broker stand-in, with a producer that waits for the publish ready callback
+ * whenever the publish queue is full.
+ */
+TEST( MQTT_Unit_API, PublishThroughput )
+{
+    uint32_t i = 0, completeCount = 0;
+    uint64_t startTime = 0, elapsedTime = 0;
+    IotMqttError_t status = IOT_MQTT_STATUS_PENDING;
+    _brokerStandIn_t broker;
+    IotSemaphore_t completeSem, readySem;
+    IotMqttPublishInfo_t publishInfo = IOT_MQTT_PUBLISH_INFO_INITIALIZER;
+    IotMqttCallbackInfo_t callbackInfo = IOT_MQTT_CALLBACK_INFO_INITIALIZER;
+
+    TEST_ASSERT_EQUAL_INT( true, IotSemaphore_Create( &completeSem, 0, THROUGHPUT_PUBLISH_COUNT ) );
+    TEST_ASSERT_EQUAL_INT( true, IotSemaphore_Create( &readySem, 0, 1 ) );
+
+    /* Print a newline so this test may log its status. */
+    UNITY_PRINT_EOL();
+
+    /* Initialize parameters. Use the default in-flight window. */
+    _networkInterface.send = _brokerSend;
+    _networkInterface.receive = _brokerReceive;
+    _networkInfo.publishReadyCallback.function = _publishReadyCallback;
+    _networkInfo.publishReadyCallback.pCallbackContext = &readySem;
+    callbackInfo.function = _publishCompleteCallback;
+    callbackInfo.pCallbackContext = &completeSem;
+
+    /* Create a new MQTT connection. */
+    _pMqttConnection = IotTestMqtt_createMqttConnection( AWS_IOT_MQTT_SERVER,
+                                                         &_networkInfo,
+                                                         0 );
+    TEST_ASSERT_NOT_NULL( _pMqttConnection );
+    _brokerCreate( &broker );
+
+    /* Set the publish info. Retransmissions recover PUBACKs that arrive before
+     * a PUBLISH is awaiting a response. */
+    publishInfo.qos = IOT_MQTT_QOS_1;
+    publishInfo.pTopicName = TEST_TOPIC_NAME;
+    publishInfo.topicNameLength = TEST_TOPIC_NAME_LENGTH;
+    publishInfo.pPayload = "test";
+    publishInfo.payloadLength = 4;
+    publishInfo.retryMs = THROUGHPUT_RETRY_MS;
+    publishInfo.retryLimit = THROUGHPUT_RETRY_LIMIT;
+
+    TEST_ASSERT_EQUAL_INT( true, Iot_CreateDetachedThread( _brokerThread,
+                                                           &broker,
+                                                           IOT_THREAD_DEFAULT_PRIORITY,
+                                                           IOT_THREAD_DEFAULT_STACK_SIZE ) );
+
+    if( TEST_PROTECT() )
+    {
+        startTime = IotClock_GetTimeMs();
+
+        /* Send the PUBLISH messages, waiting for room in the publish queue
+         * whenever it is full. */
+        for( i = 0; i < THROUGHPUT_PUBLISH_COUNT; )
+        {
+            status = IotMqtt_Publish( _pMqttConnection,
+                                      &publishInfo,
+                                      0,
+                                      &callbackInfo,
+                                      NULL );
+
+            if( status == IOT_MQTT_QUEUE_FULL )
+            {
+                TEST_ASSERT_EQUAL_INT( true, IotSemaphore_TimedWait( &readySem, THROUGHPUT_TIMEOUT_MS ) );
+            }
+            else
+            {
+                TEST_ASSERT_EQUAL( IOT_MQTT_STATUS_PENDING, status );
+                i++;
+            }
+        }
+
+        /* Wait for every PUBLISH to complete. */
+        for( completeCount = 0; completeCount < THROUGHPUT_PUBLISH_COUNT; completeCount++ )
+        {
+            TEST_ASSERT_EQUAL_INT( true, IotSemaphore_TimedWait( &completeSem, THROUGHPUT_TIMEOUT_MS ) );
+        }
+
+        elapsedTime = IotClock_GetTimeMs() - startTime;
+
+        /* Log the PUBLISH rate with Unity. */
+        UnityPrint( "PublishThroughput " );
+        UnityPrintNumber( ( UNITY_INT ) THROUGHPUT_PUBLISH_COUNT );
+        UnityPrint( " PUBLISH messages in " );
+        UnityPrintNumber( ( UNITY_INT ) elapsedTime );
+        UnityPrint( " ms (" );
+        UnityPrintNumber( ( UNITY_INT ) ( ( THROUGHPUT_PUBLISH_COUNT * 1000ULL ) / ( elapsedTime + 1 ) ) );
+        UnityPrint( " messages/s), publish queue full " );
+        UnityPrintNumber( ( UNITY_INT ) _publishReadyCount );
+        UnityPrint( " times." );
+        UNITY_PRINT_EOL();
+
+        /* Every PUBLISH was acknowledged, and the in-flight window was never exceeded. */
+        TEST_ASSERT_EQUAL_UINT32( THROUGHPUT_PUBLISH_COUNT, _publishCompleteCount );
+        TEST_ASSERT_TRUE( broker.maxInFlightPublishes <= IOT_MQTT_MAX_IN_FLIGHT_PUBLISHES );
+    }
+
+    /* Stop the broker stand-in. */
+    broker.exit = true;
+    TEST_ASSERT_EQUAL_INT( true, IotSemaphore_TimedWait( &( broker.exitSem ), THROUGHPUT_TIMEOUT_MS ) );
+
+    /* Clean up MQTT connection. */
+    IotMqtt_Disconnect( _pMqttConnection, IOT_MQTT_FLAG_CLEANUP_ONLY );
+
+    _brokerDestroy( &broker );
+    IotSemaphore_Destroy( &readySem );
+    IotSemaphore_Destroy( &completeSem );
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Tests the behavior of @ref mqtt_function_subscribe and
  * @ref mqtt_function_unsubscribe with various invalid parameters.
@@ -243,6 +243,23 @@ typedef struct IotSerializerDecoderObject
     } u;
 } IotSerializerDecoderObject_t;
 
+/**
+ * @brief One entry of the token table built by the JSON decoder.
+ *
+ * The JSON decoder tokenizes a document once when it is initialized; keys,
+ * values and containers are then located through the token table instead of
+ * rescanning the text. Applications that decode documents of a known shape may
+ * supply the table with @ref IotSerializer_InitJsonDecoderWithTokens to avoid
+ * allocating it.
+ */
+typedef struct IotSerializerJsonToken
+{
+    uint32_t start; /**< Offset of the first character of the token. */
+    uint32_t end;   /**< Offset one past the last character of the token. */
+    uint32_t next;  /**< Index of the token following this token and all of its children. */
+    uint32_t type;  /**< The #IotSerializerDataType_t of the token. */
+} IotSerializerJsonToken_t;
+
 typedef void * IotSerializerDecoderIterator_t;
 
 /**
@@ -453,4 +470,26 @@ extern IotSerializerEncodeInterface_t _IotSerializerJsonEncoder;
 
 extern IotSerializerDecodeInterface_t _IotSerializerJsonDecoder;
 
+/**
+ * @brief Initialize a JSON decoder object using a caller-supplied token table.
+ *
+ * Behaves like the `init` function of #_IotSerializerJsonDecoder, except that
+ * the document is tokenized into `pTokenBuffer` instead of a table allocated
+ * by the decoder. The token buffer must remain valid until the decoder object
+ * is destroyed.
+ *
+ * @param[out] pDecoderObject Decoder object to initialize.
+ * @param[in] pDataBuffer JSON document.
+ * @param[in] maxSize Maximum length of the JSON document.
+ * @param[in] pTokenBuffer Token table to fill.
+ * @param[in] tokenBufferCount Number of entries in `pTokenBuffer`.
+ * @return IOT_SERIALIZER_SUCCESS if successful; IOT_SERIALIZER_BUFFER_TOO_SMALL
+ * if the document has more tokens than `tokenBufferCount`.
+ */
+IotSerializerError_t IotSerializer_InitJsonDecoderWithTokens( IotSerializerDecoderObject_t * pDecoderObject,
+                                                             const uint8_t * pDataBuffer,
+                                                             size_t maxSize,
+                                                             IotSerializerJsonToken_t * pTokenBuffer,
+                                                             size_t tokenBufferCount );
+
 #endif /* ifndef IOT_SERIALIZER_H_ */
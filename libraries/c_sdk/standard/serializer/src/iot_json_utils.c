@@ -32,11 +32,428 @@
 #include "iot_config.h"
 
 /* Standard includes. */
+#include <stdint.h>
 #include <string.h>
 
 /* JSON utilities include. */
 #include "iot_json_utils.h"
 
+/**
+ * @cond DOXYGEN_IGNORE
+ * Doxygen should ignore this section.
+ *
+ * Provide default values for undefined configuration constants.
+ */
+#ifndef IOT_JSON_UTILS_ENABLE_SIMD
+    #define IOT_JSON_UTILS_ENABLE_SIMD    ( 1 )
+#endif
+/** @endcond */
+
+/* Select the vector instructions used to scan for structural characters. The
+ * scalar scanner is used when none are available. */
+#if IOT_JSON_UTILS_ENABLE_SIMD == 1
+    #if defined( __AVX2__ )
+        #include <immintrin.h>
+        #define _SCAN_BLOCK_SIZE    ( 32 )
+        #define _SCAN_AVX2
+    #elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && ( _M_IX86_FP >= 2 ) )
+        #include <emmintrin.h>
+        #define _SCAN_BLOCK_SIZE    ( 16 )
+        #define _SCAN_SSE2
+    #elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+        #include <arm_neon.h>
+        #define _SCAN_BLOCK_SIZE    ( 16 )
+        #define _SCAN_NEON
+    #endif
+#endif
+
+#if defined( _MSC_VER ) && defined( _SCAN_BLOCK_SIZE )
+    #include <intrin.h>
+#endif
+
+/**
+ * @brief Characters that end a JSON primitive, or make it invalid.
+ */
+#define _PRIMITIVE_END_CHARACTERS    ",} \n\r\t"
+
+/*-----------------------------------------------------------*/
+
+#ifdef _SCAN_BLOCK_SIZE
+
+/**
+ * @brief Get the index of the lowest set bit of a non-zero mask.
+ *
+ * @param[in] mask A non-zero mask.
+ *
+ * @return The index of the lowest set bit.
+ */
+    static size_t _lowestSetBit( uint32_t mask );
+
+/**
+ * @brief Compare each character of one block of #_SCAN_BLOCK_SIZE characters
+ * with a character.
+ *
+ * @param[in] pBlock The block to search.
+ * @param[in] character Character to search for.
+ *
+ * @return A mask with bit `n` set if `pBlock[ n ]` is `character`.
+ */
+    static uint32_t _blockEquals( const char * pBlock,
+                                  char character );
+#endif
+
+/**
+ * @brief Find the first character of a set in a range of a JSON document.
+ *
+ * The range is scanned in blocks using vector instructions when they are
+ * available, so that searches jump between structural characters instead of
+ * visiting each character.
+ *
+ * @param[in] pJsonDocument The JSON document.
+ * @param[in] start Offset to start searching.
+ * @param[in] end Offset one past the last character to search.
+ * @param[in] pSet Characters to search for.
+ * @param[in] setLength Number of characters in `pSet`.
+ *
+ * @return Offset of the first character in the set; `end` if there is none.
+ */
+static size_t _findFirstOf( const char * pJsonDocument,
+                            size_t start,
+                            size_t end,
+                            const char * pSet,
+                            size_t setLength );
+
+/**
+ * @brief Find the next position where a key may end with a double quote.
+ *
+ * A position is a candidate if it holds the first character of the key and a
+ * double quote follows the key length. Candidates are found a block at a time
+ * when vector instructions are available.
+ *
+ * @param[in] pJsonDocument The JSON document.
+ * @param[in] start Offset to start searching.
+ * @param[in] end Offset one past the last candidate to consider.
+ * @param[in] firstCharacter The first character of the key.
+ * @param[in] jsonKeyLength Length of the key.
+ *
+ * @return Offset of the first candidate; `end` if there is none.
+ */
+static size_t _findKeyCandidate( const char * pJsonDocument,
+                                 size_t start,
+                                 size_t end,
+                                 char firstCharacter,
+                                 size_t jsonKeyLength );
+
+/**
+ * @brief Skip whitespace in a JSON document.
+ *
+ * @param[in] pJsonDocument The JSON document.
+ * @param[in] jsonDocumentLength Length of the JSON document.
+ * @param[in] i Offset to start skipping.
+ *
+ * @return Offset of the first character that is not whitespace; `jsonDocumentLength`
+ * if the end of the document is reached.
+ */
+static size_t _skipWhitespace( const char * pJsonDocument,
+                               size_t jsonDocumentLength,
+                               size_t i );
+
+/**
+ * @brief Calculate the length of the JSON value starting at an offset.
+ *
+ * @param[in] pJsonDocument The JSON document.
+ * @param[in] jsonDocumentLength Length of the JSON document.
+ * @param[in] i Offset of the first character of the value.
+ * @param[out] pJsonValueLength Set to the length of the value.
+ *
+ * @return `true` if the value is complete; `false` otherwise.
+ */
+static bool _valueLength( const char * pJsonDocument,
+                          size_t jsonDocumentLength,
+                          size_t i,
+                          size_t * pJsonValueLength );
+
+/*-----------------------------------------------------------*/
+
+#ifdef _SCAN_BLOCK_SIZE
+
+    static size_t _lowestSetBit( uint32_t mask )
+    {
+        #if defined( __GNUC__ )
+            return ( size_t ) __builtin_ctz( mask );
+        #elif defined( _MSC_VER )
+            unsigned long index = 0;
+
+            ( void ) _BitScanForward( &index, mask );
+
+            return ( size_t ) index;
+        #else
+            size_t index = 0;
+
+            while( ( mask & 1UL ) == 0 )
+            {
+                mask >>= 1;
+                index++;
+            }
+
+            return index;
+        #endif
+    }
+
+/*-----------------------------------------------------------*/
+
+    static uint32_t _blockEquals( const char * pBlock,
+                                  char character )
+    {
+        #if defined( _SCAN_AVX2 )
+            __m256i block = _mm256_loadu_si256( ( const __m256i * ) pBlock );
+
+            return ( uint32_t ) _mm256_movemask_epi8( _mm256_cmpeq_epi8( block, _mm256_set1_epi8( character ) ) );
+        #elif defined( _SCAN_SSE2 )
+            __m128i block = _mm_loadu_si128( ( const __m128i * ) pBlock );
+
+            return ( uint32_t ) _mm_movemask_epi8( _mm_cmpeq_epi8( block, _mm_set1_epi8( character ) ) );
+        #elif defined( _SCAN_NEON )
+            static const uint8_t bitWeights[ 16 ] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+            uint8x16_t matches = vceqq_u8( vld1q_u8( ( const uint8_t * ) pBlock ),
+                                           vdupq_n_u8( ( uint8_t ) character ) );
+            uint8x8_t sum;
+
+            /* Each match contributes its bit weight; pairwise additions then
+             * collapse each half of the block into one byte of the mask. */
+            matches = vandq_u8( matches, vld1q_u8( bitWeights ) );
+            sum = vpadd_u8( vget_low_u8( matches ), vget_high_u8( matches ) );
+            sum = vpadd_u8( sum, sum );
+            sum = vpadd_u8( sum, sum );
+
+            return ( uint32_t ) vget_lane_u8( sum, 0 ) | ( ( uint32_t ) vget_lane_u8( sum, 1 ) << 8 );
+        #endif
+    }
+
+#endif /* ifdef _SCAN_BLOCK_SIZE */
+
+/*-----------------------------------------------------------*/
+
+static size_t _findFirstOf( const char * pJsonDocument,
+                            size_t start,
+                            size_t end,
+                            const char * pSet,
+                            size_t setLength )
+{
+    size_t i = start, j = 0;
+    const char * pFound = NULL;
+
+    #ifdef _SCAN_BLOCK_SIZE
+        uint32_t mask = 0;
+
+        for( ; i + _SCAN_BLOCK_SIZE <= end; i += _SCAN_BLOCK_SIZE )
+        {
+            mask = 0;
+
+            for( j = 0; j < setLength; j++ )
+            {
+                mask |= _blockEquals( pJsonDocument + i, pSet[ j ] );
+            }
+
+            if( mask != 0 )
+            {
+                return i + _lowestSetBit( mask );
+            }
+        }
+    #endif
+
+    /* A single character is found with memchr, which is usually optimized by
+     * the C library. */
+    if( setLength == 1 )
+    {
+        if( i < end )
+        {
+            pFound = memchr( pJsonDocument + i, pSet[ 0 ], end - i );
+        }
+
+        return ( pFound != NULL ) ? ( size_t ) ( pFound - pJsonDocument ) : end;
+    }
+
+    for( ; i < end; i++ )
+    {
+        for( j = 0; j < setLength; j++ )
+        {
+            if( pJsonDocument[ i ] == pSet[ j ] )
+            {
+                return i;
+            }
+        }
+    }
+
+    return end;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t _findKeyCandidate( const char * pJsonDocument,
+                                 size_t start,
+                                 size_t end,
+                                 char firstCharacter,
+                                 size_t jsonKeyLength )
+{
+    size_t i = start;
+    const char * pFound = NULL;
+
+    #ifdef _SCAN_BLOCK_SIZE
+        uint32_t mask = 0;
+
+        /* Compare a block with the first character of the key and the block
+         * one key length later with a double quote. Both blocks are within the
+         * document because a key must end before the last 3 characters. */
+        for( ; i + _SCAN_BLOCK_SIZE <= end; i += _SCAN_BLOCK_SIZE )
+        {
+            mask = _blockEquals( pJsonDocument + i, firstCharacter ) &
+                   _blockEquals( pJsonDocument + i + jsonKeyLength, '\"' );
+
+            if( mask != 0 )
+            {
+                return i + _lowestSetBit( mask );
+            }
+        }
+    #endif
+
+    while( i < end )
+    {
+        pFound = memchr( pJsonDocument + i, firstCharacter, end - i );
+
+        if( pFound == NULL )
+        {
+            break;
+        }
+
+        i = ( size_t ) ( pFound - pJsonDocument );
+
+        if( pJsonDocument[ i + jsonKeyLength ] == '\"' )
+        {
+            return i;
+        }
+
+        i++;
+    }
+
+    return end;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t _skipWhitespace( const char * pJsonDocument,
+                               size_t jsonDocumentLength,
+                               size_t i )
+{
+    while( ( i < jsonDocumentLength ) &&
+           ( ( pJsonDocument[ i ] == ' ' ) ||
+             ( pJsonDocument[ i ] == '\n' ) ||
+             ( pJsonDocument[ i ] == '\r' ) ||
+             ( pJsonDocument[ i ] == '\t' ) ) )
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _valueLength( const char * pJsonDocument,
+                          size_t jsonDocumentLength,
+                          size_t i,
+                          size_t * pJsonValueLength )
+{
+    size_t end = 0;
+    char delimiters[ 2 ] = { '\0' };
+    int nestingLevel = 0;
+
+    switch( pJsonDocument[ i ] )
+    {
+        /* Calculate length of a JSON string. */
+        case '\"':
+
+            /* Find the closing double quote. A double quote preceded by a
+             * backslash is escaped, unless the backslash is the opening quote. */
+            for( end = i + 1; ; end++ )
+            {
+                end = _findFirstOf( pJsonDocument, end, jsonDocumentLength, "\"", 1 );
+
+                /* If the end of the document is reached, this isn't a match. */
+                if( end >= jsonDocumentLength )
+                {
+                    return false;
+                }
+
+                if( ( end == i + 1 ) || ( pJsonDocument[ end - 1 ] != '\\' ) )
+                {
+                    break;
+                }
+            }
+
+            /* Include the length of the opening and closing double quotes. */
+            *pJsonValueLength = end - i + 1;
+            break;
+
+        /* Calculate the length of a JSON object or array. This includes the
+         * length of nested objects. */
+        case '{':
+        case '[':
+            delimiters[ 0 ] = pJsonDocument[ i ];
+            delimiters[ 1 ] = ( pJsonDocument[ i ] == '{' ) ? '}' : ']';
+
+            /* Only the opening and closing characters change the nesting level. */
+            for( end = i + 1; ; end++ )
+            {
+                end = _findFirstOf( pJsonDocument, end, jsonDocumentLength, delimiters, 2 );
+
+                /* If the end of the document is reached, this isn't a match. */
+                if( end >= jsonDocumentLength )
+                {
+                    return false;
+                }
+
+                if( pJsonDocument[ end ] == delimiters[ 0 ] )
+                {
+                    nestingLevel++;
+                }
+                else if( nestingLevel == 0 )
+                {
+                    break;
+                }
+                else
+                {
+                    nestingLevel--;
+                }
+            }
+
+            /* Include the length of the opening and closing characters. */
+            *pJsonValueLength = end - i + 1;
+            break;
+
+        /* Calculate the length of a JSON primitive. The JSON value ends with a , or } */
+        default:
+            end = _findFirstOf( pJsonDocument,
+                                i,
+                                jsonDocumentLength,
+                                _PRIMITIVE_END_CHARACTERS,
+                                sizeof( _PRIMITIVE_END_CHARACTERS ) - 1 );
+
+            /* If the end of the document is reached, this isn't a match. Any
+             * whitespace before a , or } means the JSON document is invalid. */
+            if( ( end >= jsonDocumentLength ) ||
+                ( ( pJsonDocument[ end ] != ',' ) && ( pJsonDocument[ end ] != '}' ) ) )
+            {
+                return false;
+            }
+
+            *pJsonValueLength = end - i;
+            break;
+    }
+
+    return true;
+}
+
 /*-----------------------------------------------------------*/
 
 bool IotJsonUtils_FindJsonValue( const char * pJsonDocument,
@@ -46,10 +463,8 @@ bool IotJsonUtils_FindJsonValue( const char * pJsonDocument,
                                  const char ** pJsonValue,
                                  size_t * pJsonValueLength )
 {
-    size_t i = 0;
+    size_t i = 0, searchEnd = 0;
     size_t jsonValueLength = 0;
-    char openCharacter = '\0', closeCharacter = '\0';
-    int nestingLevel = 0;
 
     /* Ensure the JSON document is long enough to contain the key/value pair. At
      * the very least, a JSON key/value pair must contain the key and the 6
@@ -59,38 +474,36 @@ bool IotJsonUtils_FindJsonValue( const char * pJsonDocument,
         return false;
     }
 
-    /* Search the characters in the JSON document for the key. The end of the JSON
-     * document does not have to be searched once too few characters remain to hold a
-     * value. */
-    while( i < jsonDocumentLength - jsonKeyLength - 3 )
+    /* The end of the JSON document does not have to be searched once too few
+     * characters remain to hold a value. */
+    searchEnd = jsonDocumentLength - jsonKeyLength - 3;
+
+    /* A key can only start with its first character and end where a double
+     * quote follows it, so the search jumps between such candidates. */
+    while( i < searchEnd )
     {
-        /* If the first character in the key is found and there's an unescaped double
-         * quote after the key length, do a string compare for the key. */
-        if( ( pJsonDocument[ i ] == pJsonKey[ 0 ] ) &&
-            ( pJsonDocument[ i + jsonKeyLength ] == '\"' ) &&
-            ( pJsonDocument[ i + jsonKeyLength - 1 ] != '\\' ) &&
+        i = _findKeyCandidate( pJsonDocument, i, searchEnd, pJsonKey[ 0 ], jsonKeyLength );
+
+        if( i >= searchEnd )
+        {
+            break;
+        }
+
+        /* If the double quote after the key is unescaped, do a string compare
+         * for the key. */
+        if( ( pJsonDocument[ i + jsonKeyLength - 1 ] != '\\' ) &&
             ( strncmp( pJsonDocument + i,
                        pJsonKey,
                        jsonKeyLength ) == 0 ) )
         {
-            /* Key found; this is a potential match. */
-
-            /* Skip the characters in the JSON key and closing double quote. */
-            i += jsonKeyLength + 1;
+            /* Key found; this is a potential match. Skip the closing double quote
+             * and all whitespace characters between it and the : */
+            i = _skipWhitespace( pJsonDocument, jsonDocumentLength, i + jsonKeyLength + 1 );
 
-            /* Skip all whitespace characters between the closing " and the : */
-            while( pJsonDocument[ i ] == ' ' ||
-                   pJsonDocument[ i ] == '\n' ||
-                   pJsonDocument[ i ] == '\r' ||
-                   pJsonDocument[ i ] == '\t' )
+            /* If the end of the document is reached, this isn't a match. */
+            if( i >= jsonDocumentLength )
             {
-                i++;
-
-                /* If the end of the document is reached, this isn't a match. */
-                if( i >= jsonDocumentLength )
-                {
-                    return false;
-                }
+                return false;
             }
 
             /* The character immediately following a key (and any whitespace) must be a :
@@ -99,25 +512,15 @@ bool IotJsonUtils_FindJsonValue( const char * pJsonDocument,
             {
                 continue;
             }
-            else
-            {
-                /* Skip the : */
-                i++;
-            }
 
-            /* Skip all whitespace characters between : and the first character in the value. */
-            while( pJsonDocument[ i ] == ' ' ||
-                   pJsonDocument[ i ] == '\n' ||
-                   pJsonDocument[ i ] == '\r' ||
-                   pJsonDocument[ i ] == '\t' )
-            {
-                i++;
+            /* Skip the : and all whitespace characters between it and the first
+             * character in the value. */
+            i = _skipWhitespace( pJsonDocument, jsonDocumentLength, i + 1 );
 
-                /* If the end of the document is reached, this isn't a match. */
-                if( i >= jsonDocumentLength )
-                {
-                    return false;
-                }
+            /* If the end of the document is reached, this isn't a match. */
+            if( i >= jsonDocumentLength )
+            {
+                return false;
             }
 
             /* Value found. Set the output parameter. */
@@ -127,119 +530,9 @@ bool IotJsonUtils_FindJsonValue( const char * pJsonDocument,
             }
 
             /* Calculate the value's length. */
-            switch( pJsonDocument[ i ] )
+            if( _valueLength( pJsonDocument, jsonDocumentLength, i, &jsonValueLength ) == false )
             {
-                /* Calculate length of a JSON string. */
-                case '\"':
-                    /* Include the length of the opening and closing double quotes. */
-                    jsonValueLength = 2;
-
-                    /* Skip the opening double quote. */
-                    i++;
-
-                    /* Add the length of all characters in the JSON string. */
-                    while( pJsonDocument[ i ] != '\"' )
-                    {
-                        /* Ignore escaped double quotes. */
-                        if( ( pJsonDocument[ i ] == '\\' ) &&
-                            ( i + 1 < jsonDocumentLength ) &&
-                            ( pJsonDocument[ i + 1 ] == '\"' ) )
-                        {
-                            /* Skip the characters \" */
-                            i += 2;
-                            jsonValueLength += 2;
-                        }
-                        else
-                        {
-                            /* Add the length of a single character. */
-                            i++;
-                            jsonValueLength++;
-                        }
-
-                        /* If the end of the document is reached, this isn't a match. */
-                        if( i >= jsonDocumentLength )
-                        {
-                            return false;
-                        }
-                    }
-
-                    break;
-
-                /* Set the matching opening and closing characters of a JSON object or array.
-                 * The length calculation is performed below. */
-                case '{':
-                    openCharacter = '{';
-                    closeCharacter = '}';
-                    break;
-
-                case '[':
-                    openCharacter = '[';
-                    closeCharacter = ']';
-                    break;
-
-                /* Calculate the length of a JSON primitive. */
-                default:
-
-                    /* Skip the characters in the JSON value. The JSON value ends with a , or } */
-                    while( pJsonDocument[ i ] != ',' &&
-                           pJsonDocument[ i ] != '}' )
-                    {
-                        /* Any whitespace before a , or } means the JSON document is invalid. */
-                        if( ( pJsonDocument[ i ] == ' ' ) ||
-                            ( pJsonDocument[ i ] == '\n' ) ||
-                            ( pJsonDocument[ i ] == '\r' ) ||
-                            ( pJsonDocument[ i ] == '\t' ) )
-                        {
-                            return false;
-                        }
-
-                        i++;
-                        jsonValueLength++;
-
-                        /* If the end of the document is reached, this isn't a match. */
-                        if( i >= jsonDocumentLength )
-                        {
-                            return false;
-                        }
-                    }
-
-                    break;
-            }
-
-            /* Calculate the length of a JSON object or array. */
-            if( ( openCharacter != '\0' ) && ( closeCharacter != '\0' ) )
-            {
-                /* Include the length of the opening and closing characters. */
-                jsonValueLength = 2;
-
-                /* Skip the opening character. */
-                i++;
-
-                /* Add the length of all characters in the JSON object or array. This
-                 * includes the length of nested objects. */
-                while( pJsonDocument[ i ] != closeCharacter ||
-                       ( pJsonDocument[ i ] == closeCharacter && nestingLevel != 0 ) )
-                {
-                    /* An opening character starts a nested object. */
-                    if( pJsonDocument[ i ] == openCharacter )
-                    {
-                        nestingLevel++;
-                    }
-                    /* A closing character ends a nested object. */
-                    else if( pJsonDocument[ i ] == closeCharacter )
-                    {
-                        nestingLevel--;
-                    }
-
-                    i++;
-                    jsonValueLength++;
-
-                    /* If the end of the document is reached, this isn't a match. */
-                    if( i >= jsonDocumentLength )
-                    {
-                        return false;
-                    }
-                }
+                return false;
             }
 
             /* JSON value length calculated; set the output parameter. */
@@ -49,6 +49,9 @@
 #define _STRING_QUOTE                '"'
 #define _QUOTE_ESCAPE                '\\'
 
+/* Marks a token with no parent, i.e. the outermost container. */
+#define _NO_PARENT                   ( UINT32_MAX )
+
 #define _isValidContainer( decoder )                          \
     ( ( decoder ) &&                                          \
       ( decoder )->type >= IOT_SERIALIZER_CONTAINER_STREAM && \
@@ -81,10 +84,6 @@ static IotSerializerError_t _stepOut( IotSerializerDecoderIterator_t iterator,
 
 static void _destroy( IotSerializerDecoderObject_t * pDecoderObject );
 
-static void parseTextString( const char * pBuffer,
-                             const size_t bufLength,
-                             size_t * pOffset );
-
 IotSerializerDecodeInterface_t _IotSerializerJsonDecoder =
 {
     .init             = _init,
@@ -97,12 +96,32 @@ IotSerializerDecodeInterface_t _IotSerializerJsonDecoder =
     .destroy          = _destroy
 };
 
+struct _jsonDocument;
+
+/*
+ * A container is a map or array token of a tokenized document. Iterators are
+ * containers whose current member walks the children of the container token.
+ */
 typedef struct _jsonContainer
 {
-    const char * pStart;
-    size_t length;
+    struct _jsonDocument * pDocument; /* Document the container belongs to. */
+    uint32_t token;                   /* Index of the container token. */
+    uint32_t current;                 /* Index of the current child token when iterating. */
+    bool isRoot;                      /* Whether this is the outermost container of the document. */
 } _jsonContainer_t;
 
+/*
+ * A JSON document tokenized in one pass by _init. The token table follows this
+ * structure in the same allocation, unless it was supplied by the caller.
+ */
+typedef struct _jsonDocument
+{
+    _jsonContainer_t root;              /* The outermost container. */
+    const char * pBuffer;               /* The JSON text. */
+    IotSerializerJsonToken_t * pTokens; /* Token table. */
+    uint32_t tokenCount;                /* Number of tokens in pTokens. */
+} _jsonDocument_t;
+
 /*-----------------------------------------------------------*/
 
 static IotSerializerDataType_t _getTokenType( const char * pBuffer,
@@ -157,15 +176,17 @@ static IotSerializerDataType_t _getTokenType( const char * pBuffer,
 
 /*-----------------------------------------------------------*/
 
-static _jsonContainer_t * _createContainer( const char * pBuffer,
-                                            const size_t length )
+static _jsonContainer_t * _createContainer( _jsonDocument_t * pDocument,
+                                            uint32_t token )
 {
     _jsonContainer_t * pContainer = pvPortMalloc( sizeof( _jsonContainer_t ) );
 
     if( pContainer != NULL )
     {
-        pContainer->pStart = pBuffer;
-        pContainer->length = length;
+        pContainer->pDocument = pDocument;
+        pContainer->token = token;
+        pContainer->current = token + 1;
+        pContainer->isRoot = false;
     }
 
     return pContainer;
@@ -173,240 +194,310 @@ static _jsonContainer_t * _createContainer( const char * pBuffer,
 
 /*-----------------------------------------------------------*/
 
-static void _skipWhiteSpacesAndDelimeters( const char * pBuffer,
-                                           const size_t bufLength,
-                                           size_t * pOffset )
+static size_t _scalarEnd( const char * pBuffer,
+                          const size_t bufLength,
+                          size_t offset,
+                          IotSerializerDataType_t tokenType )
 {
-    size_t offset = *pOffset;
+    size_t end = bufLength;
 
-    for( ; offset < bufLength; offset++ )
+    switch( tokenType )
     {
-        if( ( pBuffer[ offset ] != ' ' ) &&
-            ( pBuffer[ offset ] != '\r' ) &&
-            ( pBuffer[ offset ] != '\n' ) &&
-            ( pBuffer[ offset ] != '\t' ) &&
-            ( pBuffer[ offset ] != ':' ) &&
-            ( pBuffer[ offset ] != ',' ) )
-        {
+        case IOT_SERIALIZER_SCALAR_TEXT_STRING:
+
+            /* Find the closing quote, skipping any escaped character. */
+            for( offset++; offset < bufLength; offset++ )
+            {
+                if( pBuffer[ offset ] == _QUOTE_ESCAPE )
+                {
+                    offset++;
+                }
+                else if( pBuffer[ offset ] == _STRING_QUOTE )
+                {
+                    end = offset + 1;
+                    break;
+                }
+            }
+
+            break;
+
+        case IOT_SERIALIZER_SCALAR_SIGNED_INT:
+
+            /*Skip -, + or first digit */
+            for( offset++; offset < bufLength; offset++ )
+            {
+                if( ( pBuffer[ offset ] < '0' ) ||
+                    ( pBuffer[ offset ] > '9' ) )
+                {
+                    break;
+                }
+            }
+
+            end = offset;
+            break;
+
+        case IOT_SERIALIZER_SCALAR_BOOL:
+
+            if( ( bufLength - offset >= 4 ) && ( strncmp( pBuffer + offset, "true", 4 ) == 0 ) )
+            {
+                end = offset + 4;
+            }
+            else if( ( bufLength - offset >= 5 ) && ( strncmp( pBuffer + offset, "false", 5 ) == 0 ) )
+            {
+                end = offset + 5;
+            }
+
+            break;
+
+        case IOT_SERIALIZER_SCALAR_NULL:
+
+            if( ( bufLength - offset >= 4 ) && ( strncmp( pBuffer + offset, "null", 4 ) == 0 ) )
+            {
+                end = offset + 4;
+            }
+
+            break;
+
+        default:
             break;
-        }
     }
 
-    *pOffset = offset;
+    /* bufLength is returned for a truncated or malformed scalar. */
+    return end;
 }
 
 /*-----------------------------------------------------------*/
-static void parseContainer( const char * pBuffer,
-                            const size_t bufLength,
-                            size_t * pOffset,
-                            const char containerStopChar )
+
+/*
+ * Tokenize a JSON container in a single pass. Tokens are stored in document
+ * order; each token records the index of the token following it and all of
+ * its children, so siblings can be visited without rescanning the text.
+ * While a container is open, its next member holds the index of its parent.
+ *
+ * If pTokens is NULL, the tokens are only counted.
+ */
+static IotSerializerError_t _tokenize( const char * pBuffer,
+                                       const size_t bufLength,
+                                       IotSerializerJsonToken_t * pTokens,
+                                       size_t maxTokens,
+                                       uint32_t * pTokenCount )
 {
-    size_t offset = *pOffset;
+    IotSerializerError_t error = IOT_SERIALIZER_SUCCESS;
+    IotSerializerDataType_t tokenType = IOT_SERIALIZER_UNDEFINED;
+    uint32_t count = 0, parent = _NO_PARENT, depth = 0;
+    size_t offset = 0, end = 0;
+    bool done = false;
 
-    for( ; offset < bufLength && pBuffer[ offset ] != containerStopChar; offset++ )
+    while( ( offset < bufLength ) && ( done == false ) && ( error == IOT_SERIALIZER_SUCCESS ) )
     {
         switch( pBuffer[ offset ] )
         {
-            case _START_CHAR_MAP:
+            case ' ':
+            case '\r':
+            case '\n':
+            case '\t':
+            case ':':
+            case ',':
                 offset++;
-                parseContainer( pBuffer, bufLength, &offset, _STOP_CHAR_MAP );
                 break;
 
-            case _START_CHAR_ARRAY:
-                offset++;
-                parseContainer( pBuffer, bufLength, &offset, _STOP_CHAR_ARRAY );
-                break;
+            case _STOP_CHAR_MAP:
+            case _STOP_CHAR_ARRAY:
+
+                if( depth == 0 )
+                {
+                    error = IOT_SERIALIZER_INVALID_INPUT;
+                    break;
+                }
+
+                if( pTokens != NULL )
+                {
+                    /* The closing character must match the open container. */
+                    if( ( pTokens[ parent ].type == IOT_SERIALIZER_CONTAINER_MAP ) !=
+                        ( pBuffer[ offset ] == _STOP_CHAR_MAP ) )
+                    {
+                        error = IOT_SERIALIZER_INVALID_INPUT;
+                        break;
+                    }
+
+                    pTokens[ parent ].end = ( uint32_t ) ( offset + 1 );
+                    end = pTokens[ parent ].next;
+                    pTokens[ parent ].next = count;
+                    parent = ( uint32_t ) end;
+                }
 
-            case _STRING_QUOTE:
+                depth--;
                 offset++;
-                parseTextString( pBuffer, bufLength, &offset );
+
+                /* Stop once the outermost container is closed. */
+                done = ( depth == 0 );
                 break;
-        }
-    }
 
-    *pOffset = offset;
-}
+            default:
+                tokenType = _getTokenType( pBuffer, offset );
 
-/*-----------------------------------------------------------*/
+                if( ( tokenType == IOT_SERIALIZER_UNDEFINED ) ||
+                    ( ( depth == 0 ) && ( count > 0 ) ) )
+                {
+                    error = IOT_SERIALIZER_INVALID_INPUT;
+                    break;
+                }
 
-static int64_t parseNumber( const char * pBuffer,
-                            const size_t bufLength,
-                            size_t * pOffset )
-{
-    size_t offset = *pOffset;
-    int64_t val = atoi( pBuffer + offset );
+                if( ( pTokens != NULL ) && ( count >= maxTokens ) )
+                {
+                    error = IOT_SERIALIZER_BUFFER_TOO_SMALL;
+                    break;
+                }
 
-    /*Skip -, + or first digit */
-    offset++;
+                if( ( tokenType == IOT_SERIALIZER_CONTAINER_MAP ) ||
+                    ( tokenType == IOT_SERIALIZER_CONTAINER_ARRAY ) )
+                {
+                    if( pTokens != NULL )
+                    {
+                        pTokens[ count ].start = ( uint32_t ) offset;
+                        pTokens[ count ].end = 0;
+                        pTokens[ count ].next = parent;
+                        pTokens[ count ].type = ( uint32_t ) tokenType;
+                        parent = count;
+                    }
 
-    for( ; offset < bufLength; offset++ )
-    {
-        if( ( pBuffer[ offset ] < '0' ) ||
-            ( pBuffer[ offset ] > '9' ) )
-        {
-            break;
+                    depth++;
+                    offset++;
+                }
+                else
+                {
+                    end = _scalarEnd( pBuffer, bufLength, offset, tokenType );
+
+                    if( end >= bufLength )
+                    {
+                        error = IOT_SERIALIZER_INVALID_INPUT;
+                        break;
+                    }
+
+                    if( pTokens != NULL )
+                    {
+                        pTokens[ count ].start = ( uint32_t ) offset;
+                        pTokens[ count ].end = ( uint32_t ) end;
+                        pTokens[ count ].next = count + 1;
+                        pTokens[ count ].type = ( uint32_t ) tokenType;
+                    }
+
+                    offset = end;
+                }
+
+                count++;
+                break;
         }
     }
 
-    *pOffset = offset;
+    /* Every container must be closed. */
+    if( ( error == IOT_SERIALIZER_SUCCESS ) && ( done == false ) )
+    {
+        error = IOT_SERIALIZER_INVALID_INPUT;
+    }
+
+    *pTokenCount = count;
 
-    return val;
+    return error;
 }
 
 /*-----------------------------------------------------------*/
 
-static void parseTextString( const char * pBuffer,
-                             const size_t bufLength,
-                             size_t * pOffset )
-
+static int64_t _parseNumber( const char * pBuffer,
+                             const IotSerializerJsonToken_t * pToken )
 {
-    size_t offset = *pOffset;
+    uint32_t offset = pToken->start;
+    bool negative = false;
+    int64_t val = 0;
 
-    for( ; offset < bufLength && pBuffer[ offset ] != _STRING_QUOTE; offset++ )
+    if( pBuffer[ offset ] == '-' )
     {
-        /* Backslash: Quoted symbol expected */
-        if( ( offset < bufLength - 1 ) &&
-            ( pBuffer[ offset ] == _QUOTE_ESCAPE ) &&
-            ( pBuffer[ offset + 1 ] == _STRING_QUOTE ) )
-        {
-            offset++;
-        }
+        negative = true;
+        offset++;
+    }
+
+    /* Digits beyond the length of the largest int64 are ignored. */
+    for( ; ( offset < pToken->end ) && ( offset - pToken->start < _JSON_INT64_MAX_LENGTH ); offset++ )
+    {
+        val = ( val * 10 ) + ( pBuffer[ offset ] - '0' );
     }
 
-    *pOffset = offset;
+    return ( negative == true ) ? -val : val;
 }
 
 /*-----------------------------------------------------------*/
 
-static IotSerializerError_t parseTokenValue( const char * pBuffer,
-                                             const size_t bufLength,
-                                             size_t * pOffset,
-                                             IotSerializerDataType_t tokenType,
-                                             IotSerializerDecoderObject_t * pValue )
+static IotSerializerError_t _getTokenValue( _jsonDocument_t * pDocument,
+                                            uint32_t token,
+                                            IotSerializerDecoderObject_t * pValue )
 {
     IotSerializerError_t error = IOT_SERIALIZER_SUCCESS;
+    const IotSerializerJsonToken_t * pToken = &( pDocument->pTokens[ token ] );
+    IotSerializerDataType_t tokenType = ( IotSerializerDataType_t ) pToken->type;
 
     switch( tokenType )
     {
         case IOT_SERIALIZER_CONTAINER_MAP:
-           {
-               size_t start = ++( *pOffset ), length;
-               parseContainer( pBuffer, bufLength, pOffset, _STOP_CHAR_MAP );
-               length = ( *pOffset - start ) + 1; /* Include MAP stop char in the length */
-
-               if( pValue )
-               {
-                   pValue->type = tokenType;
-                   pValue->u.pHandle = _createContainer( ( pBuffer + start ), length );
-               }
-
-               ( *pOffset )++; /* Skip past the token */
-               break;
-           }
-
         case IOT_SERIALIZER_CONTAINER_ARRAY:
-           {
-               size_t start = ++( *pOffset ), length;
-               parseContainer( pBuffer, bufLength, pOffset, _STOP_CHAR_ARRAY );
-               length = ( *pOffset - start ) + 1; /* Include array stop char ']' in the length */
+            pValue->type = tokenType;
+            pValue->u.pHandle = _createContainer( pDocument, token );
 
-               if( pValue )
-               {
-                   pValue->type = tokenType;
-                   pValue->u.pHandle = _createContainer( ( pBuffer + start ), length );
-               }
+            if( pValue->u.pHandle == NULL )
+            {
+                error = IOT_SERIALIZER_OUT_OF_MEMORY;
+            }
 
-               ( *pOffset )++; /* Skip past the token after parsing */
-               break;
-           }
+            break;
 
         case IOT_SERIALIZER_SCALAR_SIGNED_INT:
-           {
-               int64_t val = parseNumber( pBuffer, bufLength, pOffset );
-
-               if( pValue )
-               {
-                   pValue->type = tokenType;
-                   pValue->u.value.u.signedInt = val;
-               }
-
-               break;
-           }
+            pValue->type = tokenType;
+            pValue->u.value.u.signedInt = _parseNumber( pDocument->pBuffer, pToken );
+            break;
 
         case IOT_SERIALIZER_SCALAR_BOOL:
-           {
-               bool val;
-
-               if( pBuffer[ *pOffset ] == 't' )
-               {
-                   val = true;
-                   ( *pOffset ) += 5; /* Skip past the token after parsing  */
-               }
-               else
-               {
-                   val = false;
-                   ( *pOffset ) += 6; /* Skip past the token after parsing */
-               }
-
-               if( pValue != NULL )
-               {
-                   pValue->type = tokenType;
-                   pValue->u.value.u.booleanValue = val;
-               }
-
-               break;
-           }
+            pValue->type = tokenType;
+            pValue->u.value.u.booleanValue = ( pDocument->pBuffer[ pToken->start ] == 't' );
+            break;
 
         case IOT_SERIALIZER_SCALAR_NULL:
-            *pOffset += 5; /* Skip past the token after parsing */
-
-            if( pValue != NULL )
-            {
-                pValue->type = tokenType;
-            }
-
+            pValue->type = tokenType;
             break;
 
-        case IOT_SERIALIZER_SCALAR_BYTE_STRING:
         case IOT_SERIALIZER_SCALAR_TEXT_STRING:
            {
-               size_t start = ++( *pOffset ), length;
+               /* Don't include the quotes of a string */
+               const char * pString = pDocument->pBuffer + pToken->start + 1;
+               size_t length = pToken->end - pToken->start - 2;
                int decodeRet;
-               parseTextString( pBuffer, bufLength, pOffset );
-               length = ( *pOffset ) - start; /* Don't include the last quotes of a string */
 
-               if( pValue != NULL )
+               if( pValue->type == IOT_SERIALIZER_SCALAR_BYTE_STRING )
                {
-                   if( pValue->type == IOT_SERIALIZER_SCALAR_BYTE_STRING )
-                   {
-                       decodeRet = mbedtls_base64_decode( ( unsigned char * ) ( pValue->u.value.u.string.pString ),
-                                                          pValue->u.value.u.string.length,
-                                                          &( pValue->u.value.u.string.length ),
-                                                          ( const unsigned char * ) ( pBuffer + start ), length );
-
-                       switch( decodeRet )
-                       {
-                           case MBEDTLS_ERR_BASE64_INVALID_CHARACTER:
-                               error = IOT_SERIALIZER_INTERNAL_FAILURE;
-                               break;
-
-                           case MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL:
-                               error = IOT_SERIALIZER_BUFFER_TOO_SMALL;
-                               break;
-
-                           default:
-                               break;
-                       }
-                   }
-                   else
+                   decodeRet = mbedtls_base64_decode( ( unsigned char * ) ( pValue->u.value.u.string.pString ),
+                                                      pValue->u.value.u.string.length,
+                                                      &( pValue->u.value.u.string.length ),
+                                                      ( const unsigned char * ) pString, length );
+
+                   switch( decodeRet )
                    {
-                       pValue->type = tokenType;
-                       pValue->u.value.u.string.pString = ( uint8_t * ) ( pBuffer + start );
-                       pValue->u.value.u.string.length = length;
+                       case MBEDTLS_ERR_BASE64_INVALID_CHARACTER:
+                           error = IOT_SERIALIZER_INTERNAL_FAILURE;
+                           break;
+
+                       case MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL:
+                           error = IOT_SERIALIZER_BUFFER_TOO_SMALL;
+                           break;
+
+                       default:
+                           break;
                    }
                }
+               else
+               {
+                   pValue->type = tokenType;
+                   pValue->u.value.u.string.pString = ( uint8_t * ) pString;
+                   pValue->u.value.u.string.length = length;
+               }
 
-               ( *pOffset )++; /* Skip past the token after parsing */
                break;
            }
 
@@ -425,128 +516,52 @@ static IotSerializerError_t _findKeyValue( _jsonContainer_t * pObject,
                                            size_t keyLength,
                                            IotSerializerDecoderObject_t * pValue )
 {
-    size_t offset = 0;
-    IotSerializerDataType_t tokenType;
-    IotSerializerDecoderObject_t key = { .type = IOT_SERIALIZER_SCALAR_TEXT_STRING };
+    const _jsonDocument_t * pDocument = pObject->pDocument;
+    const IotSerializerJsonToken_t * pTokens = pDocument->pTokens;
+    uint32_t token = pObject->token + 1, valueToken = 0;
+    const uint32_t end = pTokens[ pObject->token ].next;
     IotSerializerError_t ret = IOT_SERIALIZER_NOT_FOUND;
 
-    ( void ) keyLength;
-
-    bool isValue = false;
-    bool isKeyFound = false;
-
-    _skipWhiteSpacesAndDelimeters( pObject->pStart, pObject->length, &offset );
-
-    for( ; ( offset < pObject->length ) && ( pObject->pStart[ offset ] != '}' ) && ( ret == IOT_SERIALIZER_NOT_FOUND ); )
+    /* Visit each key-value pair of the map. Nested containers are skipped
+     * without being rescanned. */
+    while( ( token < end ) && ( ret == IOT_SERIALIZER_NOT_FOUND ) )
     {
-        tokenType = _getTokenType( pObject->pStart, offset );
+        valueToken = pTokens[ token ].next;
 
-        switch( tokenType )
+        /* JSON key can only be text string, and must have a value. */
+        if( ( pTokens[ token ].type != IOT_SERIALIZER_SCALAR_TEXT_STRING ) ||
+            ( valueToken >= end ) )
         {
-            case IOT_SERIALIZER_CONTAINER_MAP:
-            case IOT_SERIALIZER_CONTAINER_ARRAY:
-            case IOT_SERIALIZER_SCALAR_SIGNED_INT:
-            case IOT_SERIALIZER_SCALAR_BOOL:
-            case IOT_SERIALIZER_SCALAR_NULL:
-            case IOT_SERIALIZER_SCALAR_BYTE_STRING:
-
-                /* JSON key can only be text string, so return error */
-                if( isValue )
-                {
-                    /* If key parsed successfully, parse and store the value, else skip past the JSON value */
-                    if( isKeyFound )
-                    {
-                        ret = parseTokenValue( pObject->pStart, pObject->length, &offset, tokenType, pValue );
-                    }
-                    else
-                    {
-                        ( void ) parseTokenValue( pObject->pStart, pObject->length, &offset, tokenType, NULL );
-
-                        /* Skip any white space characters or delimeters after the token */
-                        _skipWhiteSpacesAndDelimeters( pObject->pStart, pObject->length, &offset );
-
-                        /* Set isValue to false as we are expecting a key now */
-                        isValue = false;
-                    }
-                }
-                else
-                {
-                    ret = IOT_SERIALIZER_INTERNAL_FAILURE;
-                }
-
-                break;
-
-            case IOT_SERIALIZER_SCALAR_TEXT_STRING:
-
-                if( !isValue )
-                {
-                    /*
-                     * Parser is expecting a key. Parse the JSON key and compare with the
-                     * input key provided.
-                     */
-                    ( void ) parseTokenValue( pObject->pStart, pObject->length, &offset, tokenType, &key );
-
-                    if( strncmp( pKey, ( const char * ) key.u.value.u.string.pString, key.u.value.u.string.length ) == 0 )
-                    {
-                        isKeyFound = true;
-                    }
-
-                    /* Set the isValue to true as the parser expects a value now */
-                    isValue = true;
-                }
-                else
-                {
-                    /*
-                     * Parser is expecting a value. If key already found, parse and store the value.
-                     * Else skip the value.
-                     */
-                    if( isKeyFound )
-                    {
-                        /* If key already found, store the string as value, and return success */
-                        ret = parseTokenValue( pObject->pStart, pObject->length, &offset, tokenType, pValue );
-                    }
-                    else
-                    {
-                        /* Skip the value */
-                        ( void ) parseTokenValue( pObject->pStart, pObject->length, &offset, tokenType, NULL );
-                    }
-
-                    /* Set the isValue to true as the parser expects a key now */
-                    isValue = false;
-                }
-
-                /* Skip any white space characters or delimeters */
-                _skipWhiteSpacesAndDelimeters( pObject->pStart, pObject->length, &offset );
-                break;
-
-            default:
-                /* Any other character other than start of a token is an invalid character */
-                ret = IOT_SERIALIZER_INTERNAL_FAILURE;
+            ret = IOT_SERIALIZER_INVALID_INPUT;
+        }
+        else if( ( pTokens[ token ].end - pTokens[ token ].start - 2 == keyLength ) &&
+                 ( strncmp( pKey, pDocument->pBuffer + pTokens[ token ].start + 1, keyLength ) == 0 ) )
+        {
+            ret = _getTokenValue( pObject->pDocument, valueToken, pValue );
+        }
+        else
+        {
+            token = pTokens[ valueToken ].next;
         }
-    }
-
-    /*
-     * If offset went past the container during parsing, return error.
-     */
-    if( offset >= pObject->length )
-    {
-        ret = IOT_SERIALIZER_INVALID_INPUT;
     }
 
     return ret;
 }
 
-
 /*-----------------------------------------------------------*/
 
-static IotSerializerError_t _init( IotSerializerDecoderObject_t * pDecoderObject,
-                                   const uint8_t * pDataBuffer,
-                                   size_t maxSize )
+static IotSerializerError_t _initDocument( IotSerializerDecoderObject_t * pDecoderObject,
+                                           const uint8_t * pDataBuffer,
+                                           size_t maxSize,
+                                           IotSerializerJsonToken_t * pTokenBuffer,
+                                           size_t tokenBufferCount )
 {
     IotSerializerDataType_t tokenType;
-    _jsonContainer_t * pContainer;
+    _jsonDocument_t * pDocument = NULL;
+    IotSerializerJsonToken_t * pTokens = pTokenBuffer;
     const char * pStart = ( const char * ) pDataBuffer;
     size_t length = strlen( pStart );
+    uint32_t tokenCount = 0;
     IotSerializerError_t error = IOT_SERIALIZER_SUCCESS;
 
     length = ( length < maxSize ) ? length : maxSize;
@@ -560,24 +575,94 @@ static IotSerializerError_t _init( IotSerializerDecoderObject_t * pDecoderObject
         error = IOT_SERIALIZER_INVALID_INPUT;
     }
 
-    if( error == IOT_SERIALIZER_SUCCESS )
+    /* Without a caller-supplied token table, count the tokens and allocate
+     * the table with the document. */
+    if( ( error == IOT_SERIALIZER_SUCCESS ) && ( pTokens == NULL ) )
     {
-        pContainer = _createContainer( pStart + 1, length - 1 );
+        error = _tokenize( pStart, length, NULL, 0, &tokenCount );
 
-        if( pContainer != NULL )
+        if( error == IOT_SERIALIZER_SUCCESS )
         {
-            pDecoderObject->type = tokenType;
-            pDecoderObject->u.pHandle = ( void * ) pContainer;
+            pDocument = pvPortMalloc( sizeof( _jsonDocument_t ) +
+                                      ( tokenCount * sizeof( IotSerializerJsonToken_t ) ) );
+
+            if( pDocument != NULL )
+            {
+                pTokens = ( IotSerializerJsonToken_t * ) ( pDocument + 1 );
+                tokenBufferCount = tokenCount;
+            }
+            else
+            {
+                error = IOT_SERIALIZER_OUT_OF_MEMORY;
+            }
         }
-        else
+    }
+    else if( error == IOT_SERIALIZER_SUCCESS )
+    {
+        pDocument = pvPortMalloc( sizeof( _jsonDocument_t ) );
+
+        if( pDocument == NULL )
         {
             error = IOT_SERIALIZER_OUT_OF_MEMORY;
         }
     }
 
+    if( error == IOT_SERIALIZER_SUCCESS )
+    {
+        error = _tokenize( pStart, length, pTokens, tokenBufferCount, &tokenCount );
+    }
+
+    if( error == IOT_SERIALIZER_SUCCESS )
+    {
+        pDocument->pBuffer = pStart;
+        pDocument->pTokens = pTokens;
+        pDocument->tokenCount = tokenCount;
+        pDocument->root.pDocument = pDocument;
+        pDocument->root.token = 0;
+        pDocument->root.current = 1;
+        pDocument->root.isRoot = true;
+
+        pDecoderObject->type = tokenType;
+        pDecoderObject->u.pHandle = ( void * ) &( pDocument->root );
+    }
+    else if( pDocument != NULL )
+    {
+        vPortFree( pDocument );
+    }
+
     return error;
 }
 
+/*-----------------------------------------------------------*/
+
+static IotSerializerError_t _init( IotSerializerDecoderObject_t * pDecoderObject,
+                                   const uint8_t * pDataBuffer,
+                                   size_t maxSize )
+{
+    return _initDocument( pDecoderObject, pDataBuffer, maxSize, NULL, 0 );
+}
+
+/*-----------------------------------------------------------*/
+
+IotSerializerError_t IotSerializer_InitJsonDecoderWithTokens( IotSerializerDecoderObject_t * pDecoderObject,
+                                                             const uint8_t * pDataBuffer,
+                                                             size_t maxSize,
+                                                             IotSerializerJsonToken_t * pTokenBuffer,
+                                                             size_t tokenBufferCount )
+{
+    IotSerializerError_t error = IOT_SERIALIZER_SUCCESS;
+
+    if( ( pTokenBuffer == NULL ) || ( tokenBufferCount == 0 ) )
+    {
+        error = IOT_SERIALIZER_INVALID_INPUT;
+    }
+    else
+    {
+        error = _initDocument( pDecoderObject, pDataBuffer, maxSize, pTokenBuffer, tokenBufferCount );
+    }
+
+    return error;
+}
 
 /*-----------------------------------------------------------*/
 
@@ -612,45 +697,35 @@ static IotSerializerError_t _stepIn( IotSerializerDecoderObject_t * pDecoderObje
 {
     IotSerializerDecoderObject_t * pNewObject;
     _jsonContainer_t * pContainer, * pNewContainer;
-    size_t offset = 0;
     IotSerializerError_t error = IOT_SERIALIZER_SUCCESS;
 
     if( _isValidContainer( pDecoderObject ) )
     {
         pContainer = pDecoderObject->u.pHandle;
 
-        _skipWhiteSpacesAndDelimeters( pContainer->pStart, pContainer->length, &offset );
+        /* The iterator starts at the first child of the container token. */
+        pNewContainer = _createContainer( pContainer->pDocument, pContainer->token );
 
-        if( offset >= pContainer->length )
+        if( pNewContainer != NULL )
         {
-            error = IOT_SERIALIZER_INTERNAL_FAILURE;
-        }
+            pNewObject = pvPortMalloc( sizeof( IotSerializerDecoderObject_t ) );
 
-        if( error == IOT_SERIALIZER_SUCCESS )
-        {
-            pNewContainer = _createContainer( ( pContainer->pStart + offset ), pContainer->length - offset );
-
-            if( pNewContainer != NULL )
+            if( pNewObject != NULL )
             {
-                pNewObject = pvPortMalloc( sizeof( IotSerializerDecoderObject_t ) );
-
-                if( pNewObject != NULL )
-                {
-                    pNewObject->type = pDecoderObject->type;
-                    pNewObject->u.pHandle = pNewContainer;
-                    *pIterator = ( IotSerializerDecoderIterator_t ) pNewObject;
-                }
-                else
-                {
-                    vPortFree( pNewContainer );
-                    error = IOT_SERIALIZER_OUT_OF_MEMORY;
-                }
+                pNewObject->type = pDecoderObject->type;
+                pNewObject->u.pHandle = pNewContainer;
+                *pIterator = ( IotSerializerDecoderIterator_t ) pNewObject;
             }
             else
             {
+                vPortFree( pNewContainer );
                 error = IOT_SERIALIZER_OUT_OF_MEMORY;
             }
         }
+        else
+        {
+            error = IOT_SERIALIZER_OUT_OF_MEMORY;
+        }
     }
     else
     {
@@ -662,27 +737,9 @@ static IotSerializerError_t _stepIn( IotSerializerDecoderObject_t * pDecoderObje
 
 /*-----------------------------------------------------------*/
 
-static bool _isEOF( const char * pBuffer,
-                    IotSerializerDataType_t containerType )
+static bool _isEOF( const _jsonContainer_t * pContainer )
 {
-    bool isEOF;
-
-    switch( containerType )
-    {
-        case IOT_SERIALIZER_CONTAINER_MAP:
-            isEOF = ( pBuffer[ 0 ] == '}' );
-            break;
-
-        case IOT_SERIALIZER_CONTAINER_ARRAY:
-            isEOF = ( pBuffer[ 0 ] == ']' );
-            break;
-
-        default:
-            isEOF = false;
-            break;
-    }
-
-    return isEOF;
+    return pContainer->current >= pContainer->pDocument->pTokens[ pContainer->token ].next;
 }
 
 /*-----------------------------------------------------------*/
@@ -696,7 +753,7 @@ static bool _isEndOfContainer( IotSerializerDecoderIterator_t iterator )
     if( _isValidContainer( pObject ) )
     {
         pContainer = pObject->u.pHandle;
-        ret = _isEOF( pContainer->pStart, pObject->type );
+        ret = _isEOF( pContainer );
     }
 
     return ret;
@@ -709,27 +766,19 @@ static IotSerializerError_t _get( IotSerializerDecoderIterator_t iterator,
 {
     IotSerializerDecoderObject_t * pDecoder = ( IotSerializerDecoderObject_t * ) iterator;
     _jsonContainer_t * pContainer;
-    IotSerializerDataType_t type;
-    size_t offset = 0;
     IotSerializerError_t error = IOT_SERIALIZER_SUCCESS;
 
     if( _isValidContainer( pDecoder ) )
     {
         pContainer = _castDecoderIteratorToJsonContainer( iterator );
-        type = _getTokenType( pContainer->pStart, offset );
 
-        if( type != IOT_SERIALIZER_UNDEFINED )
+        if( _isEOF( pContainer ) == false )
         {
-            parseTokenValue( pContainer->pStart, pContainer->length, &offset, type, pValueObject );
-
-            if( offset >= pContainer->length )
-            {
-                error = IOT_SERIALIZER_BUFFER_TOO_SMALL;
-            }
+            error = _getTokenValue( pContainer->pDocument, pContainer->current, pValueObject );
         }
         else
         {
-            error = IOT_SERIALIZER_INTERNAL_FAILURE;
+            error = IOT_SERIALIZER_BUFFER_TOO_SMALL;
         }
     }
     else
@@ -747,20 +796,16 @@ static IotSerializerError_t _next( IotSerializerDecoderIterator_t iterator )
 {
     IotSerializerDecoderObject_t * pObject = ( IotSerializerDecoderObject_t * ) iterator;
     _jsonContainer_t * pContainer;
-    IotSerializerDataType_t type;
-    size_t offset = 0;
     IotSerializerError_t error = IOT_SERIALIZER_SUCCESS;
 
     if( _isValidContainer( pObject ) )
     {
         pContainer = pObject->u.pHandle;
-        type = _getTokenType( pContainer->pStart, offset );
-        parseTokenValue( pContainer->pStart, pContainer->length, &offset, type, NULL );
-        _skipWhiteSpacesAndDelimeters( pContainer->pStart, pContainer->length, &offset );
 
-        if( offset < pContainer->length )
+        /* Skip the current token and all of its children. */
+        if( _isEOF( pContainer ) == false )
         {
-            pContainer->pStart += offset;
+            pContainer->current = pContainer->pDocument->pTokens[ pContainer->current ].next;
         }
         else
         {
@@ -789,9 +834,9 @@ static IotSerializerError_t _stepOut( IotSerializerDecoderIterator_t iterator,
         pContainer = pDecoderObject->u.pHandle;
         pIterContainer = pIterObject->u.pHandle;
 
-        if( _isEOF( pIterContainer->pStart, pIterObject->type ) )
+        if( _isEOF( pIterContainer ) )
         {
-            pContainer->pStart = ( pIterContainer->pStart + 1 );
+            pContainer->current = pIterContainer->current;
             vPortFree( pIterContainer );
             vPortFree( pIterObject );
         }
@@ -812,11 +857,17 @@ static IotSerializerError_t _stepOut( IotSerializerDecoderIterator_t iterator,
 
 static void _destroy( IotSerializerDecoderObject_t * pDecoderObject )
 {
+    _jsonContainer_t * pContainer;
+
     if( _isValidContainer( pDecoderObject ) )
     {
         if( pDecoderObject->u.pHandle != NULL )
         {
-            vPortFree( pDecoderObject->u.pHandle );
+            pContainer = pDecoderObject->u.pHandle;
+
+            /* The outermost container is the first member of its document,
+             * which also holds any allocated token table. */
+            vPortFree( pContainer->isRoot ? ( void * ) pContainer->pDocument : ( void * ) pContainer );
             pDecoderObject->u.pHandle = NULL;
         }
     }
@@ -23,6 +23,12 @@
  * http://www.FreeRTOS.org
  */
 
+/* Standard includes. */
+#include <string.h>
+
+/* Platform layer includes. */
+#include "platform/iot_clock.h"
+
 /* Unity framework includes. */
 #include "unity_fixture.h"
 #include "unity.h"
@@ -50,6 +56,42 @@ static const uint8_t test_data[] =
 
 static const uint16_t test_data_length = sizeof( test_data ) / sizeof( test_data[ 0 ] );
 
+/* A job document of the shape received by the OTA agent. */
+static const uint8_t job_document[] =
+    "{"
+    "\"clientToken\":\"0:testclient\","
+    "\"timestamp\":1540854733,"
+    "\"execution\":{"
+    "\"jobId\":\"AFR_OTA-testjob20181029\","
+    "\"status\":\"QUEUED\","
+    "\"queuedAt\":1540854731,"
+    "\"lastUpdatedAt\":1540854731,"
+    "\"versionNumber\":1,"
+    "\"executionNumber\":1,"
+    "\"jobDocument\":{"
+    "\"afr_ota\":{"
+    "\"streamname\":\"AFR_OTA-f1ac9b5e-0e56-4d31-b9d5-6b3a2cf2a8b5\","
+    "\"files\":[{"
+    "\"filepath\":\"/device/platform\","
+    "\"filesize\":180568,"
+    "\"fileid\":0,"
+    "\"certfile\":\"rsasigner.crt\","
+    "\"update_data_url\":null,"
+    "\"auth_scheme\":null,"
+    "\"sig-sha256-rsa\":\"IHLnP6+CbMgvTHq6RMvyvAdQ3Glt5sB3S3/5Hde/cZoD4PlOqdGnaHgJUtfG9n8WPzAQO3EXrx06IgqHdC4Avh7lcLW8yF7x1TJuAhg52oK6Tq0Ls7/ZX+lhXO4kuePq/ehvTh9IKCrLtD4Qnv0EKNmYNjz2D/LTNZuNVZmsiNFe8qVUoelzjSy2UQu4RjjYgwCg3GLm6RJv0I5a/o5+FxR6KFnIvl0GaTX7HmA6ucmtJfdiAN5nsfmgmxqdR4UeGYm9bOhfdg9FZNjLGkdWF0DHvZ+q6QBtUeZd0JxmXl9cGCNI5AH1njUqO3bzjEvxf7A5ULQNDz7TUHH9L7Yr+qzJiQ==\","
+    "\"attr\":3"
+    "}]"
+    "}"
+    "}"
+    "}"
+    "}";
+
+/* Number of tokens in job_document. */
+#define JOB_DOCUMENT_TOKEN_COUNT    ( 44 )
+
+/* Number of times job_document is decoded by the benchmark. */
+#define JOB_DOCUMENT_ITERATIONS     ( 10000 )
+
 TEST_GROUP( Full_Serializer_JSON_deserialize );
 
 TEST_SETUP( Full_Serializer_JSON_deserialize )
@@ -76,6 +118,10 @@ TEST_GROUP_RUNNER( Full_Serializer_JSON_deserialize )
     RUN_TEST_CASE( Full_Serializer_JSON_deserialize, find_key_object_value );
     RUN_TEST_CASE( Full_Serializer_JSON_deserialize, find_key_array_of_objects_value );
     RUN_TEST_CASE( Full_Serializer_JSON_deserialize, find_nested_key_array_of_objects_value );
+    RUN_TEST_CASE( Full_Serializer_JSON_deserialize, iterate_array_of_objects );
+    RUN_TEST_CASE( Full_Serializer_JSON_deserialize, init_with_tokens );
+    RUN_TEST_CASE( Full_Serializer_JSON_deserialize, init_malformed_document );
+    RUN_TEST_CASE( Full_Serializer_JSON_deserialize, decode_job_document_throughput );
 }
 
 TEST( Full_Serializer_JSON_deserialize, find_key_string_value )
@@ -121,3 +167,202 @@ TEST( Full_Serializer_JSON_deserialize, find_nested_key_array_of_objects_value )
 
     _decoder.destroy( &nestedObject );
 }
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Decode the file fields of job_document, as the OTA agent does.
+ */
+static void _decodeJobDocument( IotSerializerDecoderObject_t * pDocument )
+{
+    IotSerializerDecoderObject_t execution = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    IotSerializerDecoderObject_t jobDocument = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    IotSerializerDecoderObject_t afrOta = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    IotSerializerDecoderObject_t files = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    IotSerializerDecoderObject_t file = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    IotSerializerDecoderObject_t value = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    IotSerializerDecoderIterator_t iterator = IOT_SERIALIZER_DECODER_ITERATOR_INITIALIZER;
+
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( pDocument, "execution", &execution ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &execution, "jobDocument", &jobDocument ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &jobDocument, "afr_ota", &afrOta ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &afrOta, "files", &files ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_CONTAINER_ARRAY, files.type );
+
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.stepIn( &files, &iterator ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.get( iterator, &file ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_CONTAINER_MAP, file.type );
+
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &file, "filesize", &value ) );
+    TEST_ASSERT_EQUAL( 180568, value.u.value.u.signedInt );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &file, "attr", &value ) );
+    TEST_ASSERT_EQUAL( 3, value.u.value.u.signedInt );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &file, "sig-sha256-rsa", &value ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SCALAR_TEXT_STRING, value.type );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_NOT_FOUND, _decoder.find( &file, "filepath2", &value ) );
+
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.next( iterator ) );
+    TEST_ASSERT_TRUE( _decoder.isEndOfContainer( iterator ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.stepOut( iterator, &files ) );
+
+    _decoder.destroy( &file );
+    _decoder.destroy( &files );
+    _decoder.destroy( &afrOta );
+    _decoder.destroy( &jobDocument );
+    _decoder.destroy( &execution );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Print the throughput of decoding job_document.
+ */
+static void _printThroughput( const char * pName,
+                              uint64_t elapsedMs )
+{
+    uint64_t bytes = ( uint64_t ) strlen( ( const char * ) job_document ) * JOB_DOCUMENT_ITERATIONS;
+
+    /* Avoid dividing by zero on fast platforms. */
+    if( elapsedMs == 0 )
+    {
+        elapsedMs = 1;
+    }
+
+    UnityPrint( pName );
+    UnityPrint( ": decoded " );
+    UnityPrintNumber( ( UNITY_INT ) bytes );
+    UnityPrint( " bytes in " );
+    UnityPrintNumber( ( UNITY_INT ) elapsedMs );
+    UnityPrint( " ms (" );
+    UnityPrintNumber( ( UNITY_INT ) ( ( bytes * 1000 ) / elapsedMs ) );
+    UnityPrint( " bytes/s)." );
+    UNITY_PRINT_EOL();
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_Serializer_JSON_deserialize, iterate_array_of_objects )
+{
+    const char * const names[] = { "xQueue", "pvItemToQueue", "xTicksToWait" };
+    IotSerializerDecoderIterator_t iterator = IOT_SERIALIZER_DECODER_ITERATOR_INITIALIZER;
+    IotSerializerDecoderObject_t parameter = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    IotSerializerDecoderObject_t value = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    int64_t index = 0;
+
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &rootObject, "parameters", &childObject ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.stepIn( &childObject, &iterator ) );
+
+    while( _decoder.isEndOfContainer( iterator ) == false )
+    {
+        TEST_ASSERT_TRUE( index < 3 );
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.get( iterator, &parameter ) );
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_CONTAINER_MAP, parameter.type );
+
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &parameter, "name", &value ) );
+        TEST_ASSERT_EQUAL( strlen( names[ index ] ), value.u.value.u.string.length );
+        TEST_ASSERT_EQUAL( 0, strncmp( ( const char * ) value.u.value.u.string.pString,
+                                       names[ index ],
+                                       value.u.value.u.string.length ) );
+
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.find( &parameter, "index", &value ) );
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_SCALAR_SIGNED_INT, value.type );
+        TEST_ASSERT_EQUAL( index + 1, value.u.value.u.signedInt );
+
+        _decoder.destroy( &parameter );
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.next( iterator ) );
+        index++;
+    }
+
+    TEST_ASSERT_EQUAL( 3, index );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS, _decoder.stepOut( iterator, &childObject ) );
+}
+
+TEST( Full_Serializer_JSON_deserialize, init_with_tokens )
+{
+    IotSerializerJsonToken_t tokens[ JOB_DOCUMENT_TOKEN_COUNT ];
+    IotSerializerDecoderObject_t document = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+
+    /* A table one token too small is rejected. */
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_BUFFER_TOO_SMALL,
+                       IotSerializer_InitJsonDecoderWithTokens( &document,
+                                                                job_document,
+                                                                sizeof( job_document ),
+                                                                tokens,
+                                                                JOB_DOCUMENT_TOKEN_COUNT - 1 ) );
+
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS,
+                       IotSerializer_InitJsonDecoderWithTokens( &document,
+                                                                job_document,
+                                                                sizeof( job_document ),
+                                                                tokens,
+                                                                JOB_DOCUMENT_TOKEN_COUNT ) );
+    TEST_ASSERT_EQUAL( IOT_SERIALIZER_CONTAINER_MAP, document.type );
+
+    if( TEST_PROTECT() )
+    {
+        _decodeJobDocument( &document );
+    }
+
+    _decoder.destroy( &document );
+    TEST_ASSERT_NULL( document.u.pHandle );
+}
+
+TEST( Full_Serializer_JSON_deserialize, init_malformed_document )
+{
+    IotSerializerDecoderObject_t document = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    const char * const malformed[] =
+    {
+        "{\"key\":\"value\"",     /* Unterminated map. */
+        "{\"key\":[1,2}",         /* Mismatched container. */
+        "{\"key\":\"value}",      /* Unterminated string. */
+        "{\"key\":tru}",          /* Invalid literal. */
+        "\"key\""                  /* Not a container. */
+    };
+    size_t i = 0;
+
+    for( i = 0; i < sizeof( malformed ) / sizeof( malformed[ 0 ] ); i++ )
+    {
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_INVALID_INPUT,
+                           _decoder.init( &document,
+                                          ( const uint8_t * ) malformed[ i ],
+                                          strlen( malformed[ i ] ) ) );
+    }
+}
+
+TEST( Full_Serializer_JSON_deserialize, decode_job_document_throughput )
+{
+    IotSerializerJsonToken_t tokens[ JOB_DOCUMENT_TOKEN_COUNT ];
+    IotSerializerDecoderObject_t document = IOT_SERIALIZER_DECODER_OBJECT_INITIALIZER;
+    uint64_t startTime = 0;
+    uint32_t i = 0;
+
+    /* Decode with a token table allocated by the decoder. */
+    startTime = IotClock_GetTimeMs();
+
+    for( i = 0; i < JOB_DOCUMENT_ITERATIONS; i++ )
+    {
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS,
+                           _decoder.init( &document, job_document, sizeof( job_document ) ) );
+        _decodeJobDocument( &document );
+        _decoder.destroy( &document );
+    }
+
+    _printThroughput( "Job document, allocated tokens", IotClock_GetTimeMs() - startTime );
+
+    /* Decode with a caller-supplied token table. */
+    startTime = IotClock_GetTimeMs();
+
+    for( i = 0; i < JOB_DOCUMENT_ITERATIONS; i++ )
+    {
+        TEST_ASSERT_EQUAL( IOT_SERIALIZER_SUCCESS,
+                           IotSerializer_InitJsonDecoderWithTokens( &document,
+                                                                    job_document,
+                                                                    sizeof( job_document ),
+                                                                    tokens,
+                                                                    JOB_DOCUMENT_TOKEN_COUNT ) );
+        _decodeJobDocument( &document );
+        _decoder.destroy( &document );
+    }
+
+    _printThroughput( "Job document, caller tokens", IotClock_GetTimeMs() - startTime );
+}
@@ -0,0 +1,574 @@
+/*
+ * Amazon FreeRTOS Serializer V1.1.0
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file iot_tests_json_utils.c
+ * @brief Tests for the JSON utilities in iot_json_utils.h.
+ */
+
+/* The config header is always included first. */
+#include "iot_config.h"
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Platform layer includes. */
+#include "platform/iot_clock.h"
+
+/* JSON utilities include. */
+#include "iot_json_utils.h"
+
+/* Test framework includes. */
+#include "unity_fixture.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of random documents compared by the differential test.
+ */
+#define FUZZ_ITERATIONS            ( 50000 )
+
+/**
+ * @brief Maximum length of a random document.
+ */
+#define FUZZ_MAX_DOCUMENT_LENGTH   ( 192 )
+
+/**
+ * @brief Number of child devices in the aggregated Shadow document of the benchmark.
+ */
+#define BENCHMARK_CHILD_COUNT      ( 64 )
+
+/**
+ * @brief Number of searches performed by the benchmark.
+ */
+#define BENCHMARK_ITERATIONS       ( 2000 )
+
+/**
+ * @brief Size of the aggregated Shadow document buffer.
+ */
+#define BENCHMARK_DOCUMENT_SIZE    ( 8192 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Characters of random documents. Structural characters are repeated
+ * so that they appear often.
+ */
+static const char _fuzzAlphabet[] = "\"\"\"\"{{}}[[]]::,,\\\\  \n\tkkeyab1";
+
+/**
+ * @brief Keys searched for in random documents.
+ */
+static const char * const _fuzzKeys[] = { "k", "key", "ab", "a", "ke", "y\\", "\"k" };
+
+/**
+ * @brief State of the pseudo-random number generator; a fixed seed makes
+ * failures reproducible.
+ */
+static uint32_t _fuzzSeed = 1;
+
+/**
+ * @brief Buffer holding a random document. Characters after the document are
+ * always zero.
+ */
+static char _pFuzzDocument[ FUZZ_MAX_DOCUMENT_LENGTH + 64 ] = { 0 };
+
+/**
+ * @brief Buffer holding the aggregated Shadow document of the benchmark.
+ */
+static char _pBenchmarkDocument[ BENCHMARK_DOCUMENT_SIZE ] = { 0 };
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The byte-at-a-time implementation of IotJsonUtils_FindJsonValue,
+ * which the structural scanner must match exactly.
+ */
+static bool _referenceFindJsonValue( const char * pJsonDocument,
+                                     size_t jsonDocumentLength,
+                                     const char * pJsonKey,
+                                     size_t jsonKeyLength,
+                                     const char ** pJsonValue,
+                                     size_t * pJsonValueLength )
+{
+    size_t i = 0;
+    size_t jsonValueLength = 0;
+    char openCharacter = '\0', closeCharacter = '\0';
+    int nestingLevel = 0;
+
+    /* Ensure the JSON document is long enough to contain the key/value pair. At
+     * the very least, a JSON key/value pair must contain the key and the 6
+     * characters {":""} */
+    if( jsonDocumentLength < jsonKeyLength + 6 )
+    {
+        return false;
+    }
+
+    /* Search the characters in the JSON document for the key. The end of the JSON
+     * document does not have to be searched once too few characters remain to hold a
+     * value. */
+    while( i < jsonDocumentLength - jsonKeyLength - 3 )
+    {
+        /* If the first character in the key is found and there's an unescaped double
+         * quote after the key length, do a string compare for the key. */
+        if( ( pJsonDocument[ i ] == pJsonKey[ 0 ] ) &&
+            ( pJsonDocument[ i + jsonKeyLength ] == '\"' ) &&
+            ( pJsonDocument[ i + jsonKeyLength - 1 ] != '\\' ) &&
+            ( strncmp( pJsonDocument + i,
+                       pJsonKey,
+                       jsonKeyLength ) == 0 ) )
+        {
+            /* Key found; this is a potential match. */
+
+            /* Skip the characters in the JSON key and closing double quote. */
+            i += jsonKeyLength + 1;
+
+            /* Skip all whitespace characters between the closing " and the : */
+            while( pJsonDocument[ i ] == ' ' ||
+                   pJsonDocument[ i ] == '\n' ||
+                   pJsonDocument[ i ] == '\r' ||
+                   pJsonDocument[ i ] == '\t' )
+            {
+                i++;
+
+                /* If the end of the document is reached, this isn't a match. */
+                if( i >= jsonDocumentLength )
+                {
+                    return false;
+                }
+            }
+
+            /* The character immediately following a key (and any whitespace) must be a :
+             * If it's another character, then this string is a JSON value; skip it. */
+            if( pJsonDocument[ i ] != ':' )
+            {
+                continue;
+            }
+            else
+            {
+                /* Skip the : */
+                i++;
+            }
+
+            /* Skip all whitespace characters between : and the first character in the value. */
+            while( pJsonDocument[ i ] == ' ' ||
+                   pJsonDocument[ i ] == '\n' ||
+                   pJsonDocument[ i ] == '\r' ||
+                   pJsonDocument[ i ] == '\t' )
+            {
+                i++;
+
+                /* If the end of the document is reached, this isn't a match. */
+                if( i >= jsonDocumentLength )
+                {
+                    return false;
+                }
+            }
+
+            /* Value found. Set the output parameter. */
+            if( pJsonValue != NULL )
+            {
+                *pJsonValue = pJsonDocument + i;
+            }
+
+            /* Calculate the value's length. */
+            switch( pJsonDocument[ i ] )
+            {
+                /* Calculate length of a JSON string. */
+                case '\"':
+                    /* Include the length of the opening and closing double quotes. */
+                    jsonValueLength = 2;
+
+                    /* Skip the opening double quote. */
+                    i++;
+
+                    /* Add the length of all characters in the JSON string. */
+                    while( pJsonDocument[ i ] != '\"' )
+                    {
+                        /* Ignore escaped double quotes. */
+                        if( ( pJsonDocument[ i ] == '\\' ) &&
+                            ( i + 1 < jsonDocumentLength ) &&
+                            ( pJsonDocument[ i + 1 ] == '\"' ) )
+                        {
+                            /* Skip the characters \" */
+                            i += 2;
+                            jsonValueLength += 2;
+                        }
+                        else
+                        {
+                            /* Add the length of a single character. */
+                            i++;
+                            jsonValueLength++;
+                        }
+
+                        /* If the end of the document is reached, this isn't a match. */
+                        if( i >= jsonDocumentLength )
+                        {
+                            return false;
+                        }
+                    }
+
+                    break;
+
+                /* Set the matching opening and closing characters of a JSON object or array.
+                 * The length calculation is performed below. */
+                case '{':
+                    openCharacter = '{';
+                    closeCharacter = '}';
+                    break;
+
+                case '[':
+                    openCharacter = '[';
+                    closeCharacter = ']';
+                    break;
+
+                /* Calculate the length of a JSON primitive. */
+                default:
+
+                    /* Skip the characters in the JSON value. The JSON value ends with a , or } */
+                    while( pJsonDocument[ i ] != ',' &&
+                           pJsonDocument[ i ] != '}' )
+                    {
+                        /* Any whitespace before a , or } means the JSON document is invalid. */
+                        if( ( pJsonDocument[ i ] == ' ' ) ||
+                            ( pJsonDocument[ i ] == '\n' ) ||
+                            ( pJsonDocument[ i ] == '\r' ) ||
+                            ( pJsonDocument[ i ] == '\t' ) )
+                        {
+                            return false;
+                        }
+
+                        i++;
+                        jsonValueLength++;
+
+                        /* If the end of the document is reached, this isn't a match. */
+                        if( i >= jsonDocumentLength )
+                        {
+                            return false;
+                        }
+                    }
+
+                    break;
+            }
+
+            /* Calculate the length of a JSON object or array. */
+            if( ( openCharacter != '\0' ) && ( closeCharacter != '\0' ) )
+            {
+                /* Include the length of the opening and closing characters. */
+                jsonValueLength = 2;
+
+                /* Skip the opening character. */
+                i++;
+
+                /* Add the length of all characters in the JSON object or array. This
+                 * includes the length of nested objects. */
+                while( pJsonDocument[ i ] != closeCharacter ||
+                       ( pJsonDocument[ i ] == closeCharacter && nestingLevel != 0 ) )
+                {
+                    /* An opening character starts a nested object. */
+                    if( pJsonDocument[ i ] == openCharacter )
+                    {
+                        nestingLevel++;
+                    }
+                    /* A closing character ends a nested object. */
+                    else if( pJsonDocument[ i ] == closeCharacter )
+                    {
+                        nestingLevel--;
+                    }
+
+                    i++;
+                    jsonValueLength++;
+
+                    /* If the end of the document is reached, this isn't a match. */
+                    if( i >= jsonDocumentLength )
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            /* JSON value length calculated; set the output parameter. */
+            if( pJsonValueLength != NULL )
+            {
+                *pJsonValueLength = jsonValueLength;
+            }
+
+            return true;
+        }
+
+        i++;
+    }
+
+    return false;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Linear congruential generator for the differential test.
+ */
+static uint32_t _fuzzRandom( void )
+{
+    _fuzzSeed = ( _fuzzSeed * 1103515245UL ) + 12345UL;
+
+    return ( _fuzzSeed >> 16 ) & 0x7fff;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Compare IotJsonUtils_FindJsonValue with the reference implementation.
+ */
+static void _compareWithReference( const char * pDocument,
+                                   size_t documentLength,
+                                   const char * pKey,
+                                   size_t keyLength )
+{
+    bool expected = false, actual = false;
+    const char * pExpectedValue = NULL, * pActualValue = NULL;
+    size_t expectedValueLength = 0, actualValueLength = 0;
+
+    expected = _referenceFindJsonValue( pDocument,
+                                        documentLength,
+                                        pKey,
+                                        keyLength,
+                                        &pExpectedValue,
+                                        &expectedValueLength );
+    actual = IotJsonUtils_FindJsonValue( pDocument,
+                                         documentLength,
+                                         pKey,
+                                         keyLength,
+                                         &pActualValue,
+                                         &actualValueLength );
+
+    TEST_ASSERT_EQUAL_INT( expected, actual );
+
+    if( expected == true )
+    {
+        TEST_ASSERT_EQUAL_PTR( pExpectedValue, pActualValue );
+        TEST_ASSERT_EQUAL( expectedValueLength, actualValueLength );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Fill the benchmark buffer with a Shadow document aggregating the
+ * reported state of many child devices.
+ *
+ * @return Length of the document.
+ */
+static size_t _generateAggregatedDocument( void )
+{
+    size_t length = 0;
+    int i = 0;
+
+    length += ( size_t ) snprintf( _pBenchmarkDocument + length,
+                                   BENCHMARK_DOCUMENT_SIZE - length,
+                                   "{\"state\": {\"reported\": {" );
+
+    for( i = 0; i < BENCHMARK_CHILD_COUNT; i++ )
+    {
+        length += ( size_t ) snprintf( _pBenchmarkDocument + length,
+                                       BENCHMARK_DOCUMENT_SIZE - length,
+                                       "\"child%02d\": {\"temperature\": %d, \"humidity\": %d, "
+                                       "\"firmware\": \"v1.%d.0\", \"labels\": [\"floor%d\", \"zone\"]}, ",
+                                       i, 20 + i, 40 + i, i, i % 4 );
+    }
+
+    length += ( size_t ) snprintf( _pBenchmarkDocument + length,
+                                   BENCHMARK_DOCUMENT_SIZE - length,
+                                   "\"gateway\": {\"uptime\": 86400}}}, \"clientToken\": \"gateway-1\"}" );
+
+    return length;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test group for the JSON utilities.
+ */
+TEST_GROUP( Full_Serializer_JSON_utils );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test setup for the JSON utilities.
+ */
+TEST_SETUP( Full_Serializer_JSON_utils )
+{
+    _fuzzSeed = 1;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test tear down for the JSON utilities.
+ */
+TEST_TEAR_DOWN( Full_Serializer_JSON_utils )
+{
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test group runner for the JSON utilities.
+ */
+TEST_GROUP_RUNNER( Full_Serializer_JSON_utils )
+{
+    RUN_TEST_CASE( Full_Serializer_JSON_utils, FindValueTypes );
+    RUN_TEST_CASE( Full_Serializer_JSON_utils, DifferentialFuzz );
+    RUN_TEST_CASE( Full_Serializer_JSON_utils, FindValueThroughput );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Find values of every JSON type, including values that span several
+ * scanned blocks.
+ */
+TEST( Full_Serializer_JSON_utils, FindValueTypes )
+{
+    size_t i = 0;
+    const char pDocument[] =
+        "{\"string\" : \"a \\\"quoted\\\" string that is longer than one block\","
+        "\"escaped\\\"key\": 1,"
+        "\"object\":{\"nested\": {\"key\": [1, 2, 3]}, \"padding\": \"................................\"},"
+        "\"array\" : [ [], [ \"]\" ] ],"
+        "\"number\":\t-12.5e3,"
+        "\"literal\": true}";
+    const char * const pKeys[] =
+    {
+        "string", "object", "array", "number", "literal", "nested", "missing", "key\\"
+    };
+
+    /* Every key must give the same result as the reference implementation. */
+    for( i = 0; i < sizeof( pKeys ) / sizeof( pKeys[ 0 ] ); i++ )
+    {
+        _compareWithReference( pDocument, sizeof( pDocument ) - 1, pKeys[ i ], strlen( pKeys[ i ] ) );
+    }
+
+    /* Check some values directly. */
+    {
+        const char * pValue = NULL;
+        size_t valueLength = 0;
+
+        TEST_ASSERT_TRUE( IotJsonUtils_FindJsonValue( pDocument, sizeof( pDocument ) - 1,
+                                                      "number", 6, &pValue, &valueLength ) );
+        TEST_ASSERT_EQUAL( 7, valueLength );
+        TEST_ASSERT_EQUAL_STRING_LEN( "-12.5e3", pValue, valueLength );
+
+        TEST_ASSERT_TRUE( IotJsonUtils_FindJsonValue( pDocument, sizeof( pDocument ) - 1,
+                                                      "nested", 6, &pValue, &valueLength ) );
+        TEST_ASSERT_EQUAL_STRING_LEN( "{\"key\": [1, 2, 3]}", pValue, valueLength );
+
+        TEST_ASSERT_FALSE( IotJsonUtils_FindJsonValue( pDocument, sizeof( pDocument ) - 1,
+                                                       "missing", 7, NULL, NULL ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Compare IotJsonUtils_FindJsonValue with the reference implementation
+ * on random documents.
+ */
+TEST( Full_Serializer_JSON_utils, DifferentialFuzz )
+{
+    uint32_t iteration = 0;
+    size_t i = 0, documentLength = 0, keyIndex = 0;
+
+    for( iteration = 0; iteration < FUZZ_ITERATIONS; iteration++ )
+    {
+        documentLength = _fuzzRandom() % ( FUZZ_MAX_DOCUMENT_LENGTH + 1 );
+
+        for( i = 0; i < documentLength; i++ )
+        {
+            _pFuzzDocument[ i ] = _fuzzAlphabet[ _fuzzRandom() % ( sizeof( _fuzzAlphabet ) - 1 ) ];
+        }
+
+        /* The reference implementation may read one character past the end
+         * of the document; keep it zero. */
+        memset( _pFuzzDocument + documentLength, 0x00, sizeof( _pFuzzDocument ) - documentLength );
+
+        keyIndex = _fuzzRandom() % ( sizeof( _fuzzKeys ) / sizeof( _fuzzKeys[ 0 ] ) );
+
+        _compareWithReference( _pFuzzDocument,
+                               documentLength,
+                               _fuzzKeys[ keyIndex ],
+                               strlen( _fuzzKeys[ keyIndex ] ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measure the time to search an aggregated Shadow document.
+ */
+TEST( Full_Serializer_JSON_utils, FindValueThroughput )
+{
+    uint32_t i = 0;
+    size_t documentLength = _generateAggregatedDocument();
+    const char * pValue = NULL;
+    size_t valueLength = 0;
+    uint64_t startTime = 0, referenceTime = 0, scannerTime = 0;
+
+    /* The key is near the end of the document, so most of it is searched. */
+    _compareWithReference( _pBenchmarkDocument, documentLength, "clientToken", 11 );
+
+    startTime = IotClock_GetTimeMs();
+
+    for( i = 0; i < BENCHMARK_ITERATIONS; i++ )
+    {
+        TEST_ASSERT_TRUE( _referenceFindJsonValue( _pBenchmarkDocument, documentLength,
+                                                   "clientToken", 11, &pValue, &valueLength ) );
+    }
+
+    referenceTime = IotClock_GetTimeMs() - startTime;
+    startTime = IotClock_GetTimeMs();
+
+    for( i = 0; i < BENCHMARK_ITERATIONS; i++ )
+    {
+        TEST_ASSERT_TRUE( IotJsonUtils_FindJsonValue( _pBenchmarkDocument, documentLength,
+                                                      "clientToken", 11, &pValue, &valueLength ) );
+    }
+
+    scannerTime = IotClock_GetTimeMs() - startTime;
+
+    UnityPrint( "FindJsonValue in " );
+    UnityPrintNumber( ( UNITY_INT ) documentLength );
+    UnityPrint( " byte document, " );
+    UnityPrintNumber( BENCHMARK_ITERATIONS );
+    UnityPrint( " searches: byte-at-a-time " );
+    UnityPrintNumber( ( UNITY_INT ) referenceTime );
+    UnityPrint( " ms, structural scan " );
+    UnityPrintNumber( ( UNITY_INT ) scannerTime );
+    UnityPrint( " ms." );
+    UNITY_PRINT_EOL();
+}
+
+/*-----------------------------------------------------------*/
@@ -76,6 +76,45 @@
     #define ggdconfigJSON_MAX_TOKENS    ( 128 )        /* Size of the array used by jsmn to store the tokens. */
 #endif
 
+/**
+ * @brief Number of candidate core endpoints to connect to at the same time
+ * when the core is auto selected.
+ *
+ * Each attempt beyond the first runs the TLS handshake in its own task; the
+ * first endpoint to accept the connection is returned. Set to 1 to try the
+ * endpoints one after the other in document order.
+ */
+#ifndef ggdconfigMAX_PARALLEL_CONNECTS
+    #define ggdconfigMAX_PARALLEL_CONNECTS    ( 1 )
+#endif
+
+/**
+ * @brief Stack size in words of the tasks that probe core endpoints.
+ *
+ * Only used when ggdconfigMAX_PARALLEL_CONNECTS is greater than 1. The
+ * stack must be able to hold a TLS handshake.
+ */
+#ifndef ggdconfigCONNECT_TASK_STACK_SIZE
+    #define ggdconfigCONNECT_TASK_STACK_SIZE    ( configMINIMAL_STACK_SIZE * 8 )
+#endif
+
+/**
+ * @brief Priority of the tasks that probe core endpoints.
+ */
+#ifndef ggdconfigCONNECT_TASK_PRIORITY
+    #define ggdconfigCONNECT_TASK_PRIORITY    ( tskIDLE_PRIORITY + 1 )
+#endif
+
+/**
+ * @brief Set to 1 to remember the last core endpoint that accepted a
+ * connection and try it first on the next discovery.
+ *
+ * The endpoint is kept in RAM only.
+ */
+#ifndef ggdconfigCACHE_LAST_GOOD_HOST
+    #define ggdconfigCACHE_LAST_GOOD_HOST    ( 1 )
+#endif
+
 #ifndef ggdconfigPRINT
     #define ggdconfigPRINT    vLoggingPrintf
 #endif
@@ -144,6 +144,109 @@ static BaseType_t prvIsIPvalid( const char * pcIP,
                                 uint32_t ulIPlength );
 /** @} */
 
+/**
+ * @brief Core selection helper functions.
+ *
+ * Once the document is tokenized, the certificate and the core are located
+ * and the core endpoints are tried until one accepts a TLS connection.
+ */
+/** @{ */
+static BaseType_t prvGGDGetHostFromTokens( char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                           const HostParameters_t * pxHostParameters,
+                                           GGD_HostAddressData_t * pxHostAddressData,
+                                           const BaseType_t xAutoSelectFlag,
+                                           const jsmntok_t * pxTok,
+                                           const uint32_t ulNbTokens );
+static BaseType_t prvGGDConnectInOrder( char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                        const jsmntok_t * pxTok,
+                                        const uint32_t ulNbTokens,
+                                        uint32_t ulTokenIndex,
+                                        GGD_HostAddressData_t * pxHostAddressData );
+/** @} */
+
+/**
+ * @brief Tokenize the part of the JSON file received so far.
+ *
+ * Resumes the parse started on the previous chunks. Returns the number of
+ * tokens once the document is complete, JSMN_ERROR_PART while more data is
+ * needed, or another jsmn error if the document can't be parsed.
+ */
+static int32_t prvGGDParseJSONChunk( jsmn_parser * pxParser,
+                                     const char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                     uint32_t ulLength,
+                                     const BaseType_t xLastChunk,
+                                     jsmntok_t * pxTok );
+static BaseType_t prvIsJSONDelimiter( const char cChar ); /*lint !e971 can use char without signed/unsigned. */
+
+#if ( ggdconfigCACHE_LAST_GOOD_HOST == 1 )
+
+/**
+ * @brief Endpoint of the last core that accepted a connection.
+ */
+    typedef struct GGDLastGoodHost
+    {
+        char cHostAddress[ securesocketsMAX_DNS_NAME_LENGTH + 1 ]; /*lint !e971 can use char without signed/unsigned. */
+        uint16_t usPort;
+    } GGDLastGoodHost_t;
+
+    static GGDLastGoodHost_t xLastGoodHost = { { '\0' }, 0 };
+
+    static BaseType_t prvGGDConnectToLastGoodHost( char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                                   const jsmntok_t * pxTok,
+                                                   const uint32_t ulNbTokens,
+                                                   uint32_t ulTokenIndex,
+                                                   GGD_HostAddressData_t * pxHostAddressData );
+    static void prvGGDSetLastGoodHost( const GGD_HostAddressData_t * pxHostAddressData );
+#endif
+
+#if ( ggdconfigMAX_PARALLEL_CONNECTS > 1 )
+
+/**
+ * @brief State shared by the caller and the tasks probing core endpoints.
+ *
+ * Freed by whichever of them releases it last, so the caller can return as
+ * soon as one probe succeeds.
+ */
+    typedef struct GGDProbeGroup
+    {
+        QueueHandle_t xResults;   /**< Receives a GGDProbeResult_t from every probe. */
+        UBaseType_t uxReferences; /**< The caller and every running probe hold a reference. */
+    } GGDProbeGroup_t;
+
+/**
+ * @brief Outcome of a connection attempt.
+ */
+    typedef struct GGDProbeResult
+    {
+        uint32_t ulSlot;    /**< Slot of the endpoint in the caller's in flight list. */
+        BaseType_t xStatus; /**< pdPASS if the endpoint accepted the connection. */
+    } GGDProbeResult_t;
+
+/**
+ * @brief Parameters of a probe task.
+ *
+ * The host name and certificate are copied right after the structure.
+ */
+    typedef struct GGDProbe
+    {
+        GGDProbeGroup_t * pxGroup;
+        uint32_t ulSlot;
+        GGD_HostAddressData_t xHostAddressData;
+    } GGDProbe_t;
+
+    static BaseType_t prvGGDConnectInParallel( char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                               const jsmntok_t * pxTok,
+                                               const uint32_t ulNbTokens,
+                                               uint32_t ulTokenIndex,
+                                               GGD_HostAddressData_t * pxHostAddressData );
+    static GGDProbeGroup_t * prvGGDCreateProbeGroup( void );
+    static void prvGGDReleaseProbeGroup( GGDProbeGroup_t * pxGroup );
+    static BaseType_t prvGGDStartProbe( GGDProbeGroup_t * pxGroup,
+                                        const uint32_t ulSlot,
+                                        const GGD_HostAddressData_t * pxHostAddressData );
+    static void prvGGDProbeTask( void * pvParameters );
+#endif /* if ( ggdconfigMAX_PARALLEL_CONNECTS > 1 ) */
+
 /**
  * @brief Search for length field in server HTTP response
  *
@@ -167,6 +270,9 @@ BaseType_t GGD_GetGGCIPandCertificate( const char * pcHostAddress,
     BaseType_t xJSONFileRetrieveCompleted = pdFALSE;
     uint32_t ulByteRead = 0;
     BaseType_t xStatus;
+    jsmn_parser xParser;
+    jsmntok_t pxTok[ ggdconfigJSON_MAX_TOKENS ];
+    int32_t lNbTokens = ( int32_t ) JSMN_ERROR_PART;
 
     configASSERT( pxHostAddressData != NULL );
     configASSERT( pcBuffer != NULL );
@@ -180,7 +286,12 @@ BaseType_t GGD_GetGGCIPandCertificate( const char * pcHostAddress,
 
     if( xStatus == pdPASS )
     {
-        /* Loop until the full JSON is retrieved. */
+        jsmn_init( &xParser );
+
+        /* Loop until the full JSON is retrieved. Each chunk is tokenized as
+         * soon as it is received, so the document is parsed by the time the
+         * last byte arrives and a malformed one is dropped without waiting
+         * for the rest of it. */
         do
         {
             xStatus = GGD_JSONRequestGetFile( &xSocket,
@@ -189,6 +300,21 @@ BaseType_t GGD_GetGGCIPandCertificate( const char * pcHostAddress,
                                               &ulByteRead,
                                               &xJSONFileRetrieveCompleted,
                                               ulJSONFileSize ); /*lint !e644 ulJSONFileSize has been initialized if code reaches here. */
+
+            if( xStatus == pdPASS )
+            {
+                lNbTokens = prvGGDParseJSONChunk( &xParser,
+                                                  pcBuffer,
+                                                  ulByteRead,
+                                                  xJSONFileRetrieveCompleted,
+                                                  pxTok );
+
+                if( ( lNbTokens != ( int32_t ) JSMN_ERROR_PART ) && ( lNbTokens < 0 ) )
+                {
+                    ggdconfigPRINT( "JSON parsing: Failed to parse JSON\r\n" );
+                    xStatus = pdFAIL;
+                }
+            }
         }
         while( ( xStatus == pdPASS ) && ( xJSONFileRetrieveCompleted != pdTRUE ) && ( ulBufferSize - ulByteRead ) > 0 );
 
@@ -209,7 +335,7 @@ BaseType_t GGD_GetGGCIPandCertificate( const char * pcHostAddress,
             xStatus = pdFAIL;
         }
 
-        if( xJSONFileRetrieveCompleted != pdTRUE )
+        if( ( xJSONFileRetrieveCompleted != pdTRUE ) || ( lNbTokens < 0 ) )
         {
             xStatus = pdFAIL;
         }
@@ -217,11 +343,13 @@ BaseType_t GGD_GetGGCIPandCertificate( const char * pcHostAddress,
 
     if( xStatus == pdPASS )
     {
-        xStatus = GGD_GetIPandCertificateFromJSON( pcBuffer,
-                                                   ulJSONFileSize,
-                                                   NULL,
-                                                   pxHostAddressData,
-                                                   pdTRUE );
+        /* The tokens are complete, select the core without parsing again. */
+        xStatus = prvGGDGetHostFromTokens( pcBuffer,
+                                           NULL,
+                                           pxHostAddressData,
+                                           pdTRUE,
+                                           pxTok,
+                                           ( uint32_t ) lNbTokens );
     }
 
     return xStatus;
@@ -449,12 +577,18 @@ BaseType_t GGD_JSONRequestGetFile( Socket_t * pxSocket,
         {
             *pxJSONFileRetrieveCompleted = pdFALSE;
         }
-        else
+        else if( ulDataSizeRead < ulBufferSize )
         {
-            /* Add the escape character. */
-            pcBuffer[ pulJSONFileSize - ( uint32_t ) 1 ] = '\0';
+            /* Add the escape character after the last byte of this chunk,
+             * which is also the last byte of the file. */
+            pcBuffer[ ulDataSizeRead ] = '\0';
             *pxJSONFileRetrieveCompleted = pdTRUE;
         }
+        else
+        {
+            ggdconfigPRINT( "JSON parsing - No room left for the escape character\r\n" );
+            xStatus = pdFAIL;
+        }
     }
 
     if( xStatus == pdFAIL )
@@ -493,15 +627,10 @@ BaseType_t GGD_GetIPandCertificateFromJSON( char * pcJSONFile, /*lint !e971 can
                                             GGD_HostAddressData_t * pxHostAddressData,
                                             const BaseType_t xAutoSelectFlag )
 {
-    Socket_t xSocket;
     BaseType_t xStatus;
     jsmn_parser xParser;
     jsmntok_t pxTok[ ggdconfigJSON_MAX_TOKENS ];
     int32_t lNbTokens;
-    uint32_t ulTokenIndex = 0;
-    uint8_t ucCurrentInterface = 0, ucTargetInterface = 1;
-    BaseType_t xFoundGGC = pdFALSE;
-    BaseType_t xIsIPValid;
 
     configASSERT( pcJSONFile != NULL );
     configASSERT( pxHostAddressData != NULL );
@@ -528,23 +657,41 @@ BaseType_t GGD_GetIPandCertificateFromJSON( char * pcJSONFile, /*lint !e971 can
     }
     else
     {
-        xStatus = pdPASS;
+        xStatus = prvGGDGetHostFromTokens( pcJSONFile,
+                                           pxHostParameters,
+                                           pxHostAddressData,
+                                           xAutoSelectFlag,
+                                           pxTok,
+                                           ( uint32_t ) lNbTokens );
     }
 
-    if( xStatus == pdPASS )
+    return xStatus;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvGGDGetHostFromTokens( char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                           const HostParameters_t * pxHostParameters,
+                                           GGD_HostAddressData_t * pxHostAddressData,
+                                           const BaseType_t xAutoSelectFlag,
+                                           const jsmntok_t * pxTok,
+                                           const uint32_t ulNbTokens )
+{
+    BaseType_t xStatus = pdPASS;
+    uint32_t ulTokenIndex = 0;
+    uint8_t ucCurrentInterface = 0;
+    BaseType_t xFoundGGC = pdFALSE;
+
+    /* Look for the green grass group certificate. */
+    if( prvGGDGetCertificate( pcJSONFile,
+                              pxHostParameters,
+                              xAutoSelectFlag,
+                              pxTok,
+                              ulNbTokens,
+                              pxHostAddressData ) == pdFAIL )
     {
-        /* Look for the green grass group certificate. */
-        if( prvGGDGetCertificate( pcJSONFile,
-                                  pxHostParameters,
-                                  xAutoSelectFlag,
-                                  pxTok,
-                                  ( uint32_t ) lNbTokens, /*lint !e644 lNbTokens has been initialized if code reaches here. */
-                                  pxHostAddressData ) == pdFAIL )
-        {
-            ggdconfigPRINT( "JSON parsing: Couldn't find certificate\r\n" );
+        ggdconfigPRINT( "JSON parsing: Couldn't find certificate\r\n" );
 
-            xStatus = pdFAIL;
-        }
+        xStatus = pdFAIL;
     }
 
     if( xStatus == pdPASS )
@@ -554,7 +701,7 @@ BaseType_t GGD_GetIPandCertificateFromJSON( char * pcJSONFile, /*lint !e971 can
                            pxHostParameters,
                            xAutoSelectFlag,
                            pxTok,
-                           ( uint32_t ) lNbTokens,
+                           ulNbTokens,
                            &ulTokenIndex ) == pdFAIL )
         {
             ggdconfigPRINT( "JSON parsing: Couldn't find Green Grass Core\r\n" );
@@ -574,7 +721,7 @@ BaseType_t GGD_GetIPandCertificateFromJSON( char * pcJSONFile, /*lint !e971 can
             if( prvGGDGetIPOnInterface( pcJSONFile,
                                         pxHostParameters->ucInterface,
                                         pxTok,
-                                        ( uint32_t ) lNbTokens,
+                                        ulNbTokens,
                                         pxHostAddressData,
                                         &ulTokenIndex,
                                         &ucCurrentInterface ) == pdFAIL )
@@ -587,46 +734,456 @@ BaseType_t GGD_GetIPandCertificateFromJSON( char * pcJSONFile, /*lint !e971 can
             }
         }
         else
+        {
+            #if ( ggdconfigCACHE_LAST_GOOD_HOST == 1 )
+                {
+                    /* Try the endpoint that worked last time on its own
+                     * before probing the whole list. */
+                    xFoundGGC = prvGGDConnectToLastGoodHost( pcJSONFile,
+                                                             pxTok,
+                                                             ulNbTokens,
+                                                             ulTokenIndex,
+                                                             pxHostAddressData );
+                }
+            #endif
+
+            if( xFoundGGC == pdFALSE )
+            {
+                #if ( ggdconfigMAX_PARALLEL_CONNECTS > 1 )
+                    xFoundGGC = prvGGDConnectInParallel( pcJSONFile,
+                                                         pxTok,
+                                                         ulNbTokens,
+                                                         ulTokenIndex,
+                                                         pxHostAddressData );
+                #else
+                    xFoundGGC = prvGGDConnectInOrder( pcJSONFile,
+                                                      pxTok,
+                                                      ulNbTokens,
+                                                      ulTokenIndex,
+                                                      pxHostAddressData );
+                #endif
+            }
+
+            #if ( ggdconfigCACHE_LAST_GOOD_HOST == 1 )
+                {
+                    if( xFoundGGC == pdTRUE )
+                    {
+                        prvGGDSetLastGoodHost( pxHostAddressData );
+                    }
+                }
+            #endif
+        }
+
+        if( xFoundGGC != pdTRUE )
+        {
+            ggdconfigPRINT( "GGD - Can't connect to greengrass Core\r\n" );
+
+            xStatus = pdFAIL;
+        }
+    }
+
+    return xStatus;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t prvGGDParseJSONChunk( jsmn_parser * pxParser,
+                                     const char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                     uint32_t ulLength,
+                                     const BaseType_t xLastChunk,
+                                     jsmntok_t * pxTok )
+{
+    /* jsmn ends a primitive at the end of the data it is given, so hold back
+     * any trailing characters that could be a number or a literal cut in
+     * two by the socket read. They are parsed with the next chunk. Strings
+     * and containers left open are rewound by jsmn itself. */
+    if( xLastChunk == pdFALSE )
+    {
+        while( ( ulLength > ( uint32_t ) 0 ) &&
+               ( prvIsJSONDelimiter( pcJSONFile[ ulLength - ( uint32_t ) 1 ] ) == pdFALSE ) )
+        {
+            ulLength--;
+        }
+    }
+
+    /* jsmn resumes from where the previous call stopped. */
+    return ( int32_t ) jsmn_parse( pxParser,
+                                   pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                   ( size_t ) ulLength,
+                                   pxTok,
+                                   ( unsigned int ) ggdconfigJSON_MAX_TOKENS ); /*lint !e961 redundant casting only when int = int32_t. */
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsJSONDelimiter( const char cChar ) /*lint !e971 can use char without signed/unsigned. */
+{
+    BaseType_t xIsDelimiter;
+
+    switch( cChar )
+    {
+        case '\t':
+        case '\r':
+        case '\n':
+        case ' ':
+        case ',':
+        case ':':
+        case '"':
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+            xIsDelimiter = pdTRUE;
+            break;
+
+        default:
+            xIsDelimiter = pdFALSE;
+            break;
+    }
+
+    return xIsDelimiter;
+}
+/*-----------------------------------------------------------*/
+
+#if ( ggdconfigCACHE_LAST_GOOD_HOST == 1 )
+
+    static BaseType_t prvGGDConnectToLastGoodHost( char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                                   const jsmntok_t * pxTok,
+                                                   const uint32_t ulNbTokens,
+                                                   uint32_t ulTokenIndex,
+                                                   GGD_HostAddressData_t * pxHostAddressData )
+    {
+        GGD_HostAddressData_t xCandidate = *pxHostAddressData;
+        uint8_t ucCurrentInterface = 0;
+        BaseType_t xFoundGGC = pdFALSE;
+        Socket_t xSocket;
+
+        if( xLastGoodHost.cHostAddress[ 0 ] != '\0' )
         {
             while( prvGGDGetIPOnInterface( pcJSONFile,
-                                           ucTargetInterface,
+                                           ucCurrentInterface + ( uint8_t ) 1,
                                            pxTok,
-                                           ( uint32_t ) lNbTokens,
-                                           pxHostAddressData,
+                                           ulNbTokens,
+                                           &xCandidate,
                                            &ulTokenIndex,
                                            &ucCurrentInterface ) == pdPASS )
             {
-                xIsIPValid = prvIsIPvalid( ( const char * ) pxHostAddressData->pcHostAddress,
-                                           strlen( pxHostAddressData->pcHostAddress ) );
-
-                if( xIsIPValid == pdTRUE )
+                if( ( xCandidate.usPort == xLastGoodHost.usPort ) &&
+                    ( strcmp( xCandidate.pcHostAddress, xLastGoodHost.cHostAddress ) == 0 ) )
                 {
-                    if( GGD_SecureConnect_Connect( pxHostAddressData,
+                    if( GGD_SecureConnect_Connect( &xCandidate,
                                                    &xSocket,
                                                    ggdconfigTCP_RECEIVE_TIMEOUT_MS,
                                                    ggdconfigTCP_SEND_TIMEOUT_MS )
                         == pdPASS )
                     {
                         xFoundGGC = pdTRUE;
+                        *pxHostAddressData = xCandidate;
                         /* Interface found, disconnect. */
                         GGD_SecureConnect_Disconnect( &xSocket );
-                        break;
                     }
+
+                    break;
+                }
+            }
+        }
+
+        return xFoundGGC;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvGGDSetLastGoodHost( const GGD_HostAddressData_t * pxHostAddressData )
+    {
+        size_t xLength = strlen( pxHostAddressData->pcHostAddress );
+
+        if( xLength < sizeof( xLastGoodHost.cHostAddress ) )
+        {
+            ( void ) memcpy( xLastGoodHost.cHostAddress, pxHostAddressData->pcHostAddress, xLength + ( size_t ) 1 );
+            xLastGoodHost.usPort = pxHostAddressData->usPort;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* if ( ggdconfigCACHE_LAST_GOOD_HOST == 1 ) */
+
+#if ( ggdconfigMAX_PARALLEL_CONNECTS > 1 )
+
+    static BaseType_t prvGGDConnectInParallel( char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                               const jsmntok_t * pxTok,
+                                               const uint32_t ulNbTokens,
+                                               uint32_t ulTokenIndex,
+                                               GGD_HostAddressData_t * pxHostAddressData )
+    {
+        GGD_HostAddressData_t xCandidate = *pxHostAddressData;
+        GGD_HostAddressData_t pxInFlight[ ggdconfigMAX_PARALLEL_CONNECTS ];
+        GGDProbeGroup_t * pxGroup;
+        GGDProbeResult_t xResult;
+        uint8_t ucCurrentInterface = 0;
+        uint32_t ulSlot;
+        UBaseType_t uxRunning = 0;
+        BaseType_t xMoreHosts = pdTRUE;
+        BaseType_t xFoundGGC = pdFALSE;
+        Socket_t xSocket;
+
+        pxGroup = prvGGDCreateProbeGroup();
+
+        if( pxGroup == NULL )
+        {
+            /* Not enough memory for the probe tasks, try the hosts one by one. */
+            xMoreHosts = pdFALSE;
+            xFoundGGC = prvGGDConnectInOrder( pcJSONFile,
+                                              pxTok,
+                                              ulNbTokens,
+                                              ulTokenIndex,
+                                              pxHostAddressData );
+        }
+
+        for( ulSlot = 0; ulSlot < ( uint32_t ) ggdconfigMAX_PARALLEL_CONNECTS; ulSlot++ )
+        {
+            pxInFlight[ ulSlot ].pcHostAddress = NULL;
+        }
+
+        while( ( xFoundGGC == pdFALSE ) && ( ( xMoreHosts == pdTRUE ) || ( uxRunning > ( UBaseType_t ) 0 ) ) )
+        {
+            /* Keep up to ggdconfigMAX_PARALLEL_CONNECTS probes running, starting
+             * them in document order so that the preferred interfaces go first. */
+            while( ( xFoundGGC == pdFALSE ) &&
+                   ( xMoreHosts == pdTRUE ) &&
+                   ( uxRunning < ( UBaseType_t ) ggdconfigMAX_PARALLEL_CONNECTS ) )
+            {
+                xMoreHosts = prvGGDGetIPOnInterface( pcJSONFile,
+                                                     ucCurrentInterface + ( uint8_t ) 1,
+                                                     pxTok,
+                                                     ulNbTokens,
+                                                     &xCandidate,
+                                                     &ulTokenIndex,
+                                                     &ucCurrentInterface );
+
+                if( ( xMoreHosts == pdTRUE ) &&
+                    ( prvIsIPvalid( xCandidate.pcHostAddress, strlen( xCandidate.pcHostAddress ) ) == pdTRUE ) )
+                {
+                    /* There is a free slot since fewer probes than slots are running. */
+                    ulSlot = 0;
+
+                    while( pxInFlight[ ulSlot ].pcHostAddress != NULL )
+                    {
+                        ulSlot++;
+                    }
+
+                    if( prvGGDStartProbe( pxGroup, ulSlot, &xCandidate ) == pdPASS )
+                    {
+                        pxInFlight[ ulSlot ] = xCandidate;
+                        uxRunning++;
+                    }
+                    else if( GGD_SecureConnect_Connect( &xCandidate,
+                                                        &xSocket,
+                                                        ggdconfigTCP_RECEIVE_TIMEOUT_MS,
+                                                        ggdconfigTCP_SEND_TIMEOUT_MS )
+                             == pdPASS )
+                    {
+                        /* No memory for another task, this one was tried in place. */
+                        xFoundGGC = pdTRUE;
+                        *pxHostAddressData = xCandidate;
+                        GGD_SecureConnect_Disconnect( &xSocket );
+                    }
+                    else
+                    {
+                        /* Try the next host. */
+                    }
+                }
+            }
+
+            if( ( xFoundGGC == pdFALSE ) && ( uxRunning > ( UBaseType_t ) 0 ) )
+            {
+                /* Every probe gives up within its socket timeouts. */
+                ( void ) xQueueReceive( pxGroup->xResults, &xResult, portMAX_DELAY );
+                uxRunning--;
+
+                if( xResult.xStatus == pdPASS )
+                {
+                    xFoundGGC = pdTRUE;
+                    *pxHostAddressData = pxInFlight[ xResult.ulSlot ];
                 }
 
-                ucTargetInterface++;
+                pxInFlight[ xResult.ulSlot ].pcHostAddress = NULL;
             }
         }
 
-        if( xFoundGGC != pdTRUE )
+        if( pxGroup != NULL )
         {
-            ggdconfigPRINT( "GGD - Can't connect to greengrass Core\r\n" );
+            /* Probes still in flight finish on their own and the last one
+             * to exit frees the group. */
+            prvGGDReleaseProbeGroup( pxGroup );
+        }
 
-            xStatus = pdFAIL;
+        return xFoundGGC;
+    }
+/*-----------------------------------------------------------*/
+
+    static GGDProbeGroup_t * prvGGDCreateProbeGroup( void )
+    {
+        GGDProbeGroup_t * pxGroup = pvPortMalloc( sizeof( GGDProbeGroup_t ) );
+
+        if( pxGroup != NULL )
+        {
+            pxGroup->uxReferences = 1;
+            pxGroup->xResults = xQueueCreate( ( UBaseType_t ) ggdconfigMAX_PARALLEL_CONNECTS,
+                                              sizeof( GGDProbeResult_t ) );
+
+            if( pxGroup->xResults == NULL )
+            {
+                vPortFree( pxGroup );
+                pxGroup = NULL;
+            }
+        }
+
+        return pxGroup;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvGGDReleaseProbeGroup( GGDProbeGroup_t * pxGroup )
+    {
+        UBaseType_t uxReferences;
+
+        taskENTER_CRITICAL();
+        {
+            pxGroup->uxReferences--;
+            uxReferences = pxGroup->uxReferences;
+        }
+        taskEXIT_CRITICAL();
+
+        if( uxReferences == ( UBaseType_t ) 0 )
+        {
+            vQueueDelete( pxGroup->xResults );
+            vPortFree( pxGroup );
         }
     }
+/*-----------------------------------------------------------*/
 
-    return xStatus;
+    static BaseType_t prvGGDStartProbe( GGDProbeGroup_t * pxGroup,
+                                        const uint32_t ulSlot,
+                                        const GGD_HostAddressData_t * pxHostAddressData )
+    {
+        size_t xHostLength = strlen( pxHostAddressData->pcHostAddress ) + ( size_t ) 1;
+        GGDProbe_t * pxProbe;
+        char * pcCopy; /*lint !e971 can use char without signed/unsigned. */
+        BaseType_t xStatus = pdFAIL;
+
+        /* The probe can outlive the caller's buffer, so it carries its own
+         * copy of the host name and certificate. */
+        pxProbe = pvPortMalloc( sizeof( GGDProbe_t ) + xHostLength + ( size_t ) pxHostAddressData->ulCertificateSize );
+
+        if( pxProbe != NULL )
+        {
+            pcCopy = ( char * ) &pxProbe[ 1 ]; /*lint !e971 !e740 the strings are stored after the structure. */
+            ( void ) memcpy( pcCopy, pxHostAddressData->pcHostAddress, xHostLength );
+
+            pxProbe->pxGroup = pxGroup;
+            pxProbe->ulSlot = ulSlot;
+            pxProbe->xHostAddressData = *pxHostAddressData;
+            pxProbe->xHostAddressData.pcHostAddress = pcCopy;
+
+            if( pxHostAddressData->pcCertificate != NULL )
+            {
+                pcCopy = &pcCopy[ xHostLength ];
+                ( void ) memcpy( pcCopy, pxHostAddressData->pcCertificate, ( size_t ) pxHostAddressData->ulCertificateSize );
+                pxProbe->xHostAddressData.pcCertificate = pcCopy;
+            }
+
+            taskENTER_CRITICAL();
+            {
+                pxGroup->uxReferences++;
+            }
+            taskEXIT_CRITICAL();
+
+            xStatus = xTaskCreate( prvGGDProbeTask,
+                                   "GGDProbe",
+                                   ( uint16_t ) ggdconfigCONNECT_TASK_STACK_SIZE,
+                                   pxProbe,
+                                   ggdconfigCONNECT_TASK_PRIORITY,
+                                   NULL );
+
+            if( xStatus != pdPASS )
+            {
+                xStatus = pdFAIL;
+                prvGGDReleaseProbeGroup( pxGroup );
+                vPortFree( pxProbe );
+            }
+        }
+
+        return xStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvGGDProbeTask( void * pvParameters )
+    {
+        GGDProbe_t * pxProbe = ( GGDProbe_t * ) pvParameters;
+        GGDProbeResult_t xResult;
+        Socket_t xSocket;
+
+        xResult.ulSlot = pxProbe->ulSlot;
+        xResult.xStatus = GGD_SecureConnect_Connect( &pxProbe->xHostAddressData,
+                                                     &xSocket,
+                                                     ggdconfigTCP_RECEIVE_TIMEOUT_MS,
+                                                     ggdconfigTCP_SEND_TIMEOUT_MS );
+
+        /* Report before the graceful disconnect so the winner is known as
+         * soon as the handshake completes. The queue holds one entry per
+         * probe so this never blocks. */
+        ( void ) xQueueSend( pxProbe->pxGroup->xResults, &xResult, ( TickType_t ) 0 );
+
+        if( xResult.xStatus == pdPASS )
+        {
+            GGD_SecureConnect_Disconnect( &xSocket );
+        }
+
+        prvGGDReleaseProbeGroup( pxProbe->pxGroup );
+        vPortFree( pxProbe );
+        vTaskDelete( NULL );
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* if ( ggdconfigMAX_PARALLEL_CONNECTS > 1 ) */
+
+static BaseType_t prvGGDConnectInOrder( char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                        const jsmntok_t * pxTok,
+                                        const uint32_t ulNbTokens,
+                                        uint32_t ulTokenIndex,
+                                        GGD_HostAddressData_t * pxHostAddressData )
+{
+    Socket_t xSocket;
+    uint8_t ucCurrentInterface = 0, ucTargetInterface = 1;
+    BaseType_t xFoundGGC = pdFALSE;
+    BaseType_t xIsIPValid;
+
+    while( prvGGDGetIPOnInterface( pcJSONFile,
+                                   ucTargetInterface,
+                                   pxTok,
+                                   ulNbTokens,
+                                   pxHostAddressData,
+                                   &ulTokenIndex,
+                                   &ucCurrentInterface ) == pdPASS )
+    {
+        xIsIPValid = prvIsIPvalid( ( const char * ) pxHostAddressData->pcHostAddress,
+                                   strlen( pxHostAddressData->pcHostAddress ) );
+
+        if( xIsIPValid == pdTRUE )
+        {
+            if( GGD_SecureConnect_Connect( pxHostAddressData,
+                                           &xSocket,
+                                           ggdconfigTCP_RECEIVE_TIMEOUT_MS,
+                                           ggdconfigTCP_SEND_TIMEOUT_MS )
+                == pdPASS )
+            {
+                xFoundGGC = pdTRUE;
+                /* Interface found, disconnect. */
+                GGD_SecureConnect_Disconnect( &xSocket );
+                break;
+            }
+        }
+
+        ucTargetInterface++;
+    }
+
+    return xFoundGGC;
 }
 /*-----------------------------------------------------------*/
 
@@ -67,5 +67,10 @@ BaseType_t test_prvGGDGetCore( const char * pcJSONFile, /*lint !e971 can use cha
                                uint32_t * pulTokenIndex );
 BaseType_t test_prvIsIPvalid( const char * pcIP,
                               uint32_t ucIPlength );
+int32_t test_prvGGDParseJSONChunk( jsmn_parser * pxParser,
+                                   const char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                   uint32_t ulLength,
+                                   const BaseType_t xLastChunk,
+                                   jsmntok_t * pxTok );
 
 #endif /* _AWS_GREENGRASS_DISCOVERY_TEST_ACCESS_DECLARE_H_ */
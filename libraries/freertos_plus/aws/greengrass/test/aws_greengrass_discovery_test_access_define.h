@@ -133,4 +133,19 @@ BaseType_t test_prvIsIPvalid( const char * pcIP,
     return prvIsIPvalid( pcIP, ulIPlength );
 }
 
+/*-----------------------------------------------------------*/
+
+int32_t test_prvGGDParseJSONChunk( jsmn_parser * pxParser,
+                                   const char * pcJSONFile, /*lint !e971 can use char without signed/unsigned. */
+                                   uint32_t ulLength,
+                                   const BaseType_t xLastChunk,
+                                   jsmntok_t * pxTok )
+{
+    return prvGGDParseJSONChunk( pxParser,
+                                 pcJSONFile,
+                                 ulLength,
+                                 xLastChunk,
+                                 pxTok );
+}
+
 #endif /* _AWS_GREENGRASS_DISCOVERY_TEST_ACCESS_DEFINE_H_ */
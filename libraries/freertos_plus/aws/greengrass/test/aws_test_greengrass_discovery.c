@@ -95,6 +95,7 @@ TEST_GROUP_RUNNER( Full_GGD )
     RUN_TEST_CASE( Full_GGD, JSONRequestGetFile );
     RUN_TEST_CASE( Full_GGD, CheckForContentLengthString );
     RUN_TEST_CASE( Full_GGD, Jsoneq );
+    RUN_TEST_CASE( Full_GGD, ParseJSONChunk );
     RUN_TEST_CASE( Full_GGD, CheckMatch );
     RUN_TEST_CASE( Full_GGD, GetCertificate );
     RUN_TEST_CASE( Full_GGD, GetCore );
@@ -804,6 +805,92 @@ TEST( Full_GGD, CheckMatch )
     }
 }
 
+TEST( Full_GGD, ParseJSONChunk )
+{
+    const uint32_t pulChunkSizes[] = { 1, 7, 64, 1000 };
+    const char cBadJSON[] = "{\"GGGroups\":[{\"GGGroupId\":1]}}";
+    jsmn_parser xParser;
+    jsmntok_t pxChunkTok[ ggdTestJSON_MAX_TOKENS ];
+    int32_t lNbTokens, lNbChunkTokens;
+    uint32_t ulJSONFileSize = strlen( cJSON_FILE );
+    uint32_t ulSizeIndex, ulReceived, ulTokenIndex;
+
+    if( TEST_PROTECT() )
+    {
+        /** @brief Prepare test.
+         *  @{
+         */
+        jsmn_init( &xParser );
+        lNbTokens = ( int32_t ) jsmn_parse( &xParser,
+                                            cJSON_FILE,
+                                            ( size_t ) ulJSONFileSize,
+                                            pxTok,
+                                            ( unsigned int ) ggdTestJSON_MAX_TOKENS );
+        TEST_ASSERT_GREATER_THAN( 0, lNbTokens );
+        /** @}*/
+
+        /** @brief Check the file gives the same tokens however it is split,
+         *  including numbers cut in two between chunks.
+         *  @{
+         */
+        for( ulSizeIndex = 0; ulSizeIndex < sizeof( pulChunkSizes ) / sizeof( pulChunkSizes[ 0 ] ); ulSizeIndex++ )
+        {
+            jsmn_init( &xParser );
+            ulReceived = 0;
+
+            do
+            {
+                ulReceived += pulChunkSizes[ ulSizeIndex ];
+
+                if( ulReceived > ulJSONFileSize )
+                {
+                    ulReceived = ulJSONFileSize;
+                }
+
+                lNbChunkTokens = test_prvGGDParseJSONChunk( &xParser,
+                                                            cJSON_FILE,
+                                                            ulReceived,
+                                                            ( ulReceived == ulJSONFileSize ) ? pdTRUE : pdFALSE,
+                                                            pxChunkTok );
+
+                if( ulReceived < ulJSONFileSize )
+                {
+                    TEST_ASSERT_EQUAL_INT32( JSMN_ERROR_PART, lNbChunkTokens );
+                }
+            }
+            while( ulReceived < ulJSONFileSize );
+
+            TEST_ASSERT_EQUAL_INT32( lNbTokens, lNbChunkTokens );
+
+            for( ulTokenIndex = 0; ulTokenIndex < ( uint32_t ) lNbTokens; ulTokenIndex++ )
+            {
+                TEST_ASSERT_EQUAL_INT32( pxTok[ ulTokenIndex ].type, pxChunkTok[ ulTokenIndex ].type );
+                TEST_ASSERT_EQUAL_INT32( pxTok[ ulTokenIndex ].start, pxChunkTok[ ulTokenIndex ].start );
+                TEST_ASSERT_EQUAL_INT32( pxTok[ ulTokenIndex ].end, pxChunkTok[ ulTokenIndex ].end );
+                TEST_ASSERT_EQUAL_INT32( pxTok[ ulTokenIndex ].size, pxChunkTok[ ulTokenIndex ].size );
+            }
+        }
+
+        /** @}*/
+
+        /** @brief Check a malformed file is rejected before the last chunk.
+         *  @{
+         */
+        jsmn_init( &xParser );
+        lNbChunkTokens = test_prvGGDParseJSONChunk( &xParser,
+                                                    cBadJSON,
+                                                    strlen( cBadJSON ) - 1,
+                                                    pdFALSE,
+                                                    pxChunkTok );
+        TEST_ASSERT_EQUAL_INT32( JSMN_ERROR_INVAL, lNbChunkTokens );
+        /** @}*/
+    }
+    else
+    {
+        TEST_FAIL();
+    }
+}
+
 TEST( Full_GGD, Jsoneq )
 {
     BaseType_t xStatus;
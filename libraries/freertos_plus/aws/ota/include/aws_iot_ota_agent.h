@@ -154,6 +154,7 @@ typedef uint32_t OTA_Err_t;
 #define kOTA_Err_UserAbort               0x28000000UL     /*!< User aborted the active OTA. */
 #define kOTA_Err_ResetNotSupported       0x29000000UL     /*!< We tried to reset the device but the device doesn't support it. */
 #define kOTA_Err_TopicTooLarge           0x2a000000UL     /*!< Attempt to build a topic string larger than the supplied buffer. */
+#define kOTA_Err_CheckpointFailed        0x2b000000UL     /*!< The PAL failed to save or load the file transfer checkpoint. */
 
 /**
  * @brief OTA Job callback events.
@@ -206,6 +207,27 @@ typedef enum
 } OTA_ImageState_t;
 
 
+/**
+ * @brief OTA stream request window.
+ *
+ * State of the pipelined block requester used when otaconfigPIPELINE_BLOCK_REQUESTS is enabled.
+ * Block counts are in units of the smallest block size, 1 << otaconfigLOG2_FILE_BLOCK_SIZE, which
+ * is also the unit of the receive block bitmap.
+ */
+typedef struct
+{
+    uint8_t * pucInFlightBitmap; /*!< Bitmap of blocks requested from the stream but not yet received. */
+    uint32_t ulInFlight;         /*!< Number of blocks requested but not yet received. */
+    uint32_t ulWindow;           /*!< Maximum number of blocks allowed in flight. */
+    uint32_t ulThreshold;        /*!< Window size above which the window grows linearly instead of doubling. */
+    uint32_t ulGrowth;           /*!< Blocks received since the window last grew linearly. */
+    uint32_t ulSinceLoss;        /*!< Blocks received since the window was last reduced. */
+    uint32_t ulNextBlock;        /*!< Next block to consider requesting in the current pass over the file. */
+    uint32_t ulLog2BlockSize;    /*!< Log base 2 of the block size being requested. */
+    bool_t xFixedBlockSize;      /*!< True if the stream doesn't echo our client token so the block size can't change. */
+} OTA_RequestWindow_t;
+
+
 /**
  * @brief OTA File Context Information.
  *
@@ -237,6 +259,14 @@ typedef struct
     uint8_t * pucCertFilepath;   /*!< Pathname of the certificate file used to validate the receive file. */
     uint32_t ulUpdaterVersion;   /*!< Used by OTA self-test detection, the version of FW that did the update. */
     bool_t xIsInSelfTest;        /*!< True if the job is in self test mode. */
+    void * pvSigVerifyContext;   /*!< Signature verification context fed as blocks are received, or NULL to hash the file at close. */
+    uint32_t ulHashedBlocks;     /*!< Number of leading file blocks already fed to pvSigVerifyContext. */
+    bool_t xResume;              /*!< True if the file was partially received before a reset and must be reopened, not recreated. */
+    OTA_RequestWindow_t xWindow; /*!< Pipelined block request state. */
+    uint8_t * pucCompression;    /*!< Compression of the file on the stream, or NULL if it is sent as is. */
+    uint32_t ulImageSize;        /*!< The size of the file once decompressed. Equal to ulFileSize if it isn't compressed. */
+    void * pvInflateContext;     /*!< Decompressor of a compressed file, or NULL. */
+    uint32_t ulInflatedBlocks;   /*!< Number of leading file blocks already fed to pvInflateContext. */
 } OTA_FileContext_t;
 
 
@@ -287,15 +317,16 @@ typedef enum
 
 typedef enum
 {
-    eOTA_JobParseErr_Unknown = -1,        /* The error code has not yet been set by a logic path. */
-    eOTA_JobParseErr_None = 0,            /* Signifies no error has occurred. */
-    eOTA_JobParseErr_BusyWithExistingJob, /* We're busy with a job but received a new job document. */
-    eOTA_JobParseErr_NullJob,             /* A null job was reported (no job ID). */
-    eOTA_JobParseErr_BusyWithSameJob,     /* We're already busy with the reported job ID. */
-    eOTA_JobParseErr_ZeroFileSize,        /* Job document specified a zero sized file. This is not allowed. */
-    eOTA_JobParseErr_NonConformingJobDoc, /* The job document failed to fulfill the model requirements. */
-    eOTA_JobParseErr_BadModelInitParams,  /* There was an invalid initialization parameter used in the document model. */
-    eOTA_JobParseErr_NoContextAvailable   /* There wasn't an OTA context available. */
+    eOTA_JobParseErr_Unknown = -1,          /* The error code has not yet been set by a logic path. */
+    eOTA_JobParseErr_None = 0,              /* Signifies no error has occurred. */
+    eOTA_JobParseErr_BusyWithExistingJob,   /* We're busy with a job but received a new job document. */
+    eOTA_JobParseErr_NullJob,               /* A null job was reported (no job ID). */
+    eOTA_JobParseErr_BusyWithSameJob,       /* We're already busy with the reported job ID. */
+    eOTA_JobParseErr_ZeroFileSize,          /* Job document specified a zero sized file. This is not allowed. */
+    eOTA_JobParseErr_NonConformingJobDoc,   /* The job document failed to fulfill the model requirements. */
+    eOTA_JobParseErr_BadModelInitParams,    /* There was an invalid initialization parameter used in the document model. */
+    eOTA_JobParseErr_NoContextAvailable,    /* There wasn't an OTA context available. */
+    eOTA_JobParseErr_UnsupportedCompression /* Job document specified a compression that isn't supported. */
 } OTA_JobParseErr_t;
 
 /**
@@ -390,6 +421,38 @@ typedef int16_t (* pxOTAPALWriteBlockCallback_t)( OTA_FileContext_t * const C,
                                                   uint8_t * const pacData,
                                                   uint32_t iBlockSize );
 
+/**
+ * @brief OTA Save Checkpoint callback function typedef.
+ *
+ * The user may register a callback function when initializing the OTA Agent. This
+ * callback is used to persist the progress of a file transfer so that it can be resumed
+ * after a reset. All blocks written to the file so far must be made durable before the
+ * checkpoint is saved. A NULL pucData with a zero ulSize erases the saved checkpoint.
+ *
+ * @param[in] C File context of the transfer
+ * @param[in] pucData Checkpoint data to persist. Its format is private to the OTA agent.
+ * @param[in] ulSize Size of the checkpoint data
+ */
+typedef OTA_Err_t (* pxOTAPALSaveCheckpointCallback_t)( OTA_FileContext_t * const C,
+                                                        const uint8_t * pucData,
+                                                        uint32_t ulSize );
+
+/**
+ * @brief OTA Load Checkpoint callback function typedef.
+ *
+ * The user may register a callback function when initializing the OTA Agent. This
+ * callback is used to read back the checkpoint last saved by the Save Checkpoint callback.
+ *
+ * @param[in] C File context of the transfer
+ * @param[out] pucData Buffer to receive the checkpoint data
+ * @param[in] ulMaxSize Size of the buffer
+ *
+ * @return The size of the checkpoint, or 0 if there is none or it doesn't fit in the buffer.
+ */
+typedef uint32_t (* pxOTAPALLoadCheckpointCallback_t)( OTA_FileContext_t * const C,
+                                                       uint8_t * pucData,
+                                                       uint32_t ulMaxSize );
+
 /**
  * @brief Custom Job callback function typedef.
  *
@@ -415,6 +478,8 @@ typedef struct
     pxOTAPALWriteBlockCallback_t xWriteBlock;                       /* OTA Write Block callback pointer */
     pxOTACompleteCallback_t xCompleteCallback;                      /* OTA Job Completed callback pointer */
     pxOTACustomJobCallback_t xCustomJobCallback;                    /* OTA Custom Job callback pointer */
+    pxOTAPALSaveCheckpointCallback_t xSaveCheckpoint;               /* OTA Save Checkpoint callback pointer (optional) */
+    pxOTAPALLoadCheckpointCallback_t xLoadCheckpoint;               /* OTA Load Checkpoint callback pointer (optional) */
 } OTA_PAL_Callbacks_t;
 
 
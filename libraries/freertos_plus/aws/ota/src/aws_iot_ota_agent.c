@@ -43,6 +43,16 @@
 /* Internal header file for shared definitions. */
 #include "aws_ota_agent_internal.h"
 
+#if ( otaconfigHASH_ON_INGEST == 1 )
+    /* Crypto includes for hashing file blocks as they are received. */
+    #include "iot_crypto.h"
+#endif
+
+#if ( otaconfigDECOMPRESS_IMAGES == 1 )
+    /* Streaming decompression of compressed files. */
+    #include "aws_ota_inflate.h"
+#endif
+
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"     /*lint !e537 intentional include of all interfaces used by this file. */
 #include "timers.h"       /*lint !e537 intentional include of all interfaces used by this file. */
@@ -84,11 +94,15 @@
 #define OTA_EVT_MASK_SHUTDOWN              0x00000002UL /* Event flag to request OTA shutdown. */
 #define OTA_EVT_MASK_REQ_TIMEOUT           0x00000004UL /* Event flag indicating the request timer has timed out. */
 #define OTA_EVT_MASK_USER_ABORT            0x00000008UL /* Event flag to indicate user initiated OTA abort. */
-#define OTA_EVT_MASK_ALL_EVENTS            ( OTA_EVT_MASK_MSG_READY | OTA_EVT_MASK_SHUTDOWN | OTA_EVT_MASK_REQ_TIMEOUT | OTA_EVT_MASK_USER_ABORT )
+#define OTA_EVT_MASK_REQ_BLOCKS            0x00000010UL /* Event flag to request more blocks without waiting for the request timer. */
+#define OTA_EVT_MASK_ALL_EVENTS            ( OTA_EVT_MASK_MSG_READY | OTA_EVT_MASK_SHUTDOWN | OTA_EVT_MASK_REQ_TIMEOUT | OTA_EVT_MASK_USER_ABORT | OTA_EVT_MASK_REQ_BLOCKS )
 
 /* Stream GET message constants. */
 
 #define OTA_CLIENT_TOKEN             "rdy"              /* Arbitrary client token sent in the stream "GET" message. */
+#define OTA_CLIENT_TOKEN_TAG_LEN     2U                 /* Max digits of the block size tag appended to the client token of pipelined requests. */
+#define OTA_CLIENT_TOKEN_MAX_SIZE    ( sizeof( OTA_CLIENT_TOKEN ) + OTA_CLIENT_TOKEN_TAG_LEN )
+#define OTA_WINDOW_INITIAL_BLOCKS    4U                 /* Number of blocks a pipelined transfer starts with in flight. */
 #define OTA_MAX_BLOCK_BITMAP_SIZE    128U               /* Max allowed number of bytes to track all blocks of an OTA file. Adjust block size if more range is needed. */
 #define OTA_REQUEST_MSG_MAX_SIZE     ( 3U * OTA_MAX_BLOCK_BITMAP_SIZE )
 
@@ -96,6 +110,7 @@
 
 #define OTA_STATUS_MSG_MAX_SIZE        128U             /* Max length of a job status message to the service. */
 #define OTA_UPDATE_STATUS_FREQUENCY    64U              /* Update the job status every 64 unique blocks received. */
+#define OTA_CHECKPOINT_MAGIC           0x4f544143UL     /* Identifies a file transfer checkpoint written by this version of the agent ("OTAC"). */
 
 /* Job document parser constants. */
 
@@ -112,7 +127,7 @@ typedef enum
     eOTA_PubMsgType_Stream   /* Messages on the topic are stream messages. */
 } OTA_PubMsgType_t;
 
-#define OTA_DATA_BLOCK_SIZE    ( ( 1 << otaconfigLOG2_FILE_BLOCK_SIZE ) + 30 ) /* header is 19 bytes .*/
+#define OTA_DATA_BLOCK_SIZE    ( ( 1 << otaconfigLOG2_MAX_FILE_BLOCK_SIZE ) + 30 + OTA_CLIENT_TOKEN_TAG_LEN ) /* header is 19 bytes .*/
 
 typedef struct
 {
@@ -135,9 +150,11 @@ typedef struct
  * size, attributes, etc. The following value specifies the number of parameters
  * that are included in the job document model although some may be optional. */
 
-#define OTA_NUM_JOB_PARAMS         ( 16 ) /* Number of parameters in the job document. */
+#define OTA_NUM_JOB_PARAMS         ( 18 ) /* Number of parameters in the job document. */
 /* We need the following string to match in a couple places in the code so use a #define. */
 #define OTA_JSON_UPDATED_BY_KEY    "updatedBy"
+/* The only compression of a file supported in the job document. */
+#define OTA_COMPRESSION_ZLIB       "zlib"
 
 static const char pcOTA_JSON_ClientTokenKey[] = "clientToken";
 static const char pcOTA_JSON_ExecutionKey[] = "execution";
@@ -154,6 +171,8 @@ static const char pcOTA_JSON_FileSizeKey[] = "filesize";
 static const char pcOTA_JSON_FileIDKey[] = "fileid";
 static const char pcOTA_JSON_FileAttributeKey[] = "attr";
 static const char pcOTA_JSON_FileCertNameKey[] = "certfile";
+static const char pcOTA_JSON_FileCompressionKey[] = "compression";
+static const char pcOTA_JSON_FileRawSizeKey[] = "rawsize";
 
 enum
 {
@@ -318,6 +337,137 @@ static IngestResult_t prvIngestDataBlock( OTA_FileContext_t * C,
                                           uint32_t ulMsgSize,
                                           OTA_Err_t * pxCloseResult );
 
+#if ( otaconfigHASH_ON_INGEST == 1 )
+
+/* Start hashing the blocks of a file as they are received. */
+
+    static void prvStartFileHash( OTA_FileContext_t * C );
+
+/* Feed a newly written block into the file's signature verification context. */
+
+    static void prvHashDataBlock( OTA_FileContext_t * C,
+                                  uint32_t ulBlockIndex,
+                                  const uint8_t * pucPayload,
+                                  uint32_t ulBlockSize );
+
+/* Hash the part of a block that isn't already in the hashed prefix of the file. */
+
+    static void prvHashBlockTail( OTA_FileContext_t * C,
+                                  uint32_t ulBlockIndex,
+                                  const uint8_t * pucPayload,
+                                  uint32_t ulBlockSize );
+
+/* Stop hashing the file and release the signature verification context and any held blocks. */
+
+    static void prvStopFileHash( OTA_FileContext_t * C );
+#endif /* otaconfigHASH_ON_INGEST */
+
+#if ( otaconfigDECOMPRESS_IMAGES == 1 )
+
+/* Start decompressing the blocks of a compressed file as they are received. */
+
+    static bool_t prvStartInflate( OTA_FileContext_t * C );
+
+/* Feed a newly received block of a compressed file into its decompressor. */
+
+    static IngestResult_t prvInflateDataBlock( OTA_FileContext_t * C,
+                                               uint32_t ulBlockIndex,
+                                               const uint8_t * pucPayload,
+                                               uint32_t ulBlockSize );
+
+/* Decompress the part of a block that isn't already in the decompressed prefix of the file. */
+
+    static IngestResult_t prvInflateBlockTail( OTA_FileContext_t * C,
+                                               uint32_t ulBlockIndex,
+                                               const uint8_t * pucPayload,
+                                               uint32_t ulBlockSize );
+
+/* Write decompressed data to the file. Called by the decompressor. */
+
+    static BaseType_t prvInflateOutput( void * pvContext,
+                                        uint32_t ulOffset,
+                                        const uint8_t * pucData,
+                                        uint32_t ulSize );
+
+/* Check that all of a compressed file was received and decompressed to the expected size. */
+
+    static bool_t prvFinishInflate( OTA_FileContext_t * C );
+
+/* Release the decompressor of a file and any blocks held for it. */
+
+    static void prvStopInflate( OTA_FileContext_t * C );
+#endif /* otaconfigDECOMPRESS_IMAGES */
+
+/* Persist the progress of a file transfer so it can be resumed after a reset. */
+
+static void prvSaveCheckpoint( OTA_FileContext_t * C );
+
+/* Erase any persisted file transfer progress. */
+
+static void prvEraseCheckpoint( OTA_FileContext_t * C );
+
+/* Restore the progress of an interrupted transfer of the same file, if one was saved. */
+
+static bool_t prvRestoreCheckpoint( OTA_FileContext_t * C );
+
+/* Mark every block of a file as still needed in its block bitmap. */
+
+static void prvResetBlockBitmap( OTA_FileContext_t * C,
+                                 uint32_t ulNumBlocks,
+                                 uint32_t ulBitmapLen );
+
+/* Count the blocks in a range that are still needed according to the block bitmap. */
+
+static uint32_t prvCountMissingBlocks( OTA_FileContext_t * C,
+                                       uint32_t ulFirstBlock,
+                                       uint32_t ulNumBlocks );
+
+/* Mark a range of blocks as received in the block bitmap. */
+
+static void prvMarkBlocksReceived( OTA_FileContext_t * C,
+                                   uint32_t ulFirstBlock,
+                                   uint32_t ulNumBlocks );
+
+#if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+
+/* Open the request window for a new file transfer. */
+
+    static bool_t prvWindowStart( OTA_FileContext_t * C,
+                                  uint32_t ulBitmapLen );
+
+/* Release the request window of a file transfer. */
+
+    static void prvWindowStop( OTA_FileContext_t * C );
+
+/* Choose the blocks to ask for in the next stream request. */
+
+    static uint32_t prvWindowSelectBlocks( OTA_FileContext_t * C,
+                                           uint8_t * pucBitmap,
+                                           uint32_t ulMaxBitmapLen,
+                                           uint32_t * pulBitmapLen );
+
+/* Shrink the window after blocks were lost. */
+
+    static void prvWindowReduce( OTA_FileContext_t * C,
+                                 bool_t xForce );
+
+/* Account for a block received from the stream and adapt the window. */
+
+    static void prvWindowBlockReceived( OTA_FileContext_t * C,
+                                        uint32_t ulFirstBlock,
+                                        uint32_t ulNumBlocks );
+
+/* Treat every block in flight as lost after the request timer expired. */
+
+    static void prvWindowTimeout( OTA_FileContext_t * C );
+
+/* Find the log base 2 of the size a received stream block was requested with. */
+
+    static uint32_t prvWindowBlockLog2( OTA_FileContext_t * C,
+                                        const char * pcRawMsg,
+                                        uint32_t ulMsgSize );
+#endif /* otaconfigPIPELINE_BLOCK_REQUESTS */
+
 /* Called when the OTA agent receives an OTA version message. */
 
 static OTA_FileContext_t * prvProcessOTAJobMsg( const char * pcRawMsg,
@@ -428,6 +578,31 @@ typedef struct ota_agent_statistics
     uint32_t ulOTA_PublishFailures;  /* Number of MQTT publish failures. */
 } OTA_AgentStatistics_t;
 
+#if ( otaconfigHASH_ON_INGEST == 1 ) || ( otaconfigDECOMPRESS_IMAGES == 1 )
+
+/* A file block received ahead of the hashed or decompressed prefix of the file, held until the gap fills. */
+
+    typedef struct
+    {
+        uint8_t * pucData;     /* The block payload, or NULL if this slot is free. */
+        uint32_t ulBlockIndex; /* The index of the block within the file. */
+        uint32_t ulBlockSize;  /* The size of the block payload in bytes. */
+    } OTA_PendingBlock_t;
+#endif
+
+/* Header of the file transfer checkpoint saved through the PAL. It is followed by the job name,
+ * the stream name and the block bitmap of the file. */
+
+typedef struct
+{
+    uint32_t ulMagic;         /* Always OTA_CHECKPOINT_MAGIC. */
+    uint32_t ulServerFileID;  /* The file ID within the job. */
+    uint32_t ulFileSize;      /* The size of the file in bytes. */
+    uint32_t ulJobNameLen;    /* Length of the job name that follows the header. */
+    uint32_t ulStreamNameLen; /* Length of the stream name that follows the job name. */
+    uint32_t ulBitmapLen;     /* Length of the block bitmap that follows the stream name. */
+} OTA_Checkpoint_t;
+
 /* The OTA agent is a singleton today. The structure keeps it nice and organized. */
 
 typedef struct ota_agent_context
@@ -446,10 +621,24 @@ typedef struct ota_agent_context
     OTA_AgentStatistics_t xStatistics;                      /* The OTA agent statistics block. */
     OTA_PAL_Callbacks_t xPALCallbacks;                      /* Variable to store PAL callbacks */
     uint32_t ulServerFileID;                                /* Variable to store current file ID passed down */
+    #if ( otaconfigHASH_ON_INGEST == 1 )
+        OTA_PendingBlock_t pxPendingBlocks[ otaconfigMAX_HASH_PENDING_BLOCKS ]; /* Out of order blocks waiting to be hashed. */
+    #endif
+    #if ( otaconfigDECOMPRESS_IMAGES == 1 )
+        OTA_PendingBlock_t pxInflatePendingBlocks[ otaconfigMAX_DECOMPRESS_PENDING_BLOCKS ]; /* Out of order blocks waiting to be decompressed. */
+    #endif
 } OTA_AgentContext_t;
 
 
 
+#if ( otaconfigRESUME_TRANSFERS == 1 )
+    #define OTA_PAL_DEFAULT_SAVE_CHECKPOINT    prvPAL_SaveCheckpoint
+    #define OTA_PAL_DEFAULT_LOAD_CHECKPOINT    prvPAL_LoadCheckpoint
+#else
+    #define OTA_PAL_DEFAULT_SAVE_CHECKPOINT    NULL
+    #define OTA_PAL_DEFAULT_LOAD_CHECKPOINT    NULL
+#endif
+
 #define OTA_JOB_CALLBACK_DEFAULT_INITIALIZER                           \
     {                                                                  \
         .xAbort = prvPAL_Abort,                                        \
@@ -461,7 +650,9 @@ typedef struct ota_agent_context
         .xSetPlatformImageState = prvPAL_DefaultSetPlatformImageState, \
         .xWriteBlock = prvPAL_WriteBlock,                              \
         .xCompleteCallback = prvDefaultOTACompleteCallback,            \
-        .xCustomJobCallback = prvDefaultCustomJobCallback              \
+        .xCustomJobCallback = prvDefaultCustomJobCallback,             \
+        .xSaveCheckpoint = OTA_PAL_DEFAULT_SAVE_CHECKPOINT,            \
+        .xLoadCheckpoint = OTA_PAL_DEFAULT_LOAD_CHECKPOINT             \
     }
 
 /* This is THE OTA agent context and initialization state. */
@@ -699,6 +890,25 @@ OTA_State_t OTA_AgentInit_internal( void * pvClient,
         {
             xOTA_Agent.xPALCallbacks.xCustomJobCallback = prvDefaultCustomJobCallback;
         }
+
+        /* The checkpoint callbacks are optional. Without them, transfers aren't resumable. */
+        if( xCallbacks->xSaveCheckpoint != NULL )
+        {
+            xOTA_Agent.xPALCallbacks.xSaveCheckpoint = xCallbacks->xSaveCheckpoint;
+        }
+        else
+        {
+            xOTA_Agent.xPALCallbacks.xSaveCheckpoint = OTA_PAL_DEFAULT_SAVE_CHECKPOINT;
+        }
+
+        if( xCallbacks->xLoadCheckpoint != NULL )
+        {
+            xOTA_Agent.xPALCallbacks.xLoadCheckpoint = xCallbacks->xLoadCheckpoint;
+        }
+        else
+        {
+            xOTA_Agent.xPALCallbacks.xLoadCheckpoint = OTA_PAL_DEFAULT_LOAD_CHECKPOINT;
+        }
     }
 
     /* Reset our statistics counters. */
@@ -1363,30 +1573,55 @@ static OTA_Err_t prvPublishGetStreamMessage( OTA_FileContext_t * C )
 
     uint32_t ulMsgSizeToPublish;
     size_t xMsgSizeFromStream;
-    uint32_t ulNumBlocks, ulBitmapLen, ulTopicLen;
+    uint32_t ulNumBlocks, ulBitmapLen, ulTopicLen, ulBlockSize;
+    uint8_t * pucBitmap;
     IotMqttError_t eResult;
     OTA_Err_t xErr = kOTA_Err_None;
     char pcMsg[ OTA_REQUEST_MSG_MAX_SIZE ];
     char pcTopicBuffer[ OTA_MAX_TOPIC_LEN ];
 
+    #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+        uint8_t pucWindowBitmap[ OTA_MAX_BLOCK_BITMAP_SIZE ];
+        char pcClientToken[ OTA_CLIENT_TOKEN_MAX_SIZE ];
+    #else
+        const char * pcClientToken = OTA_CLIENT_TOKEN;
+    #endif
+
     if( C != NULL )
     {
-        if( C->ulRequestMomentum < OTA_MAX_STREAM_REQUEST_MOMENTUM )
-        {
+        #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+
+            /* Only ask for the blocks the window has room for. The block size is tagged onto the
+             * client token so the blocks can be placed even if the block size changes meanwhile. */
+            ulNumBlocks = prvWindowSelectBlocks( C, pucWindowBitmap, sizeof( pucWindowBitmap ), &ulBitmapLen );
+            ulBlockSize = 1UL << C->xWindow.ulLog2BlockSize;
+            pucBitmap = pucWindowBitmap;
+            ( void ) snprintf( pcClientToken, sizeof( pcClientToken ), "%s%u", OTA_CLIENT_TOKEN, ( unsigned int ) C->xWindow.ulLog2BlockSize ); /*lint -e586 Intentionally using snprintf. */
+        #else
             ulNumBlocks = ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
             ulBitmapLen = ( ulNumBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
+            ulBlockSize = OTA_FILE_BLOCK_SIZE;
+            pucBitmap = C->pucRxBlockBitmap;
+            ulNumBlocks = otaconfigMAX_NUM_BLOCKS_REQUEST;
+        #endif
 
+        if( ulNumBlocks == 0U )
+        {
+            /* The request window is full or every missing block is already in flight. */
+        }
+        else if( C->ulRequestMomentum < OTA_MAX_STREAM_REQUEST_MOMENTUM )
+        {
             if( pdTRUE == OTA_CBOR_Encode_GetStreamRequestMessage(
                     ( uint8_t * ) pcMsg,
                     sizeof( pcMsg ),
                     &xMsgSizeFromStream,
-                    OTA_CLIENT_TOKEN,
+                    pcClientToken,
                     ( int32_t ) C->ulServerFileID,
-                    ( int32_t ) ( OTA_FILE_BLOCK_SIZE & 0x7fffffffUL ), /* Mask to keep lint happy. It's still a constant. */
+                    ( int32_t ) ( ulBlockSize & 0x7fffffffUL ), /* Mask to keep lint happy. */
                     0,
-                    C->pucRxBlockBitmap,
+                    pucBitmap,
                     ulBitmapLen,
-                    otaconfigMAX_NUM_BLOCKS_REQUEST ) )
+                    ( int32_t ) ulNumBlocks ) )
             {
                 ulMsgSizeToPublish = ( uint32_t ) xMsgSizeFromStream;
 
@@ -1541,7 +1776,10 @@ static void prvOTAUpdateTask( void * pvUnused )
     OTA_FileContext_t * C = NULL;
     OTA_Err_t xErr;
     OTA_PubMsg_t * pxMsgMetaData;
-    uint32_t ulNumOfBlocksToReceive = otaconfigMAX_NUM_BLOCKS_REQUEST;
+
+    #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 0 )
+        uint32_t ulNumOfBlocksToReceive = otaconfigMAX_NUM_BLOCKS_REQUEST;
+    #endif
 
     ( void ) pvUnused;
 
@@ -1590,11 +1828,18 @@ static void prvOTAUpdateTask( void * pvUnused )
                 }
 
                 /* On OTA request timer timeout, publish the stream request if we have context. */
-                if( ( ( uxBits & OTA_EVT_MASK_REQ_TIMEOUT ) != 0U ) && ( C != NULL ) )
+                if( ( ( uxBits & ( OTA_EVT_MASK_REQ_TIMEOUT | OTA_EVT_MASK_REQ_BLOCKS ) ) != 0U ) && ( C != NULL ) )
                 {
                     if( C->ulBlocksRemaining > 0U )
                     {
-                        ulNumOfBlocksToReceive = otaconfigMAX_NUM_BLOCKS_REQUEST;
+                        #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+                            if( ( uxBits & OTA_EVT_MASK_REQ_TIMEOUT ) != 0U )
+                            {
+                                prvWindowTimeout( C ); /* Nothing arrived for a while so the blocks in flight were lost. */
+                            }
+                        #else
+                            ulNumOfBlocksToReceive = otaconfigMAX_NUM_BLOCKS_REQUEST;
+                        #endif
 
                         xErr = prvPublishGetStreamMessage( C );
 
@@ -1668,6 +1913,11 @@ static void prvOTAUpdateTask( void * pvUnused )
                                 else
                                 {
                                     xOTA_Agent.eState = eOTA_AgentState_Active;
+
+                                    #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+                                        /* Open the request window right away instead of waiting for the request timer. */
+                                        ( void ) xEventGroupSetBits( xOTA_Agent.xOTA_EventFlags, OTA_EVT_MASK_REQ_BLOCKS );
+                                    #endif
                                 }
                             }
                             /* It's not a job message, maybe it's a data stream message... */
@@ -1727,30 +1977,37 @@ static void prvOTAUpdateTask( void * pvUnused )
                                     }
                                     else
                                     {
-                                        if( xResult == eIngest_Result_Accepted_Continue )
+                                        if( ( xResult == eIngest_Result_Accepted_Continue ) || ( xResult == eIngest_Result_Deferred_Continue ) )
                                         {
                                             /* We're actively receiving a file so update the job status as needed. */
                                             /* First reset the momentum counter since we received a good block. */
                                             C->ulRequestMomentum = 0;
                                             prvUpdateJobStatus( C, eJobStatus_InProgress, ( int32_t ) eJobReason_Receiving, ( int32_t ) NULL );
 
-                                            /* Check if we have received expected number of blocks for the current request. */
-                                            if( ulNumOfBlocksToReceive > 1 )
-                                            {
-                                                ulNumOfBlocksToReceive--;
-                                            }
-                                            else
-                                            {
-                                                /* Received number of data blocks requested so restart the request timer.*/
-                                                prvStartRequestTimer( C );
-
-                                                /* Send the event to request next set of data blocks.*/
-                                                if( xOTA_Agent.xOTA_EventFlags != NULL )
+                                            #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 0 )
+                                                /* Check if we have received expected number of blocks for the current request. */
+                                                if( ulNumOfBlocksToReceive > 1 )
                                                 {
-                                                    ( void ) xEventGroupSetBits( xOTA_Agent.xOTA_EventFlags, OTA_EVT_MASK_REQ_TIMEOUT );
+                                                    ulNumOfBlocksToReceive--;
                                                 }
-                                            }
+                                                else
+                                                {
+                                                    /* Received number of data blocks requested so restart the request timer.*/
+                                                    prvStartRequestTimer( C );
+
+                                                    /* Send the event to request next set of data blocks.*/
+                                                    if( xOTA_Agent.xOTA_EventFlags != NULL )
+                                                    {
+                                                        ( void ) xEventGroupSetBits( xOTA_Agent.xOTA_EventFlags, OTA_EVT_MASK_REQ_TIMEOUT );
+                                                    }
+                                                }
+                                            #endif
                                         }
+
+                                        #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+                                            /* Blocks that arrived, even duplicates, make room in the request window. */
+                                            ( void ) xEventGroupSetBits( xOTA_Agent.xOTA_EventFlags, OTA_EVT_MASK_REQ_BLOCKS );
+                                        #endif
                                     }
                                 }
                             }
@@ -1963,6 +2220,19 @@ static bool_t prvOTA_Close( OTA_FileContext_t * const C )
             C->xRequestTimer = NULL;
         }
 
+        /* A transfer is still in progress if we have a block bitmap. */
+        if( C->pucRxBlockBitmap != NULL )
+        {
+            if( xOTA_Agent.eState == eOTA_AgentState_ShuttingDown )
+            {
+                prvSaveCheckpoint( C ); /* Keep the progress made so far so the transfer resumes when the agent restarts. */
+            }
+            else
+            {
+                prvEraseCheckpoint( C ); /* The transfer is being abandoned so there is nothing to resume. */
+            }
+        }
+
         if( C->pucStreamName != NULL )
         {
             ( void ) prvUnSubscribeFromDataStream( C ); /* Unsubscribe from the data stream if needed. */
@@ -2000,6 +2270,24 @@ static bool_t prvOTA_Close( OTA_FileContext_t * const C )
             C->pucCertFilepath = NULL;
         }
 
+        if( C->pucCompression != NULL )
+        {
+            vPortFree( C->pucCompression ); /* Free the compression name string memory. */
+            C->pucCompression = NULL;
+        }
+
+        #if ( otaconfigHASH_ON_INGEST == 1 )
+            prvStopFileHash( C ); /* Release any hash state left over from an incomplete transfer. */
+        #endif
+
+        #if ( otaconfigDECOMPRESS_IMAGES == 1 )
+            prvStopInflate( C ); /* Release the decompressor of a compressed file. */
+        #endif
+
+        #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+            prvWindowStop( C ); /* Release the request window of an incomplete transfer. */
+        #endif
+
         /* Abort any active file access and release the file resource, if needed. */
         ( void ) xOTA_Agent.xPALCallbacks.xAbort( C );
         memset( C, 0, sizeof( OTA_FileContext_t ) ); /* Clear the entire structure now that it is free. */
@@ -2498,6 +2786,8 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
         { pcOTA_JSON_FileCertNameKey,  OTA_JOB_PARAM_REQUIRED, { OFFSET_OF( OTA_FileContext_t, pucCertFilepath )}, eModelParamType_StringCopy,  JSMN_STRING    },
         { cOTA_JSON_FileSignatureKey,  OTA_JOB_PARAM_REQUIRED, { OFFSET_OF( OTA_FileContext_t, pxSignature )   }, eModelParamType_SigBase64,   JSMN_STRING    },
         { pcOTA_JSON_FileAttributeKey, OTA_JOB_PARAM_OPTIONAL, { OFFSET_OF( OTA_FileContext_t, ulFileAttributes )}, eModelParamType_UInt32,      JSMN_PRIMITIVE },
+        { pcOTA_JSON_FileCompressionKey, OTA_JOB_PARAM_OPTIONAL, { OFFSET_OF( OTA_FileContext_t, pucCompression )}, eModelParamType_StringCopy, JSMN_STRING  },
+        { pcOTA_JSON_FileRawSizeKey,   OTA_JOB_PARAM_OPTIONAL, { OFFSET_OF( OTA_FileContext_t, ulImageSize )   }, eModelParamType_UInt32,      JSMN_PRIMITIVE },
     };
 
     OTA_JobParseErr_t eErr = eOTA_JobParseErr_Unknown;
@@ -2527,11 +2817,23 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
         { /* Validate the job document parameters. */
             eErr = eOTA_JobParseErr_None;
 
-            if( C->ulFileSize == 0U )
+            if( C->pucCompression == NULL )
+            {
+                C->ulImageSize = C->ulFileSize; /* The file is stored as it is received. */
+            }
+
+            /* A compressed file must also give its decompressed size. */
+            if( ( C->ulFileSize == 0U ) || ( C->ulImageSize == 0U ) )
             {
                 OTA_LOG_L1( "[%s] Zero file size is not allowed!\r\n", OTA_METHOD_NAME );
                 eErr = eOTA_JobParseErr_ZeroFileSize;
             }
+            else if( ( C->pucCompression != NULL ) &&
+                     ( ( otaconfigDECOMPRESS_IMAGES == 0 ) || ( strcmp( ( const char * ) C->pucCompression, OTA_COMPRESSION_ZLIB ) != 0 ) ) )
+            {
+                OTA_LOG_L1( "[%s] File compression %s is not supported!\r\n", OTA_METHOD_NAME, C->pucCompression );
+                eErr = eOTA_JobParseErr_UnsupportedCompression;
+            }
             /* If there's an active job, verify that it's the same as what's being reported now. */
             /* We already checked for missing parameters so we SHOULD have a job name in the context. */
             else if( xOTA_Agent.pcOTA_Singleton_ActiveJobName != NULL )
@@ -2726,7 +3028,8 @@ static OTA_FileContext_t * prvParseJobDoc( const char * pcJSON,
 static OTA_FileContext_t * prvProcessOTAJobMsg( const char * pcRawMsg,
                                                 uint32_t ulMsgLen )
 {
-    uint32_t ulIndex;
+    DEFINE_OTA_METHOD_NAME( "prvProcessOTAJobMsg" );
+
     uint32_t ulNumBlocks;              /* How many data pages are in the expected update image. */
     uint32_t ulBitmapLen;              /* Length of the file block bitmap in bytes. */
     OTA_FileContext_t * pstUpdateFile; /* Pointer to an OTA update context. */
@@ -2751,41 +3054,65 @@ static OTA_FileContext_t * prvProcessOTAJobMsg( const char * pcRawMsg,
         ulBitmapLen = ( ulNumBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
         pstUpdateFile->pucRxBlockBitmap = ( uint8_t * ) pvPortMalloc( ulBitmapLen ); /*lint !e9079 FreeRTOS malloc port returns void*. */
 
+        #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+            if( ( pstUpdateFile->pucRxBlockBitmap != NULL ) && ( prvWindowStart( pstUpdateFile, ulBitmapLen ) == ( bool_t ) pdFALSE ) )
+            {
+                vPortFree( pstUpdateFile->pucRxBlockBitmap ); /* Without the window we can't track the blocks in flight. */
+                pstUpdateFile->pucRxBlockBitmap = NULL;
+            }
+        #endif
+
+        #if ( otaconfigDECOMPRESS_IMAGES == 1 )
+            if( ( pstUpdateFile->pucRxBlockBitmap != NULL ) && ( pstUpdateFile->pucCompression != NULL ) &&
+                ( prvStartInflate( pstUpdateFile ) == ( bool_t ) pdFALSE ) )
+            {
+                vPortFree( pstUpdateFile->pucRxBlockBitmap ); /* Without the decompressor we can't receive a compressed file. */
+                pstUpdateFile->pucRxBlockBitmap = NULL;
+            }
+        #endif
+
         if( pstUpdateFile->pucRxBlockBitmap != NULL )
         {
             if( ( BaseType_t ) ( prvSubscribeToDataStream( pstUpdateFile ) ) == pdTRUE )
             {
-                /* Set all bits in the bitmap to the erased state (we use 1 for erased just like flash memory). */
-                memset( pstUpdateFile->pucRxBlockBitmap, ( int ) OTA_ERASED_BLOCKS_VAL, ulBitmapLen );
-
-                /* Mark as used any pages in the bitmap that are out of range, based on the file size.
-                 * This keeps us from requesting those pages during retry processing or if using a windowed
-                 * block request. It also avoids erroneously accepting an out of range data block should it
-                 * get past any safety checks.
-                 * Files aren't always a multiple of 8 pages (8 bits/pages per byte) so some bits of the
-                 * last byte may be out of range and those are the bits we want to clear. */
-
-                uint8_t ulBit = 1U << ( BITS_PER_BYTE - 1U );
-                uint32_t ulNumOutOfRange = ( ulBitmapLen * BITS_PER_BYTE ) - ulNumBlocks;
-
-                for( ulIndex = 0U; ulIndex < ulNumOutOfRange; ulIndex++ )
-                {
-                    pstUpdateFile->pucRxBlockBitmap[ ulBitmapLen - 1U ] &= ~ulBit;
-                    ulBit >>= 1U;
-                }
+                prvResetBlockBitmap( pstUpdateFile, ulNumBlocks, ulBitmapLen );
 
-                pstUpdateFile->ulBlocksRemaining = ulNumBlocks; /* Initialize our blocks remaining counter. */
+                /* Pick up where an interrupted transfer of this file left off, if we can. Only the
+                 * blocks still marked in the bitmap will be requested from the stream. */
+                pstUpdateFile->xResume = prvRestoreCheckpoint( pstUpdateFile );
                 prvStartRequestTimer( pstUpdateFile );
 
                 /* Create/Open the OTA file on the file system. */
                 xErr = xOTA_Agent.xPALCallbacks.xCreateFileForRx( pstUpdateFile );
 
+                if( ( xErr != kOTA_Err_None ) && ( pstUpdateFile->xResume == ( bool_t ) pdTRUE ) )
+                {
+                    /* The partially received file is gone, so start the transfer over. */
+                    OTA_LOG_L1( "[%s] Unable to resume the file transfer (0x%08x), starting over.\r\n", OTA_METHOD_NAME, xErr );
+                    prvEraseCheckpoint( pstUpdateFile );
+                    prvResetBlockBitmap( pstUpdateFile, ulNumBlocks, ulBitmapLen );
+                    pstUpdateFile->xResume = pdFALSE;
+                    xErr = xOTA_Agent.xPALCallbacks.xCreateFileForRx( pstUpdateFile );
+                }
+
                 if( xErr != kOTA_Err_None )
                 {
                     ( void ) prvSetImageStateWithReason( eOTA_ImageState_Aborted, xErr );
                     ( void ) prvOTA_Close( pstUpdateFile ); /* Ignore false result since we're setting the pointer to null on the next line. */
                     pstUpdateFile = NULL;
                 }
+
+                #if ( otaconfigHASH_ON_INGEST == 1 )
+                    else if( pstUpdateFile->xResume == ( bool_t ) pdFALSE )
+                    {
+                        /* Blocks received before a resume were never hashed, so only hash fresh transfers. */
+                        prvStartFileHash( pstUpdateFile );
+                    }
+                    else
+                    {
+                        /* The PAL hashes a resumed file from storage when it is closed. */
+                    }
+                #endif
             }
             else
             {
@@ -2807,112 +3134,731 @@ static OTA_FileContext_t * prvProcessOTAJobMsg( const char * pcRawMsg,
 
 
 
-/* prvIngestDataBlock
+/* Mark every block of the file as still needed in its block bitmap. */
+
+static void prvResetBlockBitmap( OTA_FileContext_t * C,
+                                 uint32_t ulNumBlocks,
+                                 uint32_t ulBitmapLen )
+{
+    uint32_t ulIndex;
+
+    /* Set all bits in the bitmap to the erased state (we use 1 for erased just like flash memory). */
+    memset( C->pucRxBlockBitmap, ( int ) OTA_ERASED_BLOCKS_VAL, ulBitmapLen );
+
+    /* Mark as used any pages in the bitmap that are out of range, based on the file size.
+     * This keeps us from requesting those pages during retry processing or if using a windowed
+     * block request. It also avoids erroneously accepting an out of range data block should it
+     * get past any safety checks.
+     * Files aren't always a multiple of 8 pages (8 bits/pages per byte) so some bits of the
+     * last byte may be out of range and those are the bits we want to clear. */
+
+    uint8_t ulBit = 1U << ( BITS_PER_BYTE - 1U );
+    uint32_t ulNumOutOfRange = ( ulBitmapLen * BITS_PER_BYTE ) - ulNumBlocks;
+
+    for( ulIndex = 0U; ulIndex < ulNumOutOfRange; ulIndex++ )
+    {
+        C->pucRxBlockBitmap[ ulBitmapLen - 1U ] &= ~ulBit;
+        ulBit >>= 1U;
+    }
+
+    C->ulBlocksRemaining = ulNumBlocks; /* Initialize our blocks remaining counter. */
+}
+
+
+/* Count the blocks in a range that are still needed according to the block bitmap. */
+
+static uint32_t prvCountMissingBlocks( OTA_FileContext_t * C,
+                                       uint32_t ulFirstBlock,
+                                       uint32_t ulNumBlocks )
+{
+    uint32_t ulBlock;
+    uint32_t ulMissing = 0U;
+
+    for( ulBlock = ulFirstBlock; ulBlock < ( ulFirstBlock + ulNumBlocks ); ulBlock++ )
+    {
+        if( ( C->pucRxBlockBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] & ( 1U << ( ulBlock % BITS_PER_BYTE ) ) ) != 0U )
+        {
+            ulMissing++;
+        }
+    }
+
+    return ulMissing;
+}
+
+
+/* Mark a range of blocks as received in the block bitmap and take the newly received ones off the
+ * count of blocks remaining. A block larger than the bitmap's block size covers several bits. */
+
+static void prvMarkBlocksReceived( OTA_FileContext_t * C,
+                                   uint32_t ulFirstBlock,
+                                   uint32_t ulNumBlocks )
+{
+    uint32_t ulBlock;
+    uint8_t ucBitMask;
+
+    for( ulBlock = ulFirstBlock; ulBlock < ( ulFirstBlock + ulNumBlocks ); ulBlock++ )
+    {
+        ucBitMask = ( uint8_t ) ( 1U << ( ulBlock % BITS_PER_BYTE ) ); /*lint !e9031 The composite expression will never be greater than BITS_PER_BYTE(8). */
+
+        if( ( C->pucRxBlockBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] & ucBitMask ) != 0U )
+        {
+            C->pucRxBlockBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] &= ~ucBitMask;
+            C->ulBlocksRemaining--;
+        }
+    }
+}
+
+#if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+
+/* prvWindowStart
  *
- * A block of file data was received by the application via some configured communication protocol.
- * If it looks like it is in range, write it to persistent storage. If it's the last block we're
- * expecting, close the file and perform the final signature check on it. If the close and signature
- * check are OK, let the caller know so it can be used by the system. Firmware updates generally
- * reboot the system and perform a self test phase. If the close or signature check fails, abort
- * the file transfer and return the result and any available details to the caller.
+ * Open the request window for a new file transfer. The window starts small and grows as blocks
+ * arrive, the block size starts at the smallest size. Returns pdFALSE if there's not enough memory
+ * to track the blocks in flight.
  */
-static IngestResult_t prvIngestDataBlock( OTA_FileContext_t * C,
-                                          const char * pcRawMsg,
-                                          uint32_t ulMsgSize,
-                                          OTA_Err_t * pxCloseResult )
-{
-    DEFINE_OTA_METHOD_NAME( "prvIngestDataBlock" );
+    static bool_t prvWindowStart( OTA_FileContext_t * C,
+                                  uint32_t ulBitmapLen )
+    {
+        OTA_RequestWindow_t * pxWindow = &C->xWindow;
 
-    IngestResult_t eIngestResult = eIngest_Result_Uninitialized;
-    int32_t lFileId = 0;
-    uint32_t ulBlockSize = 0;
-    uint32_t ulBlockIndex = 0;
-    uint8_t * pucPayload = NULL;
-    size_t xPayloadSize = 0;
+        prvWindowStop( C );
+        pxWindow->pucInFlightBitmap = ( uint8_t * ) pvPortMalloc( ulBitmapLen ); /*lint !e9079 FreeRTOS malloc port returns void*. */
 
-    if( C != NULL )
+        if( pxWindow->pucInFlightBitmap != NULL )
+        {
+            memset( pxWindow->pucInFlightBitmap, 0, ulBitmapLen );
+            pxWindow->ulWindow = ( OTA_WINDOW_INITIAL_BLOCKS < otaconfigMAX_WINDOW_BLOCKS ) ? OTA_WINDOW_INITIAL_BLOCKS : otaconfigMAX_WINDOW_BLOCKS;
+            pxWindow->ulThreshold = otaconfigMAX_WINDOW_BLOCKS;
+            pxWindow->ulLog2BlockSize = otaconfigLOG2_FILE_BLOCK_SIZE;
+        }
+
+        return ( pxWindow->pucInFlightBitmap != NULL ) ? ( bool_t ) pdTRUE : ( bool_t ) pdFALSE;
+    }
+
+/* prvWindowStop
+ *
+ * Release the request window of a file transfer.
+ */
+    static void prvWindowStop( OTA_FileContext_t * C )
     {
-        if( pxCloseResult != NULL )
+        if( C->xWindow.pucInFlightBitmap != NULL )
         {
-            *pxCloseResult = kOTA_Err_GenericIngestError; /* Default to a generic ingest function error until we prove success. */
+            vPortFree( C->xWindow.pucInFlightBitmap );
+        }
 
-            /* If we have a block bitmap available then process the message. */
-            if( C->pucRxBlockBitmap && ( C->ulBlocksRemaining > 0U ) )
+        memset( &C->xWindow, 0, sizeof( OTA_RequestWindow_t ) );
+    }
+
+/* prvWindowSelectBlocks
+ *
+ * Choose the blocks to ask for in the next stream request. The stream service sends the requested
+ * blocks in order, so the window makes passes over the file in order too, asking for the missing
+ * blocks that aren't already in flight until the window is full. Blocks lost along the way are
+ * asked for again on the next pass. A request is only made once a quarter of the window is free
+ * so the service isn't sent a request for every block received.
+ *
+ * The selected blocks are returned as a stream request bitmap at the current block size. Returns
+ * the number of blocks selected, which is zero if there's nothing to request right now.
+ */
+    static uint32_t prvWindowSelectBlocks( OTA_FileContext_t * C,
+                                           uint8_t * pucBitmap,
+                                           uint32_t ulMaxBitmapLen,
+                                           uint32_t * pulBitmapLen )
+    {
+        OTA_RequestWindow_t * pxWindow = &C->xWindow;
+        uint32_t ulShift = pxWindow->ulLog2BlockSize - otaconfigLOG2_FILE_BLOCK_SIZE;
+        uint32_t ulNumBlocks = ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+        uint32_t ulNumStreamBlocks = ( ulNumBlocks + ( ( 1UL << ulShift ) - 1U ) ) >> ulShift;
+        uint32_t ulFree = 0U;
+        uint32_t ulSelected = 0U;
+        uint32_t ulStreamBlock, ulBlock, ulLastBlock, ulNeeded;
+        uint8_t ucBitMask;
+        bool_t xWrapped = pdFALSE;
+
+        *pulBitmapLen = 0U;
+        memset( pucBitmap, 0, ulMaxBitmapLen );
+
+        if( ( pxWindow->pucInFlightBitmap != NULL ) && ( pxWindow->ulWindow > pxWindow->ulInFlight ) )
+        {
+            ulFree = pxWindow->ulWindow - pxWindow->ulInFlight;
+        }
+
+        if( ( ulFree >= ( 1UL << ulShift ) ) && ( ulFree >= ( pxWindow->ulWindow >> 2 ) ) )
+        {
+            ulStreamBlock = pxWindow->ulNextBlock >> ulShift;
+
+            /* The last pass may have ended past the final block at a larger block size. */
+            if( ulStreamBlock >= ulNumStreamBlocks )
             {
-                /* Reset or start the firmware request timer. */
-                prvStartRequestTimer( C );
+                ulStreamBlock = 0U;
+                pxWindow->ulNextBlock = 0U;
+                xWrapped = pdTRUE;
+            }
 
-                /* Decode the CBOR content. */
-                if( pdFALSE == OTA_CBOR_Decode_GetStreamResponseMessage(
-                        ( const uint8_t * ) pcRawMsg,
-                        ulMsgSize,
-                        &lFileId,
-                        ( int32_t * ) &ulBlockIndex, /*lint !e9087 CBOR requires pointer to int and our block index's never exceed 31 bits. */
-                        ( int32_t * ) &ulBlockSize,  /*lint !e9087 CBOR requires pointer to int and our block sizes never exceed 31 bits. */
-                        &pucPayload,                 /* This payload gets malloc'd by OTA_CBOR_Decode_GetStreamResponseMessage(). We must free it. */
-                        ( size_t * ) &xPayloadSize ) )
+            while( ulStreamBlock < ulNumStreamBlocks )
+            {
+                ulBlock = ulStreamBlock << ulShift;
+                ulLastBlock = ulBlock + ( 1UL << ulShift );
+                ulLastBlock = ( ulLastBlock < ulNumBlocks ) ? ulLastBlock : ulNumBlocks;
+                ulNeeded = 0U;
+
+                /* Count the blocks covered by this stream block that are needed and not in flight. */
+                for( ; ulBlock < ulLastBlock; ulBlock++ )
                 {
-                    eIngestResult = eIngest_Result_BadData;
+                    ucBitMask = ( uint8_t ) ( 1U << ( ulBlock % BITS_PER_BYTE ) );
+
+                    if( ( ( C->pucRxBlockBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] & ucBitMask ) != 0U ) &&
+                        ( ( pxWindow->pucInFlightBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] & ucBitMask ) == 0U ) )
+                    {
+                        ulNeeded++;
+                    }
                 }
-                else
+
+                if( ( ulNeeded > ulFree ) || ( ( ulStreamBlock >> LOG2_BITS_PER_BYTE ) >= ulMaxBitmapLen ) )
                 {
-                    /* Validate the block index and size. */
-                    /* If it is NOT the last block, it MUST be equal to a full block size. */
-                    /* If it IS the last block, it MUST be equal to the expected remainder. */
-                    /* If the block ID is out of range, that's an error so abort. */
-                    uint32_t iLastBlock = ( ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE ) - 1U;
+                    break; /* The window is full, or the request can't reach this block. */
+                }
 
-                    if( ( ( ( uint32_t ) ulBlockIndex < iLastBlock ) && ( ulBlockSize == OTA_FILE_BLOCK_SIZE ) ) ||
-                        ( ( ( uint32_t ) ulBlockIndex == iLastBlock ) && ( ( uint32_t ) ulBlockSize == ( C->ulFileSize - ( iLastBlock * OTA_FILE_BLOCK_SIZE ) ) ) ) )
+                if( ulNeeded > 0U )
+                {
+                    for( ulBlock = ulStreamBlock << ulShift; ulBlock < ulLastBlock; ulBlock++ )
                     {
-                        OTA_LOG_L1( "[%s] Received file block %u, size %u\r\n", OTA_METHOD_NAME, ulBlockIndex, ulBlockSize );
-
-                        /* Create bit mask for use in our bitmap. */
-                        uint8_t ulBitMask = 1U << ( ulBlockIndex % BITS_PER_BYTE ); /*lint !e9031 The composite expression will never be greater than BITS_PER_BYTE(8). */
-                        /* Calculate byte offset into bitmap. */
-                        uint32_t ulByte = ulBlockIndex >> LOG2_BITS_PER_BYTE;
+                        ucBitMask = ( uint8_t ) ( 1U << ( ulBlock % BITS_PER_BYTE ) );
 
-                        if( ( C->pucRxBlockBitmap[ ulByte ] & ulBitMask ) == 0U ) /* If we've already received this block... */
+                        if( ( C->pucRxBlockBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] & ucBitMask ) != 0U )
                         {
-                            OTA_LOG_L1( "[%s] block %u is a DUPLICATE. %u blocks remaining.\r\n", OTA_METHOD_NAME,
-                                        ulBlockIndex,
-                                        C->ulBlocksRemaining );
-                            eIngestResult = eIngest_Result_Duplicate_Continue;
-                            *pxCloseResult = kOTA_Err_None; /* This is a success path. */
+                            pxWindow->pucInFlightBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] |= ucBitMask;
                         }
-                        else /* Otherwise, process it normally... */
-                        {
-                            if( C->pucFile != NULL )
-                            {
-                                int32_t iBytesWritten = xOTA_Agent.xPALCallbacks.xWriteBlock( C, ( ulBlockIndex * OTA_FILE_BLOCK_SIZE ), pucPayload, ( uint32_t ) ulBlockSize );
+                    }
 
-                                if( iBytesWritten < 0 )
-                                {
-                                    OTA_LOG_L1( "[%s] Error (%d) writing file block\r\n", OTA_METHOD_NAME, iBytesWritten );
-                                    eIngestResult = eIngest_Result_WriteBlockFailed;
-                                }
+                    pucBitmap[ ulStreamBlock >> LOG2_BITS_PER_BYTE ] |= ( uint8_t ) ( 1U << ( ulStreamBlock % BITS_PER_BYTE ) );
+                    *pulBitmapLen = ( ulStreamBlock >> LOG2_BITS_PER_BYTE ) + 1U;
+                    pxWindow->ulInFlight += ulNeeded;
+                    ulFree -= ulNeeded;
+                    ulSelected++;
+                }
+
+                ulStreamBlock++;
+                pxWindow->ulNextBlock = ulStreamBlock << ulShift;
+
+                /* Start the next pass over the file if this one found nothing more to ask for. */
+                if( ( ulStreamBlock == ulNumStreamBlocks ) && ( ulSelected == 0U ) && ( xWrapped == pdFALSE ) )
+                {
+                    ulStreamBlock = 0U;
+                    pxWindow->ulNextBlock = 0U;
+                    xWrapped = pdTRUE;
+                }
+            }
+        }
+
+        return ulSelected;
+    }
+
+/* prvWindowReduce
+ *
+ * Halve the window after blocks were lost, at most once for each window of blocks received.
+ * Smaller blocks waste less of the link with each block lost, so the block size is halved too.
+ */
+    static void prvWindowReduce( OTA_FileContext_t * C,
+                                 bool_t xForce )
+    {
+        OTA_RequestWindow_t * pxWindow = &C->xWindow;
+        uint32_t ulStreamBlocks;
+
+        if( ( xForce == ( bool_t ) pdTRUE ) || ( pxWindow->ulSinceLoss >= pxWindow->ulWindow ) )
+        {
+            if( ( pxWindow->xFixedBlockSize == ( bool_t ) pdFALSE ) && ( pxWindow->ulLog2BlockSize > otaconfigLOG2_FILE_BLOCK_SIZE ) )
+            {
+                pxWindow->ulLog2BlockSize--;
+            }
+
+            ulStreamBlocks = 1UL << ( pxWindow->ulLog2BlockSize - otaconfigLOG2_FILE_BLOCK_SIZE );
+            pxWindow->ulThreshold = pxWindow->ulWindow >> 1;
+            pxWindow->ulThreshold = ( pxWindow->ulThreshold > ulStreamBlocks ) ? pxWindow->ulThreshold : ulStreamBlocks;
+            pxWindow->ulWindow = pxWindow->ulThreshold;
+            pxWindow->ulGrowth = 0U;
+            pxWindow->ulSinceLoss = 0U;
+        }
+    }
+
+/* prvWindowBlockReceived
+ *
+ * Account for a block received from the stream. Blocks are streamed in the order they were
+ * requested, so any block still in flight that was requested before this one was lost. Blocks
+ * below ulNextBlock were requested in the current pass over the file, so if this block is from
+ * the current pass every block in flight below it was lost. Otherwise it's a late block of the
+ * previous pass and only the blocks of that pass between ulNextBlock and it were lost.
+ *
+ * Without loss the window doubles every round trip until it reaches the threshold and then grows
+ * by one block per window received. Once the window is as large as allowed and a whole window
+ * arrives without loss, the block size doubles to move the same data in fewer messages.
+ */
+    static void prvWindowBlockReceived( OTA_FileContext_t * C,
+                                        uint32_t ulFirstBlock,
+                                        uint32_t ulNumBlocks )
+    {
+        OTA_RequestWindow_t * pxWindow = &C->xWindow;
+        uint32_t ulBlock;
+        uint32_t ulLost = 0U;
+        uint32_t ulArrived = 0U;
+        uint8_t ucBitMask;
+
+        if( pxWindow->pucInFlightBitmap != NULL )
+        {
+            ulBlock = ( ulFirstBlock < pxWindow->ulNextBlock ) ? 0U : pxWindow->ulNextBlock;
+
+            for( ; ulBlock < ( ulFirstBlock + ulNumBlocks ); ulBlock++ )
+            {
+                ucBitMask = ( uint8_t ) ( 1U << ( ulBlock % BITS_PER_BYTE ) );
+
+                if( ( pxWindow->pucInFlightBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] & ucBitMask ) != 0U )
+                {
+                    pxWindow->pucInFlightBitmap[ ulBlock >> LOG2_BITS_PER_BYTE ] &= ~ucBitMask;
+
+                    if( ulBlock < ulFirstBlock )
+                    {
+                        ulLost++;
+                    }
+                    else
+                    {
+                        ulArrived++;
+                    }
+                }
+            }
+
+            pxWindow->ulInFlight -= ulLost + ulArrived;
+            pxWindow->ulSinceLoss += ulArrived;
+
+            if( ulLost > 0U )
+            {
+                prvWindowReduce( C, pdFALSE );
+            }
+            else if( pxWindow->ulWindow < pxWindow->ulThreshold )
+            {
+                pxWindow->ulWindow += ulArrived;
+            }
+            else
+            {
+                pxWindow->ulGrowth += ulArrived;
+
+                if( pxWindow->ulGrowth >= pxWindow->ulWindow )
+                {
+                    pxWindow->ulGrowth = 0U;
+
+                    if( pxWindow->ulWindow < otaconfigMAX_WINDOW_BLOCKS )
+                    {
+                        pxWindow->ulWindow += 1UL << ( pxWindow->ulLog2BlockSize - otaconfigLOG2_FILE_BLOCK_SIZE );
+                    }
+                    else if( ( pxWindow->xFixedBlockSize == ( bool_t ) pdFALSE ) && ( pxWindow->ulLog2BlockSize < otaconfigLOG2_MAX_FILE_BLOCK_SIZE ) )
+                    {
+                        pxWindow->ulLog2BlockSize++;
+                    }
+                    else
+                    {
+                        /* The window and block size are as large as allowed. */
+                    }
+                }
+            }
+
+            if( pxWindow->ulWindow > otaconfigMAX_WINDOW_BLOCKS )
+            {
+                pxWindow->ulWindow = otaconfigMAX_WINDOW_BLOCKS;
+            }
+        }
+    }
+
+/* prvWindowTimeout
+ *
+ * Nothing was received for a whole request timer period, so every block in flight was lost.
+ * Shrink the window and start a new pass over the file to ask for them again.
+ */
+    static void prvWindowTimeout( OTA_FileContext_t * C )
+    {
+        OTA_RequestWindow_t * pxWindow = &C->xWindow;
+        uint32_t ulBitmapLen = ( ( ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE ) + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
+
+        if( ( pxWindow->pucInFlightBitmap != NULL ) && ( pxWindow->ulInFlight > 0U ) )
+        {
+            memset( pxWindow->pucInFlightBitmap, 0, ulBitmapLen );
+            pxWindow->ulInFlight = 0U;
+            pxWindow->ulNextBlock = 0U;
+            prvWindowReduce( C, pdTRUE );
+        }
+    }
+
+/* prvWindowBlockLog2
+ *
+ * Stream requests carry the block size in their client token so that blocks requested before the
+ * block size changed are still written at the right offset. If the stream doesn't echo the client
+ * token back, the block size can't be told from the block, so it's fixed at the current size for
+ * the rest of the transfer. It can't have changed yet since the first block received fixes it.
+ */
+    static uint32_t prvWindowBlockLog2( OTA_FileContext_t * C,
+                                        const char * pcRawMsg,
+                                        uint32_t ulMsgSize )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvWindowBlockLog2" );
+
+        OTA_RequestWindow_t * pxWindow = &C->xWindow;
+        char pcClientToken[ OTA_CLIENT_TOKEN_MAX_SIZE ];
+        uint32_t ulLog2BlockSize = 0U;
+        uint32_t ulIndex = sizeof( OTA_CLIENT_TOKEN ) - 1U;
+
+        if( ( pxWindow->xFixedBlockSize == ( bool_t ) pdFALSE ) &&
+            ( OTA_CBOR_Decode_GetStreamResponseClientToken( ( const uint8_t * ) pcRawMsg, ulMsgSize, pcClientToken, sizeof( pcClientToken ) ) == pdTRUE ) &&
+            ( strncmp( pcClientToken, OTA_CLIENT_TOKEN, sizeof( OTA_CLIENT_TOKEN ) - 1U ) == 0 ) )
+        {
+            for( ; ( pcClientToken[ ulIndex ] >= '0' ) && ( pcClientToken[ ulIndex ] <= '9' ); ulIndex++ )
+            {
+                ulLog2BlockSize = ( ulLog2BlockSize * 10U ) + ( uint32_t ) ( pcClientToken[ ulIndex ] - '0' );
+            }
+        }
+
+        if( ( ulLog2BlockSize < otaconfigLOG2_FILE_BLOCK_SIZE ) || ( ulLog2BlockSize > otaconfigLOG2_MAX_FILE_BLOCK_SIZE ) )
+        {
+            if( pxWindow->xFixedBlockSize == ( bool_t ) pdFALSE )
+            {
+                OTA_LOG_L1( "[%s] Stream doesn't tag blocks with their size, the block size is fixed.\r\n", OTA_METHOD_NAME );
+            }
+
+            pxWindow->xFixedBlockSize = pdTRUE;
+            ulLog2BlockSize = ( pxWindow->ulLog2BlockSize != 0U ) ? pxWindow->ulLog2BlockSize : otaconfigLOG2_FILE_BLOCK_SIZE;
+        }
+
+        return ulLog2BlockSize;
+    }
+
+#endif /* otaconfigPIPELINE_BLOCK_REQUESTS */
+
+
+/* Allocate a checkpoint for the file transfer and fill in everything but the block bitmap.
+ * The checkpoint identifies the job, stream and file so that a checkpoint saved for a different
+ * transfer is never resumed. Returns NULL if there's no active job or not enough memory, or if the
+ * file is being decompressed since the decompressor can't resume from a checkpoint. */
+
+static uint8_t * prvNewCheckpoint( OTA_FileContext_t * C,
+                                   uint32_t * pulSize,
+                                   uint8_t ** ppucBitmap )
+{
+    OTA_Checkpoint_t xHeader;
+    uint8_t * pucCheckpoint = NULL;
+    const char * pcJobName = ( const char * ) xOTA_Agent.pcOTA_Singleton_ActiveJobName;
+    uint32_t ulNumBlocks;
+
+    if( ( pcJobName != NULL ) && ( C->pucStreamName != NULL ) && ( C->pvInflateContext == NULL ) )
+    {
+        ulNumBlocks = ( C->ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+
+        xHeader.ulMagic = OTA_CHECKPOINT_MAGIC;
+        xHeader.ulServerFileID = C->ulServerFileID;
+        xHeader.ulFileSize = C->ulFileSize;
+        xHeader.ulJobNameLen = ( uint32_t ) strlen( pcJobName );
+        xHeader.ulStreamNameLen = ( uint32_t ) strlen( ( const char * ) C->pucStreamName );
+        xHeader.ulBitmapLen = ( ulNumBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
+
+        *pulSize = sizeof( xHeader ) + xHeader.ulJobNameLen + xHeader.ulStreamNameLen + xHeader.ulBitmapLen;
+        pucCheckpoint = ( uint8_t * ) pvPortMalloc( *pulSize ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+
+        if( pucCheckpoint != NULL )
+        {
+            memcpy( pucCheckpoint, &xHeader, sizeof( xHeader ) );
+            memcpy( &pucCheckpoint[ sizeof( xHeader ) ], pcJobName, xHeader.ulJobNameLen );
+            memcpy( &pucCheckpoint[ sizeof( xHeader ) + xHeader.ulJobNameLen ], C->pucStreamName, xHeader.ulStreamNameLen );
+            *ppucBitmap = &pucCheckpoint[ *pulSize - xHeader.ulBitmapLen ];
+        }
+    }
+
+    return pucCheckpoint;
+}
+
+
+/* Save the block bitmap of the file transfer through the PAL so that the transfer can resume
+ * from it after a reset. The PAL makes the blocks written so far durable before saving it. */
+
+static void prvSaveCheckpoint( OTA_FileContext_t * C )
+{
+    DEFINE_OTA_METHOD_NAME( "prvSaveCheckpoint" );
+
+    uint8_t * pucCheckpoint;
+    uint8_t * pucBitmap = NULL;
+    uint32_t ulSize = 0;
+    OTA_Err_t xErr;
+
+    if( ( xOTA_Agent.xPALCallbacks.xSaveCheckpoint != NULL ) && ( C->pucRxBlockBitmap != NULL ) )
+    {
+        pucCheckpoint = prvNewCheckpoint( C, &ulSize, &pucBitmap );
+
+        if( pucCheckpoint != NULL )
+        {
+            memcpy( pucBitmap, C->pucRxBlockBitmap, ( size_t ) ( &pucCheckpoint[ ulSize ] - pucBitmap ) );
+            xErr = xOTA_Agent.xPALCallbacks.xSaveCheckpoint( C, pucCheckpoint, ulSize );
+
+            if( xErr != kOTA_Err_None )
+            {
+                OTA_LOG_L1( "[%s] Error (0x%08x) saving the transfer checkpoint.\r\n", OTA_METHOD_NAME, xErr );
+            }
+
+            vPortFree( pucCheckpoint );
+        }
+    }
+}
+
+
+/* Erase any checkpoint saved through the PAL. */
+
+static void prvEraseCheckpoint( OTA_FileContext_t * C )
+{
+    if( xOTA_Agent.xPALCallbacks.xSaveCheckpoint != NULL )
+    {
+        ( void ) xOTA_Agent.xPALCallbacks.xSaveCheckpoint( C, NULL, 0U );
+    }
+}
+
+
+/* Load the checkpoint saved through the PAL and, if it belongs to the transfer of this same file,
+ * restore its block bitmap and blocks remaining counter. A checkpoint for any other transfer is
+ * erased since it can never be resumed. Returns pdTRUE if the transfer should be resumed. */
+
+static bool_t prvRestoreCheckpoint( OTA_FileContext_t * C )
+{
+    DEFINE_OTA_METHOD_NAME( "prvRestoreCheckpoint" );
+
+    bool_t xRestored = pdFALSE;
+    uint8_t * pucExpected;
+    uint8_t * pucLoaded;
+    uint8_t * pucBitmap = NULL;
+    uint8_t ucByte;
+    uint32_t ulSize = 0;
+    uint32_t ulHeaderLen;
+    uint32_t ulIndex;
+    uint32_t ulRemaining = 0;
+
+    if( xOTA_Agent.xPALCallbacks.xLoadCheckpoint != NULL )
+    {
+        pucExpected = prvNewCheckpoint( C, &ulSize, &pucBitmap );
+
+        if( pucExpected != NULL )
+        {
+            ulHeaderLen = ( uint32_t ) ( pucBitmap - pucExpected );
+            pucLoaded = ( uint8_t * ) pvPortMalloc( ulSize ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+
+            if( ( pucLoaded != NULL ) &&
+                ( xOTA_Agent.xPALCallbacks.xLoadCheckpoint( C, pucLoaded, ulSize ) == ulSize ) &&
+                ( memcmp( pucLoaded, pucExpected, ulHeaderLen ) == 0 ) )
+            {
+                /* Count the blocks still needed. Only blocks that are in range can be needed. */
+                for( ulIndex = 0U; ulIndex < ( ulSize - ulHeaderLen ); ulIndex++ )
+                {
+                    for( ucByte = C->pucRxBlockBitmap[ ulIndex ] & pucLoaded[ ulHeaderLen + ulIndex ]; ucByte != 0U; ucByte &= ( uint8_t ) ( ucByte - 1U ) )
+                    {
+                        ulRemaining++;
+                    }
+                }
+
+                /* A checkpoint is erased when the last block is received, so a complete bitmap can't be trusted. */
+                if( ulRemaining > 0U )
+                {
+                    OTA_LOG_L1( "[%s] Resuming file transfer, %u blocks remaining.\r\n", OTA_METHOD_NAME, ulRemaining );
+
+                    for( ulIndex = 0U; ulIndex < ( ulSize - ulHeaderLen ); ulIndex++ )
+                    {
+                        C->pucRxBlockBitmap[ ulIndex ] &= pucLoaded[ ulHeaderLen + ulIndex ];
+                    }
+
+                    C->ulBlocksRemaining = ulRemaining;
+                    xRestored = pdTRUE;
+                }
+            }
+
+            if( pucLoaded != NULL )
+            {
+                vPortFree( pucLoaded );
+            }
+
+            vPortFree( pucExpected );
+        }
+
+        if( xRestored == ( bool_t ) pdFALSE )
+        {
+            prvEraseCheckpoint( C );
+        }
+    }
+
+    return xRestored;
+}
+
+
+/* prvIngestDataBlock
+ *
+ * A block of file data was received by the application via some configured communication protocol.
+ * If it looks like it is in range, write it to persistent storage. If it's the last block we're
+ * expecting, close the file and perform the final signature check on it. If the close and signature
+ * check are OK, let the caller know so it can be used by the system. Firmware updates generally
+ * reboot the system and perform a self test phase. If the close or signature check fails, abort
+ * the file transfer and return the result and any available details to the caller.
+ */
+static IngestResult_t prvIngestDataBlock( OTA_FileContext_t * C,
+                                          const char * pcRawMsg,
+                                          uint32_t ulMsgSize,
+                                          OTA_Err_t * pxCloseResult )
+{
+    DEFINE_OTA_METHOD_NAME( "prvIngestDataBlock" );
+
+    IngestResult_t eIngestResult = eIngest_Result_Uninitialized;
+    int32_t lFileId = 0;
+    uint32_t ulBlockSize = 0;
+    uint32_t ulBlockIndex = 0;
+    uint32_t ulLog2BlockSize = otaconfigLOG2_FILE_BLOCK_SIZE;
+    const uint8_t * pucPayload = NULL;
+    size_t xPayloadSize = 0;
+
+    if( C != NULL )
+    {
+        if( pxCloseResult != NULL )
+        {
+            *pxCloseResult = kOTA_Err_GenericIngestError; /* Default to a generic ingest function error until we prove success. */
+
+            /* If we have a block bitmap available then process the message. */
+            if( C->pucRxBlockBitmap && ( C->ulBlocksRemaining > 0U ) )
+            {
+                /* Reset or start the firmware request timer. */
+                prvStartRequestTimer( C );
+
+                /* Decode the CBOR content. */
+                if( pdFALSE == OTA_CBOR_Decode_GetStreamResponseMessage(
+                        ( const uint8_t * ) pcRawMsg,
+                        ulMsgSize,
+                        &lFileId,
+                        ( int32_t * ) &ulBlockIndex, /*lint !e9087 CBOR requires pointer to int and our block index's never exceed 31 bits. */
+                        ( int32_t * ) &ulBlockSize,  /*lint !e9087 CBOR requires pointer to int and our block sizes never exceed 31 bits. */
+                        &pucPayload,                 /* This payload points into the message buffer, it isn't copied. */
+                        ( size_t * ) &xPayloadSize ) )
+                {
+                    eIngestResult = eIngest_Result_BadData;
+                }
+                else
+                {
+                    #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+                        /* The block size may have changed since this block was requested. */
+                        ulLog2BlockSize = prvWindowBlockLog2( C, pcRawMsg, ulMsgSize );
+                    #endif
+
+                    /* Validate the block index and size. */
+                    /* If it is NOT the last block, it MUST be equal to a full block size. */
+                    /* If it IS the last block, it MUST be equal to the expected remainder. */
+                    /* If the block ID is out of range, that's an error so abort. */
+                    uint32_t ulStreamBlockSize = 1UL << ulLog2BlockSize;
+                    uint32_t iLastBlock = ( ( C->ulFileSize + ( ulStreamBlockSize - 1U ) ) >> ulLog2BlockSize ) - 1U;
+
+                    if( ( ( ( uint32_t ) ulBlockIndex < iLastBlock ) && ( ulBlockSize == ulStreamBlockSize ) ) ||
+                        ( ( ( uint32_t ) ulBlockIndex == iLastBlock ) && ( ( uint32_t ) ulBlockSize == ( C->ulFileSize - ( iLastBlock * ulStreamBlockSize ) ) ) ) )
+                    {
+                        OTA_LOG_L1( "[%s] Received file block %u, size %u\r\n", OTA_METHOD_NAME, ulBlockIndex, ulBlockSize );
+
+                        /* Find the blocks of the receive bitmap covered by this block. */
+                        uint32_t ulFirstBlock = ulBlockIndex << ( ulLog2BlockSize - otaconfigLOG2_FILE_BLOCK_SIZE );
+                        uint32_t ulNumBlocks = ( ulBlockSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+
+                        #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+                            prvWindowBlockReceived( C, ulFirstBlock, ulNumBlocks );
+                        #endif
+
+                        if( prvCountMissingBlocks( C, ulFirstBlock, ulNumBlocks ) == 0U ) /* If we've already received this block... */
+                        {
+                            OTA_LOG_L1( "[%s] block %u is a DUPLICATE. %u blocks remaining.\r\n", OTA_METHOD_NAME,
+                                        ulBlockIndex,
+                                        C->ulBlocksRemaining );
+                            eIngestResult = eIngest_Result_Duplicate_Continue;
+                            *pxCloseResult = kOTA_Err_None; /* This is a success path. */
+                        }
+                        else /* Otherwise, process it normally... */
+                        {
+                            if( C->pucFile == NULL )
+                            {
+                                OTA_LOG_L1( "[%s] Error: Unable to write block, file handle is NULL.\r\n", OTA_METHOD_NAME );
+                                eIngestResult = eIngest_Result_BadFileHandle;
+                            }
+
+                            #if ( otaconfigDECOMPRESS_IMAGES == 1 )
+                                else if( C->pvInflateContext != NULL )
+                                {
+                                    /* A compressed file is written by its decompressor. */
+                                    eIngestResult = prvInflateDataBlock( C, ulFirstBlock, pucPayload, ulBlockSize );
+                                }
+                            #endif
+                            else
+                            {
+                                int32_t iBytesWritten = xOTA_Agent.xPALCallbacks.xWriteBlock( C, ( ulBlockIndex << ulLog2BlockSize ), ( uint8_t * ) pucPayload, ( uint32_t ) ulBlockSize ); /*lint !e9005 The PAL doesn't modify the block. */
+
+                                if( iBytesWritten < 0 )
+                                {
+                                    OTA_LOG_L1( "[%s] Error (%d) writing file block\r\n", OTA_METHOD_NAME, iBytesWritten );
+                                    eIngestResult = eIngest_Result_WriteBlockFailed;
+                                }
                                 else
                                 {
-                                    C->pucRxBlockBitmap[ ulByte ] &= ~ulBitMask; /* Mark this block as received in our bitmap. */
-                                    C->ulBlocksRemaining--;
+                                    #if ( otaconfigHASH_ON_INGEST == 1 )
+                                        prvHashDataBlock( C, ulFirstBlock, pucPayload, ulBlockSize );
+                                    #endif
+
                                     eIngestResult = eIngest_Result_Accepted_Continue;
-                                    *pxCloseResult = kOTA_Err_None; /* This is a success path. */
                                 }
                             }
+
+                            if( eIngestResult == eIngest_Result_Accepted_Continue )
+                            {
+                                uint32_t ulBlocksRemaining = C->ulBlocksRemaining;
+                                prvMarkBlocksReceived( C, ulFirstBlock, ulNumBlocks ); /* Mark these blocks as received in our bitmap. */
+                                *pxCloseResult = kOTA_Err_None;                        /* This is a success path. */
+
+                                /* Checkpoint each time the count of remaining blocks crosses a multiple of the interval. */
+                                if( ( C->ulBlocksRemaining > 0U ) &&
+                                    ( ( ulBlocksRemaining / otaconfigCHECKPOINT_INTERVAL_BLOCKS ) != ( C->ulBlocksRemaining / otaconfigCHECKPOINT_INTERVAL_BLOCKS ) ) )
+                                {
+                                    prvSaveCheckpoint( C );
+                                }
+                            }
+                            else if( eIngestResult == eIngest_Result_Deferred_Continue )
+                            {
+                                /* The block is left unmarked in the bitmap so it is requested again. */
+                                *pxCloseResult = kOTA_Err_None; /* This is a success path. */
+                            }
                             else
                             {
-                                OTA_LOG_L1( "[%s] Error: Unable to write block, file handle is NULL.\r\n", OTA_METHOD_NAME );
-                                eIngestResult = eIngest_Result_BadFileHandle;
+                                /* The block was rejected. */
                             }
 
                             if( C->ulBlocksRemaining == 0U )
                             {
                                 OTA_LOG_L1( "[%s] Received final expected block of file.\r\n", OTA_METHOD_NAME );
                                 prvStopRequestTimer( C );         /* Don't request any more since we're done. */
+                                prvEraseCheckpoint( C );          /* There is nothing left to resume. */
                                 vPortFree( C->pucRxBlockBitmap ); /* Free the bitmap now that we're done with the download. */
                                 C->pucRxBlockBitmap = NULL;
 
-                                if( C->pucFile != NULL )
+                                #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+                                    prvWindowStop( C );
+                                #endif
+
+                                #if ( otaconfigDECOMPRESS_IMAGES == 1 )
+                                    if( C->pvInflateContext != NULL )
+                                    {
+                                        if( prvFinishInflate( C ) == ( bool_t ) pdFALSE )
+                                        {
+                                            OTA_LOG_L1( "[%s] Error: Compressed file is truncated or doesn't match its decompressed size.\r\n", OTA_METHOD_NAME );
+                                            eIngestResult = eIngest_Result_BadData;
+                                            *pxCloseResult = kOTA_Err_GenericIngestError;
+                                        }
+
+                                        prvStopInflate( C ); /* Free the decompressor's window before the file is verified. */
+                                    }
+                                #endif
+
+                                if( eIngestResult != eIngest_Result_Accepted_Continue )
+                                {
+                                    /* The final block wasn't accepted so the file can't be closed. */
+                                }
+                                else if( C->pucFile != NULL )
                                 {
                                     *pxCloseResult = xOTA_Agent.xPALCallbacks.xCloseFile( C );
 
@@ -2975,13 +3921,397 @@ static IngestResult_t prvIngestDataBlock( OTA_FileContext_t * C,
         eIngestResult = eIngest_Result_NullContext;
     }
 
-    if( NULL != pucPayload )
+    return eIngestResult;
+}
+
+#if ( otaconfigHASH_ON_INGEST == 1 )
+
+/* prvStartFileHash
+ *
+ * Start an incremental signature verification context for a file that is about to be received.
+ * The PAL picks the context up in its close function and only needs to perform the final
+ * signature check. If the context can't be started, the PAL hashes the file from storage instead.
+ */
+    static void prvStartFileHash( OTA_FileContext_t * C )
     {
-        vPortFree( pucPayload );
+        DEFINE_OTA_METHOD_NAME( "prvStartFileHash" );
+
+        C->ulHashedBlocks = 0U;
+
+        if( pdFALSE == CRYPTO_SignatureVerificationStart( &C->pvSigVerifyContext,
+                                                          cryptoASYMMETRIC_ALGORITHM_ECDSA,
+                                                          cryptoHASH_ALGORITHM_SHA256 ) )
+        {
+            OTA_LOG_L1( "[%s] Unable to start incremental hash, the file will be hashed at close.\r\n", OTA_METHOD_NAME );
+            C->pvSigVerifyContext = NULL;
+        }
     }
 
-    return eIngestResult;
-}
+/* prvHashDataBlock
+ *
+ * Feed a block that was just written to storage into the file's signature verification context.
+ * Only the contiguous prefix of the file can be hashed, so a block that arrives ahead of a gap is
+ * held until the missing blocks are received. If no slot is free to hold it, incremental hashing
+ * is abandoned and the PAL hashes the file from storage when it is closed. A block larger than
+ * the bitmap's block size may overlap the hashed prefix, in which case only the rest is hashed.
+ *
+ * The payload points into the MQTT receive buffer, so a held block is copied. Blocks that arrive
+ * in order are hashed straight from the receive buffer.
+ */
+    static void prvHashDataBlock( OTA_FileContext_t * C,
+                                  uint32_t ulBlockIndex,
+                                  const uint8_t * pucPayload,
+                                  uint32_t ulBlockSize )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvHashDataBlock" );
+
+        bool_t xHeld = pdFALSE;
+        bool_t xProgress;
+        uint32_t ulIndex;
+        OTA_PendingBlock_t * pxBlock;
+
+        if( C->pvSigVerifyContext != NULL )
+        {
+            if( ulBlockIndex <= C->ulHashedBlocks )
+            {
+                prvHashBlockTail( C, ulBlockIndex, pucPayload, ulBlockSize );
+
+                /* Hash any held blocks that are now contiguous with the hashed prefix. */
+                do
+                {
+                    xProgress = pdFALSE;
+
+                    for( ulIndex = 0U; ulIndex < otaconfigMAX_HASH_PENDING_BLOCKS; ulIndex++ )
+                    {
+                        pxBlock = &xOTA_Agent.pxPendingBlocks[ ulIndex ];
+
+                        if( ( pxBlock->pucData != NULL ) && ( pxBlock->ulBlockIndex <= C->ulHashedBlocks ) )
+                        {
+                            prvHashBlockTail( C, pxBlock->ulBlockIndex, pxBlock->pucData, pxBlock->ulBlockSize );
+                            vPortFree( pxBlock->pucData );
+                            pxBlock->pucData = NULL;
+                            xProgress = pdTRUE;
+                        }
+                    }
+                } while( xProgress == pdTRUE );
+            }
+            else
+            {
+                /* Find a free slot to hold the block until the gap before it is filled. */
+                for( ulIndex = 0U; ulIndex < otaconfigMAX_HASH_PENDING_BLOCKS; ulIndex++ )
+                {
+                    pxBlock = &xOTA_Agent.pxPendingBlocks[ ulIndex ];
+
+                    if( pxBlock->pucData == NULL )
+                    {
+                        pxBlock->pucData = ( uint8_t * ) pvPortMalloc( ulBlockSize ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+
+                        if( pxBlock->pucData != NULL )
+                        {
+                            memcpy( pxBlock->pucData, pucPayload, ulBlockSize );
+                            pxBlock->ulBlockIndex = ulBlockIndex;
+                            pxBlock->ulBlockSize = ulBlockSize;
+                            xHeld = pdTRUE;
+                        }
+
+                        break;
+                    }
+                }
+
+                if( xHeld == pdFALSE )
+                {
+                    OTA_LOG_L1( "[%s] Unable to hold a block out of order, the file will be hashed at close.\r\n", OTA_METHOD_NAME );
+                    prvStopFileHash( C );
+                }
+            }
+        }
+    }
+
+/* prvHashBlockTail
+ *
+ * Hash the part of a block that starts at the end of the hashed prefix of the file. The block must
+ * start at or before the end of the prefix. Nothing is hashed if the prefix already covers it.
+ */
+    static void prvHashBlockTail( OTA_FileContext_t * C,
+                                  uint32_t ulBlockIndex,
+                                  const uint8_t * pucPayload,
+                                  uint32_t ulBlockSize )
+    {
+        uint32_t ulEndBlock = ulBlockIndex + ( ( ulBlockSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE );
+        uint32_t ulSkip = ( C->ulHashedBlocks - ulBlockIndex ) << otaconfigLOG2_FILE_BLOCK_SIZE;
+
+        if( ulEndBlock > C->ulHashedBlocks )
+        {
+            CRYPTO_SignatureVerificationUpdate( C->pvSigVerifyContext, &pucPayload[ ulSkip ], ulBlockSize - ulSkip );
+            C->ulHashedBlocks = ulEndBlock;
+        }
+    }
+
+/* prvStopFileHash
+ *
+ * Release the file's signature verification context, if any, along with any blocks held for it.
+ */
+    static void prvStopFileHash( OTA_FileContext_t * C )
+    {
+        uint32_t ulIndex;
+
+        for( ulIndex = 0U; ulIndex < otaconfigMAX_HASH_PENDING_BLOCKS; ulIndex++ )
+        {
+            if( xOTA_Agent.pxPendingBlocks[ ulIndex ].pucData != NULL )
+            {
+                vPortFree( xOTA_Agent.pxPendingBlocks[ ulIndex ].pucData );
+                xOTA_Agent.pxPendingBlocks[ ulIndex ].pucData = NULL;
+            }
+        }
+
+        if( C->pvSigVerifyContext != NULL )
+        {
+            /* Finalizing without a certificate or signature just frees the context. */
+            ( void ) CRYPTO_SignatureVerificationFinal( C->pvSigVerifyContext, NULL, 0, NULL, 0 );
+            C->pvSigVerifyContext = NULL;
+        }
+
+        C->ulHashedBlocks = 0U;
+    }
+
+#endif /* otaconfigHASH_ON_INGEST */
+
+#if ( otaconfigDECOMPRESS_IMAGES == 1 )
+
+/* prvStartInflate
+ *
+ * Create the decompressor for a compressed file that is about to be received. Its window is the
+ * only memory it needs, so the largest window a file may be compressed with is set by the config.
+ */
+    static bool_t prvStartInflate( OTA_FileContext_t * C )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvStartInflate" );
+
+        C->ulInflatedBlocks = 0U;
+        C->pvInflateContext = OTA_Inflate_Create( otaconfigLOG2_MAX_DECOMPRESS_WINDOW, prvInflateOutput, C );
+
+        if( C->pvInflateContext == NULL )
+        {
+            OTA_LOG_L1( "[%s] Error: Unable to create the decompressor.\r\n", OTA_METHOD_NAME );
+        }
+
+        return ( C->pvInflateContext != NULL ) ? ( bool_t ) pdTRUE : ( bool_t ) pdFALSE;
+    }
+
+/* prvInflateDataBlock
+ *
+ * Feed a block of a compressed file into its decompressor. Only the contiguous prefix of the file
+ * can be decompressed, so a block that arrives ahead of a gap is copied and held until the missing
+ * blocks are received. If no slot is free to hold it, the block is deferred: it isn't marked as
+ * received so it is requested again once the gap has been filled.
+ */
+    static IngestResult_t prvInflateDataBlock( OTA_FileContext_t * C,
+                                               uint32_t ulBlockIndex,
+                                               const uint8_t * pucPayload,
+                                               uint32_t ulBlockSize )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvInflateDataBlock" );
+
+        IngestResult_t eIngestResult = eIngest_Result_Deferred_Continue;
+        bool_t xProgress;
+        uint32_t ulIndex;
+        OTA_PendingBlock_t * pxBlock;
+
+        if( ulBlockIndex <= C->ulInflatedBlocks )
+        {
+            eIngestResult = prvInflateBlockTail( C, ulBlockIndex, pucPayload, ulBlockSize );
+
+            /* Decompress any held blocks that are now contiguous with the decompressed prefix. */
+            do
+            {
+                xProgress = pdFALSE;
+
+                for( ulIndex = 0U; ( ulIndex < otaconfigMAX_DECOMPRESS_PENDING_BLOCKS ) && ( eIngestResult == eIngest_Result_Accepted_Continue ); ulIndex++ )
+                {
+                    pxBlock = &xOTA_Agent.pxInflatePendingBlocks[ ulIndex ];
+
+                    if( ( pxBlock->pucData != NULL ) && ( pxBlock->ulBlockIndex <= C->ulInflatedBlocks ) )
+                    {
+                        eIngestResult = prvInflateBlockTail( C, pxBlock->ulBlockIndex, pxBlock->pucData, pxBlock->ulBlockSize );
+                        vPortFree( pxBlock->pucData );
+                        pxBlock->pucData = NULL;
+                        xProgress = pdTRUE;
+                    }
+                }
+            } while( ( xProgress == pdTRUE ) && ( eIngestResult == eIngest_Result_Accepted_Continue ) );
+        }
+        else
+        {
+            /* Find a free slot to hold the block until the gap before it is filled. */
+            for( ulIndex = 0U; ulIndex < otaconfigMAX_DECOMPRESS_PENDING_BLOCKS; ulIndex++ )
+            {
+                pxBlock = &xOTA_Agent.pxInflatePendingBlocks[ ulIndex ];
+
+                if( pxBlock->pucData == NULL )
+                {
+                    pxBlock->pucData = ( uint8_t * ) pvPortMalloc( ulBlockSize ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+
+                    if( pxBlock->pucData != NULL )
+                    {
+                        memcpy( pxBlock->pucData, pucPayload, ulBlockSize );
+                        pxBlock->ulBlockIndex = ulBlockIndex;
+                        pxBlock->ulBlockSize = ulBlockSize;
+                        eIngestResult = eIngest_Result_Accepted_Continue;
+                    }
+
+                    break;
+                }
+            }
+
+            if( eIngestResult == eIngest_Result_Deferred_Continue )
+            {
+                OTA_LOG_L1( "[%s] Unable to hold block %u out of order, it will be requested again.\r\n", OTA_METHOD_NAME, ulBlockIndex );
+            }
+        }
+
+        return eIngestResult;
+    }
+
+/* prvInflateBlockTail
+ *
+ * Decompress the part of a block that starts at the end of the decompressed prefix of the file. The
+ * block must start at or before the end of the prefix. Nothing is decompressed if the prefix already
+ * covers it.
+ */
+    static IngestResult_t prvInflateBlockTail( OTA_FileContext_t * C,
+                                               uint32_t ulBlockIndex,
+                                               const uint8_t * pucPayload,
+                                               uint32_t ulBlockSize )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvInflateBlockTail" );
+
+        IngestResult_t eIngestResult = eIngest_Result_Accepted_Continue;
+        OTA_InflateStatus_t xStatus;
+        uint32_t ulEndBlock = ulBlockIndex + ( ( ulBlockSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE );
+        uint32_t ulSkip = ( C->ulInflatedBlocks - ulBlockIndex ) << otaconfigLOG2_FILE_BLOCK_SIZE;
+
+        if( ulEndBlock > C->ulInflatedBlocks )
+        {
+            xStatus = OTA_Inflate_Decompress( ( OTA_InflateContext_t * ) C->pvInflateContext, &pucPayload[ ulSkip ], ulBlockSize - ulSkip );
+            C->ulInflatedBlocks = ulEndBlock;
+
+            if( xStatus == eOTA_Inflate_ErrOutput )
+            {
+                OTA_LOG_L1( "[%s] Error writing decompressed data.\r\n", OTA_METHOD_NAME );
+                eIngestResult = eIngest_Result_WriteBlockFailed;
+            }
+            else if( ( int32_t ) xStatus < 0 )
+            {
+                OTA_LOG_L1( "[%s] Error (%d) decompressing block %u.\r\n", OTA_METHOD_NAME, ( int32_t ) xStatus, ulBlockIndex );
+                eIngestResult = eIngest_Result_BadData;
+            }
+            else
+            {
+                /* The stream continues or is complete. */
+            }
+        }
+
+        return eIngestResult;
+    }
+
+/* prvInflateOutput
+ *
+ * Write a chunk of decompressed data to the file. The PAL takes at most a block at a time, so the
+ * chunk is split into blocks. With hash on ingest the decompressed data is hashed here, since the
+ * signature is of the decompressed file and the decompressor always outputs it in order.
+ */
+    static BaseType_t prvInflateOutput( void * pvContext,
+                                        uint32_t ulOffset,
+                                        const uint8_t * pucData,
+                                        uint32_t ulSize )
+    {
+        DEFINE_OTA_METHOD_NAME( "prvInflateOutput" );
+
+        OTA_FileContext_t * C = ( OTA_FileContext_t * ) pvContext;
+        BaseType_t xResult = pdTRUE;
+        uint32_t ulDone = 0U;
+        uint32_t ulChunk;
+        int16_t sBytesWritten;
+
+        /* Don't write past the size given in the job document. */
+        if( ( ulOffset > C->ulImageSize ) || ( ulSize > ( C->ulImageSize - ulOffset ) ) )
+        {
+            OTA_LOG_L1( "[%s] Error: Decompressed file is larger than %u bytes.\r\n", OTA_METHOD_NAME, C->ulImageSize );
+            xResult = pdFALSE;
+        }
+
+        while( ( xResult == pdTRUE ) && ( ulDone < ulSize ) )
+        {
+            ulChunk = ( ( ulSize - ulDone ) < OTA_FILE_BLOCK_SIZE ) ? ( ulSize - ulDone ) : OTA_FILE_BLOCK_SIZE;
+            sBytesWritten = xOTA_Agent.xPALCallbacks.xWriteBlock( C, ulOffset + ulDone, ( uint8_t * ) &pucData[ ulDone ], ulChunk ); /*lint !e9005 The PAL doesn't modify the block. */
+
+            if( sBytesWritten < 0 )
+            {
+                OTA_LOG_L1( "[%s] Error (%d) writing decompressed data\r\n", OTA_METHOD_NAME, sBytesWritten );
+                xResult = pdFALSE;
+            }
+            else
+            {
+                ulDone += ulChunk;
+            }
+        }
+
+        #if ( otaconfigHASH_ON_INGEST == 1 )
+            if( ( xResult == pdTRUE ) && ( C->pvSigVerifyContext != NULL ) )
+            {
+                CRYPTO_SignatureVerificationUpdate( C->pvSigVerifyContext, pucData, ulSize );
+            }
+        #endif
+
+        return xResult;
+    }
+
+/* prvFinishInflate
+ *
+ * Called after the last block of a compressed file was received. Checks that the end of the stream
+ * was reached and that it decompressed to the size given in the job document.
+ */
+    static bool_t prvFinishInflate( OTA_FileContext_t * C )
+    {
+        OTA_InflateContext_t * pxInflate = ( OTA_InflateContext_t * ) C->pvInflateContext;
+        bool_t xResult = pdFALSE;
+
+        if( ( OTA_Inflate_Decompress( pxInflate, NULL, 0U ) == eOTA_Inflate_Done ) &&
+            ( OTA_Inflate_GetTotalOut( pxInflate ) == C->ulImageSize ) )
+        {
+            xResult = pdTRUE;
+        }
+
+        return xResult;
+    }
+
+/* prvStopInflate
+ *
+ * Release the file's decompressor, if any, along with any blocks held for it.
+ */
+    static void prvStopInflate( OTA_FileContext_t * C )
+    {
+        uint32_t ulIndex;
+
+        for( ulIndex = 0U; ulIndex < otaconfigMAX_DECOMPRESS_PENDING_BLOCKS; ulIndex++ )
+        {
+            if( xOTA_Agent.pxInflatePendingBlocks[ ulIndex ].pucData != NULL )
+            {
+                vPortFree( xOTA_Agent.pxInflatePendingBlocks[ ulIndex ].pucData );
+                xOTA_Agent.pxInflatePendingBlocks[ ulIndex ].pucData = NULL;
+            }
+        }
+
+        if( C->pvInflateContext != NULL )
+        {
+            OTA_Inflate_Delete( ( OTA_InflateContext_t * ) C->pvInflateContext );
+            C->pvInflateContext = NULL;
+        }
+
+        C->ulInflatedBlocks = 0U;
+    }
+
+#endif /* otaconfigDECOMPRESS_IMAGES */
 
 
 /* Subscribe to the OTA job notification topics. */
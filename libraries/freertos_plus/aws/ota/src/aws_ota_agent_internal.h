@@ -39,6 +39,72 @@
 #define BITS_PER_BYTE          ( 1UL << LOG2_BITS_PER_BYTE )            /* Number of bits in a byte. This is used by the block bitmap implementation. */
 #define OTA_FILE_BLOCK_SIZE    ( 1UL << otaconfigLOG2_FILE_BLOCK_SIZE ) /* Data section size of the file data block message (excludes the header). */
 
+/* Set to 1 to have the agent hash file blocks into an incremental SHA-256 signature verification
+ * context as they are received, so that closing the file only needs the final signature check.
+ * Requires the PAL to verify ECDSA SHA-256 signatures through the CRYPTO abstraction. */
+#ifndef otaconfigHASH_ON_INGEST
+    #define otaconfigHASH_ON_INGEST            0
+#endif
+
+/* Set to 1 if the PAL implements prvPAL_SaveCheckpoint() and prvPAL_LoadCheckpoint(). The agent
+ * then checkpoints the block bitmap of a file transfer so that a transfer interrupted by a reset
+ * or an agent shutdown resumes with only the missing blocks when its job is received again. */
+#ifndef otaconfigRESUME_TRANSFERS
+    #define otaconfigRESUME_TRANSFERS              0
+#endif
+
+/* Checkpoint the progress of a resumable file transfer each time this many more blocks are received. */
+#ifndef otaconfigCHECKPOINT_INTERVAL_BLOCKS
+    #define otaconfigCHECKPOINT_INTERVAL_BLOCKS    32U
+#endif
+
+/* The number of out of order blocks held in RAM while waiting for the hashed prefix of the file
+ * to reach them. If more are outstanding, incremental hashing stops and the PAL hashes the file
+ * from storage when it is closed. */
+#ifndef otaconfigMAX_HASH_PENDING_BLOCKS
+    #define otaconfigMAX_HASH_PENDING_BLOCKS    4U
+#endif
+
+/* Set to 1 to keep a window of block requests outstanding on the data stream instead of
+ * requesting otaconfigMAX_NUM_BLOCKS_REQUEST blocks and waiting for all of them (or for
+ * otaconfigFILE_REQUEST_WAIT_MS) before asking for more. More blocks are requested as blocks
+ * arrive, and the window and block size adapt to the blocks that are lost. */
+#ifndef otaconfigPIPELINE_BLOCK_REQUESTS
+    #define otaconfigPIPELINE_BLOCK_REQUESTS    0
+#endif
+
+/* The largest window of outstanding block requests, in blocks of 1 << otaconfigLOG2_FILE_BLOCK_SIZE. */
+#ifndef otaconfigMAX_WINDOW_BLOCKS
+    #define otaconfigMAX_WINDOW_BLOCKS    otaconfigMAX_NUM_BLOCKS_REQUEST
+#endif
+
+/* Log base 2 of the largest block size the pipelined requester may grow to. Received messages are
+ * buffered at this size. The default keeps the block size fixed at otaconfigLOG2_FILE_BLOCK_SIZE. */
+#ifndef otaconfigLOG2_MAX_FILE_BLOCK_SIZE
+    #define otaconfigLOG2_MAX_FILE_BLOCK_SIZE    otaconfigLOG2_FILE_BLOCK_SIZE
+#endif
+
+/* Set to 1 to accept files that the job document marks as compressed with "compression": "zlib".
+ * A compressed file is decompressed as its blocks are received and the PAL is given the decompressed
+ * image, so it must size the file from ulImageSize rather than ulFileSize. The transfer of a
+ * compressed file is not checkpointed since the decompressor's state can't be resumed. */
+#ifndef otaconfigDECOMPRESS_IMAGES
+    #define otaconfigDECOMPRESS_IMAGES    0
+#endif
+
+/* Log base 2 of the decompression window. Files must be compressed with a window no larger than
+ * this (zlib's windowBits), or the job is failed. The window is allocated while a file is received. */
+#ifndef otaconfigLOG2_MAX_DECOMPRESS_WINDOW
+    #define otaconfigLOG2_MAX_DECOMPRESS_WINDOW    12U
+#endif
+
+/* The number of out of order blocks of a compressed file held in RAM while waiting for the
+ * decompressed prefix of the file to reach them. Blocks that arrive further ahead are dropped and
+ * requested again. */
+#ifndef otaconfigMAX_DECOMPRESS_PENDING_BLOCKS
+    #define otaconfigMAX_DECOMPRESS_PENDING_BLOCKS    4U
+#endif
+
 typedef enum
 {
     eIngest_Result_FileComplete = -1,       /* The file transfer is complete and the signature check passed. */
@@ -54,6 +120,7 @@ typedef enum
     eIngest_Result_Uninitialized = -127,    /* Software BUG: We forgot to set the result code. */
     eIngest_Result_Accepted_Continue = 0,   /* The block was accepted and we're expecting more. */
     eIngest_Result_Duplicate_Continue = 1,  /* The block was a duplicate but that's OK. Continue. */
+    eIngest_Result_Deferred_Continue = 2,   /* The block can't be decompressed yet and will be requested again. Continue. */
 } IngestResult_t;
 
 /* Generic JSON document parser errors. */
@@ -56,12 +56,12 @@ BaseType_t OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pucMessageB
                                                      int32_t * plFileId,
                                                      int32_t * plBlockId,
                                                      int32_t * plBlockSize,
-                                                     uint8_t ** ppucPayload,
+                                                     const uint8_t ** ppucPayload,
                                                      size_t * pxPayloadSize )
 {
     CborError xCborResult = CborNoError;
     CborParser xCborParser;
-    CborValue xCborValue, xCborMap;
+    CborValue xCborValue, xCborMap, xCborNext;
 
     /* Initialize the parser. */
     xCborResult = cbor_parser_init( pucMessageBuffer,
@@ -162,27 +162,81 @@ BaseType_t OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pucMessageB
         }
     }
 
+    /* The payload is returned in place, so it must be a single chunk. The
+     * stream service never sends indefinite length strings. */
+    if( CborNoError == xCborResult )
+    {
+        xCborResult = cbor_value_get_string_length( &xCborValue,
+                                                    pxPayloadSize );
+    }
+
+    /* Step over the payload. Its bytes are the ones just before the next
+     * value. */
+    if( CborNoError == xCborResult )
+    {
+        xCborNext = xCborValue;
+        xCborResult = cbor_value_advance( &xCborNext );
+    }
+
+    if( CborNoError == xCborResult )
+    {
+        *ppucPayload = cbor_value_get_next_byte( &xCborNext ) - *pxPayloadSize;
+    }
+
+    return CborNoError == xCborResult;
+}
+
+/**
+ * @brief Decode the client token echoed back in a Get Stream response message.
+ * Returns pdFALSE if the response has no client token or it doesn't fit.
+ */
+BaseType_t OTA_CBOR_Decode_GetStreamResponseClientToken( const uint8_t * pucMessageBuffer,
+                                                         size_t xMessageSize,
+                                                         char * pcClientToken,
+                                                         size_t xClientTokenSize )
+{
+    CborError xCborResult = CborNoError;
+    CborParser xCborParser;
+    CborValue xCborValue, xCborMap;
+    size_t xTokenSize = xClientTokenSize;
+
+    /* Initialize the parser. */
+    xCborResult = cbor_parser_init( pucMessageBuffer,
+                                    xMessageSize,
+                                    0,
+                                    &xCborParser,
+                                    &xCborMap );
+
     if( CborNoError == xCborResult )
     {
-        xCborResult = cbor_value_calculate_string_length( &xCborValue,
-                                                          pxPayloadSize );
+        if( false == cbor_value_is_map( &xCborMap ) )
+        {
+            xCborResult = CborErrorIllegalType;
+        }
     }
 
+    /* Find the client token. */
     if( CborNoError == xCborResult )
     {
-        *ppucPayload = pvPortMalloc( *pxPayloadSize );
+        xCborResult = cbor_value_map_find_value( &xCborMap,
+                                                 OTA_CBOR_CLIENTTOKEN_KEY,
+                                                 &xCborValue );
+    }
 
-        if( NULL == *ppucPayload )
+    if( CborNoError == xCborResult )
+    {
+        if( CborTextStringType != cbor_value_get_type( &xCborValue ) )
         {
-            xCborResult = CborErrorOutOfMemory;
+            xCborResult = CborErrorIllegalType;
         }
     }
 
+    /* The copy fails if the token and its terminator don't fit. */
     if( CborNoError == xCborResult )
     {
-        xCborResult = cbor_value_copy_byte_string( &xCborValue,
-                                                   *ppucPayload,
-                                                   pxPayloadSize,
+        xCborResult = cbor_value_copy_text_string( &xCborValue,
+                                                   pcClientToken,
+                                                   &xTokenSize,
                                                    NULL );
     }
 
@@ -28,15 +28,26 @@
 
 /**
  * @brief Decode a Get Stream response message from AWS IoT OTA.
+ *
+ * The payload is not copied. *ppucPayload points into pucMessageBuffer and is
+ * only valid for as long as the message buffer is.
  */
 BaseType_t OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pucMessageBuffer,
                                                      size_t xMessageSize,
                                                      int32_t * plFileId,
                                                      int32_t * plBlockId,
                                                      int32_t * plBlockSize,
-                                                     uint8_t ** ppucPayload,
+                                                     const uint8_t ** ppucPayload,
                                                      size_t * pxPayloadSize );
 
+/**
+ * @brief Decode the client token echoed back in a Get Stream response message.
+ */
+BaseType_t OTA_CBOR_Decode_GetStreamResponseClientToken( const uint8_t * pucMessageBuffer,
+                                                         size_t xMessageSize,
+                                                         char * pcClientToken,
+                                                         size_t xClientTokenSize );
+
 /**
  * @brief Create an encoded Get Stream Request message for the AWS IoT OTA
  * service.
@@ -0,0 +1,1012 @@
+/*
+ * Amazon FreeRTOS OTA V1.0.4
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_ota_inflate.c
+ * @brief Streaming zlib decompression of AWS IoT Over-the-Air update files.
+ *
+ * The decompressor is fed the compressed file a block at a time and may stop at any bit of the
+ * stream, so it keeps all of its state in its context instead of on the stack. Huffman codes are
+ * only consumed once all of their bits and extra bits have been received; until then the bits
+ * are kept in the bit buffer for the next call. The history window doubles as the output buffer,
+ * so the only memory used besides the context is the window the stream was compressed with.
+ */
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "aws_ota_inflate.h"
+
+#define OTA_INFLATE_MIN_LOG2_WINDOW    8U     /* Smallest window of a zlib stream. */
+#define OTA_INFLATE_MAX_LOG2_WINDOW    15U    /* Largest window of a zlib stream. */
+#define OTA_INFLATE_MAX_BITS           15U    /* Longest Huffman code. */
+#define OTA_INFLATE_MAX_LCODES         286U   /* Most literal/length codes in a dynamic block. */
+#define OTA_INFLATE_MAX_DCODES         30U    /* Most distance codes in a dynamic block. */
+#define OTA_INFLATE_FIXED_LCODES       288U   /* Literal/length codes of the fixed code. */
+#define OTA_INFLATE_CODE_LENGTH_CODES  19U    /* Code length codes of a dynamic block. */
+#define OTA_INFLATE_END_OF_BLOCK       256U   /* Literal/length symbol ending a block. */
+#define OTA_INFLATE_ADLER_BASE         65521UL
+#define OTA_INFLATE_ADLER_NMAX         5552U  /* Most bytes summed before the Adler-32 sums must be reduced. */
+#define OTA_INFLATE_NEED_BITS          ( -1 ) /* A Huffman code continues past the bits received so far. */
+#define OTA_INFLATE_BAD_CODE           ( -2 ) /* The bits received are not a code. */
+
+/**
+ * @brief Where the decompressor is in the stream.
+ */
+typedef enum
+{
+    eInflateState_Header,            /* Expecting the zlib header. */
+    eInflateState_Block,             /* Expecting a block header. */
+    eInflateState_StoredLength,      /* Expecting the length of a stored block. */
+    eInflateState_Stored,            /* Copying a stored block. */
+    eInflateState_TableSizes,        /* Expecting the code counts of a dynamic block. */
+    eInflateState_CodeLengthLengths, /* Expecting the code length code lengths of a dynamic block. */
+    eInflateState_CodeLengths,       /* Expecting the code lengths of a dynamic block. */
+    eInflateState_Length,            /* Expecting a literal, a match length or the end of the block. */
+    eInflateState_Distance,          /* Expecting the distance code of a match. */
+    eInflateState_DistanceExtra,     /* Expecting the extra bits of the distance of a match. */
+    eInflateState_Trailer,           /* Expecting the Adler-32 checksum. */
+    eInflateState_Done,              /* The end of the stream was reached. */
+    eInflateState_Error              /* The stream can't be continued. */
+} OTA_InflateState_t;
+
+/**
+ * @brief Canonical Huffman code, by the number of codes of each length and the symbols in code order.
+ */
+typedef struct
+{
+    uint16_t usCount[ OTA_INFLATE_MAX_BITS + 1U ];
+    uint16_t usSymbol[ OTA_INFLATE_FIXED_LCODES ];
+} OTA_HuffmanCode_t;
+
+struct OTA_InflateContext
+{
+    OTA_InflateState_t eState;                                        /* Where the decompressor is in the stream. */
+    OTA_InflateStatus_t eError;                                       /* Why the stream can't be continued, in eInflateState_Error. */
+    OTA_InflateOutput_t xOutput;                                      /* Function taking the decompressed data. */
+    void * pvOutputContext;                                           /* Context of the output function. */
+    uint32_t ulBitBuffer;                                             /* Bits received but not yet consumed, first bit lowest. */
+    uint32_t ulBitCount;                                              /* Number of bits in ulBitBuffer. */
+    BaseType_t xLastBlock;                                            /* True while decoding the last block of the stream. */
+    uint32_t ulCount;                                                 /* Bytes left of a stored block, or code lengths read. */
+    uint32_t ulLengthCodes;                                           /* Literal/length codes of the dynamic block. */
+    uint32_t ulDistanceCodes;                                         /* Distance codes of the dynamic block. */
+    uint32_t ulCodeLengthCodes;                                       /* Code length codes of the dynamic block. */
+    uint32_t ulMatchLength;                                           /* Length of the match whose distance is expected. */
+    uint32_t ulDistanceSymbol;                                        /* Distance symbol whose extra bits are expected. */
+    uint32_t ulStreamWindow;                                          /* Window size declared by the stream header. */
+    uint32_t ulAdler;                                                 /* Adler-32 of the data output so far. */
+    uint32_t ulTotalOut;                                              /* Bytes decompressed so far. */
+    uint32_t ulWindowSize;                                            /* Size of pucWindow. */
+    uint32_t ulWindowPos;                                             /* Position in pucWindow of the next byte. */
+    uint32_t ulFlushed;                                               /* Position in pucWindow up to which data was output. */
+    uint8_t * pucWindow;                                              /* The last ulWindowSize bytes decompressed. */
+    OTA_HuffmanCode_t xLengthCode;                                    /* Literal/length code, or the code length code. */
+    OTA_HuffmanCode_t xDistanceCode;                                  /* Distance code. */
+    uint8_t ucLengths[ OTA_INFLATE_MAX_LCODES + OTA_INFLATE_MAX_DCODES ]; /* Code lengths of the dynamic block. */
+};
+
+/* Base values and extra bits of the match length and distance symbols, per RFC 1951. */
+
+static const uint16_t usLengthBase[ 29 ] =
+{
+    3,  4,  5,  6,  7,  8,  9,  10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t ucLengthExtra[ 29 ] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t usDistanceBase[ OTA_INFLATE_MAX_DCODES ] =
+{
+    1,    2,    3,    4,    5,    7,    9,    13,   17,   25,   33,    49,    65,    97,    129,
+    193,  257,  385,  513,  769,  1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t ucDistanceExtra[ OTA_INFLATE_MAX_DCODES ] =
+{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* The order in which the code length code lengths are sent. */
+
+static const uint8_t ucCodeLengthOrder[ OTA_INFLATE_CODE_LENGTH_CODES ] =
+{
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/*-----------------------------------------------------------*/
+
+/* Build a canonical Huffman code from the code length of each symbol. Returns 0 for a complete
+ * code, a positive number for an incomplete one and a negative number for an over-subscribed one. */
+
+static int32_t prvBuildCode( OTA_HuffmanCode_t * pxCode,
+                             const uint8_t * pucLengths,
+                             uint32_t ulNumSymbols )
+{
+    uint16_t usOffsets[ OTA_INFLATE_MAX_BITS + 1U ];
+    uint32_t ulSymbol;
+    uint32_t ulLength;
+    int32_t lLeft = 1;
+
+    memset( pxCode->usCount, 0, sizeof( pxCode->usCount ) );
+
+    for( ulSymbol = 0U; ulSymbol < ulNumSymbols; ulSymbol++ )
+    {
+        pxCode->usCount[ pucLengths[ ulSymbol ] ]++;
+    }
+
+    if( pxCode->usCount[ 0 ] != ulNumSymbols )
+    {
+        /* Each length leaves twice as many codes as the last, less those used. */
+        for( ulLength = 1U; ( ulLength <= OTA_INFLATE_MAX_BITS ) && ( lLeft >= 0 ); ulLength++ )
+        {
+            lLeft = ( lLeft << 1 ) - ( int32_t ) pxCode->usCount[ ulLength ];
+        }
+
+        if( lLeft >= 0 )
+        {
+            usOffsets[ 1 ] = 0U;
+
+            for( ulLength = 1U; ulLength < OTA_INFLATE_MAX_BITS; ulLength++ )
+            {
+                usOffsets[ ulLength + 1U ] = usOffsets[ ulLength ] + pxCode->usCount[ ulLength ];
+            }
+
+            for( ulSymbol = 0U; ulSymbol < ulNumSymbols; ulSymbol++ )
+            {
+                if( pucLengths[ ulSymbol ] != 0U )
+                {
+                    pxCode->usSymbol[ usOffsets[ pucLengths[ ulSymbol ] ]++ ] = ( uint16_t ) ulSymbol;
+                }
+            }
+        }
+    }
+    else
+    {
+        lLeft = 0; /* No codes at all. Decoding with this code fails. */
+    }
+
+    return lLeft;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Only the literal/length and distance codes of a stream with a single code of that kind may be
+ * incomplete, and only by having the one code of length 1. */
+
+static BaseType_t prvIsValidCode( const OTA_HuffmanCode_t * pxCode,
+                                  int32_t lLeft,
+                                  uint32_t ulNumSymbols )
+{
+    return ( lLeft == 0 ) ||
+           ( ( lLeft > 0 ) && ( ulNumSymbols == ( uint32_t ) pxCode->usCount[ 0 ] + pxCode->usCount[ 1 ] ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/* Decode the Huffman code at the start of the bit buffer without consuming it. Returns the symbol
+ * and its code length, OTA_INFLATE_NEED_BITS if the code is longer than the bits buffered or
+ * OTA_INFLATE_BAD_CODE if the bits don't match any code. */
+
+static int32_t prvPeekSymbol( const OTA_HuffmanCode_t * pxCode,
+                              uint32_t ulBits,
+                              uint32_t ulBitCount,
+                              uint32_t * pulCodeLength )
+{
+    int32_t lSymbol = OTA_INFLATE_BAD_CODE;
+    int32_t lCode = 0;  /* The bits of the code so far. */
+    int32_t lFirst = 0; /* The first code of the current length. */
+    int32_t lIndex = 0; /* The index of the first code of the current length in usSymbol. */
+    int32_t lCount;
+    uint32_t ulLength;
+
+    for( ulLength = 1U; ulLength <= OTA_INFLATE_MAX_BITS; ulLength++ )
+    {
+        if( ulLength > ulBitCount )
+        {
+            lSymbol = OTA_INFLATE_NEED_BITS;
+            break;
+        }
+
+        lCode |= ( int32_t ) ( ( ulBits >> ( ulLength - 1U ) ) & 1U );
+        lCount = ( int32_t ) pxCode->usCount[ ulLength ];
+
+        if( ( lCode - lCount ) < lFirst )
+        {
+            lSymbol = ( int32_t ) pxCode->usSymbol[ lIndex + ( lCode - lFirst ) ];
+            *pulCodeLength = ulLength;
+            break;
+        }
+
+        lIndex += lCount;
+        lFirst = ( lFirst + lCount ) << 1;
+        lCode <<= 1;
+    }
+
+    return lSymbol;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvConsumeBits( OTA_InflateContext_t * pxContext,
+                            uint32_t ulCount )
+{
+    pxContext->ulBitBuffer >>= ulCount;
+    pxContext->ulBitCount -= ulCount;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Stop decompressing the stream for good. */
+
+static void prvSetError( OTA_InflateContext_t * pxContext,
+                         OTA_InflateStatus_t eError )
+{
+    pxContext->eState = eInflateState_Error;
+    pxContext->eError = eError;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Pass the data added to the window since the last flush to the output function, and start over
+ * at the beginning of the window once it is full. */
+
+static void prvFlushWindow( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulSize = pxContext->ulWindowPos - pxContext->ulFlushed;
+    const uint8_t * pucData = &pxContext->pucWindow[ pxContext->ulFlushed ];
+    uint32_t ulS1 = pxContext->ulAdler & 0xffffUL;
+    uint32_t ulS2 = pxContext->ulAdler >> 16;
+    uint32_t ulChunk;
+    uint32_t ulIndex;
+
+    if( ulSize > 0U )
+    {
+        if( pdFALSE == pxContext->xOutput( pxContext->pvOutputContext, pxContext->ulTotalOut - ulSize, pucData, ulSize ) )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrOutput );
+        }
+
+        /* Update the Adler-32 of the output, reducing the sums before they can overflow. */
+        while( ulSize > 0U )
+        {
+            ulChunk = ( ulSize < OTA_INFLATE_ADLER_NMAX ) ? ulSize : OTA_INFLATE_ADLER_NMAX;
+
+            for( ulIndex = 0U; ulIndex < ulChunk; ulIndex++ )
+            {
+                ulS1 += pucData[ ulIndex ];
+                ulS2 += ulS1;
+            }
+
+            ulS1 %= OTA_INFLATE_ADLER_BASE;
+            ulS2 %= OTA_INFLATE_ADLER_BASE;
+            pucData = &pucData[ ulChunk ];
+            ulSize -= ulChunk;
+        }
+
+        pxContext->ulAdler = ( ulS2 << 16 ) | ulS1;
+        pxContext->ulFlushed = pxContext->ulWindowPos;
+    }
+
+    if( pxContext->ulWindowPos == pxContext->ulWindowSize )
+    {
+        pxContext->ulWindowPos = 0U;
+        pxContext->ulFlushed = 0U;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/* Add decompressed bytes to the window. */
+
+static void prvOutputBytes( OTA_InflateContext_t * pxContext,
+                            const uint8_t * pucData,
+                            uint32_t ulSize )
+{
+    uint32_t ulChunk;
+
+    while( ( ulSize > 0U ) && ( pxContext->eState != eInflateState_Error ) )
+    {
+        ulChunk = pxContext->ulWindowSize - pxContext->ulWindowPos;
+        ulChunk = ( ulSize < ulChunk ) ? ulSize : ulChunk;
+        memcpy( &pxContext->pucWindow[ pxContext->ulWindowPos ], pucData, ulChunk );
+        pxContext->ulWindowPos += ulChunk;
+        pxContext->ulTotalOut += ulChunk;
+        pucData = &pucData[ ulChunk ];
+        ulSize -= ulChunk;
+
+        if( pxContext->ulWindowPos == pxContext->ulWindowSize )
+        {
+            prvFlushWindow( pxContext );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/* Add a copy of earlier decompressed data to the window. The match may overlap itself. */
+
+static void prvCopyMatch( OTA_InflateContext_t * pxContext,
+                          uint32_t ulDistance,
+                          uint32_t ulLength )
+{
+    uint32_t ulFrom = ( pxContext->ulWindowPos + pxContext->ulWindowSize - ulDistance ) & ( pxContext->ulWindowSize - 1U );
+
+    while( ( ulLength > 0U ) && ( pxContext->eState != eInflateState_Error ) )
+    {
+        pxContext->pucWindow[ pxContext->ulWindowPos ] = pxContext->pucWindow[ ulFrom ];
+        pxContext->ulWindowPos++;
+        pxContext->ulTotalOut++;
+        ulFrom = ( ulFrom + 1U ) & ( pxContext->ulWindowSize - 1U );
+        ulLength--;
+
+        if( pxContext->ulWindowPos == pxContext->ulWindowSize )
+        {
+            prvFlushWindow( pxContext );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/* Move on from the end of a block to the next one or, after the last, to the checksum. */
+
+static void prvEndBlock( OTA_InflateContext_t * pxContext )
+{
+    if( pxContext->xLastBlock == pdTRUE )
+    {
+        /* The checksum covers all of the data, so output what's left of it first. */
+        prvFlushWindow( pxContext );
+
+        if( pxContext->eState != eInflateState_Error )
+        {
+            pxContext->eState = eInflateState_Trailer;
+        }
+    }
+    else
+    {
+        pxContext->eState = eInflateState_Block;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/* Use the fixed codes of RFC 1951 for the block. */
+
+static void prvBuildFixedCodes( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulSymbol;
+
+    for( ulSymbol = 0U; ulSymbol < OTA_INFLATE_FIXED_LCODES; ulSymbol++ )
+    {
+        pxContext->ucLengths[ ulSymbol ] = ( ulSymbol < 144U ) ? 8U : ( ( ulSymbol < 256U ) ? 9U : ( ( ulSymbol < 280U ) ? 7U : 8U ) );
+    }
+
+    ( void ) prvBuildCode( &pxContext->xLengthCode, pxContext->ucLengths, OTA_INFLATE_FIXED_LCODES );
+
+    memset( pxContext->ucLengths, 5, OTA_INFLATE_MAX_DCODES );
+    ( void ) prvBuildCode( &pxContext->xDistanceCode, pxContext->ucLengths, OTA_INFLATE_MAX_DCODES );
+}
+
+/*-----------------------------------------------------------*/
+
+/* Decode the zlib header, which must declare deflate data and a window no larger than ours. */
+
+static BaseType_t prvDecodeHeader( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulMethod;
+    uint32_t ulFlags;
+    uint32_t ulLog2Window;
+
+    if( pxContext->ulBitCount >= 16U )
+    {
+        ulMethod = pxContext->ulBitBuffer & 0xffUL;
+        ulFlags = ( pxContext->ulBitBuffer >> 8 ) & 0xffUL;
+        ulLog2Window = ( ulMethod >> 4 ) + 8U;
+        prvConsumeBits( pxContext, 16U );
+
+        /* Deflate, no preset dictionary and a valid header check. */
+        if( ( ( ulMethod & 0x0fUL ) != 8U ) || ( ulLog2Window > OTA_INFLATE_MAX_LOG2_WINDOW ) ||
+            ( ( ulFlags & 0x20UL ) != 0U ) || ( ( ( ulMethod << 8 ) | ulFlags ) % 31U != 0U ) )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+        else if( ( 1UL << ulLog2Window ) > pxContext->ulWindowSize )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrWindowSize );
+        }
+        else
+        {
+            pxContext->ulStreamWindow = 1UL << ulLog2Window;
+            pxContext->eState = eInflateState_Block;
+        }
+    }
+
+    return pxContext->eState != eInflateState_Header;
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDecodeBlockHeader( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulType;
+
+    if( pxContext->ulBitCount >= 3U )
+    {
+        pxContext->xLastBlock = ( ( pxContext->ulBitBuffer & 1U ) != 0U ) ? pdTRUE : pdFALSE;
+        ulType = ( pxContext->ulBitBuffer >> 1 ) & 3U;
+        prvConsumeBits( pxContext, 3U );
+
+        if( ulType == 0U )
+        {
+            pxContext->eState = eInflateState_StoredLength;
+        }
+        else if( ulType == 1U )
+        {
+            prvBuildFixedCodes( pxContext );
+            pxContext->eState = eInflateState_Length;
+        }
+        else if( ulType == 2U )
+        {
+            pxContext->eState = eInflateState_TableSizes;
+        }
+        else
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+    }
+
+    return pxContext->eState != eInflateState_Block;
+}
+
+/*-----------------------------------------------------------*/
+
+/* A stored block starts at a byte boundary with its length and the complement of its length. */
+
+static BaseType_t prvDecodeStoredLength( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulLength;
+
+    prvConsumeBits( pxContext, pxContext->ulBitCount & 7U );
+
+    if( pxContext->ulBitCount >= 32U )
+    {
+        ulLength = pxContext->ulBitBuffer & 0xffffUL;
+        prvConsumeBits( pxContext, 16U );
+
+        if( ulLength != ( ~pxContext->ulBitBuffer & 0xffffUL ) )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+        else
+        {
+            prvConsumeBits( pxContext, 16U );
+            pxContext->ulCount = ulLength;
+            pxContext->eState = eInflateState_Stored;
+        }
+    }
+
+    return pxContext->eState != eInflateState_StoredLength;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Copy a stored block, first from the bytes already in the bit buffer and then straight from the input. */
+
+static BaseType_t prvCopyStored( OTA_InflateContext_t * pxContext,
+                                 const uint8_t ** ppucNext,
+                                 const uint8_t * pucEnd )
+{
+    uint8_t ucByte;
+    uint32_t ulChunk;
+
+    while( ( pxContext->ulCount > 0U ) && ( pxContext->ulBitCount >= 8U ) && ( pxContext->eState == eInflateState_Stored ) )
+    {
+        ucByte = ( uint8_t ) pxContext->ulBitBuffer;
+        prvConsumeBits( pxContext, 8U );
+        prvOutputBytes( pxContext, &ucByte, 1U );
+        pxContext->ulCount--;
+    }
+
+    if( ( pxContext->ulCount > 0U ) && ( *ppucNext < pucEnd ) && ( pxContext->eState == eInflateState_Stored ) )
+    {
+        ulChunk = ( uint32_t ) ( pucEnd - *ppucNext );
+        ulChunk = ( pxContext->ulCount < ulChunk ) ? pxContext->ulCount : ulChunk;
+        prvOutputBytes( pxContext, *ppucNext, ulChunk );
+        *ppucNext = &( *ppucNext )[ ulChunk ];
+        pxContext->ulCount -= ulChunk;
+    }
+
+    if( ( pxContext->ulCount == 0U ) && ( pxContext->eState == eInflateState_Stored ) )
+    {
+        prvEndBlock( pxContext );
+    }
+
+    return pxContext->eState != eInflateState_Stored;
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDecodeTableSizes( OTA_InflateContext_t * pxContext )
+{
+    if( pxContext->ulBitCount >= 14U )
+    {
+        pxContext->ulLengthCodes = ( pxContext->ulBitBuffer & 0x1fUL ) + 257U;
+        pxContext->ulDistanceCodes = ( ( pxContext->ulBitBuffer >> 5 ) & 0x1fUL ) + 1U;
+        pxContext->ulCodeLengthCodes = ( ( pxContext->ulBitBuffer >> 10 ) & 0x0fUL ) + 4U;
+        prvConsumeBits( pxContext, 14U );
+
+        if( ( pxContext->ulLengthCodes > OTA_INFLATE_MAX_LCODES ) || ( pxContext->ulDistanceCodes > OTA_INFLATE_MAX_DCODES ) )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+        else
+        {
+            memset( pxContext->ucLengths, 0, OTA_INFLATE_CODE_LENGTH_CODES );
+            pxContext->ulCount = 0U;
+            pxContext->eState = eInflateState_CodeLengthLengths;
+        }
+    }
+
+    return pxContext->eState != eInflateState_TableSizes;
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDecodeCodeLengthLengths( OTA_InflateContext_t * pxContext )
+{
+    while( ( pxContext->ulCount < pxContext->ulCodeLengthCodes ) && ( pxContext->ulBitCount >= 3U ) )
+    {
+        pxContext->ucLengths[ ucCodeLengthOrder[ pxContext->ulCount ] ] = ( uint8_t ) ( pxContext->ulBitBuffer & 7U );
+        prvConsumeBits( pxContext, 3U );
+        pxContext->ulCount++;
+    }
+
+    if( pxContext->ulCount == pxContext->ulCodeLengthCodes )
+    {
+        /* The code length code is built in place of the literal/length code, which comes next. */
+        if( prvBuildCode( &pxContext->xLengthCode, pxContext->ucLengths, OTA_INFLATE_CODE_LENGTH_CODES ) != 0 )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+        else
+        {
+            pxContext->ulCount = 0U;
+            pxContext->eState = eInflateState_CodeLengths;
+        }
+    }
+
+    return pxContext->eState != eInflateState_CodeLengthLengths;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Decode the literal/length and distance code lengths of a dynamic block, then build its codes. */
+
+static BaseType_t prvDecodeCodeLengths( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulTotal = pxContext->ulLengthCodes + pxContext->ulDistanceCodes;
+    uint32_t ulCodeLength = 0U;
+    uint32_t ulExtra;
+    uint32_t ulRepeat;
+    uint8_t ucValue;
+    int32_t lSymbol;
+    int32_t lLeft;
+
+    while( ( pxContext->ulCount < ulTotal ) && ( pxContext->eState == eInflateState_CodeLengths ) )
+    {
+        lSymbol = prvPeekSymbol( &pxContext->xLengthCode, pxContext->ulBitBuffer, pxContext->ulBitCount, &ulCodeLength );
+
+        if( lSymbol == OTA_INFLATE_NEED_BITS )
+        {
+            break;
+        }
+        else if( lSymbol < 0 )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+        else if( lSymbol < 16 )
+        {
+            prvConsumeBits( pxContext, ulCodeLength );
+            pxContext->ucLengths[ pxContext->ulCount++ ] = ( uint8_t ) lSymbol;
+        }
+        else
+        {
+            /* Repeat the last length, or zero, a number of times given by the extra bits. */
+            ulExtra = ( lSymbol == 16 ) ? 2U : ( ( lSymbol == 17 ) ? 3U : 7U );
+
+            if( ( ulCodeLength + ulExtra ) > pxContext->ulBitCount )
+            {
+                break;
+            }
+
+            prvConsumeBits( pxContext, ulCodeLength );
+            ulRepeat = ( pxContext->ulBitBuffer & ( ( 1UL << ulExtra ) - 1U ) ) + ( ( lSymbol == 18 ) ? 11U : 3U );
+            prvConsumeBits( pxContext, ulExtra );
+            ucValue = 0U;
+
+            if( lSymbol == 16 )
+            {
+                if( pxContext->ulCount == 0U )
+                {
+                    prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+                }
+                else
+                {
+                    ucValue = pxContext->ucLengths[ pxContext->ulCount - 1U ];
+                }
+            }
+
+            if( ( pxContext->ulCount + ulRepeat ) > ulTotal )
+            {
+                prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+            }
+            else if( pxContext->eState == eInflateState_CodeLengths )
+            {
+                memset( &pxContext->ucLengths[ pxContext->ulCount ], ucValue, ulRepeat );
+                pxContext->ulCount += ulRepeat;
+            }
+            else
+            {
+                /* The error was set above. */
+            }
+        }
+    }
+
+    if( ( pxContext->ulCount == ulTotal ) && ( pxContext->eState == eInflateState_CodeLengths ) )
+    {
+        /* The block must have an end of block code and valid codes. */
+        if( pxContext->ucLengths[ OTA_INFLATE_END_OF_BLOCK ] == 0U )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+        else
+        {
+            lLeft = prvBuildCode( &pxContext->xLengthCode, pxContext->ucLengths, pxContext->ulLengthCodes );
+
+            if( pdFALSE == prvIsValidCode( &pxContext->xLengthCode, lLeft, pxContext->ulLengthCodes ) )
+            {
+                prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+            }
+            else
+            {
+                lLeft = prvBuildCode( &pxContext->xDistanceCode, &pxContext->ucLengths[ pxContext->ulLengthCodes ], pxContext->ulDistanceCodes );
+
+                if( pdFALSE == prvIsValidCode( &pxContext->xDistanceCode, lLeft, pxContext->ulDistanceCodes ) )
+                {
+                    prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+                }
+                else
+                {
+                    pxContext->eState = eInflateState_Length;
+                }
+            }
+        }
+    }
+
+    return pxContext->eState != eInflateState_CodeLengths;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Decode a literal, the end of the block, or a match length and its extra bits. */
+
+static BaseType_t prvDecodeLength( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulCodeLength = 0U;
+    uint32_t ulExtra;
+    uint8_t ucLiteral;
+    int32_t lSymbol;
+    BaseType_t xProgress = pdFALSE;
+
+    lSymbol = prvPeekSymbol( &pxContext->xLengthCode, pxContext->ulBitBuffer, pxContext->ulBitCount, &ulCodeLength );
+
+    if( lSymbol == OTA_INFLATE_NEED_BITS )
+    {
+        /* Wait for more input. */
+    }
+    else if( lSymbol < 0 )
+    {
+        prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+    }
+    else if( lSymbol < ( int32_t ) OTA_INFLATE_END_OF_BLOCK )
+    {
+        prvConsumeBits( pxContext, ulCodeLength );
+        ucLiteral = ( uint8_t ) lSymbol;
+        prvOutputBytes( pxContext, &ucLiteral, 1U );
+        xProgress = pdTRUE;
+    }
+    else if( lSymbol == ( int32_t ) OTA_INFLATE_END_OF_BLOCK )
+    {
+        prvConsumeBits( pxContext, ulCodeLength );
+        prvEndBlock( pxContext );
+    }
+    else if( lSymbol >= ( int32_t ) ( OTA_INFLATE_END_OF_BLOCK + 1U + sizeof( usLengthBase ) / sizeof( usLengthBase[ 0 ] ) ) )
+    {
+        prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+    }
+    else
+    {
+        lSymbol -= ( int32_t ) OTA_INFLATE_END_OF_BLOCK + 1;
+        ulExtra = ucLengthExtra[ lSymbol ];
+
+        if( ( ulCodeLength + ulExtra ) <= pxContext->ulBitCount )
+        {
+            prvConsumeBits( pxContext, ulCodeLength );
+            pxContext->ulMatchLength = usLengthBase[ lSymbol ] + ( pxContext->ulBitBuffer & ( ( 1UL << ulExtra ) - 1U ) );
+            prvConsumeBits( pxContext, ulExtra );
+            pxContext->eState = eInflateState_Distance;
+        }
+    }
+
+    return ( xProgress == pdTRUE ) || ( pxContext->eState != eInflateState_Length );
+}
+
+/*-----------------------------------------------------------*/
+
+/* Decode the distance code of a match. Its extra bits are decoded separately since both may not fit
+ * in the bit buffer at once. */
+
+static BaseType_t prvDecodeDistance( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulCodeLength = 0U;
+    int32_t lSymbol;
+
+    lSymbol = prvPeekSymbol( &pxContext->xDistanceCode, pxContext->ulBitBuffer, pxContext->ulBitCount, &ulCodeLength );
+
+    if( lSymbol == OTA_INFLATE_NEED_BITS )
+    {
+        /* Wait for more input. */
+    }
+    else if( ( lSymbol < 0 ) || ( lSymbol >= ( int32_t ) OTA_INFLATE_MAX_DCODES ) )
+    {
+        prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+    }
+    else
+    {
+        prvConsumeBits( pxContext, ulCodeLength );
+        pxContext->ulDistanceSymbol = ( uint32_t ) lSymbol;
+        pxContext->eState = eInflateState_DistanceExtra;
+    }
+
+    return pxContext->eState != eInflateState_Distance;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Decode the extra bits of the distance of a match, then copy the match. */
+
+static BaseType_t prvDecodeDistanceExtra( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulExtra = ucDistanceExtra[ pxContext->ulDistanceSymbol ];
+    uint32_t ulDistance;
+
+    if( ulExtra <= pxContext->ulBitCount )
+    {
+        ulDistance = usDistanceBase[ pxContext->ulDistanceSymbol ] + ( pxContext->ulBitBuffer & ( ( 1UL << ulExtra ) - 1U ) );
+        prvConsumeBits( pxContext, ulExtra );
+
+        /* The match must be within the data output so far and the stream's window. */
+        if( ( ulDistance > pxContext->ulTotalOut ) || ( ulDistance > pxContext->ulStreamWindow ) )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+        else
+        {
+            prvCopyMatch( pxContext, ulDistance, pxContext->ulMatchLength );
+
+            if( pxContext->eState != eInflateState_Error )
+            {
+                pxContext->eState = eInflateState_Length;
+            }
+        }
+    }
+
+    return pxContext->eState != eInflateState_DistanceExtra;
+}
+
+/*-----------------------------------------------------------*/
+
+/* The stream ends at a byte boundary with the big endian Adler-32 of the data. */
+
+static BaseType_t prvDecodeTrailer( OTA_InflateContext_t * pxContext )
+{
+    uint32_t ulAdler;
+
+    prvConsumeBits( pxContext, pxContext->ulBitCount & 7U );
+
+    if( pxContext->ulBitCount >= 32U )
+    {
+        ulAdler = ( ( pxContext->ulBitBuffer & 0xffUL ) << 24 ) | ( ( pxContext->ulBitBuffer & 0xff00UL ) << 8 ) |
+                  ( ( pxContext->ulBitBuffer >> 8 ) & 0xff00UL ) | ( pxContext->ulBitBuffer >> 24 );
+        prvConsumeBits( pxContext, 16U );
+        prvConsumeBits( pxContext, 16U );
+
+        if( ulAdler != pxContext->ulAdler )
+        {
+            prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+        }
+        else
+        {
+            pxContext->eState = eInflateState_Done;
+        }
+    }
+
+    return pxContext->eState != eInflateState_Trailer;
+}
+
+/*-----------------------------------------------------------*/
+
+OTA_InflateContext_t * OTA_Inflate_Create( uint32_t ulLog2WindowSize,
+                                           OTA_InflateOutput_t xOutput,
+                                           void * pvOutputContext )
+{
+    OTA_InflateContext_t * pxContext = NULL;
+
+    if( ( ulLog2WindowSize >= OTA_INFLATE_MIN_LOG2_WINDOW ) && ( ulLog2WindowSize <= OTA_INFLATE_MAX_LOG2_WINDOW ) && ( xOutput != NULL ) )
+    {
+        /* The window is allocated along with the context. */
+        pxContext = ( OTA_InflateContext_t * ) pvPortMalloc( sizeof( OTA_InflateContext_t ) + ( 1UL << ulLog2WindowSize ) ); /*lint !e9079 FreeRTOS malloc port returns void*. */
+
+        if( pxContext != NULL )
+        {
+            memset( pxContext, 0, sizeof( OTA_InflateContext_t ) );
+            pxContext->eState = eInflateState_Header;
+            pxContext->xOutput = xOutput;
+            pxContext->pvOutputContext = pvOutputContext;
+            pxContext->ulAdler = 1U;
+            pxContext->ulWindowSize = 1UL << ulLog2WindowSize;
+            pxContext->pucWindow = ( uint8_t * ) &pxContext[ 1 ];
+        }
+    }
+
+    return pxContext;
+}
+
+/*-----------------------------------------------------------*/
+
+OTA_InflateStatus_t OTA_Inflate_Decompress( OTA_InflateContext_t * pxContext,
+                                            const uint8_t * pucData,
+                                            uint32_t ulSize )
+{
+    const uint8_t * pucNext = pucData;
+    const uint8_t * pucEnd = ( ulSize > 0U ) ? &pucData[ ulSize ] : pucData;
+    OTA_InflateStatus_t eStatus = eOTA_Inflate_NeedInput;
+    BaseType_t xProgress = pdTRUE;
+
+    while( xProgress == pdTRUE )
+    {
+        /* Keep the bit buffer topped up. No step needs more than 20 bits at once, or 32 from a byte
+         * boundary. */
+        while( ( pxContext->ulBitCount <= 24U ) && ( pucNext < pucEnd ) )
+        {
+            pxContext->ulBitBuffer |= ( uint32_t ) *pucNext << pxContext->ulBitCount;
+            pxContext->ulBitCount += 8U;
+            pucNext++;
+        }
+
+        switch( pxContext->eState )
+        {
+            case eInflateState_Header:
+                xProgress = prvDecodeHeader( pxContext );
+                break;
+
+            case eInflateState_Block:
+                xProgress = prvDecodeBlockHeader( pxContext );
+                break;
+
+            case eInflateState_StoredLength:
+                xProgress = prvDecodeStoredLength( pxContext );
+                break;
+
+            case eInflateState_Stored:
+                xProgress = prvCopyStored( pxContext, &pucNext, pucEnd );
+                break;
+
+            case eInflateState_TableSizes:
+                xProgress = prvDecodeTableSizes( pxContext );
+                break;
+
+            case eInflateState_CodeLengthLengths:
+                xProgress = prvDecodeCodeLengthLengths( pxContext );
+                break;
+
+            case eInflateState_CodeLengths:
+                xProgress = prvDecodeCodeLengths( pxContext );
+                break;
+
+            case eInflateState_Length:
+                xProgress = prvDecodeLength( pxContext );
+                break;
+
+            case eInflateState_Distance:
+                xProgress = prvDecodeDistance( pxContext );
+                break;
+
+            case eInflateState_DistanceExtra:
+                xProgress = prvDecodeDistanceExtra( pxContext );
+                break;
+
+            case eInflateState_Trailer:
+                xProgress = prvDecodeTrailer( pxContext );
+                break;
+
+            case eInflateState_Done:
+
+                /* Nothing may follow the end of the stream. */
+                if( ( pxContext->ulBitCount > 0U ) || ( pucNext < pucEnd ) )
+                {
+                    prvSetError( pxContext, eOTA_Inflate_ErrBadData );
+                }
+
+                xProgress = pdFALSE;
+                break;
+
+            default:
+                xProgress = pdFALSE;
+                break;
+        }
+
+        /* Skipping to a byte boundary can leave a step short of bits that are still in the input. */
+        if( ( xProgress == pdFALSE ) && ( pucNext < pucEnd ) && ( pxContext->ulBitCount <= 24U ) &&
+            ( pxContext->eState != eInflateState_Error ) )
+        {
+            xProgress = pdTRUE;
+        }
+    }
+
+    if( pxContext->eState == eInflateState_Error )
+    {
+        eStatus = pxContext->eError;
+    }
+    else if( pxContext->eState == eInflateState_Done )
+    {
+        eStatus = eOTA_Inflate_Done;
+    }
+    else
+    {
+        /* Any input left is in the bit buffer, waiting for the rest of the code it starts. */
+    }
+
+    return eStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+uint32_t OTA_Inflate_GetTotalOut( const OTA_InflateContext_t * pxContext )
+{
+    return pxContext->ulTotalOut;
+}
+
+/*-----------------------------------------------------------*/
+
+void OTA_Inflate_Delete( OTA_InflateContext_t * pxContext )
+{
+    vPortFree( pxContext );
+}
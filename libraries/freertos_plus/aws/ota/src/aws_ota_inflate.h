@@ -0,0 +1,88 @@
+/*
+ * Amazon FreeRTOS OTA V1.0.4
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef __AWS_OTAINFLATE__H__
+#define __AWS_OTAINFLATE__H__
+
+/**
+ * @brief Status of a streaming decompression.
+ *
+ * Negative values are errors. The stream can't be continued after an error.
+ */
+typedef enum
+{
+    eOTA_Inflate_NeedInput = 0,       /* All of the input was consumed and the stream continues in the next block. */
+    eOTA_Inflate_Done = 1,            /* The end of the stream was reached and its checksum is valid. */
+    eOTA_Inflate_ErrBadData = -1,     /* The input is not a valid zlib stream. */
+    eOTA_Inflate_ErrWindowSize = -2,  /* The stream was compressed with a larger window than the decompressor has. */
+    eOTA_Inflate_ErrOutput = -3       /* The output function failed. */
+} OTA_InflateStatus_t;
+
+/**
+ * @brief Output function of a streaming decompression.
+ *
+ * Called with the decompressed data in order, in chunks of at most the window size. ulOffset is the
+ * offset of the chunk in the decompressed stream. Return pdFALSE to stop the decompression.
+ */
+typedef BaseType_t ( * OTA_InflateOutput_t )( void * pvOutputContext,
+                                              uint32_t ulOffset,
+                                              const uint8_t * pucData,
+                                              uint32_t ulSize );
+
+typedef struct OTA_InflateContext OTA_InflateContext_t;
+
+/**
+ * @brief Create a decompressor for a zlib (RFC 1950) stream of deflate (RFC 1951) data.
+ *
+ * The decompressor allocates a window of 1 << ulLog2WindowSize bytes, which also buffers its output,
+ * and rejects streams compressed with a larger window. ulLog2WindowSize must be from 8 to 15.
+ * Returns NULL if it is out of range or there isn't enough memory.
+ */
+OTA_InflateContext_t * OTA_Inflate_Create( uint32_t ulLog2WindowSize,
+                                           OTA_InflateOutput_t xOutput,
+                                           void * pvOutputContext );
+
+/**
+ * @brief Decompress the next part of the stream.
+ *
+ * The stream may be split anywhere. All of the input is consumed, and the decompressed data is passed
+ * to the output function as the window fills and when the end of the stream is reached. Passing no
+ * input returns the current status of the stream.
+ */
+OTA_InflateStatus_t OTA_Inflate_Decompress( OTA_InflateContext_t * pxContext,
+                                            const uint8_t * pucData,
+                                            uint32_t ulSize );
+
+/**
+ * @brief Get the number of bytes decompressed so far.
+ */
+uint32_t OTA_Inflate_GetTotalOut( const OTA_InflateContext_t * pxContext );
+
+/**
+ * @brief Free a decompressor.
+ */
+void OTA_Inflate_Delete( OTA_InflateContext_t * pxContext );
+
+#endif /* ifndef __AWS_OTAINFLATE__H__ */
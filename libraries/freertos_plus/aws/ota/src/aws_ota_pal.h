@@ -57,7 +57,8 @@ OTA_Err_t prvPAL_Abort( OTA_FileContext_t * const C );
  * @note Opens the file indicated in the OTA file context in the MCU file system.
  *
  * @note The previous image may be present in the designated image download partition or file, so the partition or file
- * must be completely erased or overwritten in this routine.
+ * must be completely erased or overwritten in this routine, unless C->xResume is set. In that case the transfer
+ * is being resumed from a checkpoint and the partially received file must be reopened as is.
  *
  * @note The input OTA_FileContext_t C is checked for NULL by the OTA agent before this
  * function is called.
@@ -196,4 +197,38 @@ OTA_Err_t prvPAL_SetPlatformImageState( OTA_ImageState_t eState );
  */
 OTA_PAL_ImageState_t prvPAL_GetPlatformImageState( void );
 
+/**
+ * @brief Persist the progress of a file transfer.
+ * This function is only required if otaconfigRESUME_TRANSFERS is set to 1.
+ * All blocks written to the receive file so far must be made durable before the checkpoint is
+ * saved, so that a reset can never leave a checkpoint claiming blocks that were lost. Saving a
+ * checkpoint replaces the previous one.
+ * @param[in] C OTA file context information.
+ * @param[in] pucData The checkpoint data to persist. Its format is private to the OTA agent.
+ * If NULL (and ulSize is zero), any saved checkpoint shall be erased.
+ * @param[in] ulSize The size of the checkpoint data in bytes.
+ * @return The OTA PAL layer error code combined with the MCU specific error code. See OTA Agent
+ * error codes information in aws_iot_ota_agent.h.
+ * kOTA_Err_None is returned when the checkpoint was saved or erased.
+ */
+OTA_Err_t prvPAL_SaveCheckpoint( OTA_FileContext_t * const C,
+                                 const uint8_t * pucData,
+                                 uint32_t ulSize );
+
+/**
+ * @brief Read back the last checkpoint saved with prvPAL_SaveCheckpoint().
+ * This function is only required if otaconfigRESUME_TRANSFERS is set to 1.
+ * If the OTA agent resumes the transfer, it sets C->xResume before calling
+ * prvPAL_CreateFileForRx(), which must then reopen the partially received file without
+ * erasing it.
+ * @param[in] C OTA file context information.
+ * @param[out] pucData Buffer to receive the checkpoint data.
+ * @param[in] ulMaxSize The size of the buffer in bytes.
+ * @return The size of the checkpoint in bytes, or 0 if no checkpoint is saved or it is larger
+ * than ulMaxSize.
+ */
+uint32_t prvPAL_LoadCheckpoint( OTA_FileContext_t * const C,
+                                uint8_t * pucData,
+                                uint32_t ulMaxSize );
+
 #endif /* ifndef _AWS_OTA_PAL_H_ */
@@ -51,4 +51,43 @@ DocParseErr_t TEST_OTA_prvParseJSONbyModel( const char * pcJSON,
                                             uint32_t ulMsgLen,
                                             JSON_DocModel_t * pxDocModel );
 
+#if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+    bool_t TEST_OTA_prvWindowStart( OTA_FileContext_t * C,
+                                    uint32_t ulBitmapLen );
+
+    void TEST_OTA_prvWindowStop( OTA_FileContext_t * C );
+
+    uint32_t TEST_OTA_prvWindowSelectBlocks( OTA_FileContext_t * C,
+                                             uint8_t * pucBitmap,
+                                             uint32_t ulMaxBitmapLen,
+                                             uint32_t * pulBitmapLen );
+
+    void TEST_OTA_prvWindowBlockReceived( OTA_FileContext_t * C,
+                                          uint32_t ulFirstBlock,
+                                          uint32_t ulNumBlocks );
+
+    void TEST_OTA_prvWindowTimeout( OTA_FileContext_t * C );
+#endif /* otaconfigPIPELINE_BLOCK_REQUESTS */
+
+void TEST_OTA_prvMarkBlocksReceived( OTA_FileContext_t * C,
+                                     uint32_t ulFirstBlock,
+                                     uint32_t ulNumBlocks );
+
+void TEST_OTA_prvSetWriteBlockCallback( pxOTAPALWriteBlockCallback_t xWriteBlock );
+
+void TEST_OTA_prvSetCheckpointCallbacks( pxOTAPALSaveCheckpointCallback_t xSaveCheckpoint,
+                                         pxOTAPALLoadCheckpointCallback_t xLoadCheckpoint );
+
+void TEST_OTA_prvSetActiveJobName( uint8_t * pucJobName );
+
+void TEST_OTA_prvSaveCheckpoint( OTA_FileContext_t * C );
+
+bool_t TEST_OTA_prvRestoreCheckpoint( OTA_FileContext_t * C );
+
+#if ( otaconfigDECOMPRESS_IMAGES == 1 )
+    bool_t TEST_OTA_prvStartInflate( OTA_FileContext_t * C );
+
+    void TEST_OTA_prvStopInflate( OTA_FileContext_t * C );
+#endif /* otaconfigDECOMPRESS_IMAGES */
+
 #endif /* ifndef _AWS_OTA_AGENT_TEST_ACCESS_DECLARE_H_ */
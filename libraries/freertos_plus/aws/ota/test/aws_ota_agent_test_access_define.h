@@ -68,4 +68,115 @@ DocParseErr_t TEST_OTA_prvParseJSONbyModel( const char * pcJSON,
     return prvParseJSONbyModel( pcJSON, ulMsgLen, pxDocModel );
 }
 
+/*-----------------------------------------------------------*/
+
+void TEST_OTA_prvMarkBlocksReceived( OTA_FileContext_t * C,
+                                     uint32_t ulFirstBlock,
+                                     uint32_t ulNumBlocks )
+{
+    prvMarkBlocksReceived( C, ulFirstBlock, ulNumBlocks );
+}
+
+/*-----------------------------------------------------------*/
+
+void TEST_OTA_prvSetWriteBlockCallback( pxOTAPALWriteBlockCallback_t xWriteBlock )
+{
+    /* NULL restores the PAL's write function, as in OTA_AgentInit_internal(). */
+    xOTA_Agent.xPALCallbacks.xWriteBlock = ( xWriteBlock != NULL ) ? xWriteBlock : prvPAL_WriteBlock;
+}
+
+/*-----------------------------------------------------------*/
+
+void TEST_OTA_prvSetCheckpointCallbacks( pxOTAPALSaveCheckpointCallback_t xSaveCheckpoint,
+                                         pxOTAPALLoadCheckpointCallback_t xLoadCheckpoint )
+{
+    /* NULL restores the PAL's checkpoint functions, as in OTA_AgentInit_internal(). */
+    xOTA_Agent.xPALCallbacks.xSaveCheckpoint = ( xSaveCheckpoint != NULL ) ? xSaveCheckpoint : OTA_PAL_DEFAULT_SAVE_CHECKPOINT;
+    xOTA_Agent.xPALCallbacks.xLoadCheckpoint = ( xLoadCheckpoint != NULL ) ? xLoadCheckpoint : OTA_PAL_DEFAULT_LOAD_CHECKPOINT;
+}
+
+/*-----------------------------------------------------------*/
+
+void TEST_OTA_prvSetActiveJobName( uint8_t * pucJobName )
+{
+    xOTA_Agent.pcOTA_Singleton_ActiveJobName = pucJobName;
+}
+
+/*-----------------------------------------------------------*/
+
+void TEST_OTA_prvSaveCheckpoint( OTA_FileContext_t * C )
+{
+    prvSaveCheckpoint( C );
+}
+
+/*-----------------------------------------------------------*/
+
+bool_t TEST_OTA_prvRestoreCheckpoint( OTA_FileContext_t * C )
+{
+    return prvRestoreCheckpoint( C );
+}
+
+#if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+
+/*-----------------------------------------------------------*/
+
+    bool_t TEST_OTA_prvWindowStart( OTA_FileContext_t * C,
+                                    uint32_t ulBitmapLen )
+    {
+        return prvWindowStart( C, ulBitmapLen );
+    }
+
+/*-----------------------------------------------------------*/
+
+    void TEST_OTA_prvWindowStop( OTA_FileContext_t * C )
+    {
+        prvWindowStop( C );
+    }
+
+/*-----------------------------------------------------------*/
+
+    uint32_t TEST_OTA_prvWindowSelectBlocks( OTA_FileContext_t * C,
+                                             uint8_t * pucBitmap,
+                                             uint32_t ulMaxBitmapLen,
+                                             uint32_t * pulBitmapLen )
+    {
+        return prvWindowSelectBlocks( C, pucBitmap, ulMaxBitmapLen, pulBitmapLen );
+    }
+
+/*-----------------------------------------------------------*/
+
+    void TEST_OTA_prvWindowBlockReceived( OTA_FileContext_t * C,
+                                          uint32_t ulFirstBlock,
+                                          uint32_t ulNumBlocks )
+    {
+        prvWindowBlockReceived( C, ulFirstBlock, ulNumBlocks );
+    }
+
+/*-----------------------------------------------------------*/
+
+    void TEST_OTA_prvWindowTimeout( OTA_FileContext_t * C )
+    {
+        prvWindowTimeout( C );
+    }
+
+#endif /* otaconfigPIPELINE_BLOCK_REQUESTS */
+
+#if ( otaconfigDECOMPRESS_IMAGES == 1 )
+
+/*-----------------------------------------------------------*/
+
+    bool_t TEST_OTA_prvStartInflate( OTA_FileContext_t * C )
+    {
+        return prvStartInflate( C );
+    }
+
+/*-----------------------------------------------------------*/
+
+    void TEST_OTA_prvStopInflate( OTA_FileContext_t * C )
+    {
+        prvStopInflate( C );
+    }
+
+#endif /* otaconfigDECOMPRESS_IMAGES */
+
 #endif /* _AWS_OTA_AGENT_TEST_ACCESS_DEFINE_H_ */
@@ -188,6 +188,11 @@ TEST_GROUP_RUNNER( Full_OTA_AGENT )
     RUN_TEST_CASE( Full_OTA_AGENT, OTA_SetImageState_InvalidParams );
     RUN_TEST_CASE( Full_OTA_AGENT, prvParseJobDocFromJSONandPrvOTA_Close );
     RUN_TEST_CASE( Full_OTA_AGENT, prvParseJSONbyModel_Errors );
+    RUN_TEST_CASE( Full_OTA_AGENT, prvRestoreCheckpoint_ResumeAfterReset );
+
+    #if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+        RUN_TEST_CASE( Full_OTA_AGENT, prvWindowSelectBlocks_SimulatedStream );
+    #endif
 }
 
 TEST( Full_OTA_AGENT, OTA_SetImageState_InvalidParams )
@@ -383,3 +388,370 @@ TEST( Full_OTA_AGENT, prvParseJSONbyModel_Errors )
     /* Shut down the OTA Agent. */
     ( void ) OTA_AgentShutdown( pdMS_TO_TICKS( otatestSHUTDOWN_WAIT ) );
 }
+
+/**
+ * @brief Checkpoint storage standing in for the PAL, so that the agent side of a resumed
+ * transfer can be tested on any port.
+ */
+#define otatestCHECKPOINT_NUM_BLOCKS     21U
+#define otatestCHECKPOINT_MAX_SIZE       128U
+
+static uint8_t ucOtatestCheckpoint[ otatestCHECKPOINT_MAX_SIZE ];
+static uint32_t ulOtatestCheckpointSize = 0U;
+
+static OTA_Err_t prvTestSaveCheckpoint( OTA_FileContext_t * const C,
+                                        const uint8_t * pucData,
+                                        uint32_t ulSize )
+{
+    OTA_Err_t xErr = kOTA_Err_None;
+
+    ( void ) C;
+
+    if( pucData == NULL )
+    {
+        ulOtatestCheckpointSize = 0U;
+    }
+    else if( ulSize > sizeof( ucOtatestCheckpoint ) )
+    {
+        xErr = kOTA_Err_CheckpointFailed;
+    }
+    else
+    {
+        memcpy( ucOtatestCheckpoint, pucData, ulSize );
+        ulOtatestCheckpointSize = ulSize;
+    }
+
+    return xErr;
+}
+
+static uint32_t prvTestLoadCheckpoint( OTA_FileContext_t * const C,
+                                       uint8_t * pucData,
+                                       uint32_t ulMaxSize )
+{
+    uint32_t ulSize = 0U;
+
+    ( void ) C;
+
+    if( ( ulOtatestCheckpointSize > 0U ) && ( ulOtatestCheckpointSize <= ulMaxSize ) )
+    {
+        memcpy( pucData, ucOtatestCheckpoint, ulOtatestCheckpointSize );
+        ulSize = ulOtatestCheckpointSize;
+    }
+
+    return ulSize;
+}
+
+/**
+ * @brief Set up a file context the way the agent does for a new transfer, with every block needed.
+ */
+static void prvStartCheckpointTransfer( OTA_FileContext_t * C,
+                                        uint8_t * pucBitmap )
+{
+    uint32_t ulBlock;
+
+    memset( C, 0, sizeof( OTA_FileContext_t ) );
+    memset( pucBitmap, 0, ( otatestCHECKPOINT_NUM_BLOCKS + 7U ) >> 3 );
+    C->pucStreamName = ( uint8_t * ) otatestSTREAM_NAME;
+    C->ulServerFileID = otatestFILE_ID;
+    C->ulFileSize = ( ( otatestCHECKPOINT_NUM_BLOCKS - 1U ) * OTA_FILE_BLOCK_SIZE ) + 1U;
+    C->ulBlocksRemaining = otatestCHECKPOINT_NUM_BLOCKS;
+    C->pucRxBlockBitmap = pucBitmap;
+
+    for( ulBlock = 0U; ulBlock < otatestCHECKPOINT_NUM_BLOCKS; ulBlock++ )
+    {
+        pucBitmap[ ulBlock >> 3 ] |= ( uint8_t ) ( 1U << ( ulBlock & 7U ) );
+    }
+}
+
+/**
+ * @brief Checkpoint a partly received transfer, start it over the way the agent does after a reset
+ * and verify only the missing blocks are needed. A checkpoint for another transfer, or one with no
+ * blocks missing, must not be resumed and must be erased.
+ */
+TEST( Full_OTA_AGENT, prvRestoreCheckpoint_ResumeAfterReset )
+{
+    OTA_FileContext_t xFile;
+    uint8_t ucBitmap[ ( otatestCHECKPOINT_NUM_BLOCKS + 7U ) >> 3 ];
+    uint8_t ucSavedBitmap[ sizeof( ucBitmap ) ];
+    uint32_t ulSavedRemaining;
+
+    TEST_OTA_prvSetCheckpointCallbacks( prvTestSaveCheckpoint, prvTestLoadCheckpoint );
+    TEST_OTA_prvSetActiveJobName( ( uint8_t * ) "15" );
+    ulOtatestCheckpointSize = 0U;
+
+    if( TEST_PROTECT() )
+    {
+        /* Nothing was checkpointed, so the transfer starts from the beginning. */
+        prvStartCheckpointTransfer( &xFile, ucBitmap );
+        TEST_ASSERT_FALSE( TEST_OTA_prvRestoreCheckpoint( &xFile ) );
+        TEST_ASSERT_EQUAL_UINT32( otatestCHECKPOINT_NUM_BLOCKS, xFile.ulBlocksRemaining );
+
+        /* Receive blocks out of order, including the short last block, and checkpoint them. */
+        TEST_OTA_prvMarkBlocksReceived( &xFile, 3U, 5U );
+        TEST_OTA_prvMarkBlocksReceived( &xFile, 0U, 1U );
+        TEST_OTA_prvMarkBlocksReceived( &xFile, otatestCHECKPOINT_NUM_BLOCKS - 1U, 1U );
+        TEST_OTA_prvSaveCheckpoint( &xFile );
+        TEST_ASSERT_NOT_EQUAL( 0U, ulOtatestCheckpointSize );
+        memcpy( ucSavedBitmap, ucBitmap, sizeof( ucBitmap ) );
+        ulSavedRemaining = xFile.ulBlocksRemaining;
+
+        /* Blocks received after the checkpoint are lost by the reset. */
+        TEST_OTA_prvMarkBlocksReceived( &xFile, 10U, 2U );
+
+        prvStartCheckpointTransfer( &xFile, ucBitmap );
+        TEST_ASSERT_TRUE( TEST_OTA_prvRestoreCheckpoint( &xFile ) );
+        TEST_ASSERT_EQUAL_UINT32( ulSavedRemaining, xFile.ulBlocksRemaining );
+        TEST_ASSERT_EQUAL_MEMORY( ucSavedBitmap, ucBitmap, sizeof( ucBitmap ) );
+
+        /* The checkpoint is kept until the transfer ends, so it can be resumed again. */
+        prvStartCheckpointTransfer( &xFile, ucBitmap );
+        TEST_ASSERT_TRUE( TEST_OTA_prvRestoreCheckpoint( &xFile ) );
+
+        /* A different file of the same job can't resume from it, and it is erased. */
+        prvStartCheckpointTransfer( &xFile, ucBitmap );
+        xFile.ulServerFileID = otatestFILE_ID + 1U;
+        TEST_ASSERT_FALSE( TEST_OTA_prvRestoreCheckpoint( &xFile ) );
+        TEST_ASSERT_EQUAL_UINT32( otatestCHECKPOINT_NUM_BLOCKS, xFile.ulBlocksRemaining );
+        TEST_ASSERT_EQUAL_UINT32( 0U, ulOtatestCheckpointSize );
+
+        /* Neither can the same file of another job. */
+        prvStartCheckpointTransfer( &xFile, ucBitmap );
+        TEST_OTA_prvMarkBlocksReceived( &xFile, 0U, 1U );
+        TEST_OTA_prvSaveCheckpoint( &xFile );
+        TEST_OTA_prvSetActiveJobName( ( uint8_t * ) "16" );
+        prvStartCheckpointTransfer( &xFile, ucBitmap );
+        TEST_ASSERT_FALSE( TEST_OTA_prvRestoreCheckpoint( &xFile ) );
+        TEST_ASSERT_EQUAL_UINT32( 0U, ulOtatestCheckpointSize );
+
+        /* A checkpoint with no blocks missing can't be trusted. */
+        TEST_OTA_prvMarkBlocksReceived( &xFile, 0U, otatestCHECKPOINT_NUM_BLOCKS );
+        TEST_ASSERT_EQUAL_UINT32( 0U, xFile.ulBlocksRemaining );
+        TEST_OTA_prvSaveCheckpoint( &xFile );
+        prvStartCheckpointTransfer( &xFile, ucBitmap );
+        TEST_ASSERT_FALSE( TEST_OTA_prvRestoreCheckpoint( &xFile ) );
+        TEST_ASSERT_EQUAL_UINT32( otatestCHECKPOINT_NUM_BLOCKS, xFile.ulBlocksRemaining );
+        TEST_ASSERT_EQUAL_UINT32( 0U, ulOtatestCheckpointSize );
+    }
+
+    TEST_OTA_prvSetActiveJobName( NULL );
+    TEST_OTA_prvSetCheckpointCallbacks( NULL, NULL );
+}
+
+#if ( otaconfigPIPELINE_BLOCK_REQUESTS == 1 )
+
+/**
+ * @brief Simulated stream used to measure how long a file takes to download.
+ *
+ * Requests reach the stream service after otatestSIM_LATENCY_MS. The service sends the requested
+ * blocks back to back over a link carrying otatestSIM_BYTES_PER_MS, each with otatestSIM_MSG_OVERHEAD
+ * bytes of protocol overhead, and each block takes another otatestSIM_LATENCY_MS to arrive. One in
+ * every otatestSIM_LOSS_RATE blocks is lost on the way. Time is simulated, so the test runs quickly
+ * and always gives the same result.
+ */
+    #define otatestSIM_FILE_SIZE           ( ( 200U * 1024U ) + 123U )
+    #define otatestSIM_LATENCY_MS          50U
+    #define otatestSIM_BYTES_PER_MS        32U
+    #define otatestSIM_MSG_OVERHEAD        40U
+    #define otatestSIM_LOSS_RATE           50U
+    #define otatestSIM_MAX_BITMAP_SIZE     128U
+    #define otatestSIM_MAX_QUEUED_BLOCKS   512U
+    #define otatestSIM_MAX_EVENTS          100000U
+
+/**
+ * @brief A block sent by the simulated stream service.
+ */
+    typedef struct
+    {
+        uint32_t ulArrivalTime;   /* Simulated time the block arrives at the device. */
+        uint32_t ulBlockIndex;    /* Index of the block at the size it was requested with. */
+        uint32_t ulLog2BlockSize; /* Log base 2 of the size the block was requested with. */
+        bool_t xLost;             /* True if the block never arrives. */
+    } SimBlock_t;
+
+    static SimBlock_t xSimBlocks[ otatestSIM_MAX_QUEUED_BLOCKS ];
+    static uint32_t ulSimHead;
+    static uint32_t ulSimCount;
+    static uint32_t ulSimLinkFree;
+    static uint32_t ulSimRandom;
+
+/**
+ * @brief Have the simulated stream service answer a request made at ulTime. Like the real service,
+ * it sends the first ulNumBlocks blocks marked in the bitmap, in order.
+ */
+    static void prvSimServeRequest( uint32_t ulTime,
+                                    const uint8_t * pucBitmap,
+                                    uint32_t ulBitmapLen,
+                                    uint32_t ulNumBlocks,
+                                    uint32_t ulLog2BlockSize )
+    {
+        uint32_t ulBlock, ulSize;
+        uint32_t ulSendTime = ulTime + otatestSIM_LATENCY_MS;
+        SimBlock_t * pxBlock;
+
+        for( ulBlock = 0U; ( ulBlock < ( ulBitmapLen * 8U ) ) && ( ulNumBlocks > 0U ); ulBlock++ )
+        {
+            if( ( ( pucBitmap[ ulBlock >> 3 ] & ( 1U << ( ulBlock & 7U ) ) ) != 0U ) &&
+                ( ( ulBlock << ulLog2BlockSize ) < otatestSIM_FILE_SIZE ) )
+            {
+                TEST_ASSERT_LESS_THAN_UINT32( otatestSIM_MAX_QUEUED_BLOCKS, ulSimCount );
+
+                ulSize = otatestSIM_FILE_SIZE - ( ulBlock << ulLog2BlockSize );
+                ulSize = ( ulSize < ( 1UL << ulLog2BlockSize ) ) ? ulSize : ( 1UL << ulLog2BlockSize );
+                ulSimLinkFree = ( ulSimLinkFree > ulSendTime ) ? ulSimLinkFree : ulSendTime;
+                ulSimLinkFree += ( ulSize + otatestSIM_MSG_OVERHEAD + ( otatestSIM_BYTES_PER_MS - 1U ) ) / otatestSIM_BYTES_PER_MS;
+                ulSimRandom = ( ulSimRandom * 1103515245UL ) + 12345UL;
+
+                pxBlock = &xSimBlocks[ ( ulSimHead + ulSimCount ) % otatestSIM_MAX_QUEUED_BLOCKS ];
+                pxBlock->ulArrivalTime = ulSimLinkFree + otatestSIM_LATENCY_MS;
+                pxBlock->ulBlockIndex = ulBlock;
+                pxBlock->ulLog2BlockSize = ulLog2BlockSize;
+                pxBlock->xLost = ( ( ( ulSimRandom >> 16 ) % otatestSIM_LOSS_RATE ) == 0U ) ? pdTRUE : pdFALSE;
+                ulSimCount++;
+                ulNumBlocks--;
+            }
+        }
+    }
+
+/**
+ * @brief Download the simulated file, either through the request window or the way the agent
+ * does without it: ask for otaconfigMAX_NUM_BLOCKS_REQUEST blocks and ask again once they have
+ * all arrived or the request timer expires. Returns the simulated download time in milliseconds.
+ */
+    static uint32_t prvSimDownload( OTA_FileContext_t * C,
+                                    bool_t xPipelined,
+                                    uint32_t * pulDuplicates,
+                                    uint32_t * pulMaxLog2BlockSize )
+    {
+        uint8_t pucBitmap[ otatestSIM_MAX_BITMAP_SIZE ];
+        uint32_t ulNumBlocks = ( otatestSIM_FILE_SIZE + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+        uint32_t ulBitmapLen = ( ulNumBlocks + 7U ) >> 3;
+        uint32_t ulTime = 0U;
+        uint32_t ulLastActivity = 0U;
+        uint32_t ulToReceive = 0U;
+        uint32_t ulEvents, ulBlock, ulFirstBlock, ulCount, ulRemaining;
+        bool_t xRequest = pdTRUE;
+        SimBlock_t * pxBlock;
+
+        /* Start with every block of the file missing and nothing in flight. */
+        memset( C, 0, sizeof( OTA_FileContext_t ) );
+        C->ulFileSize = otatestSIM_FILE_SIZE;
+        C->ulBlocksRemaining = ulNumBlocks;
+        C->pucRxBlockBitmap = ( uint8_t * ) pvPortMalloc( ulBitmapLen );
+        TEST_ASSERT_NOT_NULL( C->pucRxBlockBitmap );
+        memset( C->pucRxBlockBitmap, 0, ulBitmapLen );
+
+        for( ulBlock = 0U; ulBlock < ulNumBlocks; ulBlock++ )
+        {
+            C->pucRxBlockBitmap[ ulBlock >> 3 ] |= ( uint8_t ) ( 1U << ( ulBlock & 7U ) );
+        }
+
+        TEST_ASSERT_TRUE( TEST_OTA_prvWindowStart( C, ulBitmapLen ) );
+        ulSimHead = 0U;
+        ulSimCount = 0U;
+        ulSimLinkFree = 0U;
+        ulSimRandom = 1U;
+        *pulDuplicates = 0U;
+        *pulMaxLog2BlockSize = otaconfigLOG2_FILE_BLOCK_SIZE;
+
+        for( ulEvents = 0U; ( C->ulBlocksRemaining > 0U ) && ( ulEvents < otatestSIM_MAX_EVENTS ); ulEvents++ )
+        {
+            if( xRequest == pdTRUE )
+            {
+                if( xPipelined == pdTRUE )
+                {
+                    ulCount = TEST_OTA_prvWindowSelectBlocks( C, pucBitmap, sizeof( pucBitmap ), &ulBitmapLen );
+                    prvSimServeRequest( ulTime, pucBitmap, ulBitmapLen, ulCount, C->xWindow.ulLog2BlockSize );
+                    *pulMaxLog2BlockSize = ( C->xWindow.ulLog2BlockSize > *pulMaxLog2BlockSize ) ? C->xWindow.ulLog2BlockSize : *pulMaxLog2BlockSize;
+                }
+                else
+                {
+                    prvSimServeRequest( ulTime, C->pucRxBlockBitmap, ( ulNumBlocks + 7U ) >> 3, otaconfigMAX_NUM_BLOCKS_REQUEST, otaconfigLOG2_FILE_BLOCK_SIZE );
+                    ulToReceive = otaconfigMAX_NUM_BLOCKS_REQUEST;
+                }
+
+                xRequest = pdFALSE;
+            }
+
+            pxBlock = &xSimBlocks[ ulSimHead ];
+
+            if( ( ulSimCount > 0U ) && ( pxBlock->ulArrivalTime <= ( ulLastActivity + otaconfigFILE_REQUEST_WAIT_MS ) ) )
+            {
+                ulSimHead = ( ulSimHead + 1U ) % otatestSIM_MAX_QUEUED_BLOCKS;
+                ulSimCount--;
+                ulTime = pxBlock->ulArrivalTime;
+
+                if( pxBlock->xLost == pdFALSE )
+                {
+                    /* Account for the block the way the agent does when it ingests it. */
+                    ulLastActivity = ulTime;
+                    ulFirstBlock = pxBlock->ulBlockIndex << ( pxBlock->ulLog2BlockSize - otaconfigLOG2_FILE_BLOCK_SIZE );
+                    ulCount = 1UL << ( pxBlock->ulLog2BlockSize - otaconfigLOG2_FILE_BLOCK_SIZE );
+                    ulCount = ( ( ulFirstBlock + ulCount ) < ulNumBlocks ) ? ulCount : ( ulNumBlocks - ulFirstBlock );
+                    ulRemaining = C->ulBlocksRemaining;
+
+                    if( xPipelined == pdTRUE )
+                    {
+                        TEST_OTA_prvWindowBlockReceived( C, ulFirstBlock, ulCount );
+                        xRequest = pdTRUE;
+                    }
+
+                    TEST_OTA_prvMarkBlocksReceived( C, ulFirstBlock, ulCount );
+
+                    if( C->ulBlocksRemaining == ulRemaining )
+                    {
+                        ( *pulDuplicates )++;
+                    }
+                    else if( xPipelined == pdFALSE )
+                    {
+                        ulToReceive--;
+                        xRequest = ( ulToReceive == 0U ) ? pdTRUE : pdFALSE;
+                    }
+                }
+            }
+            else
+            {
+                /* Nothing arrived for a whole request timer period. */
+                ulTime = ulLastActivity + otaconfigFILE_REQUEST_WAIT_MS;
+                ulLastActivity = ulTime;
+                xRequest = pdTRUE;
+
+                if( xPipelined == pdTRUE )
+                {
+                    TEST_OTA_prvWindowTimeout( C );
+                }
+            }
+        }
+
+        TEST_ASSERT_EQUAL_UINT32( 0U, C->ulBlocksRemaining );
+
+        TEST_OTA_prvWindowStop( C );
+        vPortFree( C->pucRxBlockBitmap );
+        C->pucRxBlockBitmap = NULL;
+
+        return ulTime;
+    }
+
+    TEST( Full_OTA_AGENT, prvWindowSelectBlocks_SimulatedStream )
+    {
+        OTA_FileContext_t xFile;
+        uint32_t ulWindowTime, ulBatchTime, ulWindowDuplicates, ulBatchDuplicates, ulMaxLog2BlockSize, ulUnused;
+
+        ulBatchTime = prvSimDownload( &xFile, pdFALSE, &ulBatchDuplicates, &ulUnused );
+        ulWindowTime = prvSimDownload( &xFile, pdTRUE, &ulWindowDuplicates, &ulMaxLog2BlockSize );
+
+        configPRINTF( ( "Simulated download of %u bytes: %u ms with the request window (%u duplicate blocks, "
+                        "%u byte blocks at most), %u ms without it (%u duplicate blocks).\r\n",
+                        otatestSIM_FILE_SIZE, ulWindowTime, ulWindowDuplicates, 1U << ulMaxLog2BlockSize,
+                        ulBatchTime, ulBatchDuplicates ) );
+
+        /* Keeping requests in flight must beat waiting for the request timer after every loss. */
+        TEST_ASSERT_LESS_THAN_UINT32( ulBatchTime, ulWindowTime );
+
+        /* With only occasional losses, the block size should grow when it's allowed to. */
+        if( otaconfigLOG2_MAX_FILE_BLOCK_SIZE > otaconfigLOG2_FILE_BLOCK_SIZE )
+        {
+            TEST_ASSERT_GREATER_THAN_UINT32( otaconfigLOG2_FILE_BLOCK_SIZE, ulMaxLog2BlockSize );
+        }
+    }
+
+#endif /* otaconfigPIPELINE_BLOCK_REQUESTS */
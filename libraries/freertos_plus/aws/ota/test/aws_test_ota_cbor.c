@@ -40,6 +40,7 @@
 #include "aws_ota_cbor.h"
 #include "aws_ota_cbor_internal.h"
 #include "aws_ota_agent_test_access_declare.h"
+#include "aws_ota_pal.h"
 #include "cbor.h"
 
 /* Unity framework includes. */
@@ -232,6 +233,12 @@ TEST_GROUP_RUNNER( Full_OTA_CBOR )
 {
     RUN_TEST_CASE( Full_OTA_CBOR, CborOtaApi );
     RUN_TEST_CASE( Full_OTA_CBOR, CborOtaAgentIngest );
+    RUN_TEST_CASE( Full_OTA_CBOR, CborOtaAgentIngestNoAlloc );
+    RUN_TEST_CASE( Full_OTA_CBOR, CborOtaAgentIngestBenchmark );
+    #if ( otaconfigDECOMPRESS_IMAGES == 1 )
+        RUN_TEST_CASE( Full_OTA_CBOR, CborOtaAgentIngestCompressed );
+        RUN_TEST_CASE( Full_OTA_CBOR, CborOtaAgentIngestCompressedBenchmark );
+    #endif
 }
 
 TEST_GROUP_RUNNER( Quarantine_OTA_CBOR )
@@ -250,6 +257,9 @@ TEST_GROUP_RUNNER( Quarantine_OTA_CBOR )
 #define CBOR_TEST_BLOCKIDENTITY_VALUE                     0
 #define CBOR_TEST_STREAMFILES_COUNT                       3
 #define CBOR_TEST_STREAMFILE_FIELD_COUNT                  2
+#define CBOR_TEST_NOALLOC_BLOCK_COUNT                     16
+#define CBOR_TEST_BENCHMARK_ROUNDS                        4
+#define CBOR_TEST_LINK_BYTES_PER_MS                       32
 
 /*-----------------------------------------------------------*/
 
@@ -515,7 +525,7 @@ TEST( Full_OTA_CBOR, CborOtaApi )
     int lFileSize = 0;
     int lBlockIndex = 0;
     int lBlockSize = 0;
-    uint8_t * pucPayload = NULL;
+    const uint8_t * pucPayload = NULL;
     size_t xPayloadSize = 0;
 
     /* Test OTA_CBOR_Encode_GetStreamRequestMessage( ). */
@@ -562,11 +572,10 @@ TEST( Full_OTA_CBOR, CborOtaApi )
         &xPayloadSize );
     TEST_ASSERT_TRUE( xResult );
 
-    if( NULL != pucPayload )
-    {
-        vPortFree( pucPayload );
-        pucPayload = NULL;
-    }
+    /* The payload is decoded in place. */
+    TEST_ASSERT_EQUAL( sizeof( ucBlockPayload ), xPayloadSize );
+    TEST_ASSERT_TRUE( ( pucPayload > ucCborWork ) && ( ( pucPayload + xPayloadSize ) <= ( ucCborWork + xEncodedSize ) ) );
+    TEST_ASSERT_EQUAL_UINT8_ARRAY( ucBlockPayload, pucPayload, xPayloadSize );
 }
 
 TEST( Full_OTA_CBOR, CborOtaAgentIngest )
@@ -682,6 +691,494 @@ TEST( Full_OTA_CBOR, CborOtaAgentIngest )
     }
 }
 
+/* The message being ingested by CborOtaAgentIngestNoAlloc and the free heap size before it was. */
+static const uint8_t * pucNoAllocMessage = NULL;
+static size_t xNoAllocMessageSize = 0;
+static size_t xNoAllocFreeHeap = 0;
+static uint32_t ulNoAllocWrites = 0;
+
+static int16_t prvWriteBlockNoAlloc( OTA_FileContext_t * const C,
+                                     uint32_t iOffset,
+                                     uint8_t * const pacData,
+                                     uint32_t iBlockSize )
+{
+    /* The block must be written straight from the message buffer, with nothing
+     * allocated for it. The request timer is created with the first block of a
+     * file, so the heap is only checked after that. */
+    TEST_ASSERT_TRUE( ( pacData > pucNoAllocMessage ) && ( ( pacData + iBlockSize ) <= ( pucNoAllocMessage + xNoAllocMessageSize ) ) );
+
+    if( ulNoAllocWrites > 0 )
+    {
+        TEST_ASSERT_EQUAL( xNoAllocFreeHeap, xPortGetFreeHeapSize() );
+    }
+
+    ulNoAllocWrites++;
+
+    return ( int16_t ) iBlockSize;
+}
+
+TEST( Full_OTA_CBOR, CborOtaAgentIngestNoAlloc )
+{
+    IngestResult_t xResultIngest = 0;
+    OTA_Err_t xCloseResult = kOTA_Err_None;
+    uint8_t ucBlockPayload[ OTA_FILE_BLOCK_SIZE ] = { 0 };
+    uint8_t ucBlockBitmap[ ( CBOR_TEST_NOALLOC_BLOCK_COUNT / BITS_PER_BYTE ) + 1 ];
+    uint8_t ucCborWork[ CBOR_TEST_MESSAGE_BUFFER_SIZE ];
+    size_t xEncodedSize = 0;
+    OTA_FileContext_t xOTAFileContext = { 0 };
+
+    /* The file has one more block than is ingested so that it is never closed. */
+    xOTAFileContext.ulFileSize = ( CBOR_TEST_NOALLOC_BLOCK_COUNT + 1 ) * OTA_FILE_BLOCK_SIZE;
+    xOTAFileContext.ulBlocksRemaining = CBOR_TEST_NOALLOC_BLOCK_COUNT + 1;
+    xOTAFileContext.pucRxBlockBitmap = ucBlockBitmap;
+    xOTAFileContext.pucFile = ucBlockPayload;
+    memset( ucBlockBitmap, 0xFF, sizeof( ucBlockBitmap ) );
+    ulNoAllocWrites = 0;
+
+    TEST_OTA_prvSetWriteBlockCallback( prvWriteBlockNoAlloc );
+
+    for( uint32_t ulBlock = 0; ulBlock < CBOR_TEST_NOALLOC_BLOCK_COUNT; ulBlock++ )
+    {
+        TEST_ASSERT_TRUE( prvCreateSampleGetStreamResponseMessage(
+                              ucCborWork,
+                              sizeof( ucCborWork ),
+                              ulBlock,
+                              ucBlockPayload,
+                              sizeof( ucBlockPayload ),
+                              &xEncodedSize ) );
+
+        pucNoAllocMessage = ucCborWork;
+        xNoAllocMessageSize = xEncodedSize;
+        xNoAllocFreeHeap = xPortGetFreeHeapSize();
+
+        xResultIngest = TEST_OTA_prvIngestDataBlock(
+            &xOTAFileContext,
+            ucCborWork,
+            xEncodedSize,
+            &xCloseResult );
+        TEST_ASSERT_EQUAL_INT32( eIngest_Result_Accepted_Continue, xResultIngest );
+
+        /* Nothing is left allocated for any block after the first. */
+        if( ulBlock > 0 )
+        {
+            TEST_ASSERT_EQUAL( xNoAllocFreeHeap, xPortGetFreeHeapSize() );
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32( CBOR_TEST_NOALLOC_BLOCK_COUNT, ulNoAllocWrites );
+
+    /* Clean-up. */
+    TEST_OTA_prvSetWriteBlockCallback( NULL );
+
+    if( NULL != xOTAFileContext.xRequestTimer )
+    {
+        ( void ) xTimerDelete( xOTAFileContext.xRequestTimer, portMAX_DELAY );
+    }
+}
+
+/* The lowest free heap size seen while CborOtaAgentIngestBenchmark ingests a file. */
+static size_t xBenchmarkMinFreeHeap = 0;
+
+static int16_t prvWriteBlockBenchmark( OTA_FileContext_t * const C,
+                                       uint32_t iOffset,
+                                       uint8_t * const pacData,
+                                       uint32_t iBlockSize )
+{
+    size_t xFreeHeap = xPortGetFreeHeapSize();
+
+    if( xFreeHeap < xBenchmarkMinFreeHeap )
+    {
+        xBenchmarkMinFreeHeap = xFreeHeap;
+    }
+
+    return prvPAL_WriteBlock( C, iOffset, pacData, iBlockSize );
+}
+
+/* Stream the signed test file through the agent into the platform's file PAL, the way the stream
+ * service would send it, and report the ingest rate, the most heap in use while blocks are being
+ * written, and how long closing and verifying the complete file took. */
+TEST( Full_OTA_CBOR, CborOtaAgentIngestBenchmark )
+{
+    IngestResult_t xResultIngest = 0;
+    OTA_Err_t xCloseResult = kOTA_Err_None;
+    uint8_t ucCborWork[ CBOR_TEST_MESSAGE_BUFFER_SIZE ];
+    size_t xChunkSize = 0;
+    size_t xEncodedSize = 0;
+    OTA_FileContext_t xOTAFileContext = { 0 };
+    Sig256_t xSig = { 0 };
+    uint8_t * pucInFile = NULL;
+    uint32_t ulFileSize = 0;
+    size_t xBlockBitmapSize = 0;
+    size_t xStartFreeHeap = 0;
+    uint32_t ulBlocks = 0;
+    TickType_t xStart = 0;
+    TickType_t xIngestTicks = 0;
+    TickType_t xCloseTicks = 0;
+    TickType_t xMaxCloseTicks = 0;
+    uint32_t ulIngestMs = 0;
+    uint8_t ucSignature[] =
+    {
+        0x38, 0x78, 0xf9, 0xb0, 0xd8, 0xf1, 0xa8, 0xc3, 0x4a, 0xdd, 0x63, 0x44, 0xc1, 0xbc, 0x9f, 0xb3,
+        0xf3, 0xde, 0x49, 0x24, 0xb5, 0x93, 0x32, 0xe4, 0x01, 0x0e, 0x0c, 0x4a, 0xed, 0x32, 0x28, 0xd1,
+        0x68, 0x1b, 0x12, 0x6b, 0x50, 0xab, 0x88, 0x5a, 0x18, 0xd0, 0x6d, 0x08, 0x8f, 0x95, 0x77, 0x03,
+        0xb5, 0x79, 0x52, 0x5c, 0x4f, 0x32, 0x74, 0x0c, 0x28, 0xc6, 0x79, 0xf0, 0xe6, 0x57, 0x30, 0xa4,
+        0x9b, 0x1b, 0x5f, 0x10, 0xf5, 0x2b, 0x53, 0xf0, 0x64, 0x9a, 0x1c, 0xff, 0x79, 0xaf, 0xe5, 0x71,
+        0xd7, 0x6e, 0xfb, 0xc4, 0xa0, 0x5a, 0xf8, 0xc8, 0x0d, 0x2b, 0x85, 0x8e, 0x2d, 0xca, 0xb3, 0x03,
+        0x05, 0xeb, 0x04, 0xb4, 0xe5, 0x6b, 0x5b, 0x4c, 0x88, 0xe2, 0x63, 0x38, 0x2d, 0xd7, 0xb9, 0x3a,
+        0xd7, 0x48, 0xc6, 0x8f, 0x2c, 0x8d, 0x34, 0x8f, 0x19, 0x7a, 0x36, 0x12, 0x3b, 0xa1, 0x9f, 0xe2,
+        0xc3, 0x44, 0x3d, 0xe0, 0x29, 0xd6, 0xf5, 0x82, 0xd3, 0xe9, 0xa0, 0x9f, 0xd8, 0x05, 0x09, 0x98,
+        0x29, 0x71, 0xc5, 0x43, 0x94, 0x16, 0xe7, 0xc1, 0x8e, 0x4a, 0x50, 0x7d, 0xa6, 0xba, 0xb9, 0xbf,
+        0xe3, 0x25, 0xa1, 0x50, 0x80, 0x4e, 0x39, 0xb3, 0x6f, 0xdb, 0x6e, 0xe2, 0x6b, 0x12, 0x71, 0x76,
+        0x18, 0xcb, 0x8d, 0x62, 0x90, 0x48, 0x4a, 0xd9, 0xec, 0x9f, 0x97, 0xbf, 0xef, 0xa5, 0xcd, 0xaf,
+        0x30, 0xd5, 0xfa, 0xba, 0x1c, 0xb2, 0x79, 0x98, 0x64, 0xbb, 0xd9, 0xda, 0x98, 0x8e, 0x0e, 0x66,
+        0x6b, 0x29, 0xef, 0x6b, 0x4b, 0x2f, 0x80, 0xf8, 0xa4, 0x5b, 0x78, 0xfe, 0x70, 0xd6, 0x61, 0x20,
+        0x28, 0xf2, 0xc4, 0x00, 0xc2, 0x7b, 0x35, 0x44, 0xd6, 0x3e, 0x8f, 0x9d, 0x8a, 0x7e, 0xf8, 0x2f,
+        0x28, 0xa3, 0x77, 0xbb, 0xa1, 0xb7, 0xb2, 0xe1, 0x72, 0x55, 0x0a, 0x31, 0x58, 0x9b, 0xb7, 0x68
+    };
+
+    TEST_ASSERT_TRUE( prvReadCborTestFile( "payload.bin", &pucInFile, &ulFileSize ) );
+
+    xStartFreeHeap = xPortGetFreeHeapSize();
+    xBenchmarkMinFreeHeap = xStartFreeHeap;
+    TEST_OTA_prvSetWriteBlockCallback( prvWriteBlockBenchmark );
+
+    for( uint32_t ulRound = 0; ulRound < CBOR_TEST_BENCHMARK_ROUNDS; ulRound++ )
+    {
+        /* Receive the file into the PAL from scratch, as if a new job had started. */
+        memset( &xOTAFileContext, 0, sizeof( xOTAFileContext ) );
+        xOTAFileContext.ulFileSize = ulFileSize;
+        xOTAFileContext.pucFilePath = "testOtaFile.bin";
+        xOTAFileContext.pucCertFilepath = "rsasigner.crt";
+        xOTAFileContext.pxSignature = &xSig;
+        memcpy( xOTAFileContext.pxSignature->ucData, ucSignature, sizeof( ucSignature ) );
+        xOTAFileContext.pxSignature->usSize = sizeof( ucSignature );
+        xOTAFileContext.ulBlocksRemaining = ( ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1 ) ) / OTA_FILE_BLOCK_SIZE;
+
+        /* The agent frees the bitmap once the last block is in. */
+        xBlockBitmapSize = 1 + ( ulFileSize / BITS_PER_BYTE );
+        xOTAFileContext.pucRxBlockBitmap = pvPortMalloc( xBlockBitmapSize );
+        TEST_ASSERT_NOT_NULL( xOTAFileContext.pucRxBlockBitmap );
+        memset( xOTAFileContext.pucRxBlockBitmap, 0xFF, xBlockBitmapSize );
+
+        TEST_ASSERT_EQUAL( kOTA_Err_None, prvPAL_CreateFileForRx( &xOTAFileContext ) );
+
+        xStart = xTaskGetTickCount();
+
+        for( size_t xBlock = 0;
+             ( xBlock * OTA_FILE_BLOCK_SIZE ) < ulFileSize;
+             xBlock++ )
+        {
+            xChunkSize = min(
+                OTA_FILE_BLOCK_SIZE,
+                ulFileSize - ( xBlock * OTA_FILE_BLOCK_SIZE ) );
+            TEST_ASSERT_TRUE( prvCreateSampleGetStreamResponseMessage(
+                                  ucCborWork,
+                                  sizeof( ucCborWork ),
+                                  xBlock,
+                                  pucInFile + ( xBlock * OTA_FILE_BLOCK_SIZE ),
+                                  xChunkSize,
+                                  &xEncodedSize ) );
+
+            /* The last block closes and verifies the file, which is timed separately. */
+            if( ( ( xBlock * OTA_FILE_BLOCK_SIZE ) + xChunkSize ) == ulFileSize )
+            {
+                xIngestTicks += xTaskGetTickCount() - xStart;
+                xStart = xTaskGetTickCount();
+            }
+
+            xResultIngest = TEST_OTA_prvIngestDataBlock(
+                &xOTAFileContext,
+                ucCborWork,
+                xEncodedSize,
+                &xCloseResult );
+            ulBlocks++;
+
+            if( xOTAFileContext.ulBlocksRemaining > 0 )
+            {
+                TEST_ASSERT_EQUAL_INT32( eIngest_Result_Accepted_Continue, xResultIngest );
+            }
+        }
+
+        xCloseTicks = xTaskGetTickCount() - xStart;
+        xMaxCloseTicks = max( xMaxCloseTicks, xCloseTicks );
+
+        /* The whole file must have been received and checked. Whether the test signer certificate
+         * matches the platform's signature method doesn't matter here. */
+        if( ( xResultIngest != eIngest_Result_FileComplete ) && ( xResultIngest != eIngest_Result_SigCheckFail ) )
+        {
+            TEST_ASSERT_EQUAL_INT32( eIngest_Result_FileComplete, xResultIngest );
+        }
+
+        if( NULL != xOTAFileContext.xRequestTimer )
+        {
+            ( void ) xTimerDelete( xOTAFileContext.xRequestTimer, portMAX_DELAY );
+        }
+    }
+
+    ulIngestMs = max( 1, xIngestTicks * portTICK_PERIOD_MS );
+    configPRINTF( ( "OTA ingest of %u blocks of %u bytes: %u blocks/s, %u bytes of heap in use at most, "
+                    "%u ms at most to close and verify the file.\r\n",
+                    ulBlocks, OTA_FILE_BLOCK_SIZE, ( ulBlocks * 1000 ) / ulIngestMs,
+                    xStartFreeHeap - xBenchmarkMinFreeHeap, xMaxCloseTicks * portTICK_PERIOD_MS ) );
+
+    /* Clean-up. */
+    TEST_OTA_prvSetWriteBlockCallback( NULL );
+    vPortFree( pucInFile );
+}
+
+#if ( otaconfigDECOMPRESS_IMAGES == 1 )
+
+/* The decompressed file expected by prvWriteBlockCompressed and how much of it was written. */
+    static const uint8_t * pucCompressedExpected = NULL;
+    static uint32_t ulCompressedExpectedSize = 0;
+    static uint32_t ulCompressedWritten = 0;
+
+    static int16_t prvWriteBlockCompressed( OTA_FileContext_t * const C,
+                                            uint32_t iOffset,
+                                            uint8_t * const pacData,
+                                            uint32_t iBlockSize )
+    {
+        /* The decompressed file is written in order, a block at a time at most. */
+        TEST_ASSERT_EQUAL_UINT32( ulCompressedWritten, iOffset );
+        TEST_ASSERT_TRUE( iBlockSize <= OTA_FILE_BLOCK_SIZE );
+        TEST_ASSERT_TRUE( ( iOffset + iBlockSize ) <= ulCompressedExpectedSize );
+        TEST_ASSERT_EQUAL_MEMORY( pucCompressedExpected + iOffset, pacData, iBlockSize );
+        ulCompressedWritten += iBlockSize;
+
+        return prvPAL_WriteBlock( C, iOffset, pacData, iBlockSize );
+    }
+
+/* Set up a file context to receive a file of ulFileSize bytes into the platform's file PAL. The file
+ * is decompressed to ulImageSize bytes if pcCompression isn't NULL. */
+    static void prvStartTestFile( OTA_FileContext_t * C,
+                                  uint32_t ulFileSize,
+                                  uint32_t ulImageSize,
+                                  char * pcCompression )
+    {
+        size_t xBlockBitmapSize = 1 + ( ulFileSize / BITS_PER_BYTE );
+
+        memset( C, 0, sizeof( *C ) );
+        C->ulFileSize = ulFileSize;
+        C->ulImageSize = ulImageSize;
+        C->pucCompression = ( uint8_t * ) pcCompression;
+        C->pucFilePath = "testOtaFile.bin";
+        C->pucCertFilepath = "rsasigner.crt";
+        C->ulBlocksRemaining = ( ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1 ) ) / OTA_FILE_BLOCK_SIZE;
+
+        /* The agent frees the bitmap once the last block is in. */
+        C->pucRxBlockBitmap = pvPortMalloc( xBlockBitmapSize );
+        TEST_ASSERT_NOT_NULL( C->pucRxBlockBitmap );
+        memset( C->pucRxBlockBitmap, 0xFF, xBlockBitmapSize );
+
+        TEST_ASSERT_EQUAL( kOTA_Err_None, prvPAL_CreateFileForRx( C ) );
+
+        if( pcCompression != NULL )
+        {
+            TEST_ASSERT_TRUE( TEST_OTA_prvStartInflate( C ) );
+        }
+    }
+
+/* Send block ulBlock of a file to the agent and return the ingest result. The size of the message
+ * sent is added to pulWireBytes. */
+    static IngestResult_t prvIngestTestBlock( OTA_FileContext_t * C,
+                                              const uint8_t * pucFile,
+                                              uint32_t ulFileSize,
+                                              uint32_t ulBlock,
+                                              uint32_t * pulWireBytes )
+    {
+        uint8_t ucCborWork[ CBOR_TEST_MESSAGE_BUFFER_SIZE ];
+        size_t xEncodedSize = 0;
+        OTA_Err_t xCloseResult = kOTA_Err_None;
+        size_t xChunkSize = min( OTA_FILE_BLOCK_SIZE, ulFileSize - ( ulBlock * OTA_FILE_BLOCK_SIZE ) );
+
+        TEST_ASSERT_TRUE( prvCreateSampleGetStreamResponseMessage(
+                              ucCborWork,
+                              sizeof( ucCborWork ),
+                              ulBlock,
+                              ( uint8_t * ) pucFile + ( ulBlock * OTA_FILE_BLOCK_SIZE ),
+                              xChunkSize,
+                              &xEncodedSize ) );
+        *pulWireBytes += xEncodedSize;
+
+        return TEST_OTA_prvIngestDataBlock( C, ucCborWork, xEncodedSize, &xCloseResult );
+    }
+
+/* Stream a compressed copy of the signed test file through the agent, with blocks arriving ahead of
+ * the decompressed prefix, and check that the file is written decompressed. Then check that a corrupt
+ * copy is rejected. */
+    TEST( Full_OTA_CBOR, CborOtaAgentIngestCompressed )
+    {
+        IngestResult_t xResultIngest = 0;
+        OTA_FileContext_t xOTAFileContext = { 0 };
+        uint8_t * pucImage = NULL;
+        uint32_t ulImageSize = 0;
+        uint8_t * pucInFile = NULL;
+        uint32_t ulFileSize = 0;
+        uint32_t ulBlocks = 0;
+        uint32_t ulBlock = 0;
+        uint32_t ulWireBytes = 0;
+
+        TEST_ASSERT_TRUE( prvReadCborTestFile( "payload.bin", &pucImage, &ulImageSize ) );
+        TEST_ASSERT_TRUE( prvReadCborTestFile( "payload.bin.zlib", &pucInFile, &ulFileSize ) );
+        ulBlocks = ( ulFileSize + ( OTA_FILE_BLOCK_SIZE - 1 ) ) / OTA_FILE_BLOCK_SIZE;
+        TEST_ASSERT_TRUE( ulBlocks > ( otaconfigMAX_DECOMPRESS_PENDING_BLOCKS + 2 ) );
+
+        pucCompressedExpected = pucImage;
+        ulCompressedExpectedSize = ulImageSize;
+        ulCompressedWritten = 0;
+        TEST_OTA_prvSetWriteBlockCallback( prvWriteBlockCompressed );
+        prvStartTestFile( &xOTAFileContext, ulFileSize, ulImageSize, "zlib" );
+
+        /* Blocks ahead of the gap at block 0 are held until there are no free slots left, after
+         * which they are deferred to be requested again. */
+        for( ulBlock = 1; ulBlock <= otaconfigMAX_DECOMPRESS_PENDING_BLOCKS + 1; ulBlock++ )
+        {
+            xResultIngest = prvIngestTestBlock( &xOTAFileContext, pucInFile, ulFileSize, ulBlock, &ulWireBytes );
+
+            if( ulBlock <= otaconfigMAX_DECOMPRESS_PENDING_BLOCKS )
+            {
+                TEST_ASSERT_EQUAL_INT32( eIngest_Result_Accepted_Continue, xResultIngest );
+            }
+            else
+            {
+                TEST_ASSERT_EQUAL_INT32( eIngest_Result_Deferred_Continue, xResultIngest );
+            }
+        }
+
+        TEST_ASSERT_EQUAL_UINT32( 0, ulCompressedWritten );
+
+        /* Filling the gap decompresses the held blocks too, and the rest follow in order. */
+        for( ulBlock = 0; ulBlock < ulBlocks; ulBlock++ )
+        {
+            xResultIngest = prvIngestTestBlock( &xOTAFileContext, pucInFile, ulFileSize, ulBlock, &ulWireBytes );
+
+            if( ( ulBlock > 0 ) && ( ulBlock <= otaconfigMAX_DECOMPRESS_PENDING_BLOCKS ) )
+            {
+                TEST_ASSERT_EQUAL_INT32( eIngest_Result_Duplicate_Continue, xResultIngest );
+            }
+            else if( ulBlock < ( ulBlocks - 1 ) )
+            {
+                TEST_ASSERT_EQUAL_INT32( eIngest_Result_Accepted_Continue, xResultIngest );
+            }
+        }
+
+        /* No signature is given, so the complete file fails the signature check. */
+        TEST_ASSERT_EQUAL_INT32( eIngest_Result_SigCheckFail, xResultIngest );
+        TEST_ASSERT_EQUAL_UINT32( ulImageSize, ulCompressedWritten );
+        TEST_ASSERT_NULL( xOTAFileContext.pvInflateContext );
+
+        if( NULL != xOTAFileContext.xRequestTimer )
+        {
+            ( void ) xTimerDelete( xOTAFileContext.xRequestTimer, portMAX_DELAY );
+        }
+
+        /* A corrupt file fails no later than its last block, and isn't closed. */
+        pucInFile[ ulFileSize / 2 ] ^= 0x55;
+        ulCompressedWritten = 0;
+        TEST_OTA_prvSetWriteBlockCallback( prvPAL_WriteBlock );
+        prvStartTestFile( &xOTAFileContext, ulFileSize, ulImageSize, "zlib" );
+
+        for( ulBlock = 0; ulBlock < ulBlocks; ulBlock++ )
+        {
+            xResultIngest = prvIngestTestBlock( &xOTAFileContext, pucInFile, ulFileSize, ulBlock, &ulWireBytes );
+
+            if( xResultIngest != eIngest_Result_Accepted_Continue )
+            {
+                break;
+            }
+        }
+
+        /* Depending on where it is corrupt, the stream is invalid or decompresses to too much data. */
+        if( xResultIngest != eIngest_Result_WriteBlockFailed )
+        {
+            TEST_ASSERT_EQUAL_INT32( eIngest_Result_BadData, xResultIngest );
+        }
+
+        /* Clean-up. */
+        TEST_OTA_prvStopInflate( &xOTAFileContext );
+        ( void ) prvPAL_Abort( &xOTAFileContext );
+        vPortFree( xOTAFileContext.pucRxBlockBitmap );
+
+        if( NULL != xOTAFileContext.xRequestTimer )
+        {
+            ( void ) xTimerDelete( xOTAFileContext.xRequestTimer, portMAX_DELAY );
+        }
+
+        TEST_OTA_prvSetWriteBlockCallback( NULL );
+        vPortFree( pucInFile );
+        vPortFree( pucImage );
+    }
+
+/* Stream the signed test file through the agent as it is and compressed, and report the bytes sent
+ * on the wire, the time they take on a link of CBOR_TEST_LINK_BYTES_PER_MS, and the time the agent
+ * takes to ingest them. */
+    TEST( Full_OTA_CBOR, CborOtaAgentIngestCompressedBenchmark )
+    {
+        IngestResult_t xResultIngest = 0;
+        OTA_FileContext_t xOTAFileContext = { 0 };
+        uint8_t * pucFiles[ 2 ] = { NULL, NULL };
+        uint32_t ulFileSizes[ 2 ] = { 0, 0 };
+        char * pcCompression[ 2 ] = { NULL, "zlib" };
+        uint32_t ulWireBytes[ 2 ] = { 0, 0 };
+        TickType_t xIngestTicks[ 2 ] = { 0, 0 };
+        TickType_t xStart = 0;
+        uint32_t ulFile = 0;
+        uint32_t ulBlock = 0;
+
+        TEST_ASSERT_TRUE( prvReadCborTestFile( "payload.bin", &pucFiles[ 0 ], &ulFileSizes[ 0 ] ) );
+        TEST_ASSERT_TRUE( prvReadCborTestFile( "payload.bin.zlib", &pucFiles[ 1 ], &ulFileSizes[ 1 ] ) );
+        TEST_OTA_prvSetWriteBlockCallback( NULL );
+
+        for( uint32_t ulRound = 0; ulRound < CBOR_TEST_BENCHMARK_ROUNDS; ulRound++ )
+        {
+            for( ulFile = 0; ulFile < 2; ulFile++ )
+            {
+                prvStartTestFile( &xOTAFileContext, ulFileSizes[ ulFile ], ulFileSizes[ 0 ], pcCompression[ ulFile ] );
+                ulWireBytes[ ulFile ] = 0;
+                xStart = xTaskGetTickCount();
+
+                for( ulBlock = 0; ( ulBlock * OTA_FILE_BLOCK_SIZE ) < ulFileSizes[ ulFile ]; ulBlock++ )
+                {
+                    xResultIngest = prvIngestTestBlock( &xOTAFileContext, pucFiles[ ulFile ], ulFileSizes[ ulFile ], ulBlock, &ulWireBytes[ ulFile ] );
+
+                    if( xOTAFileContext.ulBlocksRemaining > 0 )
+                    {
+                        TEST_ASSERT_EQUAL_INT32( eIngest_Result_Accepted_Continue, xResultIngest );
+                    }
+                }
+
+                xIngestTicks[ ulFile ] += xTaskGetTickCount() - xStart;
+
+                /* Whether the test signer certificate matches the platform's signature method doesn't matter here. */
+                if( ( xResultIngest != eIngest_Result_FileComplete ) && ( xResultIngest != eIngest_Result_SigCheckFail ) )
+                {
+                    TEST_ASSERT_EQUAL_INT32( eIngest_Result_FileComplete, xResultIngest );
+                }
+
+                if( NULL != xOTAFileContext.xRequestTimer )
+                {
+                    ( void ) xTimerDelete( xOTAFileContext.xRequestTimer, portMAX_DELAY );
+                }
+            }
+        }
+
+        for( ulFile = 0; ulFile < 2; ulFile++ )
+        {
+            configPRINTF( ( "OTA ingest of %u bytes %s: %u bytes on the wire, %u ms on the link, %u ms to ingest and verify.\r\n",
+                            ulFileSizes[ 0 ], ( pcCompression[ ulFile ] != NULL ) ? "compressed" : "as is",
+                            ulWireBytes[ ulFile ], ulWireBytes[ ulFile ] / CBOR_TEST_LINK_BYTES_PER_MS,
+                            ( xIngestTicks[ ulFile ] * portTICK_PERIOD_MS ) / CBOR_TEST_BENCHMARK_ROUNDS ) );
+        }
+
+        TEST_ASSERT_TRUE( ulWireBytes[ 1 ] < ulWireBytes[ 0 ] );
+
+        /* Clean-up. */
+        vPortFree( pucFiles[ 0 ] );
+        vPortFree( pucFiles[ 1 ] );
+    }
+
+#endif /* otaconfigDECOMPRESS_IMAGES */
+
 TEST( Quarantine_OTA_CBOR, CborOtaServerFiles )
 {
     BaseType_t xResultBool = pdFALSE;
@@ -695,7 +1192,7 @@ TEST( Quarantine_OTA_CBOR, CborOtaServerFiles )
     int lFileSize = 0;
     int lBlockIndex = 0;
     int lBlockSize = 0;
-    uint8_t * pucPayload = NULL;
+    const uint8_t * pucPayload = NULL;
     size_t xPayloadSize = 0;
     char pcChunkFileName[ MAX_PATH ];
     uint32_t ulBitmap = CBOR_TEST_BITMAP_VALUE;
@@ -725,12 +1222,6 @@ TEST( Quarantine_OTA_CBOR, CborOtaServerFiles )
             &xBufferSize );
         TEST_ASSERT_TRUE( xResultBool );
 
-        /* Free the previous chunk buffer. */
-        if( NULL != pucPayload )
-        {
-            vPortFree( pucPayload );
-        }
-
         /* Parse the chunk message. */
         xResultBool = OTA_CBOR_Decode_GetStreamResponseMessage(
             pucInFile,
@@ -756,9 +1247,4 @@ TEST( Quarantine_OTA_CBOR, CborOtaServerFiles )
     {
         vPortFree( pucInFile );
     }
-
-    if( NULL != pucPayload )
-    {
-        vPortFree( pucPayload );
-    }
 }
@@ -63,6 +63,13 @@
  * the block write loop. */
 #define testotapalWRITE_BLOCKS_DELAY_MS    5000
 
+/* For the prvPAL_SaveCheckpoint_ResumeAfterInterruption test, ucDummyData is written in blocks
+ * of this many bytes, a checkpoint is saved every testotapalCHECKPOINT_INTERVAL blocks and the
+ * transfer is repeated testotapalCHECKPOINT_TRIALS times with different interruption points. */
+#define testotapalCHECKPOINT_BLOCK_SIZE    8U
+#define testotapalCHECKPOINT_INTERVAL      3U
+#define testotapalCHECKPOINT_TRIALS        20U
+
 /*
  * @brief: This dummy data is prepended by a SHA1 hash generated from the rsa-sha1-signer
  * certificate and keys in tests/common/ota/test_files.
@@ -169,6 +176,8 @@ TEST_GROUP_RUNNER( Full_OTA_PAL )
     RUN_TEST_CASE( Full_OTA_PAL, prvPAL_WriteBlock_WriteSingleByte );
     RUN_TEST_CASE( Full_OTA_PAL, prvPAL_WriteBlock_WriteManyBlocks );
 
+    RUN_TEST_CASE( Full_OTA_PAL, prvPAL_SaveCheckpoint_ResumeAfterInterruption );
+
     /* This test resets the device so it is not valid for an MCU. */
     RUN_TEST_CASE( Full_OTA_PAL, prvPAL_ActivateNewImage );
 
@@ -617,6 +626,116 @@ TEST( Full_OTA_PAL, prvPAL_WriteBlock_WriteManyBlocks )
     }
 }
 
+#if ( otatestpalCHECKPOINT_SUPPORTED == 1 )
+
+/**
+ * @brief A small deterministic pseudo random number generator, so that failures are repeatable.
+ */
+    static uint32_t prvNextRandom( uint32_t * pulState )
+    {
+        *pulState = ( *pulState * 1103515245UL ) + 12345UL;
+
+        return *pulState >> 16;
+    }
+#endif
+
+/**
+ * @brief Write ucDummyData in out of order blocks and interrupt the transfer at pseudo random
+ * points the way a reset would, discarding everything but what the PAL persisted. Resume each
+ * time from the last checkpoint and verify the reassembled file still passes the signature check.
+ */
+TEST( Full_OTA_PAL, prvPAL_SaveCheckpoint_ResumeAfterInterruption )
+{
+    #if ( otatestpalCHECKPOINT_SUPPORTED == 1 )
+        OTA_Err_t xOtaStatus;
+        Sig256_t xSig = { 0 };
+        const uint32_t ulNumBlocks = ( sizeof( ucDummyData ) + testotapalCHECKPOINT_BLOCK_SIZE - 1U ) / testotapalCHECKPOINT_BLOCK_SIZE;
+        uint32_t ulPending;
+        uint32_t ulSeed = 1U;
+        uint32_t ulTrial, ulBlock, ulBlockSize, ulWrites, ulInterruptAfter;
+        int16_t sNumBytesWritten;
+
+        for( ulTrial = 0; ulTrial < testotapalCHECKPOINT_TRIALS; ulTrial++ )
+        {
+            /* Start with no checkpoint and every block still needed (a set bit means needed). */
+            TEST_ASSERT_EQUAL( kOTA_Err_None, prvPAL_SaveCheckpoint( &xOtaFile, NULL, 0 ) );
+            ulPending = ( 1UL << ulNumBlocks ) - 1UL;
+
+            memset( &xOtaFile, 0, sizeof( xOtaFile ) );
+            xOtaFile.pucFilePath = ( uint8_t * ) ( "test_resume_image.bin" );
+            xOtaFile.ulFileSize = sizeof( ucDummyData );
+            xOtaStatus = prvPAL_CreateFileForRx( &xOtaFile );
+            TEST_ASSERT_EQUAL( kOTA_Err_None, xOtaStatus );
+
+            while( ulPending != 0UL )
+            {
+                ulInterruptAfter = 1U + ( prvNextRandom( &ulSeed ) % ulNumBlocks );
+
+                for( ulWrites = 0; ( ulWrites < ulInterruptAfter ) && ( ulPending != 0UL ); ulWrites++ )
+                {
+                    /* Pick a pending block at random, as blocks may arrive out of order. */
+                    do
+                    {
+                        ulBlock = prvNextRandom( &ulSeed ) % ulNumBlocks;
+                    } while( ( ulPending & ( 1UL << ulBlock ) ) == 0UL );
+
+                    ulBlockSize = sizeof( ucDummyData ) - ( ulBlock * testotapalCHECKPOINT_BLOCK_SIZE );
+
+                    if( ulBlockSize > testotapalCHECKPOINT_BLOCK_SIZE )
+                    {
+                        ulBlockSize = testotapalCHECKPOINT_BLOCK_SIZE;
+                    }
+
+                    sNumBytesWritten = prvPAL_WriteBlock( &xOtaFile,
+                                                          ulBlock * testotapalCHECKPOINT_BLOCK_SIZE,
+                                                          &ucDummyData[ ulBlock * testotapalCHECKPOINT_BLOCK_SIZE ],
+                                                          ulBlockSize );
+                    TEST_ASSERT_EQUAL_INT( ulBlockSize, sNumBytesWritten );
+                    ulPending &= ~( 1UL << ulBlock );
+
+                    if( ( ( ulWrites + 1U ) % testotapalCHECKPOINT_INTERVAL ) == 0U )
+                    {
+                        xOtaStatus = prvPAL_SaveCheckpoint( &xOtaFile, ( const uint8_t * ) &ulPending, sizeof( ulPending ) );
+                        TEST_ASSERT_EQUAL( kOTA_Err_None, xOtaStatus );
+                    }
+                }
+
+                if( ulPending != 0UL )
+                {
+                    /* Interrupt the transfer. Only the file and the checkpoint survive. */
+                    ( void ) prvPAL_Abort( &xOtaFile );
+
+                    if( prvPAL_LoadCheckpoint( &xOtaFile, ( uint8_t * ) &ulPending, sizeof( ulPending ) ) == sizeof( ulPending ) )
+                    {
+                        xOtaFile.xResume = pdTRUE;
+                    }
+                    else
+                    {
+                        /* Nothing was checkpointed yet, so start over. */
+                        ulPending = ( 1UL << ulNumBlocks ) - 1UL;
+                        xOtaFile.xResume = pdFALSE;
+                    }
+
+                    xOtaStatus = prvPAL_CreateFileForRx( &xOtaFile );
+                    TEST_ASSERT_EQUAL( kOTA_Err_None, xOtaStatus );
+                }
+            }
+
+            xOtaFile.pxSignature = &xSig;
+            xOtaFile.pxSignature->usSize = ucValidSignatureLength;
+            memcpy( xOtaFile.pxSignature->ucData, ucValidSignature, ucValidSignatureLength );
+            xOtaFile.pucCertFilepath = ( uint8_t * ) otatestpalCERTIFICATE_FILE;
+
+            xOtaStatus = prvPAL_CloseFile( &xOtaFile );
+            TEST_ASSERT_EQUAL_INT_MESSAGE( kOTA_Err_None, xOtaStatus, "Resumed file failed the signature check." );
+        }
+
+        TEST_ASSERT_EQUAL( kOTA_Err_None, prvPAL_SaveCheckpoint( &xOtaFile, NULL, 0 ) );
+    #else
+        TEST_IGNORE_MESSAGE( "The PAL doesn't support checkpoints." );
+    #endif /* if ( otatestpalCHECKPOINT_SUPPORTED == 1 ) */
+}
+
 /**
  * Call prvPAL_ActivateNewImage() and verify success. This function is expected to
  * reset the device, so this test is only supported on the Windows Simulator environment.
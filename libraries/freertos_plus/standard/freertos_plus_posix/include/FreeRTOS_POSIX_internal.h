@@ -52,9 +52,10 @@
     typedef struct pthread_mutex_internal
     {
         BaseType_t xIsInitialized;          /**< Set to pdTRUE if this mutex is initialized, pdFALSE otherwise. */
-        StaticSemaphore_t xMutex;           /**< FreeRTOS mutex. */
+        StaticSemaphore_t xMutex;           /**< FreeRTOS mutex, or the semaphore contended tasks block on if ulLockState is used. */
         TaskHandle_t xTaskOwner;            /**< Owner; used for deadlock detection and permission checks. */
         pthread_mutexattr_internal_t xAttr; /**< Mutex attributes. */
+        uint32_t ulLockState;               /**< Locked and waiters bits of a mutex taken with atomic operations. */
     } pthread_mutex_internal_t;
 
 /**
@@ -66,7 +67,8 @@
         .xIsInitialized = pdFALSE,           \
         .xMutex = { { 0 } },                 \
         .xTaskOwner = NULL,                  \
-        .xAttr = { .iType = 0 }              \
+        .xAttr = { .iType = 0 },             \
+        .ulLockState = 0                     \
     }                                        \
         )                                    \
     )
@@ -79,9 +81,8 @@
  */
     typedef struct pthread_cond_internal
     {
-        BaseType_t xIsInitialized;            /**< Set to pdTRUE if this condition variable is initialized, pdFALSE otherwise. */
-        StaticSemaphore_t xCondWaitSemaphore; /**< Threads block on this semaphore in pthread_cond_wait. */
-        unsigned iWaitingThreads;             /**< The number of threads currently waiting on this condition variable. */
+        BaseType_t xIsInitialized; /**< Set to pdTRUE if this condition variable is initialized, pdFALSE otherwise. */
+        Link_t xWaiterList;        /**< Tasks blocked in pthread_cond_wait, oldest first. */
     } pthread_cond_internal_t;
 
 /**
@@ -92,8 +93,7 @@
     ( ( ( pthread_cond_internal_t )         \
     {                                       \
         .xIsInitialized = pdFALSE,          \
-        .xCondWaitSemaphore = { { 0 } },    \
-        .iWaitingThreads = 0                \
+        .xWaiterList = { 0 }                \
     }                                       \
         )                                   \
     )
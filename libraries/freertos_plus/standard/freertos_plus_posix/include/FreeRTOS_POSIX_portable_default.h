@@ -49,6 +49,25 @@
 #endif
 /**@} */
 
+/**
+ * @name Lock non-recursive pthread mutexes with atomic operations.
+ *
+ * When set to 1, an uncontended lock or unlock of a PTHREAD_MUTEX_NORMAL or
+ * PTHREAD_MUTEX_ERRORCHECK mutex is a single atomic operation. Contended tasks
+ * block on a binary semaphore instead of a FreeRTOS mutex.
+ *
+ * @warning With this option, NORMAL and ERRORCHECK mutexes lose FreeRTOS
+ * priority inheritance: a low priority task holding such a mutex is not raised
+ * to the priority of a higher priority task waiting for it. Only enable it when
+ * no task of a different priority contends for these mutexes, or when priority
+ * inversion is acceptable. Recursive mutexes are not affected.
+ */
+/**@{ */
+#ifndef posixconfigPTHREAD_MUTEX_FAST_PATH
+    #define posixconfigPTHREAD_MUTEX_FAST_PATH    0 /**< Use atomic operations for non-recursive mutexes. */
+#endif
+/**@} */
+
 /**
  * @name Defaults for POSIX message queue implementation.
  */
@@ -60,6 +79,10 @@
 #ifndef posixconfigMQ_MAX_SIZE
     #define posixconfigMQ_MAX_SIZE    128 /**< Maximum size (in bytes) of each message. */
 #endif
+
+#ifndef posixconfigMQ_MAX_QUEUES
+    #define posixconfigMQ_MAX_QUEUES    16 /**< Maximum number of mqs that can exist at one time, at most 254. */
+#endif
 /**@} */
 
 /**
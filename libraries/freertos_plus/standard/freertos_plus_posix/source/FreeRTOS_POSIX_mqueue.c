@@ -29,6 +29,7 @@
  */
 
 /* C standard library includes. */
+#include <stdint.h>
 #include <string.h>
 
 /* FreeRTOS+POSIX includes. */
@@ -38,6 +39,32 @@
 #include "FreeRTOS_POSIX/mqueue.h"
 #include "FreeRTOS_POSIX/utils.h"
 
+#include "atomic.h"
+
+/**
+ * @defgroup Layout of message queue descriptors.
+ *
+ * An mqd_t holds the index of its descriptor slot plus one in its low byte and
+ * the generation of that slot in the next 16 bits. The state word of a slot
+ * holds the current generation in its upper 16 bits and the number of
+ * references to the queue in its lower 16 bits.
+ */
+/**@{ */
+#define posixMQ_DESCRIPTOR_INDEX_MASK    ( ( uintptr_t ) 0xFF ) /**< Bits of an mqd_t holding the slot index. */
+#define posixMQ_DESCRIPTOR_GEN_SHIFT     ( 8 )                  /**< Position of the generation in an mqd_t. */
+#define posixMQ_DESCRIPTOR_BITS          ( 24 )                 /**< Number of bits used by a valid mqd_t. */
+#define posixMQ_STATE_GEN_SHIFT          ( 16 )                 /**< Position of the generation in a slot state. */
+#define posixMQ_STATE_REFERENCE_MASK     ( 0xFFFFUL )           /**< Bits of a slot state holding the reference count. */
+#define posixMQ_GENERATION_MASK          ( 0xFFFFUL )           /**< Mask of a generation number. */
+
+#define posixMQ_STATE_GENERATION( ulState )    ( ( ulState ) >> posixMQ_STATE_GEN_SHIFT )     /**< Generation of a slot state. */
+#define posixMQ_STATE_REFERENCES( ulState )    ( ( ulState ) & posixMQ_STATE_REFERENCE_MASK ) /**< Reference count of a slot state. */
+/**@} */
+
+#if ( posixconfigMQ_MAX_QUEUES < 1 ) || ( posixconfigMQ_MAX_QUEUES > 254 )
+    #error "posixconfigMQ_MAX_QUEUES must be between 1 and 254."
+#endif
+
 /**
  * @brief Element of the FreeRTOS queues that store mq data.
  */
@@ -52,19 +79,67 @@ typedef struct QueueElement
  *
  * FreeRTOS isn't guaranteed to have a file-like abstraction, so message
  * queues in this implementation are stored as a linked list (in RAM).
+ *
+ * The messages of a queue are stored in a slab of mq_maxmsg buffers of
+ * mq_msgsize bytes allocated together with the queue. Buffers not holding a
+ * message are kept in xFreeBuffers; a sender takes a buffer from xFreeBuffers,
+ * copies the message into it and posts it to xQueue. A receiver copies the
+ * message out and returns the buffer to xFreeBuffers.
  */
 typedef struct QueueListElement
 {
-    Link_t xLink;              /**< Pointer to the next element in the list. */
-    QueueHandle_t xQueue;      /**< FreeRTOS queue handle. */
-    size_t xOpenDescriptors;   /**< Number of threads that have opened this queue. */
-    char * pcName;             /**< Null-terminated queue name. */
-    struct mq_attr xAttr;      /**< Queue attibutes. */
-    BaseType_t xPendingUnlink; /**< If pdTRUE, this queue will be unlinked once all descriptors close. */
+    Link_t xLink;               /**< Pointer to the next element in the list. */
+    QueueHandle_t xQueue;       /**< FreeRTOS queue handle. */
+    QueueHandle_t xFreeBuffers; /**< FreeRTOS queue of unused message buffers. */
+    size_t xOpenDescriptors;    /**< Number of threads that have opened this queue. */
+    char * pcName;              /**< Null-terminated queue name. */
+    struct mq_attr xAttr;       /**< Queue attibutes. */
+    BaseType_t xPendingUnlink;  /**< If pdTRUE, this queue will be unlinked once all descriptors close. */
+    size_t xSlotIndex;          /**< Index of the descriptor slot of this queue. */
+    mqd_t xDescriptor;          /**< Descriptor returned by mq_open for this queue. */
 } QueueListElement_t;
 
+/**
+ * @brief Descriptor slot of an mq.
+ *
+ * A descriptor is valid while its generation matches the generation of its
+ * slot. Unlinking a queue advances the generation, so stale descriptors are
+ * rejected even after the slot is given to another queue. Calls that use a
+ * queue hold a reference in ulState; the queue is freed when the last
+ * reference is released.
+ */
+typedef struct MessageQueueSlot
+{
+    volatile uint32_t ulState;                    /**< Generation and reference count. Only updated atomically. */
+    QueueListElement_t * volatile pxMessageQueue; /**< Queue using this slot, NULL if the slot is free. */
+} MessageQueueSlot_t;
+
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Look up the queue referenced by a descriptor and take a reference
+ * to it.
+ *
+ * Does not take xQueueListMutex.
+ *
+ * @param[in] xMessageQueueDescriptor The descriptor to look up.
+ *
+ * @return The queue, or NULL if xMessageQueueDescriptor is not valid.
+ */
+static QueueListElement_t * prvAcquireMessageQueue( mqd_t xMessageQueueDescriptor );
+
+/**
+ * @brief Give a free descriptor slot to a new queue.
+ *
+ * Must be called with xQueueListMutex held. The queue starts with one
+ * reference, held by the queue list.
+ *
+ * @param[in] pxMessageQueue The new queue.
+ *
+ * @return pdTRUE if a slot was found; pdFALSE otherwise.
+ */
+static BaseType_t prvAllocateDescriptor( QueueListElement_t * pxMessageQueue );
+
 /**
  * @brief Convert an absolute timespec into a tick timeout, taking into account
  * queue flags.
@@ -105,18 +180,15 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
 static void prvDeleteMessageQueue( const QueueListElement_t * const pxMessageQueue );
 
 /**
- * @brief Attempt to find the queue identified by pcName or xMqId in the queue list.
+ * @brief Attempt to find the queue identified by pcName in the queue list.
  *
- * Matches queues by pcName first; if pcName is NULL, matches by xMqId.
  * @param[out] ppxQueueListElement Output parameter set when queue is found.
  * @param[in] pcName A queue name to match.
- * @param[in] xMessageQueueDescriptor A queue descriptor to match.
  *
  * @return pdTRUE if the queue is found; pdFALSE otherwise.
  */
 static BaseType_t prvFindQueueInList( QueueListElement_t ** const ppxQueueListElement,
-                                      const char * const pcName,
-                                      mqd_t xMessageQueueDescriptor );
+                                      const char * const pcName );
 
 /**
  * @brief Initialize the queue list.
@@ -127,6 +199,29 @@ static BaseType_t prvFindQueueInList( QueueListElement_t ** const ppxQueueListEl
  */
 static void prvInitializeQueueList( void );
 
+/**
+ * @brief Invalidate all descriptors of a queue.
+ *
+ * Must be called with xQueueListMutex held, when the queue is removed from
+ * the queue list. The reference held by the queue list must then be released
+ * with prvReleaseMessageQueue.
+ *
+ * @param[in] pxMessageQueue The queue being removed.
+ *
+ * @return nothing
+ */
+static void prvInvalidateDescriptor( const QueueListElement_t * const pxMessageQueue );
+
+/**
+ * @brief Release a reference to a queue, freeing the queue if it was the last
+ * one.
+ *
+ * @param[in] pxMessageQueue The queue to release.
+ *
+ * @return nothing
+ */
+static void prvReleaseMessageQueue( QueueListElement_t * pxMessageQueue );
+
 /**
  * @brief Checks that pcName is a valid name for a message queue.
  *
@@ -149,6 +244,88 @@ static StaticSemaphore_t xQueueListMutex = { { 0 }, .u = { 0 } };
  */
 static Link_t xQueueListHead = { 0 };
 
+/**
+ * @brief Descriptor slots of the message queues.
+ */
+static MessageQueueSlot_t xMessageQueueSlots[ posixconfigMQ_MAX_QUEUES ] = { { 0 } };
+
+/*-----------------------------------------------------------*/
+
+static QueueListElement_t * prvAcquireMessageQueue( mqd_t xMessageQueueDescriptor )
+{
+    uintptr_t uxDescriptor = ( uintptr_t ) xMessageQueueDescriptor;
+    size_t xSlotNumber = ( size_t ) ( uxDescriptor & posixMQ_DESCRIPTOR_INDEX_MASK );
+    uint32_t ulGeneration = ( uint32_t ) ( uxDescriptor >> posixMQ_DESCRIPTOR_GEN_SHIFT );
+    uint32_t ulState = 0;
+    MessageQueueSlot_t * pxSlot = NULL;
+    QueueListElement_t * pxMessageQueue = NULL;
+
+    /* Slot numbers start at 1, so NULL and ( mqd_t ) -1 are never valid. */
+    if( ( xSlotNumber != 0 ) &&
+        ( xSlotNumber <= posixconfigMQ_MAX_QUEUES ) &&
+        ( ( uxDescriptor >> posixMQ_DESCRIPTOR_BITS ) == 0 ) )
+    {
+        pxSlot = &xMessageQueueSlots[ xSlotNumber - 1 ];
+
+        for( ; ; )
+        {
+            ulState = pxSlot->ulState;
+
+            /* A slot with no references holds no queue. A slot whose generation
+             * moved on was unlinked since the descriptor was handed out. */
+            if( ( posixMQ_STATE_GENERATION( ulState ) != ulGeneration ) ||
+                ( posixMQ_STATE_REFERENCES( ulState ) == 0 ) )
+            {
+                break;
+            }
+
+            /* Take a reference, unless the state changed in the meantime. */
+            if( Atomic_CompareAndSwap_u32( &pxSlot->ulState,
+                                           ulState + 1,
+                                           ulState ) == ATOMIC_COMPARE_AND_SWAP_SUCCESS )
+            {
+                pxMessageQueue = pxSlot->pxMessageQueue;
+                break;
+            }
+        }
+    }
+
+    return pxMessageQueue;
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvAllocateDescriptor( QueueListElement_t * pxMessageQueue )
+{
+    BaseType_t xStatus = pdFALSE;
+    MessageQueueSlot_t * pxSlot = NULL;
+    size_t i = 0;
+
+    for( i = 0; i < posixconfigMQ_MAX_QUEUES; i++ )
+    {
+        pxSlot = &xMessageQueueSlots[ i ];
+
+        /* The queue of a slot is cleared once its last reference is gone, so
+         * nothing else uses a slot with no queue. */
+        if( pxSlot->pxMessageQueue == NULL )
+        {
+            pxSlot->pxMessageQueue = pxMessageQueue;
+            pxMessageQueue->xSlotIndex = i;
+            pxMessageQueue->xDescriptor =
+                ( mqd_t ) ( ( ( uintptr_t ) posixMQ_STATE_GENERATION( pxSlot->ulState ) << posixMQ_DESCRIPTOR_GEN_SHIFT ) |
+                            ( uintptr_t ) ( i + 1 ) );
+
+            /* Publish the queue with the reference held by the queue list. */
+            ( void ) Atomic_Increment_u32( &pxSlot->ulState );
+
+            xStatus = pdTRUE;
+            break;
+        }
+    }
+
+    return xStatus;
+}
+
 /*-----------------------------------------------------------*/
 
 static int prvCalculateTickTimeout( long lMessageQueueFlags,
@@ -206,16 +383,32 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
                                             size_t xNameLength )
 {
     BaseType_t xStatus = pdTRUE;
-
-    /* Allocate space for a new queue element. */
-    *ppxMessageQueue = pvPortMalloc( sizeof( QueueListElement_t ) );
-
-    /* Check that memory allocation succeeded. */
-    if( *ppxMessageQueue == NULL )
+    size_t xMessageSize = ( size_t ) pxAttr->mq_msgsize;
+    size_t xMaxMessages = ( size_t ) pxAttr->mq_maxmsg;
+    size_t xHeaderSize = sizeof( QueueListElement_t ) + xNameLength + 1;
+    char * pcMessageSlab = NULL;
+    size_t i = 0;
+
+    /* Check that the queue element, its name and its message slab fit in a
+     * single allocation. */
+    if( xMessageSize > ( SIZE_MAX - xHeaderSize ) / xMaxMessages )
     {
         xStatus = pdFALSE;
     }
 
+    /* Allocate space for a new queue element, followed by the message slab
+     * and the queue name plus null-terminator. */
+    if( xStatus == pdTRUE )
+    {
+        *ppxMessageQueue = pvPortMalloc( xHeaderSize + ( xMaxMessages * xMessageSize ) );
+
+        /* Check that memory allocation succeeded. */
+        if( *ppxMessageQueue == NULL )
+        {
+            xStatus = pdFALSE;
+        }
+    }
+
     /* Create the FreeRTOS queue. */
     if( xStatus == pdTRUE )
     {
@@ -230,28 +423,51 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
         }
     }
 
+    /* Create the FreeRTOS queue of free message buffers. */
     if( xStatus == pdTRUE )
     {
-        /* Allocate space for the queue name plus null-terminator. */
-        ( *ppxMessageQueue )->pcName = pvPortMalloc( xNameLength + 1 );
+        ( *ppxMessageQueue )->xFreeBuffers =
+            xQueueCreate( pxAttr->mq_maxmsg, sizeof( char * ) );
 
-        /* Check that memory was successfully allocated for queue name. */
-        if( ( *ppxMessageQueue )->pcName == NULL )
+        /* Check that queue creation succeeded. */
+        if( ( *ppxMessageQueue )->xFreeBuffers == NULL )
         {
             vQueueDelete( ( *ppxMessageQueue )->xQueue );
             vPortFree( *ppxMessageQueue );
             xStatus = pdFALSE;
         }
-        else
+    }
+
+    /* Reserve a descriptor slot for the queue. */
+    if( xStatus == pdTRUE )
+    {
+        if( prvAllocateDescriptor( *ppxMessageQueue ) == pdFALSE )
         {
-            /* Copy queue name. Copying xNameLength+1 will cause strncpy to add
-             * the null-terminator. */
-            ( void ) strncpy( ( *ppxMessageQueue )->pcName, pcName, xNameLength + 1 );
+            vQueueDelete( ( *ppxMessageQueue )->xFreeBuffers );
+            vQueueDelete( ( *ppxMessageQueue )->xQueue );
+            vPortFree( *ppxMessageQueue );
+            xStatus = pdFALSE;
         }
     }
 
     if( xStatus == pdTRUE )
     {
+        /* Every message buffer starts out free. Sending to xFreeBuffers does not
+         * block because it has room for all of them. */
+        pcMessageSlab = ( char * ) ( *ppxMessageQueue + 1 );
+
+        for( i = 0; i < xMaxMessages; i++ )
+        {
+            char * pcMessageBuffer = pcMessageSlab + ( i * xMessageSize );
+
+            ( void ) xQueueSend( ( *ppxMessageQueue )->xFreeBuffers, &pcMessageBuffer, 0 );
+        }
+
+        /* Copy queue name. Copying xNameLength+1 will cause strncpy to add
+         * the null-terminator. */
+        ( *ppxMessageQueue )->pcName = pcMessageSlab + ( xMaxMessages * xMessageSize );
+        ( void ) strncpy( ( *ppxMessageQueue )->pcName, pcName, xNameLength + 1 );
+
         /* Copy attributes. */
         ( *ppxMessageQueue )->xAttr = *pxAttr;
 
@@ -272,28 +488,17 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
 
 static void prvDeleteMessageQueue( const QueueListElement_t * const pxMessageQueue )
 {
-    QueueElement_t xQueueElement = { 0 };
-
-    /* Free all data in the queue. It's assumed that no more data will be added
-     * to the queue, so xQueueReceive does not block. */
-    while( xQueueReceive( pxMessageQueue->xQueue,
-                          ( void * ) &xQueueElement,
-                          0 ) == pdTRUE )
-    {
-        vPortFree( xQueueElement.pcData );
-    }
-
-    /* Free memory used by this message queue. */
+    /* Free memory used by this message queue. Message buffers are part of the
+     * queue element, so messages still in the queue need no cleanup. */
     vQueueDelete( pxMessageQueue->xQueue );
-    vPortFree( ( void * ) pxMessageQueue->pcName );
+    vQueueDelete( pxMessageQueue->xFreeBuffers );
     vPortFree( ( void * ) pxMessageQueue );
 }
 
 /*-----------------------------------------------------------*/
 
 static BaseType_t prvFindQueueInList( QueueListElement_t ** const ppxQueueListElement,
-                                      const char * const pcName,
-                                      mqd_t xMessageQueueDescriptor )
+                                      const char * const pcName )
 {
     Link_t * pxQueueListLink = NULL;
     QueueListElement_t * pxMessageQueue = NULL;
@@ -304,21 +509,12 @@ static BaseType_t prvFindQueueInList( QueueListElement_t ** const ppxQueueListEl
     {
         pxMessageQueue = listCONTAINER( pxQueueListLink, QueueListElement_t, xLink );
 
-        /* Match by name first if provided. */
-        if( ( pcName != NULL ) && ( strcmp( pxMessageQueue->pcName, pcName ) == 0 ) )
+        /* Match by name. */
+        if( strcmp( pxMessageQueue->pcName, pcName ) == 0 )
         {
             xQueueFound = pdTRUE;
             break;
         }
-        /* If name doesn't match, match by descriptor. */
-        else
-        {
-            if( ( mqd_t ) pxMessageQueue == xMessageQueueDescriptor )
-            {
-                xQueueFound = pdTRUE;
-                break;
-            }
-        }
     }
 
     /* If the queue was found, set the output parameter. */
@@ -362,6 +558,39 @@ static void prvInitializeQueueList( void )
 
 /*-----------------------------------------------------------*/
 
+static void prvInvalidateDescriptor( const QueueListElement_t * const pxMessageQueue )
+{
+    MessageQueueSlot_t * pxSlot = &xMessageQueueSlots[ pxMessageQueue->xSlotIndex ];
+    uint32_t ulState = 0, ulNewState = 0;
+
+    /* Advance the generation, keeping the references of calls in progress. */
+    do
+    {
+        ulState = pxSlot->ulState;
+        ulNewState = ( ( ( posixMQ_STATE_GENERATION( ulState ) + 1 ) & posixMQ_GENERATION_MASK ) << posixMQ_STATE_GEN_SHIFT ) |
+                     posixMQ_STATE_REFERENCES( ulState );
+    } while( Atomic_CompareAndSwap_u32( &pxSlot->ulState,
+                                        ulNewState,
+                                        ulState ) != ATOMIC_COMPARE_AND_SWAP_SUCCESS );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvReleaseMessageQueue( QueueListElement_t * pxMessageQueue )
+{
+    MessageQueueSlot_t * pxSlot = &xMessageQueueSlots[ pxMessageQueue->xSlotIndex ];
+
+    /* The last reference is released after the queue was unlinked, so nothing
+     * else can reach the queue. Free the slot, then the queue. */
+    if( posixMQ_STATE_REFERENCES( Atomic_Decrement_u32( &pxSlot->ulState ) ) == 1 )
+    {
+        pxSlot->pxMessageQueue = NULL;
+        prvDeleteMessageQueue( pxMessageQueue );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 static BaseType_t prvValidateQueueName( const char * const pcName,
                                         size_t * pxNameLength )
 {
@@ -398,7 +627,7 @@ static BaseType_t prvValidateQueueName( const char * const pcName,
 int mq_close( mqd_t mqdes )
 {
     int iStatus = 0;
-    QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
+    QueueListElement_t * pxMessageQueue = NULL;
     BaseType_t xQueueRemoved = pdFALSE;
 
     /* Initialize the queue list, if needed. */
@@ -408,8 +637,12 @@ int mq_close( mqd_t mqdes )
      * never fail because it blocks forever. */
     ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
 
-    /* Attempt to find the message queue based on the given descriptor. */
-    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdTRUE )
+    /* Attempt to find the message queue based on the given descriptor.
+     * Descriptors are only invalidated with xQueueListMutex held, so the
+     * queue stays in the list until the mutex is released. */
+    pxMessageQueue = prvAcquireMessageQueue( mqdes );
+
+    if( pxMessageQueue != NULL )
     {
         /* Decrement the number of open descriptors. */
         if( pxMessageQueue->xOpenDescriptors > 0 )
@@ -425,6 +658,7 @@ int mq_close( mqd_t mqdes )
             if( pxMessageQueue->xPendingUnlink == pdTRUE )
             {
                 listREMOVE( &pxMessageQueue->xLink );
+                prvInvalidateDescriptor( pxMessageQueue );
 
                 /* Set the flag to delete the queue. Deleting the queue is deferred
                  * until xQueueListMutex is released. */
@@ -447,10 +681,16 @@ int mq_close( mqd_t mqdes )
     /* Release the mutex protecting the queue list. */
     ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
 
-    /* Delete all resources used by the queue if needed. */
-    if( xQueueRemoved == pdTRUE )
+    if( pxMessageQueue != NULL )
     {
-        prvDeleteMessageQueue( pxMessageQueue );
+        /* Release the reference held by the queue list if the queue was
+         * removed. The queue is deleted once the last call using it is done. */
+        if( xQueueRemoved == pdTRUE )
+        {
+            prvReleaseMessageQueue( pxMessageQueue );
+        }
+
+        prvReleaseMessageQueue( pxMessageQueue );
     }
 
     return iStatus;
@@ -462,19 +702,17 @@ int mq_getattr( mqd_t mqdes,
                 struct mq_attr * mqstat )
 {
     int iStatus = 0;
-    QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
-
-    /* Lock the mutex that guards access to the queue list. This call will
-     * never fail because it blocks forever. */
-    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
+    QueueListElement_t * pxMessageQueue = prvAcquireMessageQueue( mqdes );
 
     /* Find the mq referenced by mqdes. */
-    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdTRUE )
+    if( pxMessageQueue != NULL )
     {
-        /* Update the number of messages in the queue and copy the attributes
-         * into mqstat. */
-        pxMessageQueue->xAttr.mq_curmsgs = ( long ) uxQueueMessagesWaiting( pxMessageQueue->xQueue );
+        /* Copy the attributes into mqstat, with the current number of
+         * messages in the queue. */
         *mqstat = pxMessageQueue->xAttr;
+        mqstat->mq_curmsgs = ( long ) uxQueueMessagesWaiting( pxMessageQueue->xQueue );
+
+        prvReleaseMessageQueue( pxMessageQueue );
     }
     else
     {
@@ -483,9 +721,6 @@ int mq_getattr( mqd_t mqdes,
         iStatus = -1;
     }
 
-    /* Release the mutex protecting the queue list. */
-    ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
-
     return iStatus;
 }
 
@@ -497,6 +732,7 @@ mqd_t mq_open( const char * name,
                struct mq_attr * attr )
 {
     mqd_t xMessageQueue = NULL;
+    QueueListElement_t * pxMessageQueue = NULL;
     size_t xNameLength = 0;
 
     /* Default mq_attr. */
@@ -540,9 +776,7 @@ mqd_t mq_open( const char * name,
         ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
 
         /* Search the queue list to check if the queue exists. */
-        if( prvFindQueueInList( ( QueueListElement_t ** ) &xMessageQueue,
-                                name,
-                                ( mqd_t ) NULL ) == pdTRUE )
+        if( prvFindQueueInList( &pxMessageQueue, name ) == pdTRUE )
         {
             /* If the mq exists, check that this function wasn't called with
              * O_CREAT and O_EXCL. */
@@ -554,7 +788,7 @@ mqd_t mq_open( const char * name,
             else
             {
                 /* Check if the mq has been unlinked and is pending removal. */
-                if( ( ( QueueListElement_t * ) xMessageQueue )->xPendingUnlink == pdTRUE )
+                if( pxMessageQueue->xPendingUnlink == pdTRUE )
                 {
                     /* Queue pending deletion. Don't allow it to be re-opened. */
                     errno = EINVAL;
@@ -563,7 +797,8 @@ mqd_t mq_open( const char * name,
                 else
                 {
                     /* Increase count of open file descriptors for queue. */
-                    ( ( QueueListElement_t * ) xMessageQueue )->xOpenDescriptors++;
+                    pxMessageQueue->xOpenDescriptors++;
+                    xMessageQueue = pxMessageQueue->xDescriptor;
                 }
             }
         }
@@ -583,7 +818,7 @@ mqd_t mq_open( const char * name,
                 xQueueCreationAttr.mq_flags = ( long ) oflag;
 
                 /* Create the new message queue. */
-                if( prvCreateNewMessageQueue( ( QueueListElement_t ** ) &xMessageQueue,
+                if( prvCreateNewMessageQueue( &pxMessageQueue,
                                               &xQueueCreationAttr,
                                               name,
                                               xNameLength ) == pdFALSE )
@@ -591,6 +826,10 @@ mqd_t mq_open( const char * name,
                     errno = ENOSPC;
                     xMessageQueue = ( mqd_t ) -1;
                 }
+                else
+                {
+                    xMessageQueue = pxMessageQueue->xDescriptor;
+                }
             }
             else
             {
@@ -637,18 +876,17 @@ ssize_t mq_timedreceive( mqd_t mqdes,
     ssize_t xStatus = 0;
     int iCalculateTimeoutReturn = 0;
     TickType_t xTimeoutTicks = 0;
-    QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
+    QueueListElement_t * pxMessageQueue = NULL;
     QueueElement_t xReceiveData = { 0 };
 
     /* Silence warnings about unused parameters. */
     ( void ) msg_prio;
 
-    /* Lock the mutex that guards access to the queue list. This call will
-     * never fail because it blocks forever. */
-    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
+    /* Find the mq referenced by mqdes. The reference taken here keeps the
+     * queue alive until this function returns. */
+    pxMessageQueue = prvAcquireMessageQueue( mqdes );
 
-    /* Find the mq referenced by mqdes. */
-    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdFALSE )
+    if( pxMessageQueue == NULL )
     {
         /* Queue not found; bad descriptor. */
         errno = EBADF;
@@ -680,9 +918,6 @@ ssize_t mq_timedreceive( mqd_t mqdes,
         }
     }
 
-    /* Release the mutex protecting the queue list. */
-    ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
-
     if( xStatus == 0 )
     {
         /* Receive data from the FreeRTOS queue. */
@@ -711,9 +946,16 @@ ssize_t mq_timedreceive( mqd_t mqdes,
         /* Get the length of data for return value. */
         xStatus = ( ssize_t ) xReceiveData.xDataSize;
 
-        /* Copy received data into given buffer, then free it. */
+        /* Copy received data into given buffer, then give the message buffer
+         * back to the queue. xFreeBuffers has room for every buffer, so this
+         * does not block. */
         ( void ) memcpy( msg_ptr, xReceiveData.pcData, xReceiveData.xDataSize );
-        vPortFree( xReceiveData.pcData );
+        ( void ) xQueueSend( pxMessageQueue->xFreeBuffers, &xReceiveData.pcData, 0 );
+    }
+
+    if( pxMessageQueue != NULL )
+    {
+        prvReleaseMessageQueue( pxMessageQueue );
     }
 
     return xStatus;
@@ -729,18 +971,17 @@ int mq_timedsend( mqd_t mqdes,
 {
     int iStatus = 0, iCalculateTimeoutReturn = 0;
     TickType_t xTimeoutTicks = 0;
-    QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
+    QueueListElement_t * pxMessageQueue = NULL;
     QueueElement_t xSendData = { 0 };
 
     /* Silence warnings about unused parameters. */
     ( void ) msg_prio;
 
-    /* Lock the mutex that guards access to the queue list. This call will
-     * never fail because it blocks forever. */
-    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
+    /* Find the mq referenced by mqdes. The reference taken here keeps the
+     * queue alive until this function returns. */
+    pxMessageQueue = prvAcquireMessageQueue( mqdes );
 
-    /* Find the mq referenced by mqdes. */
-    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdFALSE )
+    if( pxMessageQueue == NULL )
     {
         /* Queue not found; bad descriptor. */
         errno = EBADF;
@@ -772,37 +1013,15 @@ int mq_timedsend( mqd_t mqdes,
         }
     }
 
-    /* Release the mutex protecting the queue list. */
-    ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
-
-    /* Allocate memory for the message. */
-    if( iStatus == 0 )
-    {
-        xSendData.xDataSize = msg_len;
-        xSendData.pcData = pvPortMalloc( msg_len );
-
-        /* Check that memory allocation succeeded. */
-        if( xSendData.pcData == NULL )
-        {
-            /* msg_len too large. */
-            errno = EMSGSIZE;
-            iStatus = -1;
-        }
-        else
-        {
-            /* Copy the data to send. */
-            ( void ) memcpy( xSendData.pcData, msg_ptr, msg_len );
-        }
-    }
-
+    /* Wait for a free message buffer. There is one buffer per message the
+     * queue can hold, so this blocks while the queue is full. */
     if( iStatus == 0 )
     {
-        /* Send data to the FreeRTOS queue. */
-        if( xQueueSend( pxMessageQueue->xQueue,
-                        &xSendData,
-                        xTimeoutTicks ) == pdFALSE )
+        if( xQueueReceive( pxMessageQueue->xFreeBuffers,
+                           &xSendData.pcData,
+                           xTimeoutTicks ) == pdFALSE )
         {
-            /* If queue send fails, set the appropriate errno. */
+            /* If no buffer became free, set the appropriate errno. */
             if( pxMessageQueue->xAttr.mq_flags & O_NONBLOCK )
             {
                 /* Set errno to EAGAIN for nonblocking mq. */
@@ -814,13 +1033,25 @@ int mq_timedsend( mqd_t mqdes,
                 errno = ETIMEDOUT;
             }
 
-            /* Free the allocated queue data. */
-            vPortFree( xSendData.pcData );
-
             iStatus = -1;
         }
     }
 
+    if( iStatus == 0 )
+    {
+        /* Copy the data to send, then send it to the FreeRTOS queue. Holding
+         * a buffer guarantees a free entry in the queue, so this does not
+         * block. */
+        xSendData.xDataSize = msg_len;
+        ( void ) memcpy( xSendData.pcData, msg_ptr, msg_len );
+        ( void ) xQueueSend( pxMessageQueue->xQueue, &xSendData, 0 );
+    }
+
+    if( pxMessageQueue != NULL )
+    {
+        prvReleaseMessageQueue( pxMessageQueue );
+    }
+
     return iStatus;
 }
 
@@ -851,13 +1082,14 @@ int mq_unlink( const char * name )
         ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
 
         /* Check if the named queue exists. */
-        if( prvFindQueueInList( &pxMessageQueue, name, ( mqd_t ) NULL ) == pdTRUE )
+        if( prvFindQueueInList( &pxMessageQueue, name ) == pdTRUE )
         {
             /* If the queue exists and there are no open descriptors to it,
              * remove it from the list. */
             if( pxMessageQueue->xOpenDescriptors == 0 )
             {
                 listREMOVE( &pxMessageQueue->xLink );
+                prvInvalidateDescriptor( pxMessageQueue );
 
                 /* Set the flag to delete the queue. Deleting the queue is deferred
                  * until xQueueListMutex is released. */
@@ -881,10 +1113,11 @@ int mq_unlink( const char * name )
         ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
     }
 
-    /* Delete all resources used by the queue if needed. */
+    /* Release the reference held by the queue list if needed. The queue is
+     * deleted once the last call using it is done. */
     if( xQueueRemoved == pdTRUE )
     {
-        prvDeleteMessageQueue( pxMessageQueue );
+        prvReleaseMessageQueue( pxMessageQueue );
     }
 
     return iStatus;
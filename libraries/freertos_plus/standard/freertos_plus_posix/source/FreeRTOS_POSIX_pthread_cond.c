@@ -29,7 +29,7 @@
  */
 
 /* C standard library includes. */
-#include <limits.h>
+#include <stddef.h>
 
 /* FreeRTOS+POSIX includes. */
 #include "FreeRTOS_POSIX.h"
@@ -37,7 +37,22 @@
 #include "FreeRTOS_POSIX/pthread.h"
 #include "FreeRTOS_POSIX/utils.h"
 
-#include "atomic.h"
+/**
+ * @brief A task blocked in pthread_cond_timedwait.
+ *
+ * Waiters live on the stack of the waiting task and are linked into the
+ * waiter list of the condition variable. The waiter list is only modified
+ * with the scheduler suspended. A waiter is woken by giving its own binary
+ * semaphore after being removed from the list and marked signaled, so a task
+ * that starts waiting after a broadcast can't take the wake up of an earlier
+ * waiter. The task notification value of the waiting task is not used.
+ */
+typedef struct CondWaiter
+{
+    Link_t xLink;                  /**< Link in the waiter list of the condition variable. */
+    StaticSemaphore_t xWakeUp;     /**< Binary semaphore given when the waiter is signaled. */
+    volatile BaseType_t xSignaled; /**< Set to pdTRUE when the waiter is removed from the list by a signal or broadcast. */
+} CondWaiter_t;
 
 /**
  * @brief Initialize a PTHREAD_COND_INITIALIZER cond.
@@ -50,6 +65,17 @@
  */
 static void prvInitializeStaticCond( pthread_cond_internal_t * pxCond );
 
+/**
+ * @brief Remove the oldest waiter from the waiter list and wake it.
+ *
+ * Must be called with the scheduler suspended.
+ *
+ * @param[in] pxCond The cond to signal.
+ *
+ * @return pdTRUE if a waiter was woken; pdFALSE if there were no waiters.
+ */
+static BaseType_t prvWakeWaiter( pthread_cond_internal_t * pxCond );
+
 /*-----------------------------------------------------------*/
 
 static void prvInitializeStaticCond( pthread_cond_internal_t * pxCond )
@@ -66,11 +92,9 @@ static void prvInitializeStaticCond( pthread_cond_internal_t * pxCond )
          * section. */
         if( pxCond->xIsInitialized == pdFALSE )
         {
-            /* Set the members of the cond. The semaphore create calls will never fail
-             * when their arguments aren't NULL. */
+            /* Set the members of the cond. */
+            listINIT_HEAD( &pxCond->xWaiterList );
             pxCond->xIsInitialized = pdTRUE;
-            ( void ) xSemaphoreCreateCountingStatic( INT_MAX, 0U, &pxCond->xCondWaitSemaphore );
-            pxCond->iWaitingThreads = 0;
         }
 
         /* Exit the critical section. */
@@ -78,59 +102,55 @@ static void prvInitializeStaticCond( pthread_cond_internal_t * pxCond )
     }
 }
 
-/**
- * @brief Check "atomically" if iLocalWaitingThreads == pxCond->iWaitingThreads and decrement.
- */
-static void prvTestAndDecrement( pthread_cond_t * pxCond,
-                                 unsigned iLocalWaitingThreads )
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvWakeWaiter( pthread_cond_internal_t * pxCond )
 {
-    /* Test local copy of threads waiting is larger than zero. */
-    while( iLocalWaitingThreads > 0 )
-    {
-        /* Test-and-set. Atomically check whether the copy in memory has changed.
-         * And, if not decrease the copy of threads waiting in memory. */
-        if( ATOMIC_COMPARE_AND_SWAP_SUCCESS == Atomic_CompareAndSwap_u32( ( uint32_t * ) &pxCond->iWaitingThreads, ( uint32_t ) iLocalWaitingThreads - 1, ( uint32_t ) iLocalWaitingThreads ) )
-        {
-            /* Signal one succeeded. Break. */
-            break;
-        }
+    BaseType_t xWoken = pdFALSE;
+    Link_t * pxLink = NULL;
+    CondWaiter_t * pxWaiter = NULL;
+
+    listPOP( &pxCond->xWaiterList, pxLink );
 
-        /* Local copy may be out dated. Reload, and retry. */
-        iLocalWaitingThreads = pxCond->iWaitingThreads;
+    if( pxLink != NULL )
+    {
+        pxWaiter = listCONTAINER( pxLink, CondWaiter_t, xLink );
+
+        /* The waiter returns, releasing its stack, once it sees xSignaled.
+         * The scheduler is suspended, so it can't run before its semaphore
+         * is given. */
+        pxWaiter->xSignaled = pdTRUE;
+        ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxWaiter->xWakeUp );
+        xWoken = pdTRUE;
     }
+
+    return xWoken;
 }
 
 /*-----------------------------------------------------------*/
 
 int pthread_cond_broadcast( pthread_cond_t * cond )
 {
-    unsigned i = 0;
     pthread_cond_internal_t * pxCond = ( pthread_cond_internal_t * ) ( cond );
 
     /* If the cond is uninitialized, perform initialization. */
     prvInitializeStaticCond( pxCond );
 
-    /* Local copy of number of threads waiting. */
-    unsigned iLocalWaitingThreads = pxCond->iWaitingThreads;
-
-    /* Test local copy of threads waiting is larger than zero. */
-    while( iLocalWaitingThreads > 0 )
+    /* Waiters add themselves before unlocking the mutex, so a broadcast with
+     * no waiters doesn't need to suspend the scheduler. */
+    if( !listIS_EMPTY( &pxCond->xWaiterList ) )
     {
-        /* Test-and-set. Atomically check whether the copy in memory has changed.
-         * And, if not set the copy of threads waiting in memory to zero. */
-        if( ATOMIC_COMPARE_AND_SWAP_SUCCESS == Atomic_CompareAndSwap_u32( ( uint32_t * ) &pxCond->iWaitingThreads, 0, ( uint32_t ) iLocalWaitingThreads ) )
-        {
-            /* Unblock all. */
-            for( i = 0; i < iLocalWaitingThreads; i++ )
-            {
-                ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxCond->xCondWaitSemaphore );
-            }
+        /* Wake all waiters within a single scheduler suspension. This still
+         * gives one semaphore per waiter, so a broadcast costs O(n) in the
+         * number of waiters; the woken tasks are made ready together when the
+         * scheduler is resumed. */
+        vTaskSuspendAll();
 
-            break;
+        while( prvWakeWaiter( pxCond ) == pdTRUE )
+        {
         }
 
-        /* Local copy is out dated. Reload, and retry. */
-        iLocalWaitingThreads = pxCond->iWaitingThreads;
+        ( void ) xTaskResumeAll();
     }
 
     return 0;
@@ -140,10 +160,8 @@ int pthread_cond_broadcast( pthread_cond_t * cond )
 
 int pthread_cond_destroy( pthread_cond_t * cond )
 {
-    pthread_cond_internal_t * pxCond = ( pthread_cond_internal_t * ) ( cond );
-
-    /* Free all resources in use by the cond. */
-    vSemaphoreDelete( ( SemaphoreHandle_t ) &pxCond->xCondWaitSemaphore );
+    /* A cond doesn't hold any resources. */
+    ( void ) cond;
 
     return 0;
 }
@@ -166,12 +184,9 @@ int pthread_cond_init( pthread_cond_t * cond,
 
     if( iStatus == 0 )
     {
-        /* Set the members of the cond. The semaphore create calls will never fail
-         * when their arguments aren't NULL. */
+        /* Set the members of the cond. */
+        listINIT_HEAD( &pxCond->xWaiterList );
         pxCond->xIsInitialized = pdTRUE;
-
-        ( void ) xSemaphoreCreateCountingStatic( INT_MAX, 0U, &pxCond->xCondWaitSemaphore );
-        pxCond->iWaitingThreads = 0;
     }
 
     return iStatus;
@@ -186,25 +201,11 @@ int pthread_cond_signal( pthread_cond_t * cond )
     /* If the cond is uninitialized, perform initialization. */
     prvInitializeStaticCond( pxCond );
 
-    /* Local copy of number of threads waiting. */
-    unsigned iLocalWaitingThreads = pxCond->iWaitingThreads;
-
-    /* Test local copy of threads waiting is larger than zero. */
-    while( iLocalWaitingThreads > 0 )
+    if( !listIS_EMPTY( &pxCond->xWaiterList ) )
     {
-        /* Test-and-set. Atomically check whether the copy in memory has changed.
-         * And, if not decrease the copy of threads waiting in memory. */
-        if( ATOMIC_COMPARE_AND_SWAP_SUCCESS == Atomic_CompareAndSwap_u32( ( uint32_t * ) &pxCond->iWaitingThreads, ( uint32_t ) iLocalWaitingThreads - 1, ( uint32_t ) iLocalWaitingThreads ) )
-        {
-            /* Unblock one. */
-            ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxCond->xCondWaitSemaphore );
-
-            /* Signal one succeeded. Break. */
-            break;
-        }
-
-        /* Local copy may be out dated. Reload, and retry. */
-        iLocalWaitingThreads = pxCond->iWaitingThreads;
+        vTaskSuspendAll();
+        ( void ) prvWakeWaiter( pxCond );
+        ( void ) xTaskResumeAll();
     }
 
     return 0;
@@ -216,10 +217,11 @@ int pthread_cond_timedwait( pthread_cond_t * cond,
                             pthread_mutex_t * mutex,
                             const struct timespec * abstime )
 {
-    unsigned iLocalWaitingThreads;
     int iStatus = 0;
     pthread_cond_internal_t * pxCond = ( pthread_cond_internal_t * ) ( cond );
     TickType_t xDelay = portMAX_DELAY;
+    TimeOut_t xTimeOut = { 0 };
+    CondWaiter_t xWaiter = { 0 };
 
     /* If the cond is uninitialized, perform initialization. */
     prvInitializeStaticCond( pxCond );
@@ -240,47 +242,61 @@ int pthread_cond_timedwait( pthread_cond_t * cond,
         }
     }
 
-    /* Increase the counter of threads blocking on condition variable, then
-     * unlock mutex. */
+    /* Join the end of the waiter list, then unlock mutex. Joining first
+     * ensures a signal sent after the mutex is unlocked finds this task. */
     if( iStatus == 0 )
     {
-        /* Atomically increments thread waiting by 1, and
-         * stores number of threads waiting before increment. */
-        iLocalWaitingThreads = Atomic_Increment_u32( ( uint32_t * ) &pxCond->iWaitingThreads );
+        ( void ) xSemaphoreCreateBinaryStatic( &xWaiter.xWakeUp );
+        xWaiter.xSignaled = pdFALSE;
+        vTaskSetTimeOutState( &xTimeOut );
+
+        vTaskSuspendAll();
+        listADD( pxCond->xWaiterList.pxPrev, &xWaiter.xLink );
+        ( void ) xTaskResumeAll();
 
         iStatus = pthread_mutex_unlock( mutex );
-    }
 
-    /* Wait on the condition variable. */
-    if( iStatus == 0 )
-    {
-        if( xSemaphoreTake( ( SemaphoreHandle_t ) &pxCond->xCondWaitSemaphore,
-                            xDelay ) == pdPASS )
+        /* Wait for a signal. The semaphore belongs to this wait only, so it is
+         * given at most once and only by the signal that removed this task. */
+        if( iStatus == 0 )
+        {
+            while( ( xWaiter.xSignaled == pdFALSE ) &&
+                   ( xTaskCheckForTimeOut( &xTimeOut, &xDelay ) == pdFALSE ) )
+            {
+                ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xWaiter.xWakeUp, xDelay );
+            }
+        }
+
+        /* Leave the waiter list, unless a signal already removed this task.
+         * A waiter signaled at the same time as its timeout expired consumed
+         * the signal, so it reports success. */
+        vTaskSuspendAll();
+
+        if( xWaiter.xSignaled == pdFALSE )
+        {
+            listREMOVE( &xWaiter.xLink );
+
+            if( iStatus == 0 )
+            {
+                iStatus = ETIMEDOUT;
+            }
+        }
+
+        ( void ) xTaskResumeAll();
+
+        /* No signal can reach this waiter any more. */
+        vSemaphoreDelete( ( SemaphoreHandle_t ) &xWaiter.xWakeUp );
+
+        /* Relock mutex if it was unlocked. */
+        if( iStatus == 0 )
         {
-            /* When successful, relock mutex. */
             iStatus = pthread_mutex_lock( mutex );
         }
-        else
+        else if( iStatus == ETIMEDOUT )
         {
-            /* Timeout. Relock mutex and decrement number of waiting threads. */
-            iStatus = ETIMEDOUT;
             ( void ) pthread_mutex_lock( mutex );
-
-            /* Atomically decrements thread waiting by 1.
-             * If iLocalWaitingThreads is updated by other thread(s) in between,
-             * this implementation guarantees to decrement by 1 based on the
-             * value currently in pxCond->iWaitingThreads. */
-            prvTestAndDecrement( pxCond, iLocalWaitingThreads + 1 );
         }
     }
-    else
-    {
-        /* Atomically decrements thread waiting by 1.
-         * If iLocalWaitingThreads is updated by other thread(s) in between,
-         * this implementation guarantees to decrement by 1 based on the
-         * value currently in pxCond->iWaitingThreads. */
-        prvTestAndDecrement( pxCond, iLocalWaitingThreads + 1 );
-    }
 
     return iStatus;
 }
@@ -30,6 +30,7 @@
 
 /* C standard library includes. */
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 /* FreeRTOS+POSIX includes. */
@@ -38,6 +39,37 @@
 #include "FreeRTOS_POSIX/pthread.h"
 #include "FreeRTOS_POSIX/utils.h"
 
+#include "atomic.h"
+
+/**
+ * @defgroup Lock state of mutexes taken with atomic operations.
+ *
+ * A locked mutex has pthreadMUTEX_LOCKED set. pthreadMUTEX_WAITERS is set when
+ * a task may be blocked on the semaphore of the mutex, in which case unlocking
+ * the mutex must give the semaphore.
+ */
+/**@{ */
+#define pthreadMUTEX_LOCKED     ( ( uint32_t ) 0x1 ) /**< The mutex is locked. */
+#define pthreadMUTEX_WAITERS    ( ( uint32_t ) 0x2 ) /**< Tasks may be waiting for the mutex. */
+/**@} */
+
+/**
+ * @brief Whether a mutex is locked through its lock state rather than with a
+ * FreeRTOS mutex.
+ */
+#define pthreadMUTEX_USES_LOCK_STATE( pxMutex )          \
+    ( ( posixconfigPTHREAD_MUTEX_FAST_PATH == 1 ) &&      \
+      ( ( pxMutex )->xAttr.iType != PTHREAD_MUTEX_RECURSIVE ) )
+
+/**
+ * @brief Create the FreeRTOS object backing a mutex, based on the mutex type.
+ *
+ * @param[in] pxMutex The mutex, with its attributes set.
+ *
+ * @return nothing
+ */
+static void prvCreateMutexSemaphore( pthread_mutex_internal_t * pxMutex );
+
 /**
  * @brief Initialize a PTHREAD_MUTEX_INITIALIZER mutex.
  *
@@ -49,6 +81,20 @@
  */
 static void prvInitializeStaticMutex( pthread_mutex_internal_t * pxMutex );
 
+/**
+ * @brief Lock a mutex through its lock state.
+ *
+ * Tasks that find the mutex locked mark it contended and block on its
+ * semaphore until it is unlocked or xDelay expires.
+ *
+ * @param[in] pxMutex The mutex to lock.
+ * @param[in] xDelay Maximum number of ticks to wait.
+ *
+ * @return 0 if the mutex was locked; ETIMEDOUT otherwise.
+ */
+static int prvLockMutexState( pthread_mutex_internal_t * pxMutex,
+                              TickType_t xDelay );
+
 /**
  * @brief Default pthread_mutexattr_t.
  */
@@ -59,6 +105,28 @@ static const pthread_mutexattr_internal_t xDefaultMutexAttributes =
 
 /*-----------------------------------------------------------*/
 
+static void prvCreateMutexSemaphore( pthread_mutex_internal_t * pxMutex )
+{
+    if( pxMutex->xAttr.iType == PTHREAD_MUTEX_RECURSIVE )
+    {
+        /* Recursive mutex. */
+        ( void ) xSemaphoreCreateRecursiveMutexStatic( &pxMutex->xMutex );
+    }
+    else if( pthreadMUTEX_USES_LOCK_STATE( pxMutex ) )
+    {
+        /* The lock state holds the mutex; contended tasks wait on an empty
+         * binary semaphore. */
+        ( void ) xSemaphoreCreateBinaryStatic( &pxMutex->xMutex );
+    }
+    else
+    {
+        /* All other mutex types. */
+        ( void ) xSemaphoreCreateMutexStatic( &pxMutex->xMutex );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 static void prvInitializeStaticMutex( pthread_mutex_internal_t * pxMutex )
 {
     /* Check if the mutex needs to be initialized. */
@@ -78,11 +146,7 @@ static void prvInitializeStaticMutex( pthread_mutex_internal_t * pxMutex )
 
             /* Call the correct FreeRTOS mutex initialization function based on
              * the mutex type. */
-            #if PTHREAD_MUTEX_DEFAULT == PTHREAD_MUTEX_RECURSIVE
-                ( void ) xSemaphoreCreateRecursiveMutexStatic( &pxMutex->xMutex );
-            #else
-                ( void ) xSemaphoreCreateMutexStatic( &pxMutex->xMutex );
-            #endif
+            prvCreateMutexSemaphore( pxMutex );
 
             pxMutex->xIsInitialized = pdTRUE;
         }
@@ -94,6 +158,60 @@ static void prvInitializeStaticMutex( pthread_mutex_internal_t * pxMutex )
 
 /*-----------------------------------------------------------*/
 
+static int prvLockMutexState( pthread_mutex_internal_t * pxMutex,
+                              TickType_t xDelay )
+{
+    int iStatus = 0;
+    uint32_t ulPreviousState = 0;
+    TimeOut_t xTimeOut = { 0 };
+
+    /* An unlocked mutex is taken with a single compare-and-swap. The lock
+     * state is either 0, locked, or locked with waiters, so a failed
+     * compare-and-swap means the mutex is held. */
+    if( Atomic_CompareAndSwap_u32( &pxMutex->ulLockState,
+                                   pthreadMUTEX_LOCKED,
+                                   0 ) != ATOMIC_COMPARE_AND_SWAP_SUCCESS )
+    {
+        /* Don't mark the mutex contended if not waiting for it. */
+        if( xDelay == 0 )
+        {
+            iStatus = ETIMEDOUT;
+        }
+        else
+        {
+            vTaskSetTimeOutState( &xTimeOut );
+
+            for( ; ; )
+            {
+                /* Mark the mutex contended so that the owner gives the
+                 * semaphore when unlocking it. If the mutex was unlocked in
+                 * the meantime, this takes it. The waiters flag is kept set
+                 * because other tasks may still be blocked. */
+                ulPreviousState = Atomic_OR_u32( &pxMutex->ulLockState,
+                                                 pthreadMUTEX_LOCKED | pthreadMUTEX_WAITERS );
+
+                if( ( ulPreviousState & pthreadMUTEX_LOCKED ) == 0 )
+                {
+                    break;
+                }
+
+                /* Only give up after checking the lock state, so that a task
+                 * woken by an unlock doesn't swallow the wake up. */
+                if( ( xTaskCheckForTimeOut( &xTimeOut, &xDelay ) == pdTRUE ) ||
+                    ( xSemaphoreTake( ( SemaphoreHandle_t ) &pxMutex->xMutex, xDelay ) == pdFALSE ) )
+                {
+                    iStatus = ETIMEDOUT;
+                    break;
+                }
+            }
+        }
+    }
+
+    return iStatus;
+}
+
+/*-----------------------------------------------------------*/
+
 int pthread_mutex_destroy( pthread_mutex_t * mutex )
 {
     pthread_mutex_internal_t * pxMutex = ( pthread_mutex_internal_t * ) ( mutex );
@@ -137,16 +255,7 @@ int pthread_mutex_init( pthread_mutex_t * mutex,
         }
 
         /* Call the correct FreeRTOS mutex creation function based on mutex type. */
-        if( pxMutex->xAttr.iType == PTHREAD_MUTEX_RECURSIVE )
-        {
-            /* Recursive mutex. */
-            ( void ) xSemaphoreCreateRecursiveMutexStatic( &pxMutex->xMutex );
-        }
-        else
-        {
-            /* All other mutex types. */
-            ( void ) xSemaphoreCreateMutexStatic( &pxMutex->xMutex );
-        }
+        prvCreateMutexSemaphore( pxMutex );
 
         /* Ensure that the FreeRTOS mutex was successfully created. */
         if( ( SemaphoreHandle_t ) &pxMutex->xMutex == NULL )
@@ -220,7 +329,16 @@ int pthread_mutex_timedlock( pthread_mutex_t * mutex,
         iStatus = EDEADLK;
     }
 
-    if( iStatus == 0 )
+    if( ( iStatus == 0 ) && pthreadMUTEX_USES_LOCK_STATE( pxMutex ) )
+    {
+        iStatus = prvLockMutexState( pxMutex, xDelay );
+
+        if( iStatus == 0 )
+        {
+            pxMutex->xTaskOwner = xTaskGetCurrentTaskHandle();
+        }
+    }
+    else if( iStatus == 0 )
     {
         /* Call the correct FreeRTOS mutex take function based on mutex type. */
         if( pxMutex->xAttr.iType == PTHREAD_MUTEX_RECURSIVE )
@@ -289,7 +407,19 @@ int pthread_mutex_unlock( pthread_mutex_t * mutex )
         iStatus = EPERM;
     }
 
-    if( iStatus == 0 )
+    if( ( iStatus == 0 ) && pthreadMUTEX_USES_LOCK_STATE( pxMutex ) )
+    {
+        /* Clear the owner before releasing the lock state, so that the next
+         * owner's update isn't overwritten. Wake one waiter if the mutex was
+         * contended. */
+        pxMutex->xTaskOwner = NULL;
+
+        if( ( Atomic_AND_u32( &pxMutex->ulLockState, 0 ) & pthreadMUTEX_WAITERS ) != 0 )
+        {
+            ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &pxMutex->xMutex );
+        }
+    }
+    else if( iStatus == 0 )
     {
         /* Suspend the scheduler so that
          * mutex is unlocked AND owner is updated atomically */
@@ -36,6 +36,7 @@
 #include "FreeRTOS_POSIX/errno.h"
 #include "FreeRTOS_POSIX/fcntl.h"
 #include "FreeRTOS_POSIX/mqueue.h"
+#include "FreeRTOS_POSIX/pthread.h"
 
 /* Test framework includes. */
 #include "unity.h"
@@ -53,6 +54,15 @@
 #define posixtestMQ_DEFAULT_MODE          0600                                     /**< Default mode argument for mq_open. */
 /**@} */
 
+/**
+ * @defgroup Configuration constants for the message queue throughput test.
+ */
+/**@{ */
+#define posixtestMQ_THROUGHPUT_MESSAGES           ( 10000 ) /**< Number of messages passed between the threads. */
+#define posixtestMQ_THROUGHPUT_MESSAGE_SIZE       ( 32 )    /**< Size of each message, in bytes. */
+#define posixtestMQ_THROUGHPUT_TIMEOUT_SECONDS    ( 10 )    /**< Time allowed for sending all messages. */
+/**@} */
+
 /* Default queue attributes used in these tests. */
 struct mq_attr xDefaultQueueAttr =
 {
@@ -64,6 +74,40 @@ struct mq_attr xDefaultQueueAttr =
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Sends posixtestMQ_THROUGHPUT_MESSAGES messages to the queue passed
+ * in pvArgs.
+ *
+ * @return ( void * ) 1 if all messages were sent; NULL otherwise.
+ */
+static void * prvThroughputSenderThread( void * pvArgs )
+{
+    int i = 0;
+    mqd_t xMqId = *( ( mqd_t * ) pvArgs );
+    char pcMessage[ posixtestMQ_THROUGHPUT_MESSAGE_SIZE ] = { 0 };
+    struct timespec xTimeout = { 0 };
+
+    /* Give up if the receiver stops, so that the test can always join this
+     * thread. */
+    ( void ) clock_gettime( CLOCK_REALTIME, &xTimeout );
+    xTimeout.tv_sec += posixtestMQ_THROUGHPUT_TIMEOUT_SECONDS;
+
+    for( i = 0; i < posixtestMQ_THROUGHPUT_MESSAGES; i++ )
+    {
+        /* Tag each message with its sequence number. */
+        ( void ) memcpy( pcMessage, &i, sizeof( i ) );
+
+        if( mq_timedsend( xMqId, pcMessage, sizeof( pcMessage ), 0, &xTimeout ) != 0 )
+        {
+            break;
+        }
+    }
+
+    return ( void * ) ( intptr_t ) ( i == posixtestMQ_THROUGHPUT_MESSAGES );
+}
+
+/*-----------------------------------------------------------*/
+
 TEST_GROUP( Full_POSIX_MQUEUE );
 
 /*-----------------------------------------------------------*/
@@ -93,6 +137,8 @@ TEST_GROUP_RUNNER( Full_POSIX_MQUEUE )
     RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_send_receive );
     /*RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_send_receive_invalidParams ); */
     RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_send_receive_nonblock );
+    RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_stale_descriptor );
+    RUN_TEST_CASE( Full_POSIX_MQUEUE, mq_send_receive_throughput );
 }
 
 /*-----------------------------------------------------------*/
@@ -550,3 +596,119 @@ TEST( Full_POSIX_MQUEUE, mq_send_receive_nonblock )
 }
 
 /*-----------------------------------------------------------*/
+
+TEST( Full_POSIX_MQUEUE, mq_stale_descriptor )
+{
+    int iStatus = 0;
+    volatile mqd_t xMqId = posixtestMQ_INVALID_MQD, xMqId2 = posixtestMQ_INVALID_MQD;
+    struct mq_attr xQueueAttr = { 0 };
+
+    if( TEST_PROTECT() )
+    {
+        /* Create a queue, then close and unlink it. */
+        xMqId = mq_open( posixtestMQ_DEFAULT_NAME, O_CREAT | O_RDWR, posixtestMQ_DEFAULT_MODE, &xDefaultQueueAttr );
+        TEST_ASSERT_NOT_EQUAL( posixtestMQ_INVALID_MQD, xMqId );
+        TEST_ASSERT_EQUAL_INT( 0, mq_close( xMqId ) );
+        TEST_ASSERT_EQUAL_INT( 0, mq_unlink( posixtestMQ_DEFAULT_NAME ) );
+
+        /* Create a new queue with the same name. It may reuse the storage of
+         * the first queue, but must get a different descriptor. */
+        xMqId2 = mq_open( posixtestMQ_DEFAULT_NAME, O_CREAT | O_RDWR, posixtestMQ_DEFAULT_MODE, &xDefaultQueueAttr );
+        TEST_ASSERT_NOT_EQUAL( posixtestMQ_INVALID_MQD, xMqId2 );
+        TEST_ASSERT_NOT_EQUAL( xMqId, xMqId2 );
+
+        /* The descriptor of the first queue must not reach the new queue. */
+        iStatus = mq_send( xMqId, posixtestMQ_SMALL_MESSAGE, posixtestMQ_SMALL_MESSAGE_SIZE, 0 );
+        TEST_ASSERT_EQUAL_INT( -1, iStatus );
+        TEST_ASSERT_EQUAL_INT( EBADF, errno );
+
+        iStatus = mq_close( xMqId );
+        TEST_ASSERT_EQUAL_INT( -1, iStatus );
+        TEST_ASSERT_EQUAL_INT( EBADF, errno );
+
+        iStatus = mq_getattr( xMqId2, &xQueueAttr );
+        TEST_ASSERT_EQUAL_INT( 0, iStatus );
+        TEST_ASSERT_EQUAL_INT( 0, xQueueAttr.mq_curmsgs );
+    }
+
+    /* Clean up resources used by test. */
+    ( void ) mq_close( xMqId2 );
+    ( void ) mq_unlink( posixtestMQ_DEFAULT_NAME );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_POSIX_MQUEUE, mq_send_receive_throughput )
+{
+    int i = 0;
+    ssize_t xMessageSize = 0;
+    volatile mqd_t xMqId = posixtestMQ_INVALID_MQD;
+    mqd_t xSenderMqId = posixtestMQ_INVALID_MQD;
+    pthread_t xSenderThread;
+    BaseType_t xSenderCreated = pdFALSE;
+    void * pvSenderResult = NULL;
+    struct timespec xStartTime = { 0 }, xEndTime = { 0 };
+    int64_t llElapsedUs = 0;
+    char pcReceiveBuffer[ posixtestMQ_THROUGHPUT_MESSAGE_SIZE ] = { 0 };
+    struct mq_attr xQueueAttr =
+    {
+        .mq_flags   = 0,
+        .mq_maxmsg  = posixconfigMQ_MAX_MESSAGES,
+        .mq_msgsize = posixtestMQ_THROUGHPUT_MESSAGE_SIZE,
+        .mq_curmsgs = 0
+    };
+
+    if( TEST_PROTECT() )
+    {
+        xMqId = mq_open( posixtestMQ_DEFAULT_NAME, O_CREAT | O_RDWR, posixtestMQ_DEFAULT_MODE, &xQueueAttr );
+        TEST_ASSERT_NOT_EQUAL( posixtestMQ_INVALID_MQD, xMqId );
+        xSenderMqId = xMqId;
+
+        ( void ) clock_gettime( CLOCK_MONOTONIC, &xStartTime );
+
+        /* Pass messages from a sender thread to this thread. */
+        TEST_ASSERT_EQUAL_INT( 0, pthread_create( &xSenderThread, NULL, prvThroughputSenderThread, &xSenderMqId ) );
+        xSenderCreated = pdTRUE;
+
+        for( i = 0; i < posixtestMQ_THROUGHPUT_MESSAGES; i++ )
+        {
+            xMessageSize = mq_receive( xMqId, pcReceiveBuffer, sizeof( pcReceiveBuffer ), NULL );
+            TEST_ASSERT_EQUAL_INT( posixtestMQ_THROUGHPUT_MESSAGE_SIZE, xMessageSize );
+
+            /* Messages must arrive in order. */
+            TEST_ASSERT_EQUAL_MEMORY( &i, pcReceiveBuffer, sizeof( i ) );
+        }
+
+        ( void ) clock_gettime( CLOCK_MONOTONIC, &xEndTime );
+
+        ( void ) pthread_join( xSenderThread, &pvSenderResult );
+        xSenderCreated = pdFALSE;
+        TEST_ASSERT_EQUAL( ( void * ) 1, pvSenderResult );
+
+        llElapsedUs = ( int64_t ) ( xEndTime.tv_sec - xStartTime.tv_sec ) * 1000000LL;
+        llElapsedUs += ( int64_t ) ( xEndTime.tv_nsec - xStartTime.tv_nsec ) / 1000LL;
+
+        if( llElapsedUs <= 0 )
+        {
+            llElapsedUs = 1;
+        }
+
+        configPRINTF( ( "mqueue throughput: %d messages of %d bytes in %u us, %u msgs/s\r\n",
+                        posixtestMQ_THROUGHPUT_MESSAGES,
+                        posixtestMQ_THROUGHPUT_MESSAGE_SIZE,
+                        ( unsigned ) llElapsedUs,
+                        ( unsigned ) ( posixtestMQ_THROUGHPUT_MESSAGES * 1000000LL / llElapsedUs ) ) );
+    }
+
+    /* Clean up resources used by test. If an assert was triggered, the sender
+     * stops once the queue is gone or its timeout expires. */
+    ( void ) mq_close( xMqId );
+    ( void ) mq_unlink( posixtestMQ_DEFAULT_NAME );
+
+    if( xSenderCreated == pdTRUE )
+    {
+        ( void ) pthread_join( xSenderThread, NULL );
+    }
+}
+
+/*-----------------------------------------------------------*/
@@ -66,6 +66,22 @@
 #define posixtestMUTEX_STRESS_NUMBER_OF_THREADS    ( 12 ) /**< Number of mutex test threads. */
 /**@} */
 
+/**
+ * @defgroup Configuration constants for the mutex contention benchmark.
+ */
+/**@{ */
+#define posixtestMUTEX_BENCHMARK_ITERATIONS           ( 10000 ) /**< Lock and unlock pairs per thread. */
+#define posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS    ( 4 )     /**< Number of threads contending for the mutex. */
+/**@} */
+
+/**
+ * @defgroup Configuration constants for the condition variable benchmark.
+ */
+/**@{ */
+#define posixtestCOND_BENCHMARK_ROUNDS               ( 1000 ) /**< Number of broadcasts. */
+#define posixtestCOND_BENCHMARK_NUMBER_OF_THREADS    ( 4 )    /**< Number of threads woken by each broadcast. */
+/**@} */
+
 /**
  * @defgroup Configuration constants for the barrier stress test.
  */
@@ -92,6 +108,18 @@ typedef struct MutexTestThreadArgs
     pthread_mutex_t * pxMutex;       /**< Mutex which protects the shared variable. */
 } MutexTestThreadArgs_t;
 
+/**
+ * @brief The state shared by the condition variable benchmark threads.
+ */
+typedef struct CondBenchmarkArgs
+{
+    pthread_mutex_t xMutex;     /**< Mutex which protects the members below. */
+    pthread_cond_t xRoundCond;  /**< Broadcast when a new round starts. */
+    pthread_cond_t xDoneCond;   /**< Signaled when all threads finished a round. */
+    volatile int iRound;        /**< Current round. */
+    volatile int iThreadsDone;  /**< How many threads finished the current round. */
+} CondBenchmarkArgs_t;
+
 /**
  * @brief The arguments to all of the barrier test threads.
  */
@@ -275,6 +303,60 @@ static void * prvMutexTestThread( void * pvArgs )
 
 /*-----------------------------------------------------------*/
 
+static void * prvMutexBenchmarkThread( void * pvArgs )
+{
+    intptr_t iResult = 1;
+    int i = 0;
+    MutexTestThreadArgs_t * pxArgs = ( MutexTestThreadArgs_t * ) pvArgs;
+
+    for( i = 0; ( i < posixtestMUTEX_BENCHMARK_ITERATIONS ) && ( iResult == 1 ); i++ )
+    {
+        iResult = ( intptr_t ) ( pthread_mutex_lock( pxArgs->pxMutex ) == 0 );
+
+        if( iResult )
+        {
+            ( *( pxArgs->piSharedVariable ) )++;
+            iResult = ( intptr_t ) ( pthread_mutex_unlock( pxArgs->pxMutex ) == 0 );
+        }
+    }
+
+    return ( void * ) iResult;
+}
+
+/*-----------------------------------------------------------*/
+
+static void * prvCondBenchmarkThread( void * pvArgs )
+{
+    intptr_t iResult = 0;
+    int i = 0;
+    CondBenchmarkArgs_t * pxArgs = ( CondBenchmarkArgs_t * ) pvArgs;
+
+    iResult = ( intptr_t ) ( pthread_mutex_lock( &pxArgs->xMutex ) == 0 );
+
+    for( i = 1; ( i <= posixtestCOND_BENCHMARK_ROUNDS ) && ( iResult == 1 ); i++ )
+    {
+        /* Wait for round i to start. */
+        while( ( pxArgs->iRound < i ) && ( iResult == 1 ) )
+        {
+            iResult = ( intptr_t ) ( pthread_cond_wait( &pxArgs->xRoundCond, &pxArgs->xMutex ) == 0 );
+        }
+
+        /* The last thread to finish the round wakes the test thread. */
+        pxArgs->iThreadsDone++;
+
+        if( pxArgs->iThreadsDone == posixtestCOND_BENCHMARK_NUMBER_OF_THREADS )
+        {
+            ( void ) pthread_cond_signal( &pxArgs->xDoneCond );
+        }
+    }
+
+    ( void ) pthread_mutex_unlock( &pxArgs->xMutex );
+
+    return ( void * ) iResult;
+}
+
+/*-----------------------------------------------------------*/
+
 static void * prvBarrierTestThread( void * pvArgs )
 {
     intptr_t iResult = 0;
@@ -324,6 +406,8 @@ TEST_GROUP_RUNNER( Full_POSIX_STRESS )
     RUN_TEST_CASE( Full_POSIX_STRESS, mqueue );
     RUN_TEST_CASE( Full_POSIX_STRESS, pthread_mutex );
     RUN_TEST_CASE( Full_POSIX_STRESS, pthread_barrier_overflow );
+    RUN_TEST_CASE( Full_POSIX_STRESS, pthread_mutex_contention );
+    RUN_TEST_CASE( Full_POSIX_STRESS, pthread_cond_broadcast );
 }
 
 /*-----------------------------------------------------------*/
@@ -598,3 +682,131 @@ TEST( Full_POSIX_STRESS, pthread_barrier_overflow )
 }
 
 /*-----------------------------------------------------------*/
+
+TEST( Full_POSIX_STRESS, pthread_mutex_contention )
+{
+    int i = 0;
+    volatile int iSharedVariable = 0;
+    pthread_mutex_t xMutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_t xBenchmarkThreads[ posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS ] = { ( pthread_t ) NULL };
+    intptr_t xBenchmarkThreadStatus[ posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS ] = { 0 };
+    MutexTestThreadArgs_t xThreadArguments = { 0 };
+    TickType_t xStartTime = 0, xElapsedTicks = 0;
+
+    /* Set the arguments for the benchmark threads. */
+    xThreadArguments.piSharedVariable = &iSharedVariable;
+    xThreadArguments.pxMutex = &xMutex;
+
+    /* Measure lock and unlock pairs without contention. */
+    xStartTime = xTaskGetTickCount();
+    xBenchmarkThreadStatus[ 0 ] = ( intptr_t ) prvMutexBenchmarkThread( &xThreadArguments );
+    xElapsedTicks = xTaskGetTickCount() - xStartTime;
+
+    TEST_ASSERT_EQUAL_INT( 1, xBenchmarkThreadStatus[ 0 ] );
+    TEST_ASSERT_EQUAL_INT( posixtestMUTEX_BENCHMARK_ITERATIONS, iSharedVariable );
+
+    configPRINTF( ( "Uncontended mutex: %d lock/unlock pairs in %u ticks.\r\n",
+                    posixtestMUTEX_BENCHMARK_ITERATIONS,
+                    ( unsigned ) xElapsedTicks ) );
+
+    /* Measure the same pairs with several threads contending for the mutex. */
+    iSharedVariable = 0;
+    xStartTime = xTaskGetTickCount();
+
+    for( i = 0; i < posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS; i++ )
+    {
+        ( void ) pthread_create( &xBenchmarkThreads[ i ], NULL, prvMutexBenchmarkThread, &xThreadArguments );
+    }
+
+    for( i = 0; i < posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS; i++ )
+    {
+        if( xBenchmarkThreads[ i ] != ( pthread_t ) NULL )
+        {
+            ( void ) pthread_join( xBenchmarkThreads[ i ], ( void ** ) &xBenchmarkThreadStatus[ i ] );
+        }
+    }
+
+    xElapsedTicks = xTaskGetTickCount() - xStartTime;
+
+    configPRINTF( ( "Contended mutex: %d threads, %d lock/unlock pairs in %u ticks.\r\n",
+                    posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS,
+                    posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS * posixtestMUTEX_BENCHMARK_ITERATIONS,
+                    ( unsigned ) xElapsedTicks ) );
+
+    /* Check results. */
+    TEST_ASSERT_EQUAL_INT( posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS * posixtestMUTEX_BENCHMARK_ITERATIONS,
+                           iSharedVariable );
+
+    for( i = 0; i < posixtestMUTEX_BENCHMARK_NUMBER_OF_THREADS; i++ )
+    {
+        TEST_ASSERT_EQUAL_INT( 1, xBenchmarkThreadStatus[ i ] );
+    }
+
+    ( void ) pthread_mutex_destroy( &xMutex );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_POSIX_STRESS, pthread_cond_broadcast )
+{
+    int i = 0, iResult = 0;
+    pthread_t xBenchmarkThreads[ posixtestCOND_BENCHMARK_NUMBER_OF_THREADS ] = { ( pthread_t ) NULL };
+    intptr_t xBenchmarkThreadStatus[ posixtestCOND_BENCHMARK_NUMBER_OF_THREADS ] = { 0 };
+    CondBenchmarkArgs_t xThreadArguments = { 0 };
+    TickType_t xStartTime = 0, xElapsedTicks = 0;
+
+    TEST_ASSERT_EQUAL_INT( 0, pthread_mutex_init( &xThreadArguments.xMutex, NULL ) );
+    TEST_ASSERT_EQUAL_INT( 0, pthread_cond_init( &xThreadArguments.xRoundCond, NULL ) );
+    TEST_ASSERT_EQUAL_INT( 0, pthread_cond_init( &xThreadArguments.xDoneCond, NULL ) );
+
+    for( i = 0; i < posixtestCOND_BENCHMARK_NUMBER_OF_THREADS; i++ )
+    {
+        ( void ) pthread_create( &xBenchmarkThreads[ i ], NULL, prvCondBenchmarkThread, &xThreadArguments );
+    }
+
+    xStartTime = xTaskGetTickCount();
+    ( void ) pthread_mutex_lock( &xThreadArguments.xMutex );
+
+    /* Start each round with a broadcast and wait for every thread to see it. */
+    for( i = 1; ( i <= posixtestCOND_BENCHMARK_ROUNDS ) && ( iResult == 0 ); i++ )
+    {
+        xThreadArguments.iThreadsDone = 0;
+        xThreadArguments.iRound = i;
+        ( void ) pthread_cond_broadcast( &xThreadArguments.xRoundCond );
+
+        while( ( xThreadArguments.iThreadsDone < posixtestCOND_BENCHMARK_NUMBER_OF_THREADS ) && ( iResult == 0 ) )
+        {
+            iResult = pthread_cond_wait( &xThreadArguments.xDoneCond, &xThreadArguments.xMutex );
+        }
+    }
+
+    ( void ) pthread_mutex_unlock( &xThreadArguments.xMutex );
+    xElapsedTicks = xTaskGetTickCount() - xStartTime;
+
+    for( i = 0; i < posixtestCOND_BENCHMARK_NUMBER_OF_THREADS; i++ )
+    {
+        if( xBenchmarkThreads[ i ] != ( pthread_t ) NULL )
+        {
+            ( void ) pthread_join( xBenchmarkThreads[ i ], ( void ** ) &xBenchmarkThreadStatus[ i ] );
+        }
+    }
+
+    configPRINTF( ( "Condition variable: %d broadcasts to %d threads in %u ticks.\r\n",
+                    posixtestCOND_BENCHMARK_ROUNDS,
+                    posixtestCOND_BENCHMARK_NUMBER_OF_THREADS,
+                    ( unsigned ) xElapsedTicks ) );
+
+    /* Check results. */
+    TEST_ASSERT_EQUAL_INT( 0, iResult );
+
+    for( i = 0; i < posixtestCOND_BENCHMARK_NUMBER_OF_THREADS; i++ )
+    {
+        TEST_ASSERT_EQUAL_INT( 1, xBenchmarkThreadStatus[ i ] );
+    }
+
+    ( void ) pthread_cond_destroy( &xThreadArguments.xDoneCond );
+    ( void ) pthread_cond_destroy( &xThreadArguments.xRoundCond );
+    ( void ) pthread_mutex_destroy( &xThreadArguments.xMutex );
+}
+
+/*-----------------------------------------------------------*/
@@ -496,6 +496,119 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigZERO_COPY_RX_DRIVER		( 0 )
 #endif
 
+#ifndef ipconfigUSE_RX_BATCHING
+	/* When non-zero, the network driver may pass received frames with
+	xSendRxFrameToIPTask() instead of sending one eNetworkRxEvent per frame.
+	The frames are placed in a single-producer, single-consumer ring and the
+	IP-task will process up to ipconfigRX_BATCH_MAX_FRAMES of them each time
+	it wakes up.  Only one task or ISR may act as the producer. */
+	#define ipconfigUSE_RX_BATCHING			( 0 )
+#endif
+
+#if( ipconfigUSE_RX_BATCHING != 0 )
+	#ifndef ipconfigRX_BATCH_RING_LENGTH
+		/* Number of slots in the RX ring, must be a power of 2. */
+		#define ipconfigRX_BATCH_RING_LENGTH	( 32 )
+	#endif
+
+	#if( ( ipconfigRX_BATCH_RING_LENGTH & ( ipconfigRX_BATCH_RING_LENGTH - 1 ) ) != 0 )
+		#error ipconfigRX_BATCH_RING_LENGTH must be a power of 2
+	#endif
+
+	#ifndef ipconfigRX_BATCH_MAX_FRAMES
+		/* The maximum number of frames taken from the RX ring before the
+		IP-task looks at its event queue again. */
+		#define ipconfigRX_BATCH_MAX_FRAMES		( 8 )
+	#endif
+#endif /* ipconfigUSE_RX_BATCHING */
+
+#ifndef ipconfigUSE_TCP_RX_COALESCING
+	/* When non-zero, in-order TCP segments for the same connection that are
+	found within one batch of received frames are passed to the socket as a
+	single segment: the payloads are added to the RX stream one after the other
+	and a single ACK is prepared for all of them. */
+	#if( ipconfigUSE_TCP != 0 )
+		#define ipconfigUSE_TCP_RX_COALESCING	ipconfigUSE_RX_BATCHING
+	#else
+		#define ipconfigUSE_TCP_RX_COALESCING	( 0 )
+	#endif
+#endif
+
+#if( ( ipconfigUSE_TCP_RX_COALESCING != 0 ) && ( ( ipconfigUSE_RX_BATCHING == 0 ) || ( ipconfigUSE_TCP == 0 ) ) )
+	#error ipconfigUSE_TCP_RX_COALESCING requires ipconfigUSE_RX_BATCHING and ipconfigUSE_TCP
+#endif
+
+#ifndef ipconfigUSE_TCP_LARGE_SEND
+	/* When non-zero, a TCP socket that has several full-size segments ready
+	to be sent will take them from the sliding window in one go.  The first
+	segment is sent as usual, the following ones are cut from the TX stream and
+	get a copy of its headers, where only the sequence number, the lengths and
+	the checksums are updated. */
+	#define ipconfigUSE_TCP_LARGE_SEND		( 0 )
+#endif
+
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	#ifndef ipconfigTCP_LARGE_SEND_SEGMENTS
+		/* The maximum number of segments that are sent in one go. */
+		#define ipconfigTCP_LARGE_SEND_SEGMENTS	( 8 )
+	#endif
+
+	#if( ( ipconfigUSE_TCP == 0 ) || ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_LARGE_SEND requires ipconfigUSE_TCP and ipconfigUSE_TCP_WIN
+	#endif
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
+#ifndef ipconfigTCP_WIN_SEG_GROW_COUNT
+	/* When non-zero, the pool of TCP segment descriptors starts with
+	ipconfigTCP_WIN_SEG_COUNT descriptors, and grows by this number of
+	descriptors each time it runs empty.  The added descriptors are not
+	returned to the heap until vTCPSegmentCleanup() is called. */
+	#define ipconfigTCP_WIN_SEG_GROW_COUNT	( 0 )
+#endif
+
+#if( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 )
+	#ifndef ipconfigTCP_WIN_SEG_MAX_COUNT
+		/* The pool will not grow beyond this number of descriptors. */
+		#define ipconfigTCP_WIN_SEG_MAX_COUNT	( 4 * ipconfigTCP_WIN_SEG_COUNT )
+	#endif
+#endif /* ipconfigTCP_WIN_SEG_GROW_COUNT */
+
+#ifndef ipconfigUSE_TCP_RX_AUTOTUNE
+	/* When non-zero, the size of the reception buffer and window of a TCP
+	socket is tuned while it is connected.  Once every round-trip time, the
+	number of bytes received is compared with the window: when the peer was
+	limited by the window, the buffer is doubled, up to
+	ipconfigTCP_RX_AUTOTUNE_MAX_SIZE bytes.  When less than
+	ipconfigTCP_RX_AUTOTUNE_HEAP_RESERVE bytes of heap are left, it is halved
+	again.  A socket stops tuning as soon as FREERTOS_SO_RCVBUF,
+	FREERTOS_SO_WIN_PROPERTIES or FREERTOS_SO_SET_LOW_HIGH_WATER is used. */
+	#define ipconfigUSE_TCP_RX_AUTOTUNE		( 0 )
+#endif
+
+#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+	#ifndef ipconfigTCP_RX_AUTOTUNE_MAX_SIZE
+		/* The largest reception buffer that a socket may get.  The window
+		scale factor sent in the SYN is based on this size. */
+		#define ipconfigTCP_RX_AUTOTUNE_MAX_SIZE		( 64u * ipconfigTCP_MSS )
+	#endif
+
+	#ifndef ipconfigTCP_RX_AUTOTUNE_HEAP_RESERVE
+		/* The number of bytes that must remain free on the heap after a
+		reception buffer has grown. */
+		#define ipconfigTCP_RX_AUTOTUNE_HEAP_RESERVE	( 16u * 1024u )
+	#endif
+
+	#ifndef ipconfigTCP_RX_AUTOTUNE_FREE_HEAP
+		/* Returns the number of free bytes on the heap used by
+		pvPortMallocLarge(). */
+		#define ipconfigTCP_RX_AUTOTUNE_FREE_HEAP()	xPortGetFreeHeapSize()
+	#endif
+
+	#if( ( ipconfigUSE_TCP == 0 ) || ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_RX_AUTOTUNE requires ipconfigUSE_TCP and ipconfigUSE_TCP_WIN
+	#endif
+#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+
 #ifndef ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM
 	#define ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM 0
 #endif
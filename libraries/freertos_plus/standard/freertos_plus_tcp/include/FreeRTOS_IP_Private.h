@@ -419,6 +419,23 @@ BaseType_t FreeRTOS_ReleaseFreeNetworkBufferFromISR( void );
 void FreeRTOS_NetworkDown( void );
 BaseType_t FreeRTOS_NetworkDownFromISR( void );
 
+#if( ipconfigUSE_RX_BATCHING != 0 )
+	/*
+	 * Pass a received frame to the IP-task through the RX ring, as an
+	 * alternative to sending an eNetworkRxEvent for every frame.  The IP-task
+	 * is only woken up when the ring was drained since the last call.  pdFAIL
+	 * is returned when the ring is full, in which case the caller still owns
+	 * the network buffer.
+	 *
+	 * The ring has a single producer: all calls must be made from the same
+	 * task, or from the same ISR using the FromISR() version.  If
+	 * xSendRxFrameToIPTaskFromISR() sets *pxHigherPriorityTaskWoken then a
+	 * context switch should be performed before the interrupt is exited.
+	 */
+	BaseType_t xSendRxFrameToIPTask( NetworkBufferDescriptor_t *pxNetworkBuffer );
+	BaseType_t xSendRxFrameToIPTaskFromISR( NetworkBufferDescriptor_t *pxNetworkBuffer, BaseType_t *pxHigherPriorityTaskWoken );
+#endif /* ipconfigUSE_RX_BATCHING */
+
 /*
  * Processes incoming ARP packets.
  */
@@ -532,6 +549,9 @@ BaseType_t xIPIsNetworkTaskReady( void );
 				bFinLast : 1,		/* The last ACK (after FIN and FIN+ACK) has been sent or will be sent by the peer */
 				bRxStopped : 1,		/* Application asked to temporarily stop reception */
 				bMallocError : 1,	/* There was an error allocating a stream */
+				#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+					bRxAutoTune : 1,	/* The size of the reception buffer and window is tuned at runtime */
+				#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
 				bWinScaling : 1;	/* A TCP-Window Scaling option was offered and accepted in the SYN phase. */
 		} bits;
 		uint32_t ulHighestRxAllowed;
@@ -562,6 +582,26 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		#if( ipconfigUSE_TCP_WIN == 1 )
 			NetworkBufferDescriptor_t *pxAckMessage;
 		#endif /* ipconfigUSE_TCP_WIN */
+		#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+			/* Set by prvTCPPrepareSend() when it took more than one segment:
+			the number of bytes that follow the first segment, the length of
+			each segment, and the offset of the remaining bytes in txStream. */
+			uint32_t ulLargeSendLength;
+			uint32_t ulLargeSendSegment;
+			size_t uxLargeSendOffset;
+		#endif /* ipconfigUSE_TCP_LARGE_SEND */
+		#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+			/* The round-trip time measured during the handshake, the start of
+			the current measurement and the value of rx.ulCurrentSequenceNumber
+			at that moment, and the size of rxStream that the IP-task will
+			install as soon as the stream is empty.  The stream that it replaced
+			is freed by the next call to FreeRTOS_recv(). */
+			TickType_t xAutoTuneRTT;
+			TickType_t xAutoTuneTime;
+			uint32_t ulAutoTuneSequence;
+			size_t uxAutoTuneSize;
+			StreamBuffer_t *pxRxStreamOld;
+		#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
 		/* Buffer space to store the last TCP header received. */
 		LastTCPPacket_t xPacket;
 		uint8_t tcpflags;		/* TCP flags */
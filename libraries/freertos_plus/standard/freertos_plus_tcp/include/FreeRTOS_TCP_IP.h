@@ -32,6 +32,22 @@ extern "C" {
 
 BaseType_t xProcessReceivedTCPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer );
 
+#if( ipconfigUSE_TCP_RX_COALESCING != 0 )
+	/*
+	 * Called by the IP-task, for a TCP packet that is part of a batch of
+	 * received frames.  The packet is either held, to be passed to the socket
+	 * together with the in-order segments that follow it, or it is processed
+	 * immediately.  Returns pdPASS if the network buffer has been consumed.
+	 */
+	BaseType_t xCoalesceReceivedTCPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * Process the TCP segments that are being held by
+	 * xCoalesceReceivedTCPPacket().  Must be called at the end of every batch.
+	 */
+	void vTCPFlushCoalescedPackets( void );
+#endif /* ipconfigUSE_TCP_RX_COALESCING */
+
 typedef enum eTCP_STATE {
 	/* Comments about the TCP states are borrowed from the very useful
 	 * Wiki page:
@@ -157,6 +157,10 @@ void vTCPWindowInit( TCPWindow_t *pxWindow, uint32_t ulAckNumber, uint32_t ulSeq
 /* Clean up allocated segments. Should only be called when FreeRTOS+TCP will no longer be used. */
 void vTCPSegmentCleanup( void );
 
+/* Returns the number of descriptors in the segment pool.  When 'puxFree' is
+ * not NULL, the number of descriptors that are not in use is stored in it. */
+UBaseType_t uxTCPSegmentPoolSize( UBaseType_t *puxFree );
+
 /*=============================================================================
  *
  * Rx functions
@@ -199,6 +203,14 @@ BaseType_t xTCPWindowTxDone( TCPWindow_t *pxWindow );
  * apPos will point to a location with the circular data buffer: txStream */
 uint32_t ulTCPWindowTxGet( TCPWindow_t *pxWindow, uint32_t ulWindowSize, int32_t *plPosition );
 
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	/* Like ulTCPWindowTxGet(), but it may also take up to 'uxMaxSegments - 1'
+	 * new segments that follow the first one.  Returns the total length of the
+	 * run, and stores the length of its first segment in 'pulSegmentLength'. */
+	uint32_t ulTCPWindowTxGetRun( TCPWindow_t *pxWindow, uint32_t ulWindowSize, int32_t *plPosition,
+		UBaseType_t uxMaxSegments, uint32_t *pulSegmentLength );
+#endif
+
 /* Receive a normal ACK */
 uint32_t ulTCPWindowTxAck( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber );
 
@@ -122,6 +122,14 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceNETWORK_EVENT_RECEIVED( eEvent )
 #endif
 
+#ifndef iptraceNETWORK_RX_BATCH
+	#define iptraceNETWORK_RX_BATCH( uxFrameCount )
+#endif
+
+#ifndef iptraceTCP_RX_COALESCED
+	#define iptraceTCP_RX_COALESCED( uxSegmentCount, ulByteCount )
+#endif
+
 #ifndef iptraceBIND_FAILED
 	#define iptraceBIND_FAILED( xSocket, usPort )
 #endif
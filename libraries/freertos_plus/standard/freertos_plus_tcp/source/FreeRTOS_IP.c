@@ -244,6 +244,19 @@ static void prvIPTimerReload( IPTimer_t *pxTimer, TickType_t xTime );
 static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPPacket,
 	NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength );
 
+#if( ipconfigUSE_RX_BATCHING != 0 )
+	/*
+	 * Take up to ipconfigRX_BATCH_MAX_FRAMES frames from the RX ring and
+	 * process them.
+	 */
+	static void prvProcessRxBatch( void );
+
+	/*
+	 * Add a frame to the RX ring, and see if the IP-task must be woken up.
+	 */
+	static BaseType_t prvRxRingPush( NetworkBufferDescriptor_t *pxNetworkBuffer, BaseType_t *pxMustWakeUp );
+#endif /* ipconfigUSE_RX_BATCHING */
+
 /*-----------------------------------------------------------*/
 
 /* The queue used to pass events into the IP-task for processing. */
@@ -311,6 +324,34 @@ static BaseType_t xIPTaskInitialised = pdFALSE;
 	static UBaseType_t uxQueueMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
 #endif
 
+#if( ipconfigUSE_RX_BATCHING != 0 )
+	/* The RX ring, written by the network driver and read by the IP-task.
+	uxRxRingHead is only changed by the driver, uxRxRingTail only by the
+	IP-task.  Both are free-running, the slot is found by masking. */
+	static NetworkBufferDescriptor_t * volatile pxRxRing[ ipconfigRX_BATCH_RING_LENGTH ];
+	static volatile UBaseType_t uxRxRingHead = 0u;
+	static volatile UBaseType_t uxRxRingTail = 0u;
+
+	/* Set by the driver when it has sent a wake-up event, cleared by the
+	IP-task before it starts draining the ring.  As long as it is set, there is
+	no need to send another event. */
+	static volatile BaseType_t xRxRingWakeUpPending = pdFALSE;
+
+	/* Set while prvProcessRxBatch() is processing frames. */
+	static BaseType_t xProcessingRxBatch = pdFALSE;
+
+	#define ipRX_RING_MASK				( ( UBaseType_t ) ipconfigRX_BATCH_RING_LENGTH - 1u )
+	#define ipRX_RING_IS_EMPTY()		( uxRxRingHead == uxRxRingTail )
+
+	/* On a single core, the volatile accesses are sufficient.  A port that
+	runs the producer on another core must supply a memory barrier. */
+	#ifdef portMEMORY_BARRIER
+		#define ipRX_RING_BARRIER()		portMEMORY_BARRIER()
+	#else
+		#define ipRX_RING_BARRIER()		do {} while( 0 )
+	#endif
+#endif /* ipconfigUSE_RX_BATCHING */
+
 /*-----------------------------------------------------------*/
 
 static void prvIPTask( void *pvParameters )
@@ -356,6 +397,17 @@ struct freertos_sockaddr xAddress;
 		/* Calculate the acceptable maximum sleep time. */
 		xNextIPSleep = prvCalculateSleepTime();
 
+		#if( ipconfigUSE_RX_BATCHING != 0 )
+		{
+			/* Frames are still waiting in the RX ring, only look at the event
+			queue without blocking. */
+			if( !ipRX_RING_IS_EMPTY() )
+			{
+				xNextIPSleep = ( TickType_t ) 0;
+			}
+		}
+		#endif /* ipconfigUSE_RX_BATCHING */
+
 		/* Wait until there is something to do. If the following call exits
 		 * due to a time out rather than a message being received, set a
 		 * 'NoEvent' value. */
@@ -392,8 +444,13 @@ struct freertos_sockaddr xAddress;
 			case eNetworkRxEvent:
 				/* The network hardware driver has received a new packet.  A
 				pointer to the received buffer is located in the pvData member
-				of the received event structure. */
-				prvHandleEthernetPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
+				of the received event structure.  When pvData is NULL, the
+				driver has placed frames in the RX ring, which will be drained
+				below. */
+				if( xReceivedEvent.pvData != NULL )
+				{
+					prvHandleEthernetPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
+				}
 				break;
 
 			case eNetworkTxEvent:
@@ -513,6 +570,18 @@ struct freertos_sockaddr xAddress;
 				break;
 		}
 
+		#if( ipconfigUSE_RX_BATCHING != 0 )
+		{
+			/* Whatever event has woken up this task, drain a batch of frames
+			from the RX ring.  The ring is checked after every event so that
+			a busy event queue can not starve the reception. */
+			if( !ipRX_RING_IS_EMPTY() || ( xRxRingWakeUpPending != pdFALSE ) )
+			{
+				prvProcessRxBatch();
+			}
+		}
+		#endif /* ipconfigUSE_RX_BATCHING */
+
 		if( xNetworkDownEventPending != pdFALSE )
 		{
 			/* A network down event could not be posted to the network event
@@ -577,6 +646,129 @@ static void prvHandleEthernetPacket( NetworkBufferDescriptor_t *pxBuffer )
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_RX_BATCHING != 0 )
+
+	static void prvProcessRxBatch( void )
+	{
+	NetworkBufferDescriptor_t *pxBuffer;
+	UBaseType_t uxTail, uxCount;
+
+		/* Clear the flag before looking at the ring: a frame that is added
+		after this point will cause a new wake-up event, a frame that was
+		added before it will be seen below. */
+		xRxRingWakeUpPending = pdFALSE;
+		ipRX_RING_BARRIER();
+
+		xProcessingRxBatch = pdTRUE;
+
+		uxTail = uxRxRingTail;
+		for( uxCount = 0u; uxCount < ( UBaseType_t ) ipconfigRX_BATCH_MAX_FRAMES; uxCount++ )
+		{
+			if( uxTail == uxRxRingHead )
+			{
+				break;
+			}
+
+			ipRX_RING_BARRIER();
+			pxBuffer = pxRxRing[ uxTail & ipRX_RING_MASK ];
+			uxTail++;
+
+			/* Give the slot back to the driver before the frame is
+			processed. */
+			uxRxRingTail = uxTail;
+
+			prvHandleEthernetPacket( pxBuffer );
+		}
+
+		#if( ipconfigUSE_TCP_RX_COALESCING != 0 )
+		{
+			/* Pass the TCP segments that were held back to their sockets. */
+			vTCPFlushCoalescedPackets();
+		}
+		#endif /* ipconfigUSE_TCP_RX_COALESCING */
+
+		xProcessingRxBatch = pdFALSE;
+
+		iptraceNETWORK_RX_BATCH( uxCount );
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvRxRingPush( NetworkBufferDescriptor_t *pxNetworkBuffer, BaseType_t *pxMustWakeUp )
+	{
+	UBaseType_t uxHead = uxRxRingHead;
+	BaseType_t xReturn;
+
+		*pxMustWakeUp = pdFALSE;
+
+		if( ( xIPIsNetworkTaskReady() == pdFALSE ) || ( ( uxHead - uxRxRingTail ) >= ( UBaseType_t ) ipconfigRX_BATCH_RING_LENGTH ) )
+		{
+			/* The IP-task is not running yet, or the ring is full. */
+			iptraceETHERNET_RX_EVENT_LOST();
+			xReturn = pdFAIL;
+		}
+		else
+		{
+			pxRxRing[ uxHead & ipRX_RING_MASK ] = pxNetworkBuffer;
+			ipRX_RING_BARRIER();
+			uxRxRingHead = uxHead + 1u;
+			ipRX_RING_BARRIER();
+
+			if( xRxRingWakeUpPending == pdFALSE )
+			{
+				xRxRingWakeUpPending = pdTRUE;
+				*pxMustWakeUp = pdTRUE;
+			}
+
+			xReturn = pdPASS;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xSendRxFrameToIPTask( NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	static const IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+	BaseType_t xReturn, xMustWakeUp;
+
+		xReturn = prvRxRingPush( pxNetworkBuffer, &xMustWakeUp );
+
+		if( xMustWakeUp != pdFALSE )
+		{
+			if( xQueueSendToBack( xNetworkEventQueue, &xRxEvent, ( TickType_t ) 0 ) != pdPASS )
+			{
+				/* The queue is full, so the IP-task is busy anyway and will
+				look at the ring after its next event.  Let the next frame try
+				again. */
+				xRxRingWakeUpPending = pdFALSE;
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xSendRxFrameToIPTaskFromISR( NetworkBufferDescriptor_t *pxNetworkBuffer, BaseType_t *pxHigherPriorityTaskWoken )
+	{
+	static const IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+	BaseType_t xReturn, xMustWakeUp;
+
+		xReturn = prvRxRingPush( pxNetworkBuffer, &xMustWakeUp );
+
+		if( xMustWakeUp != pdFALSE )
+		{
+			if( xQueueSendToBackFromISR( xNetworkEventQueue, &xRxEvent, pxHigherPriorityTaskWoken ) != pdPASS )
+			{
+				xRxRingWakeUpPending = pdFALSE;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_RX_BATCHING */
+/*-----------------------------------------------------------*/
+
 static TickType_t prvCalculateSleepTime( void )
 {
 TickType_t xMaximumSleepTime;
@@ -1656,6 +1848,19 @@ uint8_t ucProtocol;
 			case ipPROTOCOL_TCP :
 				{
 
+					#if( ipconfigUSE_TCP_RX_COALESCING != 0 )
+					if( xProcessingRxBatch != pdFALSE )
+					{
+						/* The packet may be held, and passed to the socket
+						together with the segments that follow it in this
+						batch. */
+						if( xCoalesceReceivedTCPPacket( pxNetworkBuffer ) == pdPASS )
+						{
+							eReturn = eFrameConsumed;
+						}
+					}
+					else
+					#endif /* ipconfigUSE_TCP_RX_COALESCING */
 					if( xProcessReceivedTCPPacket( pxNetworkBuffer ) == pdPASS )
 					{
 						eReturn = eFrameConsumed;
@@ -129,6 +129,14 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static StreamBuffer_t *prvTCPCreateStream (FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream );
 #endif /* ipconfigUSE_TCP == 1 */
 
+#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+	/*
+	 * Called by the IP-task when the tuning has chosen another size for the
+	 * rxStream.  The stream is only replaced while it is empty.
+	 */
+	static void prvTCPRxStreamResize( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Called from FreeRTOS_send(): some checks which will be done before
@@ -347,6 +355,12 @@ Socket_t xReturn;
 						pxSocket->u.xTCP.uxTxWinSize  = 1u;
 					}
 					#endif
+					#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+					{
+						/* Until the owner sets the reception buffer. */
+						pxSocket->u.xTCP.bits.bRxAutoTune = pdTRUE_UNSIGNED;
+					}
+					#endif
 					/* The above values are just defaults, and can be overridden by
 					calling FreeRTOS_setsockopt().  No buffers will be allocated until a
 					socket is connected and data is exchanged. */
@@ -1170,6 +1184,15 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 				vPortFreeLarge( pxSocket->u.xTCP.txStream );
 			}
 
+			#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+			{
+				if( pxSocket->u.xTCP.pxRxStreamOld != NULL )
+				{
+					vPortFreeLarge( pxSocket->u.xTCP.pxRxStreamOld );
+				}
+			}
+			#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+
 			/* In case this is a child socket, make sure the child-count of the
 			parent socket is decreased. */
 			prvTCPSetSocketCount( pxSocket );
@@ -1454,6 +1477,12 @@ FreeRTOS_Socket_t *pxSocket;
 					pxSocket->u.xTCP.uxLittleSpace = pxLowHighWater->uxLittleSpace;
 					/* Send a GO when buffer space grows above 'uxEnoughSpace' bytes. */
 					pxSocket->u.xTCP.uxEnoughSpace = pxLowHighWater->uxEnoughSpace;
+					#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+					{
+						/* The marks are absolute, the buffer size must stay. */
+						pxSocket->u.xTCP.bits.bRxAutoTune = pdFALSE_UNSIGNED;
+					}
+					#endif
 					xReturn = 0;
 				}
 				break;
@@ -1489,6 +1518,12 @@ FreeRTOS_Socket_t *pxSocket;
 					else
 					{
 						pxSocket->u.xTCP.uxRxStreamSize = ulNewValue;
+						#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+						{
+							/* The owner has chosen a size, stop tuning it. */
+							pxSocket->u.xTCP.bits.bRxAutoTune = pdFALSE_UNSIGNED;
+						}
+						#endif
 					}
 				}
 				xReturn = 0;
@@ -2370,6 +2405,21 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 							xSendEventToIPTask( eTCPTimerEvent );
 						}
 					}
+
+					#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+					{
+						/* The IP-task has replaced the rxStream with one of
+						another size.  This task is the only one that might
+						still have been using the old one. */
+						if( pxSocket->u.xTCP.pxRxStreamOld != NULL )
+						{
+						StreamBuffer_t *pxOldStream = pxSocket->u.xTCP.pxRxStreamOld;
+
+							pxSocket->u.xTCP.pxRxStreamOld = NULL;
+							vPortFreeLarge( pxOldStream );
+						}
+					}
+					#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
 				}
 				else
 				{
@@ -2982,6 +3032,70 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+
+	static void prvTCPRxStreamResize( FreeRTOS_Socket_t *pxSocket )
+	{
+	StreamBuffer_t *pxOldStream = pxSocket->u.xTCP.rxStream;
+	StreamBuffer_t *pxBuffer;
+	size_t uxSize = pxSocket->u.xTCP.uxAutoTuneSize;
+	size_t uxLength;
+	uint32_t ulAdvertised;
+
+		/* The space that the peer may still fill, according to the last window
+		advertised. */
+		ulAdvertised = pxSocket->u.xTCP.ulHighestRxAllowed - pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber;
+
+		/* The stream can only be replaced when it has no data for the user, no
+		out-of-order data is stored in front of its head, and the owner has
+		freed the stream that was replaced before. */
+		if( ( pxSocket->u.xTCP.pxRxStreamOld == NULL ) &&
+			( uxStreamBufferGetSize( pxOldStream ) == 0u ) &&
+			( pxOldStream->uxFront == pxOldStream->uxHead ) &&
+			( ( size_t ) ulAdvertised < uxSize ) )
+		{
+			/* The same calculation as in prvTCPCreateStream(). */
+			uxLength = ( uxSize + sizeof( size_t ) ) & ~( sizeof( size_t ) - 1u );
+			pxBuffer = ( StreamBuffer_t * ) pvPortMallocLarge( sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) + uxLength );
+
+			if( pxBuffer == NULL )
+			{
+				/* Not a reason to close the connection: keep the current
+				stream, which also limits the advertised window. */
+				FreeRTOS_debug_printf( ( "prvTCPRxStreamResize: malloc %lu failed\n", uxLength ) );
+				pxSocket->u.xTCP.uxAutoTuneSize = pxSocket->u.xTCP.uxRxStreamSize;
+			}
+			else
+			{
+				memset( pxBuffer, '\0', sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) );
+				pxBuffer->LENGTH = uxLength;
+
+				pxSocket->u.xTCP.rxStream = pxBuffer;
+				pxSocket->u.xTCP.uxRxStreamSize = uxSize;
+				pxSocket->u.xTCP.uxLittleSpace = ( sock20_PERCENT * uxSize ) / sock100_PERCENT;
+				pxSocket->u.xTCP.uxEnoughSpace = ( sock80_PERCENT * uxSize ) / sock100_PERCENT;
+
+				#if( ipconfigUSE_CALLBACKS == 1 )
+				if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xTCP.pxHandleReceive ) )
+				{
+					/* All data is passed to the handler from within the
+					IP-task, the owner does not read the stream. */
+					vPortFreeLarge( pxOldStream );
+				}
+				else
+				#endif /* ipconfigUSE_CALLBACKS */
+				{
+					/* The owner might be reading the old stream at this very
+					moment, FreeRTOS_recv() will free it. */
+					pxSocket->u.xTCP.pxRxStreamOld = pxOldStream;
+				}
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
@@ -3002,6 +3116,18 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		if( pucData == NULL ) no copying, just advance rxHead
 		if( uxOffset != 0 ) Just store data which has come out-of-order
 		if( uxOffset == 0 ) Also advance rxHead */
+		#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+		{
+			if( ( pxStream != NULL ) &&
+				( pxSocket->u.xTCP.uxAutoTuneSize != 0u ) &&
+				( pxSocket->u.xTCP.uxAutoTuneSize != pxSocket->u.xTCP.uxRxStreamSize ) )
+			{
+				prvTCPRxStreamResize( pxSocket );
+				pxStream = pxSocket->u.xTCP.rxStream;
+			}
+		}
+		#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+
 		if( pxStream == NULL )
 		{
 			pxStream = prvTCPCreateStream( pxSocket, pdTRUE );
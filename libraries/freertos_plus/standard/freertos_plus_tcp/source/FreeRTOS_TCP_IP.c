@@ -363,6 +363,75 @@ static NetworkBufferDescriptor_t *prvTCPBufferResize( FreeRTOS_Socket_t *pxSocke
 	static uint8_t prvWinScaleFactor( FreeRTOS_Socket_t *pxSocket );
 #endif
 
+#if( ipconfigUSE_TCP_RX_COALESCING != 0 )
+	/*
+	 * Returns pdTRUE if the packet is a plain data segment that may be
+	 * coalesced: only the ACK flag (and possibly PSH) is set, there are no TCP
+	 * options and it carries payload.
+	 */
+	static BaseType_t prvTCPMayCoalesce( NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * Returns pdTRUE if pxNext belongs to the same connection as pxLast,
+	 * carries the same acknowledgement and window, and starts where pxLast
+	 * ends.
+	 */
+	static BaseType_t prvTCPCanExtendRun( NetworkBufferDescriptor_t *pxLast, NetworkBufferDescriptor_t *pxNext );
+
+	/*
+	 * Add the payload of the first segment of a run, and of the segments that
+	 * follow it, to the RX stream.  Returns the total number of bytes stored.
+	 */
+	static int32_t prvTCPAddCoalescedRxData( FreeRTOS_Socket_t *pxSocket, uint32_t ulOffset, uint8_t *pucRecvData, uint32_t ulReceiveLength );
+#endif /* ipconfigUSE_TCP_RX_COALESCING */
+
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	/*
+	 * Send the 'ulLength' bytes that prvTCPPrepareSend() took from the sliding
+	 * window after the first segment.  Every frame gets a copy of the headers
+	 * in pxTemplate.
+	 */
+	static void prvTCPLargeSend( FreeRTOS_Socket_t *pxSocket, const TCPPacket_t *pxTemplate, uint32_t ulLength );
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
+#if( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+	/*
+	 * Sum the parts of the TCP checksum that are equal for all segments made
+	 * from pxTemplate: the IP addresses and protocol of the pseudo header, and
+	 * the TCP header except for the sequence number, offset, flags and checksum.
+	 */
+	static uint32_t prvTCPLargeSendHeaderSum( const TCPPacket_t *pxTemplate );
+
+	/*
+	 * Set the IP and TCP checksums of a segment that was made from pxTemplate.
+	 * Only the payload has to be summed, the IP header checksum is updated
+	 * incrementally (RFC 1624).
+	 */
+	static void prvTCPLargeSendChecksums( TCPPacket_t *pxTCPPacket, const TCPPacket_t *pxTemplate, uint32_t ulHeaderSum, uint32_t ulDataLength );
+#endif
+
+#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+	/*
+	 * Called when a connection gets established: the time between sending the
+	 * SYN (or SYN+ACK) and receiving its acknowledgement is the round-trip time
+	 * that is used for tuning the reception window.
+	 */
+	static void prvTCPRxAutoTuneStart( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Called after data has been received.  Once every round-trip time, the
+	 * number of bytes received is passed to prvTCPRxAutoTuneUpdate().
+	 */
+	static void prvTCPRxAutoTune( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Decide on a new size of the reception buffer and window, given the
+	 * number of bytes received during the last round-trip time and the amount
+	 * of free heap.
+	 */
+	static void prvTCPRxAutoTuneUpdate( FreeRTOS_Socket_t *pxSocket, uint32_t ulBytesPerRTT, size_t uxFreeHeap );
+#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+
 /*
  * Generate a randomized TCP Initial Sequence Number per RFC.
  */
@@ -373,6 +442,36 @@ extern uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
 
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_RX_COALESCING != 0 )
+	/* The run of in-order segments that is being held back by
+	xCoalesceReceivedTCPPacket().  It never outgrows a batch, because it is
+	flushed at the end of every batch. */
+	static NetworkBufferDescriptor_t *pxCoalescedPackets[ ipconfigRX_BATCH_MAX_FRAMES ];
+	static BaseType_t xCoalescedCount = 0;
+
+	/* While the first segment of a run is being handled, these describe the
+	segments that follow it.  prvTCPHandleState() counts their payload as
+	part of the received data, and prvStoreRxData() stores it. */
+	static NetworkBufferDescriptor_t **ppxRxFollowers = NULL;
+	static BaseType_t xRxFollowerCount = 0;
+	static uint32_t ulRxFollowerLength = 0ul;
+#endif /* ipconfigUSE_TCP_RX_COALESCING */
+
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	/* The maximum number of segments that prvTCPPrepareSend() takes from the
+	window at once.  The tests lower it to compare with single segments. */
+	static UBaseType_t uxLargeSendSegments = ( UBaseType_t ) ipconfigTCP_LARGE_SEND_SEGMENTS;
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
+#ifdef AMAZON_FREERTOS_ENABLE_UNIT_TESTS
+	/* Let the tests see, or take, every packet that this module sends.  It is
+	defined in iot_freertos_tcp_test_access_tcp_define.h. */
+	static BaseType_t prvTCPNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+	#define xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend )	prvTCPNetworkInterfaceOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#endif /* AMAZON_FREERTOS_ENABLE_UNIT_TESTS */
+
+/*-----------------------------------------------------------*/
+
 /* prvTCPSocketIsActive() returns true if the socket must be checked.
  * Non-active sockets are waiting for user action, either connect()
  * or close(). */
@@ -695,8 +794,24 @@ EthernetHeader_t *pxEthernetHeader;
 uint32_t ulFrontSpace, ulSpace, ulSourceAddress, ulWinSize;
 TCPWindow_t *pxTCPWindow;
 NetworkBufferDescriptor_t xTempBuffer;
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	TCPPacket_t xTemplate;
+	uint32_t ulLargeSendLength = 0UL;
+#endif
 /* For sending, a pseudo network buffer will be used, as explained above. */
 
+	#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	{
+		/* A run of segments prepared by prvTCPPrepareSend() belongs to this
+		packet only. */
+		if( pxSocket != NULL )
+		{
+			ulLargeSendLength = pxSocket->u.xTCP.ulLargeSendLength;
+			pxSocket->u.xTCP.ulLargeSendLength = 0UL;
+		}
+	}
+	#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
 	if( pxNetworkBuffer == NULL )
 	{
 		pxNetworkBuffer = &xTempBuffer;
@@ -938,6 +1053,17 @@ NetworkBufferDescriptor_t xTempBuffer;
 		}
 		#endif
 
+		#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+		{
+			if( ulLargeSendLength != 0UL )
+			{
+				/* The headers of this packet will be used for the rest of the
+				run.  Copy them before the driver takes the buffer. */
+				memcpy( ( void * ) &xTemplate, ( void * ) pxTCPPacket, ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
 		/* Send! */
 		xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
 
@@ -953,10 +1079,174 @@ NetworkBufferDescriptor_t xTempBuffer;
 		{
 			/* Nothing to do: the buffer has been passed to DMA and will be released after use */
 		}
+
+		#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+		{
+			if( ulLargeSendLength != 0UL )
+			{
+				prvTCPLargeSend( pxSocket, &xTemplate, ulLargeSendLength );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_LARGE_SEND */
 	} /* if( pxNetworkBuffer != NULL ) */
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+
+	static void prvTCPLargeSend( FreeRTOS_Socket_t *pxSocket, const TCPPacket_t *pxTemplate, uint32_t ulLength )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	TCPPacket_t *pxTCPPacket;
+	TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	const size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+	uint32_t ulSequenceNumber, ulDataLength;
+	size_t uxOffset;
+	#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+		uint32_t ulHeaderSum;
+	#endif
+
+		ulSequenceNumber = FreeRTOS_ntohl( pxTemplate->xTCPHeader.ulSequenceNumber ) + pxSocket->u.xTCP.ulLargeSendSegment;
+		uxOffset = pxSocket->u.xTCP.uxLargeSendOffset;
+
+		#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+		{
+			ulHeaderSum = prvTCPLargeSendHeaderSum( pxTemplate );
+		}
+		#endif
+
+		while( ulLength != 0UL )
+		{
+			ulDataLength = FreeRTOS_min_uint32( ulLength, pxSocket->u.xTCP.ulLargeSendSegment );
+
+			pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxHeaderLength + ( size_t ) ulDataLength, 0u );
+
+			if( pxNetworkBuffer == NULL )
+			{
+				/* The remaining segments have been registered as sent already.
+				They will be retransmitted when their timer expires. */
+				FreeRTOS_debug_printf( ( "prvTCPLargeSend: no buffer for %lu bytes\n", ulLength ) );
+				break;
+			}
+
+			pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+			memcpy( ( void * ) pxTCPPacket, ( const void * ) pxTemplate, uxHeaderLength );
+
+			/* Peek the payload from txStream, like prvTCPPrepareSend() does. */
+			( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pxNetworkBuffer->pucEthernetBuffer + uxHeaderLength,
+				( size_t ) ulDataLength, pdTRUE );
+
+			pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber );
+
+			/* The FIN flag can only be set on the last segment of the run. */
+			if( ( pxSocket->u.xTCP.bits.bFinSent != pdFALSE_UNSIGNED ) &&
+				( ( ulSequenceNumber + ulDataLength ) == pxTCPWindow->tx.ulFINSequenceNumber ) )
+			{
+				pxTCPPacket->xTCPHeader.ucTCPFlags |= ( uint8_t ) ipTCP_FLAG_FIN;
+			}
+			else
+			{
+				pxTCPPacket->xTCPHeader.ucTCPFlags &= ( ( uint8_t ) ~ipTCP_FLAG_FIN );
+			}
+
+			pxTCPPacket->xIPHeader.usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + ulDataLength ) );
+			pxTCPPacket->xIPHeader.usIdentification = FreeRTOS_htons( usPacketIdentifier );
+			usPacketIdentifier++;
+
+			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+			{
+				prvTCPLargeSendChecksums( pxTCPPacket, pxTemplate, ulHeaderSum, ulDataLength );
+			}
+			#endif
+
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				pxNetworkBuffer->pxNextBuffer = NULL;
+			}
+			#endif
+
+			pxNetworkBuffer->xDataLength = uxHeaderLength + ( size_t ) ulDataLength;
+
+			xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+
+			ulSequenceNumber += ulDataLength;
+			uxOffset += ( size_t ) ulDataLength;
+			ulLength -= ulDataLength;
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
+/*-----------------------------------------------------------*/
+
+#if( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+
+	static uint32_t prvTCPLargeSendHeaderSum( const TCPPacket_t *pxTemplate )
+	{
+	TCPHeader_t xHeader;
+	uint32_t ulSum;
+
+		memcpy( ( void * ) &xHeader, ( const void * ) &( pxTemplate->xTCPHeader ), ipSIZE_OF_TCP_HEADER );
+		xHeader.ulSequenceNumber = 0UL;
+		xHeader.ucTCPOffset = 0u;
+		xHeader.ucTCPFlags = 0u;
+		xHeader.usChecksum = 0u;
+
+		ulSum = ( uint32_t ) usGenerateChecksum( 0UL, ( uint8_t * ) &xHeader, ipSIZE_OF_TCP_HEADER );
+		ulSum += ( uint32_t ) usGenerateChecksum( 0UL, ( uint8_t * ) &( pxTemplate->xIPHeader.ulSourceIPAddress ),
+			2u * sizeof( pxTemplate->xIPHeader.ulSourceIPAddress ) );
+		ulSum += ( uint32_t ) ipPROTOCOL_TCP;
+
+		return ulSum;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+
+	static void prvTCPLargeSendChecksums( TCPPacket_t *pxTCPPacket, const TCPPacket_t *pxTemplate, uint32_t ulHeaderSum, uint32_t ulDataLength )
+	{
+	uint32_t ulSum, ulSequenceNumber;
+	uint16_t usChecksum;
+
+		/* IP header: only the length and the identification differ from the
+		template, HC' = ~( ~HC + ~m + m' ). */
+		ulSum = ( uint16_t ) ~FreeRTOS_ntohs( pxTemplate->xIPHeader.usHeaderChecksum );
+		ulSum += ( uint16_t ) ~FreeRTOS_ntohs( pxTemplate->xIPHeader.usLength );
+		ulSum += FreeRTOS_ntohs( pxTCPPacket->xIPHeader.usLength );
+		ulSum += ( uint16_t ) ~FreeRTOS_ntohs( pxTemplate->xIPHeader.usIdentification );
+		ulSum += FreeRTOS_ntohs( pxTCPPacket->xIPHeader.usIdentification );
+		ulSum = ( ulSum & 0xffffUL ) + ( ulSum >> 16 );
+		ulSum = ( ulSum & 0xffffUL ) + ( ulSum >> 16 );
+		pxTCPPacket->xIPHeader.usHeaderChecksum = FreeRTOS_htons( ( uint16_t ) ~ulSum );
+
+		/* TCP: add the fields that differ per segment, and the TCP length of
+		the pseudo header, to the sum of the template. */
+		ulSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+		ulSum = ulHeaderSum;
+		ulSum += ( ulSequenceNumber >> 16 ) + ( ulSequenceNumber & 0xffffUL );
+		ulSum += ( ( ( uint32_t ) pxTCPPacket->xTCPHeader.ucTCPOffset ) << 8 ) | pxTCPPacket->xTCPHeader.ucTCPFlags;
+		ulSum += ipSIZE_OF_TCP_HEADER + ulDataLength;
+		ulSum = ( ulSum & 0xffffUL ) + ( ulSum >> 16 );
+		ulSum = ( ulSum & 0xffffUL ) + ( ulSum >> 16 );
+
+		/* Continue with the payload. */
+		usChecksum = ( uint16_t ) ~usGenerateChecksum( ulSum,
+			( ( uint8_t * ) pxTCPPacket ) + ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER, ( size_t ) ulDataLength );
+
+		/* A calculated checksum of 0 must be inverted as 0 means the checksum
+		is disabled. */
+		if( usChecksum == 0u )
+		{
+			usChecksum = 0xffffU;
+		}
+
+		pxTCPPacket->xTCPHeader.usChecksum = FreeRTOS_htons( usChecksum );
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 /*
  * The SYN event is very important: the sequence numbers, which have a kind of
  * random starting value, are being synchronised.  The sliding window manager
@@ -1336,6 +1626,17 @@ UBaseType_t uxNewMSS;
 
 		/* 'xTCP.uxRxWinSize' is the size of the reception window in units of MSS. */
 		uxWinSize = pxSocket->u.xTCP.uxRxWinSize * ( size_t ) pxSocket->u.xTCP.usInitMSS;
+
+		#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+		{
+			/* The window may grow to half of the largest reception buffer
+			while the connection is alive, but the factor is fixed now. */
+			if( pxSocket->u.xTCP.bits.bRxAutoTune != pdFALSE_UNSIGNED )
+			{
+				uxWinSize = FreeRTOS_max_uint32( ( uint32_t ) uxWinSize, ( uint32_t ) ( ipconfigTCP_RX_AUTOTUNE_MAX_SIZE / 2u ) );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
 		ucFactor = 0u;
 		while( uxWinSize > 0xfffful )
 		{
@@ -1373,6 +1674,14 @@ UBaseType_t uxOptionsLength;
 	pxTCPHeader->ucOptdata[ 2 ] = ( uint8_t ) ( usMSS >> 8 );
 	pxTCPHeader->ucOptdata[ 3 ] = ( uint8_t ) ( usMSS & 0xffu );
 
+	#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+	{
+		/* The SYN or SYN+ACK is about to be sent, the round-trip time is
+		measured from here. */
+		pxSocket->u.xTCP.xAutoTuneTime = xTaskGetTickCount();
+	}
+	#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+
 	#if( ipconfigUSE_TCP_WIN != 0 )
 	{
 		pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket );
@@ -1688,10 +1997,13 @@ int32_t lDataLen;
 uint8_t *pucEthernetBuffer, *pucSendData;
 TCPPacket_t *pxTCPPacket;
 size_t uxOffset;
-uint32_t ulDataGot, ulDistance;
+uint32_t ulDataGot, ulDistance, ulMoreData;
 TCPWindow_t *pxTCPWindow;
 NetworkBufferDescriptor_t *pxNewBuffer;
 int32_t lStreamPos;
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	uint32_t ulRunLength, ulSegmentLength;
+#endif
 
 	if( ( *ppxNetworkBuffer ) != NULL )
 	{
@@ -1708,8 +2020,15 @@ int32_t lStreamPos;
 	pxTCPWindow = &pxSocket->u.xTCP.xTCPWindow;
 	lDataLen = 0;
 	lStreamPos = 0;
+	ulMoreData = 0UL;
 	pxTCPPacket->xTCPHeader.ucTCPFlags |= ipTCP_FLAG_ACK;
 
+	#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+	{
+		pxSocket->u.xTCP.ulLargeSendLength = 0UL;
+	}
+	#endif
+
 	if( pxSocket->u.xTCP.txStream != NULL )
 	{
 		/* ulTCPWindowTxGet will return the amount of data which may be sent
@@ -1718,7 +2037,22 @@ int32_t lStreamPos;
 		Because some TCP-stacks (like uIP) use it for flow-control. */
 		if( pxSocket->u.xTCP.usCurMSS > 1u )
 		{
-			lDataLen = ( int32_t ) ulTCPWindowTxGet( pxTCPWindow, pxSocket->u.xTCP.ulWindowSize, &lStreamPos );
+			#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+				if( uxOptionsLength == 0u )
+				{
+					/* Take a run of segments from the window.  Only the first
+					one is copied to the network buffer here, the others will be
+					sent by prvTCPLargeSend(). */
+					ulRunLength = ulTCPWindowTxGetRun( pxTCPWindow, pxSocket->u.xTCP.ulWindowSize, &lStreamPos,
+						uxLargeSendSegments, &ulSegmentLength );
+					lDataLen = ( int32_t ) ulSegmentLength;
+					ulMoreData = ulRunLength - ulSegmentLength;
+				}
+				else
+			#endif /* ipconfigUSE_TCP_LARGE_SEND */
+			{
+				lDataLen = ( int32_t ) ulTCPWindowTxGet( pxTCPWindow, pxSocket->u.xTCP.ulWindowSize, &lStreamPos );
+			}
 		}
 
 		if( lDataLen > 0 )
@@ -1753,13 +2087,26 @@ int32_t lStreamPos;
 				}
 				#endif
 
+				#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+				{
+					if( ulMoreData != 0UL )
+					{
+						/* Tell prvTCPReturnPacket() where to find the rest of
+						the run. */
+						pxSocket->u.xTCP.ulLargeSendLength = ulMoreData;
+						pxSocket->u.xTCP.ulLargeSendSegment = ( uint32_t ) lDataLen;
+						pxSocket->u.xTCP.uxLargeSendOffset = uxOffset + ( size_t ) lDataLen;
+					}
+				}
+				#endif /* ipconfigUSE_TCP_LARGE_SEND */
+
 				/* If the owner of the socket requests a closure, add the FIN
 				flag to the last packet. */
 				if( ( pxSocket->u.xTCP.bits.bCloseRequested != pdFALSE_UNSIGNED ) && ( pxSocket->u.xTCP.bits.bFinSent == pdFALSE_UNSIGNED ) )
 				{
 					ulDistance = ( uint32_t ) uxStreamBufferDistance( pxSocket->u.xTCP.txStream, ( size_t ) lStreamPos, pxSocket->u.xTCP.txStream->uxHead );
 
-					if( ulDistance == ulDataGot )
+					if( ulDistance == ulDataGot + ulMoreData )
 					{
 						#if (ipconfigHAS_DEBUG_PRINTF == 1)
 						{
@@ -1777,7 +2124,7 @@ int32_t lStreamPos;
 						ESTABLISHED until all current data has been received or
 						delivered. */
 						pxTCPPacket->xTCPHeader.ucTCPFlags |= ipTCP_FLAG_FIN;
-						pxTCPWindow->tx.ulFINSequenceNumber = pxTCPWindow->ulOurSequenceNumber + ( uint32_t ) lDataLen;
+						pxTCPWindow->tx.ulFINSequenceNumber = pxTCPWindow->ulOurSequenceNumber + ( uint32_t ) lDataLen + ulMoreData;
 						pxSocket->u.xTCP.bits.bFinSent = pdTRUE_UNSIGNED;
 					}
 				}
@@ -2169,7 +2516,15 @@ BaseType_t xResult = 0;
 			if the head marker in rxStream may be advanced,	only if lOffset == 0.
 			In case the low-water mark is reached, bLowWater will be set
 			"low-water" here stands for "little space". */
-			lStored = lTCPAddRxdata( pxSocket, ( uint32_t ) lOffset, pucRecvData, ulReceiveLength );
+			#if( ipconfigUSE_TCP_RX_COALESCING != 0 )
+			{
+				lStored = prvTCPAddCoalescedRxData( pxSocket, ( uint32_t ) lOffset, pucRecvData, ulReceiveLength );
+			}
+			#else
+			{
+				lStored = lTCPAddRxdata( pxSocket, ( uint32_t ) lOffset, pucRecvData, ulReceiveLength );
+			}
+			#endif /* ipconfigUSE_TCP_RX_COALESCING */
 
 			if( lStored != ( int32_t ) ulReceiveLength )
 			{
@@ -2197,6 +2552,15 @@ BaseType_t xResult = 0;
 			}
 		}
 		#endif /* ipconfigUSE_TCP_WIN */
+
+		#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+		{
+			if( xResult == 0 )
+			{
+				prvTCPRxAutoTune( pxSocket );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
 	}
 	else
 	{
@@ -2207,6 +2571,116 @@ BaseType_t xResult = 0;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+
+	static void prvTCPRxAutoTuneStart( FreeRTOS_Socket_t *pxSocket )
+	{
+	TickType_t xNow = xTaskGetTickCount();
+
+		/* 'xAutoTuneTime' was set when the last SYN or SYN+ACK was sent. */
+		pxSocket->u.xTCP.xAutoTuneRTT = xNow - pxSocket->u.xTCP.xAutoTuneTime;
+
+		if( pxSocket->u.xTCP.xAutoTuneRTT == ( TickType_t ) 0u )
+		{
+			pxSocket->u.xTCP.xAutoTuneRTT = ( TickType_t ) 1u;
+		}
+
+		pxSocket->u.xTCP.xAutoTuneTime = xNow;
+		pxSocket->u.xTCP.ulAutoTuneSequence = pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber;
+		pxSocket->u.xTCP.uxAutoTuneSize = pxSocket->u.xTCP.uxRxStreamSize;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPRxAutoTune( FreeRTOS_Socket_t *pxSocket )
+	{
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xRTT = pxSocket->u.xTCP.xAutoTuneRTT;
+	TickType_t xElapsed = xNow - pxSocket->u.xTCP.xAutoTuneTime;
+	uint32_t ulReceived;
+
+		/* 'xAutoTuneRTT' is zero until the connection has been established. */
+		if( ( pxSocket->u.xTCP.bits.bRxAutoTune != pdFALSE_UNSIGNED ) &&
+			( xRTT != ( TickType_t ) 0u ) &&
+			( xElapsed >= xRTT ) )
+		{
+			ulReceived = pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber - pxSocket->u.xTCP.ulAutoTuneSequence;
+
+			/* When no data was received for a while, the period is longer
+			than a round-trip time. */
+			ulReceived /= ( uint32_t ) ( xElapsed / xRTT );
+
+			prvTCPRxAutoTuneUpdate( pxSocket, ulReceived, ( size_t ) ipconfigTCP_RX_AUTOTUNE_FREE_HEAP() );
+
+			pxSocket->u.xTCP.xAutoTuneTime = xNow;
+			pxSocket->u.xTCP.ulAutoTuneSequence = pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPRxAutoTuneUpdate( FreeRTOS_Socket_t *pxSocket, uint32_t ulBytesPerRTT, size_t uxFreeHeap )
+	{
+	TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	size_t uxSize = pxSocket->u.xTCP.uxAutoTuneSize;
+	size_t uxNewSize = uxSize;
+	uint32_t ulMSS = ( uint32_t ) pxTCPWindow->usMSS;
+	uint32_t ulWindow, ulMaxWindow;
+
+		if( uxFreeHeap < ( size_t ) ipconfigTCP_RX_AUTOTUNE_HEAP_RESERVE )
+		{
+			/* The heap is running low, halve the buffer, but not below the
+			default size. */
+			if( uxSize > ( size_t ) ipconfigTCP_RX_BUFFER_LENGTH )
+			{
+				uxNewSize = FreeRTOS_max_uint32( ( uint32_t ) ( uxSize / 2u ), ( uint32_t ) ipconfigTCP_RX_BUFFER_LENGTH );
+			}
+		}
+		else if( ( pxSocket->u.xTCP.bits.bLowWater == pdFALSE_UNSIGNED ) &&
+				 ( ulBytesPerRTT >= ( pxTCPWindow->xSize.ulRxWindowLength / 2u ) ) )
+		{
+			/* The application keeps up, and the peer sent at least half a
+			window in one round-trip: it might send more if it could.  Make the
+			window twice as large as what was received, and the buffer twice as
+			large as the window. */
+			uxNewSize = FreeRTOS_min_uint32( 4u * ulBytesPerRTT, ( uint32_t ) ipconfigTCP_RX_AUTOTUNE_MAX_SIZE );
+
+			/* The old buffer is still allocated when the new one is created. */
+			if( ( uxNewSize <= uxSize ) || ( uxFreeHeap < ( uxNewSize + ( size_t ) ipconfigTCP_RX_AUTOTUNE_HEAP_RESERVE ) ) )
+			{
+				uxNewSize = uxSize;
+			}
+		}
+		else
+		{
+			/* The window is large enough. */
+		}
+
+		if( ( uxNewSize != uxSize ) && ( ulMSS != 0u ) )
+		{
+			/* As for a new socket, the window is half of the buffer, rounded
+			down to a multiple of MSS.  It can not be larger than what the
+			scale factor sent in the SYN can express. */
+			ulWindow = FreeRTOS_max_uint32( ulMSS, ( ( ( uint32_t ) uxNewSize / 2u ) / ulMSS ) * ulMSS );
+			ulMaxWindow = ( ( uint32_t ) 0xfffcu ) << pxSocket->u.xTCP.ucMyWinScaleFactor;
+			ulWindow = FreeRTOS_min_uint32( ulWindow, ( ulMaxWindow / ulMSS ) * ulMSS );
+
+			FreeRTOS_debug_printf( ( "prvTCPRxAutoTuneUpdate[%u]: %lu bytes per RTT, buffer %lu -> %lu, window %lu\n",
+				pxSocket->usLocalPort,
+				ulBytesPerRTT,
+				uxSize,
+				uxNewSize,
+				ulWindow ) );
+
+			/* The advertised window is also limited by the free space in
+			rxStream, until FreeRTOS_recv() installs a stream of the new size. */
+			pxTCPWindow->xSize.ulRxWindowLength = ulWindow;
+			pxSocket->u.xTCP.uxRxWinSize = ( size_t ) ( ulWindow / ulMSS );
+			pxSocket->u.xTCP.uxAutoTuneSize = uxNewSize;
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+/*-----------------------------------------------------------*/
+
 /* Set the TCP options (if any) for the outgoing packet. */
 static UBaseType_t prvSetOptions( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
 {
@@ -2348,6 +2822,13 @@ BaseType_t xSendLength = 0;
 			}
 		}
 		#endif /* ipconfigUSE_TCP_WIN */
+
+		#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+		{
+			prvTCPRxAutoTuneStart( pxSocket );
+		}
+		#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+
 		/* This was the third step of connecting: SYN, SYN+ACK, ACK	so now the
 		connection is established. */
 		vTCPStateChange( pxSocket, eESTABLISHED );
@@ -2647,6 +3128,183 @@ int32_t lRxSpace;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_RX_COALESCING != 0 )
+
+	static int32_t prvTCPAddCoalescedRxData( FreeRTOS_Socket_t *pxSocket, uint32_t ulOffset, uint8_t *pucRecvData, uint32_t ulReceiveLength )
+	{
+	uint32_t ulLength, ulExpected;
+	int32_t lStored, lTotal;
+	BaseType_t xIndex;
+	uint8_t *pucData;
+
+		/* The payload of the first segment. */
+		ulExpected = ulReceiveLength - ulRxFollowerLength;
+		lTotal = lTCPAddRxdata( pxSocket, ulOffset, pucRecvData, ulExpected );
+
+		/* Stop as soon as a part could not be stored completely. */
+		for( xIndex = 0; ( xIndex < xRxFollowerCount ) && ( lTotal == ( int32_t ) ulExpected ); xIndex++ )
+		{
+			ulLength = ( uint32_t ) prvCheckRxData( ppxRxFollowers[ xIndex ], &pucData );
+
+			/* Data that is added at offset 0 advances the head of the stream,
+			so the next part goes to offset 0 again.  Data that is stored
+			out-of-order is placed after the previous part. */
+			lStored = lTCPAddRxdata( pxSocket, ( ulOffset == 0ul ) ? 0ul : ( ulOffset + ulExpected ), pucData, ulLength );
+			ulExpected += ulLength;
+
+			if( lStored < 0 )
+			{
+				lTotal = lStored;
+			}
+			else
+			{
+				lTotal += lStored;
+			}
+		}
+
+		return lTotal;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTCPMayCoalesce( NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	uint8_t *pucRecvData;
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( pxNetworkBuffer->xDataLength >= ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ) ) &&
+			( ( pxTCPPacket->xTCPHeader.ucTCPFlags & ( uint8_t ) ~ipTCP_FLAG_PSH ) == ( uint8_t ) ipTCP_FLAG_ACK ) &&
+			( ( pxTCPPacket->xTCPHeader.ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) == TCP_OFFSET_STANDARD_LENGTH ) &&
+			( prvCheckRxData( pxNetworkBuffer, &pucRecvData ) > 0 ) )
+		{
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTCPCanExtendRun( NetworkBufferDescriptor_t *pxLast, NetworkBufferDescriptor_t *pxNext )
+	{
+	TCPPacket_t *pxLastPacket = ( TCPPacket_t * ) ( pxLast->pucEthernetBuffer );
+	TCPPacket_t *pxNextPacket = ( TCPPacket_t * ) ( pxNext->pucEthernetBuffer );
+	uint8_t *pucRecvData;
+	uint32_t ulLastEnd;
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( pxLastPacket->xIPHeader.ulSourceIPAddress == pxNextPacket->xIPHeader.ulSourceIPAddress ) &&
+			( pxLastPacket->xIPHeader.ulDestinationIPAddress == pxNextPacket->xIPHeader.ulDestinationIPAddress ) &&
+			( pxLastPacket->xTCPHeader.usSourcePort == pxNextPacket->xTCPHeader.usSourcePort ) &&
+			( pxLastPacket->xTCPHeader.usDestinationPort == pxNextPacket->xTCPHeader.usDestinationPort ) &&
+			( pxLastPacket->xTCPHeader.ulAckNr == pxNextPacket->xTCPHeader.ulAckNr ) &&
+			( pxLastPacket->xTCPHeader.usWindow == pxNextPacket->xTCPHeader.usWindow ) )
+		{
+			ulLastEnd = FreeRTOS_ntohl( pxLastPacket->xTCPHeader.ulSequenceNumber ) + ( uint32_t ) prvCheckRxData( pxLast, &pucRecvData );
+
+			if( ulLastEnd == FreeRTOS_ntohl( pxNextPacket->xTCPHeader.ulSequenceNumber ) )
+			{
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xCoalesceReceivedTCPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	BaseType_t xResult = pdPASS;
+
+		if( prvTCPMayCoalesce( pxNetworkBuffer ) == pdFALSE )
+		{
+			/* A SYN, FIN, RST, a packet with options or a plain ACK.  Let the
+			segments that came before it go first. */
+			vTCPFlushCoalescedPackets();
+			xResult = xProcessReceivedTCPPacket( pxNetworkBuffer );
+		}
+		else if( ( xCoalescedCount > 0 ) &&
+				 ( xCoalescedCount < ( BaseType_t ) ipconfigRX_BATCH_MAX_FRAMES ) &&
+				 ( prvTCPCanExtendRun( pxCoalescedPackets[ xCoalescedCount - 1 ], pxNetworkBuffer ) != pdFALSE ) )
+		{
+			pxCoalescedPackets[ xCoalescedCount ] = pxNetworkBuffer;
+			xCoalescedCount++;
+		}
+		else
+		{
+			/* This segment starts a new run. */
+			vTCPFlushCoalescedPackets();
+			pxCoalescedPackets[ 0 ] = pxNetworkBuffer;
+			xCoalescedCount = 1;
+		}
+
+		return xResult;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vTCPFlushCoalescedPackets( void )
+	{
+	FreeRTOS_Socket_t *pxSocket = NULL;
+	TCPPacket_t *pxTCPPacket;
+	BaseType_t xIndex;
+	uint8_t *pucRecvData;
+
+		if( xCoalescedCount > 1 )
+		{
+			pxTCPPacket = ( TCPPacket_t * ) ( pxCoalescedPackets[ 0 ]->pucEthernetBuffer );
+			pxSocket = pxTCPSocketLookup( FreeRTOS_htonl( pxTCPPacket->xIPHeader.ulDestinationIPAddress ),
+										  FreeRTOS_htons( pxTCPPacket->xTCPHeader.usDestinationPort ),
+										  FreeRTOS_htonl( pxTCPPacket->xIPHeader.ulSourceIPAddress ),
+										  FreeRTOS_htons( pxTCPPacket->xTCPHeader.usSourcePort ) );
+		}
+
+		if( ( pxSocket != NULL ) && ( pxSocket->u.xTCP.ucTCPState == eESTABLISHED ) )
+		{
+			/* Let the first segment carry the payload of the others. */
+			ppxRxFollowers = &( pxCoalescedPackets[ 1 ] );
+			xRxFollowerCount = xCoalescedCount - 1;
+			ulRxFollowerLength = 0ul;
+
+			for( xIndex = 0; xIndex < xRxFollowerCount; xIndex++ )
+			{
+				ulRxFollowerLength += ( uint32_t ) prvCheckRxData( ppxRxFollowers[ xIndex ], &pucRecvData );
+			}
+
+			iptraceTCP_RX_COALESCED( xCoalescedCount, ulRxFollowerLength );
+
+			if( xProcessReceivedTCPPacket( pxCoalescedPackets[ 0 ] ) != pdPASS )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxCoalescedPackets[ 0 ] );
+			}
+
+			ppxRxFollowers = NULL;
+			xRxFollowerCount = 0;
+			ulRxFollowerLength = 0ul;
+
+			/* The payload of the other segments has been copied. */
+			for( xIndex = 1; xIndex < xCoalescedCount; xIndex++ )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxCoalescedPackets[ xIndex ] );
+			}
+		}
+		else
+		{
+			/* A single segment, or a connection that is not (yet) in the
+			established state: handle the segments one by one. */
+			for( xIndex = 0; xIndex < xCoalescedCount; xIndex++ )
+			{
+				if( xProcessReceivedTCPPacket( pxCoalescedPackets[ xIndex ] ) != pdPASS )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxCoalescedPackets[ xIndex ] );
+				}
+			}
+		}
+
+		xCoalescedCount = 0;
+	}
+
+#endif /* ipconfigUSE_TCP_RX_COALESCING */
+/*-----------------------------------------------------------*/
+
 /*
  * prvTCPHandleState()
  * is the most important function of this TCP stack
@@ -2685,6 +3343,14 @@ TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 	pucRecvData will point to the first byte of the TCP payload. */
 	ulReceiveLength = ( uint32_t ) prvCheckRxData( *ppxNetworkBuffer, &pucRecvData );
 
+	#if( ipconfigUSE_TCP_RX_COALESCING != 0 )
+	{
+		/* The segments that were coalesced with this one are handled as if
+		their payload was part of it. */
+		ulReceiveLength += ulRxFollowerLength;
+	}
+	#endif /* ipconfigUSE_TCP_RX_COALESCING */
+
 	if( pxSocket->u.xTCP.ucTCPState >= eESTABLISHED )
 	{
 		if ( pxTCPWindow->rx.ulCurrentSequenceNumber == ulSequenceNumber + 1u )
@@ -3217,6 +3883,12 @@ struct freertos_sockaddr xAddress;
 	pxNewSocket->u.xTCP.uxRxWinSize  = pxSocket->u.xTCP.uxRxWinSize;
 	pxNewSocket->u.xTCP.uxTxWinSize  = pxSocket->u.xTCP.uxTxWinSize;
 
+	#if( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+	{
+		pxNewSocket->u.xTCP.bits.bRxAutoTune = pxSocket->u.xTCP.bits.bRxAutoTune;
+	}
+	#endif /* ipconfigUSE_TCP_RX_AUTOTUNE */
+
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 	{
 		pxNewSocket->pxUserSemaphore = pxSocket->pxUserSemaphore;
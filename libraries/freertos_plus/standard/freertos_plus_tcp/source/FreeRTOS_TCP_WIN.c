@@ -104,6 +104,22 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static BaseType_t prvCreateSectors( void );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Clear an array of segment descriptors and add them to 'xSegmentList'.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static void prvAddSectors( TCPSegment_t *pxSegments, BaseType_t xCount );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
+/*
+ * Called when 'xSegmentList' is empty: allocate another block of
+ * ipconfigTCP_WIN_SEG_GROW_COUNT descriptors, unless the pool has reached
+ * ipconfigTCP_WIN_SEG_MAX_COUNT descriptors.
+ */
+#if( ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 ) )
+	static BaseType_t prvGrowSectors( void );
+#endif
+
 /*
  * Find a segment with a given sequence number in the list of received
  * segments: 'pxWindow->xRxSegments'.
@@ -181,6 +197,14 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static BaseType_t prvTCPWindowTxHasSpace( TCPWindow_t *pxWindow, uint32_t ulWindowSize );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * A segment is about to be transmitted: move it to the waiting queue and start
+ * its transmit timer.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static void prvTCPWindowTxMarkSent( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
 /*
  * An acknowledge was received.  See if some outstanding data may be removed
  * from the transmission queue(s).
@@ -207,6 +231,20 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 /* List of free TCP segments. */
 #if( ipconfigUSE_TCP_WIN == 1 )
 	static List_t xSegmentList;
+
+	/* The total number of descriptors in the pool. */
+	static UBaseType_t uxSegmentCount = 0u;
+#endif
+
+/* Blocks of descriptors that were added to the pool when it ran empty. */
+#if( ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 ) )
+	typedef struct xTCP_SEGMENT_BLOCK
+	{
+		struct xTCP_SEGMENT_BLOCK *pxNext;
+		TCPSegment_t xSegments[ ipconfigTCP_WIN_SEG_GROW_COUNT ];
+	} TCPSegmentBlock_t;
+
+	static TCPSegmentBlock_t *pxSegmentBlocks = NULL;
 #endif
 
 /* Logging verbosity level. */
@@ -302,11 +340,12 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 	static BaseType_t prvCreateSectors( void )
 	{
-	BaseType_t xIndex, xReturn;
+	BaseType_t xReturn;
 
 		/* Allocate space for 'xTCPSegments' and store them in 'xSegmentList'. */
 
 		vListInitialise( &xSegmentList );
+		uxSegmentCount = 0u;
 		xTCPSegments = ( TCPSegment_t * ) pvPortMallocLarge( ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) );
 
 		if( xTCPSegments == NULL )
@@ -318,19 +357,7 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 		}
 		else
 		{
-			/* Clear the allocated space. */
-			memset( xTCPSegments, '\0', ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) );
-
-			for( xIndex = 0; xIndex < ipconfigTCP_WIN_SEG_COUNT; xIndex++ )
-			{
-				/* Could call vListInitialiseItem here but all data has been
-				nulled already.  Set the owner to a segment descriptor. */
-				listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xListItem ), ( void* ) &( xTCPSegments[ xIndex ] ) );
-				listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xQueueItem ), ( void* ) &( xTCPSegments[ xIndex ] ) );
-
-				/* And add it to the pool of available segments */
-				vListInsertFifo( &xSegmentList, &( xTCPSegments[xIndex].xListItem ) );
-			}
+			prvAddSectors( xTCPSegments, ipconfigTCP_WIN_SEG_COUNT );
 
 			xReturn = pdPASS;
 		}
@@ -341,6 +368,66 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static void prvAddSectors( TCPSegment_t *pxSegments, BaseType_t xCount )
+	{
+	BaseType_t xIndex;
+
+		/* Clear the allocated space. */
+		memset( pxSegments, '\0', ( size_t ) xCount * sizeof( pxSegments[ 0 ] ) );
+
+		for( xIndex = 0; xIndex < xCount; xIndex++ )
+		{
+			/* Could call vListInitialiseItem here but all data has been
+			nulled already.  Set the owner to a segment descriptor. */
+			listSET_LIST_ITEM_OWNER( &( pxSegments[ xIndex ].xListItem ), ( void* ) &( pxSegments[ xIndex ] ) );
+			listSET_LIST_ITEM_OWNER( &( pxSegments[ xIndex ].xQueueItem ), ( void* ) &( pxSegments[ xIndex ] ) );
+
+			/* And add it to the pool of available segments */
+			vListInsertFifo( &xSegmentList, &( pxSegments[xIndex].xListItem ) );
+		}
+
+		uxSegmentCount += ( UBaseType_t ) xCount;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 ) )
+
+	static BaseType_t prvGrowSectors( void )
+	{
+	TCPSegmentBlock_t *pxBlock;
+	BaseType_t xReturn = pdFAIL;
+
+		if( ( uxSegmentCount + ipconfigTCP_WIN_SEG_GROW_COUNT ) <= ( UBaseType_t ) ipconfigTCP_WIN_SEG_MAX_COUNT )
+		{
+			pxBlock = ( TCPSegmentBlock_t * ) pvPortMallocLarge( sizeof( *pxBlock ) );
+
+			if( pxBlock == NULL )
+			{
+				FreeRTOS_debug_printf( ( "prvGrowSectors: malloc %lu failed\n", sizeof( *pxBlock ) ) );
+			}
+			else
+			{
+				/* Blocks are only freed by vTCPSegmentCleanup(), because their
+				descriptors get mixed with all others in 'xSegmentList'. */
+				prvAddSectors( pxBlock->xSegments, ipconfigTCP_WIN_SEG_GROW_COUNT );
+				pxBlock->pxNext = pxSegmentBlocks;
+				pxSegmentBlocks = pxBlock;
+
+				FreeRTOS_debug_printf( ( "prvGrowSectors: pool has now %lu segments\n", uxSegmentCount ) );
+				xReturn = pdPASS;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 ) */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP_WIN == 1 )
 
 	static TCPSegment_t *xTCPWindowRxFind( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber )
@@ -382,10 +469,20 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 		/* Allocate a new segment.  The socket will borrow all segments from a
 		common pool: 'xSegmentList', which is a list of 'TCPSegment_t' */
+		#if( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 )
+		{
+			if( listLIST_IS_EMPTY( &xSegmentList ) != pdFALSE )
+			{
+				( void ) prvGrowSectors();
+			}
+		}
+		#endif /* ipconfigTCP_WIN_SEG_GROW_COUNT */
+
 		if( listLIST_IS_EMPTY( &xSegmentList ) != pdFALSE )
 		{
 			/* If the TCP-stack runs out of segments, you might consider
-			increasing 'ipconfigTCP_WIN_SEG_COUNT'. */
+			increasing 'ipconfigTCP_WIN_SEG_COUNT' or
+			'ipconfigTCP_WIN_SEG_GROW_COUNT'. */
 			FreeRTOS_debug_printf( ( "xTCPWindow%cxNew: Error: all segments occupied\n", xIsForRx ? 'R' : 'T' ) );
 			pxSegment = NULL;
 		}
@@ -685,6 +782,34 @@ const int32_t l500ms = 500;
             vPortFreeLarge( xTCPSegments );
             xTCPSegments = NULL;
         }
+
+        #if( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 )
+        {
+        TCPSegmentBlock_t *pxBlock;
+
+            while( pxSegmentBlocks != NULL )
+            {
+                pxBlock = pxSegmentBlocks;
+                pxSegmentBlocks = pxBlock->pxNext;
+                vPortFreeLarge( pxBlock );
+            }
+        }
+        #endif /* ipconfigTCP_WIN_SEG_GROW_COUNT */
+
+        uxSegmentCount = 0u;
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxTCPSegmentPoolSize( UBaseType_t *puxFree )
+    {
+        /* Only the IP-task may call this function, or a task that has
+         * suspended the scheduler. */
+        if( puxFree != NULL )
+        {
+            *puxFree = ( xTCPSegments != NULL ) ? listCURRENT_LIST_LENGTH( &xSegmentList ) : 0u;
+        }
+
+        return uxSegmentCount;
     }
 
 #endif /* ipconfgiUSE_TCP_WIN == 1 */
@@ -1271,6 +1396,43 @@ const int32_t l500ms = 500;
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static void prvTCPWindowTxMarkSent( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment )
+	{
+		configASSERT( listLIST_ITEM_CONTAINER( &(pxSegment->xQueueItem ) ) == NULL );
+
+		/* Now that the segment will be transmitted, add it to the tail of
+		the waiting queue. */
+		vListInsertFifo( &pxWindow->xWaitQueue, &pxSegment->xQueueItem );
+
+		/* And mark it as outstanding. */
+		pxSegment->u.bits.bOutstanding = pdTRUE_UNSIGNED;
+
+		/* Administer the transmit count, needed for fast
+		retransmissions. */
+		( pxSegment->u.bits.ucTransmitCount )++;
+
+		/* If there have been several retransmissions (4), decrease the
+		size of the transmission window to at most 2 times MSS. */
+		if( pxSegment->u.bits.ucTransmitCount == MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW )
+		{
+			if( pxWindow->xSize.ulTxWindowLength > ( 2U * pxWindow->usMSS ) )
+			{
+				FreeRTOS_debug_printf( ( "ulTCPWindowTxGet[%u - %d]: Change Tx window: %lu -> %u\n",
+					pxWindow->usPeerPortNumber, pxWindow->usOurPortNumber,
+					pxWindow->xSize.ulTxWindowLength, 2 * pxWindow->usMSS ) );
+				pxWindow->xSize.ulTxWindowLength = ( 2UL * pxWindow->usMSS );
+			}
+		}
+
+		/* Clear the transmit timer. */
+		vTCPTimerSet( &( pxSegment->xTransmitTimer ) );
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP_WIN == 1 )
 
 	uint32_t ulTCPWindowTxGet( TCPWindow_t *pxWindow, uint32_t ulWindowSize, int32_t *plPosition )
@@ -1395,48 +1557,97 @@ const int32_t l500ms = 500;
 		/* See if it has already been determined to return 0. */
 		if( ulReturn != 0UL )
 		{
-			configASSERT( listLIST_ITEM_CONTAINER( &(pxSegment->xQueueItem ) ) == NULL );
+			prvTCPWindowTxMarkSent( pxWindow, pxSegment );
 
-			/* Now that the segment will be transmitted, add it to the tail of
-			the waiting queue. */
-			vListInsertFifo( &pxWindow->xWaitQueue, &pxSegment->xQueueItem );
+			pxWindow->ulOurSequenceNumber = pxSegment->ulSequenceNumber;
 
-			/* And mark it as outstanding. */
-			pxSegment->u.bits.bOutstanding = pdTRUE_UNSIGNED;
+			/* Inform the caller where to find the data within the queue. */
+			*plPosition = pxSegment->lStreamPos;
 
-			/* Administer the transmit count, needed for fast
-			retransmissions. */
-			( pxSegment->u.bits.ucTransmitCount )++;
+			/* And return the length of the data segment */
+			ulReturn = ( uint32_t ) pxSegment->lDataLength;
+		}
 
-			/* If there have been several retransmissions (4), decrease the
-			size of the transmission window to at most 2 times MSS. */
-			if( pxSegment->u.bits.ucTransmitCount == MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW )
+		return ulReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_LARGE_SEND != 0 )
+
+	uint32_t ulTCPWindowTxGetRun( TCPWindow_t *pxWindow, uint32_t ulWindowSize, int32_t *plPosition,
+		UBaseType_t uxMaxSegments, uint32_t *pulSegmentLength )
+	{
+	TCPSegment_t *pxSegment;
+	uint32_t ulFirstSequenceNumber, ulSegmentLength, ulReturn;
+	UBaseType_t uxCount;
+
+		/* The first segment may be of any kind: a priority segment, a
+		retransmission or new data. */
+		ulReturn = ulTCPWindowTxGet( pxWindow, ulWindowSize, plPosition );
+		ulSegmentLength = ulReturn;
+		ulFirstSequenceNumber = pxWindow->ulOurSequenceNumber;
+
+		/* Extend the run with new segments that follow it directly in
+		sequence space, and so also in the TX stream.  All segments except the
+		last one must have the same length, so that the run can be cut into
+		pieces of 'ulSegmentLength' bytes later on. */
+		for( uxCount = 1u; ( ulReturn != 0UL ) && ( uxCount < uxMaxSegments ); uxCount++ )
+		{
+			if( ulReturn != ( ( uint32_t ) uxCount ) * ulSegmentLength )
 			{
-				if( pxWindow->xSize.ulTxWindowLength > ( 2U * pxWindow->usMSS ) )
-				{
-					FreeRTOS_debug_printf( ( "ulTCPWindowTxGet[%u - %d]: Change Tx window: %lu -> %u\n",
-						pxWindow->usPeerPortNumber, pxWindow->usOurPortNumber,
-						pxWindow->xSize.ulTxWindowLength, 2 * pxWindow->usMSS ) );
-					pxWindow->xSize.ulTxWindowLength = ( 2UL * pxWindow->usMSS );
-				}
+				/* The previous segment was a short one, it ends the run. */
+				break;
 			}
 
-			/* Clear the transmit timer. */
-			vTCPTimerSet( &( pxSegment->xTransmitTimer ) );
+			if( listLIST_IS_EMPTY( &pxWindow->xPriorityQueue ) == pdFALSE )
+			{
+				break;
+			}
 
-			pxWindow->ulOurSequenceNumber = pxSegment->ulSequenceNumber;
+			pxSegment = xTCPWindowPeekHead( &( pxWindow->xTxQueue ) );
 
-			/* Inform the caller where to find the data within the queue. */
-			*plPosition = pxSegment->lStreamPos;
+			if( ( pxSegment == NULL ) ||
+				( pxSegment->ulSequenceNumber != ulFirstSequenceNumber + ulReturn ) ||
+				( ( uint32_t ) pxSegment->lDataLength > ulSegmentLength ) )
+			{
+				break;
+			}
 
-			/* And return the length of the data segment */
-			ulReturn = ( uint32_t ) pxSegment->lDataLength;
+			if( ( pxWindow->u.bits.bSendFullSize != pdFALSE_UNSIGNED ) && ( pxSegment->lDataLength < pxSegment->lMaxLength ) )
+			{
+				break;
+			}
+
+			if( prvTCPWindowTxHasSpace( pxWindow, ulWindowSize ) == pdFALSE )
+			{
+				break;
+			}
+
+			/* Move it out of the Tx queue, exactly like ulTCPWindowTxGet()
+			does. */
+			pxSegment = xTCPWindowGetHead( &( pxWindow->xTxQueue ) );
+
+			if( pxWindow->pxHeadSegment == pxSegment )
+			{
+				pxWindow->pxHeadSegment = NULL;
+			}
+
+			pxWindow->tx.ulHighestSequenceNumber = pxSegment->ulSequenceNumber + ( ( uint32_t ) pxSegment->lDataLength );
+			prvTCPWindowTxMarkSent( pxWindow, pxSegment );
+
+			ulReturn += ( uint32_t ) pxSegment->lDataLength;
 		}
 
+		/* 'ulOurSequenceNumber' and '*plPosition' still refer to the first
+		segment. */
+		*pulSegmentLength = ulSegmentLength;
+
 		return ulReturn;
 	}
 
-#endif /* ipconfigUSE_TCP_WIN == 1 */
+#endif /* ipconfigUSE_TCP_LARGE_SEND */
 /*-----------------------------------------------------------*/
 
 #if( ipconfigUSE_TCP_WIN == 1 )
@@ -0,0 +1,743 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/* Linux includes. */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/if_tun.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+/* The name of the host interface that is opened.  When the TAP interface is
+used it must have been created beforehand, see ReadMe.txt. */
+#ifndef configLINUX_NETWORK_INTERFACE_NAME
+	#define configLINUX_NETWORK_INTERFACE_NAME		"tap0"
+#endif
+
+/* Set to 1 to attach to an existing Ethernet interface with an AF_PACKET
+socket, instead of opening a TAP interface.  This needs CAP_NET_RAW. */
+#ifndef configLINUX_USE_AF_PACKET
+	#define configLINUX_USE_AF_PACKET				0
+#endif
+
+/* The time the task that simulates the MAC interrupt sleeps when there was
+nothing to do. */
+#ifndef configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY
+	#define configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY	( ( TickType_t ) 1 )
+#endif
+
+/* The number of frames that can be in flight between the FreeRTOS tasks and
+each of the two Linux threads.  Must be a power of 2. */
+#define niRING_LENGTH				64u
+#define niRING_MASK					( niRING_LENGTH - 1u )
+
+/* The time the Linux threads sleep when they can not make progress because the
+FreeRTOS side has not caught up yet. */
+#define niTHREAD_STARVED_SLEEP_US	200u
+
+/* The largest frame that is passed in either direction. */
+#define niMAX_FRAME_SIZE			( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER )
+
+#if( ( niRING_LENGTH & niRING_MASK ) != 0 )
+	#error niRING_LENGTH must be a power of 2
+#endif
+
+/* If ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES is set to 1, then the Ethernet
+driver will filter incoming packets and only pass the stack those packets it
+considers need processing. */
+#if( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 0 )
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eProcessBuffer
+#else
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eConsiderFrameForProcessing( ( pucEthernetBuffer ) )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* A single-producer, single-consumer ring of pointers.  One side is always a
+FreeRTOS task and the other side a Linux thread, so no FreeRTOS primitive can be
+used to protect it.  The indices are free running, only the producer writes
+ulHead and only the consumer writes ulTail. */
+typedef struct xFRAME_RING
+{
+	void *pvItems[ niRING_LENGTH ];
+	uint32_t ulHead;
+	uint32_t ulTail;
+} FrameRing_t;
+
+#if( ipconfigZERO_COPY_RX_DRIVER == 0 )
+	/* Without zero copy the Linux thread receives into one of these, and the
+	frame is copied into a network buffer of the exact size later. */
+	typedef struct xRX_FRAME_SLOT
+	{
+		size_t xLength;
+		uint8_t ucFrame[ niMAX_FRAME_SIZE ];
+	} RxFrameSlot_t;
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Linux threads that are outside of the control of the FreeRTOS scheduler do
+ * the blocking reads and writes on the host interface.
+ */
+static void *prvLinuxRecvThread( void *pvParam );
+static void *prvLinuxSendThread( void *pvParam );
+
+/*
+ * Open the TAP interface or the AF_PACKET socket, as selected by
+ * configLINUX_USE_AF_PACKET.  Returns the file descriptor, or -1.
+ */
+static int prvOpenInterface( const char *pcName );
+
+/*
+ * Start the two Linux threads and the task that simulates the MAC interrupt.
+ */
+static BaseType_t prvStartThreads( void );
+
+/*
+ * A task that simulates the Ethernet interrupt: it passes received frames to
+ * the IP-task, gives fresh buffers to the receive thread and releases the
+ * buffers that have been transmitted.
+ */
+static void prvInterruptSimulatorTask( void *pvParameters );
+
+/*
+ * Give as many empty buffers to the receive thread as it can hold.
+ */
+static void prvReplenishRxRing( void );
+
+/*
+ * Pass a received frame to the IP-task, or release it.
+ */
+static void prvPassFrameToIPTask( NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*
+ * Receive a single frame into pucBuffer, blocking until there is one.  Returns
+ * the length of the frame.
+ */
+static size_t prvReceiveFrame( uint8_t *pucBuffer );
+
+/*
+ * Ring access, see FrameRing_t.
+ */
+static BaseType_t prvRingPush( FrameRing_t *pxRing, void *pvItem );
+static void *prvRingPop( FrameRing_t *pxRing );
+
+/*-----------------------------------------------------------*/
+
+/* The file descriptor of the TAP interface or the AF_PACKET socket. */
+static int iInterfaceFd = -1;
+
+/* An eventfd that wakes up the send thread, and a flag that is set while a
+wake-up is on its way so the IP-task makes a system call at most once per batch
+of frames. */
+static int iSendEventFd = -1;
+static BaseType_t xSendKickPending = pdFALSE;
+
+/* Empty buffers for the receive thread, and the frames it has received. */
+static FrameRing_t xRxFreeRing;
+static FrameRing_t xRxDoneRing;
+
+/* Frames waiting to be sent, and network buffers that have been sent and that
+must be released by a FreeRTOS task. */
+static FrameRing_t xTxRing;
+static FrameRing_t xTxDoneRing;
+
+#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+	/* The number of network buffers that are owned by the receive thread.  Only
+	accessed by the MAC interrupt simulator task. */
+	static UBaseType_t uxRxBuffersOutstanding = 0u;
+#else
+	static RxFrameSlot_t xRxFrameSlots[ niRING_LENGTH ];
+#endif
+
+/* The destination addresses that are accepted when an AF_PACKET socket is used,
+as the socket is promiscuous and sees all the traffic of the host interface. */
+static uint8_t ucFilterMACAddress[ ipMAC_ADDRESS_LENGTH_BYTES ];
+
+/* Logs the failures, for viewing in the debugger only.  The send and receive
+counters are written by the Linux threads. */
+static volatile uint32_t ulLinuxSendFailures = 0;
+static volatile uint32_t ulLinuxRecvFailures = 0;
+static volatile uint32_t ulLinuxTxRingFull = 0;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+BaseType_t xReturn = pdFAIL;
+
+	/* The interface and the threads stay in place when the network is taken
+	down and up again. */
+	if( iInterfaceFd < 0 )
+	{
+		memcpy( ucFilterMACAddress, FreeRTOS_GetMACAddress(), sizeof( ucFilterMACAddress ) );
+
+		iInterfaceFd = prvOpenInterface( configLINUX_NETWORK_INTERFACE_NAME );
+
+		if( iInterfaceFd >= 0 )
+		{
+			if( prvStartThreads() != pdPASS )
+			{
+				close( iInterfaceFd );
+				iInterfaceFd = -1;
+			}
+		}
+	}
+
+	if( iInterfaceFd >= 0 )
+	{
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+NetworkBufferDescriptor_t *pxSendBuffer = pxNetworkBuffer;
+uint64_t ullKick = 1u;
+
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+	configASSERT( xIsCallingFromIPTask() == pdTRUE );
+
+	/* The send thread takes ownership of the network buffer, so the frame is
+	handed over without copying it.  Only when the caller keeps the buffer is a
+	copy made.  With ipconfigZERO_COPY_TX_DRIVER the stack always passes the
+	buffer. */
+	if( bReleaseAfterSend == pdFALSE )
+	{
+		pxSendBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+	}
+
+	if( pxSendBuffer != NULL )
+	{
+		if( ( pxSendBuffer->xDataLength > niMAX_FRAME_SIZE ) ||
+			( prvRingPush( &xTxRing, ( void * ) pxSendBuffer ) == pdFAIL ) )
+		{
+			ulLinuxTxRingFull++;
+			FreeRTOS_debug_printf( ( "xNetworkInterfaceOutput: send ring full to store %lu\n", pxSendBuffer->xDataLength ) );
+			vReleaseNetworkBufferAndDescriptor( pxSendBuffer );
+		}
+		else if( __atomic_exchange_n( &xSendKickPending, pdTRUE, __ATOMIC_SEQ_CST ) == pdFALSE )
+		{
+			/* The send thread may be sleeping. */
+			if( write( iSendEventFd, &ullKick, sizeof( ullKick ) ) != ( ssize_t ) sizeof( ullKick ) )
+			{
+				__atomic_store_n( &xSendKickPending, pdFALSE, __ATOMIC_SEQ_CST );
+			}
+		}
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static int prvOpenInterface( const char *pcName )
+{
+int iFd;
+struct ifreq xRequest;
+
+	memset( &xRequest, '\0', sizeof( xRequest ) );
+	strncpy( xRequest.ifr_name, pcName, IFNAMSIZ - 1 );
+
+	#if( configLINUX_USE_AF_PACKET == 0 )
+	{
+		iFd = open( "/dev/net/tun", O_RDWR | O_CLOEXEC );
+
+		if( iFd >= 0 )
+		{
+			/* Attach to the TAP interface without the packet information
+			header, so every read() and write() is exactly one Ethernet
+			frame. */
+			xRequest.ifr_flags = IFF_TAP | IFF_NO_PI;
+
+			if( ioctl( iFd, TUNSETIFF, ( void * ) &xRequest ) < 0 )
+			{
+				printf( "Failed to attach to TAP interface %s: %s\n", pcName, strerror( errno ) );
+				close( iFd );
+				iFd = -1;
+			}
+		}
+		else
+		{
+			printf( "Failed to open /dev/net/tun: %s\n", strerror( errno ) );
+		}
+	}
+	#else
+	{
+	struct sockaddr_ll xAddress;
+	struct packet_mreq xMembership;
+
+		iFd = socket( AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, htons( ETH_P_ALL ) );
+
+		if( iFd < 0 )
+		{
+			printf( "Failed to open an AF_PACKET socket: %s\n", strerror( errno ) );
+		}
+		else if( ioctl( iFd, SIOCGIFINDEX, ( void * ) &xRequest ) < 0 )
+		{
+			printf( "Unknown interface %s: %s\n", pcName, strerror( errno ) );
+			close( iFd );
+			iFd = -1;
+		}
+		else
+		{
+			memset( &xAddress, '\0', sizeof( xAddress ) );
+			xAddress.sll_family = AF_PACKET;
+			xAddress.sll_protocol = htons( ETH_P_ALL );
+			xAddress.sll_ifindex = xRequest.ifr_ifindex;
+
+			/* The MAC address of the stack is not the one of the interface,
+			so the interface must be promiscuous. */
+			memset( &xMembership, '\0', sizeof( xMembership ) );
+			xMembership.mr_ifindex = xRequest.ifr_ifindex;
+			xMembership.mr_type = PACKET_MR_PROMISC;
+
+			if( ( bind( iFd, ( struct sockaddr * ) &xAddress, sizeof( xAddress ) ) < 0 ) ||
+				( setsockopt( iFd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &xMembership, sizeof( xMembership ) ) < 0 ) )
+			{
+				printf( "Failed to bind to interface %s: %s\n", pcName, strerror( errno ) );
+				close( iFd );
+				iFd = -1;
+			}
+		}
+	}
+	#endif /* configLINUX_USE_AF_PACKET */
+
+	if( iFd >= 0 )
+	{
+		printf( "Successfully opened interface %s.\n", pcName );
+	}
+
+	return iFd;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvStartThreads( void )
+{
+BaseType_t xReturn = pdFAIL;
+pthread_t xRecvThread, xSendThread;
+sigset_t xAllSignals, xOldSignals;
+
+	iSendEventFd = eventfd( 0, EFD_CLOEXEC );
+
+	if( iSendEventFd >= 0 )
+	{
+		/* The Linux threads must never handle the signals that the FreeRTOS
+		port uses for its scheduler.  They inherit the signal mask of the
+		thread that creates them. */
+		sigfillset( &xAllSignals );
+		pthread_sigmask( SIG_SETMASK, &xAllSignals, &xOldSignals );
+
+		if( ( pthread_create( &xRecvThread, NULL, prvLinuxRecvThread, NULL ) == 0 ) &&
+			( pthread_create( &xSendThread, NULL, prvLinuxSendThread, NULL ) == 0 ) )
+		{
+			xReturn = pdPASS;
+		}
+
+		pthread_sigmask( SIG_SETMASK, &xOldSignals, NULL );
+	}
+
+	if( xReturn == pdPASS )
+	{
+		/* Create a task that simulates an interrupt in a real system.  It
+		hands buffers to, and collects them from, the Linux threads. */
+		prvReplenishRxRing();
+		xTaskCreate( prvInterruptSimulatorTask, "MAC_ISR", configMINIMAL_STACK_SIZE, NULL, configMAC_ISR_SIMULATOR_PRIORITY, NULL );
+	}
+	else
+	{
+		printf( "Failed to start the network interface threads: %s\n", strerror( errno ) );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRingPush( FrameRing_t *pxRing, void *pvItem )
+{
+BaseType_t xReturn = pdFAIL;
+uint32_t ulHead = pxRing->ulHead;
+
+	if( ( ulHead - __atomic_load_n( &( pxRing->ulTail ), __ATOMIC_ACQUIRE ) ) < niRING_LENGTH )
+	{
+		pxRing->pvItems[ ulHead & niRING_MASK ] = pvItem;
+
+		/* Publish the item.  This is sequentially consistent because the
+		producer reads a wake-up flag right after it, see
+		xNetworkInterfaceOutput(). */
+		__atomic_store_n( &( pxRing->ulHead ), ulHead + 1u, __ATOMIC_SEQ_CST );
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvRingPop( FrameRing_t *pxRing )
+{
+void *pvItem = NULL;
+uint32_t ulTail = pxRing->ulTail;
+
+	if( __atomic_load_n( &( pxRing->ulHead ), __ATOMIC_SEQ_CST ) != ulTail )
+	{
+		pvItem = pxRing->pvItems[ ulTail & niRING_MASK ];
+		__atomic_store_n( &( pxRing->ulTail ), ulTail + 1u, __ATOMIC_RELEASE );
+	}
+
+	return pvItem;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvReceiveFrame( uint8_t *pucBuffer )
+{
+ssize_t xBytes;
+size_t xReturn = 0u;
+
+	/* THIS IS CALLED FROM A LINUX THREAD - DO NOT ATTEMPT ANY FREERTOS CALLS
+	OR TO PRINT OUT MESSAGES HERE. */
+
+	while( xReturn == 0u )
+	{
+		#if( configLINUX_USE_AF_PACKET == 0 )
+		{
+			xBytes = read( iInterfaceFd, pucBuffer, niMAX_FRAME_SIZE );
+		}
+		#else
+		{
+		struct sockaddr_ll xFrom;
+		socklen_t xFromLength = sizeof( xFrom );
+
+			/* MSG_TRUNC returns the real length, so frames that are larger
+			than the MTU are detected below. */
+			xBytes = recvfrom( iInterfaceFd, pucBuffer, niMAX_FRAME_SIZE, MSG_TRUNC, ( struct sockaddr * ) &xFrom, &xFromLength );
+
+			if( xBytes >= ( ssize_t ) sizeof( EthernetHeader_t ) )
+			{
+				/* Drop the frames that the host sends itself, and the frames
+				that are neither for this MAC address nor broadcast or
+				multicast. */
+				if( ( xFrom.sll_pkttype == PACKET_OUTGOING ) ||
+					( ( ( pucBuffer[ 0 ] & 0x01u ) == 0u ) && ( memcmp( pucBuffer, ucFilterMACAddress, sizeof( ucFilterMACAddress ) ) != 0 ) ) )
+				{
+					continue;
+				}
+			}
+		}
+		#endif /* configLINUX_USE_AF_PACKET */
+
+		if( ( xBytes >= ( ssize_t ) sizeof( EthernetHeader_t ) ) && ( xBytes <= ( ssize_t ) niMAX_FRAME_SIZE ) )
+		{
+			xReturn = ( size_t ) xBytes;
+		}
+		else if( ( xBytes < 0 ) && ( errno != EINTR ) )
+		{
+			/* The interface may have been taken down on the host. */
+			ulLinuxRecvFailures++;
+			usleep( niTHREAD_STARVED_SLEEP_US );
+		}
+		else
+		{
+			/* Runt or oversized frame, or an interrupted system call. */
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvLinuxRecvThread( void *pvParam )
+{
+void *pvItem;
+
+	/* THIS IS A LINUX THREAD - DO NOT ATTEMPT ANY FREERTOS CALLS OR TO PRINT
+	OUT MESSAGES HERE. */
+
+	( void ) pvParam;
+
+	for( ;; )
+	{
+		pvItem = prvRingPop( &xRxFreeRing );
+
+		if( pvItem == NULL )
+		{
+			/* The FreeRTOS side has not given back any buffers yet.  The
+			frames are left in the socket buffer of the host in the meantime. */
+			usleep( niTHREAD_STARVED_SLEEP_US );
+			continue;
+		}
+
+		#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+		{
+		NetworkBufferDescriptor_t *pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) pvItem;
+
+			/* The frame is read straight into the network buffer that will be
+			passed to the IP-task. */
+			pxNetworkBuffer->xDataLength = prvReceiveFrame( pxNetworkBuffer->pucEthernetBuffer );
+		}
+		#else
+		{
+		RxFrameSlot_t *pxSlot = ( RxFrameSlot_t * ) pvItem;
+
+			pxSlot->xLength = prvReceiveFrame( pxSlot->ucFrame );
+		}
+		#endif /* ipconfigZERO_COPY_RX_DRIVER */
+
+		/* The number of items that circulate between the two rings is never
+		more than the length of one ring, so this can not fail. */
+		( void ) prvRingPush( &xRxDoneRing, pvItem );
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvLinuxSendThread( void *pvParam )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+uint64_t ullKicks;
+ssize_t xBytes;
+
+	/* THIS IS A LINUX THREAD - DO NOT ATTEMPT ANY FREERTOS CALLS OR TO PRINT
+	OUT MESSAGES HERE. */
+
+	( void ) pvParam;
+
+	for( ;; )
+	{
+		/* Wait until notified of something to send. */
+		if( read( iSendEventFd, &ullKicks, sizeof( ullKicks ) ) < 0 )
+		{
+			continue;
+		}
+
+		/* Clear the flag before draining the ring, so a frame that is added
+		after the last check below always causes a new wake-up. */
+		__atomic_store_n( &xSendKickPending, pdFALSE, __ATOMIC_SEQ_CST );
+
+		while( ( pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) prvRingPop( &xTxRing ) ) != NULL )
+		{
+			do
+			{
+				#if( configLINUX_USE_AF_PACKET == 0 )
+				{
+					xBytes = write( iInterfaceFd, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+				}
+				#else
+				{
+					xBytes = send( iInterfaceFd, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, 0 );
+				}
+				#endif
+			} while( ( xBytes < 0 ) && ( errno == EINTR ) );
+
+			if( xBytes != ( ssize_t ) pxNetworkBuffer->xDataLength )
+			{
+				ulLinuxSendFailures++;
+			}
+
+			/* Network buffers can only be released by a FreeRTOS task. */
+			while( prvRingPush( &xTxDoneRing, ( void * ) pxNetworkBuffer ) == pdFAIL )
+			{
+				usleep( niTHREAD_STARVED_SLEEP_US );
+			}
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReplenishRxRing( void )
+{
+	#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+		while( uxRxBuffersOutstanding < niRING_LENGTH )
+		{
+			pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( niMAX_FRAME_SIZE, ( TickType_t ) 0 );
+
+			if( pxNetworkBuffer == NULL )
+			{
+				/* Try again after the IP-task has released some buffers. */
+				break;
+			}
+
+			( void ) prvRingPush( &xRxFreeRing, ( void * ) pxNetworkBuffer );
+			uxRxBuffersOutstanding++;
+		}
+	}
+	#else
+	{
+	static BaseType_t xSlotsGiven = pdFALSE;
+	UBaseType_t uxSlot;
+
+		/* The slots are handed over once, after that they are returned to
+		the receive thread as soon as their frame has been copied. */
+		if( xSlotsGiven == pdFALSE )
+		{
+			for( uxSlot = 0u; uxSlot < niRING_LENGTH; uxSlot++ )
+			{
+				( void ) prvRingPush( &xRxFreeRing, ( void * ) &( xRxFrameSlots[ uxSlot ] ) );
+			}
+
+			xSlotsGiven = pdTRUE;
+		}
+	}
+	#endif /* ipconfigZERO_COPY_RX_DRIVER */
+}
+/*-----------------------------------------------------------*/
+
+static void prvPassFrameToIPTask( NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+BaseType_t xSent = pdFAIL;
+
+	iptraceNETWORK_INTERFACE_RECEIVE();
+
+	if( ipCONSIDER_FRAME_FOR_PROCESSING( pxNetworkBuffer->pucEthernetBuffer ) == eProcessBuffer )
+	{
+		#if( ipconfigUSE_RX_BATCHING != 0 )
+		{
+			/* This task is the only producer of the RX ring of the IP-task. */
+			xSent = xSendRxFrameToIPTask( pxNetworkBuffer );
+		}
+		#else
+		{
+		IPStackEvent_t xRxEvent;
+
+			xRxEvent.eEventType = eNetworkRxEvent;
+			xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+			xSent = xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 );
+		}
+		#endif /* ipconfigUSE_RX_BATCHING */
+
+		if( xSent == pdFAIL )
+		{
+			iptraceETHERNET_RX_EVENT_LOST();
+		}
+	}
+
+	if( xSent == pdFAIL )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvInterruptSimulatorTask( void *pvParameters )
+{
+void *pvItem;
+BaseType_t xDidWork;
+
+	/* Remove compiler warnings about unused parameters. */
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		xDidWork = pdFALSE;
+
+		/* Pass the received frames to the IP-task. */
+		while( ( pvItem = prvRingPop( &xRxDoneRing ) ) != NULL )
+		{
+			xDidWork = pdTRUE;
+
+			#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+			{
+				uxRxBuffersOutstanding--;
+				prvPassFrameToIPTask( ( NetworkBufferDescriptor_t * ) pvItem );
+			}
+			#else
+			{
+			RxFrameSlot_t *pxSlot = ( RxFrameSlot_t * ) pvItem;
+			NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+				/* This is only an interrupt simulator, not a real interrupt,
+				so it is ok to call the task level function here. */
+				pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( pxSlot->xLength, ( TickType_t ) 0 );
+
+				if( pxNetworkBuffer != NULL )
+				{
+					memcpy( pxNetworkBuffer->pucEthernetBuffer, pxSlot->ucFrame, pxSlot->xLength );
+					pxNetworkBuffer->xDataLength = pxSlot->xLength;
+				}
+
+				/* The slot can be reused immediately. */
+				( void ) prvRingPush( &xRxFreeRing, ( void * ) pxSlot );
+
+				if( pxNetworkBuffer != NULL )
+				{
+					prvPassFrameToIPTask( pxNetworkBuffer );
+				}
+				else
+				{
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+			#endif /* ipconfigZERO_COPY_RX_DRIVER */
+		}
+
+		/* Release the network buffers that have been transmitted. */
+		while( ( pvItem = prvRingPop( &xTxDoneRing ) ) != NULL )
+		{
+			xDidWork = pdTRUE;
+			vReleaseNetworkBufferAndDescriptor( ( NetworkBufferDescriptor_t * ) pvItem );
+		}
+
+		prvReplenishRxRing();
+
+		if( xDidWork == pdFALSE )
+		{
+			/* There is no real way of simulating an interrupt.  Make sure
+			other tasks can run. */
+			vTaskDelay( configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY );
+		}
+		else
+		{
+			taskYIELD();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
@@ -35,4 +35,43 @@ void TEST_FreeRTOS_TCP_prvCheckOptions( FreeRTOS_Socket_t * pxSocket,
 
 void TEST_FreeRTOS_TCP_prvTCPCreateWindow( FreeRTOS_Socket_t * pxSocket );
 
+/* Called by the IP-task for every packet that FreeRTOS_TCP_IP.c sends. When
+ * it returns pdFALSE, the packet is passed to xNetworkInterfaceOutput(). When
+ * it returns pdTRUE, the packet is not sent, and the hook must release the
+ * network buffer if xReleaseAfterSend is pdTRUE. */
+typedef BaseType_t ( * TCPOutputHook_t )( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                          BaseType_t xReleaseAfterSend );
+
+void TEST_FreeRTOS_TCP_SetOutputHook( TCPOutputHook_t xHook );
+
+#if ( ipconfigUSE_TCP_RX_COALESCING != 0 )
+    BaseType_t TEST_FreeRTOS_TCP_prvTCPMayCoalesce( NetworkBufferDescriptor_t * pxNetworkBuffer );
+
+    BaseType_t TEST_FreeRTOS_TCP_prvTCPCanExtendRun( NetworkBufferDescriptor_t * pxLast,
+                                                     NetworkBufferDescriptor_t * pxNext );
+#endif
+
+#if ( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+    uint32_t TEST_FreeRTOS_TCP_prvTCPLargeSendHeaderSum( const TCPPacket_t * pxTemplate );
+
+    void TEST_FreeRTOS_TCP_prvTCPLargeSendChecksums( TCPPacket_t * pxTCPPacket,
+                                                     const TCPPacket_t * pxTemplate,
+                                                     uint32_t ulHeaderSum,
+                                                     uint32_t ulDataLength );
+#endif
+
+#if ( ipconfigUSE_TCP_LARGE_SEND != 0 )
+    void TEST_FreeRTOS_TCP_SetLargeSendSegments( UBaseType_t uxSegments );
+#endif
+
+#if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+    void TEST_FreeRTOS_TCP_prvTCPRxAutoTuneStart( FreeRTOS_Socket_t * pxSocket );
+
+    void TEST_FreeRTOS_TCP_prvTCPRxAutoTune( FreeRTOS_Socket_t * pxSocket );
+
+    void TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( FreeRTOS_Socket_t * pxSocket,
+                                                   uint32_t ulBytesPerRTT,
+                                                   size_t uxFreeHeap );
+#endif
+
 #endif /* ifndef _AWS_FREERTOS_TCP_TEST_ACCESS_DECLARE_H_ */
@@ -50,4 +50,89 @@ void TEST_FreeRTOS_TCP_prvTCPCreateWindow( FreeRTOS_Socket_t * pxSocket )
 }
 /*-----------------------------------------------------------*/
 
+static TCPOutputHook_t xTCPOutputHook = NULL;
+
+void TEST_FreeRTOS_TCP_SetOutputHook( TCPOutputHook_t xHook )
+{
+    xTCPOutputHook = xHook;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvTCPNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                                BaseType_t xReleaseAfterSend )
+{
+    TCPOutputHook_t xHook = xTCPOutputHook;
+
+    if( ( xHook != NULL ) && ( xHook( pxNetworkBuffer, xReleaseAfterSend ) != pdFALSE ) )
+    {
+        return pdPASS;
+    }
+
+    /* The parentheses keep the macro in FreeRTOS_TCP_IP.c from expanding. */
+    return ( xNetworkInterfaceOutput )( pxNetworkBuffer, xReleaseAfterSend );
+}
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_TCP_RX_COALESCING != 0 )
+    BaseType_t TEST_FreeRTOS_TCP_prvTCPMayCoalesce( NetworkBufferDescriptor_t * pxNetworkBuffer )
+    {
+        return prvTCPMayCoalesce( pxNetworkBuffer );
+    }
+    /*-----------------------------------------------------------*/
+
+    BaseType_t TEST_FreeRTOS_TCP_prvTCPCanExtendRun( NetworkBufferDescriptor_t * pxLast,
+                                                     NetworkBufferDescriptor_t * pxNext )
+    {
+        return prvTCPCanExtendRun( pxLast, pxNext );
+    }
+    /*-----------------------------------------------------------*/
+#endif /* if ( ipconfigUSE_TCP_RX_COALESCING != 0 ) */
+
+#if ( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+    uint32_t TEST_FreeRTOS_TCP_prvTCPLargeSendHeaderSum( const TCPPacket_t * pxTemplate )
+    {
+        return prvTCPLargeSendHeaderSum( pxTemplate );
+    }
+    /*-----------------------------------------------------------*/
+
+    void TEST_FreeRTOS_TCP_prvTCPLargeSendChecksums( TCPPacket_t * pxTCPPacket,
+                                                     const TCPPacket_t * pxTemplate,
+                                                     uint32_t ulHeaderSum,
+                                                     uint32_t ulDataLength )
+    {
+        prvTCPLargeSendChecksums( pxTCPPacket, pxTemplate, ulHeaderSum, ulDataLength );
+    }
+    /*-----------------------------------------------------------*/
+#endif /* if ( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) ) */
+
+#if ( ipconfigUSE_TCP_LARGE_SEND != 0 )
+    void TEST_FreeRTOS_TCP_SetLargeSendSegments( UBaseType_t uxSegments )
+    {
+        uxLargeSendSegments = uxSegments;
+    }
+    /*-----------------------------------------------------------*/
+#endif /* if ( ipconfigUSE_TCP_LARGE_SEND != 0 ) */
+
+#if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+    void TEST_FreeRTOS_TCP_prvTCPRxAutoTuneStart( FreeRTOS_Socket_t * pxSocket )
+    {
+        prvTCPRxAutoTuneStart( pxSocket );
+    }
+    /*-----------------------------------------------------------*/
+
+    void TEST_FreeRTOS_TCP_prvTCPRxAutoTune( FreeRTOS_Socket_t * pxSocket )
+    {
+        prvTCPRxAutoTune( pxSocket );
+    }
+    /*-----------------------------------------------------------*/
+
+    void TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( FreeRTOS_Socket_t * pxSocket,
+                                                   uint32_t ulBytesPerRTT,
+                                                   size_t uxFreeHeap )
+    {
+        prvTCPRxAutoTuneUpdate( pxSocket, ulBytesPerRTT, uxFreeHeap );
+    }
+    /*-----------------------------------------------------------*/
+#endif /* if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 ) */
+
 #endif /* ifndef _AWS_FREERTOS_TCP_TEST_ACCESS_TCP_DEFINE_H_ */
@@ -30,10 +30,14 @@
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
 #include "list.h"
 #include "FreeRTOS_IP.h"
 #include "FreeRTOS_IP_Private.h"
 #include "FreeRTOS_DNS.h"
+#include "FreeRTOS_Sockets.h"
+#include "NetworkBufferManagement.h"
 
 /* Test includes. */
 #include "unity_fixture.h"
@@ -43,6 +47,70 @@
 /**
  * @brief Configuration for this test group.
  */
+#define tcptestRX_BENCHMARK_FRAME_COUNT      2000
+#define tcptestRX_BENCHMARK_PAYLOAD_SIZE     1024
+#define tcptestRX_BENCHMARK_PORT             5001
+#define tcptestRX_BENCHMARK_TIMEOUT_MS       1000
+#define tcptestRX_COALESCE_PAYLOAD_SIZE      100
+#define tcptestRX_COALESCE_RUN               4
+#define tcptestRX_COALESCE_WAIT_MS           100
+#define tcptestLARGE_SEND_MSS                1000
+#define tcptestLARGE_SEND_PAYLOAD_SIZE       1460
+#define tcptestLARGE_SEND_BENCHMARK_COUNT    5000
+#define tcptestLARGE_SEND_BULK_SIZE          ( 32u * ipconfigTCP_TX_BUFFER_LENGTH )
+#define tcptestLARGE_SEND_CHUNK_SIZE         ( 4u * ipconfigTCP_MSS )
+#define tcptestLARGE_SEND_SPARE_BUFFERS      4
+#define tcptestLARGE_SEND_TIMEOUT_MS         5000
+#define tcptestSEGMENT_POOL_MSS              100
+#define tcptestAUTOTUNE_RTT_MS               50
+#define tcptestAUTOTUNE_LINK_BDP             ( 24u * ipconfigTCP_MSS )
+#define tcptestAUTOTUNE_ROUNDS               12
+#define tcptestPEER_LISTEN_PORT              5002
+#define tcptestPEER_PORT                     49200
+#define tcptestPEER_ISS                      0x7ffff000UL
+#define tcptestPEER_TIMEOUT_MS               1000
+
+/* The tests that exchange segments with a peer, which is emulated by the test
+ * task itself. */
+#define tcptestUSE_PEER                           \
+    ( ( ipconfigUSE_TCP_RX_COALESCING != 0 ) ||   \
+      ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 ) ||     \
+      ( ipconfigUSE_TCP_LARGE_SEND != 0 ) )
+
+/* The period of the data that the peer and the socket send each other. */
+#define tcptestPATTERN_PERIOD                251u
+
+/* The TCP flags, as in FreeRTOS_TCP_IP.c. */
+#define tcptestTCP_FLAG_FIN                  0x01u
+#define tcptestTCP_FLAG_SYN                  0x02u
+#define tcptestTCP_FLAG_RST                  0x04u
+#define tcptestTCP_FLAG_PSH                  0x08u
+#define tcptestTCP_FLAG_ACK                  0x10u
+
+#if ( tcptestUSE_PEER != 0 )
+
+/**
+ * @brief A TCP peer at this node's own address, which talks to one socket of
+ * this node. Its segments are passed to the IP-task as if the driver received
+ * them, and the segments sent to it are taken by an output hook.
+ */
+    typedef struct TCPTestPeer
+    {
+        Socket_t xListenSocket;    /**< Listens on tcptestPEER_LISTEN_PORT. */
+        Socket_t xSocket;          /**< The connection that was accepted. */
+        uint32_t ulFirstSequence;  /**< The sequence number of the first byte that the peer sends. */
+        uint32_t ulAckNumber;      /**< The next sequence number that the peer expects. */
+        uint16_t usWindow;         /**< The window that the peer advertises. */
+        uint16_t usPeerWindow;     /**< The last window that the socket advertised. */
+    } TCPTestPeer_t;
+
+    static TCPTestPeer_t xPeer;
+
+/* The segments that were sent to the peer. */
+    static QueueHandle_t xPeerQueue = NULL;
+
+    static void prvPeerClose( TCPTestPeer_t * pxPeer );
+#endif /* if ( tcptestUSE_PEER != 0 ) */
 
 /*
  * @brief Test group definition.
@@ -55,6 +123,14 @@ TEST_SETUP( Full_FREERTOS_TCP )
 
 TEST_TEAR_DOWN( Full_FREERTOS_TCP )
 {
+    #if ( tcptestUSE_PEER != 0 )
+        /* Also after a failed assertion. */
+        prvPeerClose( &xPeer );
+    #endif
+
+    #if ( ipconfigUSE_TCP_LARGE_SEND != 0 )
+        TEST_FreeRTOS_TCP_SetLargeSendSegments( ( UBaseType_t ) ipconfigTCP_LARGE_SEND_SEGMENTS );
+    #endif
 }
 
 TEST_GROUP_RUNNER( Full_FREERTOS_TCP )
@@ -68,6 +144,21 @@ TEST_GROUP_RUNNER( Full_FREERTOS_TCP )
 
     /* xProcessReceivedUDPPacket test. */
     RUN_TEST_CASE( Full_FREERTOS_TCP, UDPPacketLength );
+
+    /* Batched reception tests. */
+    RUN_TEST_CASE( Full_FREERTOS_TCP, TCPRxCoalescing );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, TCPRxCoalescingConnection );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, RxBatchThroughput );
+
+    /* Large send tests. */
+    RUN_TEST_CASE( Full_FREERTOS_TCP, TCPLargeSendRun );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, TCPLargeSendChecksum );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, TCPLargeSendBulk );
+
+    /* Segment pool and reception window tuning tests. */
+    RUN_TEST_CASE( Full_FREERTOS_TCP, TCPSegmentPoolGrow );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, TCPRxAutoTuneDelayedLink );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, TCPRxAutoTuneMemoryPressure );
 }
 
 TEST( Full_FREERTOS_TCP, prvParseDnsResponse )
@@ -360,3 +451,1421 @@ TEST( Full_FREERTOS_TCP, UDPPacketLength )
     xReturn = xProcessReceivedUDPPacket( &xNetworkBuffer, usPort );
     TEST_ASSERT_EQUAL_UINT32( pdFAIL, xReturn );
 }
+
+/*-----------------------------------------------------------*/
+
+#if ( tcptestUSE_PEER != 0 )
+
+/* The data that the peer and the socket send each other: a pattern with a
+ * period that doesn't divide the segment size, so that a segment that is lost
+ * or stored at the wrong place shows. */
+    static uint8_t prvPatternByte( uint32_t ulOffset )
+    {
+        return ( uint8_t ) ( ulOffset % tcptestPATTERN_PERIOD );
+    }
+
+/* The number of bytes of data in a segment. */
+    static size_t prvPeerDataLength( const TCPPacket_t * pxTCPPacket )
+    {
+        return ( size_t ) FreeRTOS_ntohs( pxTCPPacket->xIPHeader.usLength ) - ipSIZE_OF_IPv4_HEADER -
+               ( size_t ) ( ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) * 4u );
+    }
+
+/* Runs in the IP-task: queue every segment that is sent to the peer's port. A
+ * buffer that the IP-task keeps is copied. Other packets go to the driver. */
+    static BaseType_t prvPeerOutputHook( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                         BaseType_t xReleaseAfterSend )
+    {
+        const TCPPacket_t * pxTCPPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+        NetworkBufferDescriptor_t * pxCopy = pxNetworkBuffer;
+
+        if( pxTCPPacket->xTCPHeader.usDestinationPort != FreeRTOS_htons( tcptestPEER_PORT ) )
+        {
+            return pdFALSE;
+        }
+
+        if( xReleaseAfterSend == pdFALSE )
+        {
+            pxCopy = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+        }
+
+        /* A segment that doesn't fit is lost, as it might be on a real link. */
+        if( ( pxCopy != NULL ) && ( xQueueSendToBack( xPeerQueue, &pxCopy, 0 ) != pdPASS ) )
+        {
+            vReleaseNetworkBufferAndDescriptor( pxCopy );
+        }
+
+        return pdTRUE;
+    }
+
+/* Make a segment from the peer, with xLength bytes of the pattern that belong
+ * at ulSequenceNumber. A SYN only carries an MSS option, so neither side will
+ * scale its window. Returns NULL when there is no network buffer. */
+    static NetworkBufferDescriptor_t * prvPeerBuildSegment( const TCPTestPeer_t * pxPeer,
+                                                            uint32_t ulSequenceNumber,
+                                                            uint8_t ucFlags,
+                                                            size_t xLength )
+    {
+        NetworkBufferDescriptor_t * pxNetworkBuffer;
+        TCPPacket_t * pxTCPPacket;
+        const size_t xOptionsLength = ( ( ucFlags & tcptestTCP_FLAG_SYN ) != 0u ) ? 4u : 0u;
+        const size_t xHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + xOptionsLength;
+        size_t xIndex;
+        uint16_t usChecksum;
+
+        pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( xHeaderLength + xLength, pdMS_TO_TICKS( tcptestPEER_TIMEOUT_MS ) );
+
+        if( pxNetworkBuffer != NULL )
+        {
+            pxTCPPacket = ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+            pxNetworkBuffer->xDataLength = xHeaderLength + xLength;
+            memset( pxNetworkBuffer->pucEthernetBuffer, 0, xHeaderLength );
+
+            /* Like prvBuildUDPFrame(), this node appears to talk to itself. */
+            memcpy( &( pxTCPPacket->xEthernetHeader.xDestinationAddress ), ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
+            memcpy( &( pxTCPPacket->xEthernetHeader.xSourceAddress ), ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
+            pxTCPPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+
+            pxTCPPacket->xIPHeader.ucVersionHeaderLength = 0x45;
+            pxTCPPacket->xIPHeader.usLength = FreeRTOS_htons( ( uint16_t ) ( pxNetworkBuffer->xDataLength - ipSIZE_OF_ETH_HEADER ) );
+            pxTCPPacket->xIPHeader.ucTimeToLive = ipconfigTCP_TIME_TO_LIVE;
+            pxTCPPacket->xIPHeader.ucProtocol = ipPROTOCOL_TCP;
+            pxTCPPacket->xIPHeader.ulSourceIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+            pxTCPPacket->xIPHeader.ulDestinationIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+            usChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxTCPPacket->xIPHeader ), ipSIZE_OF_IPv4_HEADER );
+            pxTCPPacket->xIPHeader.usHeaderChecksum = ( uint16_t ) ~FreeRTOS_htons( usChecksum );
+
+            pxTCPPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( tcptestPEER_PORT );
+            pxTCPPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( tcptestPEER_LISTEN_PORT );
+            pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber );
+            pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + xOptionsLength ) << 2 );
+            pxTCPPacket->xTCPHeader.ucTCPFlags = ucFlags;
+            pxTCPPacket->xTCPHeader.usWindow = FreeRTOS_htons( pxPeer->usWindow );
+
+            if( ( ucFlags & tcptestTCP_FLAG_ACK ) != 0u )
+            {
+                pxTCPPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( pxPeer->ulAckNumber );
+            }
+
+            if( xOptionsLength != 0u )
+            {
+                pxTCPPacket->xTCPHeader.ucOptdata[ 0 ] = 2u; /* MSS */
+                pxTCPPacket->xTCPHeader.ucOptdata[ 1 ] = 4u;
+                pxTCPPacket->xTCPHeader.ucOptdata[ 2 ] = ( uint8_t ) ( ipconfigTCP_MSS >> 8 );
+                pxTCPPacket->xTCPHeader.ucOptdata[ 3 ] = ( uint8_t ) ( ipconfigTCP_MSS & 0xffu );
+            }
+
+            for( xIndex = 0; xIndex < xLength; xIndex++ )
+            {
+                pxNetworkBuffer->pucEthernetBuffer[ xHeaderLength + xIndex ] =
+                    prvPatternByte( ulSequenceNumber - pxPeer->ulFirstSequence + ( uint32_t ) xIndex );
+            }
+
+            ( void ) usGenerateProtocolChecksum( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdTRUE );
+        }
+
+        return pxNetworkBuffer;
+    }
+
+/* Pass a segment to the IP-task, either through the RX ring or with an
+ * eNetworkRxEvent, and release it when that fails. */
+    static BaseType_t prvPeerSend( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                   BaseType_t xUseRing )
+    {
+        IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+        BaseType_t xResult;
+
+        if( pxNetworkBuffer == NULL )
+        {
+            return pdFAIL;
+        }
+
+        #if ( ipconfigUSE_RX_BATCHING != 0 )
+            if( xUseRing != pdFALSE )
+            {
+                xResult = xSendRxFrameToIPTask( pxNetworkBuffer );
+            }
+            else
+        #else
+            ( void ) xUseRing;
+        #endif
+        {
+            xRxEvent.pvData = pxNetworkBuffer;
+            xResult = xSendEventStructToIPTask( &xRxEvent, pdMS_TO_TICKS( tcptestPEER_TIMEOUT_MS ) );
+        }
+
+        if( xResult != pdPASS )
+        {
+            vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+        }
+
+        return xResult;
+    }
+
+/* Wait for the next segment sent to the peer, and remember the window that it
+ * advertises. The caller releases it. */
+    static NetworkBufferDescriptor_t * prvPeerReceive( TCPTestPeer_t * pxPeer,
+                                                       TickType_t xTimeout )
+    {
+        NetworkBufferDescriptor_t * pxNetworkBuffer = NULL;
+
+        if( xQueueReceive( xPeerQueue, &pxNetworkBuffer, xTimeout ) != pdPASS )
+        {
+            return NULL;
+        }
+
+        pxPeer->usPeerWindow = FreeRTOS_ntohs( ( ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer )->xTCPHeader.usWindow );
+
+        return pxNetworkBuffer;
+    }
+
+/* Let a listening socket accept a connection from the peer. The socket gets
+ * pxWinProperties, when not NULL. The ACK of the handshake is sent
+ * xHandshakeDelay ticks after the SYN+ACK, which is what the socket will
+ * measure as the round-trip time. */
+    static BaseType_t prvPeerConnect( TCPTestPeer_t * pxPeer,
+                                      const WinProperties_t * pxWinProperties,
+                                      TickType_t xHandshakeDelay )
+    {
+        struct freertos_sockaddr xAddress = { 0 };
+        TickType_t xTimeout = pdMS_TO_TICKS( tcptestPEER_TIMEOUT_MS );
+        NetworkBufferDescriptor_t * pxNetworkBuffer;
+        TCPPacket_t * pxTCPPacket;
+        BaseType_t xResult = pdFAIL;
+
+        memset( pxPeer, 0, sizeof( *pxPeer ) );
+        pxPeer->ulFirstSequence = tcptestPEER_ISS + 1u;
+        pxPeer->usWindow = 0xffffu;
+
+        xPeerQueue = xQueueCreate( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, sizeof( NetworkBufferDescriptor_t * ) );
+
+        if( xPeerQueue == NULL )
+        {
+            return pdFAIL;
+        }
+
+        TEST_FreeRTOS_TCP_SetOutputHook( prvPeerOutputHook );
+
+        pxPeer->xListenSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+        if( pxPeer->xListenSocket == FREERTOS_INVALID_SOCKET )
+        {
+            pxPeer->xListenSocket = NULL;
+
+            return pdFAIL;
+        }
+
+        /* The timeout of FreeRTOS_accept(). */
+        FreeRTOS_setsockopt( pxPeer->xListenSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeout, sizeof( xTimeout ) );
+        xAddress.sin_port = FreeRTOS_htons( tcptestPEER_LISTEN_PORT );
+
+        /* The accepted socket inherits the properties. */
+        if( ( pxWinProperties != NULL ) &&
+            ( FreeRTOS_setsockopt( pxPeer->xListenSocket, 0, FREERTOS_SO_WIN_PROPERTIES, ( void * ) pxWinProperties, sizeof( *pxWinProperties ) ) != 0 ) )
+        {
+            return pdFAIL;
+        }
+
+        if( ( FreeRTOS_bind( pxPeer->xListenSocket, &xAddress, sizeof( xAddress ) ) != 0 ) ||
+            ( FreeRTOS_listen( pxPeer->xListenSocket, 1 ) != 0 ) )
+        {
+            return pdFAIL;
+        }
+
+        if( prvPeerSend( prvPeerBuildSegment( pxPeer, tcptestPEER_ISS, tcptestTCP_FLAG_SYN, 0 ), pdFALSE ) != pdPASS )
+        {
+            return pdFAIL;
+        }
+
+        pxNetworkBuffer = prvPeerReceive( pxPeer, xTimeout );
+
+        if( pxNetworkBuffer != NULL )
+        {
+            pxTCPPacket = ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+
+            if( ( pxTCPPacket->xTCPHeader.ucTCPFlags == ( tcptestTCP_FLAG_SYN | tcptestTCP_FLAG_ACK ) ) &&
+                ( FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr ) == pxPeer->ulFirstSequence ) )
+            {
+                pxPeer->ulAckNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ) + 1u;
+                xResult = pdPASS;
+            }
+
+            vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+        }
+
+        if( xResult == pdPASS )
+        {
+            vTaskDelay( xHandshakeDelay );
+            xResult = prvPeerSend( prvPeerBuildSegment( pxPeer, pxPeer->ulFirstSequence, tcptestTCP_FLAG_ACK, 0 ), pdFALSE );
+        }
+
+        if( xResult == pdPASS )
+        {
+            pxPeer->xSocket = FreeRTOS_accept( pxPeer->xListenSocket, NULL, NULL );
+
+            if( ( pxPeer->xSocket == NULL ) || ( pxPeer->xSocket == FREERTOS_INVALID_SOCKET ) )
+            {
+                pxPeer->xSocket = NULL;
+                xResult = pdFAIL;
+            }
+        }
+
+        return xResult;
+    }
+
+/* Close the sockets, and drop the segments that the peer didn't look at. */
+    static void prvPeerClose( TCPTestPeer_t * pxPeer )
+    {
+        NetworkBufferDescriptor_t * pxNetworkBuffer;
+
+        if( xPeerQueue == NULL )
+        {
+            return;
+        }
+
+        if( pxPeer->xSocket != NULL )
+        {
+            FreeRTOS_closesocket( pxPeer->xSocket );
+        }
+
+        if( pxPeer->xListenSocket != NULL )
+        {
+            FreeRTOS_closesocket( pxPeer->xListenSocket );
+        }
+
+        /* The IP-task sends what it has to send about the closed sockets
+         * before the hook is taken away. */
+        vTaskDelay( pdMS_TO_TICKS( 10 ) );
+        TEST_FreeRTOS_TCP_SetOutputHook( NULL );
+
+        while( xQueueReceive( xPeerQueue, &pxNetworkBuffer, 0 ) == pdPASS )
+        {
+            vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+        }
+
+        vQueueDelete( xPeerQueue );
+        xPeerQueue = NULL;
+        memset( pxPeer, 0, sizeof( *pxPeer ) );
+    }
+
+#endif /* if ( tcptestUSE_PEER != 0 ) */
+
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_TCP_RX_COALESCING != 0 )
+
+/* Fill in the headers of a TCP segment from 10.0.0.2:1234 to 10.0.0.1:80,
+ * followed by xPayloadSize bytes. Returns the frame length. */
+    static size_t prvBuildTCPSegment( uint8_t * pucFrame,
+                                      uint32_t ulSequenceNumber,
+                                      uint32_t ulAckNumber,
+                                      uint8_t ucFlags,
+                                      size_t xPayloadSize )
+    {
+        TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) pucFrame;
+        size_t xFrameLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + xPayloadSize;
+
+        memset( pucFrame, 0, xFrameLength );
+        pxTCPPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+        pxTCPPacket->xIPHeader.ucVersionHeaderLength = 0x45;
+        pxTCPPacket->xIPHeader.usLength = FreeRTOS_htons( xFrameLength - ipSIZE_OF_ETH_HEADER );
+        pxTCPPacket->xIPHeader.ucProtocol = ipPROTOCOL_TCP;
+        pxTCPPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_inet_addr_quick( 10, 0, 0, 2 );
+        pxTCPPacket->xIPHeader.ulDestinationIPAddress = FreeRTOS_inet_addr_quick( 10, 0, 0, 1 );
+        pxTCPPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( 1234 );
+        pxTCPPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( 80 );
+        pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber );
+        pxTCPPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( ulAckNumber );
+        pxTCPPacket->xTCPHeader.ucTCPOffset = 0x50;
+        pxTCPPacket->xTCPHeader.ucTCPFlags = ucFlags;
+        pxTCPPacket->xTCPHeader.usWindow = FreeRTOS_htons( 2920 );
+
+        return xFrameLength;
+    }
+
+#endif /* if ( ipconfigUSE_TCP_RX_COALESCING != 0 ) */
+
+TEST( Full_FREERTOS_TCP, TCPRxCoalescing )
+{
+    #if ( ipconfigUSE_TCP_RX_COALESCING != 0 )
+        uint8_t ucFirst[ sizeof( TCPPacket_t ) + tcptestRX_COALESCE_PAYLOAD_SIZE ];
+        uint8_t ucSecond[ sizeof( TCPPacket_t ) + tcptestRX_COALESCE_PAYLOAD_SIZE ];
+        NetworkBufferDescriptor_t xFirst = { 0 };
+        NetworkBufferDescriptor_t xSecond = { 0 };
+        TCPPacket_t * pxSecond = ( TCPPacket_t * ) ucSecond;
+        const uint8_t ucAck = 0x10, ucAckPush = 0x18, ucAckFin = 0x11, ucSyn = 0x02;
+
+        xFirst.pucEthernetBuffer = ucFirst;
+        xSecond.pucEthernetBuffer = ucSecond;
+
+        /* Two data segments, the second one starting where the first one ends. */
+        xFirst.xDataLength = prvBuildTCPSegment( ucFirst, 1000, 5000, ucAck, tcptestRX_COALESCE_PAYLOAD_SIZE );
+        xSecond.xDataLength = prvBuildTCPSegment( ucSecond, 1000 + tcptestRX_COALESCE_PAYLOAD_SIZE, 5000, ucAckPush, tcptestRX_COALESCE_PAYLOAD_SIZE );
+        TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_prvTCPMayCoalesce( &xFirst ) );
+        TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_prvTCPMayCoalesce( &xSecond ) );
+        TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_prvTCPCanExtendRun( &xFirst, &xSecond ) );
+
+        /* A gap, or a retransmission, ends the run. */
+        pxSecond->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( 1001 + tcptestRX_COALESCE_PAYLOAD_SIZE );
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPCanExtendRun( &xFirst, &xSecond ) );
+        pxSecond->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( 1000 );
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPCanExtendRun( &xFirst, &xSecond ) );
+        pxSecond->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( 1000 + tcptestRX_COALESCE_PAYLOAD_SIZE );
+
+        /* So does a new acknowledgement, a new window, or another connection. */
+        pxSecond->xTCPHeader.ulAckNr = FreeRTOS_htonl( 5100 );
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPCanExtendRun( &xFirst, &xSecond ) );
+        pxSecond->xTCPHeader.ulAckNr = FreeRTOS_htonl( 5000 );
+        pxSecond->xTCPHeader.usWindow = FreeRTOS_htons( 1460 );
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPCanExtendRun( &xFirst, &xSecond ) );
+        pxSecond->xTCPHeader.usWindow = FreeRTOS_htons( 2920 );
+        pxSecond->xTCPHeader.usSourcePort = FreeRTOS_htons( 1235 );
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPCanExtendRun( &xFirst, &xSecond ) );
+
+        /* Segments with other flags, with options, or without payload are
+         * always handled on their own. */
+        xSecond.xDataLength = prvBuildTCPSegment( ucSecond, 1100, 5000, ucAckFin, tcptestRX_COALESCE_PAYLOAD_SIZE );
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPMayCoalesce( &xSecond ) );
+        xSecond.xDataLength = prvBuildTCPSegment( ucSecond, 1100, 5000, ucSyn, tcptestRX_COALESCE_PAYLOAD_SIZE );
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPMayCoalesce( &xSecond ) );
+        xSecond.xDataLength = prvBuildTCPSegment( ucSecond, 1100, 5000, ucAck, tcptestRX_COALESCE_PAYLOAD_SIZE );
+        pxSecond->xTCPHeader.ucTCPOffset = 0x60;
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPMayCoalesce( &xSecond ) );
+        xSecond.xDataLength = prvBuildTCPSegment( ucSecond, 1100, 5000, ucAck, 0 );
+        TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvTCPMayCoalesce( &xSecond ) );
+    #else /* if ( ipconfigUSE_TCP_RX_COALESCING != 0 ) */
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_RX_COALESCING is not enabled." );
+    #endif /* if ( ipconfigUSE_TCP_RX_COALESCING != 0 ) */
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_TCP_RX_COALESCING != 0 )
+
+/* Pass xCount segments of tcptestRX_COALESCE_PAYLOAD_SIZE bytes, starting
+ * ulOffset bytes into the peer's data, to the IP-task in a single batch. */
+    static BaseType_t prvPeerSendBatch( TCPTestPeer_t * pxPeer,
+                                        uint32_t ulOffset,
+                                        BaseType_t xCount )
+    {
+        NetworkBufferDescriptor_t * pxSegments[ tcptestRX_COALESCE_RUN ];
+        BaseType_t xIndex, xResult = pdPASS;
+
+        configASSERT( xCount <= tcptestRX_COALESCE_RUN );
+
+        for( xIndex = 0; xIndex < xCount; xIndex++ )
+        {
+            pxSegments[ xIndex ] = prvPeerBuildSegment( pxPeer,
+                                                        pxPeer->ulFirstSequence + ulOffset + ( uint32_t ) xIndex * tcptestRX_COALESCE_PAYLOAD_SIZE,
+                                                        tcptestTCP_FLAG_ACK | tcptestTCP_FLAG_PSH,
+                                                        tcptestRX_COALESCE_PAYLOAD_SIZE );
+
+            if( pxSegments[ xIndex ] == NULL )
+            {
+                xResult = pdFAIL;
+            }
+        }
+
+        /* The IP-task must not start on the ring before all segments are in
+         * it. Nothing in here blocks. */
+        vTaskSuspendAll();
+        {
+            for( xIndex = 0; xIndex < xCount; xIndex++ )
+            {
+                if( pxSegments[ xIndex ] == NULL )
+                {
+                    continue;
+                }
+
+                if( ( xResult != pdPASS ) || ( xSendRxFrameToIPTask( pxSegments[ xIndex ] ) != pdPASS ) )
+                {
+                    vReleaseNetworkBufferAndDescriptor( pxSegments[ xIndex ] );
+                    xResult = pdFAIL;
+                }
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return xResult;
+    }
+
+/* Count the segments that are sent to the peer within
+ * tcptestRX_COALESCE_WAIT_MS, and return the acknowledgement number of the
+ * last one. */
+    static uint32_t prvPeerCollectAcks( TCPTestPeer_t * pxPeer,
+                                        BaseType_t * pxCount )
+    {
+        NetworkBufferDescriptor_t * pxNetworkBuffer;
+        TCPPacket_t * pxTCPPacket;
+        TickType_t xStart = xTaskGetTickCount();
+        const TickType_t xWaitTime = pdMS_TO_TICKS( tcptestRX_COALESCE_WAIT_MS );
+        TickType_t xElapsed;
+        uint32_t ulAckNumber = 0;
+
+        *pxCount = 0;
+
+        while( ( xElapsed = xTaskGetTickCount() - xStart ) < xWaitTime )
+        {
+            pxNetworkBuffer = prvPeerReceive( pxPeer, xWaitTime - xElapsed );
+
+            if( pxNetworkBuffer != NULL )
+            {
+                pxTCPPacket = ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+
+                /* The socket has nothing to send: only acknowledgements. */
+                if( ( pxTCPPacket->xTCPHeader.ucTCPFlags == tcptestTCP_FLAG_ACK ) &&
+                    ( prvPeerDataLength( pxTCPPacket ) == 0u ) )
+                {
+                    ulAckNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr );
+                }
+
+                ( *pxCount )++;
+                vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+            }
+        }
+
+        return ulAckNumber;
+    }
+
+/* Compare the bytes that the socket holds for its owner with the pattern,
+ * without taking them. */
+    static BaseType_t prvStreamHoldsPattern( FreeRTOS_Socket_t * pxSocket,
+                                             uint32_t ulOffset,
+                                             size_t uxLength )
+    {
+        static uint8_t ucBuffer[ tcptestRX_COALESCE_RUN * tcptestRX_COALESCE_PAYLOAD_SIZE ];
+        StreamBuffer_t * pxStream = pxSocket->u.xTCP.rxStream;
+        size_t uxIndex;
+
+        if( ( pxStream == NULL ) || ( uxLength > sizeof( ucBuffer ) ) ||
+            ( uxStreamBufferGetSize( pxStream ) != uxLength ) ||
+            ( uxStreamBufferGet( pxStream, 0, ucBuffer, uxLength, pdTRUE ) != uxLength ) )
+        {
+            return pdFALSE;
+        }
+
+        for( uxIndex = 0; uxIndex < uxLength; uxIndex++ )
+        {
+            if( ucBuffer[ uxIndex ] != prvPatternByte( ulOffset + ( uint32_t ) uxIndex ) )
+            {
+                return pdFALSE;
+            }
+        }
+
+        return pdTRUE;
+    }
+
+#endif /* if ( ipconfigUSE_TCP_RX_COALESCING != 0 ) */
+
+/* Pass runs of segments for an established connection to the IP-task through
+ * the RX ring, so that each run is handled as one segment. */
+TEST( Full_FREERTOS_TCP, TCPRxCoalescingConnection )
+{
+    #if ( ipconfigUSE_TCP_RX_COALESCING != 0 )
+        static uint8_t ucBuffer[ tcptestRX_COALESCE_RUN * tcptestRX_COALESCE_PAYLOAD_SIZE ];
+        const uint32_t ulRunLength = tcptestRX_COALESCE_RUN * tcptestRX_COALESCE_PAYLOAD_SIZE;
+        const WinProperties_t xWinProperties =
+        {
+            ipconfigTCP_TX_BUFFER_LENGTH, 1,
+            ipconfigTCP_RX_BUFFER_LENGTH, 1
+        };
+        FreeRTOS_Socket_t * pxSocket;
+        BaseType_t xAcks;
+        uint32_t ulAckNumber;
+
+        if( FreeRTOS_IsNetworkUp() == pdFALSE )
+        {
+            TEST_IGNORE_MESSAGE( "The network is not up." );
+        }
+
+        /* With a window of one MSS, every segment that is handled on its own
+         * leaves too little space for a delayed ACK, and gets its own ACK. */
+        TEST_ASSERT_EQUAL( pdPASS, prvPeerConnect( &xPeer, &xWinProperties, 0 ) );
+        pxSocket = ( FreeRTOS_Socket_t * ) xPeer.xSocket;
+
+        /* A run of segments in order. */
+        TEST_ASSERT_EQUAL( pdPASS, prvPeerSendBatch( &xPeer, 0, tcptestRX_COALESCE_RUN ) );
+        ulAckNumber = prvPeerCollectAcks( &xPeer, &xAcks );
+        TEST_ASSERT_EQUAL( 1, xAcks );
+        TEST_ASSERT_EQUAL_UINT32( xPeer.ulFirstSequence + ulRunLength, ulAckNumber );
+        TEST_ASSERT_EQUAL( pdTRUE, prvStreamHoldsPattern( pxSocket, 0, ulRunLength ) );
+        TEST_ASSERT_EQUAL( ( BaseType_t ) ulRunLength, FreeRTOS_recv( xPeer.xSocket, ucBuffer, sizeof( ucBuffer ), FREERTOS_MSG_DONTWAIT ) );
+
+        /* The next run without its first segment: it is stored in front of
+         * the head, and the ACK still asks for the missing segment. */
+        TEST_ASSERT_EQUAL( pdPASS, prvPeerSendBatch( &xPeer, ulRunLength + tcptestRX_COALESCE_PAYLOAD_SIZE, tcptestRX_COALESCE_RUN - 1 ) );
+        ulAckNumber = prvPeerCollectAcks( &xPeer, &xAcks );
+        TEST_ASSERT_EQUAL( 1, xAcks );
+        TEST_ASSERT_EQUAL_UINT32( xPeer.ulFirstSequence + ulRunLength, ulAckNumber );
+        TEST_ASSERT_EQUAL_UINT32( 0, uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream ) );
+        #if ( ipconfigUSE_TCP_WIN == 1 )
+            /* The window stored the run as one segment. */
+            TEST_ASSERT_EQUAL_UINT32( 1, listCURRENT_LIST_LENGTH( &( pxSocket->u.xTCP.xTCPWindow.xRxSegments ) ) );
+        #endif
+
+        /* The missing segment makes the whole run available, in order. */
+        TEST_ASSERT_EQUAL( pdPASS, prvPeerSendBatch( &xPeer, ulRunLength, 1 ) );
+        ulAckNumber = prvPeerCollectAcks( &xPeer, &xAcks );
+        TEST_ASSERT_EQUAL( 1, xAcks );
+        TEST_ASSERT_EQUAL_UINT32( xPeer.ulFirstSequence + 2u * ulRunLength, ulAckNumber );
+        TEST_ASSERT_EQUAL( pdTRUE, prvStreamHoldsPattern( pxSocket, ulRunLength, ulRunLength ) );
+        TEST_ASSERT_EQUAL( eESTABLISHED, pxSocket->u.xTCP.ucTCPState );
+    #else /* if ( ipconfigUSE_TCP_RX_COALESCING != 0 ) */
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_RX_COALESCING is not enabled." );
+    #endif /* if ( ipconfigUSE_TCP_RX_COALESCING != 0 ) */
+}
+
+/*-----------------------------------------------------------*/
+
+/* Fill a network buffer with a UDP frame that this node appears to have sent
+ * to itself, so that the ARP cache doesn't learn a made-up address. The UDP
+ * checksum is left at zero, which means it is not used. */
+static void prvBuildUDPFrame( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                              uint16_t usPort,
+                              size_t xPayloadSize )
+{
+    UDPPacket_t * pxUDPPacket = ( UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+    uint16_t usChecksum;
+
+    pxNetworkBuffer->xDataLength = sizeof( UDPPacket_t ) + xPayloadSize;
+    memset( pxNetworkBuffer->pucEthernetBuffer, 0, sizeof( UDPPacket_t ) );
+    memcpy( &( pxUDPPacket->xEthernetHeader.xDestinationAddress ), ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
+    memcpy( &( pxUDPPacket->xEthernetHeader.xSourceAddress ), ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
+    pxUDPPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+
+    pxUDPPacket->xIPHeader.ucVersionHeaderLength = 0x45;
+    pxUDPPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_UDP_HEADER + xPayloadSize );
+    pxUDPPacket->xIPHeader.ucTimeToLive = ipconfigUDP_TIME_TO_LIVE;
+    pxUDPPacket->xIPHeader.ucProtocol = ipPROTOCOL_UDP;
+    pxUDPPacket->xIPHeader.ulSourceIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+    pxUDPPacket->xIPHeader.ulDestinationIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+    usChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxUDPPacket->xIPHeader ), ipSIZE_OF_IPv4_HEADER );
+    pxUDPPacket->xIPHeader.usHeaderChecksum = ( uint16_t ) ~FreeRTOS_htons( usChecksum );
+
+    pxUDPPacket->xUDPHeader.usSourcePort = FreeRTOS_htons( usPort );
+    pxUDPPacket->xUDPHeader.usDestinationPort = FreeRTOS_htons( usPort );
+    pxUDPPacket->xUDPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_UDP_HEADER + xPayloadSize );
+}
+
+/* Pass tcptestRX_BENCHMARK_FRAME_COUNT frames to the IP-task, either with an
+ * eNetworkRxEvent per frame or through the RX ring, and return the number of
+ * ticks until the socket had received all of them. */
+static TickType_t prvRxBenchmarkRun( Socket_t xSocket,
+                                     BaseType_t xUseRing,
+                                     uint32_t * pulReceived )
+{
+    IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+    NetworkBufferDescriptor_t * pxNetworkBuffer;
+    struct freertos_sockaddr xSource;
+    socklen_t xSourceLength = sizeof( xSource );
+    uint8_t * pucPayload;
+    uint32_t ulSent = 0, ulReceived = 0;
+    BaseType_t xResult;
+    TickType_t xStart;
+    const uint32_t ulMaxInFlight = ipconfigUDP_MAX_RX_PACKETS > 0 ? ipconfigUDP_MAX_RX_PACKETS : ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 2 );
+
+    xStart = xTaskGetTickCount();
+
+    while( ulReceived < tcptestRX_BENCHMARK_FRAME_COUNT )
+    {
+        /* Keep the socket's receive queue from overflowing. */
+        while( ( ulSent < tcptestRX_BENCHMARK_FRAME_COUNT ) && ( ( ulSent - ulReceived ) < ulMaxInFlight ) )
+        {
+            pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( sizeof( UDPPacket_t ) + tcptestRX_BENCHMARK_PAYLOAD_SIZE, 0 );
+
+            if( pxNetworkBuffer == NULL )
+            {
+                break;
+            }
+
+            prvBuildUDPFrame( pxNetworkBuffer, tcptestRX_BENCHMARK_PORT, tcptestRX_BENCHMARK_PAYLOAD_SIZE );
+
+            #if ( ipconfigUSE_RX_BATCHING != 0 )
+                if( xUseRing != pdFALSE )
+                {
+                    xResult = xSendRxFrameToIPTask( pxNetworkBuffer );
+                }
+                else
+            #endif
+            {
+                xRxEvent.pvData = pxNetworkBuffer;
+                xResult = xSendEventStructToIPTask( &xRxEvent, 0 );
+            }
+
+            if( xResult != pdPASS )
+            {
+                vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+                break;
+            }
+
+            ulSent++;
+        }
+
+        if( FreeRTOS_recvfrom( xSocket, &pucPayload, 0, FREERTOS_ZERO_COPY, &xSource, &xSourceLength ) <= 0 )
+        {
+            /* A frame got lost. */
+            break;
+        }
+
+        FreeRTOS_ReleaseUDPPayloadBuffer( pucPayload );
+        ulReceived++;
+    }
+
+    *pulReceived = ulReceived;
+
+    return xTaskGetTickCount() - xStart;
+}
+
+/* Measure how many frames per second the IP-task delivers to a UDP socket,
+ * when the driver sends one event per frame and when it uses the RX ring.
+ * The frames are injected by this task, so the network driver must not be
+ * using the RX ring itself while the test runs. */
+TEST( Full_FREERTOS_TCP, RxBatchThroughput )
+{
+    Socket_t xSocket;
+    struct freertos_sockaddr xBindAddress;
+    TickType_t xTimeout = pdMS_TO_TICKS( tcptestRX_BENCHMARK_TIMEOUT_MS );
+    TickType_t xTicks;
+    uint32_t ulReceived = 0;
+    BaseType_t xUseRing;
+
+    if( FreeRTOS_IsNetworkUp() == pdFALSE )
+    {
+        TEST_IGNORE_MESSAGE( "The network is not up." );
+    }
+
+    xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+    TEST_ASSERT_NOT_EQUAL( FREERTOS_INVALID_SOCKET, xSocket );
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeout, sizeof( xTimeout ) );
+
+    xBindAddress.sin_port = FreeRTOS_htons( tcptestRX_BENCHMARK_PORT );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_bind( xSocket, &xBindAddress, sizeof( xBindAddress ) ) );
+
+    for( xUseRing = pdFALSE; xUseRing <= ( ipconfigUSE_RX_BATCHING != 0 ); xUseRing++ )
+    {
+        xTicks = prvRxBenchmarkRun( xSocket, xUseRing, &ulReceived );
+
+        configPRINTF( ( "RX %s: %u frames of %u bytes in %u ms, %u frames/s\r\n",
+                        ( xUseRing != pdFALSE ) ? "ring" : "events",
+                        ( unsigned ) ulReceived,
+                        ( unsigned ) tcptestRX_BENCHMARK_PAYLOAD_SIZE,
+                        ( unsigned ) ( xTicks * portTICK_PERIOD_MS ),
+                        ( unsigned ) ( ( ( uint64_t ) ulReceived * configTICK_RATE_HZ ) / ( xTicks > 0 ? xTicks : 1 ) ) ) );
+
+        if( ulReceived != tcptestRX_BENCHMARK_FRAME_COUNT )
+        {
+            break;
+        }
+    }
+
+    FreeRTOS_closesocket( xSocket );
+
+    TEST_ASSERT_EQUAL_UINT32( tcptestRX_BENCHMARK_FRAME_COUNT, ulReceived );
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_FREERTOS_TCP, TCPLargeSendRun )
+{
+    #if ( ipconfigUSE_TCP_LARGE_SEND != 0 )
+        TCPWindow_t xWindow;
+        uint32_t ulLength[ 4 ], ulSegmentLength[ 4 ], ulSequenceNumber[ 4 ];
+        int32_t lPosition[ 4 ] = { 0 };
+        const uint32_t ulFirstSequenceNumber = 10000;
+
+        memset( &xWindow, 0, sizeof( xWindow ) );
+
+        /* The segment pool is shared with the IP-task. */
+        vTaskSuspendAll();
+        {
+            vTCPWindowCreate( &xWindow, 8 * tcptestLARGE_SEND_MSS, 8 * tcptestLARGE_SEND_MSS, 5000, ulFirstSequenceNumber, tcptestLARGE_SEND_MSS );
+
+            /* Five full segments and a short one. */
+            ( void ) lTCPWindowTxAdd( &xWindow, 5 * tcptestLARGE_SEND_MSS + 300, 0, 65536 );
+
+            /* A run stops at the maximum number of segments, after a short
+             * segment, or when the window is empty. */
+            ulLength[ 0 ] = ulTCPWindowTxGetRun( &xWindow, 65536, &lPosition[ 0 ], 4, &ulSegmentLength[ 0 ] );
+            ulSequenceNumber[ 0 ] = xWindow.ulOurSequenceNumber;
+            ulLength[ 1 ] = ulTCPWindowTxGetRun( &xWindow, 65536, &lPosition[ 1 ], 4, &ulSegmentLength[ 1 ] );
+            ulSequenceNumber[ 1 ] = xWindow.ulOurSequenceNumber;
+            ulLength[ 2 ] = ulTCPWindowTxGetRun( &xWindow, 65536, &lPosition[ 2 ], 4, &ulSegmentLength[ 2 ] );
+            vTCPWindowDestroy( &xWindow );
+
+            /* A run never exceeds the window of the peer. */
+            memset( &xWindow, 0, sizeof( xWindow ) );
+            vTCPWindowCreate( &xWindow, 8 * tcptestLARGE_SEND_MSS, 8 * tcptestLARGE_SEND_MSS, 5000, ulFirstSequenceNumber, tcptestLARGE_SEND_MSS );
+            ( void ) lTCPWindowTxAdd( &xWindow, 5 * tcptestLARGE_SEND_MSS, 0, 65536 );
+            ulLength[ 3 ] = ulTCPWindowTxGetRun( &xWindow, 2 * tcptestLARGE_SEND_MSS + 500, &lPosition[ 3 ], 8, &ulSegmentLength[ 3 ] );
+            ulSequenceNumber[ 3 ] = xWindow.ulOurSequenceNumber;
+            vTCPWindowDestroy( &xWindow );
+        }
+        ( void ) xTaskResumeAll();
+
+        TEST_ASSERT_EQUAL_UINT32( 4 * tcptestLARGE_SEND_MSS, ulLength[ 0 ] );
+        TEST_ASSERT_EQUAL_UINT32( tcptestLARGE_SEND_MSS, ulSegmentLength[ 0 ] );
+        TEST_ASSERT_EQUAL_INT32( 0, lPosition[ 0 ] );
+        TEST_ASSERT_EQUAL_UINT32( ulFirstSequenceNumber, ulSequenceNumber[ 0 ] );
+
+        TEST_ASSERT_EQUAL_UINT32( tcptestLARGE_SEND_MSS + 300, ulLength[ 1 ] );
+        TEST_ASSERT_EQUAL_UINT32( tcptestLARGE_SEND_MSS, ulSegmentLength[ 1 ] );
+        TEST_ASSERT_EQUAL_INT32( 4 * tcptestLARGE_SEND_MSS, lPosition[ 1 ] );
+        TEST_ASSERT_EQUAL_UINT32( ulFirstSequenceNumber + 4 * tcptestLARGE_SEND_MSS, ulSequenceNumber[ 1 ] );
+
+        TEST_ASSERT_EQUAL_UINT32( 0, ulLength[ 2 ] );
+
+        TEST_ASSERT_EQUAL_UINT32( 2 * tcptestLARGE_SEND_MSS, ulLength[ 3 ] );
+        TEST_ASSERT_EQUAL_UINT32( ulFirstSequenceNumber, ulSequenceNumber[ 3 ] );
+    #else /* if ( ipconfigUSE_TCP_LARGE_SEND != 0 ) */
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_LARGE_SEND is not enabled." );
+    #endif /* if ( ipconfigUSE_TCP_LARGE_SEND != 0 ) */
+}
+
+/*-----------------------------------------------------------*/
+
+/* Check the checksums of segments that are made from a template, and compare
+ * the time needed to prepare the headers with a full checksum calculation for
+ * every segment. */
+TEST( Full_FREERTOS_TCP, TCPLargeSendChecksum )
+{
+    #if ( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+        static uint8_t ucTemplate[ sizeof( TCPPacket_t ) ];
+        static uint8_t ucSegment[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + tcptestLARGE_SEND_PAYLOAD_SIZE ];
+        TCPPacket_t * pxTemplate = ( TCPPacket_t * ) ucTemplate;
+        TCPPacket_t * pxSegment = ( TCPPacket_t * ) ucSegment;
+        const size_t xHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+        uint32_t ulHeaderSum, ulIndex, ulDataLength;
+        uint16_t usChecksum;
+        TickType_t xStart, xFullTicks, xTemplateTicks;
+
+        /* A template, with valid checksums, as prvTCPReturnPacket() makes it. */
+        memset( ucTemplate, 0, sizeof( ucTemplate ) );
+        pxTemplate->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+        pxTemplate->xIPHeader.ucVersionHeaderLength = 0x45;
+        pxTemplate->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + tcptestLARGE_SEND_PAYLOAD_SIZE );
+        pxTemplate->xIPHeader.usIdentification = FreeRTOS_htons( 0xfff0 );
+        pxTemplate->xIPHeader.ucTimeToLive = ipconfigTCP_TIME_TO_LIVE;
+        pxTemplate->xIPHeader.ucProtocol = ipPROTOCOL_TCP;
+        pxTemplate->xIPHeader.ulSourceIPAddress = FreeRTOS_inet_addr_quick( 192, 168, 0, 2 );
+        pxTemplate->xIPHeader.ulDestinationIPAddress = FreeRTOS_inet_addr_quick( 192, 168, 0, 1 );
+        usChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxTemplate->xIPHeader ), ipSIZE_OF_IPv4_HEADER );
+        pxTemplate->xIPHeader.usHeaderChecksum = ( uint16_t ) ~FreeRTOS_htons( usChecksum );
+        pxTemplate->xTCPHeader.usSourcePort = FreeRTOS_htons( 5001 );
+        pxTemplate->xTCPHeader.usDestinationPort = FreeRTOS_htons( 49152 );
+        pxTemplate->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( 0xfffff000UL );
+        pxTemplate->xTCPHeader.ulAckNr = FreeRTOS_htonl( 12345 );
+        pxTemplate->xTCPHeader.ucTCPOffset = 0x50;
+        pxTemplate->xTCPHeader.ucTCPFlags = 0x18;
+        pxTemplate->xTCPHeader.usWindow = FreeRTOS_htons( 2920 );
+
+        ulHeaderSum = TEST_FreeRTOS_TCP_prvTCPLargeSendHeaderSum( pxTemplate );
+
+        for( ulIndex = 0; ulIndex < tcptestLARGE_SEND_PAYLOAD_SIZE; ulIndex++ )
+        {
+            ucSegment[ xHeaderLength + ulIndex ] = ( uint8_t ) ( ulIndex * 7 );
+        }
+
+        /* Segments of different sizes, with a sequence number that wraps, a
+         * wrapping identification and a FIN flag. */
+        for( ulIndex = 0; ulIndex < 32; ulIndex++ )
+        {
+            ulDataLength = tcptestLARGE_SEND_PAYLOAD_SIZE - ( ulIndex * 37 );
+            memcpy( ucSegment, ucTemplate, xHeaderLength );
+            pxSegment->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( 0xfffff000UL + ulIndex * tcptestLARGE_SEND_PAYLOAD_SIZE );
+            pxSegment->xTCPHeader.ucTCPFlags = ( ( ulIndex & 1 ) != 0 ) ? 0x19 : 0x18;
+            pxSegment->xIPHeader.usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + ulDataLength ) );
+            pxSegment->xIPHeader.usIdentification = FreeRTOS_htons( ( uint16_t ) ( 0xfff0 + ulIndex ) );
+
+            TEST_FreeRTOS_TCP_prvTCPLargeSendChecksums( pxSegment, pxTemplate, ulHeaderSum, ulDataLength );
+
+            TEST_ASSERT_EQUAL_HEX16( 0xffff, usGenerateChecksum( 0UL, ( uint8_t * ) &( pxSegment->xIPHeader ), ipSIZE_OF_IPv4_HEADER ) );
+            TEST_ASSERT_EQUAL_HEX16( 0xffff, usGenerateProtocolChecksum( ucSegment, xHeaderLength + ulDataLength, pdFALSE ) );
+        }
+
+        /* Time the preparation of full-size segments both ways. */
+        memcpy( ucSegment, ucTemplate, xHeaderLength );
+        xStart = xTaskGetTickCount();
+
+        for( ulIndex = 0; ulIndex < tcptestLARGE_SEND_BENCHMARK_COUNT; ulIndex++ )
+        {
+            pxSegment->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulIndex * tcptestLARGE_SEND_PAYLOAD_SIZE );
+            pxSegment->xIPHeader.usIdentification = FreeRTOS_htons( ( uint16_t ) ulIndex );
+            pxSegment->xIPHeader.usHeaderChecksum = 0u;
+            usChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxSegment->xIPHeader ), ipSIZE_OF_IPv4_HEADER );
+            pxSegment->xIPHeader.usHeaderChecksum = ( uint16_t ) ~FreeRTOS_htons( usChecksum );
+            ( void ) usGenerateProtocolChecksum( ucSegment, sizeof( ucSegment ), pdTRUE );
+        }
+
+        xFullTicks = xTaskGetTickCount() - xStart;
+        xStart = xTaskGetTickCount();
+
+        for( ulIndex = 0; ulIndex < tcptestLARGE_SEND_BENCHMARK_COUNT; ulIndex++ )
+        {
+            pxSegment->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulIndex * tcptestLARGE_SEND_PAYLOAD_SIZE );
+            pxSegment->xIPHeader.usIdentification = FreeRTOS_htons( ( uint16_t ) ulIndex );
+            TEST_FreeRTOS_TCP_prvTCPLargeSendChecksums( pxSegment, pxTemplate, ulHeaderSum, tcptestLARGE_SEND_PAYLOAD_SIZE );
+        }
+
+        xTemplateTicks = xTaskGetTickCount() - xStart;
+
+        configPRINTF( ( "Large send: %u segments of %u bytes, full checksums %u ms, from template %u ms\r\n",
+                        ( unsigned ) tcptestLARGE_SEND_BENCHMARK_COUNT,
+                        ( unsigned ) tcptestLARGE_SEND_PAYLOAD_SIZE,
+                        ( unsigned ) ( xFullTicks * portTICK_PERIOD_MS ),
+                        ( unsigned ) ( xTemplateTicks * portTICK_PERIOD_MS ) ) );
+
+        TEST_ASSERT_EQUAL_HEX16( 0xffff, usGenerateProtocolChecksum( ucSegment, sizeof( ucSegment ), pdFALSE ) );
+    #else /* if ( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) ) */
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_LARGE_SEND is not enabled, or the driver calculates checksums." );
+    #endif /* if ( ( ipconfigUSE_TCP_LARGE_SEND != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) ) */
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_TCP_LARGE_SEND != 0 )
+
+/* What the peer saw of the data that the socket sent. Offsets count from the
+ * first byte of the connection. */
+    typedef struct LargeSendResult
+    {
+        uint32_t ulQueued;    /**< The number of bytes passed to FreeRTOS_send(). */
+        uint32_t ulReceived;  /**< The number of bytes received in order. */
+        uint32_t ulSegments;  /**< The number of segments with data. */
+        uint32_t ulBad;       /**< Segments with a bad checksum, length, flag or data. */
+        uint32_t ulGaps;      /**< Segments that started beyond ulReceived. */
+        uint32_t ulFins;      /**< Segments with a FIN flag. */
+        uint32_t ulFinOffset; /**< Where the first FIN was. */
+        uint32_t ulFinLength; /**< The data length of the first segment with a FIN. */
+    } LargeSendResult_t;
+
+/* Take the segments that were sent to the peer, waiting xTimeout for the
+ * first one, and check every one of them. ulFirst is the sequence number of
+ * the first byte. Returns the number of segments. */
+    static BaseType_t prvLargeSendReceive( TCPTestPeer_t * pxPeer,
+                                           uint32_t ulFirst,
+                                           LargeSendResult_t * pxResult,
+                                           TickType_t xTimeout )
+    {
+        NetworkBufferDescriptor_t * pxNetworkBuffer;
+        const TCPPacket_t * pxTCPPacket;
+        const uint8_t * pucData;
+        uint32_t ulOffset, ulLength, ulIndex;
+        BaseType_t xCount = 0;
+
+        while( ( pxNetworkBuffer = prvPeerReceive( pxPeer, ( xCount == 0 ) ? xTimeout : 0 ) ) != NULL )
+        {
+            pxTCPPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+            ulOffset = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ) - ulFirst;
+            ulLength = ( uint32_t ) prvPeerDataLength( pxTCPPacket );
+            pucData = &( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER +
+                                                             ( ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) * 4u ) ] );
+
+            if( ( ulLength > ipconfigTCP_MSS ) ||
+                ( ( pxTCPPacket->xTCPHeader.ucTCPFlags & ( tcptestTCP_FLAG_SYN | tcptestTCP_FLAG_RST ) ) != 0u ) )
+            {
+                pxResult->ulBad++;
+            }
+
+            #if ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+                if( ( usGenerateChecksum( 0UL, ( const uint8_t * ) &( pxTCPPacket->xIPHeader ), ipSIZE_OF_IPv4_HEADER ) != 0xffffu ) ||
+                    ( usGenerateProtocolChecksum( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdFALSE ) != 0xffffu ) )
+                {
+                    pxResult->ulBad++;
+                }
+            #endif
+
+            for( ulIndex = 0; ulIndex < ulLength; ulIndex++ )
+            {
+                if( pucData[ ulIndex ] != prvPatternByte( ulOffset + ulIndex ) )
+                {
+                    pxResult->ulBad++;
+                    break;
+                }
+            }
+
+            if( ulLength != 0u )
+            {
+                pxResult->ulSegments++;
+
+                if( ulOffset > pxResult->ulReceived )
+                {
+                    pxResult->ulGaps++;
+                }
+                else if( ( ulOffset + ulLength ) > pxResult->ulReceived )
+                {
+                    pxResult->ulReceived = ulOffset + ulLength;
+                }
+            }
+
+            if( ( pxTCPPacket->xTCPHeader.ucTCPFlags & tcptestTCP_FLAG_FIN ) != 0u )
+            {
+                if( pxResult->ulFins == 0u )
+                {
+                    pxResult->ulFinOffset = ulOffset + ulLength;
+                    pxResult->ulFinLength = ulLength;
+                }
+                else if( pxResult->ulFinOffset != ( ulOffset + ulLength ) )
+                {
+                    /* A FIN must always be at the same place. */
+                    pxResult->ulBad++;
+                }
+
+                pxResult->ulFins++;
+            }
+
+            vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+            xCount++;
+        }
+
+        return xCount;
+    }
+
+/* Acknowledge the data that the peer received in order, and the FIN when it
+ * follows that data. */
+    static BaseType_t prvLargeSendAck( TCPTestPeer_t * pxPeer,
+                                       uint32_t ulFirst,
+                                       const LargeSendResult_t * pxResult )
+    {
+        pxPeer->ulAckNumber = ulFirst + pxResult->ulReceived;
+
+        if( ( pxResult->ulFins != 0u ) && ( pxResult->ulFinOffset == pxResult->ulReceived ) )
+        {
+            pxPeer->ulAckNumber++;
+        }
+
+        return prvPeerSend( prvPeerBuildSegment( pxPeer, pxPeer->ulFirstSequence, tcptestTCP_FLAG_ACK, 0 ), pdFALSE );
+    }
+
+/* Pass the pattern to the socket until ulEnd bytes were passed, without
+ * blocking. */
+    static void prvLargeSendQueue( TCPTestPeer_t * pxPeer,
+                                   LargeSendResult_t * pxResult,
+                                   uint32_t ulEnd )
+    {
+        static uint8_t ucPattern[ tcptestLARGE_SEND_CHUNK_SIZE + tcptestPATTERN_PERIOD ];
+        static BaseType_t xPatternReady = pdFALSE;
+        uint32_t ulIndex;
+        BaseType_t xSent;
+
+        /* Any offset in the pattern starts within its first period. */
+        if( xPatternReady == pdFALSE )
+        {
+            for( ulIndex = 0; ulIndex < sizeof( ucPattern ); ulIndex++ )
+            {
+                ucPattern[ ulIndex ] = prvPatternByte( ulIndex );
+            }
+
+            xPatternReady = pdTRUE;
+        }
+
+        while( pxResult->ulQueued < ulEnd )
+        {
+            xSent = FreeRTOS_send( pxPeer->xSocket,
+                                   &( ucPattern[ pxResult->ulQueued % tcptestPATTERN_PERIOD ] ),
+                                   FreeRTOS_min_uint32( ulEnd - pxResult->ulQueued, tcptestLARGE_SEND_CHUNK_SIZE ),
+                                   FREERTOS_MSG_DONTWAIT );
+
+            if( xSent <= 0 )
+            {
+                break;
+            }
+
+            pxResult->ulQueued += ( uint32_t ) xSent;
+        }
+    }
+
+/* Let the socket send the pattern until the peer received ulEnd bytes in
+ * order, and acknowledge every group of segments. Returns the number of ticks
+ * that it took. */
+    static TickType_t prvLargeSendTransfer( TCPTestPeer_t * pxPeer,
+                                            uint32_t ulFirst,
+                                            LargeSendResult_t * pxResult,
+                                            uint32_t ulEnd )
+    {
+        const TickType_t xStart = xTaskGetTickCount();
+
+        while( pxResult->ulReceived < ulEnd )
+        {
+            prvLargeSendQueue( pxPeer, pxResult, ulEnd );
+
+            if( ( prvLargeSendReceive( pxPeer, ulFirst, pxResult, pdMS_TO_TICKS( tcptestLARGE_SEND_TIMEOUT_MS ) ) == 0 ) ||
+                ( prvLargeSendAck( pxPeer, ulFirst, pxResult ) != pdPASS ) )
+            {
+                break;
+            }
+        }
+
+        return xTaskGetTickCount() - xStart;
+    }
+
+/* Let the peer advertise usWindow. */
+    static BaseType_t prvLargeSendSetWindow( TCPTestPeer_t * pxPeer,
+                                             uint16_t usWindow )
+    {
+        pxPeer->usWindow = usWindow;
+
+        return prvPeerSend( prvPeerBuildSegment( pxPeer, pxPeer->ulFirstSequence, tcptestTCP_FLAG_ACK, 0 ), pdFALSE );
+    }
+
+#endif /* if ( ipconfigUSE_TCP_LARGE_SEND != 0 ) */
+
+/* Send a bulk of data over a connection to the peer, which checks every
+ * segment, first with single segments and then with runs. Then let a run stop
+ * for lack of network buffers, and end with a FIN on the last segment of a
+ * run. */
+TEST( Full_FREERTOS_TCP, TCPLargeSendBulk )
+{
+    #if ( ipconfigUSE_TCP_LARGE_SEND != 0 )
+        static NetworkBufferDescriptor_t * pxHeld[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+        NetworkBufferDescriptor_t * pxOpen;
+        LargeSendResult_t xResult;
+        TickType_t xTicks[ 2 ];
+        const UBaseType_t uxSegments[ 2 ] = { 1u, ( UBaseType_t ) ipconfigTCP_LARGE_SEND_SEGMENTS };
+        const BaseType_t xCloseAfterSend = pdTRUE;
+        uint32_t ulFirst, ulEnd, ulSegments;
+        UBaseType_t uxHeld = 0;
+        BaseType_t xIndex;
+
+        if( FreeRTOS_IsNetworkUp() == pdFALSE )
+        {
+            TEST_IGNORE_MESSAGE( "The network is not up." );
+        }
+
+        memset( &xResult, 0, sizeof( xResult ) );
+        TEST_ASSERT_EQUAL( pdPASS, prvPeerConnect( &xPeer, NULL, 0 ) );
+        ulFirst = xPeer.ulAckNumber;
+
+        /* The same amount of data with single segments and with runs. */
+        for( xIndex = 0; xIndex < 2; xIndex++ )
+        {
+            TEST_FreeRTOS_TCP_SetLargeSendSegments( uxSegments[ xIndex ] );
+            ulEnd = xResult.ulReceived + tcptestLARGE_SEND_BULK_SIZE;
+            xTicks[ xIndex ] = prvLargeSendTransfer( &xPeer, ulFirst, &xResult, ulEnd );
+            TEST_ASSERT_EQUAL_UINT32( ulEnd, xResult.ulReceived );
+
+            configPRINTF( ( "Large send: %u bytes in runs of up to %u segments in %u ms, %u bytes/tick\r\n",
+                            ( unsigned ) tcptestLARGE_SEND_BULK_SIZE,
+                            ( unsigned ) uxSegments[ xIndex ],
+                            ( unsigned ) ( xTicks[ xIndex ] * portTICK_PERIOD_MS ),
+                            ( unsigned ) ( tcptestLARGE_SEND_BULK_SIZE / ( xTicks[ xIndex ] > 0 ? xTicks[ xIndex ] : 1 ) ) ) );
+        }
+
+        TEST_ASSERT_EQUAL_UINT32( 0, xResult.ulBad );
+        TEST_ASSERT_EQUAL_UINT32( 0, xResult.ulGaps );
+        TEST_ASSERT_EQUAL_UINT32( 0, xResult.ulFins );
+
+        /* Queue a full run while the window is closed, and open it while only
+         * a few network buffers are free. The run stops early, and the rest
+         * is sent again when its timer expires. */
+        TEST_ASSERT_EQUAL( pdPASS, prvLargeSendSetWindow( &xPeer, 0u ) );
+        ulEnd = xResult.ulReceived + ipconfigTCP_LARGE_SEND_SEGMENTS * ipconfigTCP_MSS;
+        prvLargeSendQueue( &xPeer, &xResult, ulEnd );
+        TEST_ASSERT_EQUAL_UINT32( ulEnd, xResult.ulQueued );
+        TEST_ASSERT_EQUAL( 0, prvLargeSendReceive( &xPeer, ulFirst, &xResult, pdMS_TO_TICKS( tcptestRX_COALESCE_WAIT_MS ) ) );
+
+        /* The segment that opens the window is made before the buffers run
+         * out. */
+        xPeer.usWindow = 0xffffu;
+        pxOpen = prvPeerBuildSegment( &xPeer, xPeer.ulFirstSequence, tcptestTCP_FLAG_ACK, 0 );
+        TEST_ASSERT_NOT_NULL( pxOpen );
+
+        while( ( uxHeld < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ) &&
+               ( ( pxHeld[ uxHeld ] = pxGetNetworkBufferWithDescriptor( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER, 0u ) ) != NULL ) )
+        {
+            uxHeld++;
+        }
+
+        while( ( uxHeld > 0u ) && ( uxGetNumberOfFreeNetworkBuffers() < tcptestLARGE_SEND_SPARE_BUFFERS ) )
+        {
+            uxHeld--;
+            vReleaseNetworkBufferAndDescriptor( pxHeld[ uxHeld ] );
+        }
+
+        ulSegments = xResult.ulSegments;
+        ( void ) prvPeerSend( pxOpen, pdFALSE );
+        ( void ) prvLargeSendReceive( &xPeer, ulFirst, &xResult, pdMS_TO_TICKS( tcptestRX_COALESCE_WAIT_MS ) );
+        ulSegments = xResult.ulSegments - ulSegments;
+
+        while( uxHeld > 0u )
+        {
+            uxHeld--;
+            vReleaseNetworkBufferAndDescriptor( pxHeld[ uxHeld ] );
+        }
+
+        configPRINTF( ( "Large send: %u of %u segments sent with %u free network buffers\r\n",
+                        ( unsigned ) ulSegments,
+                        ( unsigned ) ipconfigTCP_LARGE_SEND_SEGMENTS,
+                        ( unsigned ) tcptestLARGE_SEND_SPARE_BUFFERS ) );
+
+        TEST_ASSERT_TRUE( ulSegments > 0 );
+        TEST_ASSERT_TRUE( ulSegments < ipconfigTCP_LARGE_SEND_SEGMENTS );
+        TEST_ASSERT_EQUAL( pdPASS, prvLargeSendAck( &xPeer, ulFirst, &xResult ) );
+        ( void ) prvLargeSendTransfer( &xPeer, ulFirst, &xResult, ulEnd );
+        TEST_ASSERT_EQUAL_UINT32( ulEnd, xResult.ulReceived );
+        TEST_ASSERT_EQUAL_UINT32( 0, xResult.ulBad );
+        TEST_ASSERT_EQUAL_UINT32( 0, xResult.ulFins );
+
+        /* The last data, queued as one run while the window is closed: only
+         * the last segment of the run carries the FIN. */
+        xResult.ulGaps = 0;
+        TEST_ASSERT_EQUAL( pdPASS, prvLargeSendSetWindow( &xPeer, 0u ) );
+        TEST_ASSERT_EQUAL( 0, FreeRTOS_setsockopt( xPeer.xSocket, 0, FREERTOS_SO_CLOSE_AFTER_SEND, &xCloseAfterSend, sizeof( xCloseAfterSend ) ) );
+        ulEnd = xResult.ulReceived + 3u * ipconfigTCP_MSS + 100u;
+        prvLargeSendQueue( &xPeer, &xResult, ulEnd );
+        TEST_ASSERT_EQUAL_UINT32( ulEnd, xResult.ulQueued );
+
+        TEST_ASSERT_EQUAL( pdPASS, prvLargeSendSetWindow( &xPeer, 0xffffu ) );
+        ( void ) prvLargeSendTransfer( &xPeer, ulFirst, &xResult, ulEnd );
+        TEST_ASSERT_EQUAL_UINT32( ulEnd, xResult.ulReceived );
+        TEST_ASSERT_EQUAL_UINT32( 0, xResult.ulBad );
+        TEST_ASSERT_EQUAL_UINT32( 0, xResult.ulGaps );
+        TEST_ASSERT_NOT_EQUAL( 0, xResult.ulFins );
+        TEST_ASSERT_EQUAL_UINT32( ulEnd, xResult.ulFinOffset );
+        TEST_ASSERT_EQUAL_UINT32( 100u, xResult.ulFinLength );
+    #else /* if ( ipconfigUSE_TCP_LARGE_SEND != 0 ) */
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_LARGE_SEND is not enabled." );
+    #endif /* if ( ipconfigUSE_TCP_LARGE_SEND != 0 ) */
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_FREERTOS_TCP, TCPSegmentPoolGrow )
+{
+    #if ( ( ipconfigUSE_TCP_WIN != 0 ) && ( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 ) )
+        TCPWindow_t xWindow;
+        UBaseType_t uxTotalBefore, uxTotalAfter, uxFree, uxQueued;
+        int32_t lAdded;
+
+        memset( &xWindow, 0, sizeof( xWindow ) );
+
+        /* The segment pool is shared with the IP-task. */
+        vTaskSuspendAll();
+        {
+            vTCPWindowCreate( &xWindow, 8 * tcptestSEGMENT_POOL_MSS, 8 * tcptestSEGMENT_POOL_MSS, 5000, 10000, tcptestSEGMENT_POOL_MSS );
+            uxTotalBefore = uxTCPSegmentPoolSize( &uxFree );
+
+            /* Ask for one segment more than the pool has free. */
+            lAdded = lTCPWindowTxAdd( &xWindow, ( uint32_t ) ( uxFree + 1u ) * tcptestSEGMENT_POOL_MSS, 0, 0x7fffffff );
+            uxQueued = listCURRENT_LIST_LENGTH( &( xWindow.xTxSegments ) );
+            uxTotalAfter = uxTCPSegmentPoolSize( NULL );
+
+            vTCPWindowDestroy( &xWindow );
+        }
+        ( void ) xTaskResumeAll();
+
+        TEST_ASSERT_EQUAL_INT32( ( int32_t ) ( uxFree + 1u ) * tcptestSEGMENT_POOL_MSS, lAdded );
+        TEST_ASSERT_EQUAL_UINT32( uxFree + 1u, uxQueued );
+        TEST_ASSERT_EQUAL_UINT32( uxTotalBefore + ipconfigTCP_WIN_SEG_GROW_COUNT, uxTotalAfter );
+    #else /* if ( ( ipconfigUSE_TCP_WIN != 0 ) && ( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 ) ) */
+        TEST_IGNORE_MESSAGE( "ipconfigTCP_WIN_SEG_GROW_COUNT is not enabled." );
+    #endif /* if ( ( ipconfigUSE_TCP_WIN != 0 ) && ( ipconfigTCP_WIN_SEG_GROW_COUNT != 0 ) ) */
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+
+/* A socket that has just sent a SYN+ACK and receives the ACK one round-trip
+ * later.  It has the default buffer and window, and is not connected to any
+ * peer. */
+    static void prvAutoTuneSocketInit( FreeRTOS_Socket_t * pxSocket,
+                                       TickType_t xRTT )
+    {
+        memset( pxSocket, 0, sizeof( *pxSocket ) );
+        pxSocket->ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+        pxSocket->u.xTCP.bits.bRxAutoTune = pdTRUE_UNSIGNED;
+        pxSocket->u.xTCP.uxRxStreamSize = ipconfigTCP_RX_BUFFER_LENGTH;
+        pxSocket->u.xTCP.ucMyWinScaleFactor = 2;
+        pxSocket->u.xTCP.xTCPWindow.usMSS = ipconfigTCP_MSS;
+        pxSocket->u.xTCP.xTCPWindow.xSize.ulRxWindowLength = FreeRTOS_max_uint32( 1UL, ( ipconfigTCP_RX_BUFFER_LENGTH / 2 ) / ipconfigTCP_MSS ) * ipconfigTCP_MSS;
+        pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = 1000;
+
+        pxSocket->u.xTCP.xAutoTuneTime = xTaskGetTickCount() - xRTT;
+        TEST_FreeRTOS_TCP_prvTCPRxAutoTuneStart( pxSocket );
+    }
+
+#endif /* if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 ) */
+
+/* Emulate a link that can carry tcptestAUTOTUNE_LINK_BDP bytes per
+ * round-trip, with a delay of tcptestAUTOTUNE_RTT_MS: in every round, the peer
+ * sends as much as the window and the link allow, and the reader only gets to
+ * the data one round-trip later. The reader then takes all data, so the
+ * IP-task can install a stream of the new size when the next round starts. */
+TEST( Full_FREERTOS_TCP, TCPRxAutoTuneDelayedLink )
+{
+    #if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+        static uint8_t ucBuffer[ ipconfigTCP_MSS ];
+        const TickType_t xRTT = pdMS_TO_TICKS( tcptestAUTOTUNE_RTT_MS );
+        FreeRTOS_Socket_t * pxSocket;
+        NetworkBufferDescriptor_t * pxNetworkBuffer;
+        TCPPacket_t * pxTCPPacket;
+        StreamBuffer_t * pxFirstStream = NULL;
+        uint32_t ulSent = 0, ulRead = 0, ulWindowEnd, ulRoundEnd, ulLength, ulIndex;
+        uint32_t ulFirst = 0, ulLast = 0, ulRound, ulMismatches = 0;
+        uint32_t ulSwapped = 0, ulFreedByRecv = 0;
+        size_t uxFirstSize;
+        BaseType_t xOldStream, xReceived;
+
+        if( FreeRTOS_IsNetworkUp() == pdFALSE )
+        {
+            TEST_IGNORE_MESSAGE( "The network is not up." );
+        }
+
+        TEST_ASSERT_EQUAL( pdPASS, prvPeerConnect( &xPeer, NULL, xRTT ) );
+        pxSocket = ( FreeRTOS_Socket_t * ) xPeer.xSocket;
+        TEST_ASSERT_TRUE( pxSocket->u.xTCP.xAutoTuneRTT >= xRTT );
+        TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, pxSocket->u.xTCP.bits.bRxAutoTune );
+
+        uxFirstSize = pxSocket->u.xTCP.uxRxStreamSize;
+        ulWindowEnd = xPeer.usPeerWindow;
+
+        for( ulRound = 0; ulRound < tcptestAUTOTUNE_ROUNDS; ulRound++ )
+        {
+            /* Send what the window and the link allow. */
+            ulRoundEnd = FreeRTOS_min_uint32( ulWindowEnd, ulSent + tcptestAUTOTUNE_LINK_BDP );
+            ulLast = ulRoundEnd - ulSent;
+
+            while( ulSent < ulRoundEnd )
+            {
+                ulLength = FreeRTOS_min_uint32( ulRoundEnd - ulSent, ipconfigTCP_MSS );
+                TEST_ASSERT_EQUAL( pdPASS, prvPeerSend( prvPeerBuildSegment( &xPeer, xPeer.ulFirstSequence + ulSent, tcptestTCP_FLAG_ACK, ulLength ), pdFALSE ) );
+                ulSent += ulLength;
+            }
+
+            vTaskDelay( xRTT );
+
+            if( ulRound == 0 )
+            {
+                ulFirst = ulLast;
+                pxFirstStream = pxSocket->u.xTCP.rxStream;
+            }
+
+            /* The IP-task replaces the empty stream when the first segment of
+             * a round arrives, while the reader is still waiting. */
+            xOldStream = ( pxSocket->u.xTCP.pxRxStreamOld != NULL ) ? pdTRUE : pdFALSE;
+
+            if( xOldStream != pdFALSE )
+            {
+                ulSwapped++;
+            }
+
+            while( ulRead < ulSent )
+            {
+                xReceived = FreeRTOS_recv( xPeer.xSocket, ucBuffer, sizeof( ucBuffer ), FREERTOS_MSG_DONTWAIT );
+
+                if( xReceived <= 0 )
+                {
+                    break;
+                }
+
+                for( ulIndex = 0; ulIndex < ( uint32_t ) xReceived; ulIndex++ )
+                {
+                    if( ucBuffer[ ulIndex ] != prvPatternByte( ulRead + ulIndex ) )
+                    {
+                        ulMismatches++;
+                    }
+                }
+
+                ulRead += ( uint32_t ) xReceived;
+            }
+
+            if( ( xOldStream != pdFALSE ) && ( pxSocket->u.xTCP.pxRxStreamOld == NULL ) )
+            {
+                ulFreedByRecv++;
+            }
+
+            TEST_ASSERT_EQUAL_UINT32( ulSent, ulRead );
+
+            /* The window that the peer may use in the next round. */
+            while( ( pxNetworkBuffer = prvPeerReceive( &xPeer, 0 ) ) != NULL )
+            {
+                pxTCPPacket = ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+                TEST_ASSERT_EQUAL_HEX8( 0, pxTCPPacket->xTCPHeader.ucTCPFlags & ( tcptestTCP_FLAG_RST | tcptestTCP_FLAG_FIN ) );
+                ulWindowEnd = ( FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr ) - xPeer.ulFirstSequence ) + xPeer.usPeerWindow;
+                vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+            }
+        }
+
+        configPRINTF( ( "RX auto-tune: RTT %u ms, throughput %u -> %u KB/s, stream %u -> %u bytes, %u swaps\r\n",
+                        ( unsigned ) tcptestAUTOTUNE_RTT_MS,
+                        ( unsigned ) ( ulFirst / tcptestAUTOTUNE_RTT_MS ),
+                        ( unsigned ) ( ulLast / tcptestAUTOTUNE_RTT_MS ),
+                        ( unsigned ) uxFirstSize,
+                        ( unsigned ) pxSocket->u.xTCP.uxRxStreamSize,
+                        ( unsigned ) ulSwapped ) );
+
+        /* All data arrived in order, through more than one stream. */
+        TEST_ASSERT_EQUAL_UINT32( 0, ulMismatches );
+        TEST_ASSERT_EQUAL( eESTABLISHED, pxSocket->u.xTCP.ucTCPState );
+        TEST_ASSERT_TRUE( pxSocket->u.xTCP.rxStream != pxFirstStream );
+        TEST_ASSERT_TRUE( pxSocket->u.xTCP.uxRxStreamSize > uxFirstSize );
+
+        /* Every stream that was replaced was freed by FreeRTOS_recv(). */
+        TEST_ASSERT_TRUE( ulSwapped > 0 );
+        TEST_ASSERT_EQUAL_UINT32( ulSwapped, ulFreedByRecv );
+        TEST_ASSERT_NULL( pxSocket->u.xTCP.pxRxStreamOld );
+
+        /* The larger window let the peer send more per round-trip. */
+        TEST_ASSERT_TRUE( ulLast > ulFirst );
+    #else /* if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 ) */
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_RX_AUTOTUNE is not enabled." );
+    #endif /* if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 ) */
+}
+
+/*-----------------------------------------------------------*/
+
+TEST( Full_FREERTOS_TCP, TCPRxAutoTuneMemoryPressure )
+{
+    #if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 )
+        static FreeRTOS_Socket_t xSocket;
+        const size_t uxPlenty = 4u * ipconfigTCP_RX_AUTOTUNE_MAX_SIZE + ipconfigTCP_RX_AUTOTUNE_HEAP_RESERVE;
+        uint32_t ulWindow;
+        size_t uxSize;
+        Socket_t xTCPSocket;
+        uint32_t ulBufferSize = 4 * ipconfigTCP_MSS;
+
+        prvAutoTuneSocketInit( &xSocket, 1 );
+        ulWindow = xSocket.u.xTCP.xTCPWindow.xSize.ulRxWindowLength;
+
+        /* A full window per round-trip, but the application is behind. */
+        xSocket.u.xTCP.bits.bLowWater = pdTRUE_UNSIGNED;
+        TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( &xSocket, ulWindow, uxPlenty );
+        TEST_ASSERT_EQUAL_UINT32( ipconfigTCP_RX_BUFFER_LENGTH, xSocket.u.xTCP.uxAutoTuneSize );
+
+        /* No room on the heap for a larger buffer. */
+        xSocket.u.xTCP.bits.bLowWater = pdFALSE_UNSIGNED;
+        TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( &xSocket, ulWindow, ipconfigTCP_RX_AUTOTUNE_HEAP_RESERVE + ipconfigTCP_RX_BUFFER_LENGTH );
+        TEST_ASSERT_EQUAL_UINT32( ipconfigTCP_RX_BUFFER_LENGTH, xSocket.u.xTCP.uxAutoTuneSize );
+
+        /* Grow twice. */
+        TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( &xSocket, ulWindow, uxPlenty );
+        TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( &xSocket, xSocket.u.xTCP.xTCPWindow.xSize.ulRxWindowLength, uxPlenty );
+        uxSize = xSocket.u.xTCP.uxAutoTuneSize;
+        TEST_ASSERT_TRUE( uxSize > ipconfigTCP_RX_BUFFER_LENGTH );
+
+        /* The heap is running low: the buffer and window are halved, but do
+         * not get smaller than the defaults. */
+        TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( &xSocket, 0, 0 );
+        TEST_ASSERT_EQUAL_UINT32( FreeRTOS_max_uint32( uxSize / 2u, ipconfigTCP_RX_BUFFER_LENGTH ), xSocket.u.xTCP.uxAutoTuneSize );
+        TEST_ASSERT_TRUE( xSocket.u.xTCP.xTCPWindow.xSize.ulRxWindowLength <= xSocket.u.xTCP.uxAutoTuneSize / 2u );
+
+        while( xSocket.u.xTCP.uxAutoTuneSize > ipconfigTCP_RX_BUFFER_LENGTH )
+        {
+            TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( &xSocket, 0, 0 );
+        }
+
+        TEST_FreeRTOS_TCP_prvTCPRxAutoTuneUpdate( &xSocket, 0, 0 );
+        TEST_ASSERT_EQUAL_UINT32( ipconfigTCP_RX_BUFFER_LENGTH, xSocket.u.xTCP.uxAutoTuneSize );
+        TEST_ASSERT_EQUAL_UINT32( ulWindow, xSocket.u.xTCP.xTCPWindow.xSize.ulRxWindowLength );
+
+        /* Setting the buffer size switches the tuning off. */
+        xTCPSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+        TEST_ASSERT_NOT_EQUAL( FREERTOS_INVALID_SOCKET, xTCPSocket );
+        TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, ( ( FreeRTOS_Socket_t * ) xTCPSocket )->u.xTCP.bits.bRxAutoTune );
+        TEST_ASSERT_EQUAL( 0, FreeRTOS_setsockopt( xTCPSocket, 0, FREERTOS_SO_RCVBUF, &ulBufferSize, sizeof( ulBufferSize ) ) );
+        TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, ( ( FreeRTOS_Socket_t * ) xTCPSocket )->u.xTCP.bits.bRxAutoTune );
+        FreeRTOS_closesocket( xTCPSocket );
+    #else /* if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 ) */
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_RX_AUTOTUNE is not enabled." );
+    #endif /* if ( ipconfigUSE_TCP_RX_AUTOTUNE != 0 ) */
+}
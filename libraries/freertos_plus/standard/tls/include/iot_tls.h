@@ -84,6 +84,10 @@ typedef BaseType_t ( * NetworkSend_t )( void * pvCallerContext,
  * @param[in] pxNetworkSend Caller-defined network send function pointer.
  * @param[in] pvCallerContext Caller-defined context handle to be used with callback
  * functions.
+ * @param[in] ulMaxFragmentLength Maximum fragment length in bytes to request
+ * from the server: 512, 1024, 2048 or 4096. Zero requests the length set by
+ * tlsconfigMAX_FRAGMENT_LENGTH. Any other value, such as the TLS default of
+ * 16384, leaves the max_fragment_length extension out.
  */
 typedef struct xTLS_PARAMS
 {
@@ -97,6 +101,7 @@ typedef struct xTLS_PARAMS
     NetworkRecv_t pxNetworkRecv;
     NetworkSend_t pxNetworkSend;
     void * pvCallerContext;
+    uint32_t ulMaxFragmentLength;
 } TLSParams_t;
 
 /**
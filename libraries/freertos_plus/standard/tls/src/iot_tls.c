@@ -49,10 +49,26 @@
 #endif
 
 /* C runtime includes. */
+#include <stddef.h>
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
 
+/**
+ * @brief Maximum fragment length (RFC 6066) requested from the server, as one
+ * of the mbedTLS MBEDTLS_SSL_MAX_FRAG_LEN_* codes.
+ *
+ * Records sent by the client never exceed this length. If the server accepts
+ * the request, its records don't either, and with
+ * MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH the record buffers of the connection
+ * shrink to this length once the handshake completes. The default,
+ * MBEDTLS_SSL_MAX_FRAG_LEN_NONE, leaves the extension out of the ClientHello.
+ * A connection can override it with TLSParams_t.ulMaxFragmentLength.
+ */
+#ifndef tlsconfigMAX_FRAGMENT_LENGTH
+    #define tlsconfigMAX_FRAGMENT_LENGTH    MBEDTLS_SSL_MAX_FRAG_LEN_NONE
+#endif
+
 /**
  * @brief Internal context structure.
  *
@@ -84,6 +100,7 @@ typedef struct TLSContext
     NetworkSend_t xNetworkSend;
     void * pvCallerContext;
     BaseType_t xTLSHandshakeSuccessful;
+    unsigned char ucMaxFragmentLength; /* One of the MBEDTLS_SSL_MAX_FRAG_LEN_* codes. */
 
     /* mbedTLS. */
     mbedtls_ssl_context xMbedSslCtx;
@@ -651,6 +668,50 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Convert the maximum fragment length of TLSParams_t to an mbedTLS
+ * MBEDTLS_SSL_MAX_FRAG_LEN_* code.
+ *
+ * @param[in] ulLength Maximum fragment length in bytes, or zero for the default.
+ *
+ * @return The code to request, MBEDTLS_SSL_MAX_FRAG_LEN_NONE for none.
+ */
+static unsigned char prvMaxFragmentLengthCode( uint32_t ulLength )
+{
+    unsigned char ucCode;
+
+    switch( ulLength )
+    {
+        case 0:
+            ucCode = ( unsigned char ) tlsconfigMAX_FRAGMENT_LENGTH;
+            break;
+
+        case 512:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_512;
+            break;
+
+        case 1024:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_1024;
+            break;
+
+        case 2048:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_2048;
+            break;
+
+        case 4096:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_4096;
+            break;
+
+        default:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+            break;
+    }
+
+    return ucCode;
+}
+
+/*-----------------------------------------------------------*/
+
 /*
  * Interface routines.
  */
@@ -679,6 +740,13 @@ BaseType_t TLS_Init( void ** ppvContext,
         pxCtx->xNetworkRecv = pxParams->pxNetworkRecv;
         pxCtx->xNetworkSend = pxParams->pxNetworkSend;
         pxCtx->pvCallerContext = pxParams->pvCallerContext;
+        pxCtx->ucMaxFragmentLength = ( unsigned char ) tlsconfigMAX_FRAGMENT_LENGTH;
+
+        /* Callers built before ulMaxFragmentLength existed pass a smaller structure. */
+        if( pxParams->ulSize >= ( offsetof( TLSParams_t, ulMaxFragmentLength ) + sizeof( pxParams->ulMaxFragmentLength ) ) )
+        {
+            pxCtx->ucMaxFragmentLength = prvMaxFragmentLengthCode( pxParams->ulMaxFragmentLength );
+        }
 
         /* Get the function pointer list for the PKCS#11 module. */
         xCkGetFunctionList = C_GetFunctionList;
@@ -820,6 +888,16 @@ BaseType_t TLS_Connect( void * pvContext )
             pxCtx->ppcAlpnProtocols );
     }
 
+    #if defined( MBEDTLS_SSL_MAX_FRAGMENT_LENGTH )
+        if( ( 0 == xResult ) && ( MBEDTLS_SSL_MAX_FRAG_LEN_NONE != pxCtx->ucMaxFragmentLength ) )
+        {
+            /* Ask the server for records no larger than the configured
+             * length, so that idle connections hold small record buffers. */
+            xResult = mbedtls_ssl_conf_max_frag_len( &pxCtx->xMbedSslConfig,
+                                                     pxCtx->ucMaxFragmentLength );
+        }
+    #endif
+
     #ifdef MBEDTLS_DEBUG_C
 
         /* If mbedTLS is being compiled with debug support, assume that the
@@ -38,6 +38,27 @@
 #include "aws_clientcredential_keys.h"
 #include "iot_test_tls.h"
 
+/* Echo server configuration. */
+#include "aws_test_tcp.h"
+
+/* The heap usage test drives the TLS layer and mbedTLS directly, so it is only
+ * built where the TLS stack is configured to shrink its record buffers. */
+#if ( tcptestSECURE_SERVER == 1 ) && defined( MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH )
+    #define tlstestHEAP_USAGE_TEST    1
+#else
+    #define tlstestHEAP_USAGE_TEST    0
+#endif
+
+#if ( tlstestHEAP_USAGE_TEST == 1 )
+    /* TLS includes. */
+    #include "iot_tls.h"
+    #include "iot_crypto.h"
+
+    /* mbedTLS includes. */
+    #include "mbedtls/platform.h"
+    #include "mbedtls/ssl.h"
+#endif
+
 /* Configuration includes. */
 #include "iot_pkcs11_config.h"
 #include "iot_test_pkcs11_config.h"
@@ -70,6 +91,18 @@ static const uint32_t tlstestCLIENT_UNTRUSTED_PRIVATE_KEY_PEM_LENGTH = sizeof( t
 static const uint32_t tlstestCLIENT_BYOC_CERTIFICATE_PEM_LENGTH = sizeof( tlstestCLIENT_BYOC_CERTIFICATE_PEM );
 static const uint32_t tlstestCLIENT_BYOC_PRIVATE_KEY_PEM_LENGTH = sizeof( tlstestCLIENT_BYOC_PRIVATE_KEY_PEM );
 
+/*
+ * Number of bytes echoed through the connection of the heap usage test.
+ */
+#define tlstestECHO_LENGTH                  ( testrunnerBUFFER_SIZE / 2 )
+
+/*
+ * Maximum fragment lengths requested by the heap usage test. The TLS default
+ * leaves the max_fragment_length extension out of the handshake.
+ */
+#define tlstestFRAGMENT_LENGTH_DEFAULT      ( 16384UL )
+#define tlstestFRAGMENT_LENGTH_REDUCED      ( 4096UL )
+
 /*-----------------------------------------------------------*/
 
 TEST_GROUP( Full_TLS );
@@ -93,6 +126,9 @@ TEST_GROUP_RUNNER( Full_TLS )
         RUN_TEST_CASE( Full_TLS, AFQP_TLS_ConnectMalformedCert );
         RUN_TEST_CASE( Full_TLS, AFQP_TLS_ConnectUntrustedCert );
     #endif
+    #if ( tlstestHEAP_USAGE_TEST == 1 )
+        RUN_TEST_CASE( Full_TLS, AFQP_TLS_ConnectHeapUsage );
+    #endif
 }
 
 /*-----------------------------------------------------------*/
@@ -374,3 +410,208 @@ TEST( Full_TLS, AFQP_TLS_ConnectBYOCCredentials )
                                 );
 }
 /*-----------------------------------------------------------*/
+
+#if ( tlstestHEAP_USAGE_TEST == 1 )
+
+/*
+ * Heap held by mbedTLS allocations since the counters were last reset, and the
+ * largest value it reached.
+ */
+    static size_t xTlsHeapInUse = 0;
+    static size_t xTlsHeapPeak = 0;
+
+/*
+ * Heap usage of one connection of the heap usage test.
+ */
+    typedef struct TlsHeapUsage
+    {
+        size_t xHandshakePeak; /* Largest heap held during TLS_Connect(). */
+        size_t xSteadyState;   /* Heap held once data has been echoed. */
+    } TlsHeapUsage_t;
+
+/*-----------------------------------------------------------*/
+
+/* mbedTLS calloc that counts the heap taken by each allocation. The scheduler
+ * is suspended so that the free heap delta belongs to this allocation alone. */
+    static void * prvCountingCalloc( size_t xNmemb,
+                                     size_t xSize )
+    {
+        void * pvNew;
+        size_t xFreeBefore;
+
+        vTaskSuspendAll();
+        {
+            xFreeBefore = xPortGetFreeHeapSize();
+            pvNew = pvPortMalloc( xNmemb * xSize );
+
+            if( NULL != pvNew )
+            {
+                xTlsHeapInUse += xFreeBefore - xPortGetFreeHeapSize();
+
+                if( xTlsHeapInUse > xTlsHeapPeak )
+                {
+                    xTlsHeapPeak = xTlsHeapInUse;
+                }
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        if( NULL != pvNew )
+        {
+            memset( pvNew, 0, xNmemb * xSize );
+        }
+
+        return pvNew;
+    }
+/*-----------------------------------------------------------*/
+
+/* mbedTLS free that counts the heap returned by each free. */
+    static void prvCountingFree( void * pvPtr )
+    {
+        size_t xFreeBefore;
+        size_t xReleased;
+
+        vTaskSuspendAll();
+        {
+            xFreeBefore = xPortGetFreeHeapSize();
+            vPortFree( pvPtr );
+            xReleased = xPortGetFreeHeapSize() - xFreeBefore;
+
+            /* Objects allocated before the counters were reset may be freed
+             * here, so do not let the count wrap. */
+            xTlsHeapInUse = ( xReleased < xTlsHeapInUse ) ? ( xTlsHeapInUse - xReleased ) : 0;
+        }
+        ( void ) xTaskResumeAll();
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvSocketsSend( void * pvCallerContext,
+                                      const unsigned char * pucData,
+                                      size_t xDataLength )
+    {
+        return ( BaseType_t ) SOCKETS_Send( ( Socket_t ) pvCallerContext, pucData, xDataLength, 0 );
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvSocketsRecv( void * pvCallerContext,
+                                      unsigned char * pucReceiveBuffer,
+                                      size_t xReceiveLength )
+    {
+        return ( BaseType_t ) SOCKETS_Recv( ( Socket_t ) pvCallerContext, pucReceiveBuffer, xReceiveLength, 0 );
+    }
+/*-----------------------------------------------------------*/
+
+/* Connects to the secure echo server over a plain TCP socket with the TLS layer
+ * on top, echoes data through it and records the heap mbedTLS held during the
+ * handshake and afterwards. */
+    static void prvMeasureConnectionHeap( uint32_t ulMaxFragmentLength,
+                                          TlsHeapUsage_t * pxUsage )
+    {
+        SocketsSockaddr_t xEchoServerAddress = { 0 };
+        TLSParams_t xTLSParams = { 0 };
+        Socket_t xSocket;
+        void * pvTLSContext = NULL;
+        BaseType_t xResult;
+        size_t xReceived = 0;
+        char * pcSendBuffer = &cBuffer[ 0 ];
+        char * pcRecvBuffer = &cBuffer[ tlstestECHO_LENGTH ];
+        uint32_t ulIndex;
+
+        xEchoServerAddress.ulAddress = SOCKETS_inet_addr_quick( tcptestECHO_SERVER_TLS_ADDR0,
+                                                                tcptestECHO_SERVER_TLS_ADDR1,
+                                                                tcptestECHO_SERVER_TLS_ADDR2,
+                                                                tcptestECHO_SERVER_TLS_ADDR3 );
+        xEchoServerAddress.usPort = SOCKETS_htons( tcptestECHO_PORT_TLS );
+        xEchoServerAddress.ucSocketDomain = SOCKETS_AF_INET;
+
+        for( ulIndex = 0; ulIndex < tlstestECHO_LENGTH; ulIndex++ )
+        {
+            pcSendBuffer[ ulIndex ] = ( char ) ulIndex;
+        }
+
+        xSocket = SOCKETS_Socket( SOCKETS_AF_INET, SOCKETS_SOCK_STREAM, SOCKETS_IPPROTO_TCP );
+        TEST_ASSERT_NOT_EQUAL( xSocket, SOCKETS_INVALID_SOCKET );
+
+        if( TEST_PROTECT() )
+        {
+            xResult = SOCKETS_Connect( xSocket, &xEchoServerAddress, sizeof( xEchoServerAddress ) );
+            TEST_ASSERT_EQUAL_INT32_MESSAGE( SOCKETS_ERROR_NONE, xResult, "Socket connect failed" );
+
+            xTLSParams.ulSize = sizeof( xTLSParams );
+            xTLSParams.pcServerCertificate = tcptestECHO_HOST_ROOT_CA;
+            xTLSParams.ulServerCertificateLength = sizeof( tcptestECHO_HOST_ROOT_CA );
+            xTLSParams.pxNetworkRecv = prvSocketsRecv;
+            xTLSParams.pxNetworkSend = prvSocketsSend;
+            xTLSParams.pvCallerContext = xSocket;
+            xTLSParams.ulMaxFragmentLength = ulMaxFragmentLength;
+
+            xTlsHeapInUse = 0;
+            xTlsHeapPeak = 0;
+            ( void ) mbedtls_platform_set_calloc_free( prvCountingCalloc, prvCountingFree );
+
+            xResult = TLS_Init( &pvTLSContext, &xTLSParams );
+            TEST_ASSERT_EQUAL_INT32_MESSAGE( CKR_OK, xResult, "TLS init failed" );
+
+            xResult = TLS_Connect( pvTLSContext );
+            TEST_ASSERT_EQUAL_INT32_MESSAGE( 0, xResult, "TLS handshake failed" );
+
+            pxUsage->xHandshakePeak = xTlsHeapPeak;
+
+            /* The connection must still carry data after the record buffers
+             * have been resized. */
+            xResult = TLS_Send( pvTLSContext, ( const unsigned char * ) pcSendBuffer, tlstestECHO_LENGTH );
+            TEST_ASSERT_EQUAL_INT32_MESSAGE( tlstestECHO_LENGTH, xResult, "TLS send failed" );
+
+            while( xReceived < tlstestECHO_LENGTH )
+            {
+                xResult = TLS_Recv( pvTLSContext, ( unsigned char * ) ( pcRecvBuffer + xReceived ), tlstestECHO_LENGTH - xReceived );
+                TEST_ASSERT_GREATER_THAN_INT32_MESSAGE( 0, xResult, "TLS receive failed" );
+                xReceived += ( size_t ) xResult;
+            }
+
+            TEST_ASSERT_EQUAL_MEMORY( pcSendBuffer, pcRecvBuffer, tlstestECHO_LENGTH );
+
+            pxUsage->xSteadyState = xTlsHeapInUse;
+
+            configPRINTF( ( "TLS max fragment length %u: handshake peak %u bytes, steady state %u bytes\r\n",
+                            ulMaxFragmentLength,
+                            ( uint32_t ) pxUsage->xHandshakePeak,
+                            ( uint32_t ) pxUsage->xSteadyState ) );
+        }
+
+        /* Free the TLS context with the counting allocator still installed, then
+         * restore the default one. */
+        TLS_Cleanup( pvTLSContext );
+        CRYPTO_ConfigureHeap();
+
+        ( void ) SOCKETS_Shutdown( xSocket, SOCKETS_SHUT_RDWR );
+        ( void ) SOCKETS_Close( xSocket );
+    }
+/*-----------------------------------------------------------*/
+
+/* Reports the heap a TLS connection holds during and after the handshake with
+ * and without a reduced maximum fragment length, and checks that the record
+ * buffers shrink to the negotiated length once the handshake is over. The echo
+ * server may not accept the extension, so only the output buffer, which follows
+ * the length the client asked for, is certain to shrink. */
+    TEST( Full_TLS, AFQP_TLS_ConnectHeapUsage )
+    {
+        TlsHeapUsage_t xDefault = { 0 };
+        TlsHeapUsage_t xReduced = { 0 };
+
+        prvMeasureConnectionHeap( tlstestFRAGMENT_LENGTH_DEFAULT, &xDefault );
+        prvMeasureConnectionHeap( tlstestFRAGMENT_LENGTH_REDUCED, &xReduced );
+
+        /* The handshake is the high-water mark of both connections, and the
+         * reduced one gives heap back once it is over. */
+        TEST_ASSERT_TRUE_MESSAGE( xDefault.xHandshakePeak >= xDefault.xSteadyState, "Heap grew after the handshake" );
+        TEST_ASSERT_GREATER_THAN_UINT32( xReduced.xSteadyState, xReduced.xHandshakePeak );
+
+        /* The reduced connection holds at least the difference in output
+         * buffer length less than the default one. */
+        TEST_ASSERT_GREATER_THAN_UINT32( xReduced.xSteadyState, xDefault.xSteadyState );
+        TEST_ASSERT_TRUE_MESSAGE( ( xDefault.xSteadyState - xReduced.xSteadyState ) >= ( MBEDTLS_SSL_OUT_CONTENT_LEN - tlstestFRAGMENT_LENGTH_REDUCED ),
+                                  "Output buffer did not shrink to the maximum fragment length" );
+    }
+#endif /* if ( tlstestHEAP_USAGE_TEST == 1 ) */
+/*-----------------------------------------------------------*/
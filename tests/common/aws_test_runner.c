@@ -193,6 +193,8 @@ static void RunTests( void )
         RUN_TEST_GROUP( MQTT_Unit_BLE_Serialize );
         RUN_TEST_GROUP( Full_BLE_END_TO_END_MQTT );
         RUN_TEST_GROUP( Full_BLE_END_TO_END_SHADOW );
+        RUN_TEST_GROUP( Full_BLE_DATA_TRANSFER );
+        RUN_TEST_GROUP( Full_BLE_GATT_DISPATCH );
     #endif
 
     #if ( testrunnerFULL_FREERTOS_TCP_ENABLED == 1 )
@@ -203,6 +205,7 @@ static void RunTests( void )
         RUN_TEST_GROUP( Full_Serializer_CBOR );
         RUN_TEST_GROUP( Full_Serializer_JSON );
         RUN_TEST_GROUP( Full_Serializer_JSON_deserialize );
+        RUN_TEST_GROUP( Full_Serializer_JSON_utils );
     #endif
 
     #if ( testrunnerFULL_HTTPS_CLIENT_ENABLED == 1 )
@@ -210,6 +213,7 @@ static void RunTests( void )
         RUN_TEST_GROUP( HTTPS_Utils_Unit_API );
         RUN_TEST_GROUP( HTTPS_Client_Unit_Sync );
         RUN_TEST_GROUP( HTTPS_Client_Unit_Async );
+        RUN_TEST_GROUP( HTTPS_Client_Unit_Download );
         RUN_TEST_GROUP( HTTPS_Client_System );
     #endif
 }
@@ -169,6 +169,7 @@ $(NAME)_SOURCES    := $(AMAZON_FREERTOS_PATH)vendors/cypress/boards/$(PLATFORM)/
                       $(AFR_C_SDK_STANDARD_PATH)common/iot_device_metrics.c \
                       $(AFR_C_SDK_STANDARD_PATH)serializer/src/iot_json_utils.c \
                       $(AFR_C_SDK_STANDARD_PATH)serializer/test/iot_tests_deserializer_json.c \
+                      $(AFR_C_SDK_STANDARD_PATH)serializer/test/iot_tests_json_utils.c \
                       $(AFR_C_SDK_STANDARD_PATH)serializer/test/iot_tests_serializer_cbor.c \
                       $(AFR_C_SDK_STANDARD_PATH)serializer/test/iot_tests_serializer_json.c \
                       $(AFR_ABSTRACTIONS_PATH)platform/freertos/iot_metrics.c \
@@ -187,6 +188,7 @@ $(NAME)_SOURCES    := $(AMAZON_FREERTOS_PATH)vendors/cypress/boards/$(PLATFORM)/
                       $(AFR_C_SDK_STANDARD_PATH)https/test/unit/iot_tests_https_async.c \
                       $(AFR_C_SDK_STANDARD_PATH)https/test/unit/iot_tests_https_client.c \
                       $(AFR_C_SDK_STANDARD_PATH)https/test/unit/iot_tests_https_common.c \
+                      $(AFR_C_SDK_STANDARD_PATH)https/test/unit/iot_tests_https_download.c \
                       $(AFR_C_SDK_STANDARD_PATH)https/test/unit/iot_tests_https_sync.c \
                       $(AFR_C_SDK_STANDARD_PATH)https/test/unit/iot_tests_https_utils.c \
                       $(AFR_C_SDK_STANDARD_PATH)https/test/system/iot_tests_https_system.c \
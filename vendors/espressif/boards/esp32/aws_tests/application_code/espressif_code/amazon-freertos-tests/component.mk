@@ -124,6 +124,7 @@ COMPONENT_ADD_INCLUDEDIRS += $(AMAZON_FREERTOS_TESTS_DIR)/include \
         $(AMAZON_FREERTOS_3RD_PARTY_DIR)/unity/src \
         $(AMAZON_FREERTOS_DEMOS_DIR)/include \
         ${AMAZON_FREERTOS_SDK_DIR}/standard/ble/test \
+        ${AMAZON_FREERTOS_SDK_DIR}/standard/ble/src \
         ${AMAZON_FREERTOS_ARF_PLUS_DIR}/aws/greengrass/test \
         ${AMAZON_FREERTOS_ARF_PLUS_DIR}/aws/ota/test \
         $(AMAZON_FREERTOS_ABSTRACTIONS_DIR)/wifi/test \
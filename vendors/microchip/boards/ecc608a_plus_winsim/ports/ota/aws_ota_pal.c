@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
 #include "FreeRTOS.h"
 #include "iot_crypto.h"
 #include "aws_ota_pal.h"
@@ -53,7 +54,13 @@ static inline BaseType_t prvContextValidate( OTA_FileContext_t * C )
 /* Size of buffer used in file operations on this platform (Windows). */
 #define OTA_PAL_WIN_BUF_SIZE ( ( size_t ) 4096UL )
 
-/* Attempt to create a new receive file for the file chunks as they come in. */
+/* The file transfer checkpoint is kept in this file in the current working directory. It is
+ * written to a temporary file first so that a reset never leaves a partially written checkpoint. */
+#define OTA_PAL_CHECKPOINT_FILE        "OTACheckpoint.bin"
+#define OTA_PAL_CHECKPOINT_TEMP_FILE   "OTACheckpoint.tmp"
+
+/* Attempt to create a new receive file for the file chunks as they come in. If the transfer is
+ * being resumed, reopen the partially received file instead. */
 
 OTA_Err_t prvPAL_CreateFileForRx( OTA_FileContext_t * const C )
 {
@@ -65,8 +72,8 @@ OTA_Err_t prvPAL_CreateFileForRx( OTA_FileContext_t * const C )
     {
         if ( C->pucFilePath != NULL )
         {
-            C->pxFile = fopen( ( const char * )C->pucFilePath, "w+b" ); /*lint !e586
-                                                                           * C standard library call is being used for portability. */
+            C->pxFile = fopen( ( const char * )C->pucFilePath, ( C->xResume == pdTRUE ) ? "r+b" : "w+b" ); /*lint !e586
+                                                                                                             * C standard library call is being used for portability. */
 
             if ( C->pxFile != NULL )
             {
@@ -192,6 +199,105 @@ int16_t prvPAL_WriteBlock( OTA_FileContext_t * const C,
     return ( int16_t ) lResult;
 }
 
+/* Save the file transfer checkpoint, or erase it if no data is given. */
+
+OTA_Err_t prvPAL_SaveCheckpoint( OTA_FileContext_t * const C,
+                                 const uint8_t * pucData,
+                                 uint32_t ulSize )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_SaveCheckpoint" );
+
+    OTA_Err_t eResult = kOTA_Err_None;
+    FILE * pxCheckpoint;
+    size_t xBytesWritten;
+    int32_t lCloseResult;
+
+    if( ( pucData == NULL ) || ( ulSize == 0U ) )
+    {
+        /* There may not be a checkpoint to erase so ignore the result. */
+        ( void ) remove( OTA_PAL_CHECKPOINT_FILE ); /*lint !e586
+                                                     * C standard library call is being used for portability. */
+    }
+    /* The blocks the checkpoint claims were received must be on disk before the checkpoint is. */
+    else if( ( prvContextValidate( C ) == pdTRUE ) && ( fflush( C->pxFile ) != 0 ) ) /*lint !e586
+                                                                                         * C standard library call is being used for portability. */
+    {
+        OTA_LOG_L1( "[%s] ERROR - Failed to flush the receive file.\r\n", OTA_METHOD_NAME );
+        eResult = ( kOTA_Err_CheckpointFailed | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                 * Errno is being used in accordance with host API documentation.
+                                                                                 * Bitmasking is being used to preserve host API error with library status code. */
+    }
+    else
+    {
+        pxCheckpoint = fopen( OTA_PAL_CHECKPOINT_TEMP_FILE, "wb" ); /*lint !e586
+                                                                     * C standard library call is being used for portability. */
+
+        if( pxCheckpoint != NULL )
+        {
+            xBytesWritten = fwrite( pucData, 1, ulSize, pxCheckpoint ); /*lint !e586
+                                                                         * C standard library call is being used for portability. */
+            lCloseResult = fclose( pxCheckpoint );                      /*lint !e586
+                                                                         * C standard library call is being used for portability. */
+
+            /* Windows can't rename over an existing file, so remove the old checkpoint first. */
+            if( ( xBytesWritten != ulSize ) ||
+                ( lCloseResult != 0 ) ||
+                ( ( remove( OTA_PAL_CHECKPOINT_FILE ) != 0 ) && ( errno != ENOENT ) ) ||
+                ( rename( OTA_PAL_CHECKPOINT_TEMP_FILE, OTA_PAL_CHECKPOINT_FILE ) != 0 ) ) /*lint !e586
+                                                                                          * C standard library call is being used for portability. */
+            {
+                OTA_LOG_L1( "[%s] ERROR - Failed to write the checkpoint file.\r\n", OTA_METHOD_NAME );
+                eResult = ( kOTA_Err_CheckpointFailed | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                         * Errno is being used in accordance with host API documentation.
+                                                                                         * Bitmasking is being used to preserve host API error with library status code. */
+            }
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] ERROR - Failed to create the checkpoint file.\r\n", OTA_METHOD_NAME );
+            eResult = ( kOTA_Err_CheckpointFailed | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                     * Errno is being used in accordance with host API documentation.
+                                                                                     * Bitmasking is being used to preserve host API error with library status code. */
+        }
+    }
+
+    return eResult;
+}
+
+/* Read back the file transfer checkpoint. */
+
+uint32_t prvPAL_LoadCheckpoint( OTA_FileContext_t * const C,
+                                uint8_t * pucData,
+                                uint32_t ulMaxSize )
+{
+    FILE * pxCheckpoint;
+    uint32_t ulSize = 0;
+    uint8_t ucExtra;
+
+    ( void ) C;
+
+    pxCheckpoint = fopen( OTA_PAL_CHECKPOINT_FILE, "rb" ); /*lint !e586
+                                                            * C standard library call is being used for portability. */
+
+    if( pxCheckpoint != NULL )
+    {
+        ulSize = ( uint32_t ) fread( pucData, 1, ulMaxSize, pxCheckpoint ); /*lint !e586
+                                                                             * C standard library call is being used for portability. */
+
+        /* A checkpoint that doesn't fit in the buffer can't be the one the caller is looking for. */
+        if( fread( &ucExtra, 1, 1, pxCheckpoint ) != 0U ) /*lint !e586
+                                                            * C standard library call is being used for portability. */
+        {
+            ulSize = 0;
+        }
+
+        ( void ) fclose( pxCheckpoint ); /*lint !e586
+                                          * C standard library call is being used for portability. */
+    }
+
+    return ulSize;
+}
+
 /* Close the specified file. This shall authenticate the file if it is marked as secure. */
 
 OTA_Err_t prvPAL_CloseFile( OTA_FileContext_t * const C )
@@ -252,6 +358,52 @@ OTA_Err_t prvPAL_CloseFile( OTA_FileContext_t * const C )
 }
 
 
+/* Feed the contents of the received file into the signature verification context. */
+
+static OTA_Err_t prvPAL_HashFile( OTA_FileContext_t * const C,
+                                  void * pvSigVerifyContext )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_HashFile" );
+
+    OTA_Err_t eResult = kOTA_Err_None;
+    uint32_t ulBytesRead;
+    uint8_t * pucBuf;
+
+    pucBuf = pvPortMalloc( OTA_PAL_WIN_BUF_SIZE ); /*lint !e9079 Allow conversion. */
+
+    if( pucBuf != NULL )
+    {
+        /* Rewind the received file to the beginning. */
+        if( fseek( C->pxFile, 0L, SEEK_SET ) == 0 ) /*lint !e586
+                                                      * C standard library call is being used for portability. */
+        {
+            do
+            {
+                ulBytesRead = fread( pucBuf, 1, OTA_PAL_WIN_BUF_SIZE, C->pxFile ); /*lint !e586
+                                                                                   * C standard library call is being used for portability. */
+                /* Include the file chunk in the signature validation. Zero size is OK. */
+                CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, pucBuf, ulBytesRead );
+            } while( ulBytesRead > 0UL );
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] ERROR - Failed to rewind the receive file.\r\n", OTA_METHOD_NAME );
+            eResult = kOTA_Err_SignatureCheckFailed;
+        }
+
+        /* Free the temporary file page buffer. */
+        vPortFree( pucBuf );
+    }
+    else
+    {
+        OTA_LOG_L1( "[%s] ERROR - Failed to allocate buffer memory.\r\n", OTA_METHOD_NAME );
+        eResult = kOTA_Err_OutOfMemory;
+    }
+
+    return eResult;
+}
+
+
 /* Verify the signature of the specified file. */
 
 static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
@@ -259,19 +411,32 @@ static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
     DEFINE_OTA_METHOD_NAME( "prvPAL_CheckFileSignature" );
 
     OTA_Err_t eResult = kOTA_Err_None;
-    uint32_t ulBytesRead;
     uint32_t ulSignerCertSize;
-    uint8_t * pucBuf, * pucSignerCert;
+    uint8_t * pucSignerCert;
     void * pvSigVerifyContext;
+    BaseType_t xHashFile = pdFALSE;
 
     if( prvContextValidate( C ) == pdTRUE )
     {
-        /* Verify an ECDSA-SHA256 signature. */
-        if( pdFALSE == CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA, cryptoHASH_ALGORITHM_SHA256 ) )
+        /* If the OTA agent already hashed the file as its blocks were received, take ownership
+         * of that context and skip reading the file back. */
+        pvSigVerifyContext = C->pvSigVerifyContext;
+        C->pvSigVerifyContext = NULL;
+
+        if( pvSigVerifyContext == NULL )
         {
-            eResult = kOTA_Err_SignatureCheckFailed;
+            /* Verify an ECDSA-SHA256 signature. */
+            if( pdFALSE == CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA, cryptoHASH_ALGORITHM_SHA256 ) )
+            {
+                eResult = kOTA_Err_SignatureCheckFailed;
+            }
+            else
+            {
+                xHashFile = pdTRUE;
+            }
         }
-        else
+
+        if( eResult == kOTA_Err_None )
         {
             OTA_LOG_L1( "[%s] Started %s signature verification, file: %s\r\n", OTA_METHOD_NAME,
                         cOTA_JSON_FileSignatureKey, ( const char * ) C->pucCertFilepath );
@@ -279,51 +444,36 @@ static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
 
             if( pucSignerCert != NULL )
             {
-                pucBuf = pvPortMalloc( OTA_PAL_WIN_BUF_SIZE ); /*lint !e9079 Allow conversion. */
+                if( xHashFile == pdTRUE )
+                {
+                    eResult = prvPAL_HashFile( C, pvSigVerifyContext );
+                }
 
-                if( pucBuf != NULL )
+                if( eResult == kOTA_Err_None )
                 {
-                    /* Rewind the received file to the beginning. */
-                    if( fseek( C->pxFile, 0L, SEEK_SET ) == 0 ) /*lint !e586
-                                                                  * C standard library call is being used for portability. */
-                    {
-                        do
-                        {
-                            ulBytesRead = fread( pucBuf, 1, OTA_PAL_WIN_BUF_SIZE, C->pxFile ); /*lint !e586
-                                                                                               * C standard library call is being used for portability. */
-                            /* Include the file chunk in the signature validation. Zero size is OK. */
-                            CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, pucBuf, ulBytesRead );
-                        } while( ulBytesRead > 0UL );
-
-                        if( pdFALSE == CRYPTO_SignatureVerificationFinal( pvSigVerifyContext,
-                                                                          ( char * ) pucSignerCert,
-                                                                          ( size_t ) ulSignerCertSize,
-                                                                          C->pxSignature->ucData,
-                                                                          C->pxSignature->usSize ) ) /*lint !e732 !e9034 Allow comparison in this context. */
-                        {
-                            eResult = kOTA_Err_SignatureCheckFailed;
-                        }
-						pvSigVerifyContext = NULL;	/* The context has been freed by CRYPTO_SignatureVerificationFinal(). */
-                    }
-                    else
+                    if( pdFALSE == CRYPTO_SignatureVerificationFinal( pvSigVerifyContext,
+                                                                      ( char * ) pucSignerCert,
+                                                                      ( size_t ) ulSignerCertSize,
+                                                                      C->pxSignature->ucData,
+                                                                      C->pxSignature->usSize ) ) /*lint !e732 !e9034 Allow comparison in this context. */
                     {
-                        /* Nothing special to do. */
+                        eResult = kOTA_Err_SignatureCheckFailed;
                     }
-
-                    /* Free the temporary file page buffer. */
-                    vPortFree( pucBuf );
                 }
                 else
                 {
-                    OTA_LOG_L1( "[%s] ERROR - Failed to allocate buffer memory.\r\n", OTA_METHOD_NAME );
-                    eResult = kOTA_Err_OutOfMemory;
+                    /* Finalizing without a certificate or signature just frees the context. */
+                    ( void ) CRYPTO_SignatureVerificationFinal( pvSigVerifyContext, NULL, 0, NULL, 0 );
                 }
 
+                pvSigVerifyContext = NULL; /* The context has been freed by CRYPTO_SignatureVerificationFinal(). */
+
                 /* Free the signer certificate that we now own after prvReadAndAssumeCertificate(). */
                 vPortFree( pucSignerCert );
             }
             else
             {
+                ( void ) CRYPTO_SignatureVerificationFinal( pvSigVerifyContext, NULL, 0, NULL, 0 );
                 eResult = kOTA_Err_BadSignerCert;
             }
         }
@@ -0,0 +1,903 @@
+/*
+ * Amazon FreeRTOS OTA PAL for Linux V1.0.0
+ * Copyright (C) 2019 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* OTA PAL implementation for Linux and other POSIX hosts.
+ *
+ * The receive file is created at its full size and written through a shared memory mapping, so
+ * writing a block is a copy into the page cache and the signature check hashes the file straight
+ * from the mapping. Without the mapping, blocks are written with pwrite(), optionally through
+ * O_DIRECT to keep the image out of the page cache. */
+
+/* O_DIRECT is a Linux extension. */
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "FreeRTOS.h"
+#include "iot_crypto.h"
+#include "aws_ota_pal.h"
+#include "aws_ota_agent_internal.h"
+
+/**
+ * @brief Write the receive file through a shared memory mapping.
+ *
+ * Set to 0 to write blocks with pwrite() instead, for instance on file systems that can't map files.
+ */
+#ifndef otaconfigPOSIX_PAL_USE_MMAP
+    #define otaconfigPOSIX_PAL_USE_MMAP    1
+#endif
+
+/**
+ * @brief Open the receive file with O_DIRECT when it isn't mapped.
+ *
+ * The image bypasses the page cache, which keeps a large update from evicting the rest of the
+ * system's cached data. Blocks are written from an aligned buffer and padded to the alignment.
+ */
+#ifndef otaconfigPOSIX_PAL_USE_O_DIRECT
+    #define otaconfigPOSIX_PAL_USE_O_DIRECT    0
+#endif
+
+/**
+ * @brief Flush the receive file to storage before a checkpoint is saved and when it is closed.
+ *
+ * Without it, a checkpoint survives the process being killed but not the host losing power.
+ */
+#ifndef otaconfigPOSIX_PAL_FSYNC
+    #define otaconfigPOSIX_PAL_FSYNC    1
+#endif
+
+#if ( otaconfigPOSIX_PAL_USE_MMAP == 0 ) && ( otaconfigPOSIX_PAL_USE_O_DIRECT == 1 ) && ( otaconfigLOG2_FILE_BLOCK_SIZE < 9UL )
+    #error "O_DIRECT writes need file blocks of at least 512 bytes."
+#endif
+
+/* Specify the OTA signature algorithm we support on this platform. */
+const char cOTA_JSON_FileSignatureKey[ OTA_FILE_SIG_KEY_STR_MAX_LENGTH ] = "sig-sha256-ecdsa";
+
+static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C );
+static uint8_t * prvPAL_ReadAndAssumeCertificate( const uint8_t * const pucCertName,
+                                                  uint32_t * const ulSignerCertSize );
+static OTA_Err_t prvPAL_WriteFileAtomic( const char * pcFileName,
+                                         const char * pcTempFileName,
+                                         const uint8_t * pucData,
+                                         uint32_t ulSize );
+
+/*-----------------------------------------------------------*/
+
+/* Used to set the high bit of errno values for a negative return value. */
+#define OTA_PAL_INT16_NEGATIVE_MASK    ( 1 << 15 )
+
+/* Size of the buffer used to read the receive file back when it isn't mapped. */
+#define OTA_PAL_POSIX_BUF_SIZE         ( ( size_t ) 4096UL )
+
+/* Alignment of the buffer, offsets and sizes of O_DIRECT reads and writes. */
+#define OTA_PAL_POSIX_DIRECT_ALIGN     ( ( size_t ) 512UL )
+
+/* The file transfer checkpoint is kept in this file in the current working directory. It is
+ * written to a temporary file first so that a reset never leaves a partially written checkpoint. */
+#define OTA_PAL_CHECKPOINT_FILE         "OTACheckpoint.bin"
+#define OTA_PAL_CHECKPOINT_TEMP_FILE    "OTACheckpoint.tmp"
+
+/* The state of the OTA image is kept in this file in the current working directory, and written
+ * the same way as the checkpoint. */
+#define OTA_PAL_IMAGE_STATE_FILE        "PlatformImageState.txt"
+#define OTA_PAL_IMAGE_STATE_TEMP_FILE   "PlatformImageState.tmp"
+
+/* The receive file that is open. The agent receives one file at a time, and the file context's
+ * file pointer points here while the file is open. */
+typedef struct
+{
+    int32_t lFd;        /* File descriptor of the receive file, or -1 if no file is open. */
+    uint8_t * pucMap;   /* Shared mapping of the whole receive file, or NULL if it isn't mapped. */
+    uint32_t ulSize;    /* Size of the receive file in bytes. */
+    uint8_t * pucBuf;   /* Allocation holding the aligned read/write buffer, if any. */
+    uint8_t * pucAlign; /* The aligned read/write buffer within pucBuf. */
+} OTA_PosixFile_t;
+
+static OTA_PosixFile_t xPosixFile = { -1, NULL, 0, NULL, NULL };
+
+/*-----------------------------------------------------------*/
+
+static inline BaseType_t prvContextValidate( OTA_FileContext_t * C )
+{
+    return( ( C != NULL ) &&
+            ( C->pucFile == ( uint8_t * ) &xPosixFile ) &&
+            ( xPosixFile.lFd >= 0 ) );
+}
+
+/* Release the open receive file without checking it. Returns 0, or -1 with errno set if the file
+ * couldn't be written back to storage. */
+
+static int32_t prvPAL_ReleaseFile( void )
+{
+    int32_t lResult = 0;
+
+    if( xPosixFile.pucMap != NULL )
+    {
+        #if ( otaconfigPOSIX_PAL_FSYNC == 1 )
+            lResult = msync( xPosixFile.pucMap, xPosixFile.ulSize, MS_SYNC );
+        #endif
+
+        ( void ) munmap( xPosixFile.pucMap, xPosixFile.ulSize );
+        xPosixFile.pucMap = NULL;
+    }
+
+    if( xPosixFile.lFd >= 0 )
+    {
+        #if ( otaconfigPOSIX_PAL_FSYNC == 1 )
+            if( ( lResult == 0 ) && ( fsync( xPosixFile.lFd ) != 0 ) )
+            {
+                lResult = -1;
+            }
+        #endif
+
+        if( ( close( xPosixFile.lFd ) != 0 ) && ( lResult == 0 ) )
+        {
+            lResult = -1;
+        }
+
+        xPosixFile.lFd = -1;
+    }
+
+    if( xPosixFile.pucBuf != NULL )
+    {
+        vPortFree( xPosixFile.pucBuf );
+        xPosixFile.pucBuf = NULL;
+        xPosixFile.pucAlign = NULL;
+    }
+
+    return lResult;
+}
+
+/* Attempt to create a new receive file for the file chunks as they come in. If the transfer is
+ * being resumed, reopen the partially received file instead. */
+
+OTA_Err_t prvPAL_CreateFileForRx( OTA_FileContext_t * const C )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_CreateFileForRx" );
+
+    OTA_Err_t eResult = kOTA_Err_Uninitialized; /* For MISRA mandatory. */
+    int32_t lFlags = O_RDWR | O_CREAT;
+
+    if( ( C != NULL ) && ( C->pucFilePath != NULL ) )
+    {
+        if( xPosixFile.lFd >= 0 )
+        {
+            /* The agent never has two files open, so the last one was left open by an error. */
+            ( void ) prvPAL_ReleaseFile();
+        }
+
+        if( C->xResume == pdFALSE )
+        {
+            lFlags |= O_TRUNC;
+        }
+
+        #if ( otaconfigPOSIX_PAL_USE_MMAP == 0 ) && ( otaconfigPOSIX_PAL_USE_O_DIRECT == 1 )
+            lFlags |= O_DIRECT;
+        #endif
+
+        xPosixFile.lFd = open( ( const char * ) C->pucFilePath, lFlags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+
+        /* A compressed file is written as it is decompressed, so it is stored at its decompressed size. */
+        xPosixFile.ulSize = ( C->pucCompression != NULL ) ? C->ulImageSize : C->ulFileSize;
+
+        /* Size the file up front so the mapping covers all of it and writes never extend it. */
+        if( ( xPosixFile.lFd >= 0 ) && ( ftruncate( xPosixFile.lFd, ( off_t ) xPosixFile.ulSize ) == 0 ) )
+        {
+            #if ( otaconfigPOSIX_PAL_USE_MMAP == 1 )
+                /* A file of unknown size can't be mapped, so it is written like an unmapped file. */
+                if( xPosixFile.ulSize > 0U )
+                {
+                    xPosixFile.pucMap = mmap( NULL, xPosixFile.ulSize, PROT_READ | PROT_WRITE, MAP_SHARED, xPosixFile.lFd, 0 );
+
+                    if( xPosixFile.pucMap == MAP_FAILED )
+                    {
+                        xPosixFile.pucMap = NULL;
+                    }
+                    else
+                    {
+                        eResult = kOTA_Err_None;
+                    }
+                }
+                else
+            #endif /* if ( otaconfigPOSIX_PAL_USE_MMAP == 1 ) */
+            {
+                xPosixFile.pucBuf = pvPortMalloc( OTA_PAL_POSIX_BUF_SIZE + OTA_PAL_POSIX_DIRECT_ALIGN ); /*lint !e9079 Allow conversion. */
+
+                if( xPosixFile.pucBuf != NULL )
+                {
+                    xPosixFile.pucAlign = ( uint8_t * ) ( ( ( uintptr_t ) xPosixFile.pucBuf + ( OTA_PAL_POSIX_DIRECT_ALIGN - 1U ) ) &
+                                                          ~( uintptr_t ) ( OTA_PAL_POSIX_DIRECT_ALIGN - 1U ) );
+                    eResult = kOTA_Err_None;
+                }
+                else
+                {
+                    errno = ENOMEM;
+                }
+            }
+        }
+
+        if( eResult == kOTA_Err_None )
+        {
+            C->pucFile = ( uint8_t * ) &xPosixFile;
+            OTA_LOG_L1( "[%s] Receive file created.\r\n", OTA_METHOD_NAME );
+        }
+        else
+        {
+            eResult = ( kOTA_Err_RxFileCreateFailed | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                       * Errno is being used in accordance with host API documentation.
+                                                                                       * Bitmasking is being used to preserve host API error with library status code. */
+            OTA_LOG_L1( "[%s] ERROR - Failed to create the receive file: %d\r\n", OTA_METHOD_NAME, errno );
+            ( void ) prvPAL_ReleaseFile();
+        }
+    }
+    else
+    {
+        eResult = kOTA_Err_RxFileCreateFailed;
+        OTA_LOG_L1( "[%s] ERROR - Invalid context provided.\r\n", OTA_METHOD_NAME );
+    }
+
+    return eResult;
+}
+
+
+/* Abort receiving the specified OTA update by closing the file. */
+
+OTA_Err_t prvPAL_Abort( OTA_FileContext_t * const C )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_Abort" );
+
+    OTA_Err_t eResult = kOTA_Err_Uninitialized;
+
+    if( NULL != C )
+    {
+        /* Close the OTA update file if it's open. */
+        if( prvContextValidate( C ) == pdTRUE )
+        {
+            C->pucFile = NULL;
+
+            if( 0 == prvPAL_ReleaseFile() )
+            {
+                OTA_LOG_L1( "[%s] OK\r\n", OTA_METHOD_NAME );
+                eResult = kOTA_Err_None;
+            }
+            else /* Failed to close file. */
+            {
+                OTA_LOG_L1( "[%s] ERROR - Closing file failed.\r\n", OTA_METHOD_NAME );
+                eResult = ( kOTA_Err_FileAbort | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                  * Errno is being used in accordance with host API documentation.
+                                                                                  * Bitmasking is being used to preserve host API error with library status code. */
+            }
+        }
+        else
+        {
+            /* Nothing to do. No open file associated with this context. */
+            eResult = kOTA_Err_None;
+        }
+    }
+    else /* Context was not valid. */
+    {
+        OTA_LOG_L1( "[%s] ERROR - Invalid context.\r\n", OTA_METHOD_NAME );
+        eResult = kOTA_Err_FileAbort;
+    }
+
+    return eResult;
+}
+
+/* Write a block of data to the specified file. */
+int16_t prvPAL_WriteBlock( OTA_FileContext_t * const C,
+                           uint32_t ulOffset,
+                           uint8_t * const pacData,
+                           uint32_t ulBlockSize )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_WriteBlock" );
+
+    int32_t lResult = 0;
+    size_t xWriteSize = ulBlockSize;
+
+    if( prvContextValidate( C ) != pdTRUE )
+    {
+        OTA_LOG_L1( "[%s] ERROR - Invalid context.\r\n", OTA_METHOD_NAME );
+        lResult = OTA_PAL_INT16_NEGATIVE_MASK | EBADF; /* There's no open receive file to write to. */
+    }
+    else if( xPosixFile.pucMap != NULL )
+    {
+        if( ( ulOffset <= xPosixFile.ulSize ) && ( ulBlockSize <= ( xPosixFile.ulSize - ulOffset ) ) )
+        {
+            memcpy( &xPosixFile.pucMap[ ulOffset ], pacData, ulBlockSize );
+            lResult = ( int32_t ) ulBlockSize;
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] ERROR - Block is outside of the file.\r\n", OTA_METHOD_NAME );
+            lResult = OTA_PAL_INT16_NEGATIVE_MASK | EFBIG; /* A mapped file can't grow past the size it was created with. */
+        }
+    }
+    else
+    {
+        #if ( otaconfigPOSIX_PAL_USE_MMAP == 0 ) && ( otaconfigPOSIX_PAL_USE_O_DIRECT == 1 )
+            /* O_DIRECT needs an aligned buffer, offset and size. A block that doesn't cover whole
+             * aligned units is merged with what the file already holds there. Padding past the
+             * end of the file is cut off again when the file is closed. */
+            uint32_t ulStart = ulOffset & ~( uint32_t ) ( OTA_PAL_POSIX_DIRECT_ALIGN - 1U );
+            ssize_t xBytesRead = ( ssize_t ) 0;
+
+            xWriteSize = ( ( ulOffset + ulBlockSize - ulStart ) + ( OTA_PAL_POSIX_DIRECT_ALIGN - 1U ) ) & ~( OTA_PAL_POSIX_DIRECT_ALIGN - 1U );
+
+            if( xWriteSize <= OTA_PAL_POSIX_BUF_SIZE )
+            {
+                if( xWriteSize != ( size_t ) ulBlockSize )
+                {
+                    xBytesRead = pread( xPosixFile.lFd, xPosixFile.pucAlign, xWriteSize, ( off_t ) ulStart );
+                }
+
+                if( xBytesRead >= 0 )
+                {
+                    memset( &xPosixFile.pucAlign[ xBytesRead ], 0, xWriteSize - ( size_t ) xBytesRead );
+                    memcpy( &xPosixFile.pucAlign[ ulOffset - ulStart ], pacData, ulBlockSize );
+                    lResult = ( int32_t ) pwrite( xPosixFile.lFd, xPosixFile.pucAlign, xWriteSize, ( off_t ) ulStart );
+                }
+                else
+                {
+                    lResult = -1;
+                }
+            }
+            else
+            {
+                errno = EINVAL;
+                lResult = -1;
+            }
+        #else
+            lResult = ( int32_t ) pwrite( xPosixFile.lFd, pacData, xWriteSize, ( off_t ) ulOffset );
+        #endif
+
+        if( lResult == ( int32_t ) xWriteSize )
+        {
+            lResult = ( int32_t ) ulBlockSize;
+
+            /* Track the end of the data in case the size of the file wasn't known up front. */
+            if( ( ulOffset + ulBlockSize ) > xPosixFile.ulSize )
+            {
+                xPosixFile.ulSize = ulOffset + ulBlockSize;
+            }
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] ERROR - pwrite failed\r\n", OTA_METHOD_NAME );
+
+            /* Mask to return a negative value. A short write leaves errno unset. */
+            lResult = OTA_PAL_INT16_NEGATIVE_MASK | ( ( lResult < 0 ) ? errno : EIO ); /*lint !e40 !e9027
+                                                                                       * Errno is being used in accordance with host API documentation.
+                                                                                       * Bitmasking is being used to preserve host API error with library status code. */
+        }
+    }
+
+    return ( int16_t ) lResult;
+}
+
+/* Write a small file so that it either has the new contents or the old ones, even after a reset. */
+
+static OTA_Err_t prvPAL_WriteFileAtomic( const char * pcFileName,
+                                         const char * pcTempFileName,
+                                         const uint8_t * pucData,
+                                         uint32_t ulSize )
+{
+    OTA_Err_t eResult = kOTA_Err_None;
+    int32_t lFd;
+    ssize_t xBytesWritten;
+    int32_t lSyncResult = 0;
+
+    lFd = open( pcTempFileName, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+
+    if( lFd >= 0 )
+    {
+        xBytesWritten = write( lFd, pucData, ulSize );
+
+        #if ( otaconfigPOSIX_PAL_FSYNC == 1 )
+            lSyncResult = fsync( lFd );
+        #endif
+
+        /* POSIX rename() replaces the old file in one step. */
+        if( ( close( lFd ) != 0 ) ||
+            ( xBytesWritten != ( ssize_t ) ulSize ) ||
+            ( lSyncResult != 0 ) ||
+            ( rename( pcTempFileName, pcFileName ) != 0 ) )
+        {
+            eResult = ( OTA_Err_t ) ( ( xBytesWritten < 0 ) ? errno : EIO );
+            ( void ) unlink( pcTempFileName );
+        }
+    }
+    else
+    {
+        eResult = ( OTA_Err_t ) errno;
+    }
+
+    return eResult;
+}
+
+/* Save the file transfer checkpoint, or erase it if no data is given. */
+
+OTA_Err_t prvPAL_SaveCheckpoint( OTA_FileContext_t * const C,
+                                 const uint8_t * pucData,
+                                 uint32_t ulSize )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_SaveCheckpoint" );
+
+    OTA_Err_t eResult = kOTA_Err_None;
+    int32_t lFlushResult = 0;
+
+    if( ( pucData == NULL ) || ( ulSize == 0U ) )
+    {
+        /* There may not be a checkpoint to erase so ignore the result. */
+        ( void ) unlink( OTA_PAL_CHECKPOINT_FILE );
+    }
+    else
+    {
+        /* The blocks the checkpoint claims were received must be on disk before the checkpoint is. */
+        #if ( otaconfigPOSIX_PAL_FSYNC == 1 )
+            if( prvContextValidate( C ) == pdTRUE )
+            {
+                lFlushResult = ( xPosixFile.pucMap != NULL ) ? msync( xPosixFile.pucMap, xPosixFile.ulSize, MS_SYNC ) : fdatasync( xPosixFile.lFd );
+            }
+        #endif
+
+        if( lFlushResult != 0 )
+        {
+            OTA_LOG_L1( "[%s] ERROR - Failed to flush the receive file.\r\n", OTA_METHOD_NAME );
+            eResult = ( kOTA_Err_CheckpointFailed | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                     * Errno is being used in accordance with host API documentation.
+                                                                                     * Bitmasking is being used to preserve host API error with library status code. */
+        }
+        else
+        {
+            eResult = prvPAL_WriteFileAtomic( OTA_PAL_CHECKPOINT_FILE, OTA_PAL_CHECKPOINT_TEMP_FILE, pucData, ulSize );
+
+            if( eResult != kOTA_Err_None )
+            {
+                OTA_LOG_L1( "[%s] ERROR - Failed to write the checkpoint file.\r\n", OTA_METHOD_NAME );
+                eResult = ( kOTA_Err_CheckpointFailed | ( eResult & kOTA_PAL_ErrMask ) );
+            }
+        }
+    }
+
+    return eResult;
+}
+
+/* Read back the file transfer checkpoint. */
+
+uint32_t prvPAL_LoadCheckpoint( OTA_FileContext_t * const C,
+                                uint8_t * pucData,
+                                uint32_t ulMaxSize )
+{
+    int32_t lFd;
+    ssize_t xBytesRead;
+    uint32_t ulSize = 0;
+    uint8_t ucExtra;
+
+    ( void ) C;
+
+    lFd = open( OTA_PAL_CHECKPOINT_FILE, O_RDONLY );
+
+    if( lFd >= 0 )
+    {
+        xBytesRead = read( lFd, pucData, ulMaxSize );
+
+        /* A checkpoint that doesn't fit in the buffer can't be the one the caller is looking for. */
+        if( ( xBytesRead > 0 ) && ( read( lFd, &ucExtra, 1 ) == 0 ) )
+        {
+            ulSize = ( uint32_t ) xBytesRead;
+        }
+
+        ( void ) close( lFd );
+    }
+
+    return ulSize;
+}
+
+/* Close the specified file. This shall authenticate the file if it is marked as secure. */
+
+OTA_Err_t prvPAL_CloseFile( OTA_FileContext_t * const C )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_CloseFile" );
+
+    OTA_Err_t eResult = kOTA_Err_None;
+
+    if( prvContextValidate( C ) == pdTRUE )
+    {
+        #if ( otaconfigPOSIX_PAL_USE_MMAP == 0 ) && ( otaconfigPOSIX_PAL_USE_O_DIRECT == 1 )
+            /* Cut off the padding of the final block. */
+            if( ftruncate( xPosixFile.lFd, ( off_t ) xPosixFile.ulSize ) != 0 )
+            {
+                OTA_LOG_L1( "[%s] ERROR - Failed to truncate the receive file.\r\n", OTA_METHOD_NAME );
+                eResult = ( kOTA_Err_FileClose | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                                  * Errno is being used in accordance with host API documentation.
+                                                                                  * Bitmasking is being used to preserve host API error with library status code. */
+            }
+        #endif
+
+        if( eResult != kOTA_Err_None )
+        {
+            /* Don't check a file that isn't the one received. */
+        }
+        else if( C->pxSignature != NULL )
+        {
+            /* Verify the file signature, close the file and return the signature verification result. */
+            eResult = prvPAL_CheckFileSignature( C );
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] ERROR - NULL OTA Signature structure.\r\n", OTA_METHOD_NAME );
+            eResult = kOTA_Err_SignatureCheckFailed;
+        }
+
+        /* Close the file. */
+        C->pucFile = NULL;
+
+        if( ( prvPAL_ReleaseFile() != 0 ) && ( eResult == kOTA_Err_None ) )
+        {
+            OTA_LOG_L1( "[%s] ERROR - Failed to close OTA update file.\r\n", OTA_METHOD_NAME );
+            eResult = ( kOTA_Err_FileClose | ( errno & kOTA_PAL_ErrMask ) ); /*lint !e40 !e737 !e9027 !e9029
+                                                                              * Errno is being used in accordance with host API documentation.
+                                                                              * Bitmasking is being used to preserve host API error with library status code. */
+        }
+
+        if( eResult == kOTA_Err_None )
+        {
+            OTA_LOG_L1( "[%s] %s signature verification passed.\r\n", OTA_METHOD_NAME, cOTA_JSON_FileSignatureKey );
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] ERROR - Failed to pass %s signature verification: %d.\r\n", OTA_METHOD_NAME,
+                        cOTA_JSON_FileSignatureKey, eResult );
+
+            /* If we fail to verify the file signature that means the image is not valid. We need to set the image state to aborted. */
+            ( void ) prvPAL_SetPlatformImageState( eOTA_ImageState_Aborted );
+        }
+    }
+    else /* Invalid OTA Context. */
+    {
+        /* There's no open receive file to close. */
+        OTA_LOG_L1( "[%s] ERROR - Invalid context.\r\n", OTA_METHOD_NAME );
+        eResult = ( kOTA_Err_NullFilePtr | ( EBADF & kOTA_PAL_ErrMask ) );
+    }
+
+    return eResult;
+}
+
+
+/* Feed the contents of the received file into the signature verification context. A mapped file
+ * is hashed in place, otherwise it is read back through the aligned buffer. */
+
+static OTA_Err_t prvPAL_HashFile( OTA_FileContext_t * const C,
+                                  void * pvSigVerifyContext )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_HashFile" );
+
+    OTA_Err_t eResult = kOTA_Err_None;
+    uint32_t ulOffset;
+    ssize_t xBytesRead;
+
+    ( void ) C;
+
+    if( xPosixFile.pucMap != NULL )
+    {
+        CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, xPosixFile.pucMap, xPosixFile.ulSize );
+    }
+    else
+    {
+        for( ulOffset = 0U; ( ulOffset < xPosixFile.ulSize ) && ( eResult == kOTA_Err_None ); ulOffset += ( uint32_t ) xBytesRead )
+        {
+            xBytesRead = pread( xPosixFile.lFd, xPosixFile.pucAlign, OTA_PAL_POSIX_BUF_SIZE, ( off_t ) ulOffset );
+
+            if( xBytesRead > 0 )
+            {
+                /* Only hash up to the size of the file, in case the read returned padding. */
+                if( ( uint32_t ) xBytesRead > ( xPosixFile.ulSize - ulOffset ) )
+                {
+                    xBytesRead = ( ssize_t ) ( xPosixFile.ulSize - ulOffset );
+                }
+
+                CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, xPosixFile.pucAlign, ( size_t ) xBytesRead );
+            }
+            else
+            {
+                OTA_LOG_L1( "[%s] ERROR - Failed to read back the receive file.\r\n", OTA_METHOD_NAME );
+                eResult = kOTA_Err_SignatureCheckFailed;
+            }
+        }
+    }
+
+    return eResult;
+}
+
+
+/* Verify the signature of the specified file. */
+
+static OTA_Err_t prvPAL_CheckFileSignature( OTA_FileContext_t * const C )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_CheckFileSignature" );
+
+    OTA_Err_t eResult = kOTA_Err_None;
+    uint32_t ulSignerCertSize;
+    uint8_t * pucSignerCert;
+    void * pvSigVerifyContext;
+    BaseType_t xHashFile = pdFALSE;
+
+    if( prvContextValidate( C ) == pdTRUE )
+    {
+        /* If the OTA agent already hashed the file as its blocks were received, take ownership
+         * of that context and skip reading the file back. */
+        pvSigVerifyContext = C->pvSigVerifyContext;
+        C->pvSigVerifyContext = NULL;
+
+        if( pvSigVerifyContext == NULL )
+        {
+            /* Verify an ECDSA-SHA256 signature. */
+            if( pdFALSE == CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA, cryptoHASH_ALGORITHM_SHA256 ) )
+            {
+                eResult = kOTA_Err_SignatureCheckFailed;
+            }
+            else
+            {
+                xHashFile = pdTRUE;
+            }
+        }
+
+        if( eResult == kOTA_Err_None )
+        {
+            OTA_LOG_L1( "[%s] Started %s signature verification, file: %s\r\n", OTA_METHOD_NAME,
+                        cOTA_JSON_FileSignatureKey, ( const char * ) C->pucCertFilepath );
+            pucSignerCert = prvPAL_ReadAndAssumeCertificate( ( const uint8_t * const ) C->pucCertFilepath, &ulSignerCertSize );
+
+            if( pucSignerCert != NULL )
+            {
+                if( xHashFile == pdTRUE )
+                {
+                    eResult = prvPAL_HashFile( C, pvSigVerifyContext );
+                }
+
+                if( eResult == kOTA_Err_None )
+                {
+                    if( pdFALSE == CRYPTO_SignatureVerificationFinal( pvSigVerifyContext,
+                                                                      ( char * ) pucSignerCert,
+                                                                      ( size_t ) ulSignerCertSize,
+                                                                      C->pxSignature->ucData,
+                                                                      C->pxSignature->usSize ) ) /*lint !e732 !e9034 Allow comparison in this context. */
+                    {
+                        eResult = kOTA_Err_SignatureCheckFailed;
+                    }
+                }
+                else
+                {
+                    /* Finalizing without a certificate or signature just frees the context. */
+                    ( void ) CRYPTO_SignatureVerificationFinal( pvSigVerifyContext, NULL, 0, NULL, 0 );
+                }
+
+                /* Free the signer certificate that we now own after prvReadAndAssumeCertificate(). */
+                vPortFree( pucSignerCert );
+            }
+            else
+            {
+                ( void ) CRYPTO_SignatureVerificationFinal( pvSigVerifyContext, NULL, 0, NULL, 0 );
+                eResult = kOTA_Err_BadSignerCert;
+            }
+        }
+    }
+    else
+    {
+        /* Invalid OTA context or no open receive file. */
+        OTA_LOG_L1( "[%s] ERROR - Invalid OTA file context.\r\n", OTA_METHOD_NAME );
+        eResult = ( kOTA_Err_NullFilePtr | ( EBADF & kOTA_PAL_ErrMask ) );
+    }
+
+    return eResult;
+}
+
+
+/* Read the specified signer certificate from the filesystem into a local buffer. The allocated
+ * memory becomes the property of the caller who is responsible for freeing it.
+ */
+
+static uint8_t * prvPAL_ReadAndAssumeCertificate( const uint8_t * const pucCertName,
+                                                  uint32_t * const ulSignerCertSize )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_ReadAndAssumeCertificate" );
+
+    int32_t lFd;
+    struct stat xStat;
+    uint8_t * pucSignerCert = NULL;
+
+    lFd = open( ( const char * ) pucCertName, O_RDONLY );
+
+    if( lFd >= 0 )
+    {
+        if( ( fstat( lFd, &xStat ) == 0 ) && ( xStat.st_size >= 0 ) )
+        {
+            /* Allocate memory for the signer certificate plus a terminating zero so we can load and return it to the caller. */
+            pucSignerCert = pvPortMalloc( ( size_t ) xStat.st_size + 1U ); /*lint !e9079 Allow conversion. */
+        }
+
+        if( pucSignerCert != NULL )
+        {
+            if( read( lFd, pucSignerCert, ( size_t ) xStat.st_size ) == ( ssize_t ) xStat.st_size )
+            {
+                /* The crypto code requires the terminating zero to be part of the length so add 1 to the size. */
+                *ulSignerCertSize = ( uint32_t ) xStat.st_size + 1U;
+                pucSignerCert[ xStat.st_size ] = 0;
+            }
+            else
+            {   /* There was a problem reading the certificate file so free the memory and abort. */
+                vPortFree( pucSignerCert );
+                pucSignerCert = NULL;
+            }
+        }
+        else
+        {
+            OTA_LOG_L1( "[%s] ERROR - Failed to allocate memory for signer cert contents.\r\n", OTA_METHOD_NAME );
+            /* Nothing special to do. */
+        }
+
+        ( void ) close( lFd );
+    }
+    else
+    {
+        OTA_LOG_L1( "[%s] ERROR - Failed to open signer certificate file.\r\n", OTA_METHOD_NAME );
+        /* Do nothing- pucSignerCert is already initialized to NULL. */
+    }
+
+    return pucSignerCert;
+}
+
+/*-----------------------------------------------------------*/
+
+OTA_Err_t prvPAL_ResetDevice( void )
+{
+    /* Return no error. The Linux implementation does not reset the host. */
+    return kOTA_Err_None;
+}
+
+/*-----------------------------------------------------------*/
+
+OTA_Err_t prvPAL_ActivateNewImage( void )
+{
+    /* Return no error. The Linux implementation simply does nothing on activate.
+     * To run the new firmware image, run the downloaded file. */
+    return kOTA_Err_None;
+}
+
+
+/*
+ * Set the final state of the last transferred (final) OTA file (or bundle).
+ * On Linux, the state of the OTA image is stored in PlatformImageState.txt.
+ */
+
+OTA_Err_t prvPAL_SetPlatformImageState( OTA_ImageState_t eState )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_SetPlatformImageState" );
+
+    OTA_Err_t eResult = kOTA_Err_None;
+
+    if( ( eState == eOTA_ImageState_Accepted ) && ( xPosixFile.lFd >= 0 ) )
+    {
+        /* The image can't be committed while a new one is still being received. */
+        OTA_LOG_L1( "[%s] ERROR - Can't accept the image while a file is open.\r\n", OTA_METHOD_NAME );
+        eResult = kOTA_Err_CommitFailed;
+    }
+    else if( ( eState != eOTA_ImageState_Unknown ) && ( eState <= eOTA_LastImageState ) )
+    {
+        eResult = prvPAL_WriteFileAtomic( OTA_PAL_IMAGE_STATE_FILE,
+                                          OTA_PAL_IMAGE_STATE_TEMP_FILE,
+                                          ( const uint8_t * ) &eState,
+                                          sizeof( OTA_ImageState_t ) );
+
+        if( eResult != kOTA_Err_None )
+        {
+            OTA_LOG_L1( "[%s] ERROR - Unable to write the image state file.\r\n", OTA_METHOD_NAME );
+            eResult = ( kOTA_Err_BadImageState | ( eResult & kOTA_PAL_ErrMask ) );
+        }
+    }
+    else /* Image state invalid. */
+    {
+        OTA_LOG_L1( "[%s] ERROR - Invalid image state provided.\r\n", OTA_METHOD_NAME );
+        eResult = kOTA_Err_BadImageState;
+    }
+
+    return eResult;
+}
+
+/* Get the state of the currently running image.
+ *
+ * On Linux, this is simulated by looking for and reading the state from
+ * the PlatformImageState.txt file in the current working directory.
+ *
+ * We read this at OTA_Init time so we can tell if the MCU image is in self
+ * test mode. If it is, we expect a successful connection to the OTA services
+ * within a reasonable amount of time. If we don't satisfy that requirement,
+ * we assume there is something wrong with the firmware and reset the device,
+ * causing it to rollback to the previous code. On Linux, this is not
+ * fully simulated as the host isn't reset.
+ */
+OTA_PAL_ImageState_t prvPAL_GetPlatformImageState( void )
+{
+    DEFINE_OTA_METHOD_NAME( "prvPAL_GetPlatformImageState" );
+
+    int32_t lFd;
+    OTA_ImageState_t eSavedAgentState = eOTA_ImageState_Unknown;
+    OTA_PAL_ImageState_t ePalState = eOTA_PAL_ImageState_Unknown;
+
+    lFd = open( OTA_PAL_IMAGE_STATE_FILE, O_RDONLY );
+
+    if( lFd >= 0 )
+    {
+        if( read( lFd, &eSavedAgentState, sizeof( OTA_ImageState_t ) ) != ( ssize_t ) sizeof( OTA_ImageState_t ) )
+        {
+            /* If an error occured reading the file, mark the state as aborted. */
+            OTA_LOG_L1( "[%s] ERROR - Unable to read image state file.\r\n", OTA_METHOD_NAME );
+            ePalState = ( eOTA_PAL_ImageState_Invalid | ( errno & kOTA_PAL_ErrMask ) );
+        }
+        else
+        {
+            switch( eSavedAgentState )
+            {
+                case eOTA_ImageState_Testing:
+                    ePalState = eOTA_PAL_ImageState_PendingCommit;
+                    break;
+
+                case eOTA_ImageState_Accepted:
+                    ePalState = eOTA_PAL_ImageState_Valid;
+                    break;
+
+                case eOTA_ImageState_Rejected:
+                case eOTA_ImageState_Aborted:
+                default:
+                    ePalState = eOTA_PAL_ImageState_Invalid;
+                    break;
+            }
+        }
+
+        ( void ) close( lFd );
+    }
+    else
+    {
+        /* If no image state file exists, assume a factory image. */
+        ePalState = eOTA_PAL_ImageState_Valid; /*lint !e64 Allow assignment. */
+    }
+
+    return ePalState; /*lint !e64 I/O calls and return type are used per design. */
+}
+
+/*-----------------------------------------------------------*/
+
+/* Provide access to private members for testing. */
+#ifdef AMAZON_FREERTOS_ENABLE_UNIT_TESTS
+    #include "aws_ota_pal_test_access_define.h"
+#endif
@@ -222,6 +222,15 @@ extern uint32_t ulRand();
 /* USE_WIN: Let TCP use windowing mechanism. */
 #define ipconfigUSE_TCP_WIN                            ( 1 )
 
+/* Build the RX ring, so that the tests can compare it with passing one event
+ * per received frame.  The WinPCap driver itself still sends one event per
+ * frame. */
+#define ipconfigUSE_RX_BATCHING                        ( 1 )
+
+/* Send runs of up to ipconfigTCP_LARGE_SEND_SEGMENTS full-size TCP segments
+ * from a single header template. */
+#define ipconfigUSE_TCP_LARGE_SEND                     ( 1 )
+
 /* The MTU is the maximum number of bytes the payload of a network frame can
  * contain.  For normal Ethernet V2 frames the maximum MTU is 1500.  Setting a
  * lower value can save RAM, depending on the buffer management scheme used.  If
@@ -276,6 +285,10 @@ extern uint32_t ulRand();
  * simultaneously, one could define TCP_WIN_SEG_COUNT as 120. */
 #define ipconfigTCP_WIN_SEG_COUNT                      240
 
+/* Add 60 descriptors each time the pool runs empty, up to the default
+ * maximum of 4 x ipconfigTCP_WIN_SEG_COUNT. */
+#define ipconfigTCP_WIN_SEG_GROW_COUNT                 60
+
 /* Each TCP socket has a circular buffers for Rx and Tx, which have a fixed
  * maximum size.  Define the size of Rx buffer for TCP sockets. */
 #define ipconfigTCP_RX_BUFFER_LENGTH                   ( 10000 )
@@ -283,6 +296,10 @@ extern uint32_t ulRand();
 /* Define the size of Tx buffer for TCP sockets. */
 #define ipconfigTCP_TX_BUFFER_LENGTH                   ( 10000 )
 
+/* Let the Rx buffer and window of a TCP socket grow while it receives, up to
+ * ipconfigTCP_RX_AUTOTUNE_MAX_SIZE bytes. */
+#define ipconfigUSE_TCP_RX_AUTOTUNE                    ( 1 )
+
 /* When using call-back handlers, the driver may check if the handler points to
  * real program memory (RAM or flash) or just has a random non-zero value. */
 #define ipconfigIS_VALID_PROG_ADDRESS( x )    ( ( x ) != NULL )
@@ -43,4 +43,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #define ggdconfigJSON_MAX_TOKENS            ( 128 )
 
+/**
+ * @brief Number of core endpoints to connect to at the same time.
+ */
+#define ggdconfigMAX_PARALLEL_CONNECTS      ( 3 )
+
 #endif /* _AWS_GGD_CONFIG_H_ */
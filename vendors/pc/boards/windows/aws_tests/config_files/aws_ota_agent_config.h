@@ -85,4 +85,43 @@
  */
  #define otaconfigMAX_NUM_BLOCKS_REQUEST        128U
 
+/**
+ * @brief Hash file blocks as they are received instead of reading the file back at close.
+ *
+ * The OTA agent feeds the contiguous received prefix of the file into the signature verification
+ * context, holding up to otaconfigMAX_HASH_PENDING_BLOCKS out of order blocks in RAM until the
+ * gap before them fills. Closing the file then only needs the final signature check.
+ */
+#define otaconfigHASH_ON_INGEST                 1
+
+/**
+ * @brief Checkpoint the progress of file transfers so that they resume after a reset.
+ *
+ * The Windows Simulator PAL saves the checkpoint in OTACheckpoint.bin in the current working
+ * directory. A checkpoint is saved every otaconfigCHECKPOINT_INTERVAL_BLOCKS blocks and when
+ * the agent is shut down in the middle of a transfer.
+ */
+#define otaconfigRESUME_TRANSFERS               1
+
+/**
+ * @brief Keep a window of block requests in flight instead of one request at a time.
+ *
+ * The window grows while blocks arrive and shrinks when they're lost. Once it reaches
+ * otaconfigMAX_WINDOW_BLOCKS blocks without loss, the block size grows up to
+ * 2^otaconfigLOG2_MAX_FILE_BLOCK_SIZE bytes.
+ */
+#define otaconfigPIPELINE_BLOCK_REQUESTS        1
+#define otaconfigMAX_WINDOW_BLOCKS              32U
+#define otaconfigLOG2_MAX_FILE_BLOCK_SIZE       12UL
+
+/**
+ * @brief Accept files that the job document marks as compressed with zlib.
+ *
+ * Compressed files are decompressed as their blocks are received, through a window of
+ * 2^otaconfigLOG2_MAX_DECOMPRESS_WINDOW bytes. The Windows Simulator PAL grows the file as it is
+ * written so it needs no changes to store the decompressed image.
+ */
+#define otaconfigDECOMPRESS_IMAGES              1
+#define otaconfigLOG2_MAX_DECOMPRESS_WINDOW     12U
+
 #endif /* _AWS_OTA_AGENT_CONFIG_H_ */